@@ -45,6 +45,14 @@ public: // functions
     const Uint cols = block_cols(block_idx);
     table.set_row_size(cols);
     table.resize(rows);
+    if(table.is_column_major())
+    {
+      // Blocks are always stored row by row
+      typename Table<T>::ArrayT row_major(boost::extents[rows][cols]);
+      read_data_block(reinterpret_cast<char*>(row_major.data()), sizeof(T)*rows*cols, block_idx);
+      table.array() = row_major;
+      return;
+    }
     read_data_block(reinterpret_cast<char*>(table.array().data()), sizeof(T)*rows*cols, block_idx);
   }
   
@@ -12,7 +12,13 @@
 #include <boost/iostreams/filter/zlib.hpp>
 #include <boost/iostreams/device/file_descriptor.hpp>
 
+#include <deque>
+
+#include <boost/foreach.hpp>
+#include <boost/ref.hpp>
+
 #include "common/Log.hpp"
+#include "common/OutputThread.hpp"
 #include "common/Signal.hpp"
 #include "common/PropertyList.hpp"
 #include "common/OptionList.hpp"
@@ -31,10 +37,32 @@ namespace common {
 
 struct BinaryDataWriter::Implementation
 {
-  Implementation(const URI& file) :
+  /// Description of a written block
+  struct BlockInfo
+  {
+    BlockInfo(const std::string& name, const std::string& type, const Uint rows, const Uint cols) :
+      list_name(name),
+      type_name(type),
+      nb_rows(rows),
+      nb_cols(cols),
+      begin(0),
+      end(0)
+    {
+    }
+
+    std::string list_name;
+    std::string type_name;
+    Uint nb_rows;
+    Uint nb_cols;
+    Uint begin;
+    Uint end;
+  };
+
+  Implementation(const URI& file, const bool async) :
     filename(build_filename(file, PE::Comm::instance().rank())),
     xml_filename(file),
-    index(0),
+    asynchronous(async),
+    finished(false),
     xml_doc("1.0", "ISO-8859-1"),
     m_total_count(0)
   {
@@ -62,22 +90,41 @@ struct BinaryDataWriter::Implementation
 
   ~Implementation()
   {
-    CFdebug << "wrote a total of " << m_total_count << " bytes with a compression ratio of " << static_cast<Real>(out_file.tellp()) / static_cast<Real>(m_total_count) * 100. << "%" << CFendl;
-    out_file.close();
-    if(PE::Comm::instance().rank() == 0)
-      XML::to_file(xml_doc, xml_filename);
-
-    PE::Comm::instance().barrier();
+    if(!finished)
+      finish();
   }
 
   Uint write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name)
+  {
+    cf3_assert(!finished);
+    // Elements of a deque stay at the same place when appending, so the output thread can fill in the info
+    blocks.push_back(BlockInfo(list_name, type_name, nb_rows, nb_cols));
+    if(asynchronous)
+    {
+      boost::shared_ptr< std::vector<char> > staged_data(new std::vector<char>(data, data + count));
+      OutputThread::instance().enqueue(boost::bind(&Implementation::write_staged_block, this, staged_data, boost::ref(blocks.back())));
+    }
+    else
+    {
+      write_block(data, count, blocks.back());
+    }
+
+    return blocks.size() - 1;
+  }
+
+  void write_staged_block(const boost::shared_ptr< std::vector<char> >& staged_data, BlockInfo& block_info)
+  {
+    write_block(staged_data->empty() ? 0 : &(*staged_data)[0], staged_data->size(), block_info);
+  }
+
+  // Compress the data and write it to the binary file
+  void write_block(const char* data, const std::streamsize count, BlockInfo& block_info)
   {
     cf3_assert(out_file.is_open());
-    PE::Comm& comm = PE::Comm::instance();
     // Prefix and suffix markers
     static const std::string block_prefix("__CFDATA_BEGIN");
 
-    const Uint block_begin = out_file.tellp();
+    block_info.begin = out_file.tellp();
 
     // Write the prefix
     out_file.write(block_prefix.c_str(), block_prefix.size());
@@ -94,11 +141,32 @@ struct BinaryDataWriter::Implementation
       compressing_stream.pop();
     }
 
-    const Uint block_end = out_file.tellp();
+    block_info.end = out_file.tellp();
+    m_total_count += count;
+  }
+
+  /// Close the binary file and write the XML index. Collective, and when asynchronous all writes must be finished.
+  void finish()
+  {
+    finished = true;
+
+    CFdebug << "wrote a total of " << m_total_count << " bytes with a compression ratio of " << static_cast<Real>(out_file.tellp()) / static_cast<Real>(m_total_count) * 100. << "%" << CFendl;
+    out_file.close();
+
+    // Data describing the blocks on the current CPU
+    PE::Comm& comm = PE::Comm::instance();
+    const Uint block_info_size = 4;
+    const Uint nb_blocks = blocks.size();
+    std::vector<Uint> my_block_info;
+    my_block_info.reserve(block_info_size*nb_blocks);
+    BOOST_FOREACH(const BlockInfo& block, blocks)
+    {
+      my_block_info.push_back(block.nb_rows);
+      my_block_info.push_back(block.nb_cols);
+      my_block_info.push_back(block.begin);
+      my_block_info.push_back(block.end);
+    }
 
-    // Data describing the block on the current CPU
-    const std::vector<Uint> my_block_info = boost::assign::list_of(nb_rows)(nb_cols)(block_begin)(block_end);
-    const Uint block_info_size = my_block_info.size();
     std::vector<Uint> global_block_info;
     const Uint root = 0;
     if(comm.is_active())
@@ -116,22 +184,24 @@ struct BinaryDataWriter::Implementation
       const Uint nb_procs = comm.size();
       for(Uint i = 0; i != nb_procs; ++i)
       {
-        XmlNode block_xml = node_xml_data[i].add_node("block");
-        const Uint j = i*block_info_size;
-        block_xml.set_attribute("name", list_name);
-        block_xml.set_attribute("index", to_str(index));
-        block_xml.set_attribute("type_name", type_name);
-        block_xml.set_attribute("nb_rows", to_str(global_block_info[j]));
-        block_xml.set_attribute("nb_cols", to_str(global_block_info[j+1]));
-        block_xml.set_attribute("begin", to_str(global_block_info[j+2]));
-        block_xml.set_attribute("end", to_str(global_block_info[j+3]));
+        for(Uint block_idx = 0; block_idx != nb_blocks; ++block_idx)
+        {
+          XmlNode block_xml = node_xml_data[i].add_node("block");
+          const Uint j = (i*nb_blocks + block_idx)*block_info_size;
+          block_xml.set_attribute("name", blocks[block_idx].list_name);
+          block_xml.set_attribute("index", to_str(block_idx));
+          block_xml.set_attribute("type_name", blocks[block_idx].type_name);
+          block_xml.set_attribute("nb_rows", to_str(global_block_info[j]));
+          block_xml.set_attribute("nb_cols", to_str(global_block_info[j+1]));
+          block_xml.set_attribute("begin", to_str(global_block_info[j+2]));
+          block_xml.set_attribute("end", to_str(global_block_info[j+3]));
+        }
       }
-    }
 
-    ++index;
-    m_total_count += count;
+      XML::to_file(xml_doc, xml_filename);
+    }
 
-    return index - 1;
+    comm.barrier();
   }
 
   Uint version() const
@@ -152,8 +222,14 @@ struct BinaryDataWriter::Implementation
   const URI xml_filename;
   boost::filesystem::fstream out_file;
 
-  // Index of the next block to write
-  Uint index;
+  // True if the blocks are written by the output thread
+  const bool asynchronous;
+
+  // True if the XML index was written
+  bool finished;
+
+  // Blocks written so far
+  std::deque<BlockInfo> blocks;
 
   // XML document describing all data added (only valid on root process)
   XmlDoc xml_doc;
@@ -170,6 +246,11 @@ BinaryDataWriter::BinaryDataWriter ( const std::string& name ) : Component(name)
     .pretty_name("File")
     .description("File name for the output file")
     .attach_trigger(boost::bind(&BinaryDataWriter::trigger_file, this));
+
+  options().add("asynchronous", false)
+    .pretty_name("Asynchronous")
+    .description("Compress and write the data on the output thread. The index file is written when the output thread is flushed.")
+    .attach_trigger(boost::bind(&BinaryDataWriter::trigger_file, this));
 }
 
 BinaryDataWriter::~BinaryDataWriter()
@@ -179,6 +260,13 @@ BinaryDataWriter::~BinaryDataWriter()
 
 void BinaryDataWriter::close()
 {
+  if(is_null(m_implementation.get()))
+    return;
+
+  // The index can only be written once all blocks are written, so this is deferred to the flush of the output thread
+  if(m_implementation->asynchronous)
+    OutputThread::instance().enqueue(OutputThread::TaskT(), boost::bind(&Implementation::finish, m_implementation));
+
   m_implementation.reset();
 }
 
@@ -186,7 +274,7 @@ Uint BinaryDataWriter::write_data_block(const char* data, const std::streamsize
 {
   if(is_null(m_implementation.get()))
   {
-    m_implementation.reset(new Implementation(options().value<URI>("file")));
+    m_implementation.reset(new Implementation(options().value<URI>("file"), options().value<bool>("asynchronous")));
   }
 
   return m_implementation->write_data_block(data, count, list_name, nb_rows, nb_cols, type_name);
@@ -194,7 +282,7 @@ Uint BinaryDataWriter::write_data_block(const char* data, const std::streamsize
 
 void BinaryDataWriter::trigger_file()
 {
-  m_implementation.reset();
+  close();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -7,7 +7,7 @@
 #ifndef cf3_common_BinaryDataWriter_hpp
 #define cf3_common_BinaryDataWriter_hpp
 
-#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "common/Component.hpp"
 #include "common/List.hpp"
@@ -21,7 +21,9 @@ namespace common {
 ///////////////////////////////////////////////////////////////////////////////////////
 
   
-/// Component for writing binary data collected into a single file
+/// Component for writing binary data collected into a single file.
+/// When the option "asynchronous" is set, the data is copied when it is appended, and compressed and written by the common::OutputThread.
+/// The XML index is then written when the OutputThread is flushed.
 class Common_API BinaryDataWriter : public Component {
 
 public: // functions
@@ -38,6 +40,13 @@ public: // functions
   template<typename T>
   Uint append_data(const Table<T>& table)
   {
+    if(table.is_column_major())
+    {
+      // Blocks are always stored row by row
+      typename Table<T>::ArrayT rows(boost::extents[table.size()][table.row_size()]);
+      rows = table.array();
+      return write_data_block(reinterpret_cast<const char*>(rows.data()), sizeof(T)*table.row_size()*table.size(), table.name(), table.size(), table.row_size(), class_name<T>());
+    }
     return write_data_block(reinterpret_cast<const char*>(table.array().data()), sizeof(T)*table.row_size()*table.size(), table.name(), table.size(), table.row_size(), class_name<T>());
   }
   
@@ -59,7 +68,7 @@ private:
   void trigger_file();
 
   class Implementation;
-  boost::scoped_ptr<Implementation> m_implementation;
+  boost::shared_ptr<Implementation> m_implementation;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
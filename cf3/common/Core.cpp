@@ -13,6 +13,7 @@
 #include "common/Signal.hpp"
 #include "common/OSystem.hpp"
 #include "common/OSystemLayer.hpp"
+#include "common/OutputThread.hpp"
 #include "common/NetworkInfo.hpp"
 #include "common/EventHandler.hpp"
 #include "common/OSystem.hpp"
@@ -130,6 +131,9 @@ void Core::initiate ( int argc, char** argv )
 
 void Core::terminate()
 {
+  // finish writing any output that is still in progress
+  OutputThread::instance().flush();
+
   // terminate all
   if(is_not_null(m_libraries))
     libraries().terminate_all_libraries();
@@ -4,6 +4,10 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <fstream>
+
+#include <boost/bind.hpp>
+
 #include "common/Signal.hpp"
 #include "common/OptionT.hpp"
 #include "common/Builder.hpp"
@@ -12,6 +16,11 @@
 #include "common/Log.hpp"
 #include "common/Environment.hpp"
 #include "common/PropertyList.hpp"
+#include "common/Trace.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "common/XML/SignalOptions.hpp"
 
 namespace cf3 {
 namespace common {
@@ -102,9 +111,27 @@ Environment::Environment ( const std::string& name) : Component ( name )
       .mark_basic()
       .attach_trigger(boost::bind(&Environment::trigger_log_level,this));
 
+  options().add("trace", false)
+      .pretty_name("Trace")
+      .description("If true, the execution time of actions, loops, linear solves and communication is recorded. "
+                   "Use the write_trace signal to write the result.")
+      .mark_basic()
+      .attach_trigger(boost::bind(&Environment::trigger_trace,this));
+
+  options().add("trace_buffer_size", 100000u)
+      .pretty_name("Trace Buffer Size")
+      .description("Number of trace events kept for each thread. When the buffer is full, the oldest events are overwritten.")
+      .attach_trigger(boost::bind(&Environment::trigger_trace_buffer_size,this));
+
   trigger_log_level();
 
   // signals
+  regist_signal ( "write_trace" )
+      .description( "Write the trace of each rank in the Chrome trace format, and a summary over all ranks" )
+      .pretty_name("Write Trace" )
+      .connect   ( boost::bind ( &Environment::signal_write_trace,    this, _1 ) )
+      .signature ( boost::bind ( &Environment::signature_write_trace, this, _1 ) );
+
   signal("create_component")->hidden(true);
   signal("rename_component")->hidden(true);
   signal("delete_component")->hidden(true);
@@ -180,5 +207,49 @@ void Environment::trigger_log_level()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Environment::trigger_trace()
+{
+  Tracer::instance().enable(options().value<bool>("trace"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Environment::trigger_trace_buffer_size()
+{
+  Tracer::instance().set_buffer_size(options().value<Uint>("trace_buffer_size"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Environment::signature_write_trace ( SignalArgs& args )
+{
+  XML::SignalOptions options( args );
+
+  options.add("file", std::string("trace"))
+      .description("Base name of the files. Each rank writes <file>-P<rank>.json, and rank 0 writes <file>-summary.txt")
+      .mark_basic();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Environment::signal_write_trace ( SignalArgs& args )
+{
+  XML::SignalOptions options( args );
+  const std::string file = options.check("file") ? options.value<std::string>("file") : std::string("trace");
+
+  const Uint rank = PE::Comm::instance().is_active() ? PE::Comm::instance().rank() : 0;
+  Tracer::instance().write_chrome_trace(file + "-P" + to_str(rank) + ".json");
+
+  const std::string summary = Tracer::instance().summary();
+  if(rank == 0)
+  {
+    std::ofstream summary_file((file + "-summary.txt").c_str());
+    summary_file << summary;
+  }
+  CFinfo << summary << CFendl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // common
 } // cf3
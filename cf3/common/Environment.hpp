@@ -33,6 +33,10 @@ public: // functions
   /// Get the class name
   static std::string type_name () { return "Environment"; }
 
+  /// Write the recorded trace regions of each rank in the Chrome trace format, and a summary over all ranks
+  void signal_write_trace ( SignalArgs& args );
+  void signature_write_trace ( SignalArgs& args );
+
 private: // functions
 
   void trigger_only_cpu0_writes();
@@ -51,6 +55,10 @@ private: // functions
 
   void trigger_log_level();
 
+  void trigger_trace();
+
+  void trigger_trace_buffer_size();
+
 }; // Environment
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -55,7 +55,8 @@ public: // functions
   /// Contructor
   /// @param name of the component
   List ( const std::string& name ) :
-    Component ( name )
+    Component ( name ),
+    m_nb_storage_users(0)
   {
 
   }
@@ -68,6 +69,7 @@ public: // functions
   /// @param[in] new_size The size allocated after resizing
   void resize(const Uint new_size)
   {
+    check_resizable();
     m_array.resize(boost::extents[new_size]);
   }
 
@@ -85,6 +87,7 @@ public: // functions
   /// @return A Buffer object that can fill this Array
   Buffer create_buffer(const size_t buffersize=16384)
   {
+    check_resizable();
     return Buffer(m_array,buffersize);
   }
 
@@ -94,6 +97,7 @@ public: // functions
   /// @return A Buffer object that can fill this Array
   typename boost::shared_ptr<Buffer> create_buffer_ptr(const size_t buffersize=16384)
   {
+    check_resizable();
     return boost::shared_ptr<Buffer>( new Buffer(m_array,buffersize) );
   }
 
@@ -110,11 +114,38 @@ public: // functions
   /// @return The number of local rows in the array
   Uint size() const { return m_array.size(); }
 
+  /// Register a user that keeps a pointer to the raw storage, such as a NumPy array in the Python bindings.
+  /// Resizing the list or creating a buffer for it throws as long as the storage has users,
+  /// because the reallocation would leave them pointing to freed memory.
+  void add_storage_user() const { ++m_nb_storage_users; }
+
+  /// Unregister a user added with add_storage_user
+  void remove_storage_user() const
+  {
+    cf3_assert(m_nb_storage_users != 0);
+    --m_nb_storage_users;
+  }
+
+  /// Number of users of the raw storage
+  Uint nb_storage_users() const { return m_nb_storage_users; }
+
+private: // functions
+
+  /// Throws if the storage may not be reallocated
+  void check_resizable() const
+  {
+    if(m_nb_storage_users != 0)
+      throw IllegalCall(FromHere(), "List " + uri().path() + " can't be resized while views of its data exist");
+  }
+
 private: // data
 
   /// storage of the array
   ListT m_array;
 
+  /// number of users of the raw storage
+  mutable Uint m_nb_storage_users;
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,159 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <boost/bind.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/OutputThread.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+OutputThread& OutputThread::instance()
+{
+  static OutputThread output_thread;
+  return output_thread;
+}
+
+OutputThread::OutputThread() :
+  m_nb_completions(0),
+  m_max_queue_size(2),
+  m_busy(false),
+  m_stop(false)
+{
+}
+
+OutputThread::~OutputThread()
+{
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_task_condition.notify_all();
+  if(m_thread)
+    m_thread->join();
+}
+
+void OutputThread::enqueue(const TaskT& task, const TaskT& completion)
+{
+  // Completions are only run by flush, so bound the data they hold on to
+  if(!completion.empty())
+  {
+    bool queue_full = false;
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      queue_full = m_nb_completions >= m_max_queue_size;
+    }
+    if(queue_full)
+      flush();
+  }
+
+  {
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    if(!m_thread)
+      m_thread.reset(new boost::thread(boost::bind(&OutputThread::run, this)));
+
+    while(m_tasks.size() >= m_max_queue_size)
+      m_done_condition.wait(lock);
+
+    // Empty tasks still go through the queue, to keep the completions in order
+    m_tasks.push_back(task);
+    m_completions.push_back(completion);
+    if(!completion.empty())
+      ++m_nb_completions;
+  }
+  m_task_condition.notify_all();
+}
+
+void OutputThread::flush()
+{
+  std::deque<TaskT> completions;
+  boost::exception_ptr exception;
+  {
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    while(!m_tasks.empty() || m_busy)
+      m_done_condition.wait(lock);
+
+    completions.swap(m_completions);
+    m_nb_completions = 0;
+    exception = m_exception;
+    m_exception = boost::exception_ptr();
+  }
+
+  if(exception)
+    boost::rethrow_exception(exception);
+
+  for(std::deque<TaskT>::iterator it = completions.begin(); it != completions.end(); ++it)
+  {
+    if(!it->empty())
+      (*it)();
+  }
+}
+
+Uint OutputThread::max_queue_size() const
+{
+  return m_max_queue_size;
+}
+
+void OutputThread::set_max_queue_size(const Uint size)
+{
+  if(size == 0)
+    throw BadValue(FromHere(), "Output queue size must be at least 1");
+
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  m_max_queue_size = size;
+}
+
+void OutputThread::run()
+{
+  while(true)
+  {
+    TaskT task;
+    {
+      boost::unique_lock<boost::mutex> lock(m_mutex);
+      while(!m_stop && m_tasks.empty())
+        m_task_condition.wait(lock);
+
+      if(m_tasks.empty())
+        return;
+
+      task = m_tasks.front();
+      m_tasks.pop_front();
+      m_busy = true;
+    }
+    // The queue has room again
+    m_done_condition.notify_all();
+
+    try
+    {
+      if(!task.empty())
+        task();
+    }
+    catch(...)
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      if(!m_exception)
+        m_exception = boost::current_exception();
+    }
+
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      m_busy = false;
+    }
+    m_done_condition.notify_all();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,99 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_OutputThread_hpp
+#define cf3_common_OutputThread_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <deque>
+
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "common/CF.hpp"
+#include "common/CommonAPI.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Dedicated thread that compresses and writes output files in the background, so the solver can continue
+/// while data is being written. Writers copy the data to write into a staging buffer and queue a task working on that copy.
+/// The queue is bounded: queueing blocks while the maximum number of tasks is waiting, limiting the memory used by staged data.
+///
+/// Each task can have a completion, which is executed in the calling thread by flush, in the order the tasks were queued.
+/// Completions can do collective communication, so flush must be called by all processes at the same point.
+/// Completions keep their data alive until they are run, so their number is bounded as well: queueing a task with a completion
+/// flushes the queue first if the maximum number of completions is pending. Such tasks must therefore be queued by all processes at the same point.
+class Common_API OutputThread : public boost::noncopyable
+{
+public:
+  typedef boost::function<void ()> TaskT;
+
+  /// Access to the process-wide output thread
+  static OutputThread& instance();
+
+  /// Waits for the remaining tasks and stops the thread. Completions that were not run by flush are discarded.
+  ~OutputThread();
+
+  /// Queue a task for execution on the output thread.
+  /// @param task Executed on the output thread. May be empty, to only add a completion
+  /// @param completion Executed by the next call to flush, after task has finished. May be empty.
+  /// If max_queue_size completions are pending, flush is called first.
+  void enqueue(const TaskT& task, const TaskT& completion = TaskT());
+
+  /// Wait until all queued tasks are finished and run their completions. The first exception thrown by a task is rethrown here.
+  void flush();
+
+  /// Maximum number of tasks waiting in the queue, and of pending completions. The default of 2 provides double buffering.
+  Uint max_queue_size() const;
+
+  /// Set the maximum number of tasks waiting in the queue
+  void set_max_queue_size(const Uint size);
+
+private:
+  OutputThread();
+
+  /// Main loop for the output thread
+  void run();
+
+  boost::scoped_ptr<boost::thread> m_thread;
+  boost::mutex m_mutex;
+  /// Notified when a task is queued or the thread needs to stop
+  boost::condition_variable m_task_condition;
+  /// Notified when a task is finished
+  boost::condition_variable m_done_condition;
+
+  std::deque<TaskT> m_tasks;
+  std::deque<TaskT> m_completions;
+  /// Number of non-empty entries in m_completions
+  Uint m_nb_completions;
+  Uint m_max_queue_size;
+  /// True while the output thread executes a task
+  bool m_busy;
+  bool m_stop;
+
+  /// First exception thrown by a task since the last flush
+  boost::exception_ptr m_exception;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_OutputThread_hpp
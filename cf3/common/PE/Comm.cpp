@@ -7,6 +7,7 @@
 #include "common/Log.hpp"
 
 #include "common/BasicExceptions.hpp"
+#include "common/OutputThread.hpp"
 #include "common/PE/Comm.hpp"
 
 //#include "common/PE/debug.hpp"
@@ -97,6 +98,9 @@ void Comm::finalize()
 {
   if( is_initialized() && !is_finalized() ) // then finalized
   {
+    // Output that is still being written may need MPI to complete
+    if( is_active() )
+      OutputThread::instance().flush();
     MPI_CHECK_RESULT(MPI_Finalize,());
     //  CFinfo << "MPI (version " <<  version() << ") -- finalized" << CFendl;
   }
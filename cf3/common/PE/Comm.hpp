@@ -153,6 +153,11 @@ public:
   {
            PE::all_to_all(communicator(), send, recv);
   }
+  /// Exchange with only the processes that have data to send or receive, see PE::sparse_all_to_all
+  template<typename T> inline void sparse_all_to_all( const std::vector<std::vector<T> >& send, std::vector<std::vector<T> >& recv)
+  {
+           PE::sparse_all_to_all(communicator(), send, recv);
+  }
 
   //@}
 
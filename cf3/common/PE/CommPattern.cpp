@@ -6,6 +6,8 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <cstring>
+
 #include "boost/lexical_cast.hpp"
 
 #include "common/BoostAssertions.hpp"
@@ -13,6 +15,7 @@
 #include "common/FindComponents.hpp"
 #include "common/Builder.hpp"
 #include "common/Log.hpp"
+#include "common/Trace.hpp"
 
 #include "common/PE/Comm.hpp"
 #include "common/PE/CommPattern.hpp"
@@ -63,6 +66,14 @@ CommPattern::CommPattern(const std::string& name): Component(name), m_gid(alloca
 CommPattern::~CommPattern()
 {
   if (m_gid.get()!=nullptr) m_gid->remove_tag("gid_of_"+this->name());
+
+  // don't leave requests pointing to buffers that are about to be freed
+  if (PE::Comm::instance().is_active())
+  {
+    for (std::map<const CommWrapper*, PendingSync>::iterator it=m_pending_syncs.begin(); it!=m_pending_syncs.end(); ++it)
+      if (!it->second.requests.empty())
+        MPI_Waitall((int)it->second.requests.size(),&it->second.requests[0],MPI_STATUSES_IGNORE);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -475,6 +486,8 @@ void CommPattern::setup()
     if (global_nelems[i]!=0)
       delete[] global[i];
 
+  setup_neighbors();
+
 #undef COMPUTE_IRANK
 #undef COMPUTE_INODE
 }
@@ -564,18 +577,43 @@ void CommPattern::setup()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void CommPattern::synchronize_all()
+void CommPattern::setup_neighbors()
 {
-  std::vector<unsigned char> sndbuf(1);
-  std::vector<unsigned char> rcvbuf(1);
-  BOOST_FOREACH( CommWrapper& pobj, find_components_recursively<CommWrapper>(*this) )
+  if (!m_pending_syncs.empty())
+    throw common::ShouldNotBeHere(FromHere(),"Commpattern '" + name() + "' was modified while a synchronization was in progress.");
+
+  m_neighbors.clear();
+  m_neighborSendStart.clear();
+  m_neighborRecvStart.clear();
+  CPint send_start=0;
+  CPint recv_start=0;
+  const CPint nproc=(CPint)m_sendCount.size();
+  for (CPint i=0; i<nproc; i++)
   {
-    synchronize_this(pobj,sndbuf,rcvbuf);
+    if ((m_sendCount[i]!=0)||(m_recvCount[i]!=0))
+    {
+      m_neighbors.push_back(i);
+      m_neighborSendStart.push_back(send_start);
+      m_neighborRecvStart.push_back(recv_start);
+    }
+    send_start+=m_sendCount[i];
+    recv_start+=m_recvCount[i];
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void CommPattern::synchronize_all()
+{
+  // all objects are in flight at the same time, so the latencies overlap
+  BOOST_FOREACH( CommWrapper& pobj, find_components_recursively<CommWrapper>(*this) )
+    begin_synchronize(pobj);
+  BOOST_FOREACH( CommWrapper& pobj, find_components_recursively<CommWrapper>(*this) )
+    end_synchronize(pobj);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void CommPattern::synchronize( const std::string& name )
 {
   std::vector<unsigned char> sndbuf(1);
@@ -595,18 +633,111 @@ void CommPattern::synchronize( const CommWrapper& pobj )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void CommPattern::begin_synchronize( const std::string& name )
+{
+  Handle<CommWrapper> pobj(get_child(name));
+  if (is_null(pobj)) throw common::ValueNotFound(FromHere(),"No data named '" + name + "' is registered in commpattern '" + this->name() + "'.");
+  begin_synchronize(*pobj);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::begin_synchronize( const CommWrapper& pobj )
+{
+  if ( !pobj.needs_update() ) return;
+  if (m_pending_syncs.count(&pobj)!=0)
+    throw common::ShouldNotBeHere(FromHere(),"Synchronization of '" + pobj.name() + "' in commpattern '" + name() + "' was already started.");
+  PendingSync& pending=m_pending_syncs[&pobj];
+  post_exchange(pobj,pending.sndbuf,pending.rcvbuf,pending.requests);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::end_synchronize( const std::string& name )
+{
+  Handle<CommWrapper> pobj(get_child(name));
+  if (is_null(pobj)) throw common::ValueNotFound(FromHere(),"No data named '" + name + "' is registered in commpattern '" + this->name() + "'.");
+  end_synchronize(*pobj);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::end_synchronize( const CommWrapper& pobj )
+{
+  if ( !pobj.needs_update() ) return;
+  std::map<const CommWrapper*, PendingSync>::iterator pending=m_pending_syncs.find(&pobj);
+  if (pending==m_pending_syncs.end())
+    throw common::ShouldNotBeHere(FromHere(),"Synchronization of '" + pobj.name() + "' in commpattern '" + name() + "' was not started.");
+  complete_exchange(pobj,pending->second.rcvbuf,pending->second.requests);
+  m_pending_syncs.erase(pending);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 // having the vectors for the intermediate buf coming from outside allows keeping them and reuse for all synchronize
 void CommPattern::synchronize_this( const CommWrapper& pobj, std::vector<unsigned char>& sndbuf, std::vector<unsigned char>& rcvbuf )
 {
-//  std::cout << PERank << pobj.name() << "\n" << std::flush;
-//  std::cout << PERank << pobj.needs_update() << "\n" << std::flush;
   if ( pobj.needs_update() )
   {
-    pobj.pack(sndbuf,m_sendMap);
-    rcvbuf.resize(m_recvMap.size()*pobj.size_of()*pobj.stride());
-    PE::Comm::instance().all_to_all(sndbuf,m_sendCount,rcvbuf,m_recvCount,pobj.size_of()*pobj.stride());
-    pobj.unpack(rcvbuf,m_recvMap);
+    std::vector<MPI_Request> requests;
+    post_exchange(pobj,sndbuf,rcvbuf,requests);
+    complete_exchange(pobj,rcvbuf,requests);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::post_exchange( const CommWrapper& pobj, std::vector<unsigned char>& sndbuf, std::vector<unsigned char>& rcvbuf, std::vector<MPI_Request>& requests )
+{
+  TraceRegion trace("CommPattern::post_exchange", "comm");
+  const int item_size=pobj.size_of()*pobj.stride();
+  const CPint irank=(CPint)PE::Comm::instance().rank();
+  const int nb_neighbors=(const int)m_neighbors.size();
+
+  if (!m_sendMap.empty()) pobj.pack(sndbuf,m_sendMap);
+  rcvbuf.resize(m_recvMap.size()*item_size);
+
+  requests.clear();
+  requests.reserve(2*nb_neighbors);
+  Communicator comm=PE::Comm::instance().communicator();
+
+  // receives first, so the incoming messages don't need to be buffered by mpi
+  for (int i=0; i<nb_neighbors; i++)
+  {
+    const CPint neighbor=m_neighbors[i];
+    if ((neighbor==irank)||(m_recvCount[neighbor]==0)) continue;
+    requests.push_back(MPI_REQUEST_NULL);
+    MPI_CHECK_RESULT(MPI_Irecv,(&rcvbuf[m_neighborRecvStart[i]*item_size], m_recvCount[neighbor]*item_size, MPI_BYTE, neighbor, 0, comm, &requests.back()));
+  }
+
+  for (int i=0; i<nb_neighbors; i++)
+  {
+    const CPint neighbor=m_neighbors[i];
+    if (m_sendCount[neighbor]==0) continue;
+    if (neighbor==irank)
+    {
+      // data that is ghost and updatable on the same rank is copied directly
+      cf3_assert(m_sendCount[irank]==m_recvCount[irank]);
+      std::memcpy(&rcvbuf[m_neighborRecvStart[i]*item_size],&sndbuf[m_neighborSendStart[i]*item_size],m_sendCount[irank]*item_size);
+      continue;
+    }
+    requests.push_back(MPI_REQUEST_NULL);
+    MPI_CHECK_RESULT(MPI_Isend,(&sndbuf[m_neighborSendStart[i]*item_size], m_sendCount[neighbor]*item_size, MPI_BYTE, neighbor, 0, comm, &requests.back()));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::complete_exchange( const CommWrapper& pobj, std::vector<unsigned char>& rcvbuf, std::vector<MPI_Request>& requests )
+{
+  if (!requests.empty())
+  {
+    // time spent waiting for the neighbors
+    TraceRegion trace("CommPattern::wait", "comm");
+    MPI_CHECK_RESULT(MPI_Waitall,((int)requests.size(), &requests[0], MPI_STATUSES_IGNORE));
   }
+  requests.clear();
+  if (!m_recvMap.empty()) pobj.unpack(rcvbuf,m_recvMap);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,8 @@
 #ifndef cf3_common_PE_CommPattern_hpp
 #define cf3_common_PE_CommPattern_hpp
 
+#include <map>
+
 #include "common/Component.hpp"
 #include "common/BoostArray.hpp"
 #include "common/PE/Comm.hpp"
@@ -229,6 +231,24 @@ public:
   /// @param name the name of the parallel object
   void synchronize( const CommWrapper& pobj );
 
+  /// start the synchronization of the parallel object designated by its name, without waiting for the data to arrive
+  /// data is only exchanged with the neighboring ranks, and the registered data must not be modified before end_synchronize
+  /// all ranks must start the synchronizations in the same order
+  /// @param name the name of the parallel object
+  void begin_synchronize( const std::string& name );
+
+  /// start the synchronization of the parallel object designated by its commwrapper reference
+  /// @param pobj the parallel object
+  void begin_synchronize( const CommWrapper& pobj );
+
+  /// wait for the synchronization started by begin_synchronize and copy the received data to the ghosts
+  /// @param name the name of the parallel object
+  void end_synchronize( const std::string& name );
+
+  /// wait for the synchronization started by begin_synchronize and copy the received data to the ghosts
+  /// @param pobj the parallel object
+  void end_synchronize( const CommWrapper& pobj );
+
   /// add element to the commpattern
   /// when all changes done, all needs to be committed by calling setup
   /// if global id is not on current rank, then a ghost is automatically created on current rank
@@ -284,6 +304,9 @@ public:
   /// Return the rank associated with the given local ID
   int rank(const Uint lid) const { return m_ranks[lid]; }
 
+  /// accessor to the ranks this process exchanges data with during synchronization
+  const std::vector<CPint>& neighbors() const { return m_neighbors; }
+
   //@} END ACCESSORS
 
 protected: // helper function
@@ -295,6 +318,17 @@ protected: // helper function
   /// @param rcvbuf vector for intermediate buffer for recieve
   void synchronize_this( const CommWrapper& pobj, std::vector<unsigned char>& sndbuf, std::vector<unsigned char>& rcvbuf );
 
+private: // helper functions
+
+  /// build the list of neighbors and their offsets in the send and receive maps, from m_sendCount and m_recvCount
+  void setup_neighbors();
+
+  /// pack the data and post the nonblocking sends and receives to the neighbors
+  void post_exchange( const CommWrapper& pobj, std::vector<unsigned char>& sndbuf, std::vector<unsigned char>& rcvbuf, std::vector<MPI_Request>& requests );
+
+  /// wait for the posted sends and receives, and unpack the received data
+  void complete_exchange( const CommWrapper& pobj, std::vector<unsigned char>& rcvbuf, std::vector<MPI_Request>& requests );
+
 private:
 
   /// @name PROPERTIES
@@ -349,6 +383,26 @@ private:
   /// Rank for all the gids in local index space
   std::vector<int> m_ranks;
 
+  /// ranks with a nonzero send or receive count, in increasing order
+  std::vector< CPint > m_neighbors;
+
+  /// for each neighbor, the first index of its data in m_sendMap
+  std::vector< CPint > m_neighborSendStart;
+
+  /// for each neighbor, the first index of its data in m_recvMap
+  std::vector< CPint > m_neighborRecvStart;
+
+  /// buffers and requests of a synchronization that was started with begin_synchronize
+  struct PendingSync
+  {
+    std::vector<unsigned char> sndbuf;
+    std::vector<unsigned char> rcvbuf;
+    std::vector<MPI_Request> requests;
+  };
+
+  /// synchronizations in progress, by parallel object
+  std::map<const CommWrapper*, PendingSync> m_pending_syncs;
+
 }; // CommPattern
 
 ////////////////////////////////////////////////////////////////////////////////////////////
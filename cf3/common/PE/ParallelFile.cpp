@@ -0,0 +1,326 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+#include "common/BasicExceptions.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/ParallelFile.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+namespace PE {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+  /// Orders row positions by their global index
+  struct RowIndexLess
+  {
+    RowIndexLess(const std::vector<Uint>& indices) : row_indices(indices) {}
+    bool operator()(const Uint a, const Uint b) const { return row_indices[a] < row_indices[b]; }
+    const std::vector<Uint>& row_indices;
+  };
+
+  /// Compute the positions of the rows sorted by increasing global index, keeping only the first occurence of each index
+  void sorted_unique_rows(const std::vector<Uint>& row_indices, std::vector<Uint>& positions, std::vector<Uint>& sorted_indices)
+  {
+    const Uint nb_rows = row_indices.size();
+    positions.resize(nb_rows);
+    for(Uint i = 0; i != nb_rows; ++i)
+      positions[i] = i;
+    std::stable_sort(positions.begin(), positions.end(), RowIndexLess(row_indices));
+
+    sorted_indices.clear();
+    sorted_indices.reserve(nb_rows);
+    Uint nb_unique = 0;
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      const Uint row_idx = row_indices[positions[i]];
+      if(!sorted_indices.empty() && sorted_indices.back() == row_idx)
+        continue;
+      positions[nb_unique++] = positions[i];
+      sorted_indices.push_back(row_idx);
+    }
+    positions.resize(nb_unique);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+class ParallelFile::Implementation
+{
+public:
+  Implementation(const std::string& filename, const Mode mode) :
+    m_filename(filename),
+    m_parallel(Comm::instance().is_active()),
+    m_write_end(0),
+    m_write_pending(false)
+  {
+    if(m_parallel)
+    {
+      const int amode = mode == WRITE ? (MPI_MODE_CREATE | MPI_MODE_WRONLY) : MPI_MODE_RDONLY;
+      if(MPI_File_open(Comm::instance().communicator(), const_cast<char*>(filename.c_str()), amode, MPI_INFO_NULL, &m_file) != MPI_SUCCESS)
+        throw FileSystemError(FromHere(), "Failed to open file " + filename);
+      if(mode == WRITE)
+        MPI_CHECK_RESULT(MPI_File_set_size, (m_file, 0));
+    }
+    else
+    {
+      m_stream.open(filename.c_str(), mode == WRITE ? (std::ios_base::out | std::ios_base::trunc | std::ios_base::binary) : (std::ios_base::in | std::ios_base::binary));
+      if(!m_stream.is_open())
+        throw FileSystemError(FromHere(), "Failed to open file " + filename);
+    }
+  }
+
+  ~Implementation()
+  {
+    if(m_write_pending)
+      MPI_Wait(&m_write_request, MPI_STATUS_IGNORE);
+    if(m_parallel)
+      MPI_File_close(&m_file);
+    else
+      m_stream.close();
+  }
+
+  /// Transfer the rows with the given sorted, unique indices between the buffer and the file
+  void transfer(const boost::uint64_t block_begin, char* buffer, const std::vector<Uint>& sorted_indices, const boost::uint64_t row_size, const bool write)
+  {
+    const Uint nb_rows = sorted_indices.size();
+    if(nb_rows * row_size > static_cast<boost::uint64_t>(std::numeric_limits<int>::max()))
+      throw NotSupported(FromHere(), "Too much data for a single transfer to file " + m_filename);
+
+    if(m_parallel)
+    {
+      // File view selecting the rows of this process, so all processes can access the file in a single collective call
+      MPI_Datatype filetype;
+      if(nb_rows != 0)
+      {
+        std::vector<MPI_Aint> displacements(nb_rows);
+        for(Uint i = 0; i != nb_rows; ++i)
+          displacements[i] = static_cast<MPI_Aint>(sorted_indices[i] * row_size);
+        MPI_CHECK_RESULT(MPI_Type_create_hindexed_block, (static_cast<int>(nb_rows), static_cast<int>(row_size), &displacements[0], MPI_BYTE, &filetype));
+      }
+      else
+      {
+        MPI_CHECK_RESULT(MPI_Type_contiguous, (0, MPI_BYTE, &filetype));
+      }
+      MPI_CHECK_RESULT(MPI_Type_commit, (&filetype));
+      MPI_CHECK_RESULT(MPI_File_set_view, (m_file, static_cast<MPI_Offset>(block_begin), MPI_BYTE, filetype, const_cast<char*>("native"), MPI_INFO_NULL));
+
+      char dummy = 0;
+      char* data = nb_rows == 0 ? &dummy : buffer;
+      const int count = static_cast<int>(nb_rows * row_size);
+      if(write)
+      {
+        MPI_CHECK_RESULT(MPI_File_write_all, (m_file, data, count, MPI_BYTE, MPI_STATUS_IGNORE));
+      }
+      else
+      {
+        MPI_CHECK_RESULT(MPI_File_read_all, (m_file, data, count, MPI_BYTE, MPI_STATUS_IGNORE));
+      }
+
+      MPI_CHECK_RESULT(MPI_Type_free, (&filetype));
+      return;
+    }
+
+    // Sequential access, grouping consecutive rows
+    Uint run_begin = 0;
+    while(run_begin != nb_rows)
+    {
+      Uint run_end = run_begin + 1;
+      while(run_end != nb_rows && sorted_indices[run_end] == sorted_indices[run_end-1] + 1)
+        ++run_end;
+
+      const std::streamsize nb_bytes = (run_end - run_begin) * row_size;
+      char* run_data = buffer + run_begin * row_size;
+      if(write)
+      {
+        m_stream.seekp(static_cast<std::streamoff>(block_begin + sorted_indices[run_begin] * row_size));
+        m_stream.write(run_data, nb_bytes);
+      }
+      else
+      {
+        m_stream.seekg(static_cast<std::streamoff>(block_begin + sorted_indices[run_begin] * row_size));
+        m_stream.read(run_data, nb_bytes);
+      }
+      if(!m_stream)
+        throw FileSystemError(FromHere(), "Error accessing file " + m_filename);
+
+      run_begin = run_end;
+    }
+  }
+
+  /// Append the rows with the given sorted, unique indices to the pending write
+  void add_rows(const boost::uint64_t block_begin, const char* buffer, const std::vector<Uint>& sorted_indices, const boost::uint64_t row_size)
+  {
+    if(!m_parallel)
+    {
+      transfer(block_begin, const_cast<char*>(buffer), sorted_indices, row_size, true);
+      return;
+    }
+
+    if(m_write_pending)
+      throw SetupError(FromHere(), "Rows can't be added while a write is in progress for file " + m_filename);
+    if(block_begin < m_write_end)
+      throw BadValue(FromHere(), "Blocks must be added in increasing order for file " + m_filename);
+
+    const Uint nb_rows = sorted_indices.size();
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      const boost::uint64_t row_begin = block_begin + sorted_indices[i] * row_size;
+      // Consecutive rows are merged into a single block of the file type
+      if(!m_write_displacements.empty() && static_cast<boost::uint64_t>(m_write_displacements.back()) + m_write_lengths.back() == row_begin)
+      {
+        m_write_lengths.back() += static_cast<int>(row_size);
+      }
+      else
+      {
+        m_write_displacements.push_back(static_cast<MPI_Aint>(row_begin));
+        m_write_lengths.push_back(static_cast<int>(row_size));
+      }
+    }
+    m_write_buffer.insert(m_write_buffer.end(), buffer, buffer + nb_rows * row_size);
+    if(nb_rows != 0)
+      m_write_end = block_begin + (sorted_indices.back() + 1) * row_size;
+  }
+
+  void begin_write()
+  {
+    if(!m_parallel)
+      return;
+
+    if(m_write_pending)
+      throw SetupError(FromHere(), "A write is already in progress for file " + m_filename);
+    if(m_write_buffer.size() > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+      throw NotSupported(FromHere(), "Too much data for a single transfer to file " + m_filename);
+
+    MPI_Datatype filetype;
+    if(!m_write_displacements.empty())
+    {
+      MPI_CHECK_RESULT(MPI_Type_create_hindexed, (static_cast<int>(m_write_displacements.size()), &m_write_lengths[0], &m_write_displacements[0], MPI_BYTE, &filetype));
+    }
+    else
+    {
+      MPI_CHECK_RESULT(MPI_Type_contiguous, (0, MPI_BYTE, &filetype));
+    }
+    MPI_CHECK_RESULT(MPI_Type_commit, (&filetype));
+    MPI_CHECK_RESULT(MPI_File_set_view, (m_file, 0, MPI_BYTE, filetype, const_cast<char*>("native"), MPI_INFO_NULL));
+    MPI_CHECK_RESULT(MPI_Type_free, (&filetype));
+
+    // The buffer must stay untouched until end_write
+    char* data = m_write_buffer.empty() ? &m_dummy : &m_write_buffer[0];
+    MPI_CHECK_RESULT(MPI_File_iwrite_all, (m_file, data, static_cast<int>(m_write_buffer.size()), MPI_BYTE, &m_write_request));
+    m_write_pending = true;
+  }
+
+  void end_write()
+  {
+    if(!m_write_pending)
+      return;
+
+    MPI_CHECK_RESULT(MPI_Wait, (&m_write_request, MPI_STATUS_IGNORE));
+    m_write_pending = false;
+    m_write_end = 0;
+    m_write_displacements.clear();
+    m_write_lengths.clear();
+    std::vector<char>().swap(m_write_buffer);
+  }
+
+private:
+  const std::string m_filename;
+  const bool m_parallel;
+  MPI_File m_file;
+  std::fstream m_stream;
+
+  // State for the batched write
+  std::vector<MPI_Aint> m_write_displacements;
+  std::vector<int> m_write_lengths;
+  std::vector<char> m_write_buffer;
+  boost::uint64_t m_write_end;
+  bool m_write_pending;
+  MPI_Request m_write_request;
+  char m_dummy;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+ParallelFile::ParallelFile(const std::string& filename, const Mode mode) :
+  m_implementation(new Implementation(filename, mode))
+{
+}
+
+ParallelFile::~ParallelFile()
+{
+}
+
+void ParallelFile::write_rows(const boost::uint64_t block_begin, const char* data, const std::vector<Uint>& row_indices, const boost::uint64_t row_size)
+{
+  std::vector<Uint> positions, sorted_indices;
+  detail::sorted_unique_rows(row_indices, positions, sorted_indices);
+
+  const Uint nb_rows = positions.size();
+  std::vector<char> buffer(nb_rows * row_size);
+  for(Uint i = 0; i != nb_rows; ++i)
+    std::copy(data + positions[i] * row_size, data + (positions[i]+1) * row_size, buffer.begin() + i * row_size);
+
+  m_implementation->transfer(block_begin, buffer.empty() ? 0 : &buffer[0], sorted_indices, row_size, true);
+}
+
+void ParallelFile::add_rows(const boost::uint64_t block_begin, const char* data, const std::vector<Uint>& row_indices, const boost::uint64_t row_size)
+{
+  std::vector<Uint> positions, sorted_indices;
+  detail::sorted_unique_rows(row_indices, positions, sorted_indices);
+
+  const Uint nb_rows = positions.size();
+  std::vector<char> buffer(nb_rows * row_size);
+  for(Uint i = 0; i != nb_rows; ++i)
+    std::copy(data + positions[i] * row_size, data + (positions[i]+1) * row_size, buffer.begin() + i * row_size);
+
+  m_implementation->add_rows(block_begin, buffer.empty() ? 0 : &buffer[0], sorted_indices, row_size);
+}
+
+void ParallelFile::begin_write()
+{
+  m_implementation->begin_write();
+}
+
+void ParallelFile::end_write()
+{
+  m_implementation->end_write();
+}
+
+void ParallelFile::read_rows(const boost::uint64_t block_begin, char* data, const std::vector<Uint>& row_indices, const boost::uint64_t row_size)
+{
+  std::vector<Uint> positions, sorted_indices;
+  detail::sorted_unique_rows(row_indices, positions, sorted_indices);
+
+  const Uint nb_unique = positions.size();
+  std::vector<char> buffer(nb_unique * row_size);
+  m_implementation->transfer(block_begin, buffer.empty() ? 0 : &buffer[0], sorted_indices, row_size, false);
+
+  // Copy to the requested positions, including duplicates
+  const Uint nb_rows = row_indices.size();
+  for(Uint i = 0; i != nb_rows; ++i)
+  {
+    const Uint unique_idx = std::lower_bound(sorted_indices.begin(), sorted_indices.end(), row_indices[i]) - sorted_indices.begin();
+    std::copy(buffer.begin() + unique_idx * row_size, buffer.begin() + (unique_idx+1) * row_size, data + i * row_size);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // PE
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
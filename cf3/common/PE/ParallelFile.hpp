@@ -0,0 +1,86 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_PE_ParallelFile_hpp
+#define cf3_common_PE_ParallelFile_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include "common/CF.hpp"
+#include "common/CommonAPI.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+namespace PE {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// A single binary file that is shared by all processes, accessed with collective MPI-IO.
+/// Data is organized in blocks of fixed-size rows, indexed by a global row number. Each process
+/// reads or writes an arbitrary subset of the rows, so the data can be read back on any number of processes.
+/// When the parallel environment is not active, plain file access is used with the same layout.
+/// Offsets and sizes are 64 bit, so files larger than 4 GiB are supported.
+class Common_API ParallelFile : public boost::noncopyable
+{
+public:
+  enum Mode { READ, WRITE };
+
+  /// Open the file. Collective.
+  ParallelFile(const std::string& filename, const Mode mode);
+
+  /// Closes the file. Collective.
+  ~ParallelFile();
+
+  /// Write rows into the block starting at byte offset block_begin. Collective.
+  /// @param block_begin Offset of the block in the file, in bytes
+  /// @param data Row-major data, containing row_indices.size() rows of row_size bytes
+  /// @param row_indices Global index of each row in the block. If an index appears more than once, the first row is written.
+  /// @param row_size Size of one row, in bytes
+  void write_rows(const boost::uint64_t block_begin, const char* data, const std::vector<Uint>& row_indices, const boost::uint64_t row_size);
+
+  /// Read rows from the block starting at byte offset block_begin. Collective.
+  /// @param block_begin Offset of the block in the file, in bytes
+  /// @param data Row-major storage for row_indices.size() rows of row_size bytes
+  /// @param row_indices Global index of each row to read
+  /// @param row_size Size of one row, in bytes
+  void read_rows(const boost::uint64_t block_begin, char* data, const std::vector<Uint>& row_indices, const boost::uint64_t row_size);
+
+  /// Add rows to the next write started by begin_write, so multiple blocks can be written in one collective call.
+  /// The data is copied. Blocks must be added in increasing file order. Without an active parallel environment, the rows are written immediately.
+  /// @param block_begin Offset of the block in the file, in bytes
+  /// @param data Row-major data, containing row_indices.size() rows of row_size bytes
+  /// @param row_indices Global index of each row in the block. If an index appears more than once, the first row is written.
+  /// @param row_size Size of one row, in bytes
+  void add_rows(const boost::uint64_t block_begin, const char* data, const std::vector<Uint>& row_indices, const boost::uint64_t row_size);
+
+  /// Start writing all rows added using add_rows, using a nonblocking collective write. Collective.
+  void begin_write();
+
+  /// Wait for the write started by begin_write to complete. Collective. Called automatically when the file is closed.
+  void end_write();
+
+private:
+  class Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // PE
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_PE_ParallelFile_hpp
@@ -445,6 +445,52 @@ void all_to_all(const Communicator& comm, const std::vector<std::vector<T> >& se
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/**
+  Variable size exchange in which each process only communicates with the processes it sends to or receives from.
+  Only the sizes are exchanged with a collective (MPI_Alltoall on one int per process), the data goes in point to point messages,
+  so this is cheaper than all_to_all when most of the send vectors are empty.
+  @param comm Comm::Communicator
+  @param send data to send to each process, the size of send must be the number of processes
+  @param recv data received from each process, resized to the number of processes
+**/
+template <typename T>
+void sparse_all_to_all(const Communicator& comm, const std::vector<std::vector<T> >& send, std::vector<std::vector<T> >& recv)
+{
+  int nb_procs;
+  MPI_CHECK_RESULT(MPI_Comm_size,(comm,&nb_procs));
+  cf3_assert(send.size() == nb_procs);
+
+  std::vector<int> send_counts(nb_procs);
+  std::vector<int> recv_counts(nb_procs);
+  for (int i=0; i<nb_procs; ++i)
+    send_counts[i] = send[i].size();
+  MPI_CHECK_RESULT(MPI_Alltoall,(&send_counts[0], 1, MPI_INT, &recv_counts[0], 1, MPI_INT, comm));
+
+  // Tag that is not used by the other exchanges, so pending messages of those don't match
+  const int tag = 0x5a2;
+  std::vector<MPI_Request> requests;
+  recv.resize(nb_procs);
+  for (int i=0; i<nb_procs; ++i)
+  {
+    recv[i].resize(recv_counts[i]);
+    if (recv_counts[i] == 0)
+      continue;
+    requests.push_back(MPI_REQUEST_NULL);
+    MPI_CHECK_RESULT(MPI_Irecv,(&recv[i][0], recv_counts[i], get_mpi_datatype<T>(), i, tag, comm, &requests.back()));
+  }
+  for (int i=0; i<nb_procs; ++i)
+  {
+    if (send_counts[i] == 0)
+      continue;
+    requests.push_back(MPI_REQUEST_NULL);
+    MPI_CHECK_RESULT(MPI_Isend,(const_cast<T*>(&send[i][0]), send_counts[i], get_mpi_datatype<T>(), i, tag, comm, &requests.back()));
+  }
+  if (!requests.empty())
+    MPI_CHECK_RESULT(MPI_Waitall,((int)requests.size(), &requests[0], MPI_STATUSES_IGNORE));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // namespace PE
 } // namespace common
 } // namespace cf3
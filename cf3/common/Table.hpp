@@ -24,6 +24,22 @@ namespace common {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+  /// Access to the storage order that multi_array uses when it reallocates. A pointer to the protected
+  /// member, taken through a derived class, may be applied to any multi_array.
+  template<typename ArrayT>
+  struct StorageOrderAccess : ArrayT
+  {
+    static typename ArrayT::storage_order_type& storage_order(ArrayT& array)
+    {
+      return array.*(&StorageOrderAccess::storage_);
+    }
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 /// @brief Component holding a 2 dimensional array of a templated type
 ///
 /// The internal structure is that of a boost::multi_array,
@@ -65,7 +81,7 @@ public: // functions
 
   /// Contructor
   /// @param name of the component
-  Table ( const std::string& name )  : Component ( name ), m_pos(0)
+  Table ( const std::string& name )  : Component ( name ), m_pos(0), m_nb_storage_users(0)
   {  }
 
   /// Get the component type name
@@ -77,6 +93,7 @@ public: // functions
   /// @param[in] nb_cols number of columns in the table.
   void set_row_size(const Uint nb_cols)
   {
+    check_resizable();
     m_array.resize(boost::extents[size()][nb_cols]);
   }
 
@@ -84,9 +101,42 @@ public: // functions
   /// @param[in] nb_rows The number of rows after resizing
   virtual void resize(const Uint nb_rows)
   {
+    check_resizable();
     m_array.resize(boost::extents[nb_rows][row_size()]);
   }
 
+  /// Choose between row by row (the default) and column by column storage of the values.
+  /// Column-major storage places each column contiguously in memory (structure of arrays),
+  /// so loops that touch only a few columns stream less data. Row access through operator[]
+  /// keeps working, but the entries of a row are then strided: use array().strides() when
+  /// accessing the raw data. Existing values are preserved.
+  /// @param[in] column_major True to store the table column by column
+  void set_column_major(const bool column_major)
+  {
+    if(column_major == is_column_major())
+      return;
+
+    check_resizable();
+
+    // multi_array has no way to change the storage order of an existing array. Its resize builds a new array
+    // in the current storage order, copies the values and swaps the new array into place, so announce the new
+    // order and resize to the same extents. The strides, used to copy the values, are still those of the old order.
+    const typename ArrayT::storage_order_type old_order = m_array.storage_order();
+    detail::StorageOrderAccess<ArrayT>::storage_order(m_array) = column_major ? boost::general_storage_order<2>(boost::fortran_storage_order()) : boost::general_storage_order<2>(boost::c_storage_order());
+    try
+    {
+      m_array.resize(boost::extents[size()][row_size()]);
+    }
+    catch(...)
+    {
+      detail::StorageOrderAccess<ArrayT>::storage_order(m_array) = old_order;
+      throw;
+    }
+  }
+
+  /// True if the values are stored column by column
+  bool is_column_major() const { return m_array.storage_order().ordering(0) == 0; }
+
   /// Modifiable access to the internal structure
   /// @return A reference to the array data
   ArrayT& array() { return m_array; }
@@ -103,6 +153,7 @@ public: // functions
   {
     // make sure the array has its columnsize defined
     cf3_assert(row_size() > 0);
+    check_resizable();
     return Buffer(m_array,buffersize);
   }
 
@@ -110,6 +161,7 @@ public: // functions
   {
     // make sure the array has its columnsize defined
     cf3_assert(row_size() > 0);
+    check_resizable();
     return typename boost::shared_ptr<Buffer> ( new Buffer (m_array,buffersize) );
   }
 
@@ -159,12 +211,38 @@ public: // functions
     return m_pos;
   }
 
+  /// Register a user that keeps a pointer to the raw storage, such as a NumPy array in the Python bindings.
+  /// Resizing the table or creating a buffer for it throws as long as the storage has users,
+  /// because the reallocation would leave them pointing to freed memory.
+  void add_storage_user() const { ++m_nb_storage_users; }
+
+  /// Unregister a user added with add_storage_user
+  void remove_storage_user() const
+  {
+    cf3_assert(m_nb_storage_users != 0);
+    --m_nb_storage_users;
+  }
+
+  /// Number of users of the raw storage
+  Uint nb_storage_users() const { return m_nb_storage_users; }
+
+private: // functions
+
+  /// Throws if the storage may not be reallocated
+  void check_resizable() const
+  {
+    if(m_nb_storage_users != 0)
+      throw IllegalCall(FromHere(), "Table " + uri().path() + " can't be resized while views of its data exist");
+  }
+
 private: // data
 
   /// storage of the array
   ArrayT m_array;
   /// position when used as output stream
   Uint m_pos;
+  /// number of users of the raw storage
+  mutable Uint m_nb_storage_users;
 };
 
 /////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,179 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
+#include "common/Assertions.hpp"
+#include "common/ThreadPool.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool& ThreadPool::instance()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+ThreadPool::ThreadPool() :
+  m_nb_workers(0),
+  m_nb_threads(0),
+  m_barrier(0),
+  m_generation(0),
+  m_nb_running(0),
+  m_busy(false),
+  m_stop(false)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_start_condition.notify_all();
+  m_workers.join_all();
+}
+
+void ThreadPool::run(const Uint nb_threads, const TaskT& task)
+{
+  bool serial = nb_threads < 2;
+  if(!serial)
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    serial = m_busy;
+    m_busy = true;
+  }
+
+  // Nested or single-threaded call: run everything in the calling thread
+  if(serial)
+  {
+    boost::barrier barrier(1);
+    task(0, 1, barrier);
+    return;
+  }
+
+  boost::barrier barrier(nb_threads);
+
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    while(m_nb_workers < nb_threads - 1)
+    {
+      ++m_nb_workers;
+      m_workers.create_thread(boost::bind(&ThreadPool::worker, this, m_nb_workers));
+    }
+
+    m_task = task;
+    m_nb_threads = nb_threads;
+    m_barrier = &barrier;
+    m_exception = boost::exception_ptr();
+    m_nb_running = nb_threads - 1;
+    ++m_generation;
+  }
+  m_start_condition.notify_all();
+
+  execute(0);
+
+  boost::exception_ptr exception;
+  {
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    while(m_nb_running != 0)
+      m_done_condition.wait(lock);
+
+    m_task.clear();
+    m_barrier = 0;
+    m_busy = false;
+    exception = m_exception;
+    m_exception = boost::exception_ptr();
+  }
+
+  if(exception)
+    boost::rethrow_exception(exception);
+}
+
+Uint ThreadPool::nb_workers() const
+{
+  return m_nb_workers;
+}
+
+void ThreadPool::static_chunk(const Uint size, const Uint thread_idx, const Uint nb_threads, Uint& begin, Uint& end, const Uint alignment)
+{
+  cf3_assert(thread_idx < nb_threads);
+  cf3_assert(alignment > 0);
+
+  // Number of aligned blocks, and the blocks per thread
+  const Uint nb_blocks = (size + alignment - 1) / alignment;
+  const Uint blocks_per_thread = nb_blocks / nb_threads;
+  const Uint remainder = nb_blocks % nb_threads;
+
+  const Uint first_block = thread_idx * blocks_per_thread + std::min(thread_idx, remainder);
+  const Uint last_block = first_block + blocks_per_thread + (thread_idx < remainder ? 1 : 0);
+
+  begin = std::min(first_block * alignment, size);
+  end = std::min(last_block * alignment, size);
+}
+
+void ThreadPool::worker(const Uint worker_idx)
+{
+  Uint seen_generation = 0;
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    // A worker created for a running task must still take part in it
+    seen_generation = m_generation - 1;
+  }
+
+  while(true)
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(m_mutex);
+      while(!m_stop && m_generation == seen_generation)
+        m_start_condition.wait(lock);
+
+      if(m_stop)
+        return;
+
+      seen_generation = m_generation;
+      if(worker_idx >= m_nb_threads)
+        continue;
+    }
+
+    execute(worker_idx);
+
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      --m_nb_running;
+    }
+    m_done_condition.notify_all();
+  }
+}
+
+void ThreadPool::execute(const Uint thread_idx)
+{
+  try
+  {
+    m_task(thread_idx, m_nb_threads, *m_barrier);
+  }
+  catch(...)
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    if(!m_exception)
+      m_exception = boost::current_exception();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,97 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_ThreadPool_hpp
+#define cf3_common_ThreadPool_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "common/CF.hpp"
+#include "common/CommonAPI.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Pool of persistent worker threads, used to run data-parallel loops inside a single MPI process.
+/// A task is executed by a team of threads, the calling thread always taking part as thread 0.
+/// Workers are created on demand and kept alive until the end of the program, so starting a
+/// task only costs a wake-up. Calls to run from inside a task are executed serially by the calling thread.
+class Common_API ThreadPool : public boost::noncopyable
+{
+public:
+  /// Signature of a task: the index of the executing thread, the size of the team and a barrier shared by the team
+  typedef boost::function<void (const Uint, const Uint, boost::barrier&)> TaskT;
+
+  /// Access to the process-wide pool
+  static ThreadPool& instance();
+
+  ~ThreadPool();
+
+  /// Execute the task on nb_threads threads and return when all of them are done.
+  /// The first exception thrown by any of the threads is rethrown here.
+  void run(const Uint nb_threads, const TaskT& task);
+
+  /// Number of worker threads that were started so far
+  Uint nb_workers() const;
+
+  /// Compute the part [begin, end) of the range [0, size) that is handled by thread thread_idx out of nb_threads.
+  /// Chunk boundaries are rounded to a multiple of alignment, so threads writing to consecutive arrays don't share cache lines.
+  static void static_chunk(const Uint size, const Uint thread_idx, const Uint nb_threads, Uint& begin, Uint& end, const Uint alignment = 1);
+
+private:
+  ThreadPool();
+
+  /// Main loop for the worker with the given index (starting at 1)
+  void worker(const Uint worker_idx);
+
+  /// Executes the current task, storing any exception
+  void execute(const Uint thread_idx);
+
+  boost::thread_group m_workers;
+  Uint m_nb_workers;
+
+  boost::mutex m_mutex;
+  boost::condition_variable m_start_condition;
+  boost::condition_variable m_done_condition;
+
+  /// Task that is executed, and its parameters
+  TaskT m_task;
+  Uint m_nb_threads;
+  boost::barrier* m_barrier;
+
+  /// Incremented for every new task, so workers know when to start
+  Uint m_generation;
+  /// Number of workers that are still executing the current task
+  Uint m_nb_running;
+  /// True while a task is executing
+  bool m_busy;
+  /// Set on destruction to stop the workers
+  bool m_stop;
+
+  /// First exception thrown during the current task
+  boost::exception_ptr m_exception;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_ThreadPool_hpp
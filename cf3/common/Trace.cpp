@@ -0,0 +1,272 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/Trace.hpp"
+
+#include "common/PE/Buffer.hpp"
+#include "common/PE/Comm.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+  /// Write a string as a JSON string literal
+  void write_json_string(std::ostream& out, const char* str)
+  {
+    out << '"';
+    for(const char* c = str; *c != '\0'; ++c)
+    {
+      if(*c == '"' || *c == '\\')
+        out << '\\' << *c;
+      else if(static_cast<unsigned char>(*c) < 0x20)
+        out << ' ';
+      else
+        out << *c;
+    }
+    out << '"';
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Tracer& Tracer::instance()
+{
+  static Tracer tracer;
+  return tracer;
+}
+
+Tracer::Tracer() :
+  m_enabled(false),
+  m_buffer_size(100000),
+  m_thread_buffer(&Tracer::no_cleanup)
+{
+}
+
+void Tracer::enable(const bool enabled)
+{
+  m_enabled = enabled;
+}
+
+void Tracer::set_buffer_size(const Uint buffer_size)
+{
+  if(buffer_size == 0)
+    throw BadValue(FromHere(), "The trace buffer size must be larger than 0");
+
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_buffer_size = buffer_size;
+  BOOST_FOREACH(const boost::shared_ptr<ThreadBuffer>& buffer, m_buffers)
+  {
+    buffer->events.assign(buffer_size, Event());
+    buffer->count.store(0);
+    buffer->totals.clear();
+  }
+}
+
+boost::uint64_t Tracer::now() const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char* name, const char* category, const boost::uint64_t begin, const boost::uint64_t end)
+{
+  ThreadBuffer& buffer = thread_buffer();
+  const boost::uint64_t count = buffer.count.load(std::memory_order_relaxed);
+  Event& event = buffer.events[count % buffer.events.size()];
+  event.name = name;
+  event.category = category;
+  event.begin = begin;
+  event.end = end;
+  buffer.count.store(count + 1, std::memory_order_release);
+
+  // Totals are kept separately, so the summary is complete when the oldest events are overwritten
+  RegionTotal& total = buffer.totals[name];
+  total.time += end - begin;
+  ++total.count;
+}
+
+const char* Tracer::intern(const std::string& name)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  return m_names.insert(name).first->c_str();
+}
+
+Tracer::ThreadBuffer& Tracer::thread_buffer()
+{
+  ThreadBuffer* buffer = m_thread_buffer.get();
+  if(buffer == 0)
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_buffers.push_back(boost::make_shared<ThreadBuffer>(m_buffer_size, m_buffers.size()));
+    buffer = m_buffers.back().get();
+    m_thread_buffer.reset(buffer);
+  }
+  return *buffer;
+}
+
+std::vector< std::pair<Tracer::Event, Uint> > Tracer::events() const
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  std::vector< std::pair<Event, Uint> > result;
+  BOOST_FOREACH(const boost::shared_ptr<ThreadBuffer>& buffer, m_buffers)
+  {
+    const boost::uint64_t count = buffer->count.load(std::memory_order_acquire);
+    const boost::uint64_t size = buffer->events.size();
+    for(boost::uint64_t i = count > size ? count - size : 0; i != count; ++i)
+      result.push_back(std::make_pair(buffer->events[i % size], buffer->thread_idx));
+  }
+  return result;
+}
+
+void Tracer::write_chrome_trace(const std::string& file_name) const
+{
+  std::ofstream file(file_name.c_str());
+  if(!file)
+    throw FileSystemError(FromHere(), "Could not open trace file " + file_name);
+
+  const Uint rank = PE::Comm::instance().is_active() ? PE::Comm::instance().rank() : 0;
+
+  // Complete events, with times in microseconds
+  file << "{\"traceEvents\":[\n";
+  file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"args\":{\"name\":\"rank " << rank << "\"}}";
+  file << std::fixed << std::setprecision(3);
+  typedef std::pair<Event, Uint> EventT;
+  BOOST_FOREACH(const EventT& event, events())
+  {
+    file << ",\n{\"name\":";
+    detail::write_json_string(file, event.first.name);
+    file << ",\"cat\":";
+    detail::write_json_string(file, event.first.category);
+    file << ",\"ph\":\"X\",\"ts\":" << static_cast<Real>(event.first.begin) * 1e-3
+         << ",\"dur\":" << static_cast<Real>(event.first.end - event.first.begin) * 1e-3
+         << ",\"pid\":" << rank << ",\"tid\":" << event.second << "}";
+  }
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+std::string Tracer::summary() const
+{
+  // Local totals in seconds and call counts, per region name
+  std::map< std::string, std::pair<Real, Uint> > local_stats;
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    typedef std::pair<const char* const, RegionTotal> TotalT;
+    BOOST_FOREACH(const boost::shared_ptr<ThreadBuffer>& buffer, m_buffers)
+    {
+      BOOST_FOREACH(const TotalT& total, buffer->totals)
+      {
+        std::pair<Real, Uint>& stats = local_stats[total.first];
+        stats.first += static_cast<Real>(total.second.time) * 1e-9;
+        stats.second += static_cast<Uint>(total.second.count);
+      }
+    }
+  }
+
+  // All ranks need the same list of names
+  std::vector<std::string> names;
+  PE::Comm& comm = PE::Comm::instance();
+  Uint nb_ranks = 1;
+  if(comm.is_active())
+  {
+    nb_ranks = comm.size();
+    PE::Buffer send_names;
+    PE::Buffer recv_names;
+    typedef std::pair< std::string, std::pair<Real, Uint> > StatsT;
+    BOOST_FOREACH(const StatsT& stats, local_stats)
+      send_names << stats.first;
+    send_names.all_gather(recv_names);
+    std::set<std::string> all_names;
+    std::string name;
+    while(recv_names.more_to_unpack())
+    {
+      recv_names >> name;
+      all_names.insert(name);
+    }
+    names.assign(all_names.begin(), all_names.end());
+  }
+  else
+  {
+    typedef std::pair< std::string, std::pair<Real, Uint> > StatsT;
+    BOOST_FOREACH(const StatsT& stats, local_stats)
+      names.push_back(stats.first);
+  }
+
+  const Uint nb_names = names.size();
+  std::vector<Real> totals(nb_names, 0.);
+  std::vector<Uint> counts(nb_names, 0);
+  for(Uint i = 0; i != nb_names; ++i)
+  {
+    std::map< std::string, std::pair<Real, Uint> >::const_iterator stats = local_stats.find(names[i]);
+    if(stats != local_stats.end())
+    {
+      totals[i] = stats->second.first;
+      counts[i] = stats->second.second;
+    }
+  }
+
+  std::vector<Real> min_totals(totals), max_totals(totals), sum_totals(totals);
+  std::vector<Uint> sum_counts(counts);
+  if(comm.is_active() && nb_names != 0)
+  {
+    comm.all_reduce(PE::min(), &totals[0], nb_names, &min_totals[0]);
+    comm.all_reduce(PE::max(), &totals[0], nb_names, &max_totals[0]);
+    comm.all_reduce(PE::plus(), &totals[0], nb_names, &sum_totals[0]);
+    comm.all_reduce(PE::plus(), &counts[0], nb_names, &sum_counts[0]);
+  }
+
+  // Most expensive regions first
+  std::vector< std::pair<Real, Uint> > order(nb_names);
+  for(Uint i = 0; i != nb_names; ++i)
+    order[i] = std::make_pair(-max_totals[i], i);
+  std::sort(order.begin(), order.end());
+
+  std::stringstream result;
+  result << "Trace summary over " << nb_ranks << " ranks, times in seconds including nested regions\n";
+  result << std::setw(40) << std::left << "region" << std::right
+         << std::setw(12) << "calls" << std::setw(14) << "min" << std::setw(14) << "max"
+         << std::setw(14) << "avg" << std::setw(12) << "max/avg" << "\n";
+  result << std::scientific << std::setprecision(4);
+  for(Uint j = 0; j != nb_names; ++j)
+  {
+    const Uint i = order[j].second;
+    const Real avg = sum_totals[i] / static_cast<Real>(nb_ranks);
+    result << std::setw(40) << std::left << names[i] << std::right
+           << std::setw(12) << sum_counts[i] << std::setw(14) << min_totals[i] << std::setw(14) << max_totals[i]
+           << std::setw(14) << avg << std::setw(12) << std::fixed << std::setprecision(3) << (avg > 0. ? max_totals[i] / avg : 1.)
+           << std::scientific << std::setprecision(4) << "\n";
+  }
+  return result.str();
+}
+
+void Tracer::clear()
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  BOOST_FOREACH(const boost::shared_ptr<ThreadBuffer>& buffer, m_buffers)
+  {
+    buffer->count.store(0);
+    buffer->totals.clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
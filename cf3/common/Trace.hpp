@@ -0,0 +1,181 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_Trace_hpp
+#define cf3_common_Trace_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "common/CF.hpp"
+#include "common/CommonAPI.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Records the begin and end time of nested regions of code, for all threads of the process.
+/// Each thread records into its own ring buffer without locking, so tracing can stay enabled in production runs.
+/// When a buffer is full, the oldest events are overwritten. The result can be written in the Chrome trace format,
+/// which is read by chrome://tracing and https://ui.perfetto.dev, and summarized over all ranks to show imbalance.
+/// Tracing is disabled by default, and is controlled through the "trace" option of the Environment.
+class Common_API Tracer : public boost::noncopyable
+{
+public:
+  /// A completed region
+  struct Event
+  {
+    const char* name;
+    const char* category;
+    /// Times in nanoseconds of the steady clock
+    boost::uint64_t begin;
+    boost::uint64_t end;
+  };
+
+  /// Access to the process-wide tracer
+  static Tracer& instance();
+
+  /// True if regions are recorded
+  bool enabled() const { return m_enabled; }
+
+  /// Start or stop recording. Events that were recorded before are kept.
+  void enable(const bool enabled);
+
+  /// Set the number of events kept for each thread. This clears the recorded events, and must not be called while recording.
+  void set_buffer_size(const Uint buffer_size);
+
+  /// Current time in nanoseconds of the steady clock, so ranks on the same node share the time base
+  boost::uint64_t now() const;
+
+  /// Record a completed region for the calling thread. The name and category must stay valid as long as the event is kept.
+  void record(const char* name, const char* category, const boost::uint64_t begin, const boost::uint64_t end);
+
+  /// Copy of the given name that stays valid for the lifetime of the tracer, for regions named at run time
+  const char* intern(const std::string& name);
+
+  /// Events of all threads, oldest first for each thread. The second member of each pair is the thread index.
+  /// Recording must not happen at the same time.
+  std::vector< std::pair<Event, Uint> > events() const;
+
+  /// Write the events of this rank in the Chrome trace format. The process id is the rank, the thread id the thread index.
+  void write_chrome_trace(const std::string& file_name) const;
+
+  /// Total time and number of calls for each region name, with the minimum, maximum and average total time
+  /// over all ranks. The totals include the events that were overwritten in the ring buffers.
+  /// This is collective when the communicator is active. Recording must not happen at the same time.
+  std::string summary() const;
+
+  /// Remove all recorded events and totals. Recording must not happen at the same time.
+  void clear();
+
+private:
+  Tracer();
+
+  /// Running total of a region, in nanoseconds
+  struct RegionTotal
+  {
+    boost::uint64_t time;
+    boost::uint64_t count;
+  };
+
+  /// Events recorded by a single thread
+  struct ThreadBuffer
+  {
+    ThreadBuffer(const Uint size, const Uint idx) : events(size), count(0), thread_idx(idx) {}
+
+    std::vector<Event> events;
+    /// Total number of events recorded, the last one being at position (count-1) % events.size()
+    std::atomic<boost::uint64_t> count;
+    Uint thread_idx;
+    /// Totals of all events recorded by this thread, per region name
+    std::map<const char*, RegionTotal> totals;
+  };
+
+  /// Buffer for the calling thread, created on the first use
+  ThreadBuffer& thread_buffer();
+
+  /// Buffers are never deleted while the program runs, so no cleanup is done when a thread exits
+  static void no_cleanup(ThreadBuffer*) {}
+
+  bool m_enabled;
+  Uint m_buffer_size;
+
+  /// Protects the list of buffers and the interned names, not the recording itself
+  mutable boost::mutex m_mutex;
+  std::vector< boost::shared_ptr<ThreadBuffer> > m_buffers;
+  boost::thread_specific_ptr<ThreadBuffer> m_thread_buffer;
+  std::set<std::string> m_names;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Traces the region of code in which the object lives, when tracing is enabled:
+///
+///   {
+///     TraceRegion trace("assembly", "proto");
+///     ...
+///   }
+class Common_API TraceRegion : public boost::noncopyable
+{
+public:
+  /// Region with a name that stays valid, e.g. a string literal
+  TraceRegion(const char* name, const char* category = "cf3") :
+    m_name(0),
+    m_category(category)
+  {
+    if(Tracer::instance().enabled())
+    {
+      m_name = name;
+      m_begin = Tracer::instance().now();
+    }
+  }
+
+  /// Region with a name that is built at run time
+  TraceRegion(const std::string& name, const char* category = "cf3") :
+    m_name(0),
+    m_category(category)
+  {
+    if(Tracer::instance().enabled())
+    {
+      m_name = Tracer::instance().intern(name);
+      m_begin = Tracer::instance().now();
+    }
+  }
+
+  ~TraceRegion()
+  {
+    if(m_name != 0)
+      Tracer::instance().record(m_name, m_category, m_begin, Tracer::instance().now());
+  }
+
+private:
+  const char* m_name;
+  const char* m_category;
+  boost::uint64_t m_begin;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_Trace_hpp
@@ -0,0 +1,53 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include "common/BasicExceptions.hpp"
+
+#include "math/LSS/Matrix.hpp"
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////
+
+boost::shared_ptr<BlockBatch> Matrix::create_batch(const Uint block_nb_nodes, const std::vector<Uint>& node_indices)
+{
+  if(block_nb_nodes == 0 || node_indices.size() % block_nb_nodes != 0)
+    throw common::BadValue(FromHere(), "Number of node indices for a batch is not a multiple of the block size");
+
+  boost::shared_ptr<BlockBatch> result(new BlockBatch());
+  result->block_nb_nodes = block_nb_nodes;
+  result->node_indices = node_indices;
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Matrix::add_values_batch(const BlockBatch& batch, const Uint begin_block, const Uint end_block, const Real* values)
+{
+  cf3_assert(end_block <= batch.nb_blocks());
+  const Uint nb_nodes = batch.block_nb_nodes;
+  const Uint block_size = nb_nodes*neq();
+  const Uint nb_entries = block_size*block_size;
+
+  BlockAccumulator acc;
+  acc.resize(nb_nodes, neq());
+  for(Uint block = begin_block; block != end_block; ++block)
+  {
+    for(Uint i = 0; i != nb_nodes; ++i)
+      acc.indices[i] = batch.node_indices[block*nb_nodes + i];
+    std::copy(values, values + nb_entries, acc.mat.data());
+    add_values(acc);
+    values += nb_entries;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
@@ -9,6 +9,7 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <boost/shared_ptr.hpp>
 #include <boost/utility.hpp>
 
 #include "math/LSS/LibLSS.hpp"
@@ -32,6 +33,35 @@ namespace LSS {
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+/// Node indices of a batch of element blocks that all have the same number of nodes, together with any data a matrix
+/// precomputes to add their values quickly. Created by Matrix::create_batch, and only valid for the matrix that created it
+/// until that matrix is created again.
+class LSS_API BlockBatch
+{
+public:
+  BlockBatch() : values(nullptr) {}
+  virtual ~BlockBatch() {}
+
+  /// Number of nodes in each block
+  Uint block_nb_nodes;
+
+  /// Local node indices, block_nb_nodes per block
+  std::vector<Uint> node_indices;
+
+  /// Number of blocks in the batch
+  Uint nb_blocks() const { return node_indices.size() / block_nb_nodes; }
+
+  /// Start of the value array of the matrix, if it stores all values in one array that doesn't move until the matrix is
+  /// created again. The block entries can then be added to it directly through the offsets. Null otherwise.
+  Real* values;
+
+  /// Offset in values of each entry of each block matrix, in the layout of add_values_batch, or -1 for entries that are
+  /// not stored on this process. Only filled if values is not null.
+  std::vector<int> offsets;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 class LSS_API Matrix : public cf3::common::Component {
 public:
 
@@ -94,6 +124,15 @@ public:
   /// Add a list of values
   virtual void get_values(BlockAccumulator& values) = 0;
 
+  /// Prepare a batch of element blocks with block_nb_nodes nodes each, for use with add_values_batch.
+  /// The batch can be reused as long as the matrix is not created again.
+  virtual boost::shared_ptr<BlockBatch> create_batch(const Uint block_nb_nodes, const std::vector<Uint>& node_indices);
+
+  /// Add the element matrices of the blocks [begin_block, end_block) of a batch. values points to the matrix of begin_block,
+  /// and the matrices follow each other, each in the row-major layout of BlockAccumulator::mat.
+  /// Can be called concurrently for block ranges that don't share rows, if add_values can.
+  virtual void add_values_batch(const BlockBatch& batch, const Uint begin_block, const Uint end_block, const Real* values);
+
   /// Set a row, diagonal and off-diagonals values separately (dirichlet-type boundaries)
   virtual void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval) = 0;
 
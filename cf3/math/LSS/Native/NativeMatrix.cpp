@@ -0,0 +1,658 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include "common/Assertions.hpp"
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/ThreadPool.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "math/VariablesDescriptor.hpp"
+
+#include "math/LSS/Native/NativeMatrix.hpp"
+#include "math/LSS/Native/NativeVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file NativeMatrix.cpp Implementation of LSS::Matrix for the native linear solver
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::math;
+using namespace cf3::math::LSS;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < LSS::NativeMatrix, LSS::Matrix, LSS::LibLSS > NativeMatrix_Builder;
+
+const Uint NativeMatrix::invalid_position = std::numeric_limits<Uint>::max();
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Computes y = alpha*A*x + beta*y for the rows in the chunk of the thread
+void multiply_rows(const Uint thread_idx, const Uint nb_threads, boost::barrier&, const NativeMatrix& matrix, const Uint neq, const Real* x, Real* y, const Real alpha, const Real beta)
+{
+  const std::vector<Uint>& row_starts = matrix.row_starts();
+  const std::vector<Uint>& block_columns = matrix.block_columns();
+  const Real* values = matrix.values().empty() ? 0 : &matrix.values()[0];
+  const Uint block_size = neq*neq;
+
+  Uint begin, end;
+  common::ThreadPool::static_chunk(row_starts.size() - 1, thread_idx, nb_threads, begin, end);
+
+  std::vector<Real> row_sum(neq);
+  for(Uint row = begin; row != end; ++row)
+  {
+    const Uint row_begin = row_starts[row];
+    const Uint row_end = row_starts[row+1];
+    if(row_begin == row_end)
+      continue;
+
+    std::fill(row_sum.begin(), row_sum.end(), 0.);
+    for(Uint pos = row_begin; pos != row_end; ++pos)
+    {
+      const Real* block = values + pos*block_size;
+      const Real* x_block = x + block_columns[pos]*neq;
+      for(Uint a = 0; a != neq; ++a)
+        for(Uint b = 0; b != neq; ++b)
+          row_sum[a] += block[a*neq+b] * x_block[b];
+    }
+
+    Real* y_block = y + row*neq;
+    for(Uint a = 0; a != neq; ++a)
+      y_block[a] = beta == 0. ? alpha*row_sum[a] : alpha*row_sum[a] + beta*y_block[a];
+  }
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+NativeMatrix::NativeMatrix(const std::string& name) :
+  LSS::Matrix(name),
+  m_neq(0),
+  m_is_created(false),
+  m_nb_owned(0)
+{
+  properties().add("vector_type", std::string("cf3.math.LSS.NativeVector"));
+
+  options().add("nb_threads", 1u)
+    .description("Number of threads used for the matrix-vector product")
+    .pretty_name("Number of Threads");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::create(common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  if (m_is_created) destroy();
+
+  detail::create_native_node_map(cp, periodic_links_nodes, periodic_links_active, m_node_map, m_owned);
+  const Uint nb_nodes = m_node_map.size();
+  cf3_assert(starting_indices.size() == nb_nodes+1);
+  m_neq = neq;
+  m_nb_owned = std::count(m_owned.begin(), m_owned.end(), true);
+
+  m_node_connectivity = node_connectivity;
+  m_starting_indices = starting_indices;
+  m_periodic_nodes.clear();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(m_node_map[i] != i)
+      m_periodic_nodes[m_node_map[i]].push_back(i);
+  }
+
+  // Collect the columns of each row. The rows of periodic nodes are merged into the row of the node they are linked to.
+  std::vector< std::vector<Uint> > row_columns(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint row = m_node_map[i];
+    if(!m_owned[row])
+      continue;
+
+    std::vector<Uint>& columns = row_columns[row];
+    columns.push_back(row);
+    for(Uint j = starting_indices[i]; j != starting_indices[i+1]; ++j)
+      columns.push_back(m_node_map[node_connectivity[j]]);
+  }
+
+  m_row_starts.assign(nb_nodes+1, 0);
+  m_block_columns.clear();
+  for(Uint row = 0; row != nb_nodes; ++row)
+  {
+    std::vector<Uint>& columns = row_columns[row];
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+    m_block_columns.insert(m_block_columns.end(), columns.begin(), columns.end());
+    m_row_starts[row+1] = m_block_columns.size();
+    std::vector<Uint>().swap(columns);
+  }
+
+  m_values.assign(m_block_columns.size()*m_neq*m_neq, 0.);
+
+  CFdebug << "Native: created a " << m_nb_owned*m_neq << " x " << nb_nodes*m_neq << " matrix with " << m_block_columns.size() << " blocks of size " << m_neq << CFendl;
+
+  m_is_created = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, Vector& solution, Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  create(cp, vars.size(), node_connectivity, starting_indices, solution, rhs, periodic_links_nodes, periodic_links_active);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::destroy()
+{
+  m_node_map.clear();
+  m_owned.clear();
+  m_row_starts.clear();
+  m_block_columns.clear();
+  m_values.clear();
+  m_node_connectivity.clear();
+  m_starting_indices.clear();
+  m_periodic_nodes.clear();
+  m_symmetric_dirichlet_values.clear();
+  m_nb_owned = 0;
+  m_neq = 0;
+  m_is_created = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Uint NativeMatrix::block_position(const Uint row, const Uint col) const
+{
+  const std::vector<Uint>::const_iterator row_begin = m_block_columns.begin() + m_row_starts[row];
+  const std::vector<Uint>::const_iterator row_end = m_block_columns.begin() + m_row_starts[row+1];
+  const std::vector<Uint>::const_iterator found = std::lower_bound(row_begin, row_end, col);
+  if(found == row_end || *found != col)
+    return invalid_position;
+  return found - m_block_columns.begin();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Real* NativeMatrix::block(const Uint row, const Uint col)
+{
+  const Uint pos = block_position(row, col);
+  if(pos == invalid_position)
+    throw common::BadValue(FromHere(), "Trying to access an illegal entry.");
+  return &m_values[pos*m_neq*m_neq];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::set_value(const Uint icol, const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  const Uint row = m_node_map[irow / m_neq];
+  if(m_owned[row])
+    block(row, m_node_map[icol / m_neq])[(irow % m_neq)*m_neq + icol % m_neq] = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::add_value(const Uint icol, const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  const Uint row = m_node_map[irow / m_neq];
+  if(m_owned[row])
+    block(row, m_node_map[icol / m_neq])[(irow % m_neq)*m_neq + icol % m_neq] += value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::get_value(const Uint icol, const Uint irow, Real& value)
+{
+  cf3_assert(m_is_created);
+  const Uint row = m_node_map[irow / m_neq];
+  value = m_owned[row] ? block(row, m_node_map[icol / m_neq])[(irow % m_neq)*m_neq + icol % m_neq] : 0.;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::set_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint row = m_node_map[values.indices[i]];
+    if(!m_owned[row])
+      continue;
+    for(Uint j = 0; j != nb_nodes; ++j)
+    {
+      Real* row_block = block(row, m_node_map[values.indices[j]]);
+      for(Uint a = 0; a != m_neq; ++a)
+        for(Uint b = 0; b != m_neq; ++b)
+          row_block[a*m_neq+b] = values.mat(i*m_neq+a, j*m_neq+b);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::add_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint row = m_node_map[values.indices[i]];
+    if(!m_owned[row])
+      continue;
+    for(Uint j = 0; j != nb_nodes; ++j)
+    {
+      Real* row_block = block(row, m_node_map[values.indices[j]]);
+      for(Uint a = 0; a != m_neq; ++a)
+        for(Uint b = 0; b != m_neq; ++b)
+          row_block[a*m_neq+b] += values.mat(i*m_neq+a, j*m_neq+b);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::get_values(BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  values.mat.setZero();
+  const Uint nb_nodes = values.indices.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint row = m_node_map[values.indices[i]];
+    if(!m_owned[row])
+      continue;
+    for(Uint j = 0; j != nb_nodes; ++j)
+    {
+      const Real* row_block = block(row, m_node_map[values.indices[j]]);
+      for(Uint a = 0; a != m_neq; ++a)
+        for(Uint b = 0; b != m_neq; ++b)
+          values.mat(i*m_neq+a, j*m_neq+b) = row_block[a*m_neq+b];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval)
+{
+  cf3_assert(m_is_created);
+  const Uint row = m_node_map[iblockrow];
+  if(!m_owned[row])
+    return;
+
+  for(Uint pos = m_row_starts[row]; pos != m_row_starts[row+1]; ++pos)
+  {
+    Real* row_values = &m_values[pos*m_neq*m_neq + ieq*m_neq];
+    for(Uint b = 0; b != m_neq; ++b)
+      row_values[b] = (m_block_columns[pos] == row && b == ieq) ? diagval : offdiagval;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = m_node_map.size();
+  const Uint col = m_node_map[iblockcol];
+  values.assign(nb_nodes*m_neq, 0.);
+  for(Uint row = 0; row != nb_nodes; ++row)
+  {
+    const Uint pos = block_position(row, col);
+    if(pos == invalid_position)
+      continue;
+    Real* col_values = &m_values[pos*m_neq*m_neq + ieq];
+    for(Uint a = 0; a != m_neq; ++a)
+    {
+      values[row*m_neq+a] = col_values[a*m_neq];
+      col_values[a*m_neq] = 0.;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs)
+{
+  cf3_assert(m_is_created);
+  NativeVector& rhs_vec = dynamic_cast<NativeVector&>(rhs);
+  std::vector<Real>& rhs_data = rhs_vec.data();
+
+  const Uint bc_node = m_node_map[blockrow];
+  const Uint bc_col = bc_node*m_neq + ieq;
+
+  DirichletEntryT& cached_values = m_symmetric_dirichlet_values[bc_col];
+  if(cached_values.empty())
+  {
+    // The matrix is structurally symmetric, so the rows with an entry in the column are the neighbours of the node,
+    // including the neighbours of the periodic nodes whose rows were merged into it
+    std::vector<Uint> nodes(1, bc_node);
+    const std::map< Uint, std::vector<Uint> >::const_iterator periodic_nodes = m_periodic_nodes.find(bc_node);
+    if(periodic_nodes != m_periodic_nodes.end())
+      nodes.insert(nodes.end(), periodic_nodes->second.begin(), periodic_nodes->second.end());
+
+    std::vector<Uint> rows(1, bc_node);
+    BOOST_FOREACH(const Uint node, nodes)
+    {
+      for(Uint j = m_starting_indices[node]; j != m_starting_indices[node+1]; ++j)
+        rows.push_back(m_node_map[m_node_connectivity[j]]);
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    BOOST_FOREACH(const Uint row, rows)
+    {
+      if(!m_owned[row])
+        continue;
+      const Uint pos = block_position(row, bc_node);
+      if(pos == invalid_position)
+        continue;
+
+      for(Uint a = 0; a != m_neq; ++a)
+      {
+        const Uint other_row = row*m_neq + a;
+        if(other_row != bc_col)
+        {
+          Real& entry = m_values[pos*m_neq*m_neq + a*m_neq + ieq];
+          cached_values[other_row] = entry;
+          rhs_data[other_row] -= entry*value;
+          entry = 0.;
+        }
+      }
+    }
+
+    if(m_owned[bc_node])
+      set_row(bc_node, ieq, 1., 0.);
+  }
+  else
+  {
+    for(DirichletEntryT::const_iterator it = cached_values.begin(); it != cached_values.end(); ++it)
+      rhs_data[it->first] -= it->second*value;
+  }
+
+  rhs.set_value(blockrow, ieq, value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from)
+{
+  cf3_assert(m_is_created);
+  const Uint row_to = m_node_map[iblockrow_to];
+  const Uint row_from = m_node_map[iblockrow_from];
+  if(!m_owned[row_to] || !m_owned[row_from])
+    return;
+
+  const Uint row_size = m_row_starts[row_to+1] - m_row_starts[row_to];
+  if(row_size != m_row_starts[row_from+1] - m_row_starts[row_from] || !std::equal(m_block_columns.begin() + m_row_starts[row_to], m_block_columns.begin() + m_row_starts[row_to+1], m_block_columns.begin() + m_row_starts[row_from]))
+    throw common::BadValue(FromHere(), "Rows to tie have a different sparsity pattern.");
+
+  const Uint block_size = m_neq*m_neq;
+  Real* values_to = &m_values[m_row_starts[row_to]*block_size];
+  Real* values_from = &m_values[m_row_starts[row_from]*block_size];
+
+  // Add the from row to the to row, and replace it with from - to = 0
+  for(Uint i = 0; i != row_size*block_size; ++i)
+  {
+    values_to[i] += values_from[i];
+    values_from[i] = 0.;
+  }
+  Real* from_diag = block(row_from, row_from);
+  Real* from_to = block(row_from, row_to);
+  for(Uint a = 0; a != m_neq; ++a)
+  {
+    from_diag[a*m_neq+a] = 1.;
+    from_to[a*m_neq+a] = -1.;
+  }
+
+  // Move the contribution of the from node in the to row to the to node
+  Real* to_diag = block(row_to, row_to);
+  Real* to_from = block(row_to, row_from);
+  for(Uint i = 0; i != block_size; ++i)
+  {
+    to_diag[i] += to_from[i];
+    to_from[i] = 0.;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::set_diagonal(const std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(diag.size() == m_node_map.size()*m_neq);
+  const Uint nb_nodes = m_node_map.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(!m_owned[i])
+      continue;
+    Real* diag_block = block(i, i);
+    for(Uint a = 0; a != m_neq; ++a)
+      diag_block[a*m_neq+a] = diag[i*m_neq+a];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::add_diagonal(const std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(diag.size() == m_node_map.size()*m_neq);
+  const Uint nb_nodes = m_node_map.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(!m_owned[i])
+      continue;
+    Real* diag_block = block(i, i);
+    for(Uint a = 0; a != m_neq; ++a)
+      diag_block[a*m_neq+a] += diag[i*m_neq+a];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::get_diagonal(std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = m_node_map.size();
+  diag.assign(nb_nodes*m_neq, 0.);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint row = m_node_map[i];
+    if(!m_owned[row])
+      continue;
+    const Real* diag_block = block(row, row);
+    for(Uint a = 0; a != m_neq; ++a)
+      diag[i*m_neq+a] = diag_block[a*m_neq+a];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::reset(Real reset_to)
+{
+  cf3_assert(m_is_created);
+  m_values.assign(m_values.size(), reset_to);
+  m_symmetric_dirichlet_values.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::print(common::LogStream& stream)
+{
+  std::stringstream output;
+  print(output);
+  stream << output.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::print(std::ostream& stream)
+{
+  if (m_is_created)
+  {
+    std::vector<Uint> row_indices, col_indices;
+    std::vector<Real> values;
+    debug_data(row_indices, col_indices, values);
+    const Uint nb_entries = values.size();
+    for(Uint i = 0; i != nb_entries; ++i)
+      stream << col_indices[i] << " " << -static_cast<int>(row_indices[i]) << " " << values[i] << "\n";
+    stream << "# name:                 " << name() << "\n";
+    stream << "# type_name:            " << type_name() << "\n";
+    stream << "# process:              " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:  " << m_neq << "\n";
+    stream << "# number of rows:       " << m_nb_owned*m_neq << "\n";
+    stream << "# number of cols:       " << m_node_map.size()*m_neq << "\n";
+    stream << "# number of block rows: " << m_nb_owned << "\n";
+    stream << "# number of block cols: " << m_node_map.size() << "\n";
+    stream << "# number of entries:    " << nb_entries << "\n" << std::flush;
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::print(const std::string& filename, std::ios_base::openmode mode )
+{
+  std::ofstream stream(filename.c_str(),mode);
+  stream << "VARIABLES=COL,ROW,VAL\n" << std::flush;
+  stream << "ZONE T=\"" << type_name() << "::" << name() <<  "\"\n" << std::flush;
+  print(stream);
+  stream.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::print_native(std::ostream& stream)
+{
+  const Uint nb_nodes = m_node_map.size();
+  const Uint block_size = m_neq*m_neq;
+  for(Uint row = 0; row != nb_nodes; ++row)
+  {
+    for(Uint pos = m_row_starts[row]; pos != m_row_starts[row+1]; ++pos)
+    {
+      stream << row << " " << m_block_columns[pos] << ":";
+      for(Uint i = 0; i != block_size; ++i)
+        stream << " " << m_values[pos*block_size + i];
+      stream << "\n";
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::clone_to(Matrix& other)
+{
+  if(!m_is_created)
+    throw common::SetupError(FromHere(), "Matrix to clone " + uri().string() + " is not created");
+
+  NativeMatrix* other_ptr = dynamic_cast<NativeMatrix*>(&other);
+  if(is_null(other_ptr))
+    throw common::SetupError(FromHere(), "clone_to method of NativeMatrix needs another NativeMatrix, but a " + other.derived_type_name() + " was supplied instead.");
+
+  other_ptr->m_neq = m_neq;
+  other_ptr->m_node_map = m_node_map;
+  other_ptr->m_owned = m_owned;
+  other_ptr->m_nb_owned = m_nb_owned;
+  other_ptr->m_row_starts = m_row_starts;
+  other_ptr->m_block_columns = m_block_columns;
+  other_ptr->m_values = m_values;
+  other_ptr->m_node_connectivity = m_node_connectivity;
+  other_ptr->m_starting_indices = m_starting_indices;
+  other_ptr->m_periodic_nodes = m_periodic_nodes;
+  other_ptr->m_symmetric_dirichlet_values = m_symmetric_dirichlet_values;
+  other_ptr->m_is_created = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::read_native(const common::URI& file)
+{
+  throw common::NotSupported(FromHere(), "NativeMatrix can't read matrices from file");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::apply(const Handle<Vector>& y, const Handle<Vector const>& x, const Real alpha, const Real beta)
+{
+  NativeVector* y_ptr = dynamic_cast<NativeVector*>(y.get());
+  NativeVector const* x_ptr = dynamic_cast<NativeVector const*>(x.get());
+  if(is_null(y_ptr) || is_null(x_ptr))
+    throw common::SetupError(FromHere(), "apply method of NativeMatrix needs NativeVector arguments");
+
+  multiply(x_ptr->data(), y_ptr->data(), alpha, beta);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::multiply(const std::vector<Real>& x, std::vector<Real>& y, const Real alpha, const Real beta) const
+{
+  cf3_assert(m_is_created);
+  cf3_assert(x.size() == m_node_map.size()*m_neq);
+  cf3_assert(y.size() == m_node_map.size()*m_neq);
+  if(y.empty())
+    return;
+
+  common::ThreadPool::instance().run(nb_threads(), boost::bind(multiply_rows, _1, _2, _3, boost::cref(*this), m_neq, &x[0], &y[0], alpha, beta));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Uint NativeMatrix::nb_threads() const
+{
+  return std::max(options().value<Uint>("nb_threads"), 1u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeMatrix::debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values)
+{
+  cf3_assert(m_is_created);
+  row_indices.clear();
+  col_indices.clear();
+  values.clear();
+  const Uint nb_nodes = m_node_map.size();
+  for(Uint row = 0; row != nb_nodes; ++row)
+  {
+    for(Uint a = 0; a != m_neq; ++a)
+    {
+      for(Uint pos = m_row_starts[row]; pos != m_row_starts[row+1]; ++pos)
+      {
+        for(Uint b = 0; b != m_neq; ++b)
+        {
+          row_indices.push_back(row*m_neq+a);
+          col_indices.push_back(m_block_columns[pos]*m_neq+b);
+          values.push_back(m_values[pos*m_neq*m_neq + a*m_neq + b]);
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,244 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_NativeMatrix_hpp
+#define cf3_Math_LSS_NativeMatrix_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <map>
+
+#include "math/LSS/LibLSS.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "math/LSS/Matrix.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file NativeMatrix.hpp Matrix of the native linear solver, which does not need Trilinos
+
+  The matrix is stored in block compressed sparse row format, with a dense neq x neq block for each pair of connected nodes.
+  Rows and columns are numbered as the nodes of the CommPattern, and only the nodes owned by this process have a row.
+  Periodic nodes are mapped onto the node they are linked to, as in TrilinosCrsMatrix.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+class NativeVector;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class LSS_API NativeMatrix : public LSS::Matrix {
+public:
+
+  /// @name CREATION, DESTRUCTION AND COMPONENT SYSTEM
+  //@{
+
+  /// name of the type
+  static std::string type_name () { return "NativeMatrix"; }
+
+  /// Accessor to solver type
+  const std::string solvertype() { return "Native"; }
+
+  /// Accessor to the flag if matrix, solution and rhs are tied together or not
+  const bool is_swappable(const LSS::Vector& solution, const LSS::Vector& rhs) { return true; }
+
+  /// Default constructor
+  NativeMatrix(const std::string& name);
+
+  /// Setup sparsity structure
+  void create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// The native solver does not depend on the ordering of the unknowns, so this is the same as create with vars.size() equations
+  void create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, Vector& solution, Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// Deallocate underlying data
+  void destroy();
+
+  //@} END CREATION, DESTRUCTION AND COMPONENT SYSTEM
+
+  /// @name INDIVIDUAL ACCESS
+  //@{
+
+  /// Set value at given location in the matrix
+  void set_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Add value at given location in the matrix
+  void add_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Get value at given location in the matrix
+  void get_value(const Uint icol, const Uint irow, Real& value);
+
+  //@} END INDIVIDUAL ACCESS
+
+  /// @name EFFICCIENT ACCESS
+  //@{
+
+  /// Set a list of values
+  void set_values(const BlockAccumulator& values);
+
+  /// Add a list of values. Can be called concurrently for blocks that don't share rows.
+  void add_values(const BlockAccumulator& values);
+
+  /// Add a list of values
+  void get_values(BlockAccumulator& values);
+
+  /// Set a row, diagonal and off-diagonals values separately (dirichlet-type boundaries)
+  void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval);
+
+  /// Get a column and replace it to zero (dirichlet-type boundaries, when trying to preserve symmetry)
+  void get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values);
+
+  /// Apply a dirichlet boundary condition, preserving symmetry by moving entries to the RHS
+  /// @pre The matrix must be structurally symmetric
+  void symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, LSS::Vector& rhs);
+
+  /// Add one line to another and tie to it via dirichlet-style (applying periodicity)
+  void tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from);
+
+  /// Set the diagonal
+  void set_diagonal(const std::vector<Real>& diag);
+
+  /// Add to the diagonal
+  void add_diagonal(const std::vector<Real>& diag);
+
+  /// Get the diagonal
+  void get_diagonal(std::vector<Real>& diag);
+
+  /// Reset Matrix
+  void reset(Real reset_to=0.);
+
+  //@} END EFFICCIENT ACCESS
+
+  /// @name MISCELLANEOUS
+  //@{
+
+  /// Print to wherever
+  void print(common::LogStream& stream);
+
+  /// Print to wherever
+  void print(std::ostream& stream);
+
+  /// Print to file given by filename
+  void print(const std::string& filename, std::ios_base::openmode mode = std::ios_base::out );
+
+  /// Prints the blocks of each row
+  void print_native(std::ostream& stream);
+
+  /// Accessor to the state of create
+  const bool is_created() { return m_is_created; }
+
+  /// Accessor to the number of equations
+  const Uint neq() { return m_neq; }
+
+  /// Accessor to the number of block rows
+  const Uint blockrow_size() { cf3_assert(m_is_created); return m_nb_owned; }
+
+  /// Accessor to the number of block columns
+  const Uint blockcol_size() { cf3_assert(m_is_created); return m_node_map.size(); }
+
+  /// Make a deep copy of the current matrix into other
+  void clone_to(Matrix& other);
+
+  /// Not supported
+  void read_native(const common::URI& file);
+
+  //@} END MISCELLANEOUS
+
+  /// @name LINEAR ALGEBRA
+  //@{
+
+  /// Compute y = alpha*A*x + beta*y. The ghost values of x must be up to date, see Vector::sync.
+  void apply(const Handle<Vector>& y, const Handle<Vector const>& x, const Real alpha = 1., const Real beta = 0.);
+
+  //@} END LINEAR ALGEBRA
+
+  /// @name TEST ONLY
+  //@{
+
+  /// exports the matrix into big linear arrays
+  /// @attention only for debug and utest purposes
+  void debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values);
+
+  //@} END TEST ONLY
+
+  /// @name NATIVE ACCESS
+  //@{
+
+  /// Value returned by block_position if there is no such block
+  static const Uint invalid_position;
+
+  /// Compute y = alpha*A*x + beta*y on the raw vector data, for the rows owned by this process.
+  /// Uses the number of threads given by the nb_threads option.
+  void multiply(const std::vector<Real>& x, std::vector<Real>& y, const Real alpha = 1., const Real beta = 0.) const;
+
+  /// Position of the block for the given row and column nodes in block_columns, or invalid_position
+  Uint block_position(const Uint row, const Uint col) const;
+
+  /// First block of each node row, with an extra entry for the end. Rows of nodes that are not owned are empty.
+  const std::vector<Uint>& row_starts() const { return m_row_starts; }
+
+  /// Column node of each block, sorted within each row
+  const std::vector<Uint>& block_columns() const { return m_block_columns; }
+
+  /// Values of the blocks, each stored row by row
+  const std::vector<Real>& values() const { return m_values; }
+
+  /// True for the nodes that have a row on this process
+  const std::vector<bool>& owned() const { return m_owned; }
+
+  /// Number of threads to use
+  Uint nb_threads() const;
+
+  //@} END NATIVE ACCESS
+
+private:
+
+  /// Pointer to the block for the given row and column nodes. Throws if there is no such block.
+  Real* block(const Uint row, const Uint col);
+
+  /// Number of equations per node
+  Uint m_neq;
+
+  /// State of creation
+  bool m_is_created;
+
+  /// Node holding the values, for each node
+  std::vector<Uint> m_node_map;
+
+  /// Nodes that have a row on this process
+  std::vector<bool> m_owned;
+
+  /// Number of rows on this process
+  Uint m_nb_owned;
+
+  /// Block CSR storage
+  std::vector<Uint> m_row_starts;
+  std::vector<Uint> m_block_columns;
+  std::vector<Real> m_values;
+
+  /// Copy of the node connectivity, used to find the rows affected by symmetric_dirichlet
+  std::vector<Uint> m_node_connectivity;
+  std::vector<Uint> m_starting_indices;
+  /// Nodes whose row is merged into the row of another node by periodicity, indexed by that row
+  std::map< Uint, std::vector<Uint> > m_periodic_nodes;
+
+  /// Values removed from each column by symmetric_dirichlet, by row
+  typedef std::map<Uint, Real> DirichletEntryT;
+  std::map<Uint, DirichletEntryT> m_symmetric_dirichlet_values;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_NativeMatrix_hpp
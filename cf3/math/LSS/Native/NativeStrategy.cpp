@@ -0,0 +1,640 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <cmath>
+
+#include <Eigen/LU>
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "math/MatrixTypes.hpp"
+
+#include "math/LSS/Native/NativeMatrix.hpp"
+#include "math/LSS/Native/NativeStrategy.hpp"
+#include "math/LSS/Native/NativeVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder<NativeStrategy, SolutionStrategy, LibLSS> NativeStrategy_builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+struct NativeStrategy::Implementation
+{
+  typedef std::vector<Real> VectorT;
+
+  Implementation(common::Component& self) :
+    m_self(self)
+  {
+    std::vector<boost::any> solvers;
+    solvers.push_back(std::string("CG"));
+    solvers.push_back(std::string("BiCGStab"));
+    solvers.push_back(std::string("GMRES"));
+    m_self.options().add("solver", std::string("GMRES"))
+      .pretty_name("Solver")
+      .description("Krylov method: CG (symmetric positive definite systems only), BiCGStab or GMRES")
+      .mark_basic()
+      .restricted_list() = solvers;
+
+    std::vector<boost::any> preconditioners;
+    preconditioners.push_back(std::string("Default"));
+    preconditioners.push_back(std::string("None"));
+    preconditioners.push_back(std::string("Jacobi"));
+    preconditioners.push_back(std::string("BlockJacobi"));
+    preconditioners.push_back(std::string("ILU0"));
+    m_self.options().add("preconditioner", std::string("Default"))
+      .pretty_name("Preconditioner")
+      .description("Preconditioner: None, Jacobi (inverse diagonal), BlockJacobi (inverse of the diagonal block of each node) "
+                   "or ILU0 (incomplete LU factorization without fill-in, local to each process). ILU0 is not symmetric, so it can't be used with CG. "
+                   "Default selects BlockJacobi for CG and ILU0 for the other solvers.")
+      .mark_basic()
+      .restricted_list() = preconditioners;
+
+    m_self.options().add("max_iterations", 1000u)
+      .pretty_name("Maximum Iterations")
+      .description("Maximum number of iterations")
+      .mark_basic();
+
+    m_self.options().add("tolerance", 1e-8)
+      .pretty_name("Tolerance")
+      .description("Convergence is reached when the norm of the residual is below this fraction of the norm of the right hand side")
+      .mark_basic();
+
+    m_self.options().add("gmres_restart", 30u)
+      .pretty_name("GMRES Restart")
+      .description("Number of GMRES iterations before restarting");
+
+    m_self.properties().add("iterations", 0u);
+    m_self.properties().add("residual", 0.);
+  }
+
+  void check_setup()
+  {
+    if(is_null(m_matrix))
+      throw common::SetupError(FromHere(), "Null or non-native matrix for " + m_self.uri().path());
+    if(is_null(m_rhs))
+      throw common::SetupError(FromHere(), "Null or non-native RHS for " + m_self.uri().path());
+    if(is_null(m_solution))
+      throw common::SetupError(FromHere(), "Null or non-native solution for " + m_self.uri().path());
+  }
+
+  void solve()
+  {
+    check_setup();
+
+    m_neq = m_matrix->neq();
+    m_owned = &m_matrix->owned();
+    if(is_null(m_work) || m_work->data().size() != m_solution->data().size())
+    {
+      m_work = common::allocate_component<NativeVector>("NativeStrategyWork");
+      m_solution->clone_to(*m_work);
+    }
+
+    setup_preconditioner();
+
+    const std::string solver = m_self.options().value<std::string>("solver");
+    VectorT& x = m_solution->data();
+    const VectorT& b = m_rhs->data();
+
+    const Real b_norm = norm(b);
+    Uint iterations = 0;
+    Real residual = 0.;
+    if(b_norm == 0.)
+    {
+      x.assign(x.size(), 0.);
+    }
+    else
+    {
+      const Real target = m_self.options().value<Real>("tolerance") * b_norm;
+      if(solver == "CG")
+        residual = cg(b, x, target, iterations);
+      else if(solver == "BiCGStab")
+        residual = bicgstab(b, x, target, iterations);
+      else
+        residual = gmres(b, x, target, iterations);
+      residual /= b_norm;
+
+      if(residual > m_self.options().value<Real>("tolerance"))
+        CFwarn << "Native " << solver << " solver did not converge after " << iterations << " iterations, relative residual is " << residual << CFendl;
+    }
+
+    m_solution->sync();
+
+    m_self.properties()["iterations"] = iterations;
+    m_self.properties()["residual"] = residual;
+    CFdebug << "Native " << solver << " solver finished after " << iterations << " iterations with relative residual " << residual << CFendl;
+  }
+
+  Real compute_residual()
+  {
+    check_setup();
+    m_neq = m_matrix->neq();
+    m_owned = &m_matrix->owned();
+    if(is_null(m_work) || m_work->data().size() != m_solution->data().size())
+    {
+      m_work = common::allocate_component<NativeVector>("NativeStrategyWork");
+      m_solution->clone_to(*m_work);
+    }
+
+    VectorT r;
+    residual(m_rhs->data(), m_solution->data(), r);
+    return norm(r);
+  }
+
+  /// @name Vector operations, on the entries owned by this process
+  //@{
+
+  Real dot(const VectorT& a, const VectorT& b) const
+  {
+    const std::vector<bool>& owned = *m_owned;
+    const Uint nb_nodes = owned.size();
+    Real local_result = 0.;
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      if(!owned[i])
+        continue;
+      for(Uint j = i*m_neq; j != (i+1)*m_neq; ++j)
+        local_result += a[j]*b[j];
+    }
+
+    if(!common::PE::Comm::instance().is_active())
+      return local_result;
+
+    Real result = 0.;
+    common::PE::Comm::instance().all_reduce(common::PE::plus(), &local_result, 1, &result);
+    return result;
+  }
+
+  Real norm(const VectorT& a) const
+  {
+    return std::sqrt(dot(a, a));
+  }
+
+  /// y = x + alpha*y
+  static void xpay(const VectorT& x, const Real alpha, VectorT& y)
+  {
+    const Uint size = y.size();
+    for(Uint i = 0; i != size; ++i)
+      y[i] = x[i] + alpha*y[i];
+  }
+
+  /// y += alpha*x
+  static void axpy(const Real alpha, const VectorT& x, VectorT& y)
+  {
+    const Uint size = y.size();
+    for(Uint i = 0; i != size; ++i)
+      y[i] += alpha*x[i];
+  }
+
+  /// y = A*x, after updating the ghost values of x
+  void multiply(const VectorT& x, VectorT& y)
+  {
+    m_work->data() = x;
+    m_work->sync();
+    y.resize(x.size());
+    m_matrix->multiply(m_work->data(), y);
+  }
+
+  /// r = b - A*x
+  void residual(const VectorT& b, const VectorT& x, VectorT& r)
+  {
+    multiply(x, r);
+    const Uint size = r.size();
+    for(Uint i = 0; i != size; ++i)
+      r[i] = b[i] - r[i];
+  }
+
+  //@}
+
+  /// @name Preconditioners
+  //@{
+
+  void setup_preconditioner()
+  {
+    const std::string solver = m_self.options().value<std::string>("solver");
+    m_preconditioner = m_self.options().value<std::string>("preconditioner");
+    if(m_preconditioner == "Default")
+      m_preconditioner = solver == "CG" ? "BlockJacobi" : "ILU0";
+    if(solver == "CG" && m_preconditioner == "ILU0")
+      throw common::SetupError(FromHere(), "The ILU0 preconditioner is not symmetric and can't be used with the CG solver for " + m_self.uri().path());
+
+    if(m_preconditioner == "Jacobi")
+      setup_jacobi();
+    else if(m_preconditioner == "BlockJacobi")
+      setup_block_jacobi();
+    else if(m_preconditioner == "ILU0")
+      setup_ilu0();
+  }
+
+  void setup_jacobi()
+  {
+    m_matrix->get_diagonal(m_inverse_diagonal);
+    const Uint size = m_inverse_diagonal.size();
+    for(Uint i = 0; i != size; ++i)
+      m_inverse_diagonal[i] = m_inverse_diagonal[i] == 0. ? 1. : 1. / m_inverse_diagonal[i];
+  }
+
+  void setup_block_jacobi()
+  {
+    const std::vector<bool>& owned = *m_owned;
+    const Uint nb_nodes = owned.size();
+    const Uint block_size = m_neq*m_neq;
+    m_inverse_diagonal.assign(nb_nodes*block_size, 0.);
+    RealMatrix diagonal_block(m_neq, m_neq);
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      if(!owned[i])
+        continue;
+      const Real* values = &m_matrix->values()[m_matrix->block_position(i, i)*block_size];
+      for(Uint a = 0; a != m_neq; ++a)
+        for(Uint b = 0; b != m_neq; ++b)
+          diagonal_block(a, b) = values[a*m_neq+b];
+
+      Eigen::FullPivLU<RealMatrix> lu(diagonal_block);
+      const RealMatrix inverse = lu.isInvertible() ? RealMatrix(lu.inverse()) : RealMatrix(RealMatrix::Identity(m_neq, m_neq));
+      for(Uint a = 0; a != m_neq; ++a)
+        for(Uint b = 0; b != m_neq; ++b)
+          m_inverse_diagonal[i*block_size + a*m_neq + b] = inverse(a, b);
+    }
+  }
+
+  /// Scalar ILU(0) factorization of the part of the matrix that couples the unknowns owned by this process
+  void setup_ilu0()
+  {
+    const std::vector<bool>& owned = *m_owned;
+    const std::vector<Uint>& row_starts = m_matrix->row_starts();
+    const std::vector<Uint>& block_columns = m_matrix->block_columns();
+    const std::vector<Real>& values = m_matrix->values();
+    const Uint nb_nodes = owned.size();
+    const Uint nb_rows = nb_nodes*m_neq;
+    const Uint block_size = m_neq*m_neq;
+
+    m_ilu_row_starts.assign(nb_rows+1, 0);
+    m_ilu_columns.clear();
+    m_ilu_values.clear();
+    m_ilu_diagonal.assign(nb_rows, 0);
+    for(Uint node = 0; node != nb_nodes; ++node)
+    {
+      for(Uint a = 0; a != m_neq; ++a)
+      {
+        const Uint row = node*m_neq + a;
+        if(owned[node])
+        {
+          for(Uint pos = row_starts[node]; pos != row_starts[node+1]; ++pos)
+          {
+            const Uint col_node = block_columns[pos];
+            if(!owned[col_node])
+              continue;
+            for(Uint b = 0; b != m_neq; ++b)
+            {
+              const Uint col = col_node*m_neq + b;
+              if(col == row)
+                m_ilu_diagonal[row] = m_ilu_columns.size();
+              m_ilu_columns.push_back(col);
+              m_ilu_values.push_back(values[pos*block_size + a*m_neq + b]);
+            }
+          }
+        }
+        m_ilu_row_starts[row+1] = m_ilu_columns.size();
+      }
+    }
+
+    // IKJ variant of the factorization, with the positions of the entries of row i in marker
+    std::vector<Uint> marker(nb_rows, NativeMatrix::invalid_position);
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      const Uint row_begin = m_ilu_row_starts[i];
+      const Uint row_end = m_ilu_row_starts[i+1];
+      if(row_begin == row_end)
+        continue;
+
+      for(Uint p = row_begin; p != row_end; ++p)
+        marker[m_ilu_columns[p]] = p;
+
+      for(Uint p = row_begin; p != row_end && m_ilu_columns[p] < i; ++p)
+      {
+        const Uint k = m_ilu_columns[p];
+        const Real l = m_ilu_values[p] / m_ilu_values[m_ilu_diagonal[k]];
+        m_ilu_values[p] = l;
+        for(Uint q = m_ilu_diagonal[k]+1; q != m_ilu_row_starts[k+1]; ++q)
+        {
+          const Uint pos = marker[m_ilu_columns[q]];
+          if(pos != NativeMatrix::invalid_position)
+            m_ilu_values[pos] -= l*m_ilu_values[q];
+        }
+      }
+
+      if(m_ilu_values[m_ilu_diagonal[i]] == 0.)
+        m_ilu_values[m_ilu_diagonal[i]] = 1.;
+
+      for(Uint p = row_begin; p != row_end; ++p)
+        marker[m_ilu_columns[p]] = NativeMatrix::invalid_position;
+    }
+  }
+
+  /// z = M^-1 r
+  void precondition(const VectorT& r, VectorT& z) const
+  {
+    const std::vector<bool>& owned = *m_owned;
+    const Uint nb_nodes = owned.size();
+    z.assign(r.size(), 0.);
+
+    if(m_preconditioner == "Jacobi")
+    {
+      for(Uint i = 0; i != nb_nodes; ++i)
+      {
+        if(!owned[i])
+          continue;
+        for(Uint j = i*m_neq; j != (i+1)*m_neq; ++j)
+          z[j] = m_inverse_diagonal[j]*r[j];
+      }
+    }
+    else if(m_preconditioner == "BlockJacobi")
+    {
+      const Uint block_size = m_neq*m_neq;
+      for(Uint i = 0; i != nb_nodes; ++i)
+      {
+        if(!owned[i])
+          continue;
+        const Real* inverse = &m_inverse_diagonal[i*block_size];
+        for(Uint a = 0; a != m_neq; ++a)
+          for(Uint b = 0; b != m_neq; ++b)
+            z[i*m_neq+a] += inverse[a*m_neq+b]*r[i*m_neq+b];
+      }
+    }
+    else if(m_preconditioner == "ILU0")
+    {
+      const Uint nb_rows = z.size();
+      for(Uint i = 0; i != nb_rows; ++i)
+      {
+        if(m_ilu_row_starts[i] == m_ilu_row_starts[i+1])
+          continue;
+        Real sum = r[i];
+        for(Uint p = m_ilu_row_starts[i]; p != m_ilu_diagonal[i]; ++p)
+          sum -= m_ilu_values[p]*z[m_ilu_columns[p]];
+        z[i] = sum;
+      }
+      for(Uint i = nb_rows; i != 0; --i)
+      {
+        const Uint row = i-1;
+        if(m_ilu_row_starts[row] == m_ilu_row_starts[row+1])
+          continue;
+        Real sum = z[row];
+        for(Uint p = m_ilu_diagonal[row]+1; p != m_ilu_row_starts[row+1]; ++p)
+          sum -= m_ilu_values[p]*z[m_ilu_columns[p]];
+        z[row] = sum / m_ilu_values[m_ilu_diagonal[row]];
+      }
+    }
+    else
+    {
+      for(Uint i = 0; i != nb_nodes; ++i)
+      {
+        if(!owned[i])
+          continue;
+        for(Uint j = i*m_neq; j != (i+1)*m_neq; ++j)
+          z[j] = r[j];
+      }
+    }
+  }
+
+  //@}
+
+  /// @name Solvers. Each returns the norm of the final residual
+  //@{
+
+  /// Preconditioned conjugate gradient
+  Real cg(const VectorT& b, VectorT& x, const Real target, Uint& iterations)
+  {
+    const Uint max_iterations = m_self.options().value<Uint>("max_iterations");
+    VectorT r, z, p, q;
+    residual(b, x, r);
+    precondition(r, z);
+    p = z;
+    Real rz = dot(r, z);
+    Real r_norm = norm(r);
+    for(iterations = 0; iterations != max_iterations && r_norm > target; ++iterations)
+    {
+      multiply(p, q);
+      const Real alpha = rz / dot(p, q);
+      axpy(alpha, p, x);
+      axpy(-alpha, q, r);
+      r_norm = norm(r);
+      precondition(r, z);
+      const Real rz_new = dot(r, z);
+      xpay(z, rz_new / rz, p);
+      rz = rz_new;
+    }
+    return r_norm;
+  }
+
+  /// Right-preconditioned BiCGStab
+  Real bicgstab(const VectorT& b, VectorT& x, const Real target, Uint& iterations)
+  {
+    const Uint max_iterations = m_self.options().value<Uint>("max_iterations");
+    VectorT r, r0, p(x.size(), 0.), v(x.size(), 0.), p_hat, s, s_hat, t;
+    residual(b, x, r);
+    r0 = r;
+    Real rho = 1., alpha = 1., omega = 1.;
+    Real r_norm = norm(r);
+    for(iterations = 0; iterations != max_iterations && r_norm > target; ++iterations)
+    {
+      const Real rho_new = dot(r0, r);
+      if(rho_new == 0.)
+      {
+        CFwarn << "Native BiCGStab solver broke down" << CFendl;
+        break;
+      }
+      const Real beta = (rho_new / rho) * (alpha / omega);
+      axpy(-omega, v, p);
+      xpay(r, beta, p);
+      precondition(p, p_hat);
+      multiply(p_hat, v);
+      alpha = rho_new / dot(r0, v);
+      s = r;
+      axpy(-alpha, v, s);
+      axpy(alpha, p_hat, x);
+      const Real s_norm = norm(s);
+      if(s_norm <= target)
+      {
+        r.swap(s);
+        r_norm = s_norm;
+        ++iterations;
+        break;
+      }
+      precondition(s, s_hat);
+      multiply(s_hat, t);
+      omega = dot(t, s) / dot(t, t);
+      axpy(omega, s_hat, x);
+      r.swap(s);
+      axpy(-omega, t, r);
+      r_norm = norm(r);
+      rho = rho_new;
+    }
+    return r_norm;
+  }
+
+  /// Right-preconditioned restarted GMRES, using modified Gram-Schmidt and Givens rotations
+  Real gmres(const VectorT& b, VectorT& x, const Real target, Uint& iterations)
+  {
+    const Uint max_iterations = m_self.options().value<Uint>("max_iterations");
+    const Uint restart = std::max(m_self.options().value<Uint>("gmres_restart"), 1u);
+    std::vector<VectorT> basis(restart+1);
+    RealMatrix hessenberg(restart+1, restart);
+    RealVector g(restart+1), cs(restart), sn(restart), y(restart);
+    VectorT z, w;
+
+    iterations = 0;
+    Real r_norm = 0.;
+    while(true)
+    {
+      residual(b, x, basis[0]);
+      r_norm = norm(basis[0]);
+      if(r_norm <= target || iterations == max_iterations)
+        break;
+
+      for(Uint i = 0; i != basis[0].size(); ++i)
+        basis[0][i] /= r_norm;
+      g.setZero();
+      g[0] = r_norm;
+      hessenberg.setZero();
+
+      Uint k = 0;
+      while(k != restart && iterations != max_iterations && r_norm > target)
+      {
+        precondition(basis[k], z);
+        multiply(z, w);
+        for(Uint i = 0; i <= k; ++i)
+        {
+          hessenberg(i, k) = dot(w, basis[i]);
+          axpy(-hessenberg(i, k), basis[i], w);
+        }
+        const Real w_norm = norm(w);
+        hessenberg(k+1, k) = w_norm;
+        if(w_norm != 0.)
+        {
+          for(Uint i = 0; i != w.size(); ++i)
+            w[i] /= w_norm;
+        }
+        basis[k+1].swap(w);
+
+        for(Uint i = 0; i != k; ++i)
+        {
+          const Real h_ik = hessenberg(i, k);
+          hessenberg(i, k) = cs[i]*h_ik + sn[i]*hessenberg(i+1, k);
+          hessenberg(i+1, k) = -sn[i]*h_ik + cs[i]*hessenberg(i+1, k);
+        }
+        const Real denominator = std::sqrt(hessenberg(k, k)*hessenberg(k, k) + w_norm*w_norm);
+        cs[k] = denominator == 0. ? 1. : hessenberg(k, k) / denominator;
+        sn[k] = denominator == 0. ? 0. : w_norm / denominator;
+        hessenberg(k, k) = cs[k]*hessenberg(k, k) + sn[k]*w_norm;
+        hessenberg(k+1, k) = 0.;
+        g[k+1] = -sn[k]*g[k];
+        g[k] = cs[k]*g[k];
+
+        r_norm = std::abs(g[k+1]);
+        ++k;
+        ++iterations;
+        if(w_norm == 0.)
+          break;
+      }
+
+      // Solve the upper triangular system and update the solution with the preconditioned basis combination
+      for(Uint i = k; i != 0; --i)
+      {
+        const Uint row = i-1;
+        Real sum = g[row];
+        for(Uint j = row+1; j != k; ++j)
+          sum -= hessenberg(row, j)*y[j];
+        y[row] = hessenberg(row, row) == 0. ? 0. : sum / hessenberg(row, row);
+      }
+      w.assign(x.size(), 0.);
+      for(Uint i = 0; i != k; ++i)
+        axpy(y[i], basis[i], w);
+      precondition(w, z);
+      axpy(1., z, x);
+    }
+    return r_norm;
+  }
+
+  //@}
+
+  common::Component& m_self;
+
+  Handle<NativeMatrix> m_matrix;
+  Handle<NativeVector> m_rhs;
+  Handle<NativeVector> m_solution;
+
+  /// Copy of the vector to multiply, for the ghost update
+  boost::shared_ptr<NativeVector> m_work;
+
+  Uint m_neq;
+  const std::vector<bool>* m_owned;
+
+  /// Preconditioner data
+  std::string m_preconditioner;
+  std::vector<Real> m_inverse_diagonal;
+  std::vector<Uint> m_ilu_row_starts;
+  std::vector<Uint> m_ilu_columns;
+  std::vector<Uint> m_ilu_diagonal;
+  std::vector<Real> m_ilu_values;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+NativeStrategy::NativeStrategy(const std::string& name) :
+  SolutionStrategy(name),
+  m_implementation(new Implementation(*this))
+{
+}
+
+NativeStrategy::~NativeStrategy()
+{
+}
+
+void NativeStrategy::set_matrix(const Handle< Matrix >& matrix)
+{
+  m_implementation->m_matrix = Handle<NativeMatrix>(matrix);
+}
+
+void NativeStrategy::set_rhs(const Handle< Vector >& rhs)
+{
+  m_implementation->m_rhs = Handle<NativeVector>(rhs);
+}
+
+void NativeStrategy::set_solution(const Handle< Vector >& solution)
+{
+  m_implementation->m_solution = Handle<NativeVector>(solution);
+}
+
+void NativeStrategy::solve()
+{
+  m_implementation->solve();
+}
+
+Real NativeStrategy::compute_residual()
+{
+  return m_implementation->compute_residual();
+}
+
+void NativeStrategy::set_coordinates(common::PE::CommPattern& cp, const common::Table< Real >& coords, const common::List< Uint >& used_nodes, const std::vector< bool >& periodic_links_active)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
@@ -0,0 +1,69 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_NativeStrategy_hpp
+#define cf3_Math_LSS_NativeStrategy_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/scoped_ptr.hpp>
+
+#include "math/LSS/SolutionStrategy.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file NativeStrategy.hpp Krylov solvers for the native matrix and vectors
+
+  Offers CG, BiCGStab and restarted GMRES, with Jacobi, block Jacobi or ILU(0) preconditioning.
+  In parallel, the ILU(0) factorization only uses the rows and columns owned by each process.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class LSS_API NativeStrategy : public SolutionStrategy
+{
+public:
+
+  /// Default constructor
+  NativeStrategy(const std::string& name);
+
+  ~NativeStrategy();
+
+  /// name of the type
+  static std::string type_name () { return "NativeStrategy"; }
+
+  void set_matrix(const Handle<LSS::Matrix>& matrix);
+  void set_rhs(const Handle<LSS::Vector>& rhs);
+  void set_solution(const Handle<LSS::Vector>& solution);
+  void solve();
+
+  /// Norm of b - A*x, over all processes
+  Real compute_residual();
+
+  /// Not used by the native preconditioners
+  void set_coordinates(common::PE::CommPattern& cp, const common::Table<Real>& coords, const common::List<Uint>& used_nodes, const std::vector<bool>& periodic_links_active);
+
+private:
+  /// Hide the solver internals
+  struct Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
+
+}; // end of class NativeStrategy
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_NativeStrategy_hpp
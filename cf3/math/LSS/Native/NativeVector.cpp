@@ -0,0 +1,423 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <fstream>
+#include <sstream>
+
+#include "common/Assertions.hpp"
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "math/VariablesDescriptor.hpp"
+
+#include "math/LSS/Native/NativeVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file NativeVector.cpp Implementation of LSS::Vector for the native linear solver
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::math;
+using namespace cf3::math::LSS;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < LSS::NativeVector, LSS::Vector, LSS::LibLSS > NativeVector_Builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void LSS::detail::create_native_node_map(common::PE::CommPattern& cp, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active, std::vector<Uint>& node_map, std::vector<bool>& owned)
+{
+  const Uint nb_nodes = cp.isUpdatable().size();
+  cf3_assert(periodic_links_active.empty() || periodic_links_active.size() == nb_nodes);
+  cf3_assert(periodic_links_nodes.size() == periodic_links_active.size());
+
+  node_map.resize(nb_nodes);
+  owned.resize(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    Uint final_linked_node = i;
+    if(!periodic_links_active.empty())
+    {
+      while(periodic_links_active[final_linked_node])
+        final_linked_node = periodic_links_nodes[final_linked_node];
+    }
+    node_map[i] = final_linked_node;
+    owned[i] = cp.isUpdatable()[i] && final_linked_node == i;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+NativeVector::NativeVector(const std::string& name) :
+  LSS::Vector(name),
+  m_neq(0),
+  m_is_created(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+NativeVector::~NativeVector()
+{
+  remove_from_comm_pattern();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::create(common::PE::CommPattern& cp, Uint neq, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  if (m_is_created) destroy();
+
+  detail::create_native_node_map(cp, periodic_links_nodes, periodic_links_active, m_node_map, m_owned);
+  const Uint nb_nodes = m_node_map.size();
+  m_neq = neq;
+  m_data.assign(nb_nodes*neq, 0.);
+
+  // The values are stored per node, so the ghosts are updated using the global node numbers
+  if(common::PE::Comm::instance().is_active())
+  {
+    m_gids.resize(nb_nodes);
+    if(nb_nodes != 0)
+      cp.gid()->pack(&m_gids[0]);
+    std::vector<Uint> ranks(nb_nodes);
+    for(Uint i = 0; i != nb_nodes; ++i)
+      ranks[i] = cp.rank(i);
+
+    m_comm_pattern = common::allocate_component<common::PE::CommPattern>("CommPattern");
+    m_comm_pattern->insert("gid", m_gids, 1, false);
+    m_comm_pattern->setup(Handle<common::PE::CommWrapper>(m_comm_pattern->get_child("gid")), ranks);
+    m_comm_pattern->insert(name(), m_data, m_neq, true);
+  }
+
+  m_is_created = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  create(cp, vars.size(), periodic_links_nodes, periodic_links_active);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::destroy()
+{
+  remove_from_comm_pattern();
+  m_comm_pattern.reset();
+  m_data.clear();
+  m_node_map.clear();
+  m_owned.clear();
+  m_neq = 0;
+  m_is_created = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::remove_from_comm_pattern()
+{
+  if(is_not_null(m_comm_pattern) && is_not_null(m_comm_pattern->get_child(name())))
+    m_comm_pattern->remove_component(name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::set_value(const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  m_data[index(irow / m_neq, irow % m_neq)] = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::add_value(const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  m_data[index(irow / m_neq, irow % m_neq)] += value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::get_value(const Uint irow, Real& value)
+{
+  cf3_assert(m_is_created);
+  value = m_data[index(irow / m_neq, irow % m_neq)];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::set_value(const Uint iblockrow, const Uint ieq, const Real value)
+{
+  cf3_assert(m_is_created);
+  m_data[index(iblockrow, ieq)] = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::add_value(const Uint iblockrow, const Uint ieq, const Real value)
+{
+  cf3_assert(m_is_created);
+  m_data[index(iblockrow, ieq)] += value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::get_value(const Uint iblockrow, const Uint ieq, Real& value)
+{
+  cf3_assert(m_is_created);
+  value = m_data[index(iblockrow, ieq)];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::set_rhs_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+    for(Uint j = 0; j != m_neq; ++j)
+      m_data[index(values.indices[i], j)] = values.rhs[i*m_neq+j];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::add_rhs_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+    for(Uint j = 0; j != m_neq; ++j)
+      m_data[index(values.indices[i], j)] += values.rhs[i*m_neq+j];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::get_rhs_values(BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+    for(Uint j = 0; j != m_neq; ++j)
+      values.rhs[i*m_neq+j] = m_data[index(values.indices[i], j)];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::set_sol_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+    for(Uint j = 0; j != m_neq; ++j)
+      m_data[index(values.indices[i], j)] = values.sol[i*m_neq+j];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::add_sol_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+    for(Uint j = 0; j != m_neq; ++j)
+      m_data[index(values.indices[i], j)] += values.sol[i*m_neq+j];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::get_sol_values(BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+    for(Uint j = 0; j != m_neq; ++j)
+      values.sol[i*m_neq+j] = m_data[index(values.indices[i], j)];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::reset(Real reset_to)
+{
+  cf3_assert(m_is_created);
+  m_data.assign(m_data.size(), reset_to);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::get( boost::multi_array<Real, 2>& data)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(data.shape()[0] == m_node_map.size());
+  cf3_assert(data.shape()[1] == m_neq);
+  const Uint nb_nodes = m_node_map.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+    for(Uint j = 0; j != m_neq; ++j)
+      data[i][j] = m_data[index(i, j)];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::set( boost::multi_array<Real, 2>& data)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(data.shape()[0] == m_node_map.size());
+  cf3_assert(data.shape()[1] == m_neq);
+  const Uint nb_nodes = m_node_map.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+    for(Uint j = 0; j != m_neq; ++j)
+      m_data[index(i, j)] = data[i][j];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::print(common::LogStream& stream)
+{
+  std::stringstream output;
+  print(output);
+  stream << output.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::print(std::ostream& stream)
+{
+  if (m_is_created)
+  {
+    const Uint nb_nodes = m_node_map.size();
+    for(Uint i = 0; i != nb_nodes; ++i)
+      for(Uint j = 0; j != m_neq; ++j)
+        stream << 0 << " " << -static_cast<int>(i*m_neq+j) << " " << m_data[index(i, j)] << "\n";
+    stream << "# name:                 " << name() << "\n";
+    stream << "# type_name:            " << type_name() << "\n";
+    stream << "# process:              " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:  " << m_neq << "\n";
+    stream << "# number of rows:       " << nb_nodes*m_neq << "\n";
+    stream << "# number of block rows: " << nb_nodes << "\n" << std::flush;
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::print(const std::string& filename, std::ios_base::openmode mode)
+{
+  std::ofstream stream(filename.c_str(),mode);
+  stream << "VARIABLES=COL,ROW,VAL\n" << std::flush;
+  stream << "ZONE T=\"" << type_name() << "::" << name() <<  "\"\n" << std::flush;
+  print(stream);
+  stream.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::print_native(std::ostream& stream)
+{
+  const Uint nb_nodes = m_node_map.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    stream << i << (m_owned[i] ? " owned" : (m_node_map[i] != i ? " periodic" : " ghost")) << ":";
+    for(Uint j = 0; j != m_neq; ++j)
+      stream << " " << m_data[i*m_neq+j];
+    stream << "\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::clone_to(Vector& other)
+{
+  if(!m_is_created)
+    throw common::SetupError(FromHere(), "Vector to clone " + uri().string() + " is not created");
+
+  NativeVector* other_ptr = dynamic_cast<NativeVector*>(&other);
+  if(is_null(other_ptr))
+    throw common::SetupError(FromHere(), "clone_to method of NativeVector needs another NativeVector, but a " + other.derived_type_name() + " was supplied instead.");
+
+  other_ptr->destroy();
+  other_ptr->m_neq = m_neq;
+  other_ptr->m_data = m_data;
+  other_ptr->m_node_map = m_node_map;
+  other_ptr->m_owned = m_owned;
+  other_ptr->m_comm_pattern = m_comm_pattern;
+  if(is_not_null(m_comm_pattern))
+    m_comm_pattern->insert(other_ptr->name(), other_ptr->m_data, m_neq, true);
+  other_ptr->m_is_created = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::assign(const Vector& source)
+{
+  NativeVector const* source_ptr = dynamic_cast<NativeVector const*>(&source);
+  if(is_null(source_ptr))
+    throw common::SetupError(FromHere(), "assign method of NativeVector needs another NativeVector, but a " + source.derived_type_name() + " was supplied instead.");
+  if(source_ptr->m_data.size() != m_data.size())
+    throw common::SetupError(FromHere(), "assign method of NativeVector got a vector with incorrect size");
+
+  m_data.assign(source_ptr->m_data.begin(), source_ptr->m_data.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::update(const Vector& source, const Real alpha)
+{
+  NativeVector const* source_ptr = dynamic_cast<NativeVector const*>(&source);
+  if(is_null(source_ptr))
+    throw common::SetupError(FromHere(), "update method of NativeVector needs another NativeVector, but a " + source.derived_type_name() + " was supplied instead.");
+  if(source_ptr->m_data.size() != m_data.size())
+    throw common::SetupError(FromHere(), "update method of NativeVector got a vector with incorrect size");
+
+  const Uint size = m_data.size();
+  for(Uint i = 0; i != size; ++i)
+    m_data[i] += alpha*source_ptr->m_data[i];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::scale(const Real alpha)
+{
+  const Uint size = m_data.size();
+  for(Uint i = 0; i != size; ++i)
+    m_data[i] *= alpha;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::sync()
+{
+  if(is_not_null(m_comm_pattern))
+    m_comm_pattern->synchronize(name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::read_native(const common::URI& filename, const std::string type)
+{
+  throw common::NotSupported(FromHere(), "NativeVector can't read vectors from file");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::debug_data(std::vector<Real>& values)
+{
+  cf3_assert(m_is_created);
+  values.clear();
+  const Uint nb_nodes = m_node_map.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+    for(Uint j = 0; j != m_neq; ++j)
+      values.push_back(m_data[index(i, j)]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
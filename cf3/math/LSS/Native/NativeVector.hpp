@@ -0,0 +1,234 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_NativeVector_hpp
+#define cf3_Math_LSS_NativeVector_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "math/LSS/LibLSS.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "math/LSS/Vector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file NativeVector.hpp Vector of the native linear solver, which does not need Trilinos
+
+  Values are stored per node in the process-local numbering of the CommPattern, including the ghost nodes.
+  Periodic nodes are mapped onto the node they are linked to, so they share their values.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+namespace detail
+{
+  /// Compute the node that holds the values for each node, following the periodic links, and the nodes that have a row in the
+  /// matrix on this process, i.e. the updatable nodes that are not periodic.
+  LSS_API void create_native_node_map(common::PE::CommPattern& cp, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active, std::vector<Uint>& node_map, std::vector<bool>& owned);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class LSS_API NativeVector : public LSS::Vector {
+public:
+
+  /// @name CREATION, DESTRUCTION AND COMPONENT SYSTEM
+  //@{
+
+  /// name of the type
+  static std::string type_name () { return "NativeVector"; }
+
+  /// Accessor to solver type
+  const std::string solvertype() { return "Native"; }
+
+  /// Default constructor
+  NativeVector(const std::string& name);
+
+  ~NativeVector();
+
+  /// Setup sparsity structure
+  void create(common::PE::CommPattern& cp, Uint neq, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// The native solver does not depend on the ordering of the unknowns, so this is the same as create with vars.size() equations
+  void create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// Deallocate underlying data
+  void destroy();
+
+  //@} END CREATION, DESTRUCTION AND COMPONENT SYSTEM
+
+  /// @name INDIVIDUAL ACCESS
+  //@{
+
+  /// Set value at given location in the matrix
+  void set_value(const Uint irow, const Real value);
+
+  /// Add value at given location in the matrix
+  void add_value(const Uint irow, const Real value);
+
+  /// Get value at given location in the matrix
+  void get_value(const Uint irow, Real& value);
+
+  /// Set value at given location in the matrix
+  void set_value(const Uint iblockrow, const Uint ieq, const Real value);
+
+  /// Add value at given location in the matrix
+  void add_value(const Uint iblockrow, const Uint ieq, const Real value);
+
+  /// Get value at given location in the matrix
+  void get_value(const Uint iblockrow, const Uint ieq, Real& value);
+
+  //@} END INDIVIDUAL ACCESS
+
+  /// @name EFFICCIENT ACCESS
+  //@{
+
+  /// Set a list of values to rhs
+  void set_rhs_values(const BlockAccumulator& values);
+
+  /// Add a list of values to rhs
+  void add_rhs_values(const BlockAccumulator& values);
+
+  /// Get a list of values from rhs
+  void get_rhs_values(BlockAccumulator& values);
+
+  /// Set a list of values to sol
+  void set_sol_values(const BlockAccumulator& values);
+
+  /// Add a list of values to sol
+  void add_sol_values(const BlockAccumulator& values);
+
+  /// Get a list of values from sol
+  void get_sol_values(BlockAccumulator& values);
+
+  /// Reset Vector
+  void reset(Real reset_to=0.);
+
+  /// Copies the contents out of the LSS::Vector to table.
+  void get( boost::multi_array<Real, 2>& data);
+
+  /// Copies the contents of the table into the LSS::Vector.
+  void set( boost::multi_array<Real, 2>& data);
+
+  //@} END EFFICCIENT ACCESS
+
+  /// @name MISCELLANEOUS
+  //@{
+
+  /// Print to wherever
+  void print(common::LogStream& stream);
+
+  /// Print to wherever
+  void print(std::ostream& stream);
+
+  /// Prints the raw values, including the ghost and periodic nodes
+  void print_native(std::ostream& stream);
+
+  /// Print to file given by filename
+  void print(const std::string& filename, std::ios_base::openmode mode = std::ios_base::out );
+
+  /// Accessor to the state of create
+  const bool is_created() { return m_is_created; }
+
+  /// Accessor to the number of equations
+  const Uint neq() { return m_neq; }
+
+  /// Accessor to the number of block rows
+  const Uint blockrow_size() { return m_node_map.size(); }
+
+  /// Clone this vector into another one
+  void clone_to(Vector& other);
+
+  /// Assign from another vector
+  void assign(const Vector& source);
+
+  /// Update this vector with a scalar multiplication of the target vector; i.e.:
+  /// this += alpha*source
+  void update(const Vector& source, const Real alpha = 1.);
+
+  /// Scale the vector in-place with the given scalar
+  /// this *= alpha
+  void scale(const Real alpha);
+
+  /// Update the ghost nodes with the values of their owners
+  void sync();
+
+  /// Not supported
+  void read_native(const common::URI& filename, const std::string type = "");
+
+  //@} END MISCELLANEOUS
+
+  /// @name TEST ONLY
+  //@{
+
+  /// exports the vector into big linear array
+  /// @attention only for debug and utest purposes
+  void debug_data(std::vector<Real>& values);
+
+  //@} END TEST ONLY
+
+  /// @name NATIVE ACCESS
+  //@{
+
+  /// Raw values, with neq() entries for each local node
+  std::vector<Real>& data() { return m_data; }
+  const std::vector<Real>& data() const { return m_data; }
+
+  /// Node that holds the values of each node
+  const std::vector<Uint>& node_map() const { return m_node_map; }
+
+  /// True for the nodes that are owned by this process and not periodic
+  const std::vector<bool>& owned() const { return m_owned; }
+
+  //@} END NATIVE ACCESS
+
+private:
+
+  /// Index in m_data of the given equation of the given node
+  Uint index(const Uint iblockrow, const Uint ieq) const
+  {
+    cf3_assert(iblockrow < m_node_map.size());
+    cf3_assert(ieq < m_neq);
+    return m_node_map[iblockrow]*m_neq + ieq;
+  }
+
+  /// Remove the data from the CommPattern
+  void remove_from_comm_pattern();
+
+  /// Number of equations per node
+  Uint m_neq;
+
+  /// State of creation
+  bool m_is_created;
+
+  /// The values
+  std::vector<Real> m_data;
+
+  /// Node holding the values, for each node
+  std::vector<Uint> m_node_map;
+
+  /// Nodes owned by this process, excluding periodic nodes
+  std::vector<bool> m_owned;
+
+  /// Global node numbers, used to set up the CommPattern
+  std::vector<Uint> m_gids;
+
+  /// Synchronizes the ghost nodes, shared with the clones. Null when running serially.
+  boost::shared_ptr<common::PE::CommPattern> m_comm_pattern;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_NativeVector_hpp
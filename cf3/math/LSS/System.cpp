@@ -16,6 +16,7 @@
 #include "common/OptionT.hpp"
 #include "common/PE/CommPattern.hpp"
 #include "common/Signal.hpp"
+#include "common/Trace.hpp"
 
 #include "common/XML/Protocol.hpp"
 #include "common/XML/SignalOptions.hpp"
@@ -202,6 +203,7 @@ void LSS::System::destroy()
 void LSS::System::solve()
 {
   cf3_assert(is_created());
+  common::TraceRegion trace("LSS::System::solve", "lss");
   m_solution_strategy->solve();
 }
 
@@ -25,6 +25,12 @@ public:
   
   /// Writable access to the matrix
   virtual Teuchos::RCP<Thyra::LinearOpBase<Real> > thyra_operator() = 0;
+
+  /// Operator to build the preconditioner from, if it differs from the matrix. Null by default.
+  virtual Teuchos::RCP<const Thyra::LinearOpBase<Real> > thyra_preconditioner_operator() const
+  {
+    return Teuchos::null;
+  }
 };
 
 } // namespace LSS
@@ -6,10 +6,12 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 
 #include <boost/pointer_cast.hpp>
+#include <boost/thread/tss.hpp>
 
 #include "Teuchos_ConfigDefs.hpp"
 #include "Teuchos_RCP.hpp"
@@ -62,6 +64,8 @@ using namespace cf3::math::LSS;
 
 common::ComponentBuilder < LSS::TrilinosCrsMatrix, LSS::Matrix, LSS::LibLSS > TrilinosCrsMatrix_Builder;
 
+////////////////////////////////////////////////////////////////////////////////////////////
+
 TrilinosCrsMatrix::TrilinosCrsMatrix(const std::string& name) :
   LSS::Matrix(name),
   m_mat(0),
@@ -231,20 +235,29 @@ void TrilinosCrsMatrix::add_values(const BlockAccumulator& values)
   const Uint nb_nodes = values.indices.size();
   const int num_entries = nb_nodes*m_neq;
   cf3_assert(values.mat.rows() == num_entries);
+
+  // Threaded element loops call this concurrently for blocks that don't share rows, so the index buffer is per thread
+  static boost::thread_specific_ptr< std::vector<int> > thread_converted_indices;
+  if(thread_converted_indices.get() == nullptr)
+    thread_converted_indices.reset(new std::vector<int>());
+  std::vector<int>& converted_indices = *thread_converted_indices;
+  if(converted_indices.size() < static_cast<std::size_t>(num_entries))
+    converted_indices.resize(num_entries);
+
   // Convert the index vector
   for(Uint i = 0; i != nb_nodes; ++i)
   {
     const Uint local_start_idx = values.indices[i]*m_neq;
     for(int j = 0; j != m_neq; ++j)
-      m_converted_indices[i*m_neq+j] = m_p2m[local_start_idx+j];
+      converted_indices[i*m_neq+j] = m_p2m[local_start_idx+j];
   }
   // insert the values
   for(Uint i = 0; i != nb_nodes; ++i)
   {
     for(int j = 0; j != m_neq; ++j)
     {
-      if(m_converted_indices[i*m_neq+j] < m_num_my_elements)
-        TRILINOS_THROW(m_mat->SumIntoMyValues(m_converted_indices[i*m_neq+j], num_entries, values.mat.data()+(num_entries*(i*m_neq+j)),&m_converted_indices[0]));
+      if(converted_indices[i*m_neq+j] < m_num_my_elements)
+        TRILINOS_THROW(m_mat->SumIntoMyValues(converted_indices[i*m_neq+j], num_entries, values.mat.data()+(num_entries*(i*m_neq+j)),&converted_indices[0]));
     }
   }
 }
@@ -292,6 +305,96 @@ void TrilinosCrsMatrix::get_values(BlockAccumulator& values)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+boost::shared_ptr<BlockBatch> TrilinosCrsMatrix::create_batch(const Uint block_nb_nodes, const std::vector<Uint>& node_indices)
+{
+  cf3_assert(m_is_created);
+  if(block_nb_nodes == 0 || node_indices.size() % block_nb_nodes != 0)
+    throw common::BadValue(FromHere(), "Number of node indices for a batch is not a multiple of the block size");
+
+  int* index_offsets;
+  int* indices;
+  double* crs_values;
+  TRILINOS_THROW(m_mat->ExtractCrsDataPointers(index_offsets, indices, crs_values));
+
+  // The CRS value array stays in place until the matrix is created again, so the batch can point into it directly
+  boost::shared_ptr<BlockBatch> result(new BlockBatch());
+  result->block_nb_nodes = block_nb_nodes;
+  result->node_indices = node_indices;
+  result->values = crs_values;
+
+  const Uint block_size = block_nb_nodes*m_neq;
+  const Uint nb_blocks = result->nb_blocks();
+  result->offsets.resize(nb_blocks*block_size*block_size);
+  std::vector<int> converted_indices(block_size);
+  std::vector<int>::iterator offsets = result->offsets.begin();
+  for(Uint block = 0; block != nb_blocks; ++block)
+  {
+    for(Uint i = 0; i != block_nb_nodes; ++i)
+    {
+      const Uint local_start_idx = node_indices[block*block_nb_nodes + i]*m_neq;
+      for(Uint j = 0; j != m_neq; ++j)
+        converted_indices[i*m_neq+j] = m_p2m[local_start_idx+j];
+    }
+
+    for(Uint row = 0; row != block_size; ++row, offsets += block_size)
+    {
+      const int local_row = converted_indices[row];
+      if(local_row >= m_num_my_elements)
+      {
+        std::fill(offsets, offsets + block_size, -1);
+        continue;
+      }
+
+      // Column indices are sorted within each row after FillComplete
+      const int* row_begin = indices + index_offsets[local_row];
+      const int* row_end = indices + index_offsets[local_row+1];
+      for(Uint col = 0; col != block_size; ++col)
+      {
+        const int* position = std::lower_bound(row_begin, row_end, converted_indices[col]);
+        if(position == row_end || *position != converted_indices[col])
+          throw common::BadValue(FromHere(),"Trying to access an illegal entry.");
+        offsets[col] = position - indices;
+      }
+    }
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosCrsMatrix::add_values_batch(const BlockBatch& batch, const Uint begin_block, const Uint end_block, const Real* values)
+{
+  cf3_assert(m_is_created);
+  if(batch.values == nullptr)
+  {
+    Matrix::add_values_batch(batch, begin_block, end_block, values);
+    return;
+  }
+
+  int* index_offsets;
+  int* indices;
+  double* crs_values;
+  TRILINOS_THROW(m_mat->ExtractCrsDataPointers(index_offsets, indices, crs_values));
+  if(crs_values != batch.values)
+    throw common::SetupError(FromHere(), "Batch used with " + uri().string() + " was not created by it, or the matrix was created again");
+
+  cf3_assert(end_block <= batch.nb_blocks());
+  const Uint block_size = batch.block_nb_nodes*m_neq;
+  const Uint nb_entries = (end_block - begin_block)*block_size*block_size;
+  if(nb_entries == 0)
+    return;
+
+  const int* offsets = &batch.offsets[begin_block*block_size*block_size];
+  for(Uint i = 0; i != nb_entries; ++i)
+  {
+    if(offsets[i] >= 0)
+      crs_values[offsets[i]] += values[i];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void TrilinosCrsMatrix::set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval)
 {
   cf3_assert(m_is_created);
@@ -92,6 +92,12 @@ public:
   /// Add a list of values
   void get_values(BlockAccumulator& values);
 
+  /// Precompute the offset of each element block entry in the CRS value array, stored in BlockBatch::offsets
+  boost::shared_ptr<BlockBatch> create_batch(const Uint block_nb_nodes, const std::vector<Uint>& node_indices);
+
+  /// Add the values directly at the precomputed offsets, without index conversion or column search
+  void add_values_batch(const BlockBatch& batch, const Uint begin_block, const Uint end_block, const Real* values);
+
   /// Set a row, diagonal and off-diagonals values separately (dirichlet-type boundaries)
   void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval);
 
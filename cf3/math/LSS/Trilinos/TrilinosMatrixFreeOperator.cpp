@@ -0,0 +1,649 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <fstream>
+
+#include <boost/bind.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "Thyra_EpetraLinearOp.hpp"
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/OptionT.hpp"
+#include "common/OptionComponent.hpp"
+#include "common/PropertyList.hpp"
+#include "common/Tags.hpp"
+#include "common/Timer.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+
+#include "math/VariablesDescriptor.hpp"
+
+#include "math/LSS/Trilinos/TrilinosDetail.hpp"
+#include "math/LSS/Trilinos/TrilinosMatrixFreeOperator.hpp"
+#include "math/LSS/Trilinos/TrilinosVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::math;
+using namespace cf3::math::LSS;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < LSS::TrilinosMatrixFreeOperator, LSS::Matrix, LSS::LibLSS > TrilinosMatrixFreeOperator_Builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Presents the matrix-free operator to Trilinos
+class TrilinosMatrixFreeOperator::EpetraOperator : public Epetra_Operator
+{
+public:
+  EpetraOperator(TrilinosMatrixFreeOperator& self) : m_self(self)
+  {
+  }
+
+  virtual int SetUseTranspose(bool UseTranspose)
+  {
+    return -1;
+  }
+
+  virtual int Apply(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const
+  {
+    m_self.apply_epetra(X, Y);
+    return 0;
+  }
+
+  virtual int ApplyInverse(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const
+  {
+    return -1;
+  }
+
+  virtual double NormInf() const
+  {
+    return 0.;
+  }
+
+  virtual const char* Label() const
+  {
+    return "cf3 matrix-free operator";
+  }
+
+  virtual bool UseTranspose() const
+  {
+    return false;
+  }
+
+  virtual bool HasNormInf() const
+  {
+    return false;
+  }
+
+  virtual const Epetra_Comm& Comm() const
+  {
+    return m_self.m_comm;
+  }
+
+  virtual const Epetra_Map& OperatorDomainMap() const
+  {
+    return *m_self.m_row_map;
+  }
+
+  virtual const Epetra_Map& OperatorRangeMap() const
+  {
+    return *m_self.m_row_map;
+  }
+
+private:
+  TrilinosMatrixFreeOperator& m_self;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+TrilinosMatrixFreeOperator::TrilinosMatrixFreeOperator(const std::string& name) :
+  LSS::Matrix(name),
+  m_comm(common::PE::Comm::instance().communicator()),
+  m_is_created(false),
+  m_neq(0),
+  m_num_my_elements(0),
+  m_y(nullptr),
+  m_applying(false),
+  m_diagonal_preconditioner(true),
+  m_nb_applications(0),
+  m_application_time(0.)
+{
+  properties().add("vector_type", std::string("cf3.math.LSS.TrilinosVector"));
+
+  options().add("operator_action", m_operator_action)
+    .pretty_name("Operator Action")
+    .description("Action that adds the element matrices to this matrix, executed each time the operator is applied")
+    .link_to(&m_operator_action)
+    .mark_basic();
+
+  options().add("preconditioner_matrix_builder", std::string())
+    .pretty_name("Preconditioner Matrix Builder")
+    .description("Builder for the assembled matrix used to build the preconditioner, e.g. cf3.math.LSS.TrilinosCrsMatrix. Leave empty for no preconditioner.")
+    .attach_trigger(boost::bind(&TrilinosMatrixFreeOperator::trigger_preconditioner, this))
+    .mark_basic();
+
+  std::vector<boost::any> sparsity_list;
+  sparsity_list.push_back(std::string("Diagonal"));
+  sparsity_list.push_back(std::string("Full"));
+  options().add("preconditioner_sparsity", std::string("Diagonal"))
+    .pretty_name("Preconditioner Sparsity")
+    .description("Keep only the diagonal block of each node (Diagonal) or the complete element matrices (Full) in the preconditioner matrix")
+    .attach_trigger(boost::bind(&TrilinosMatrixFreeOperator::trigger_preconditioner, this))
+    .restricted_list() = sparsity_list;
+
+  properties().add("nb_applications", 0u);
+  properties().add("application_time", 0.);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+TrilinosMatrixFreeOperator::~TrilinosMatrixFreeOperator()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  // Kept as child, since the preconditioner may be rebuilt later on
+  if(is_not_null(get_child("SingleVariableDescriptor")))
+    remove_component("SingleVariableDescriptor");
+  Handle<VariablesDescriptor> single_var_descriptor = create_component<VariablesDescriptor>("SingleVariableDescriptor");
+  single_var_descriptor->options().set(common::Tags::dimension(), neq);
+  single_var_descriptor->push_back("LSSvars", VariablesDescriptor::Dimensionalities::VECTOR);
+  create_blocked(cp, *single_var_descriptor, node_connectivity, starting_indices, solution, rhs, periodic_links_nodes, periodic_links_active);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, Vector& solution, Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  if(m_is_created)
+    destroy();
+
+  if(is_null(dynamic_cast<TrilinosVector*>(&rhs)))
+    throw common::SetupError(FromHere(), "TrilinosMatrixFreeOperator needs a TrilinosVector as RHS, but a " + rhs.derived_type_name() + " was supplied instead.");
+
+  std::vector<int> my_global_elements;
+  std::vector<Uint> my_ranks;
+  create_map_data(cp, vars, m_p2m, my_global_elements, my_ranks, m_num_my_elements, periodic_links_nodes, periodic_links_active);
+
+  // rowmap, ghosts not present
+  m_row_map = Teuchos::rcp(new Epetra_Map(-1, m_num_my_elements, &my_global_elements[0], 0, m_comm));
+
+  // colmap, has ghosts at the end
+  m_col_map = Teuchos::rcp(new Epetra_Map(-1, my_global_elements.size(), &my_global_elements[0], 0, m_comm));
+  m_importer = Teuchos::rcp(new Epetra_Import(*m_col_map, *m_row_map));
+  m_x_col = Teuchos::rcp(new Epetra_Vector(*m_col_map));
+
+  m_rhs = rhs.handle<Vector>();
+  m_rhs_backup = create_component<TrilinosVector>("RHSBackup");
+  rhs.clone_to(*m_rhs_backup);
+
+  m_comm_pattern = cp.handle<common::PE::CommPattern>();
+  m_variables = vars.handle<VariablesDescriptor>();
+  m_solution = solution.handle<Vector>();
+  m_node_connectivity = node_connectivity;
+  m_starting_indices = starting_indices;
+  m_periodic_links_nodes = periodic_links_nodes;
+  m_periodic_links_active = periodic_links_active;
+
+  m_epetra_operator = Teuchos::rcp(new EpetraOperator(*this));
+
+  m_neq = vars.size();
+  m_is_created = true;
+  m_nb_applications = 0;
+  m_application_time = 0.;
+  properties()["nb_applications"] = m_nb_applications;
+  properties()["application_time"] = m_application_time;
+
+  trigger_preconditioner();
+
+  CFdebug << "Rank " << common::PE::Comm::instance().rank() << ": Created a matrix-free operator with " << m_num_my_elements << " local rows" << CFendl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::trigger_preconditioner()
+{
+  if(is_not_null(m_preconditioner))
+  {
+    remove_component(m_preconditioner->name());
+    m_preconditioner = Handle<LSS::Matrix>();
+  }
+
+  m_diagonal_preconditioner = options().value<std::string>("preconditioner_sparsity") == "Diagonal";
+
+  const std::string builder_name = options().value<std::string>("preconditioner_matrix_builder");
+  if(!m_is_created || builder_name.empty())
+    return;
+
+  m_preconditioner = create_component<LSS::Matrix>("PreconditionerMatrix", builder_name);
+  if(m_preconditioner->solvertype() != "Trilinos" || is_null(dynamic_cast<ThyraOperator*>(m_preconditioner.get())))
+    throw common::SetupError(FromHere(), "Preconditioner matrix " + builder_name + " for " + uri().string() + " is not a Trilinos matrix");
+
+  if(m_diagonal_preconditioner)
+  {
+    // Each node is only connected to itself
+    const Uint nb_nodes = m_starting_indices.size() - 1;
+    std::vector<Uint> node_connectivity(nb_nodes);
+    std::vector<Uint> starting_indices(nb_nodes+1);
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      node_connectivity[i] = i;
+      starting_indices[i] = i;
+    }
+    starting_indices[nb_nodes] = nb_nodes;
+    m_preconditioner->create_blocked(*m_comm_pattern, *m_variables, node_connectivity, starting_indices, *m_solution, *m_rhs, m_periodic_links_nodes, m_periodic_links_active);
+  }
+  else
+  {
+    m_preconditioner->create_blocked(*m_comm_pattern, *m_variables, m_node_connectivity, m_starting_indices, *m_solution, *m_rhs, m_periodic_links_nodes, m_periodic_links_active);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::destroy()
+{
+  if(is_not_null(m_preconditioner))
+  {
+    remove_component(m_preconditioner->name());
+    m_preconditioner = Handle<LSS::Matrix>();
+  }
+  if(is_not_null(m_rhs_backup))
+  {
+    remove_component(m_rhs_backup->name());
+    m_rhs_backup = Handle<Vector>();
+  }
+  m_epetra_operator.reset();
+  m_x_col.reset();
+  m_importer.reset();
+  m_col_map.reset();
+  m_row_map.reset();
+  m_p2m.clear();
+  m_replaced_rows.clear();
+  m_added_diagonal.clear();
+  m_node_connectivity.clear();
+  m_starting_indices.clear();
+  m_neq = 0;
+  m_num_my_elements = 0;
+  m_is_created = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::set_value(const Uint icol, const Uint irow, const Real value)
+{
+  throw common::NotSupported(FromHere(), "set_value is not supported for a matrix-free operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::add_value(const Uint icol, const Uint irow, const Real value)
+{
+  throw common::NotSupported(FromHere(), "add_value is not supported for a matrix-free operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::get_value(const Uint icol, const Uint irow, Real& value)
+{
+  throw common::NotSupported(FromHere(), "get_value is not supported for a matrix-free operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::set_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  if(m_applying)
+    throw common::NotSupported(FromHere(), "set_values is not supported during the application of a matrix-free operator, the operator action must add its values");
+
+  add_to_preconditioner(values, false);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::add_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  if(!m_applying)
+  {
+    add_to_preconditioner(values, true);
+    return;
+  }
+
+  const Uint nb_nodes = values.indices.size();
+  const Uint num_entries = nb_nodes*m_neq;
+  cf3_assert(values.mat.rows() == num_entries);
+
+  // Threaded element loops call this concurrently for blocks that don't share rows, so the gathered values are per thread
+  static boost::thread_specific_ptr< std::vector<int> > thread_converted_indices;
+  static boost::thread_specific_ptr< RealVector > thread_x;
+  if(thread_converted_indices.get() == nullptr)
+  {
+    thread_converted_indices.reset(new std::vector<int>());
+    thread_x.reset(new RealVector());
+  }
+  std::vector<int>& converted_indices = *thread_converted_indices;
+  RealVector& x = *thread_x;
+  if(converted_indices.size() < num_entries)
+  {
+    converted_indices.resize(num_entries);
+    x.resize(num_entries);
+  }
+
+  const double* x_col = m_x_col->Values();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint local_start_idx = values.indices[i]*m_neq;
+    for(Uint j = 0; j != m_neq; ++j)
+    {
+      const int idx = m_p2m[local_start_idx+j];
+      converted_indices[i*m_neq+j] = idx;
+      x[i*m_neq+j] = x_col[idx];
+    }
+  }
+
+  for(Uint row = 0; row != num_entries; ++row)
+  {
+    if(converted_indices[row] >= m_num_my_elements)
+      continue;
+    m_y[converted_indices[row]] += values.mat.row(row).dot(x.head(num_entries));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::add_to_preconditioner(const BlockAccumulator& values, const bool add)
+{
+  if(is_null(m_preconditioner))
+    return;
+
+  if(!m_diagonal_preconditioner)
+  {
+    if(add)
+      m_preconditioner->add_values(values);
+    else
+      m_preconditioner->set_values(values);
+    return;
+  }
+
+  // Per-thread accumulator for a single node
+  static boost::thread_specific_ptr<BlockAccumulator> thread_node_block;
+  if(thread_node_block.get() == nullptr)
+    thread_node_block.reset(new BlockAccumulator());
+  BlockAccumulator& node_block = *thread_node_block;
+  if(node_block.indices.size() != 1 || node_block.mat.rows() != m_neq)
+    node_block.resize(1, m_neq);
+
+  const Uint nb_nodes = values.indices.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    node_block.indices[0] = values.indices[i];
+    node_block.mat = values.mat.block(i*m_neq, i*m_neq, m_neq, m_neq);
+    if(add)
+      m_preconditioner->add_values(node_block);
+    else
+      m_preconditioner->set_values(node_block);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::get_values(BlockAccumulator& values)
+{
+  throw common::NotSupported(FromHere(), "get_values is not supported for a matrix-free operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval)
+{
+  cf3_assert(m_is_created);
+  if(m_applying)
+    return;
+
+  if(offdiagval != 0.)
+    throw common::NotSupported(FromHere(), "set_row with a non-zero off-diagonal value is not supported for a matrix-free operator");
+
+  const int row = m_p2m[iblockrow*m_neq+ieq];
+  if(row < m_num_my_elements)
+    m_replaced_rows[row] = diagval;
+
+  if(is_not_null(m_preconditioner))
+    m_preconditioner->set_row(iblockrow, ieq, diagval, offdiagval);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values)
+{
+  throw common::NotSupported(FromHere(), "get_column_and_replace_to_zero is not supported for a matrix-free operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs)
+{
+  cf3_assert(m_is_created);
+  if(m_applying)
+    return;
+
+  // Eliminating the column requires the matrix values, so only the row is replaced
+  set_row(blockrow, ieq, 1., 0.);
+  rhs.set_value(blockrow, ieq, value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from)
+{
+  throw common::NotSupported(FromHere(), "tie_blockrow_pairs is not supported for a matrix-free operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::set_diagonal(const std::vector<Real>& diag)
+{
+  throw common::NotSupported(FromHere(), "set_diagonal is not supported for a matrix-free operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::add_diagonal(const std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(diag.size() == m_p2m.size());
+  if(m_applying)
+    return;
+
+  if(m_added_diagonal.empty())
+    m_added_diagonal.assign(m_num_my_elements, 0.);
+
+  const Uint nb_entries = m_p2m.size();
+  for(Uint i = 0; i != nb_entries; ++i)
+  {
+    if(m_p2m[i] < m_num_my_elements)
+      m_added_diagonal[m_p2m[i]] += diag[i];
+  }
+
+  if(is_not_null(m_preconditioner))
+    m_preconditioner->add_diagonal(diag);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::get_diagonal(std::vector<Real>& diag)
+{
+  throw common::NotSupported(FromHere(), "get_diagonal is not supported for a matrix-free operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::reset(Real reset_to)
+{
+  cf3_assert(m_is_created);
+  if(m_applying)
+    return;
+
+  if(reset_to != 0.)
+    throw common::NotSupported(FromHere(), "A matrix-free operator can only be reset to zero");
+
+  m_replaced_rows.clear();
+  m_added_diagonal.clear();
+
+  if(is_not_null(m_preconditioner))
+    m_preconditioner->reset(reset_to);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::apply_epetra(const Epetra_MultiVector& X, Epetra_MultiVector& Y)
+{
+  cf3_assert(m_is_created);
+  if(is_null(m_operator_action))
+    throw common::SetupError(FromHere(), "Option operator_action is not set for matrix-free operator " + uri().string());
+
+  // The operator action is timed as part of the application, so its own timer includes these executions
+  common::Timer timer;
+  const int nb_vectors = X.NumVectors();
+  for(int v = 0; v != nb_vectors; ++v)
+  {
+    const Epetra_Vector& x = *X(v);
+    Epetra_Vector& y = *Y(v);
+
+    TRILINOS_THROW(m_x_col->Import(x, *m_importer, Insert));
+    TRILINOS_THROW(y.PutScalar(0.));
+    m_y = y.Values();
+
+    // The operator action also assembles the RHS, which must be kept for the running solve
+    m_rhs_backup->assign(*m_rhs);
+    m_applying = true;
+    try
+    {
+      m_operator_action->execute();
+    }
+    catch(...)
+    {
+      m_applying = false;
+      m_rhs->assign(*m_rhs_backup);
+      throw;
+    }
+    m_applying = false;
+    m_rhs->assign(*m_rhs_backup);
+
+    const double* x_values = x.Values();
+    if(!m_added_diagonal.empty())
+    {
+      for(int i = 0; i != m_num_my_elements; ++i)
+        m_y[i] += m_added_diagonal[i]*x_values[i];
+    }
+    for(std::map<int, Real>::const_iterator it = m_replaced_rows.begin(); it != m_replaced_rows.end(); ++it)
+      m_y[it->first] = it->second*x_values[it->first];
+
+    m_y = nullptr;
+    ++m_nb_applications;
+  }
+
+  m_application_time += timer.elapsed();
+  properties()["nb_applications"] = m_nb_applications;
+  properties()["application_time"] = m_application_time;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::apply(const Handle< Vector >& y, const Handle< const Vector >& x, const Real alpha, const Real beta)
+{
+  apply_matrix(*m_epetra_operator, y, x, alpha, beta);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Teuchos::RCP< const Thyra::LinearOpBase< Real > > TrilinosMatrixFreeOperator::thyra_operator() const
+{
+  return Thyra::epetraLinearOp(m_epetra_operator, Thyra::NOTRANS, Thyra::EPETRA_OP_APPLY_APPLY, Thyra::EPETRA_OP_ADJOINT_UNSUPPORTED);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Teuchos::RCP< Thyra::LinearOpBase< Real > > TrilinosMatrixFreeOperator::thyra_operator()
+{
+  return Thyra::nonconstEpetraLinearOp(m_epetra_operator, Thyra::NOTRANS, Thyra::EPETRA_OP_APPLY_APPLY, Thyra::EPETRA_OP_ADJOINT_UNSUPPORTED);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Teuchos::RCP< const Thyra::LinearOpBase< Real > > TrilinosMatrixFreeOperator::thyra_preconditioner_operator() const
+{
+  if(is_null(m_preconditioner))
+    return Teuchos::null;
+
+  return dynamic_cast<const ThyraOperator&>(*m_preconditioner).thyra_operator();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::clone_to(Matrix& other)
+{
+  throw common::NotSupported(FromHere(), "clone_to is not supported for a matrix-free operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::read_native(const common::URI& file)
+{
+  throw common::NotSupported(FromHere(), "read_native is not supported for a matrix-free operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::print(common::LogStream& stream)
+{
+  stream << "Matrix-free operator " << uri().string() << " with " << m_num_my_elements << " local rows, " << m_replaced_rows.size() << " replaced rows and " << m_nb_applications << " applications" << CFendl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::print(std::ostream& stream)
+{
+  stream << "Matrix-free operator " << uri().string() << " with " << m_num_my_elements << " local rows, " << m_replaced_rows.size() << " replaced rows and " << m_nb_applications << " applications" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::print(const std::string& filename, std::ios_base::openmode mode )
+{
+  std::ofstream stream(filename.c_str(), mode);
+  print(stream);
+  stream.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::print_native(std::ostream& stream)
+{
+  print(stream);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosMatrixFreeOperator::debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values)
+{
+  throw common::NotSupported(FromHere(), "debug_data is not supported for a matrix-free operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,279 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_TrilinosMatrixFreeOperator_hpp
+#define cf3_Math_LSS_TrilinosMatrixFreeOperator_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <map>
+
+#include <Epetra_Import.h>
+#include <Epetra_Map.h>
+#include <Epetra_MpiComm.h>
+#include <Epetra_MultiVector.h>
+#include <Epetra_Operator.h>
+#include <Epetra_Vector.h>
+#include <Teuchos_RCP.hpp>
+
+#include "common/Action.hpp"
+
+#include "math/LSS/LibLSS.hpp"
+#include "math/LSS/BlockAccumulator.hpp"
+#include "math/LSS/Vector.hpp"
+#include "math/LSS/Matrix.hpp"
+
+#include "ThyraOperator.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file TrilinosMatrixFreeOperator.hpp Matrix-free operator, applied by re-evaluating the element matrices
+
+  The matrix entries are never stored. Applying the operator executes the action set in the operator_action option, which
+  normally is the assembly action of the system: each element matrix that it adds to this matrix is multiplied with the
+  local values of the vector and summed into the result. The element matrices must depend only on fields that are constant
+  during the linear solve, which is the case for the Picard-linearized UFEM systems.
+
+  Dirichlet conditions replace their row by the identity and keep their column, so symmetric_dirichlet is applied as a
+  non-symmetric row replacement. Use a non-symmetric Krylov method such as GMRES.
+
+  Optionally, the element matrices of the regular assembly are also stored in an assembled matrix that is used to build
+  the preconditioner, either completely or keeping only the diagonal block of each node.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class LSS_API TrilinosMatrixFreeOperator : public LSS::Matrix, public ThyraOperator {
+public:
+
+  /// @name CREATION, DESTRUCTION AND COMPONENT SYSTEM
+  //@{
+
+  /// name of the type
+  static std::string type_name () { return "TrilinosMatrixFreeOperator"; }
+
+  /// Accessor to solver type
+  const std::string solvertype() { return "Trilinos"; }
+
+  /// Accessor to the flag if matrix, solution and rhs are tied together or not
+  const bool is_swappable(const LSS::Vector& solution, const LSS::Vector& rhs) { return false; }
+
+  /// Default constructor
+  TrilinosMatrixFreeOperator(const std::string& name);
+
+  ~TrilinosMatrixFreeOperator();
+
+  /// Setup the maps. The sparsity is only used for the preconditioner matrix.
+  void create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+  void create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, Vector& solution, Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// Deallocate underlying data
+  void destroy();
+
+  //@} END CREATION, DESTRUCTION AND COMPONENT SYSTEM
+
+  /// @name INDIVIDUAL ACCESS
+  //@{
+
+  /// Not supported, since the entries are not stored
+  void set_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Not supported, since the entries are not stored
+  void add_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Not supported, since the entries are not stored
+  void get_value(const Uint icol, const Uint irow, Real& value);
+
+  //@} END INDIVIDUAL ACCESS
+
+  /// @name EFFICCIENT ACCESS
+  //@{
+
+  /// Only supported outside of operator application, for the preconditioner matrix
+  void set_values(const BlockAccumulator& values);
+
+  /// During operator application, multiply the element matrix with the vector. Otherwise, add it to the preconditioner matrix, if any.
+  /// Can be called concurrently for blocks that don't share rows.
+  void add_values(const BlockAccumulator& values);
+
+  /// Not supported, since the entries are not stored
+  void get_values(BlockAccumulator& values);
+
+  /// Replace the row by diagval times the unknown. offdiagval must be zero.
+  void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval);
+
+  /// Not supported, since the entries are not stored
+  void get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values);
+
+  /// Replace the row by the identity and set the RHS to the value. The column is kept, so symmetry is not preserved.
+  void symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs);
+
+  /// Not supported, use periodic links when creating the system instead
+  void tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from);
+
+  /// Not supported, since the entries are not stored
+  void set_diagonal(const std::vector<Real>& diag);
+
+  /// Add a diagonal, which is applied together with the element matrices
+  void add_diagonal(const std::vector<Real>& diag);
+
+  /// Not supported, since the entries are not stored
+  void get_diagonal(std::vector<Real>& diag);
+
+  /// Forget the dirichlet rows and added diagonal. Ignored during operator application.
+  void reset(Real reset_to=0.);
+
+  //@} END EFFICCIENT ACCESS
+
+  /// @name MISCELLANEOUS
+  //@{
+
+  /// Print to wherever
+  void print(common::LogStream& stream);
+
+  /// Print to wherever
+  void print(std::ostream& stream);
+
+  /// Print to file given by filename
+  void print(const std::string& filename, std::ios_base::openmode mode = std::ios_base::out );
+
+  void print_native(std::ostream& stream);
+
+  /// Accessor to the state of create
+  const bool is_created() { return m_is_created; }
+
+  /// Accessor to the number of equations
+  const Uint neq() { cf3_assert(m_is_created); return m_neq; }
+
+  /// Accessor to the number of block rows
+  const Uint blockrow_size() {  cf3_assert(m_is_created); return m_num_my_elements/neq(); }
+
+  /// Accessor to the number of block columns
+  const Uint blockcol_size() {  cf3_assert(m_is_created); return m_p2m.size()/neq(); }
+
+  //@} END MISCELLANEOUS
+
+  /// @name LINEAR ALGEBRA
+  //@{
+
+  /// Compute y = alpha*A*x + beta*y
+  void apply(const Handle<Vector>& y, const Handle<Vector const>& x, const Real alpha = 1., const Real beta = 0.);
+
+  //@} END LINEAR ALGEBRA
+
+  /// @name TEST ONLY
+  //@{
+
+  /// Not supported, since the entries are not stored
+  void debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values);
+
+  //@} END TEST ONLY
+
+  virtual Teuchos::RCP< const Thyra::LinearOpBase< Real > > thyra_operator() const;
+  virtual Teuchos::RCP< Thyra::LinearOpBase< Real > > thyra_operator();
+
+  /// The assembled preconditioner matrix, or null if there is none
+  virtual Teuchos::RCP< const Thyra::LinearOpBase< Real > > thyra_preconditioner_operator() const;
+
+  /// Not supported
+  virtual void clone_to(Matrix &other);
+
+  /// Not supported
+  virtual void read_native(const common::URI& file);
+
+  /// Compute Y = A*X for the Epetra vectors, which have the owned entries only
+  void apply_epetra(const Epetra_MultiVector& X, Epetra_MultiVector& Y);
+
+  /// Number of operator applications since creation
+  Uint nb_applications() const { return m_nb_applications; }
+
+  /// Total time in seconds spent in operator applications since creation, including the executions of the operator action
+  Real application_time() const { return m_application_time; }
+
+private:
+  /// Add the element matrix in values to the preconditioner, keeping only the node diagonal blocks if requested
+  void add_to_preconditioner(const BlockAccumulator& values, const bool add);
+
+  /// (Re)build the preconditioner matrix according to the options. It is filled by the next assembly.
+  void trigger_preconditioner();
+
+  /// Epetra interface to apply_epetra
+  class EpetraOperator;
+
+  /// epetra mpi environment
+  Epetra_MpiComm m_comm;
+
+  /// state of creation
+  bool m_is_created;
+
+  /// number of equations
+  Uint m_neq;
+
+  /// number of local elements (rows)
+  int m_num_my_elements;
+
+  /// mapper array, maps from process local numbering to matrix local numbering, with the ghosts at the end
+  std::vector<int> m_p2m;
+
+  /// Owned entries and owned entries followed by the ghosts
+  Teuchos::RCP<Epetra_Map> m_row_map;
+  Teuchos::RCP<Epetra_Map> m_col_map;
+  Teuchos::RCP<Epetra_Import> m_importer;
+
+  /// Vector to apply the operator to, including ghosts, and result. Only set during operator application.
+  Teuchos::RCP<Epetra_Vector> m_x_col;
+  double* m_y;
+
+  /// True while the operator action is executing
+  bool m_applying;
+
+  /// Copy of the RHS, restored after executing the operator action
+  Handle<Vector> m_rhs;
+  Handle<Vector> m_rhs_backup;
+
+  /// Creation arguments, kept to build the preconditioner matrix when its options change
+  Handle<common::PE::CommPattern> m_comm_pattern;
+  Handle<VariablesDescriptor const> m_variables;
+  Handle<Vector> m_solution;
+  std::vector<Uint> m_node_connectivity;
+  std::vector<Uint> m_starting_indices;
+  std::vector<Uint> m_periodic_links_nodes;
+  std::vector<bool> m_periodic_links_active;
+
+  /// Rows that were replaced by set_row or symmetric_dirichlet, with the value of their diagonal, in matrix local numbering
+  std::map<int, Real> m_replaced_rows;
+
+  /// Diagonal added with add_diagonal, in matrix local numbering. Empty if none.
+  std::vector<Real> m_added_diagonal;
+
+  /// Epetra and Thyra wrappers for the operator
+  Teuchos::RCP<EpetraOperator> m_epetra_operator;
+
+  /// The action that adds the element matrices
+  Handle<common::Action> m_operator_action;
+
+  /// Assembled matrix used to build the preconditioner
+  Handle<LSS::Matrix> m_preconditioner;
+  bool m_diagonal_preconditioner;
+
+  Uint m_nb_applications;
+  Real m_application_time;
+}; // end of class TrilinosMatrixFreeOperator
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_TrilinosMatrixFreeOperator_hpp
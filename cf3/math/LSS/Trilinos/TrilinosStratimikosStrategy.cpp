@@ -19,6 +19,7 @@
 #include "Thyra_EpetraLinearOp.hpp"
 #include "Thyra_EpetraThyraWrappers.hpp"
 #include "Thyra_LinearOpWithSolveBase.hpp"
+#include "Thyra_LinearOpWithSolveFactoryHelpers.hpp"
 #include "Thyra_VectorBase.hpp"
 #include "Thyra_VectorStdOps.hpp"
 
@@ -152,9 +153,13 @@ struct TrilinosStratimikosStrategy::Implementation
     }
 
     
+    const Teuchos::RCP< const Thyra::LinearOpBase<Real> > approx_operator = m_matrix->thyra_preconditioner_operator();
     if(m_iteration_count % m_preconditioner_reset == 0)
     {
-      Thyra::initializeOp(*m_lows_factory, m_matrix->thyra_operator(), m_lows.ptr());
+      if(approx_operator.is_null())
+        Thyra::initializeOp(*m_lows_factory, m_matrix->thyra_operator(), m_lows.ptr());
+      else
+        Thyra::initializeApproxPreconditionedOp<Real>(*m_lows_factory, m_matrix->thyra_operator(), approx_operator, m_lows.ptr());
     }
     else
     {
@@ -24,17 +24,21 @@ namespace mesh {
 ////////////////////////////////////////////////////////////////////////////////
 
 /// Fill STL-vector like per-node data storage
+/// The values are gathered directly from the table storage, so both row-major and column-major tables are supported
 template<typename NodeValuesT, typename RowT>
 void fill(NodeValuesT& to_fill, const common::Table<Real>& data_array, const RowT& element_row, const Uint start=0)
 {
   const Uint nb_nodes = element_row.size();
   const Uint dim = data_array.row_size();
   const Uint end = start+dim;
+  const Real* data = data_array.array().data();
+  const std::ptrdiff_t row_stride = data_array.array().strides()[0];
+  const std::ptrdiff_t col_stride = data_array.array().strides()[1];
   for(Uint node = 0; node != nb_nodes; ++node)
   {
-    const common::Table<Real>::ConstRow data_row = data_array[element_row[node]];
+    const Real* data_row = data + element_row[node]*row_stride;
     for(Uint j = start; j != end; ++j)
-      to_fill[node][j-start] = data_row[j];
+      to_fill[node][j-start] = data_row[j*col_stride];
   }
 }
 
@@ -42,11 +46,14 @@ void fill(NodeValuesT& to_fill, const common::Table<Real>& data_array, const Row
 template<typename RowT, int NbRows, int NbCols>
 void fill(Eigen::Matrix<Real, NbRows, NbCols>& to_fill, const common::Table<Real>& data_array, const RowT& element_row, const Uint start=0)
 {
+  const Real* data = data_array.array().data() + start*data_array.array().strides()[1];
+  const std::ptrdiff_t row_stride = data_array.array().strides()[0];
+  const std::ptrdiff_t col_stride = data_array.array().strides()[1];
   for(int node = 0; node != NbRows; ++node)
   {
-    const common::Table<Real>::ConstRow data_row = data_array[element_row[node]];
+    const Real* data_row = data + element_row[node]*row_stride;
     for(Uint j = 0; j != NbCols; ++j)
-      to_fill(node, j) = data_row[j+start];
+      to_fill(node, j) = data_row[j*col_stride];
   }
 }
 
@@ -57,11 +64,14 @@ void fill(RealMatrix& to_fill, const common::Table<Real>& data_array, const RowT
   const Uint nb_nodes = element_row.size();
   const Uint dim = data_array.row_size();
   const Uint end = start+dim;
+  const Real* data = data_array.array().data();
+  const std::ptrdiff_t row_stride = data_array.array().strides()[0];
+  const std::ptrdiff_t col_stride = data_array.array().strides()[1];
   for(Uint node = 0; node != nb_nodes; ++node)
   {
-    const common::Table<Real>::ConstRow data_row = data_array[element_row[node]];
+    const Real* data_row = data + element_row[node]*row_stride;
     for(Uint j = start; j != end; ++j)
-      to_fill(node, j-start) = data_row[j];
+      to_fill(node, j-start) = data_row[j*col_stride];
   }
 }
 
@@ -20,6 +20,8 @@ namespace mesh {
   class Octtree;
   
 /// @brief Find elements using an octtree
+/// If no element contains the point and find_closest is true, the element with the closest centroid is returned,
+/// provided the point lies inside the bounding box of the mesh.
 class Mesh_API ElementFinderOcttree : public ElementFinder
 {
 public:
@@ -44,13 +46,8 @@ private:
   Entity m_tmp;
   bool m_closest;
 
-  std::vector<Uint> m_octtree_idx;
-
   std::vector<Entity> m_elements_pool;
 
-  RealMatrix m_coordinates;
-
-
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -4,6 +4,10 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+
 #include "common/Log.hpp"
 #include "common/OptionList.hpp"
 #include "common/OptionT.hpp"
@@ -12,6 +16,7 @@
 #include "common/Builder.hpp"
 #include "common/DynTable.hpp"
 #include "common/OptionList.hpp"
+#include "common/ThreadPool.hpp"
 
 #include "math/MatrixTypes.hpp"
 #include "math/Consts.hpp"
@@ -25,6 +30,7 @@
 #include "mesh/Space.hpp"
 #include "mesh/ElementConnectivity.hpp"
 #include "mesh/Connectivity.hpp"
+#include "mesh/ElementType.hpp"
 
 #include "common/OptionList.hpp"
 
@@ -49,6 +55,19 @@ FaceCellConnectivity::FaceCellConnectivity ( const std::string& name ) :
       .link_to(&m_face_building_algorithm)
       .description("Improves efficiency for face building algorithm");
 
+  std::vector<boost::any> face_matchings;
+  face_matchings.push_back(std::string("hash"));
+  face_matchings.push_back(std::string("node_search"));
+  options().add("face_matching", std::string("hash"))
+      .description("Algorithm to match the faces of the elements: hash (hash the sorted face nodes into a table) "
+                   "or node_search (search the faces connected to each node)")
+      .pretty_name("Face Matching")
+      .restricted_list() = face_matchings;
+
+  options().add("nb_threads", 1u)
+      .description("Number of threads used to match the faces with the hash algorithm")
+      .pretty_name("Number of Threads");
+
   m_used_components = create_static_component<Group>("used_components");
   m_connectivity = create_static_component<common::Table<Entity> >(mesh::Tags::connectivity_table());
   m_face_nb_in_elem = create_static_component<common::Table<Uint> >("face_number");
@@ -108,6 +127,190 @@ void FaceCellConnectivity::add_used (Component& used_comp)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+
+/// Hash of the sorted nodes of a face. The result is mixed, so both the low bits (used for the slots of the table)
+/// and the high bits (used to distribute the faces over the threads) are evenly distributed.
+inline boost::uint64_t hash_face_nodes(const Uint* nodes, const Uint nb_nodes)
+{
+  boost::uint64_t h = 14695981039346656037ULL;
+  for(Uint i = 0; i != nb_nodes; ++i)
+    h = (h ^ nodes[i]) * 1099511628211ULL;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/// Matches the faces of the used elements through their sorted nodes.
+/// Every face of every element is an occurrence, numbered in the order the elements are traversed.
+/// After execution, first[o] is the first occurrence with the same nodes as occurrence o (o itself if no earlier one exists),
+/// or not_used if the element of o is skipped.
+struct FaceMatcher
+{
+  static const Uint not_used = static_cast<Uint>(-1);
+
+  /// A component of used elements
+  struct Block
+  {
+    const Connectivity* connectivity;
+    /// Local nodes of each face of the element type
+    std::vector< std::vector<Uint> > face_nodes;
+    /// Only elements with a true value here are used, if not null
+    const common::List<bool>* is_bdry;
+    Uint first_element;
+    Uint first_occurrence;
+  };
+
+  FaceMatcher() : nb_elements(0), nb_occurrences(0), max_nb_face_nodes(0) {}
+
+  void add(const Elements& elements, const common::List<bool>* is_bdry)
+  {
+    const ElementType& etype = elements.element_type();
+    blocks.push_back(Block());
+    Block& block = blocks.back();
+    block.connectivity = &elements.geometry_space().connectivity();
+    block.is_bdry = is_bdry;
+    block.face_nodes.resize(etype.nb_faces());
+    for(Uint face_idx = 0; face_idx != etype.nb_faces(); ++face_idx)
+    {
+      boost_foreach(const Uint face_node_idx, etype.faces().nodes_range(face_idx))
+        block.face_nodes[face_idx].push_back(face_node_idx);
+      max_nb_face_nodes = std::max(max_nb_face_nodes, static_cast<Uint>(block.face_nodes[face_idx].size()));
+    }
+    block.first_element = nb_elements;
+    block.first_occurrence = nb_occurrences;
+    nb_elements += elements.size();
+    nb_occurrences += elements.size() * etype.nb_faces();
+  }
+
+  /// Store the sorted nodes of the given face in nodes, returning their number
+  Uint sorted_face_nodes(const Block& block, const Uint element, const Uint face_idx, Uint* nodes) const
+  {
+    const Connectivity::ConstRow element_nodes = (*block.connectivity)[element];
+    const std::vector<Uint>& local_nodes = block.face_nodes[face_idx];
+    const Uint nb_nodes = local_nodes.size();
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      const Uint node = element_nodes[local_nodes[i]];
+      Uint j = i;
+      for(; j != 0 && nodes[j-1] > node; --j)
+        nodes[j] = nodes[j-1];
+      nodes[j] = node;
+    }
+    return nb_nodes;
+  }
+
+  /// Sorted nodes of the given occurrence
+  Uint sorted_face_nodes(const Uint occurrence, Uint* nodes) const
+  {
+    Uint b = blocks.size()-1;
+    while(blocks[b].first_occurrence > occurrence)
+      --b;
+    const Block& block = blocks[b];
+    const Uint nb_faces = block.face_nodes.size();
+    const Uint local_occurrence = occurrence - block.first_occurrence;
+    return sorted_face_nodes(block, local_occurrence / nb_faces, local_occurrence % nb_faces, nodes);
+  }
+
+  /// Task for the thread pool. Each thread hashes the faces of a contiguous range of elements and sorts them into shards
+  /// by the high bits of the hash. Each thread then matches the faces of one shard in an open-addressing table.
+  /// Occurrences of a shard are visited in traversal order, so the first occurrence of a face is always the one that is stored.
+  void operator()(const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier)
+  {
+    std::vector<Uint> nodes(max_nb_face_nodes);
+
+    std::vector< std::vector<Uint> >& my_shards = shards[thread_idx];
+    my_shards.assign(nb_threads, std::vector<Uint>());
+
+    Uint elements_begin, elements_end;
+    common::ThreadPool::static_chunk(nb_elements, thread_idx, nb_threads, elements_begin, elements_end);
+    boost_foreach(const Block& block, blocks)
+    {
+      const Uint nb_faces = block.face_nodes.size();
+      const Uint block_size = block.connectivity->size();
+      const Uint begin = std::max(elements_begin, block.first_element) - block.first_element;
+      const Uint end = std::min(elements_end, block.first_element + block_size);
+      for(Uint element = begin; element + block.first_element < end; ++element)
+      {
+        Uint occurrence = block.first_occurrence + element*nb_faces;
+        if(is_not_null(block.is_bdry) && (*block.is_bdry)[element] == false)
+        {
+          std::fill(first.begin() + occurrence, first.begin() + occurrence + nb_faces, not_used);
+          continue;
+        }
+        for(Uint face_idx = 0; face_idx != nb_faces; ++face_idx, ++occurrence)
+        {
+          const boost::uint64_t hash = hash_face_nodes(&nodes[0], sorted_face_nodes(block, element, face_idx, &nodes[0]));
+          hashes[occurrence] = hash;
+          my_shards[(hash >> 40) % nb_threads].push_back(occurrence);
+        }
+      }
+    }
+
+    barrier.wait();
+
+    Uint shard_size = 0;
+    for(Uint t = 0; t != nb_threads; ++t)
+      shard_size += shards[t][thread_idx].size();
+    Uint table_size = 16;
+    while(table_size < 2*shard_size)
+      table_size *= 2;
+    const Uint mask = table_size - 1;
+    std::vector<Uint> table(table_size, not_used);
+
+    std::vector<Uint> other_nodes(max_nb_face_nodes);
+    for(Uint t = 0; t != nb_threads; ++t)
+    {
+      boost_foreach(const Uint occurrence, shards[t][thread_idx])
+      {
+        const boost::uint64_t hash = hashes[occurrence];
+        const Uint nb_nodes = sorted_face_nodes(occurrence, &nodes[0]);
+        Uint slot = static_cast<Uint>(hash) & mask;
+        first[occurrence] = occurrence;
+        for(; table[slot] != not_used; slot = (slot + 1) & mask)
+        {
+          const Uint candidate = table[slot];
+          if(hashes[candidate] == hash && sorted_face_nodes(candidate, &other_nodes[0]) == nb_nodes
+             && std::equal(nodes.begin(), nodes.begin() + nb_nodes, other_nodes.begin()))
+          {
+            first[occurrence] = candidate;
+            break;
+          }
+        }
+        if(first[occurrence] == occurrence)
+          table[slot] = occurrence;
+      }
+    }
+  }
+
+  void execute(const Uint nb_threads)
+  {
+    hashes.resize(nb_occurrences);
+    first.resize(nb_occurrences);
+    shards.assign(nb_threads, std::vector< std::vector<Uint> >());
+    common::ThreadPool::instance().run(nb_threads, boost::ref(*this));
+    shards.clear();
+  }
+
+  std::vector<Block> blocks;
+  Uint nb_elements;
+  Uint nb_occurrences;
+  Uint max_nb_face_nodes;
+
+  std::vector<boost::uint64_t> hashes;
+  std::vector<Uint> first;
+  /// Occurrences in each shard, for each thread that computed them
+  std::vector< std::vector< std::vector<Uint> > > shards;
+};
+
+} // detail
+
+////////////////////////////////////////////////////////////////////////////////
+
 void FaceCellConnectivity::build_connectivity()
 {
 
@@ -117,6 +320,164 @@ void FaceCellConnectivity::build_connectivity()
     return;
   }
 
+  if (m_face_building_algorithm)
+  {
+    // allocate storage if doesn't exist that says if the element is at the boundary of a region
+    // ( = not the same as the mesh boundary)
+    boost_foreach (Handle< Component > elements_comp, used())
+    {
+      Elements& elements = dynamic_cast<Elements&>(*elements_comp);
+      Handle< Component > comp = elements.get_child("is_bdry");
+      if ( is_null( comp ) || is_null(Handle< common::List<bool> >(comp)) )
+      {
+        common::List<bool>& is_bdry_elem = * elements.create_component< common::List<bool> >("is_bdry");
+
+        const Uint nb_elem = elements.size();
+        is_bdry_elem.resize(nb_elem);
+
+        for (Uint e=0; e<nb_elem; ++e)
+          is_bdry_elem[e] = true;
+      }
+      cf3_assert( Handle< common::List<bool> >(elements.get_child("is_bdry")) );
+    }
+  }
+
+  if (options().value<std::string>("face_matching") == "node_search")
+    match_faces_node_search();
+  else
+    match_faces_hashed();
+
+  cf3_assert(m_nb_faces == m_connectivity->size());
+
+  if (m_face_building_algorithm)
+  {
+    const common::List<bool>& is_bdry_face = *m_is_bdry_face;
+    for (Uint f=0; f<m_connectivity->size(); ++f)
+    {
+      ElementConnectivity::Row elem_row = (*m_connectivity)[f];
+      boost_foreach (Entity& elem, elem_row)
+      {
+        if ( is_not_null(elem.comp) )
+        {
+          common::List<bool>& is_bdry_elem = *Handle< common::List<bool> >(elem.comp->get_child("is_bdry"));
+          is_bdry_elem[elem.idx] = is_bdry_elem[elem.idx] || is_bdry_face[f] ;
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FaceCellConnectivity::match_faces_hashed()
+{
+  detail::FaceMatcher matcher;
+  boost_foreach (Handle< Component > elements_comp, used() )
+  {
+    Elements& elements = dynamic_cast<Elements&>(*elements_comp);
+    Handle< common::List<bool> > is_bdry_elem;
+    if (m_face_building_algorithm)
+      is_bdry_elem = Handle< common::List<bool> >(elements.get_child("is_bdry"));
+    matcher.add(elements, is_bdry_elem.get());
+  }
+
+  matcher.execute(std::max(options().value<Uint>("nb_threads"), 1u));
+
+  // Faces are numbered in the order of their first occurrence
+  m_nb_faces = 0;
+  for (Uint occurrence = 0; occurrence != matcher.nb_occurrences; ++occurrence)
+  {
+    if (matcher.first[occurrence] == occurrence)
+      ++m_nb_faces;
+  }
+
+  m_connectivity->resize(m_nb_faces);
+  m_face_nb_in_elem->resize(m_nb_faces);
+  m_is_bdry_face->resize(m_nb_faces);
+  m_cell_rotation->resize(m_nb_faces);
+  m_cell_orientation->resize(m_nb_faces);
+  ElementConnectivity& f2c = *m_connectivity;
+  common::Table<Uint>& face_number = *m_face_nb_in_elem;
+  common::List<bool>& is_bdry_face = *m_is_bdry_face;
+  common::Table<Uint>& cell_rotation = *m_cell_rotation;
+  common::Table<bool>& cell_orientation = *m_cell_orientation;
+
+  // The first occurrence of each face gets the face index, so later occurrences find it through first.
+  // This is safe because first[o] < o for all later occurrences.
+  std::vector<Uint>& face_of = matcher.first;
+  std::vector<Handle< Component > > used_components = used();
+  Uint face = 0;
+  for (Uint b = 0; b != matcher.blocks.size(); ++b)
+  {
+    const detail::FaceMatcher::Block& block = matcher.blocks[b];
+    Elements& elements = dynamic_cast<Elements&>(*used_components[b]);
+    const Uint nb_faces_in_elem = block.face_nodes.size();
+    const Uint nb_elems = block.connectivity->size();
+    Uint occurrence = block.first_occurrence;
+    for (Uint loc_elem_idx = 0; loc_elem_idx != nb_elems; ++loc_elem_idx)
+    {
+      for (Uint face_idx = 0; face_idx != nb_faces_in_elem; ++face_idx, ++occurrence)
+      {
+        const Uint first = matcher.first[occurrence];
+        if (first == detail::FaceMatcher::not_used)
+          continue;
+
+        const Entity element(elements, loc_elem_idx);
+        if (first == occurrence)
+        {
+          // a new face has been found
+          face_of[occurrence] = face;
+          f2c[face][0] = element;
+          f2c[face][1] = Entity();
+          face_number[face][0] = face_idx;
+          face_number[face][1] = 0;
+          cell_orientation[face][0] = MATCHED;
+          cell_orientation[face][1] = INVERTED;
+          cell_rotation[face][0] = 0;
+          cell_rotation[face][1] = 0;
+          is_bdry_face[face] = true;
+          ++face;
+          continue;
+        }
+
+        // the face already exists, meaning that it is an internal one, shared by two elements
+        const Uint inner_face = face_of[first];
+        f2c[inner_face][1] = element;
+        face_number[inner_face][1] = face_idx;
+        is_bdry_face[inner_face] = false;
+
+        const std::vector<Uint>& local_nodes = block.face_nodes[face_idx];
+        const Uint nb_nodes = local_nodes.size();
+        if (nb_nodes > 1)
+        {
+          // Find the rotation, i.e. the position of the first node of the face in the first element
+          const Entity& first_element = f2c[inner_face][0];
+          const Uint first_node_loc_idx = first_element.get_nodes()[
+                                            first_element.element_type().faces().nodes_range(face_number[inner_face][0])[0]
+                                          ];
+          const Connectivity::ConstRow elem_nodes = (*block.connectivity)[loc_elem_idx];
+          Uint rotation;
+          for (rotation=0; rotation!=nb_nodes; ++rotation)
+          {
+            if (elem_nodes[local_nodes[rotation]] == first_node_loc_idx)
+            {
+              cell_rotation[inner_face][1]=rotation;
+              break;
+            }
+          }
+          // Following assertion fails, it means the correct orientation was not found! This should never happen!
+          cf3_always_assert(rotation != nb_nodes);
+        }
+      }
+    }
+  }
+  cf3_assert(face == m_nb_faces);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FaceCellConnectivity::match_faces_node_search()
+{
   // declartions
   m_connectivity->resize(0);
   common::Table<Entity>::Buffer f2c = m_connectivity->create_buffer();
@@ -143,28 +504,6 @@ void FaceCellConnectivity::build_connectivity()
     max_nb_faces += nb_faces * elements->size() ;
   }
 
-  if (m_face_building_algorithm)
-  {
-    // allocate storage if doesn't exist that says if the element is at the boundary of a region
-    // ( = not the same as the mesh boundary)
-    boost_foreach (Handle< Component > elements_comp, used())
-    {
-      Elements& elements = dynamic_cast<Elements&>(*elements_comp);
-      Handle< Component > comp = elements.get_child("is_bdry");
-      if ( is_null( comp ) || is_null(Handle< common::List<bool> >(comp)) )
-      {
-        common::List<bool>& is_bdry_elem = * elements.create_component< common::List<bool> >("is_bdry");
-
-        const Uint nb_elem = elements.size();
-        is_bdry_elem.resize(nb_elem);
-
-        for (Uint e=0; e<nb_elem; ++e)
-          is_bdry_elem[e] = true;
-      }
-      cf3_assert( Handle< common::List<bool> >(elements.get_child("is_bdry")) );
-    }
-  }
-
   // Declarations to save frequent allocations in the loop algorithm
   Uint nb_inner_faces = 0;
   Uint nb_matched_nodes = 1;
@@ -335,25 +674,6 @@ void FaceCellConnectivity::build_connectivity()
 
   cf3_assert(m_nb_faces <= max_nb_faces);
   cf3_assert(nb_inner_faces <= max_nb_faces);
-
-
-  cf3_assert(m_nb_faces == m_connectivity->size());
-
-  if (m_face_building_algorithm)
-  {
-    for (Uint f=0; f<m_connectivity->size(); ++f)
-    {
-      ElementConnectivity::Row elem_row = (*m_connectivity)[f];
-      boost_foreach (Entity& elem, elem_row)
-      {
-        if ( is_not_null(elem.comp) )
-        {
-          common::List<bool>& is_bdry_elem = *Handle< common::List<bool> >(elem.comp->get_child("is_bdry"));
-          is_bdry_elem[elem.idx] = is_bdry_elem[elem.idx] || is_bdry_face.get_row(f) ;
-        }
-      }
-    }
-  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -62,7 +62,8 @@ public:
   /// Build the connectivity table
   /// Build the connectivity table as a DynTable<Uint>
   /// @pre set_nodes() and set_elements() must have been called
-
+  /// Faces are numbered in the order of their first occurrence in the used elements. Both face matching
+  /// algorithms give the same result.
   void build_connectivity();
 
   /// const access to the node to element connectivity table in unified indices
@@ -95,6 +96,14 @@ public:
 
   void add_used (Component& used_comp);
 
+private: // functions
+
+  /// Match faces by hashing their sorted nodes into an open-addressing table, using several threads
+  void match_faces_hashed();
+
+  /// Match faces by searching the faces that were already found for each of their nodes
+  void match_faces_node_search();
+
 private: // data
 
   /// nb_faces
@@ -4,6 +4,7 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <boost/bind.hpp>
 #include <boost/date_time/gregorian/gregorian.hpp>
 
 #include "common/Signal.hpp"
@@ -48,6 +49,12 @@ Field::Field ( const std::string& name  ) :
   properties()["date"] = boost::gregorian::to_iso_extended_string(boost::gregorian::day_clock::local_day());
   properties()["time"] = 0.;
   properties()["step"] = 0u;
+
+  options().add("column_major", false)
+    .pretty_name("Column Major")
+    .description("Store the values variable by variable (structure of arrays) instead of node by node. "
+                 "Loops that only touch some of the variables then read less memory.")
+    .attach_trigger(boost::bind(&Field::trigger_column_major, this));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -180,6 +187,36 @@ void Field::synchronize()
   m_comm_pattern->synchronize( name() );
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+void Field::begin_synchronize()
+{
+  if(!common::PE::Comm::instance().is_active())
+    return;
+
+  if(is_null(m_comm_pattern))
+  {
+    CFdebug << "Applying default parallelization from dict for field " << uri().path() << CFendl;
+    parallelize();
+  }
+
+  cf3_assert(is_not_null(m_comm_pattern));
+
+  CFdebug << "Starting synchronization of field " << uri().path() << CFendl;
+  m_comm_pattern->begin_synchronize( name() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Field::end_synchronize()
+{
+  if(!common::PE::Comm::instance().is_active())
+    return;
+
+  cf3_assert(is_not_null(m_comm_pattern));
+  m_comm_pattern->end_synchronize( name() );
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 void Field::set_descriptor(math::VariablesDescriptor& descriptor)
@@ -272,21 +309,21 @@ Field& Field::coordinates() const
 
 Field::Ref Field::ref()
 {
-  return Ref( &array()[0][0], size(), row_size(), Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(row_size(),row_size()-1));
+  return Ref( array().data(), size(), row_size(), Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(array().strides()[0],array().strides()[1]));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 Field::Ref  Field::col(const Uint c)
 {
-  return Ref( &array()[0][c], size(), 1, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(row_size(),0) );
+  return Ref( &array()[0][c], size(), 1, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(array().strides()[0],array().strides()[1]) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 Field::RowArrayRef  Field::row(const Uint r)
 {
-  return RowArrayRef( &array()[r][0], 1, row_size() );
+  return RowArrayRef( &array()[r][0], 1, row_size(), Eigen::InnerStride<Eigen::Dynamic>(array().strides()[1]) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -300,14 +337,15 @@ Real& Field::scalar(const Uint r)
 
 Field::RowVectorRef Field::vector(const Uint r)
 {
-  return RowVectorRef( &array()[r][0], 1, row_size() );
+  return RowVectorRef( &array()[r][0], 1, row_size(), Eigen::InnerStride<Eigen::Dynamic>(array().strides()[1]) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 Field::RowTensorRef Field::tensor(const Uint r)
 {
-  return RowTensorRef( &array()[r][0],  sqrt(row_size()), sqrt(row_size()));
+  const Uint dim = sqrt(row_size());
+  return RowTensorRef( &array()[r][0], dim, dim, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(dim*array().strides()[1],array().strides()[1]) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -326,5 +364,12 @@ VarType Field::var_type() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Field::trigger_column_major()
+{
+  set_column_major(options().value<bool>("column_major"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // mesh
 } // cf3
@@ -44,13 +44,13 @@ public: // typedefs
   typedef Eigen::Block<Ref, Eigen::Dynamic, 1> RefCol;
 
   typedef Eigen::Array<Real,1,Eigen::Dynamic,Eigen::RowMajor> RowArrayStorage ;
-  typedef Eigen::Map< RowArrayStorage , Eigen::Unaligned > RowArrayRef ;
+  typedef Eigen::Map< RowArrayStorage , Eigen::Unaligned, Eigen::InnerStride<Eigen::Dynamic> > RowArrayRef ;
 
   typedef Eigen::Matrix<Real,1,Eigen::Dynamic,Eigen::RowMajor> RowVectorStorage ;
-  typedef Eigen::Map< RowVectorStorage , Eigen::Unaligned > RowVectorRef ;
+  typedef Eigen::Map< RowVectorStorage , Eigen::Unaligned, Eigen::InnerStride<Eigen::Dynamic> > RowVectorRef ;
 
   typedef Eigen::Matrix<Real,Eigen::Dynamic,Eigen::Dynamic,Eigen::RowMajor> RowTensorStorage ;
-  typedef Eigen::Map< RowTensorStorage , Eigen::Unaligned > RowTensorRef ;
+  typedef Eigen::Map< RowTensorStorage , Eigen::Unaligned, Eigen::Stride<Eigen::Dynamic,Eigen::Dynamic> > RowTensorRef ;
 
 private: // typedefs
 
@@ -124,6 +124,13 @@ public: // functions
 
   void synchronize();
 
+  /// Start synchronizing the ghost values, returning before the data is received.
+  /// The field may not be modified until end_synchronize is called.
+  void begin_synchronize();
+
+  /// Wait for the synchronization started by begin_synchronize to finish
+  void end_synchronize();
+
   math::VariablesDescriptor& descriptor() const { return *m_descriptor; }
 
   void set_descriptor(math::VariablesDescriptor& descriptor);
@@ -319,6 +326,9 @@ public: // functions
 
 private:
 
+  /// Switch the storage layout when the column_major option changes
+  void trigger_column_major();
+
   Handle<Dictionary> m_dict;
 
   Handle< common::PE::CommPattern > m_comm_pattern;
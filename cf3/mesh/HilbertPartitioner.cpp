@@ -0,0 +1,207 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "math/Hilbert.hpp"
+
+#include "mesh/BoundingBox.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/HilbertPartitioner.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+  using namespace common;
+
+//////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < HilbertPartitioner, MeshTransformer, LibMesh > HilbertPartitioner_Builder;
+
+//////////////////////////////////////////////////////////////////////////////
+
+HilbertPartitioner::HilbertPartitioner ( const std::string& name ) :
+  MeshPartitioner(name),
+  m_max_key(0)
+{
+  options().add("levels", 20u)
+      .description("Number of levels of the Hilbert curve. The number of levels times the dimension must not exceed 63.")
+      .pretty_name("Levels");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void HilbertPartitioner::build_graph()
+{
+  Mesh& mesh = *m_mesh;
+  const Uint nb_parts = options().value<Uint>("nb_parts");
+
+  // Export lists from a previous execution are discarded
+  m_nodes_to_export.assign(nb_parts, std::vector<Uint>());
+  m_elements_to_export.assign(nb_parts, std::vector< std::vector<Uint> >(mesh.elements().size()));
+
+  const BoundingBox& bounding_box = *mesh.global_bounding_box();
+  const Uint levels = options().value<Uint>("levels");
+  if(bounding_box.dim() * levels > 63)
+    throw BadValue(FromHere(), "Too many Hilbert levels for dimension " + to_str(bounding_box.dim()) + ": " + to_str(levels));
+
+  math::Hilbert hilbert(bounding_box, levels);
+  m_max_key = hilbert.max_key();
+
+  Uint nb_elements = 0;
+  boost_foreach(const Handle<Entities>& elements, mesh.elements())
+    nb_elements += elements->size();
+
+  m_objects.clear();
+  m_objects.reserve(nb_elements);
+
+  const Uint nb_entities = mesh.elements().size();
+  const Field& coordinates = mesh.geometry_fields().coordinates();
+  const Uint coord_dim = coordinates.row_size();
+  for(Uint entities_idx = 0; entities_idx != nb_entities; ++entities_idx)
+  {
+    const Entities& elements = *mesh.elements()[entities_idx];
+    Handle< common::List<Real> const > weights(elements.get_child(Tags::partition_weights()));
+    RealMatrix element_coordinates(elements.element_type().nb_nodes(), coord_dim);
+    RealVector centroid(elements.element_type().dimension());
+    const Connectivity& connectivity = elements.geometry_space().connectivity();
+
+    const Uint nb_elems = elements.size();
+    for(Uint elem_idx = 0; elem_idx != nb_elems; ++elem_idx)
+    {
+      if(elements.is_ghost(elem_idx))
+        continue;
+
+      // An element with a periodic node is placed at the target of the link, so it ends up in the same part
+      // as the elements on the other side of the periodic boundary
+      bool is_periodic = false;
+      boost_foreach(const Uint node, connectivity[elem_idx])
+      {
+        const Uint target_node = periodic_target_node(node);
+        if(target_node != node)
+        {
+          for(Uint i = 0; i != centroid.size(); ++i)
+            centroid[i] = coordinates[target_node][i];
+          is_periodic = true;
+          break;
+        }
+      }
+
+      if(!is_periodic)
+      {
+        elements.geometry_space().put_coordinates(element_coordinates, elem_idx);
+        elements.element_type().compute_centroid(element_coordinates, centroid);
+      }
+
+      CurveObject object;
+      object.key = hilbert(centroid);
+      object.weight = is_null(weights) ? 1. : (*weights)[elem_idx];
+      object.entities_idx = entities_idx;
+      object.elem_idx = elem_idx;
+      m_objects.push_back(object);
+    }
+  }
+
+  std::sort(m_objects.begin(), m_objects.end());
+
+  const Uint nb_objects = m_objects.size();
+  m_cumulative_weights.resize(nb_objects + 1);
+  m_cumulative_weights[0] = 0.;
+  for(Uint i = 0; i != nb_objects; ++i)
+    m_cumulative_weights[i+1] = m_cumulative_weights[i] + m_objects[i].weight;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void HilbertPartitioner::partition_graph()
+{
+  PE::Comm& comm = PE::Comm::instance();
+  const Uint nb_parts = options().value<Uint>("nb_parts");
+  if(nb_parts < 2)
+    return;
+
+  const Uint nb_splitters = nb_parts - 1;
+
+  Real total_weight = m_cumulative_weights.back();
+  if(comm.is_active())
+    comm.all_reduce(PE::plus(), &m_cumulative_weights.back(), 1, &total_weight);
+
+  // Splitter p is the smallest key such that the objects with a lower key weigh at least (p+1)/nb_parts of the total.
+  // Keys in [lower[p], upper[p]) are bisected, all splitters at once, until the interval contains only upper[p].
+  std::vector<Real> targets(nb_splitters);
+  for(Uint p = 0; p != nb_splitters; ++p)
+    targets[p] = total_weight * static_cast<Real>(p+1) / static_cast<Real>(nb_parts);
+
+  std::vector<boost::uint64_t> lower(nb_splitters, 0);
+  std::vector<boost::uint64_t> upper(nb_splitters, m_max_key + 1);
+  std::vector<boost::uint64_t> middle(nb_splitters);
+  std::vector<Real> local_weights(nb_splitters);
+  std::vector<Real> global_weights(nb_splitters);
+
+  CurveObject search_object;
+  Uint nb_iterations = 0;
+  while(true)
+  {
+    bool converged = true;
+    for(Uint p = 0; p != nb_splitters; ++p)
+    {
+      middle[p] = lower[p] + (upper[p] - lower[p]) / 2;
+      if(upper[p] - lower[p] > 1)
+        converged = false;
+
+      search_object.key = middle[p];
+      const Uint nb_below = std::lower_bound(m_objects.begin(), m_objects.end(), search_object) - m_objects.begin();
+      local_weights[p] = m_cumulative_weights[nb_below];
+    }
+
+    if(converged)
+      break;
+
+    if(comm.is_active())
+      comm.all_reduce(PE::plus(), local_weights, global_weights);
+    else
+      global_weights = local_weights;
+
+    for(Uint p = 0; p != nb_splitters; ++p)
+    {
+      if(upper[p] - lower[p] <= 1)
+        continue;
+      if(global_weights[p] >= targets[p])
+        upper[p] = middle[p];
+      else
+        lower[p] = middle[p];
+    }
+    ++nb_iterations;
+  }
+
+  CFdebug << "    -found Hilbert splitters in " << nb_iterations << " iterations" << CFendl;
+
+  // The part of an object is the number of splitters that are not larger than its key
+  const Uint rank = comm.rank();
+  boost_foreach(const CurveObject& object, m_objects)
+  {
+    const Uint part = std::upper_bound(upper.begin(), upper.end(), object.key) - upper.begin();
+    if(part != rank)
+      m_elements_to_export[part][object.entities_idx].push_back(object.elem_idx);
+  }
+
+  m_objects.clear();
+  m_cumulative_weights.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
@@ -0,0 +1,80 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_HilbertPartitioner_hpp
+#define cf3_mesh_HilbertPartitioner_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/cstdint.hpp>
+
+#include "mesh/MeshPartitioner.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Partitioner that cuts the Hilbert space-filling curve through the element centroids in pieces of equal weight.
+/// It needs no external library, and no graph: only the global bounding box and the element coordinates.
+/// The elements are sorted locally by Hilbert key, after which the keys that split the curve into nb_parts
+/// pieces of equal weight are found by a parallel bisection on the key range, exchanging only the weights below the
+/// candidate keys. Element weights are taken from the optional partition_weights list of each element component.
+/// The edge cut is larger than for a graph partitioner, but the cost is only a sort of the local elements.
+/// Elements with a node that is periodically linked are placed at the target node of the link, so that periodic
+/// nodes and their targets end up on the same process, as with the graph partitioners.
+/// Nodes follow the elements during migration.
+class Mesh_API HilbertPartitioner : public MeshPartitioner {
+
+public: // functions
+
+  /// Contructor
+  /// @param name of the component
+  HilbertPartitioner ( const std::string& name );
+
+  /// Virtual destructor
+  virtual ~HilbertPartitioner() {}
+
+  /// Get the class name
+  static std::string type_name () { return "HilbertPartitioner"; }
+
+  /// Compute and sort the Hilbert keys of the owned elements
+  virtual void build_graph();
+
+  /// Find the keys that split the curve and fill the export lists
+  virtual void partition_graph();
+
+private: // data
+
+  /// Element on the curve
+  struct CurveObject
+  {
+    bool operator<(const CurveObject& other) const { return key < other.key; }
+
+    boost::uint64_t key;
+    Real weight;
+    Uint entities_idx;
+    Uint elem_idx;
+  };
+
+  /// Owned elements, sorted by key
+  std::vector<CurveObject> m_objects;
+
+  /// Sum of the weights of the objects before each object, with the total weight as last entry
+  std::vector<Real> m_cumulative_weights;
+
+  /// Largest possible key
+  boost::uint64_t m_max_key;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_HilbertPartitioner_hpp
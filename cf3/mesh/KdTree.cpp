@@ -0,0 +1,162 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <limits>
+
+#include "common/BasicExceptions.hpp"
+
+#include "mesh/KdTree.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+  /// Maximum number of points in a leaf
+  const Uint kd_leaf_size = 8;
+
+  /// Orders point indices by one coordinate, using the index to break ties so the tree doesn't depend on the sort implementation
+  struct KdCoordinateLess
+  {
+    KdCoordinateLess(const std::vector<Real>& coords, const Uint dim, const Uint axis) : m_coords(coords), m_dim(dim), m_axis(axis) {}
+
+    bool operator()(const Uint a, const Uint b) const
+    {
+      const Real ca = m_coords[a*m_dim + m_axis];
+      const Real cb = m_coords[b*m_dim + m_axis];
+      return ca < cb || (ca == cb && a < b);
+    }
+
+    const std::vector<Real>& m_coords;
+    const Uint m_dim;
+    const Uint m_axis;
+  };
+}
+
+KdTree::KdTree() :
+  m_dim(0)
+{
+}
+
+void KdTree::build(const std::vector<Real>& coordinates, const Uint dim)
+{
+  if(dim == 0 || coordinates.size() % dim != 0)
+    throw common::BadValue(FromHere(), "Number of coordinates for the k-d tree is not a multiple of the dimension");
+
+  m_dim = dim;
+  const Uint nb_points = coordinates.size() / dim;
+  m_indices.resize(nb_points);
+  for(Uint i = 0; i != nb_points; ++i)
+    m_indices[i] = i;
+
+  m_nodes.clear();
+  m_nodes.reserve(2*(nb_points / detail::kd_leaf_size + 1));
+  m_nodes.push_back(Node(0, nb_points));
+
+  // The splitting reorders m_indices, using the original coordinates
+  m_coordinates = coordinates;
+  split(0, 0);
+
+  // Store the coordinates in the order of the leaves, so a leaf is contiguous in memory
+  for(Uint i = 0; i != nb_points; ++i)
+    std::copy(coordinates.begin() + m_indices[i]*dim, coordinates.begin() + (m_indices[i]+1)*dim, m_coordinates.begin() + i*dim);
+}
+
+void KdTree::split(const Uint node_idx, const Uint level)
+{
+  const Uint begin = m_nodes[node_idx].begin;
+  const Uint end = m_nodes[node_idx].end;
+  if(end - begin <= detail::kd_leaf_size || level > 64)
+    return;
+
+  // Split along the axis with the largest extent
+  Uint axis = 0;
+  Real largest_extent = -1.;
+  for(Uint d = 0; d != m_dim; ++d)
+  {
+    Real min_coord = std::numeric_limits<Real>::max();
+    Real max_coord = -std::numeric_limits<Real>::max();
+    for(Uint i = begin; i != end; ++i)
+    {
+      const Real c = m_coordinates[m_indices[i]*m_dim + d];
+      min_coord = std::min(min_coord, c);
+      max_coord = std::max(max_coord, c);
+    }
+    if(max_coord - min_coord > largest_extent)
+    {
+      largest_extent = max_coord - min_coord;
+      axis = d;
+    }
+  }
+
+  const Uint middle = begin + (end - begin) / 2;
+  std::nth_element(m_indices.begin() + begin, m_indices.begin() + middle, m_indices.begin() + end, detail::KdCoordinateLess(m_coordinates, m_dim, axis));
+
+  const Uint child = m_nodes.size();
+  m_nodes[node_idx].axis = axis;
+  m_nodes[node_idx].split = m_coordinates[m_indices[middle]*m_dim + axis];
+  m_nodes[node_idx].child = child;
+  m_nodes.push_back(Node(begin, middle));
+  m_nodes.push_back(Node(middle, end));
+
+  split(child, level+1);
+  split(child+1, level+1);
+}
+
+Uint KdTree::nearest(const Real* coordinates, Real& squared_distance) const
+{
+  if(m_indices.empty())
+    throw common::SetupError(FromHere(), "Nearest point requested from an empty k-d tree");
+
+  Uint best = std::numeric_limits<Uint>::max();
+  squared_distance = std::numeric_limits<Real>::max();
+  search(0, coordinates, best, squared_distance);
+  return best;
+}
+
+void KdTree::search(const Uint node_idx, const Real* coordinates, Uint& best, Real& best_squared_distance) const
+{
+  const Node& node = m_nodes[node_idx];
+  if(node.child == 0)
+  {
+    for(Uint i = node.begin; i != node.end; ++i)
+    {
+      const Real* point = &m_coordinates[i*m_dim];
+      Real d2 = 0.;
+      for(Uint d = 0; d != m_dim; ++d)
+      {
+        const Real diff = coordinates[d] - point[d];
+        d2 += diff*diff;
+      }
+      const Uint idx = m_indices[i];
+      if(d2 < best_squared_distance || (d2 == best_squared_distance && idx < best))
+      {
+        best_squared_distance = d2;
+        best = idx;
+      }
+    }
+    return;
+  }
+
+  // Visit the side of the splitting plane containing the point first. The other side is only skipped if it is
+  // strictly further away than the best point so far, so ties are still resolved by index.
+  const Real diff = coordinates[node.axis] - node.split;
+  const Uint near_child = diff < 0. ? node.child : node.child+1;
+  const Uint far_child = diff < 0. ? node.child+1 : node.child;
+  search(near_child, coordinates, best, best_squared_distance);
+  if(diff*diff <= best_squared_distance)
+    search(far_child, coordinates, best, best_squared_distance);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
@@ -0,0 +1,87 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_KdTree_hpp
+#define cf3_mesh_KdTree_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include "mesh/LibMesh.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// k-d tree over a fixed set of points, for exact nearest neighbour queries.
+/// The tree is built top-down by splitting the points at the median along the axis with the largest extent.
+/// Nodes are kept in a single flat array, with the two children of a node stored next to each other, and the
+/// point coordinates are copied in the order of the leaves. Queries only read the tree, so they can run concurrently.
+class Mesh_API KdTree
+{
+public:
+  KdTree();
+
+  /// Build the tree. This is O(n log(n)) in the number of points.
+  /// @param coordinates [in] Coordinates of the points, dim values per point. They are copied.
+  /// @param dim [in] Dimension of the points
+  void build(const std::vector<Real>& coordinates, const Uint dim);
+
+  /// Find the point closest to the given coordinates. Among points at the same distance, the one with
+  /// the lowest index is returned, so the result is the same as for a linear search with a strict comparison.
+  /// @param coordinates [in] dim values
+  /// @param squared_distance [out] Squared distance to the returned point
+  /// @return index of the closest point in the coordinates passed to build
+  Uint nearest(const Real* coordinates, Real& squared_distance) const;
+
+  /// Number of points in the tree
+  Uint size() const { return m_indices.size(); }
+
+  /// Dimension of the points
+  Uint dim() const { return m_dim; }
+
+private:
+  /// Split the points between begin and end over the children of node, recursively
+  void split(const Uint node_idx, const Uint level);
+
+  /// Recursive part of the query
+  void search(const Uint node_idx, const Real* coordinates, Uint& best, Real& best_squared_distance) const;
+
+  /// Node of the tree. Leaves have child == 0, which is never a valid child because it is the root.
+  struct Node
+  {
+    Node(const Uint b, const Uint e) : begin(b), end(e), axis(0), split(0.), child(0) {}
+
+    /// Range of the node in m_indices
+    Uint begin;
+    Uint end;
+    /// Splitting plane: points of the first child have a coordinate lower or equal to split along axis, those of the second child higher or equal
+    Uint axis;
+    Real split;
+    /// Index of the first child, the second child follows it
+    Uint child;
+  };
+
+  Uint m_dim;
+  std::vector<Node> m_nodes;
+  /// Original index of the points, in the order of the leaves
+  std::vector<Uint> m_indices;
+  /// Coordinates of the points, in the order of the leaves
+  std::vector<Real> m_coordinates;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_KdTree_hpp
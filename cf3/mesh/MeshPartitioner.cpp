@@ -43,7 +43,8 @@ namespace mesh {
 MeshPartitioner::MeshPartitioner ( const std::string& name ) :
     MeshTransformer(name),
     m_base(0),
-    m_nb_parts(PE::Comm::instance().size())
+    m_nb_parts(PE::Comm::instance().size()),
+    m_has_object_weights(false)
 {
   options().add("nb_parts", m_nb_parts)
       .description("Total number of partitions (e.g. number of processors)")
@@ -151,10 +152,18 @@ void MeshPartitioner::initialize(Mesh& mesh)
   }
 
   Uint tot_nb_owned_elems(0);
+  int has_weights(0);
   boost_foreach( Entities& elements, find_components_recursively<Entities>(mesh) )
   {
     tot_nb_owned_elems += elements.size();
+    if (is_not_null(elements.get_child(Tags::partition_weights())))
+    {
+      cf3_assert(Handle< common::List<Real> >(elements.get_child(Tags::partition_weights()))->size() == elements.size());
+      has_weights = 1;
+    }
   }
+  PE::Comm::instance().all_reduce(PE::max(), &has_weights, 1, &has_weights);
+  m_has_object_weights = has_weights != 0;
 
   Uint tot_nb_owned_obj = tot_nb_owned_nodes + tot_nb_owned_elems;
 
@@ -30,6 +30,7 @@
 #include "mesh/MeshTransformer.hpp"
 #include "mesh/Connectivity.hpp"
 #include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
 
 namespace cf3 {
 namespace mesh {
@@ -101,6 +102,14 @@ public: // functions
   template <typename VectorT>
   void list_of_connected_procs_in_part(const Uint part, VectorT& proc_per_neighbor) const;
 
+  /// True if any of the element components on any process has a list of partition weights
+  bool has_object_weights() const { return m_has_object_weights; }
+
+  /// Weight of each owned object, in the order of list_of_objects_owned_by_part. Nodes have weight 1, elements
+  /// the value in the list of partition weights of their component, or 1 if the component has no such list.
+  template <typename VectorT>
+  void list_of_object_weights_in_part(const Uint part, VectorT& weights) const;
+
 
 public: // functions
 
@@ -155,6 +164,8 @@ private: // data
 
   Uint m_nb_owned_obj;
 
+  bool m_has_object_weights;
+
 
   Handle< common::Map<Uint,Uint> > m_global_to_local;
 
@@ -196,6 +207,34 @@ void MeshPartitioner::list_of_objects_owned_by_part(const Uint part, VectorT& ob
 
 //////////////////////////////////////////////////////////////////////////////
 
+template <typename VectorT>
+void MeshPartitioner::list_of_object_weights_in_part(const Uint part, VectorT& weights) const
+{
+  // declaration for boost::tie
+  Handle< common::Component > comp;
+  Uint loc_idx;
+
+  Uint idx=0;
+  foreach_container((const Uint glb_obj)(const Uint loc_obj),*m_global_to_local)
+  {
+    if (part_of_obj(glb_obj) == part)
+    {
+      boost::tie(comp,loc_idx) = m_lookup->location(loc_obj);
+      if (Handle< Entities > elements = Handle<Entities>(comp))
+      {
+        Handle< common::List<Real> const > element_weights(elements->get_child(Tags::partition_weights()));
+        weights[idx++] = is_null(element_weights) ? 1. : (*element_weights)[loc_idx];
+      }
+      else if(!(glb_obj < m_end_node_per_part[part] && m_periodic_links[loc_idx].first))
+      {
+        weights[idx++] = 1.;
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 template <typename VectorT>
 Uint MeshPartitioner::nb_connected_objects_in_part(const Uint part, VectorT& nb_connections_per_obj) const
 {
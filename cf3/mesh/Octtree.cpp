@@ -4,8 +4,12 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <functional>
+#include <queue>
 #include <set>
 
+#include <boost/cstdint.hpp>
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
 
@@ -45,12 +49,55 @@ namespace mesh {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+  /// Orders element indices by one component of their centroid
+  struct CentroidLess
+  {
+    CentroidLess(const std::vector<Real>& c, const Uint d, const Uint a) : centroids(c), dim(d), axis(a) {}
+    bool operator()(const Uint a, const Uint b) const { return centroids[a*dim+axis] < centroids[b*dim+axis]; }
+    const std::vector<Real>& centroids;
+    const Uint dim;
+    const Uint axis;
+  };
+
+  /// Insert two zero bits between each of the lower 21 bits of x
+  boost::uint64_t spread_bits(boost::uint64_t x)
+  {
+    x &= 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffffull;
+    x = (x | x << 16) & 0x1f0000ff0000ffull;
+    x = (x | x << 8)  & 0x100f00f00f00f00full;
+    x = (x | x << 4)  & 0x10c30c30c30c30c3ull;
+    x = (x | x << 2)  & 0x1249249249249249ull;
+    return x;
+  }
+
+  /// Position of a point along a Morton curve through the given bounding box
+  boost::uint64_t morton_code(const RealMatrix& coordinates, const Uint row, const math::BoundingBox& bounding_box)
+  {
+    static const Real nb_cells = static_cast<Real>(1 << 21);
+    boost::uint64_t result = 0;
+    const Uint dim = std::min(static_cast<Uint>(coordinates.cols()), bounding_box.dim());
+    for(Uint d = 0; d != dim; ++d)
+    {
+      const Real length = bounding_box.max()[d] - bounding_box.min()[d];
+      const Real relative = length > 0. ? (coordinates(row, d) - bounding_box.min()[d]) / length : 0.;
+      const Real cell = std::min(std::max(relative * nb_cells, 0.), nb_cells - 1.);
+      result |= spread_bits(static_cast<boost::uint64_t>(cell)) << d;
+    }
+    return result;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 cf3::common::ComponentBuilder < Octtree, Component, LibMesh > Octtree_Builder;
 
 ////////////////////////////////////////////////////////////////////////////////
 
 Octtree::Octtree( const std::string& name )
-  : Component(name), m_dim(0), m_N(3), m_D(3), m_octtree_idx(3)
+  : Component(name), m_dim(0)
 {
 
   options().add("mesh", m_mesh)
@@ -59,15 +106,9 @@ Octtree::Octtree( const std::string& name )
       .mark_basic()
       .link_to(&m_mesh);
 
-  options().add( "nb_elems_per_cell", 1u )
-      .description("The approximate amount of elements that are stored in a structured cell of the octtree")
+  options().add( "nb_elems_per_cell", 8u )
+      .description("The maximum number of elements that are stored in a leaf of the tree")
       .pretty_name("Number of Elements per Octtree Cell");
-
-  std::vector<Uint> dummy;
-  options().add( "nb_cells", dummy)
-      .description("The number of cells in each direction of the comb. "
-                        "Takes precedence over \"Number of Elements per Octtree Cell\". ")
-      .pretty_name("Number of Cells");
 }
 
 
@@ -82,105 +123,164 @@ void Octtree::create_octtree()
 
   m_dim = m_mesh->dimension();
 
-  std::vector<Real> L(3);
+  m_nodes.clear();
+  m_elements.clear();
+  m_centroids.clear();
 
-  Real V=1;
-  for (Uint d=0; d<m_dim; ++d)
+  // Centroid and bounding box of each element, slightly enlarged so points on the element boundary are not missed
+  std::vector<Real> element_boxes;
+  RealVector centroid(m_dim);
+  boost_foreach (Elements& elements, find_components_recursively_with_filter<Elements>(*m_mesh,IsElementsVolume()))
   {
-    L[d] = m_bounding_box.max()[d] - m_bounding_box.min()[d];
-    V*=L[d];
+    RealMatrix coordinates;
+    elements.geometry_space().allocate_coordinates(coordinates);
+
+    for (Uint elem_idx=0; elem_idx<elements.size(); ++elem_idx)
+    {
+      elements.geometry_space().put_coordinates(coordinates,elem_idx);
+      elements.element_type().compute_centroid(coordinates,centroid);
+      m_elements.push_back(Entity(elements,elem_idx));
+      m_centroids.insert(m_centroids.end(), centroid.data(), centroid.data()+m_dim);
+
+      const Uint box_begin = element_boxes.size();
+      element_boxes.resize(box_begin+6, 0.);
+      Real max_length = 0.;
+      for (Uint d=0; d<m_dim; ++d)
+      {
+        element_boxes[box_begin+d] = coordinates.col(d).minCoeff();
+        element_boxes[box_begin+3+d] = coordinates.col(d).maxCoeff();
+        max_length = std::max(max_length, element_boxes[box_begin+3+d] - element_boxes[box_begin+d]);
+      }
+      const Real tolerance = 1e-8*max_length + 100*math::Consts::eps();
+      for (Uint d=0; d<m_dim; ++d)
+      {
+        element_boxes[box_begin+d] -= tolerance;
+        element_boxes[box_begin+3+d] += tolerance;
+      }
+    }
   }
 
-  const Uint nb_elems = m_mesh->topology().recursive_filtered_elements_count(IsElementsVolume(),true);
+  const Uint nb_elems = m_elements.size();
+  const Uint leaf_size = std::max(1u, options().value<Uint>("nb_elems_per_cell"));
+
+  std::vector<Uint> order(nb_elems);
+  for (Uint i=0; i<nb_elems; ++i)
+    order[i] = i;
 
-  if (options().value<std::vector<Uint> >("nb_cells").size() > 0)
+  m_nodes.reserve(2*(nb_elems/leaf_size+1));
+  m_nodes.push_back(Node());
+  build_node(0, 0, nb_elems, leaf_size, element_boxes, order);
+
+  // Store the elements in the order of the leaves
+  std::vector<Entity> sorted_elements(nb_elems);
+  std::vector<Real> sorted_centroids(nb_elems*m_dim);
+  for (Uint i=0; i<nb_elems; ++i)
   {
-    m_N = options().value<std::vector<Uint> >("nb_cells");
-    for (Uint d=0; d<m_dim; ++d)
-      m_D[d] = (L[d])/static_cast<Real>(m_N[d]);
+    sorted_elements[i] = m_elements[order[i]];
+    std::copy(m_centroids.begin()+order[i]*m_dim, m_centroids.begin()+(order[i]+1)*m_dim, sorted_centroids.begin()+i*m_dim);
   }
-  else
+  m_elements.swap(sorted_elements);
+  m_centroids.swap(sorted_centroids);
+
+  CFdebug << "Octtree: " << m_nodes.size() << " nodes for " << nb_elems << " elements, using " << memory_size() << " bytes" << CFendl;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Octtree::build_node(const Uint node_idx, const Uint begin, const Uint end, const Uint leaf_size, const std::vector<Real>& element_boxes, std::vector<Uint>& order)
+{
+  Node node;
+  node.begin = begin;
+  node.end = end;
+  node.child = 0;
+
+  Real centroid_min[3], centroid_max[3];
+  for (Uint d=0; d<3; ++d)
   {
-    Real V1 = V/nb_elems;
-    Real D1 = std::pow(V1,1./m_dim)*options().value<Uint>("nb_elems_per_cell");
+    node.min[d] = d < m_dim ? real_max() : 0.;
+    node.max[d] = d < m_dim ? -real_max() : 0.;
+    centroid_min[d] = real_max();
+    centroid_max[d] = -real_max();
+  }
 
+  for (Uint i=begin; i<end; ++i)
+  {
+    const Uint elem = order[i];
     for (Uint d=0; d<m_dim; ++d)
     {
-      m_N[d] = (Uint) std::ceil(L[d]/D1);
-      m_D[d] = (L[d])/static_cast<Real>(m_N[d]);
+      node.min[d] = std::min(node.min[d], element_boxes[6*elem+d]);
+      node.max[d] = std::max(node.max[d], element_boxes[6*elem+3+d]);
+      centroid_min[d] = std::min(centroid_min[d], m_centroids[elem*m_dim+d]);
+      centroid_max[d] = std::max(centroid_max[d], m_centroids[elem*m_dim+d]);
     }
   }
 
-  CFdebug << "Octtree:" << CFendl;
-  CFdebug << "--------" << CFendl;
-  for (Uint d=0; d<m_dim; ++d)
+  m_nodes[node_idx] = node;
+
+  if (end - begin <= leaf_size)
+    return;
+
+  // Split along the axis with the largest spread of the centroids
+  Uint axis = 0;
+  for (Uint d=1; d<m_dim; ++d)
   {
-    CFdebug<< PERank << "range["<<d<<"] :   L = " << L[d] << "    N = " << m_N[d] << "    D = " << m_D[d] << "    min = " << m_bounding_box.min()[d] << "    max = " << m_bounding_box.max()[d] << CFendl;
+    if (centroid_max[d] - centroid_min[d] > centroid_max[axis] - centroid_min[axis])
+      axis = d;
   }
-  CFdebug << "V = " << V << CFendl;
+  if (centroid_max[axis] - centroid_min[axis] <= 0.)
+    return;
 
-  // initialize the octtree
-  m_octtree.resize(boost::extents[std::max(Uint(1),m_N[XX])][std::max(Uint(1),m_N[YY])][std::max(Uint(1),m_N[ZZ])]);
+  const Uint middle = begin + (end - begin) / 2;
+  std::nth_element(order.begin()+begin, order.begin()+middle, order.begin()+end, detail::CentroidLess(m_centroids, m_dim, axis));
 
-  RealVector centroid(m_dim);
-  std::vector<Uint> octtree_idx(3);
-  boost_foreach (Elements& elements, find_components_recursively_with_filter<Elements>(*m_mesh,IsElementsVolume()))
-  {
-    Uint nb_nodes_per_element = elements.geometry_space().connectivity().row_size();
-    RealMatrix coordinates;
-    elements.geometry_space().allocate_coordinates(coordinates);
+  const Uint child = m_nodes.size();
+  m_nodes.resize(child+2);
+  m_nodes[node_idx].child = child;
+  build_node(child, begin, middle, leaf_size, element_boxes, order);
+  build_node(child+1, middle, end, leaf_size, element_boxes, order);
+}
 
-    for (Uint elem_idx=0; elem_idx<elements.size(); ++elem_idx)
-    {
-      elements.geometry_space().put_coordinates(coordinates,elem_idx);
-      elements.element_type().compute_centroid(coordinates,centroid);
-      for (Uint d=0; d<m_dim; ++d)
-      {
-        cf3_assert((centroid[d] - m_bounding_box.min()[d])/m_D[d] >= 0);
-        octtree_idx[d]=std::min((Uint) std::floor( (centroid[d] - m_bounding_box.min()[d])/m_D[d]), m_N[d]-1 );
-      }
-      m_octtree[octtree_idx[XX]][octtree_idx[YY]][octtree_idx[ZZ]].push_back(Entity(elements,elem_idx));
-    }
+//////////////////////////////////////////////////////////////////////////////
+
+Uint Octtree::memory_size() const
+{
+  return m_nodes.capacity()*sizeof(Node) + m_elements.capacity()*sizeof(Entity) + m_centroids.capacity()*sizeof(Real);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+bool Octtree::node_contains(const Node& node, const RealVector& coordinate) const
+{
+  for (Uint d=0; d<m_dim; ++d)
+  {
+    if (coordinate[d] < node.min[d] || coordinate[d] > node.max[d])
+      return false;
   }
+  return true;
+}
 
+//////////////////////////////////////////////////////////////////////////////
 
-  // Uint total=0;
-  //
-  // switch (m_dim)
-  // {
-  //   case DIM_2D:
-  //     for (Uint i=0; i<m_N[0]; ++i)
-  //       for (Uint j=0; j<m_N[1]; ++j)
-  //       {
-  //         Uint k=0;
-  //         // CFinfo << "("<<i<<","<<j<<") has elems ";
-  //         // if (m_octtree[i][j][k].size())
-  //         //   CFinfo << mesh::to_vector(m_octtree[i][j][k]).transpose() << CFendl;
-  //         // else
-  //         //   CFinfo << CFendl;
-  //         total += m_octtree[i][j][k].size();
-  //       }
-  //     break;
-  //   case DIM_3D:
-  //     for (Uint i=0; i<m_N[0]; ++i)
-  //       for (Uint j=0; j<m_N[1]; ++j)
-  //         for (Uint k=0; k<m_N[2]; ++k)
-  //         {
-  //           // CFinfo << "("<<i<<","<<j<<","<<k<<") has elems ";
-  //           // if (m_octtree[i][j][k].size())
-  //           //   CFinfo << mesh::to_vector(m_octtree[i][j][k]).transpose() << CFendl;
-  //           // else
-  //           //   CFinfo << CFendl;
-  //           total += m_octtree[i][j][k].size();
-  //         }
-  //     break;
-  //   default:
-  //     break;
-  // }
-  //
-  // CFinfo << "total = " << total << " of " << m_nb_elems << CFendl;
+Real Octtree::node_distance2(const Node& node, const RealVector& coordinate) const
+{
+  Real result = 0.;
+  for (Uint d=0; d<m_dim; ++d)
+  {
+    const Real delta = std::max(std::max(node.min[d] - coordinate[d], coordinate[d] - node.max[d]), 0.);
+    result += delta*delta;
+  }
+  return result;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+
+bool Octtree::is_coord_in_element(const RealVector& coordinate, const Entity& element)
+{
+  cf3_assert(is_not_null(element.comp));
+  element.allocate_coordinates(m_coordinates);
+  element.put_coordinates(m_coordinates);
+  return element.element_type().is_coord_in_element(coordinate,m_coordinates);
+}
 
 //////////////////////////////////////////////////////////////////////////////
 
@@ -271,201 +371,172 @@ void Octtree::find_cell_ranks( const boost::multi_array<Real,2>& coordinates, st
 
 //////////////////////////////////////////////////////////////////////////////
 
-bool Octtree::find_octtree_cell(const RealVector& coordinate, std::vector<Uint>& octtree_idx)
+Entity Octtree::find_element(const RealVector& target_coord)
+{
+  Entity element;
+  find_element(target_coord,element);
+  return element;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Octtree::find_element(const RealVector& target_coord, Entity& element)
 {
-  if (m_octtree.num_elements() == 0)
+  if ( !is_created() )
     create_octtree();
 
-  static const Real tolerance = 100*math::Consts::eps();
-  //CFinfo << "point " << coordinate.transpose() << " ("<<coordinate.size() << ")    dim " << m_dim << CFendl;
-  cf3_assert_desc(common::to_str(coordinate.size())+"=="+common::to_str(m_dim),(coordinate.size() == static_cast<int>(m_dim)));
+  cf3_assert(target_coord.size() <= (long)m_dim);
+  RealVector t_coord(m_dim);
+  t_coord.setZero();
+  for (Uint d=0; d<target_coord.size(); ++d)
+    t_coord[d] = target_coord[d];
 
-  for (Uint d=0; d<m_dim; ++d)
+  // Depth-first traversal of all nodes with a bounding box containing the point
+  m_stack.clear();
+  m_stack.push_back(0);
+  while (!m_stack.empty())
   {
-    if ( (coordinate[d] > m_bounding_box.max()[d] + tolerance) ||
-         (coordinate[d] < m_bounding_box.min()[d] - tolerance) )
+    const Node& node = m_nodes[m_stack.back()];
+    m_stack.pop_back();
+    if (!node_contains(node,t_coord))
+      continue;
+
+    if (node.child == 0)
     {
-      CFdebug << "coord " << coordinate.transpose() << " not found in bounding box" << CFendl;
-      return false; // no index found
+      for (Uint i=node.begin; i<node.end; ++i)
+      {
+        if (is_coord_in_element(t_coord,m_elements[i]))
+        {
+          element = m_elements[i];
+          return true;
+        }
+      }
+    }
+    else
+    {
+      m_stack.push_back(node.child+1);
+      m_stack.push_back(node.child);
     }
-    octtree_idx[d] = std::min((Uint) std::floor( (coordinate[d] - m_bounding_box.min()[d])/m_D[d]), m_N[d]-1 );
   }
 
-  //CFinfo << " should be in box ("<<m_point_idx[0]<<","<<m_point_idx[1]<<","<<m_point_idx[2]<<")" << CFendl;
-  return true;
+  // if arrived here, it means no element contains the point. Give up.
+  element = Entity();
+  CFdebug << "coord";
+  for(Uint i = 0; i != m_dim; ++i)
+  {
+    CFdebug << " " << common::to_str(t_coord[i]);
+  }
+  CFdebug << " has not been found in the octtree" << CFendl;
+  return false;
 }
 
-//////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
 
-void Octtree::gather_elements_around_idx(const std::vector<Uint>& octtree_idx, const Uint ring, std::vector<Entity>& elements)
+Uint Octtree::find_elements(const RealMatrix& coordinates, std::vector<Entity>& elements)
 {
-  int i(0), j(0), k(0);
-  int imin, jmin, kmin;
-  int imax, jmax, kmax;
-
-  int irmin, jrmin, krmin;
-  int irmax, jrmax, krmax;
+  if ( !is_created() )
+    create_octtree();
 
-  if (ring == 0)
+  cf3_assert(coordinates.cols() <= (long)m_dim);
+  const Uint nb_points = coordinates.rows();
+  elements.assign(nb_points, Entity());
+
+  // Process the points along a space-filling curve
+  std::vector< std::pair<boost::uint64_t, Uint> > points_order(nb_points);
+  for (Uint i=0; i<nb_points; ++i)
+    points_order[i] = std::make_pair(detail::morton_code(coordinates, i, m_bounding_box), i);
+  std::sort(points_order.begin(), points_order.end());
+
+  Uint nb_found = 0;
+  Entity last_found;
+  RealVector point(m_dim);
+  point.setZero();
+  for (Uint i=0; i<nb_points; ++i)
   {
-    boost_foreach(const Entity& element, m_octtree[octtree_idx[XX]][octtree_idx[YY]][octtree_idx[ZZ]])
+    const Uint point_idx = points_order[i].second;
+    for (Uint d=0; d<coordinates.cols(); ++d)
+      point[d] = coordinates(point_idx, d);
+
+    // Consecutive points are often in the same element
+    if (is_not_null(last_found.comp) && is_coord_in_element(point,last_found))
     {
-      cf3_assert(element.comp);
-      elements.push_back(element);
+      elements[point_idx] = last_found;
+      ++nb_found;
     }
-    return;
-  }
-  else
-  {
-    switch (m_dim)
+    else if (find_element(point,elements[point_idx]))
     {
-      case DIM_3D:
-      irmin = int(octtree_idx[XX])-int(ring);  irmax = int(octtree_idx[XX])+int(ring);
-      jrmin = int(octtree_idx[YY])-int(ring);  jrmax = int(octtree_idx[YY])+int(ring);
-      krmin = int(octtree_idx[ZZ])-int(ring);  krmax = int(octtree_idx[ZZ])+int(ring);
-
-      imin = std::max(irmin, 0);  imax = std::min(irmax,int(m_N[XX])-1);
-      jmin = std::max(jrmin, 0);  jmax = std::min(jrmax,int(m_N[YY])-1);
-      kmin = std::max(krmin, 0);  kmax = std::min(krmax,int(m_N[ZZ])-1);
-
-        // imin:
-        i = imin;
-        for (i = imin; i <= imax; ++i)
-        {
-          for (j = jmin; j <= jmax; ++j)
-          {
-            for (k = kmin; k <= kmax; ++k)
-            {
-              if ( i == irmin || i == irmax || j == jrmin || j == jrmax || k == krmin || k == krmax)
-              {
-                boost_foreach(const Entity& element, m_octtree[i][j][k])
-                {
-                  cf3_assert(element.comp);
-                  elements.push_back(element);
-                }
-              }
-            }
-          }
-        }
-
-        break;
-      case DIM_2D:
-
-        irmin = int(octtree_idx[XX])-int(ring);  irmax = int(octtree_idx[XX])+int(ring);
-        jrmin = int(octtree_idx[YY])-int(ring);  jrmax = int(octtree_idx[YY])+int(ring);
-
-        imin = std::max(irmin, 0);  imax = std::min(irmax,int(m_N[XX])-1);
-        jmin = std::max(jrmin, 0);  jmax = std::min(jrmax,int(m_N[YY])-1);
-
-        for (i = imin; i <= imax; ++i)
-        {
-          for (j = jmin; j <= jmax; ++j)
-          {
-            if ( i == irmin || i == irmax || j == jrmin || j == jrmax )
-            {
-              boost_foreach(const Entity& element, m_octtree[i][j][k])
-              {
-                cf3_assert(element.comp);
-                elements.push_back(element);
-              }
-            }
-          }
-        }
-
-        break;
-
-      case DIM_1D:
-        irmin = int(octtree_idx[XX])-int(ring);  irmax = int(octtree_idx[XX])+int(ring);
-        imin = std::max(int(octtree_idx[XX])-int(ring), 0);  imax = std::min(int(octtree_idx[XX])+int(ring),int(m_N[XX])-1);
-
-        for (i = imin; i <= imax; ++i)
-        {
-          if ( i == irmin || i == irmax)
-          {
-            boost_foreach(const Entity& element, m_octtree[i][j][k])
-            {
-              cf3_assert(element.comp);
-              elements.push_back(element);
-            }
-          }
-        }
-
-
-        break;
+      last_found = elements[point_idx];
+      ++nb_found;
     }
   }
 
-
-  //CFinfo << m_pointcloud.size() << " points in the pointcloud " << CFendl;
-
-}
-
-//////////////////////////////////////////////////////////////////////////////
-
-Entity Octtree::find_element(const RealVector& target_coord)
-{
-  Entity element;
-  find_element(target_coord,element);
-  return element;
+  return nb_found;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool Octtree::find_element(const RealVector& target_coord, Entity& element)
+void Octtree::find_nearest_elements(const RealVector& coordinate, const Uint nb_elems, std::vector<Entity>& elements)
 {
   if ( !is_created() )
     create_octtree();
 
-  cf3_assert(target_coord.size() <= (long)m_dim);
-  RealVector t_coord(m_dim);
-  for (Uint d=0; d<target_coord.size(); ++d)
-    t_coord[d] = target_coord[d];
+  elements.clear();
+  if (nb_elems == 0 || m_elements.empty())
+    return;
+
+  cf3_assert(coordinate.size() == (long)m_dim);
 
-  for (Uint t=0; t<target_coord.size(); ++t)
+  // Best-first traversal: nodes are visited by increasing distance, until they are further than the furthest element found
+  typedef std::pair<Real,Uint> DistanceT;
+  std::priority_queue< DistanceT, std::vector<DistanceT>, std::greater<DistanceT> > nodes;
+  // Max-heap with the closest elements found so far
+  std::vector<DistanceT> nearest;
+  nearest.reserve(nb_elems);
 
-  if (find_octtree_cell(t_coord,m_octtree_idx))
+  nodes.push(std::make_pair(node_distance2(m_nodes[0],coordinate), 0u));
+  while (!nodes.empty())
   {
-    m_elements_pool.clear();
-    Uint pool_size = 0;
-    Uint rings=0;
-    for ( ; pool_size==0 ; ++rings)
+    const DistanceT closest_node = nodes.top();
+    nodes.pop();
+    if (nearest.size() == nb_elems && closest_node.first > nearest.front().first)
+      break;
+
+    const Node& node = m_nodes[closest_node.second];
+    if (node.child == 0)
     {
-      pool_size=m_elements_pool.size();
-      gather_elements_around_idx(m_octtree_idx,rings,m_elements_pool);
-      boost_foreach(const Entity& pool_elem, boost::make_iterator_range(m_elements_pool.begin()+pool_size,m_elements_pool.end()))
+      for (Uint i=node.begin; i<node.end; ++i)
       {
-        cf3_assert(is_not_null(pool_elem.comp));
-        const RealMatrix elem_coordinates = pool_elem.get_coordinates();
-        if (pool_elem.element_type().is_coord_in_element(t_coord,elem_coordinates))
+        Real distance2 = 0.;
+        for (Uint d=0; d<m_dim; ++d)
         {
-          element = pool_elem;
-          return true;
+          const Real delta = m_centroids[i*m_dim+d] - coordinate[d];
+          distance2 += delta*delta;
+        }
+        const DistanceT candidate(distance2, i);
+        if (nearest.size() < nb_elems)
+        {
+          nearest.push_back(candidate);
+          std::push_heap(nearest.begin(), nearest.end());
+        }
+        else if (candidate < nearest.front())
+        {
+          std::pop_heap(nearest.begin(), nearest.end());
+          nearest.back() = candidate;
+          std::push_heap(nearest.begin(), nearest.end());
         }
       }
     }
-    // if arrived here, keep searching
-    // it means no element has been found. The search is enlarged with one more ring, for possible misses.
-    gather_elements_around_idx(m_octtree_idx,rings,m_elements_pool);
-    boost_foreach(const Entity& pool_elem, boost::make_iterator_range(m_elements_pool.begin()+pool_size,m_elements_pool.end()))
+    else
     {
-      cf3_assert(is_not_null(pool_elem.comp));
-      const RealMatrix elem_coordinates = pool_elem.get_coordinates();
-      if (pool_elem.element_type().is_coord_in_element(t_coord,elem_coordinates))
-      {
-        element = pool_elem;
-        return true;
-      }
+      nodes.push(std::make_pair(node_distance2(m_nodes[node.child],coordinate), node.child));
+      nodes.push(std::make_pair(node_distance2(m_nodes[node.child+1],coordinate), node.child+1));
     }
   }
-  // if arrived here, it means no element has been found in the octtree cell. Give up.
-  element = Entity();
-  CFdebug << "coord";
-  for(Uint i = 0; i != m_dim; ++i)
-  {
-    CFdebug << " " << common::to_str(t_coord[i]);
-  }
-  CFdebug << " has not been found in the octtree cell" << CFendl;
-  return false;
+
+  std::sort_heap(nearest.begin(), nearest.end());
+  elements.reserve(nearest.size());
+  boost_foreach(const DistanceT& near_elem, nearest)
+    elements.push_back(m_elements[near_elem.second]);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
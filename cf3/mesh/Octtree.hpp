@@ -26,17 +26,14 @@ namespace mesh {
 
 //////////////////////////////////////////////////////////////////////////////
 
-/// This class defines neutral mesh format reader
+/// Search tree for the volume elements of a mesh, used to locate points and to find neighbouring elements.
+/// Despite the name, this is a bounding volume hierarchy: a binary tree built top-down by splitting the element
+/// centroids at the median along the longest axis, so the depth stays logarithmic regardless of the grading of the mesh.
+/// Each node stores the bounding box of the elements below it. Nodes are kept in a single flat array, with the
+/// two children of a node stored next to each other.
 /// @author Willem Deconinck
 class Mesh_API Octtree : public common::Component
 {
-
-private: // typedefs
-
-  typedef std::pair<const Elements*,Uint> Point;
-  typedef boost::multi_array<std::vector<Entity> ,3> ArrayT;
-  typedef std::vector<const Point*> Pointcloud;
-
 public: // functions
   /// constructor
   Octtree( const std::string& name );
@@ -44,6 +41,7 @@ public: // functions
   /// Gets the Class name
   static std::string type_name() { return "Octtree"; }
 
+  /// Build the tree. This is O(n log(n)) in the number of volume elements.
   void create_octtree();
 
   /// @brief Find which element contains a given coordinate
@@ -55,39 +53,80 @@ public: // functions
   /// @return if element was found
   virtual bool find_element(const RealVector& target_coord, Entity& element);
 
-  /// Given a coordinate, find which box in the octtree it is located in
-  /// @param coordinate  [in]  The coordinate to look for
-  /// @param octtree_idx [out] location of the box (i,j,k) in which the coordinate sits
-  /// @return true if the coordinate is found inside the honeycomb
-  bool find_octtree_cell(const RealVector& coordinate, std::vector<Uint>& octtree_idx);
+  /// Find the elements containing a batch of points. The points are processed in spatial order,
+  /// so consecutive searches visit the same part of the tree.
+  /// @param coordinates [in] One point per row
+  /// @param elements [out] The element containing each point, or an Entity with a null comp if the point was not found
+  /// @return the number of points that were found
+  Uint find_elements(const RealMatrix& coordinates, std::vector<Entity>& elements);
 
-  /// Assemble the elements in and around a given octtree_idx (i,j,k)
-  /// It is assumed that first "find_comb_idx(coordinate)" is called
-  /// @param octtree_idx [in] the minimum number of points in the point cloud
-  /// @param ring        [in] the ring of indexes around octtree_idx to look for elements. Elements inside the ring are not looked for, only the ring itself.
-  /// @param unified_elems [out] the elements are pushed back in this vector. Nothing gets erased, it only grows.
-  /// @note subsequent calls with increasing value for ring starting from 0, will assemble everything within the last passed ring value.
-  void gather_elements_around_idx(const std::vector<Uint>& octtree_idx, const Uint ring, std::vector<Entity>& element_pool);
+  /// Find the elements with the centroids closest to the given coordinate
+  /// @param coordinate [in] The point to search around
+  /// @param nb_elems [in] Number of elements to find. Less elements are returned if the mesh is smaller.
+  /// @param elements [out] The elements, sorted by increasing distance. The vector is cleared first.
+  void find_nearest_elements(const RealVector& coordinate, const Uint nb_elems, std::vector<Entity>& elements);
 
   void find_cell_ranks( const boost::multi_array<Real,2>& coordinates, std::vector<Uint>& ranks );
 
-  bool is_created() const { return m_octtree.num_elements()!=0; }
+  bool is_created() const { return !m_nodes.empty(); }
 
   const Uint dimension() { return m_dim; }
 
+  /// Bounding box of the mesh
+  const math::BoundingBox& bounding_box() const { return m_bounding_box; }
+
+  /// Number of nodes in the tree
+  Uint nb_nodes() const { return m_nodes.size(); }
+
+  /// Memory used by the tree, in bytes
+  Uint memory_size() const;
+
+private: // functions
+
+  /// Split the elements between begin and end over the children of node, recursively
+  /// @param element_boxes Bounding box for each element, as 3 minimum coordinates followed by 3 maximum coordinates
+  /// @param order Permutation of the elements, reordered so each node covers a contiguous range
+  void build_node(const Uint node_idx, const Uint begin, const Uint end, const Uint leaf_size, const std::vector<Real>& element_boxes, std::vector<Uint>& order);
+
+  /// Check if the given point is in the given element
+  bool is_coord_in_element(const RealVector& coordinate, const Entity& element);
+
 private: // data
 
-  ArrayT m_octtree;
+  /// Node of the tree. Leaves have child == 0, which is never a valid child because it is the root.
+  struct Node
+  {
+    Real min[3];
+    Real max[3];
+    /// Range of the node in m_elements
+    Uint begin;
+    Uint end;
+    /// Index of the first child, the second child follows it
+    Uint child;
+  };
+
+  /// Check if a point is inside the bounding box of a node
+  bool node_contains(const Node& node, const RealVector& coordinate) const;
+
+  /// Squared distance from a point to the bounding box of a node
+  Real node_distance2(const Node& node, const RealVector& coordinate) const;
+
+  std::vector<Node> m_nodes;
+
+  /// Elements, in the order of the leaves
+  std::vector<Entity> m_elements;
+
+  /// Centroids of m_elements, stored contiguously with m_dim components each
+  std::vector<Real> m_centroids;
 
   Uint m_dim;
-  std::vector<Uint> m_N;
-  std::vector<Real> m_D;
 
   Handle<Mesh> m_mesh;
 
-  std::vector<Uint> m_octtree_idx;
+  /// Stack for the tree traversal
+  std::vector<Uint> m_stack;
 
-  std::vector<Entity> m_elements_pool;
+  RealMatrix m_coordinates;
 
   math::BoundingBox m_bounding_box;
 
@@ -0,0 +1,215 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <limits>
+
+#include "common/Builder.hpp"
+#include "common/Foreach.hpp"
+#include "common/Log.hpp"
+#include "common/StringConversion.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/LibMesh.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/PointLocator.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+
+//////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < PointLocator, common::Component, LibMesh > PointLocator_Builder;
+
+//////////////////////////////////////////////////////////////////////////////
+
+PointLocator::PointLocator(const std::string& name) :
+  common::Component(name),
+  m_dim(0)
+{
+}
+
+void PointLocator::build(const Mesh& mesh)
+{
+  const Field& coords = mesh.geometry_fields().coordinates();
+  const Uint dim = coords.row_size();
+  const Uint nb_nodes = coords.size();
+
+  std::vector<Real> local_box(2*dim);
+  std::fill(local_box.begin(), local_box.begin() + dim, std::numeric_limits<Real>::max());
+  std::fill(local_box.begin() + dim, local_box.end(), -std::numeric_limits<Real>::max());
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    for(Uint d = 0; d != dim; ++d)
+    {
+      local_box[d] = std::min(local_box[d], coords[i][d]);
+      local_box[dim+d] = std::max(local_box[dim+d], coords[i][d]);
+    }
+  }
+
+  common::PE::Comm& comm = common::PE::Comm::instance();
+  if(comm.is_active() && comm.size() > 1)
+  {
+    m_boxes.resize(2*dim*comm.size());
+    comm.all_gather(&local_box[0], 2*dim, &m_boxes[0]);
+  }
+  else
+  {
+    m_boxes = local_box;
+  }
+
+  // Enlarge the boxes, so points on the boundary of a box are not missed because of roundoff
+  const Uint nb_boxes = m_boxes.size() / (2*dim);
+  Real extent = 0.;
+  for(Uint d = 0; d != dim; ++d)
+  {
+    Real global_min = std::numeric_limits<Real>::max();
+    Real global_max = -std::numeric_limits<Real>::max();
+    for(Uint rank = 0; rank != nb_boxes; ++rank)
+    {
+      global_min = std::min(global_min, m_boxes[2*dim*rank + d]);
+      global_max = std::max(global_max, m_boxes[2*dim*rank + dim + d]);
+    }
+    extent = std::max(extent, global_max - global_min);
+  }
+  const Real tolerance = 1e-8*extent;
+  for(Uint rank = 0; rank != nb_boxes; ++rank)
+  {
+    for(Uint d = 0; d != dim; ++d)
+    {
+      m_boxes[2*dim*rank + d] -= tolerance;
+      m_boxes[2*dim*rank + dim + d] += tolerance;
+    }
+  }
+
+  m_dim = dim;
+}
+
+void PointLocator::candidate_ranks(const Real* coordinate, std::vector<Uint>& ranks) const
+{
+  cf3_assert(is_built());
+  ranks.clear();
+  const Uint nb_boxes = m_boxes.size() / (2*m_dim);
+  if(nb_boxes < 2)
+    return;
+
+  const Uint my_rank = common::PE::Comm::instance().rank();
+  for(Uint rank = 0; rank != nb_boxes; ++rank)
+  {
+    if(rank == my_rank)
+      continue;
+    const Real* box = &m_boxes[2*m_dim*rank];
+    bool inside = true;
+    for(Uint d = 0; d != m_dim && inside; ++d)
+      inside = coordinate[d] >= box[d] && coordinate[d] <= box[m_dim+d];
+    if(inside)
+      ranks.push_back(rank);
+  }
+}
+
+void PointLocator::route(const std::vector<Real>& coordinates, std::vector< std::vector<Uint> >& sent_points, std::vector< std::vector<Real> >& received_coordinates) const
+{
+  if(!is_built())
+    throw common::SetupError(FromHere(), "PointLocator " + uri().path() + " was not built");
+  if(coordinates.size() % m_dim != 0)
+    throw common::BadValue(FromHere(), "Number of coordinates to route is not a multiple of the dimension " + common::to_str(m_dim));
+
+  const Uint nb_ranks = m_boxes.size() / (2*m_dim);
+  sent_points.assign(nb_ranks, std::vector<Uint>());
+  received_coordinates.assign(nb_ranks, std::vector<Real>());
+  if(nb_ranks < 2)
+    return;
+
+  std::vector< std::vector<Real> > send_coordinates(nb_ranks);
+  std::vector<Uint> ranks;
+  const Uint nb_points = coordinates.size() / m_dim;
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    const Real* coordinate = &coordinates[i*m_dim];
+    candidate_ranks(coordinate, ranks);
+    BOOST_FOREACH(const Uint rank, ranks)
+    {
+      sent_points[rank].push_back(i);
+      send_coordinates[rank].insert(send_coordinates[rank].end(), coordinate, coordinate + m_dim);
+    }
+  }
+
+  common::PE::Comm::instance().sparse_all_to_all(send_coordinates, received_coordinates);
+}
+
+void PointLocator::evaluate(const std::vector<Real>& coordinates, const Uint result_size, const EvaluatorT& evaluator, std::vector<Real>& results, std::vector<int>& found_ranks) const
+{
+  std::vector< std::vector<Uint> > sent_points;
+  std::vector< std::vector<Real> > received_coordinates;
+  route(coordinates, sent_points, received_coordinates);
+
+  const Uint nb_points = coordinates.size() / m_dim;
+  found_ranks.assign(nb_points, -1);
+  if(results.size() < nb_points*result_size)
+    results.resize(nb_points*result_size, 0.);
+
+  const Uint nb_ranks = sent_points.size();
+  if(nb_ranks < 2)
+    return;
+
+  // Each answer is a found flag followed by the result
+  const Uint answer_size = result_size + 1;
+  std::vector< std::vector<Real> > send_answers(nb_ranks);
+  RealVector coordinate(m_dim);
+  for(Uint rank = 0; rank != nb_ranks; ++rank)
+  {
+    const std::vector<Real>& rank_coordinates = received_coordinates[rank];
+    const Uint nb_received = rank_coordinates.size() / m_dim;
+    send_answers[rank].assign(nb_received*answer_size, 0.);
+    for(Uint i = 0; i != nb_received; ++i)
+    {
+      for(Uint d = 0; d != m_dim; ++d)
+        coordinate[d] = rank_coordinates[i*m_dim + d];
+      Real* answer = &send_answers[rank][i*answer_size];
+      answer[0] = evaluator(coordinate, answer + 1) ? 1. : 0.;
+    }
+  }
+
+  std::vector< std::vector<Real> > recv_answers;
+  common::PE::Comm::instance().sparse_all_to_all(send_answers, recv_answers);
+
+  // Ranks are visited in order, so the lowest rank that found a point provides its result
+  for(Uint rank = 0; rank != nb_ranks; ++rank)
+  {
+    const std::vector<Uint>& rank_points = sent_points[rank];
+    cf3_assert(recv_answers[rank].size() == rank_points.size()*answer_size);
+    for(Uint i = 0; i != rank_points.size(); ++i)
+    {
+      const Real* answer = &recv_answers[rank][i*answer_size];
+      const Uint point_idx = rank_points[i];
+      if(answer[0] == 0. || found_ranks[point_idx] >= 0)
+        continue;
+      found_ranks[point_idx] = rank;
+      std::copy(answer + 1, answer + answer_size, results.begin() + point_idx*result_size);
+    }
+  }
+}
+
+PointLocator& point_locator(Mesh& mesh)
+{
+  Handle<PointLocator> locator(mesh.get_child("point_locator"));
+  if(is_null(locator))
+  {
+    locator = mesh.create_component<PointLocator>("point_locator");
+    locator->build(mesh);
+  }
+  return *locator;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
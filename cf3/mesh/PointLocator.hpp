@@ -0,0 +1,85 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_PointLocator_hpp
+#define cf3_mesh_PointLocator_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/function.hpp>
+
+#include "common/Component.hpp"
+
+#include "math/MatrixTypes.hpp"
+
+#include "mesh/LibMesh.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+
+  class Mesh;
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// Routes points to the ranks whose part of a mesh may contain them, for parallel point location and interpolation.
+/// The bounding boxes of the local meshes of all ranks are exchanged once, when the locator is built. Each point
+/// is then only sent to the other ranks whose box contains it, with a sparse all-to-all exchange, and the answers
+/// come back in a second exchange. The locator of a mesh is stored as its child "point_locator", see point_locator().
+class Mesh_API PointLocator : public common::Component
+{
+public:
+  /// Called on the receiving rank for each point: fills the result and returns true if the point was found
+  typedef boost::function<bool (const RealVector& coordinate, Real* result)> EvaluatorT;
+
+  PointLocator(const std::string& name);
+
+  static std::string type_name() { return "PointLocator"; }
+
+  /// Exchange the bounding boxes of the local part of the mesh. Collective.
+  void build(const Mesh& mesh);
+
+  /// True if build was called
+  bool is_built() const { return m_dim != 0; }
+
+  /// Dimension of the boxes
+  Uint dim() const { return m_dim; }
+
+  /// Get the ranks other than this one whose bounding box contains the point
+  void candidate_ranks(const Real* coordinate, std::vector<Uint>& ranks) const;
+
+  /// Send each point to the candidate ranks. Collective.
+  /// @param coordinates [in] dim values per point
+  /// @param sent_points [out] for each rank, the indices of the points that were sent to it
+  /// @param received_coordinates [out] for each rank, the coordinates received from it, dim values per point
+  void route(const std::vector<Real>& coordinates, std::vector< std::vector<Uint> >& sent_points, std::vector< std::vector<Real> >& received_coordinates) const;
+
+  /// Evaluate each point on the candidate ranks and collect the results. Collective.
+  /// @param coordinates [in] dim values per point
+  /// @param result_size [in] number of values in a result
+  /// @param evaluator [in] called on the candidate ranks for each point they receive
+  /// @param results [out] result_size values per point, from the lowest rank that found it. Unchanged for points that were not found.
+  /// @param found_ranks [out] rank that found each point, or -1 if the point was not found on any other rank
+  void evaluate(const std::vector<Real>& coordinates, const Uint result_size, const EvaluatorT& evaluator, std::vector<Real>& results, std::vector<int>& found_ranks) const;
+
+private:
+  Uint m_dim;
+  /// Minimum coordinates followed by maximum coordinates, for each rank, enlarged with a tolerance
+  std::vector<Real> m_boxes;
+};
+
+/// Get the point locator of a mesh, building it on first use. Collective when it is built.
+Mesh_API PointLocator& point_locator(Mesh& mesh);
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_PointLocator_hpp
@@ -39,7 +39,7 @@ cf3::common::ComponentBuilder < StencilComputerOcttree, StencilComputer, LibMesh
 //////////////////////////////////////////////////////////////////////////////
 
 StencilComputerOcttree::StencilComputerOcttree( const std::string& name )
-  : StencilComputer(name), m_dim(0), m_nb_elems_in_mesh(0)
+  : StencilComputer(name), m_dim(0)
 {
   options().option("dict").attach_trigger( boost::bind( &StencilComputerOcttree::configure_octtree, this ) );
 }
@@ -52,10 +52,8 @@ void StencilComputerOcttree::configure_octtree()
   if (is_null(mesh))
     throw SetupError(FromHere(),"Mesh was not found as parent of "+m_dict->uri().string());
 
-  m_nb_elems_in_mesh = mesh->topology().recursive_filtered_elements_count(IsElementsVolume(),true);
   m_dim = m_dict->coordinates().row_size();
   m_centroid.resize(m_dim);
-  m_octtree_cell.resize(3);
 
   if (Handle<Component> found = mesh->get_child("octtree"))
     m_octtree = Handle<Octtree>(found);
@@ -73,16 +71,7 @@ void StencilComputerOcttree::compute_stencil(const SpaceElem& element, std::vect
   cf3_assert(m_octtree);
   RealMatrix coordinates = element.comp->support().geometry_space().get_coordinates(element.idx);
   element.comp->support().element_type().compute_centroid(coordinates,m_centroid);
-  m_stencil.resize(0);
-  if (m_octtree->find_octtree_cell(m_centroid,m_octtree_cell))
-  {
-    for (Uint ring=0; m_stencil.size() < m_min_stencil_size; ++ring)
-    {
-      m_octtree->gather_elements_around_idx(m_octtree_cell,ring,m_stencil);
-      if (m_stencil.size() >= m_nb_elems_in_mesh )
-        break;
-    }
-  }
+  m_octtree->find_nearest_elements(m_centroid,m_min_stencil_size,m_stencil);
   stencil.resize(m_stencil.size());
   for (Uint e=0; e<stencil.size(); ++e)
   {
@@ -23,7 +23,7 @@ namespace mesh {
 
 //////////////////////////////////////////////////////////////////////////////
 
-/// This class defines neutral mesh format reader
+/// Computes a stencil made of the elements with the centroids closest to the centroid of the given element
 /// @author Willem Deconinck
 class Mesh_API StencilComputerOcttree : public StencilComputer {
 
@@ -45,9 +45,7 @@ private: // data
   Handle<Octtree> m_octtree;
   
   Uint m_dim;
-  Uint m_nb_elems_in_mesh;
 
-  std::vector<Uint> m_octtree_cell;
   RealVector m_centroid;
 
   std::vector<Entity> m_stencil;
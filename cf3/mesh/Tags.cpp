@@ -38,6 +38,9 @@ const char * Tags::bdry_faces ()  { return "bdry_faces"; }
 
 const char * Tags::connectivity_table () { return "connectivity_table"; }
 
+const char * Tags::partition_weights () { return "partition_weights"; }
+const char * Tags::measured_cost () { return "measured_cost"; }
+
 const char * Tags::event_mesh_loaded() { return "mesh_loaded"; }
 const char * Tags::event_mesh_changed() { return "mesh_changed"; }
 
@@ -50,6 +50,12 @@ public:
 
   static const char * connectivity_table ();
 
+  /// Name of the optional list of per-element weights used by the MeshPartitioner
+  static const char * partition_weights ();
+
+  /// Name of the Entities property with the measured time spent on the elements, used for load balancing
+  static const char * measured_cost ();
+
   static const char * event_mesh_loaded();
   static const char * event_mesh_changed();
 
@@ -8,6 +8,8 @@
 #include <set>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
 #include "common/BoostAssign.hpp"
 #include <boost/cstdint.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
@@ -18,6 +20,7 @@
 #include "common/BoostFilesystem.hpp"
 #include "common/Foreach.hpp"
 #include "common/Log.hpp"
+#include "common/OutputThread.hpp"
 #include "common/PE/Comm.hpp"
 #include "common/OptionList.hpp"
 #include "common/OptionT.hpp"
@@ -137,6 +140,20 @@ namespace detail
       m_current_block.write(reinterpret_cast<const char*>(&value), m_wordsize);
     }
 
+    /// Compress a complete array of raw bytes and append it to the stream
+    void append_array(const std::string& data)
+    {
+      start_array(data.size(), 1);
+      Uint begin = 0;
+      for(; data.size() - begin > m_header.blocksize; begin += m_header.blocksize)
+      {
+        m_current_block.write(data.data() + begin, m_header.blocksize);
+        compress_block();
+      }
+      m_current_block.write(data.data() + begin, data.size() - begin);
+      finish_array();
+    }
+
     // Offset to put in the VTK XML (= offset after the _)
     Uint offset()
     {
@@ -173,6 +190,105 @@ namespace detail
     std::stringstream data_stream;
   };
 
+  /// Raw data for one appended DataArray
+  struct StagedArray
+  {
+    /// The DataArray node, which gets the offset attribute when the data is compressed
+    XmlNode node;
+    std::string data;
+  };
+
+  /// Destination of the appended arrays. When a CompressedStream is given, the data is compressed as it is appended.
+  /// Otherwise a copy of the data for all arrays is collected, so compression and writing can be done later on.
+  struct AppendedData
+  {
+    explicit AppendedData(CompressedStream* stream = 0) :
+      m_stream(stream)
+    {
+    }
+
+    /// Start writing a new array
+    void start_array(XmlNode node, const Uint nb_elems, const Uint wordsize)
+    {
+      if(m_stream)
+      {
+        node.set_attribute("offset", to_str(m_stream->offset()));
+        m_stream->start_array(nb_elems, wordsize);
+        return;
+      }
+
+      m_wordsize = wordsize;
+      m_nb_bytes = nb_elems * wordsize;
+      arrays.push_back(StagedArray());
+      arrays.back().node = node;
+      arrays.back().data.reserve(m_nb_bytes);
+    }
+
+    /// Finish writing the current array
+    void finish_array()
+    {
+      if(m_stream)
+        m_stream->finish_array();
+      else
+        cf3_assert(arrays.back().data.size() == m_nb_bytes);
+    }
+
+    /// Append a value to the current array
+    template<typename ValueT>
+    void push_back(const ValueT& value)
+    {
+      if(m_stream)
+        m_stream->push_back(value);
+      else
+        arrays.back().data.append(reinterpret_cast<const char*>(&value), m_wordsize);
+    }
+
+    std::vector<StagedArray> arrays;
+
+  private:
+    CompressedStream* m_stream;
+    Uint m_wordsize;
+    Uint m_nb_bytes;
+  };
+
+  /// Write the VTU file, inserting the compressed data at the end
+  void write_vtu_file(const XmlDoc& doc, CompressedStream& appended_data, const std::string& path)
+  {
+    boost::filesystem::fstream fout(path, std::ios_base::out | std::ios_base::binary);
+
+    // Remove the closing tag
+    std::string xml_string;
+    to_string(doc, xml_string);
+    boost::algorithm::erase_last(xml_string, "</VTKFile>");
+    boost::algorithm::trim_right(xml_string);
+
+    // Write XML meta data
+    fout << xml_string;
+
+    // Append  compressed data
+    fout << "\n<AppendedData encoding=\"raw\">\n";
+    fout << appended_data.data_stream.rdbuf();
+    fout << "\n</AppendedData>\n</VTKFile>\n";
+
+    fout.close();
+  }
+
+  /// Compress the staged data, complete the offsets in the XML and write the VTU file.
+  /// Executed on the OutputThread for asynchronous writing, so it only uses its arguments.
+  void write_staged_vtu(const boost::shared_ptr<XmlDoc>& doc, const boost::shared_ptr<AppendedData>& staged_data, const std::string& path)
+  {
+    CompressedStream appended_data;
+    boost_foreach(StagedArray& array, staged_data->arrays)
+    {
+      array.node.set_attribute("offset", to_str(appended_data.offset()));
+      appended_data.append_array(array.data);
+      // Release the uncompressed copy as soon as possible
+      std::string().swap(array.data);
+    }
+
+    write_vtu_file(*doc, appended_data, path);
+  }
+
   // Recursively transform nodes to their parallel counterparts
   void make_pvtu(XmlNode& node)
   {
@@ -211,6 +327,10 @@ Writer::Writer( const std::string& name )
       .pretty_name("Dictionary")
       .description("Dictionary used to get the node coordinates and continuous fields")
       .link_to(&m_dictionary);
+
+    options().add("asynchronous", false)
+      .pretty_name("Asynchronous")
+      .description("Copy the data and leave compressing and writing the file to the output thread");
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -233,12 +353,12 @@ void Writer::write()
   const std::string basename = my_path.base_name();
   my_path = my_dir / (basename + "_P" + to_str(PE::Comm::instance().rank()) + ".vtu");
 
-  XmlDoc doc("1.0", "ISO-8859-1");
+  boost::shared_ptr<XmlDoc> doc(new XmlDoc("1.0", "ISO-8859-1"));
   
   const mesh::Dictionary& dict = is_null(m_dictionary) ? m_mesh->geometry_fields() : *m_dictionary;
 
   // Root node
-  XmlNode vtkfile = doc.add_node("VTKFile");
+  XmlNode vtkfile = doc->add_node("VTKFile");
   vtkfile.set_attribute("type", "UnstructuredGrid");
   vtkfile.set_attribute("version", "0.1");
   vtkfile.set_attribute("byte_order", "LittleEndian");
@@ -284,16 +404,18 @@ void Writer::write()
   piece.set_attribute("NumberOfPoints", to_str(npoints));
   piece.set_attribute("NumberOfCells", to_str(nb_elems));
 
-  // Points output
-  detail::CompressedStream appended_data;
+  // Points output. Asynchronous output stages a copy of the data, otherwise it is compressed as it is appended.
+  const bool asynchronous = options().value<bool>("asynchronous");
+  detail::CompressedStream compressed_data;
+  boost::shared_ptr<detail::AppendedData> staged_data(new detail::AppendedData(asynchronous ? 0 : &compressed_data));
+  detail::AppendedData& appended_data = *staged_data;
 
   XmlNode points_data = piece.add_node("Points").add_node("DataArray");
   points_data.set_attribute("type", sizeof(Real) == 4 ? "Float32" : "Float64");
   points_data.set_attribute("NumberOfComponents", "3");
   points_data.set_attribute("format", "appended");
-  points_data.set_attribute("offset", to_str(appended_data.offset()));
 
-  appended_data.start_array(3*npoints, sizeof(Real));
+  appended_data.start_array(points_data, 3*npoints, sizeof(Real));
   for(Uint i = 0; i != npoints; ++i)
   {
     const Field::ConstRow row = coords[i];
@@ -310,8 +432,7 @@ void Writer::write()
   connectivity.set_attribute("type", "UInt32");
   connectivity.set_attribute("Name", "connectivity");
   connectivity.set_attribute("format", "appended");
-  connectivity.set_attribute("offset", to_str(appended_data.offset()));
-  appended_data.start_array(nb_conn_nodes, 4);
+  appended_data.start_array(connectivity, nb_conn_nodes, 4);
   boost_foreach(const Handle<Elements const>& elements_h, elements_list)
   {
     const Elements& elements  = *elements_h;
@@ -333,9 +454,8 @@ void Writer::write()
   offsets.set_attribute("type", "UInt32");
   offsets.set_attribute("Name", "offsets");
   offsets.set_attribute("format", "appended");
-  offsets.set_attribute("offset", to_str(appended_data.offset()));
   boost::uint32_t offset = 0;
-  appended_data.start_array(nb_elems, 4);
+  appended_data.start_array(offsets, nb_elems, 4);
   boost_foreach(const Handle<Elements const>& elements_h, elements_list)
   {
     const Elements& elements  = *elements_h;
@@ -353,8 +473,7 @@ void Writer::write()
   types.set_attribute("type", "UInt8");
   types.set_attribute("Name", "types");
   types.set_attribute("format", "appended");
-  types.set_attribute("offset", to_str(appended_data.offset()));
-  appended_data.start_array(nb_elems, 1);
+  appended_data.start_array(types, nb_elems, 1);
   boost_foreach(const Handle<Elements const>& elements_h, elements_list)
   {
     const Elements& elements  = *elements_h;
@@ -398,9 +517,8 @@ void Writer::write()
       data_array.set_attribute("NumberOfComponents", to_str(var_size == 2 && dim == 2 ? 3 : var_size));
       data_array.set_attribute("Name", var_name);
       data_array.set_attribute("format", "appended");
-      data_array.set_attribute("offset", to_str(appended_data.offset()));
 
-      appended_data.start_array(field_size*(var_size == 2 && dim == 2 ? 3 : var_size), sizeof(Real));
+      appended_data.start_array(data_array, field_size*(var_size == 2 && dim == 2 ? 3 : var_size), sizeof(Real));
 
       if(field.continuous())
       {
@@ -461,25 +579,7 @@ void Writer::write()
     }
   }
 
-  // Write to file, inserting the binary data at the end
   std::cout << "writing file " << my_path.path() << std::endl;
-  boost::filesystem::fstream fout(my_path.path(), std::ios_base::out | std::ios_base::binary);
-
-  // Remove the closing tag
-  std::string xml_string;
-  to_string(doc, xml_string);
-  boost::algorithm::erase_last(xml_string, "</VTKFile>");
-  boost::algorithm::trim_right(xml_string);
-
-  // Write XML meta data
-  fout << xml_string;
-
-  // Append  compressed data
-  fout << "\n<AppendedData encoding=\"raw\">\n";
-  fout << appended_data.data_stream.rdbuf();
-  fout << "\n</AppendedData>\n</VTKFile>\n";
-
-  fout.close();
 
   // Write the parallel header, if needed
   if(PE::Comm::instance().rank() == 0 || options().value<bool>("distributed_files"))
@@ -509,6 +609,12 @@ void Writer::write()
 
     to_file(pvtu_doc, pvtu_path);
   }
+
+  // The piece data is only used by the compression from here on, so it can continue in the background
+  if(asynchronous)
+    OutputThread::instance().enqueue(boost::bind(&detail::write_staged_vtu, doc, staged_data, my_path.path()));
+  else
+    detail::write_vtu_file(*doc, compressed_data, my_path.path());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
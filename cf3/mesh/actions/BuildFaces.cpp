@@ -7,7 +7,6 @@
 #include <set>
 
 #include <boost/foreach.hpp>
-#include <boost/functional/hash.hpp>
 
 #include "common/Log.hpp"
 #include "common/Builder.hpp"
@@ -55,14 +54,9 @@ struct FaceCompare
 {
   bool operator()(const Face2Cell& face1, const Face2Cell& face2) const
   {
-    std::size_t seed1=0;
-    std::size_t seed2=0;
-
-    boost::hash_combine(seed1,face1.comp->uri().string());
-    boost::hash_combine(seed2,face2.comp->uri().string());
-    boost::hash_combine(seed1,face1.idx);
-    boost::hash_combine(seed2,face2.idx);
-    return seed1 < seed2;
+    if (face1.comp != face2.comp)
+      return face1.comp < face2.comp;
+    return face1.idx < face2.idx;
   }
 };
 
@@ -90,6 +84,19 @@ BuildFaces::BuildFaces( const std::string& name )
       .pretty_name("Store Cell to Face")
       .mark_basic()
       .link_to(&m_store_cell2face);
+
+  std::vector<boost::any> face_matchings;
+  face_matchings.push_back(std::string("hash"));
+  face_matchings.push_back(std::string("node_search"));
+  options().add("face_matching", std::string("hash"))
+      .description("Algorithm to match the faces of the cells: hash (hash the sorted face nodes into a table) "
+                   "or node_search (search the faces connected to each node)")
+      .pretty_name("Face Matching")
+      .restricted_list() = face_matchings;
+
+  options().add("nb_threads", 1u)
+      .description("Number of threads used to match the faces of the cells")
+      .pretty_name("Number of Threads");
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -198,6 +205,8 @@ void BuildFaces::build_face_cell_connectivity_bottom_up(Component& parent)
 //      CFdebug << PERank << "building face_cell connectivity for region " << region.uri().path() << CFendl;
       Handle<FaceCellConnectivity> face_to_cell = region.create_component<FaceCellConnectivity>("face_to_cell");
       face_to_cell->options().set("face_building_algorithm",true);
+      face_to_cell->options().set("face_matching",options().value<std::string>("face_matching"));
+      face_to_cell->options().set("nb_threads",options().value<Uint>("nb_threads"));
       face_to_cell->add_tag(mesh::Tags::inner_faces());
       face_to_cell->setup(region);
       PE::Comm::instance().barrier();
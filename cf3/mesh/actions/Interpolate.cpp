@@ -21,6 +21,7 @@
 #include "mesh/Field.hpp"
 #include "mesh/ShapeFunction.hpp"
 #include "mesh/Octtree.hpp"
+#include "mesh/PointLocator.hpp"
 #include "mesh/Connectivity.hpp"
 
 #include "mesh/actions/Interpolate.hpp"
@@ -196,94 +197,26 @@ void Interpolate::interpolate(const Field& source, const common::Table<Real>& co
     }
   }
 
-  std::vector<Real> send_coords(target_dim*missing_cells.size());
-  std::vector<Real> recv_coords;
-
-  Uint c(0);
+  // Send the coordinates that were not found here only to the ranks whose part of the source mesh may contain them
+  std::vector<Real> missing_coords;
+  missing_coords.reserve(dimension*missing_cells.size());
   boost_foreach(const Uint i, missing_cells)
   {
-    for(Uint d=0; d<target_dim; ++d)
-      send_coords[c++]=coordinates[i][d];
+    for (Uint d=0; d<target_dim; ++d)
+      coord[d] = coordinates[i][d];
+    missing_coords.insert(missing_coords.end(), coord.data(), coord.data()+dimension);
   }
 
-  for (Uint root=0; root<PE::Comm::instance().size(); ++root)
+  std::vector<Real> missing_values;
+  std::vector<int> found_ranks;
+  point_locator(source_mesh).evaluate(missing_coords, nb_vars, boost::bind(&Interpolate::interpolate_remote_coordinate, this, _1, _2), missing_values, found_ranks);
+  for (Uint i=0; i<missing_cells.size(); ++i)
   {
-
-//    if (root == PE::Comm::instance().rank())
-//    {
-//      std::cout << PERank << "send coords = ";
-//      for(Uint i=0; i<send_coords.size(); ++i)
-//         std::cout << send_coords[i] << " ";
-//      std::cout << std::endl;
-//    }
-    recv_coords.resize(0);
-    PE::Comm::instance().broadcast(send_coords,recv_coords,root,target_dim);
-
-//    if (root != PE::Comm::instance().rank())
-//    {
-//      std::cout << PERank << "recv coords = ";
-//      for(Uint i=0; i<recv_coords.size(); ++i)
-//         std::cout << recv_coords[i] << " ";
-//      std::cout << std::endl;
-//    }
-
-
-    // size is only because it doesn't get resized for this rank
-    std::vector<Real> send_target_rows(nb_vars*missing_cells.size(),math::Consts::uint_max());
-
-    if (root!=Comm::instance().rank())
-    {
-      std::vector<RealVector> recv_coordinates(recv_coords.size()/target_dim) ;
-      boost_foreach(RealVector& realvec, recv_coordinates)
-          realvec.resize(target_dim);
-
-      c=0;
-      for (Uint i=0; i<recv_coordinates.size(); ++i)
-      {
-        for(Uint d=0; d<target_dim; ++d)
-          recv_coordinates[i][d]=recv_coords[c++];
-      }
-
-      send_target_rows.resize(recv_coordinates.size()*nb_vars);
-      for (Uint i=0; i<recv_coordinates.size(); ++i)
-      {
-        for (Uint d=0; d<target_dim; ++d)
-          coord[d] = recv_coordinates[i][d];
-
-        if( m_octtree->find_element(coord,element) )
-        {
-//          std::cout<< PERank << " send to " << root << ": interpolate for coord (" << coord.transpose() << ") in " << element_component->uri().path() << "["<<element_idx<<"]" << std::endl;
-          boost::multi_array<Real,2> target_row(boost::extents[1][nb_vars]);
-          interpolate_coordinate( coord, *element.comp, element.idx, target_row[0] );
-          for (Uint v=0; v<nb_vars; ++v)
-            send_target_rows[i*nb_vars+v] = target_row[0][v];
-        }
-        else
-        {
-//          std::cout << PERank<< " send to " << root << ": coord " << coord.transpose() << " not found " << std::endl;
-          for (Uint v=0; v<nb_vars; ++v)
-            send_target_rows[i*nb_vars+v] = math::Consts::real_max();
-        }
-      }
-    }
-
-    std::vector<Real> recv_target_rows(nb_vars*missing_cells.size()*Comm::instance().size());
-    PE::Comm::instance().gather(send_target_rows,recv_target_rows,root);
-
-    if( root==Comm::instance().rank())
-    {
-      const Uint nb_cells = missing_cells.size();
-      for (Uint i=0; i<missing_cells.size(); ++i)
-      {
-        for(Uint p=0; p<Comm::instance().size(); ++p)
-        {
-          for(Uint v=0; v<nb_vars;  ++v)
-            target[missing_cells[i]][v] = std::min(recv_target_rows[v+nb_vars*(i+p*nb_cells)] , target[missing_cells[i]][v]);
-        }
-      }
-    } // endif root==rank
-  } // end foreach root
-
+    if (found_ranks[i] < 0)
+      continue;
+    for (Uint v=0; v<nb_vars; ++v)
+      target[missing_cells[i]][v] = missing_values[i*nb_vars+v];
+  }
 
   missing_cells.clear();
   for (Uint i=0; i<target.size(); ++i)
@@ -291,7 +224,7 @@ void Interpolate::interpolate(const Field& source, const common::Table<Real>& co
     bool found = true;
     for (Uint v=0; v<target.row_size(); ++v)
     {
-      if (target[i][v] == math::Consts::uint_max())
+      if (target[i][v] == math::Consts::real_max())
       {
         target[i][v] = 0.;
         found &= false;
@@ -347,6 +280,22 @@ void Interpolate::interpolate_coordinate(const RealVector& target_coord, const E
 
 //////////////////////////////////////////////////////////////////////////////
 
+bool Interpolate::interpolate_remote_coordinate(const RealVector& target_coord, Real* result)
+{
+  Entity element;
+  if( !m_octtree->find_element(target_coord,element) )
+    return false;
+
+  const Uint nb_vars = m_source->row_size();
+  boost::multi_array<Real,2> target_row(boost::extents[1][nb_vars]);
+  interpolate_coordinate( target_coord, *element.comp, element.idx, target_row[0] );
+  for (Uint v=0; v<nb_vars; ++v)
+    result[v] = target_row[0][v];
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void Interpolate::signal_interpolate ( common::SignalArgs& node )
 {
   common::XML::SignalOptions options( node );
@@ -49,8 +49,8 @@ public: // functions
   /// @param [in]  coordinates  interpolate at these coordinates (rows are coordinates)
   /// @param [out] target       Table of interpolated values at the given coordinates
   /// @post target is resized: row-size from source, nb_rows from coordinates
-  /// @note MPI communication is used if coordinates are not found on this rank. Other ranks
-  ///       then interpolate and send result back
+  /// @note MPI communication is used if coordinates are not found on this rank. They are sent to
+  ///       the ranks whose part of the source mesh may contain them, which interpolate and send the result back
   void interpolate(const Field& source, const common::Table<Real>& coordinates, common::Table<Real>& target);
 
   void signal_interpolate ( common::SignalArgs& node);
@@ -69,6 +69,9 @@ private:
 
   void interpolate_coordinate(const RealVector& target_coord, const Entities& element_component, const Uint element_idx, Field::Row target_row);
 
+  /// Interpolate at a coordinate received from another rank, returning false if it is not in the local source mesh
+  bool interpolate_remote_coordinate(const RealVector& target_coord, Real* result);
+
 
 }; // end Interpolate
 
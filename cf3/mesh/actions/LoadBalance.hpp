@@ -23,6 +23,8 @@ namespace actions {
 
 /// @brief Load Balance the mesh
 ///
+/// The mesh is partitioned with PT-Scotch or Zoltan if available, and with the built-in
+/// HilbertPartitioner otherwise.
 /// @post After this, the mesh is ready to be parallellized
 /// @author Willem Deconinck
 class mesh_actions_API LoadBalance : public MeshTransformer
@@ -29,6 +29,7 @@
 #include "mesh/Connectivity.hpp"
 #include "mesh/ElementData.hpp"
 #include "mesh/PointInterpolator.hpp"
+#include "mesh/PointLocator.hpp"
 
 #include "MeshInterpolator.hpp"
 
@@ -126,8 +127,10 @@ void MeshInterpolator::execute()
       adaptor.prepare();
       std::vector< std::vector< std::vector<Uint> > > elements_to_send(nb_procs, std::vector< std::vector<Uint> > (source_mesh->elements().size()));
 
+      // Only the ranks whose part of the source mesh may contain a missing point receive it
+      std::vector< std::vector<Uint> > sent_points;
       std::vector< std::vector<Real> > recv_missing_points;
-      comm.all_gather(my_missing_points, recv_missing_points);
+      point_locator(*source_mesh).route(my_missing_points, sent_points, recv_missing_points);
       const Uint nb_ranks = comm.size();
       cf3_assert(recv_missing_points.size() == nb_ranks);
 
@@ -175,6 +178,7 @@ void MeshInterpolator::execute()
       point_interpolator->remove_tag(common::Tags::static_component());
       remove_component(*point_interpolator);
       source_mesh->remove_component("octtree");
+      source_mesh->remove_component("point_locator");
       point_interpolator = create_static_component<PointInterpolator>("PointInterpolator");
       point_interpolator->options().set("function", std::string("cf3.mesh.ShapeFunctionInterpolation"));
       point_interpolator->options().set("dict", source_dict);
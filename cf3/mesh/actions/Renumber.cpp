@@ -0,0 +1,408 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+
+#include "common/Builder.hpp"
+#include "common/DynTable.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
+#include "common/List.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/Table.hpp"
+
+#include "math/BoundingBox.hpp"
+#include "math/Consts.hpp"
+#include "math/Hilbert.hpp"
+
+#include "mesh/actions/Renumber.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/FaceCellConnectivity.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+namespace actions {
+
+using namespace common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < Renumber, MeshTransformer, mesh::actions::LibActions> Renumber_Builder;
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+
+/// Number of levels of the Hilbert curve, as in GlobalNumbering
+const Uint hilbert_levels = 20;
+
+/// Reorder the rows of a table, so the new row i is the old row new_to_old[i]
+template<typename T>
+void permute_rows(Table<T>& table, const std::vector<Uint>& new_to_old)
+{
+  cf3_assert(table.size() == new_to_old.size());
+  const typename Table<T>::ArrayT old_array(table.array());
+  const Uint nb_rows = new_to_old.size();
+  const Uint row_size = table.row_size();
+  for(Uint i = 0; i != nb_rows; ++i)
+    for(Uint j = 0; j != row_size; ++j)
+      table.array()[i][j] = old_array[new_to_old[i]][j];
+}
+
+template<typename T>
+void permute_rows(List<T>& list, const std::vector<Uint>& new_to_old)
+{
+  cf3_assert(list.size() == new_to_old.size());
+  const typename List<T>::ListT old_array(list.array());
+  const Uint nb_rows = new_to_old.size();
+  for(Uint i = 0; i != nb_rows; ++i)
+    list.array()[i] = old_array[new_to_old[i]];
+}
+
+template<typename T>
+void permute_rows(DynTable<T>& table, const std::vector<Uint>& new_to_old)
+{
+  cf3_assert(table.size() == new_to_old.size());
+  typename DynTable<T>::ArrayT old_array;
+  old_array.swap(table.array());
+  const Uint nb_rows = new_to_old.size();
+  table.array().resize(nb_rows);
+  for(Uint i = 0; i != nb_rows; ++i)
+    table.array()[i].swap(old_array[new_to_old[i]]);
+}
+
+/// Inverse of a permutation
+void invert(const std::vector<Uint>& new_to_old, std::vector<Uint>& old_to_new)
+{
+  const Uint nb_rows = new_to_old.size();
+  old_to_new.resize(nb_rows);
+  for(Uint i = 0; i != nb_rows; ++i)
+    old_to_new[new_to_old[i]] = i;
+}
+
+/// Permutation that sorts the given keys, keeping the original order for equal keys
+template<typename KeyT>
+void sorting_order(const std::vector<KeyT>& keys, std::vector<Uint>& new_to_old)
+{
+  const Uint nb_rows = keys.size();
+  std::vector< std::pair<KeyT, Uint> > sorted(nb_rows);
+  for(Uint i = 0; i != nb_rows; ++i)
+    sorted[i] = std::make_pair(keys[i], i);
+  std::sort(sorted.begin(), sorted.end());
+  new_to_old.resize(nb_rows);
+  for(Uint i = 0; i != nb_rows; ++i)
+    new_to_old[i] = sorted[i].second;
+}
+
+/// Reverse Cuthill-McKee ordering of the graph formed by the nodes that share an element
+void rcm_order(const Mesh& mesh, std::vector<Uint>& new_to_old)
+{
+  const Dictionary& geometry = mesh.geometry_fields();
+  const Uint nb_nodes = geometry.size();
+
+  std::vector< std::vector<Uint> > neighbours(nb_nodes);
+  BOOST_FOREACH(const Handle<Space>& space, geometry.spaces())
+  {
+    BOOST_FOREACH(const Connectivity::ConstRow row, space->connectivity().array())
+    {
+      BOOST_FOREACH(const Uint a, row)
+      {
+        BOOST_FOREACH(const Uint b, row)
+        {
+          if(a != b)
+            neighbours[a].push_back(b);
+        }
+      }
+    }
+  }
+
+  std::vector<Uint> degrees(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    std::vector<Uint>& adjacent = neighbours[i];
+    std::sort(adjacent.begin(), adjacent.end());
+    adjacent.erase(std::unique(adjacent.begin(), adjacent.end()), adjacent.end());
+    degrees[i] = adjacent.size();
+  }
+
+  // Start each connected part of the graph at a node of lowest degree, and visit the neighbours by increasing degree
+  std::vector<Uint> by_degree;
+  sorting_order(degrees, by_degree);
+
+  new_to_old.clear();
+  new_to_old.reserve(nb_nodes);
+  std::vector<bool> visited(nb_nodes, false);
+  std::vector< std::pair<Uint, Uint> > next_nodes;
+  BOOST_FOREACH(const Uint start, by_degree)
+  {
+    if(visited[start])
+      continue;
+
+    visited[start] = true;
+    new_to_old.push_back(start);
+    for(Uint head = new_to_old.size() - 1; head != new_to_old.size(); ++head)
+    {
+      next_nodes.clear();
+      BOOST_FOREACH(const Uint neighbour, neighbours[new_to_old[head]])
+      {
+        if(!visited[neighbour])
+        {
+          visited[neighbour] = true;
+          next_nodes.push_back(std::make_pair(degrees[neighbour], neighbour));
+        }
+      }
+      std::sort(next_nodes.begin(), next_nodes.end());
+      for(Uint i = 0; i != next_nodes.size(); ++i)
+        new_to_old.push_back(next_nodes[i].second);
+    }
+  }
+
+  std::reverse(new_to_old.begin(), new_to_old.end());
+}
+
+/// Bounding box of the local nodes
+math::BoundingBox local_bounding_box(const Field& coordinates)
+{
+  const Uint dim = coordinates.row_size();
+  RealVector min = RealVector::Constant(dim, math::Consts::real_max());
+  RealVector max = RealVector::Constant(dim, -math::Consts::real_max());
+  BOOST_FOREACH(const Field::ConstRow row, coordinates.array())
+  {
+    for(Uint d = 0; d != dim; ++d)
+    {
+      min[d] = std::min(min[d], row[d]);
+      max[d] = std::max(max[d], row[d]);
+    }
+  }
+  return math::BoundingBox(min, max);
+}
+
+/// Order in which the elements first use the rows of a dictionary. Rows that are not used keep their order, at the end.
+void first_use_order(const Mesh& mesh, const Dictionary& dict, std::vector<Uint>& new_to_old)
+{
+  const Uint nb_rows = dict.size();
+  std::vector<bool> used(nb_rows, false);
+  new_to_old.clear();
+  new_to_old.reserve(nb_rows);
+  BOOST_FOREACH(const Handle<Entities>& elements, mesh.elements())
+  {
+    if(!dict.defined_for_entities(elements))
+      continue;
+
+    BOOST_FOREACH(const Connectivity::ConstRow row, dict.space(*elements).connectivity().array())
+    {
+      BOOST_FOREACH(const Uint i, row)
+      {
+        if(!used[i])
+        {
+          used[i] = true;
+          new_to_old.push_back(i);
+        }
+      }
+    }
+  }
+
+  for(Uint i = 0; i != nb_rows; ++i)
+  {
+    if(!used[i])
+      new_to_old.push_back(i);
+  }
+}
+
+/// Permute the elements and the connectivity rows of all their spaces
+void renumber_elements(Entities& elements, const std::vector<Uint>& new_to_old)
+{
+  permute_rows(elements.glb_idx(), new_to_old);
+  permute_rows(elements.rank(), new_to_old);
+  BOOST_FOREACH(const Handle<Space>& space, elements.spaces())
+  {
+    permute_rows(space->connectivity(), new_to_old);
+  }
+
+  Handle< List<Real> > weights(elements.get_child(mesh::Tags::partition_weights()));
+  if(is_not_null(weights))
+    permute_rows(*weights, new_to_old);
+
+  // Recomputed by GlobalNumbering when needed
+  if(is_not_null(elements.get_child("hilbert_indices")))
+    elements.remove_component("hilbert_indices");
+}
+
+/// Permute the rows of the dictionary and update the connectivity of its spaces
+void renumber_dictionary(Dictionary& dict, const std::vector<Uint>& new_to_old)
+{
+  std::vector<Uint> old_to_new;
+  invert(new_to_old, old_to_new);
+
+  BOOST_FOREACH(Field& field, find_components<Field>(dict))
+  {
+    permute_rows(field, new_to_old);
+  }
+  permute_rows(dict.glb_idx(), new_to_old);
+  permute_rows(dict.rank(), new_to_old);
+  if(dict.glb_elem_connectivity().size() == new_to_old.size())
+    permute_rows(dict.glb_elem_connectivity(), new_to_old);
+
+  Handle< List<Uint> > periodic_links_nodes(dict.get_child("periodic_links_nodes"));
+  Handle< List<bool> > periodic_links_active(dict.get_child("periodic_links_active"));
+  if(is_not_null(periodic_links_nodes))
+  {
+    permute_rows(*periodic_links_nodes, new_to_old);
+    BOOST_FOREACH(Uint& target, periodic_links_nodes->array())
+    {
+      target = old_to_new[target];
+    }
+  }
+  if(is_not_null(periodic_links_active))
+    permute_rows(*periodic_links_active, new_to_old);
+
+  // Recomputed by GlobalNumbering when needed
+  if(is_not_null(dict.get_child("hilbert_indices")))
+    dict.remove_component("hilbert_indices");
+
+  // Rebuilt on demand
+  if(is_not_null(dict.get_child("CommPattern")))
+    dict.remove_component("CommPattern");
+
+  BOOST_FOREACH(const Handle<Space>& space, dict.spaces())
+  {
+    BOOST_FOREACH(Connectivity::Row row, space->connectivity().array())
+    {
+      BOOST_FOREACH(Uint& i, row)
+      {
+        i = old_to_new[i];
+      }
+    }
+  }
+}
+
+} // namespace detail
+
+//////////////////////////////////////////////////////////////////////////////
+
+Renumber::Renumber( const std::string& name ) :
+  MeshTransformer(name)
+{
+  properties()["brief"] = std::string("Reorder the local nodes and elements for memory locality");
+  properties()["description"] = std::string("Reorders the geometry nodes in reverse Cuthill-McKee or Hilbert curve order, the elements accordingly, "
+                                            "and the other dictionaries in the order of first use by the elements");
+
+  std::vector<boost::any> orderings;
+  orderings.push_back(std::string("RCM"));
+  orderings.push_back(std::string("Hilbert"));
+  options().add("ordering", std::string("RCM"))
+      .description("Ordering of the nodes: RCM (reverse Cuthill-McKee, minimizes the bandwidth of the node graph) or Hilbert (follows the Hilbert curve through the coordinates)")
+      .pretty_name("Ordering")
+      .restricted_list() = orderings;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Renumber::execute()
+{
+  Mesh& mesh = *m_mesh;
+
+  if(!find_components_recursively<FaceCellConnectivity>(mesh).empty())
+    throw SetupError(FromHere(), "Renumber can't update the face connectivity of mesh " + mesh.uri().path() + ". Apply it before building the faces.");
+
+  Dictionary& geometry = mesh.geometry_fields();
+  const Field& coordinates = geometry.coordinates();
+  const bool hilbert = options().value<std::string>("ordering") == "Hilbert";
+  const math::BoundingBox bounding_box = detail::local_bounding_box(coordinates);
+  math::Hilbert compute_hilbert_key(bounding_box, detail::hilbert_levels);
+
+  // Order of the nodes
+  std::vector<Uint> nodes_new_to_old;
+  if(hilbert)
+  {
+    const Uint nb_nodes = coordinates.size();
+    std::vector<boost::uint64_t> keys(nb_nodes);
+    RealVector coord(coordinates.row_size());
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      for(Uint d = 0; d != coordinates.row_size(); ++d)
+        coord[d] = coordinates[i][d];
+      keys[i] = compute_hilbert_key(coord);
+    }
+    detail::sorting_order(keys, nodes_new_to_old);
+  }
+  else
+  {
+    detail::rcm_order(mesh, nodes_new_to_old);
+  }
+  std::vector<Uint> nodes_old_to_new;
+  detail::invert(nodes_new_to_old, nodes_old_to_new);
+
+  // Order of the elements of each component, sorted by Hilbert key of the centroid or by their lowest new node index
+  std::vector<Uint> elements_new_to_old;
+  BOOST_FOREACH(const Handle<Entities>& elements, mesh.elements())
+  {
+    const Uint nb_elems = elements->size();
+    const Connectivity& connectivity = elements->geometry_space().connectivity();
+    if(hilbert)
+    {
+      std::vector<boost::uint64_t> keys(nb_elems);
+      RealMatrix element_coordinates(elements->element_type().nb_nodes(), coordinates.row_size());
+      RealVector centroid(elements->element_type().dimension());
+      for(Uint e = 0; e != nb_elems; ++e)
+      {
+        elements->geometry_space().put_coordinates(element_coordinates, e);
+        elements->element_type().compute_centroid(element_coordinates, centroid);
+        keys[e] = compute_hilbert_key(centroid);
+      }
+      detail::sorting_order(keys, elements_new_to_old);
+    }
+    else
+    {
+      std::vector<Uint> keys(nb_elems);
+      for(Uint e = 0; e != nb_elems; ++e)
+      {
+        Uint lowest = nodes_old_to_new.size();
+        BOOST_FOREACH(const Uint node, connectivity[e])
+        {
+          lowest = std::min(lowest, nodes_old_to_new[node]);
+        }
+        keys[e] = lowest;
+      }
+      detail::sorting_order(keys, elements_new_to_old);
+    }
+
+    detail::renumber_elements(*elements, elements_new_to_old);
+  }
+
+  detail::renumber_dictionary(geometry, nodes_new_to_old);
+
+  std::vector<Uint> dict_new_to_old;
+  BOOST_FOREACH(const Handle<Dictionary>& dict, mesh.dictionaries())
+  {
+    if(dict.get() == &geometry)
+      continue;
+    detail::first_use_order(mesh, *dict, dict_new_to_old);
+    detail::renumber_dictionary(*dict, dict_new_to_old);
+  }
+
+  mesh.raise_mesh_changed();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // mesh
+} // cf3
@@ -0,0 +1,55 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_actions_Renumber_hpp
+#define cf3_mesh_actions_Renumber_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mesh/MeshTransformer.hpp"
+#include "mesh/actions/LibActions.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+namespace actions {
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// @brief Reorder the local nodes and elements for memory locality
+///
+/// Mesh readers keep the order of the file, which is often unrelated to the position of the nodes and elements.
+/// This reorders the geometry nodes in reverse Cuthill-McKee ("RCM") or Hilbert curve ("Hilbert") order, and the
+/// elements of each element component in the same order. The rows of the other dictionaries are numbered in the
+/// order in which the reordered elements first use them. Fields, global indices, ranks and connectivity tables are
+/// permuted accordingly, and the mesh changed event is raised, so communication patterns and the node to element
+/// connectivity are rebuilt. Global indices don't change, so this is a purely local operation.
+/// @pre No face connectivity has been built yet, i.e. this is applied right after loading or partitioning the mesh.
+class mesh_actions_API Renumber : public MeshTransformer
+{
+public: // functions
+
+  /// constructor
+  Renumber( const std::string& name );
+
+  /// Gets the Class name
+  static std::string type_name() { return "Renumber"; }
+
+  virtual void execute();
+
+}; // end Renumber
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_actions_Renumber_hpp
@@ -4,27 +4,36 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <limits>
+#include <map>
 #include <set>
 
+#include <boost/bind.hpp>
+
 #include "common/Builder.hpp"
 
 #include "common/FindComponents.hpp"
 #include "common/Foreach.hpp"
+#include "common/Log.hpp"
 #include "common/Option.hpp"
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
+#include "common/ThreadPool.hpp"
+
+#include "common/PE/Comm.hpp"
 
 #include "mesh/ConnectivityData.hpp"
 #include "mesh/DiscontinuousDictionary.hpp"
 #include "mesh/ElementData.hpp"
 #include "mesh/Faces.hpp"
+#include "mesh/KdTree.hpp"
 #include "mesh/Region.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/Mesh.hpp"
 #include "mesh/Field.hpp"
 #include "mesh/Functions.hpp"
 #include "mesh/Connectivity.hpp"
-#include "mesh/ElementData.hpp"
 
 #include "mesh/LagrangeP1/Triag2D.hpp"
 #include "mesh/LagrangeP1/Quad2D.hpp"
@@ -46,39 +55,115 @@ common::ComponentBuilder < WallDistance, MeshTransformer, mesh::actions::LibActi
 namespace detail
 {
 
-/// Helper struct to handle projection to the wall near a given surface node
+const Uint invalid_index = std::numeric_limits<Uint>::max();
+
+/// Points and elements of the wall. The local wall elements come first, in the same order as in the wall node connectivity,
+/// followed by the wall elements gathered from the other ranks. Points are numbered separately from the mesh nodes, so
+/// remote points can be added.
+struct WallSurface
+{
+  WallSurface(const Uint d) : dim(d), nb_local_elements(0)
+  {
+    element_first_point.push_back(0);
+  }
+
+  Uint nb_points() const { return point_nodes.size(); }
+  Uint nb_elements() const { return element_normals.size(); }
+
+  /// Add a point, with the local node index or invalid_index for remote points
+  Uint add_point(const Real* coords, const Uint node)
+  {
+    point_coords.insert(point_coords.end(), coords, coords + dim);
+    point_nodes.push_back(node);
+    return point_nodes.size() - 1;
+  }
+
+  void add_element(const std::vector<Uint>& points, const RealVector& normal)
+  {
+    element_points.insert(element_points.end(), points.begin(), points.end());
+    element_first_point.push_back(element_points.size());
+    element_normals.push_back(normal);
+  }
+
+  RealVector point(const Uint point_idx) const
+  {
+    RealVector result(dim);
+    for(Uint i = 0; i != dim; ++i)
+      result[i] = point_coords[point_idx*dim + i];
+    return result;
+  }
+
+  /// Build the point to element links. The elements of each point are in element order.
+  void link_points()
+  {
+    const Uint nb_pts = nb_points();
+    std::vector<Uint> counts(nb_pts, 0);
+    BOOST_FOREACH(const Uint point_idx, element_points)
+    {
+      ++counts[point_idx];
+    }
+    point_first_element.assign(nb_pts+1, 0);
+    for(Uint i = 0; i != nb_pts; ++i)
+      point_first_element[i+1] = point_first_element[i] + counts[i];
+    point_elements.resize(element_points.size());
+    std::fill(counts.begin(), counts.end(), 0);
+    const Uint nb_elems = nb_elements();
+    for(Uint elem_idx = 0; elem_idx != nb_elems; ++elem_idx)
+    {
+      for(Uint i = element_first_point[elem_idx]; i != element_first_point[elem_idx+1]; ++i)
+      {
+        const Uint point_idx = element_points[i];
+        point_elements[point_first_element[point_idx] + counts[point_idx]++] = elem_idx;
+      }
+    }
+  }
+
+  const Uint dim;
+  /// Coordinates of the points, dim values per point
+  std::vector<Real> point_coords;
+  /// Local node index of each point, or invalid_index if the point is not on this rank
+  std::vector<Uint> point_nodes;
+  /// Points of each element, starting at element_first_point
+  std::vector<Uint> element_first_point;
+  std::vector<Uint> element_points;
+  /// Unit normal of each element
+  std::vector<RealVector> element_normals;
+  /// Number of elements that are on this rank, in the order of the wall node connectivity
+  Uint nb_local_elements;
+  /// Elements adjacent to each point, starting at point_first_element
+  std::vector<Uint> point_first_element;
+  std::vector<Uint> point_elements;
+  /// Points that are candidates for the closest wall point
+  std::vector<Uint> search_points;
+};
+
+/// Helper struct to handle projection to the wall near a given surface point
 struct WallProjection
 {
-  WallProjection(const Field& coordinates, const NodeConnectivity& node_connectivity, const std::vector<std::vector<RealVector>>& normals) :
-    m_coords(coordinates),
-    m_node_connectivity(node_connectivity),
-    m_normals(normals)
+  WallProjection(const WallSurface& surface) :
+    m_surface(surface)
   {
   }
 
-  // Get the wall distance for an inner node, looking at the elements that are adjacent to the given surface node
-  Real operator()(const Uint inner_node_idx, const Uint surface_node_idx)
+  // Get the wall distance for an inner node, looking at the elements that are adjacent to the given surface point
+  Real operator()(const RealVector& inner_coord, const Uint surface_point_idx)
   {
     m_has_nearest_element = false;
+    const Uint dim = m_surface.dim;
     RealMatrix elem_coords;
-    const Uint dim = m_coords.row_size();
-    const RealVector inner_coord = to_vector(m_coords[inner_node_idx]);
-    std::vector<Uint> neighbor_nodes; // Collect neighboring nodes, so we can project onto a sharp corner in 3D if needed (i.e. near a step)
-    // Loop over all surface elements around the given node
-    BOOST_FOREACH(const NodeConnectivity::ElementReferenceT& element_ref, m_node_connectivity.node_element_range(surface_node_idx))
+    std::vector<Uint> neighbor_points; // Collect neighboring points, so we can project onto a sharp corner in 3D if needed (i.e. near a step)
+    // Loop over all surface elements around the given point
+    for(Uint i = m_surface.point_first_element[surface_point_idx]; i != m_surface.point_first_element[surface_point_idx+1]; ++i)
     {
-      // Get the element coordinates
-      const Entities& elem_entities = *m_node_connectivity.entities()[element_ref.first];
-      const ElementType& etype = elem_entities.element_type();
-      const Uint element_nb_nodes = etype.nb_nodes();
+      const Uint element_idx = m_surface.point_elements[i];
+      const Uint* conn_begin = &m_surface.element_points[m_surface.element_first_point[element_idx]];
+      const Uint* conn_end = conn_begin + (m_surface.element_first_point[element_idx+1] - m_surface.element_first_point[element_idx]);
+      const Uint element_nb_nodes = conn_end - conn_begin;
       elem_coords.resize(element_nb_nodes, dim);
-      const Connectivity::ConstRow conn_row = elem_entities.geometry_space().connectivity()[element_ref.second];
-      fill(elem_coords, m_coords, conn_row);
-
-      // We consider lines, triangles and quads as viable surface elements
-      if(element_nb_nodes < 2 || element_nb_nodes > 4 || etype.order() != 1)
+      for(Uint j = 0; j != element_nb_nodes; ++j)
       {
-        throw common::SetupError(FromHere(), "Unsupported surface element of type " + etype.name() + " in surface region " + elem_entities.uri().path());
+        for(Uint k = 0; k != dim; ++k)
+          elem_coords(j, k) = m_surface.point_coords[conn_begin[j]*dim + k];
       }
 
       bool in_element = false;
@@ -86,7 +171,6 @@ struct WallProjection
       if(element_nb_nodes == 2) // line segment
       {
         cf3_assert(dim == 2);
-        cf3_assert(etype.shape() == GeoShape::LINE);
         RealVector e1 = elem_coords.row(1) - elem_coords.row(0); // line segment vector
         Real e1_len = e1.norm();
         e1 /= e1_len;
@@ -97,7 +181,6 @@ struct WallProjection
       if(element_nb_nodes == 3)
       {
         cf3_assert(dim == 3);
-        cf3_assert(etype.shape() == GeoShape::TRIAG);
         RealVector3 e1 = (elem_coords.row(1) - elem_coords.row(0)).normalized();
         RealVector3 en = elem_coords.row(2) - elem_coords.row(0);
         RealVector3 e2 = (e1.cross(en)).cross(e1).normalized();
@@ -116,27 +199,26 @@ struct WallProjection
         p_proj[1] = p.dot(e2);
 
         in_element = LagrangeP1::Triag2D::is_coord_in_element(p_proj, triag_coords_2d);
-        const Uint origin_corner = std::find(conn_row.begin(), conn_row.end(), surface_node_idx) - conn_row.begin();
+        const Uint origin_corner = std::find(conn_begin, conn_end, surface_point_idx) - conn_begin;
         if(origin_corner == 0)
         {
-          neighbor_nodes.push_back(conn_row[1]);
-          neighbor_nodes.push_back(conn_row[2]);
+          neighbor_points.push_back(conn_begin[1]);
+          neighbor_points.push_back(conn_begin[2]);
         }
         else if(origin_corner == 1)
         {
-          neighbor_nodes.push_back(conn_row[0]);
-          neighbor_nodes.push_back(conn_row[2]);
+          neighbor_points.push_back(conn_begin[0]);
+          neighbor_points.push_back(conn_begin[2]);
         }
         else
         {
-          neighbor_nodes.push_back(conn_row[0]);
-          neighbor_nodes.push_back(conn_row[1]);
+          neighbor_points.push_back(conn_begin[0]);
+          neighbor_points.push_back(conn_begin[1]);
         }
       }
       if(element_nb_nodes == 4)
       {
         cf3_assert(dim == 3);
-        cf3_assert(etype.shape() == GeoShape::QUAD);
         RealVector3 e1 = (elem_coords.row(1) - elem_coords.row(0)).normalized();
         RealVector3 en = elem_coords.row(3) - elem_coords.row(0);
         RealVector3 e2 = (e1.cross(en)).cross(e1).normalized();
@@ -156,33 +238,33 @@ struct WallProjection
         p_proj[1] = p.dot(e2);
 
         in_element = LagrangeP1::Quad2D::is_coord_in_element(p_proj, quad_coords_2d);
-        const Uint origin_corner = std::find(conn_row.begin(), conn_row.end(), surface_node_idx) - conn_row.begin();
+        const Uint origin_corner = std::find(conn_begin, conn_end, surface_point_idx) - conn_begin;
         if(origin_corner == 0 || origin_corner == 2)
         {
-          neighbor_nodes.push_back(conn_row[1]);
-          neighbor_nodes.push_back(conn_row[3]);
+          neighbor_points.push_back(conn_begin[1]);
+          neighbor_points.push_back(conn_begin[3]);
         }
         else
         {
-          neighbor_nodes.push_back(conn_row[0]);
-          neighbor_nodes.push_back(conn_row[2]);
+          neighbor_points.push_back(conn_begin[0]);
+          neighbor_points.push_back(conn_begin[2]);
         }
       }
 
       // If the projection was in an element, we can just proceed to compute the normal distance
       if(in_element)
       {
-        m_last_nearest_element = element_ref;
+        m_last_nearest_element = element_idx;
         m_has_nearest_element = true;
-        return fabs(m_normals[element_ref.first][element_ref.second].dot(inner_coord - elem_coords.row(0).transpose()));
+        return fabs(m_surface.element_normals[element_idx].dot(inner_coord - elem_coords.row(0).transpose()));
       }
     }
     // If we got here, no projections on the elements gave a result
     // First, verify the 3D case where we need to project on "step" edges
-    BOOST_FOREACH(const Uint neighbor_node, neighbor_nodes)
+    BOOST_FOREACH(const Uint neighbor_point, neighbor_points)
     {
-      const RealVector surface_coord = to_vector(m_coords[surface_node_idx]);
-      const RealVector neighbor_coord = to_vector(m_coords[neighbor_node]);
+      const RealVector surface_coord = m_surface.point(surface_point_idx);
+      const RealVector neighbor_coord = m_surface.point(neighbor_point);
       RealVector e1 = neighbor_coord - surface_coord;
       Real e1_len = e1.norm();
       e1 /= e1_len;
@@ -192,15 +274,219 @@ struct WallProjection
         return (inner_coord - (surface_coord + e1*projection)).norm();
       }
     }
-    return (inner_coord - to_vector(m_coords[surface_node_idx])).norm();
+    return (inner_coord - m_surface.point(surface_point_idx)).norm();
   }
 
-  const Field& m_coords;
-  const NodeConnectivity& m_node_connectivity;
-  const std::vector<std::vector<RealVector>>& m_normals;
+  const WallSurface& m_surface;
   bool m_has_nearest_element = false;
-  NodeConnectivity::ElementReferenceT m_last_nearest_element;
+  Uint m_last_nearest_element = 0;
+};
+
+/// Add the wall elements owned by the other ranks to the surface. Points and elements that are already present locally are
+/// recognized by the global node indices, so the ghost copies of the wall are not duplicated.
+void gather_remote_wall(WallSurface& surface, const std::vector< Handle<Entities> >& surface_entities, const Dictionary& geometry)
+{
+  common::PE::Comm& comm = common::PE::Comm::instance();
+  const Uint dim = surface.dim;
+  const common::List<Uint>& glb_idx = geometry.glb_idx();
+
+  // Global node indices of the points and elements that are already known here
+  std::map<Uint, Uint> glb_to_point;
+  const Uint nb_local_points = surface.nb_points();
+  for(Uint point_idx = 0; point_idx != nb_local_points; ++point_idx)
+    glb_to_point[glb_idx[surface.point_nodes[point_idx]]] = point_idx;
+
+  std::set< std::vector<Uint> > known_elements;
+  std::vector<Uint> element_glb_nodes;
+  for(Uint elem_idx = 0; elem_idx != surface.nb_local_elements; ++elem_idx)
+  {
+    element_glb_nodes.clear();
+    for(Uint i = surface.element_first_point[elem_idx]; i != surface.element_first_point[elem_idx+1]; ++i)
+      element_glb_nodes.push_back(glb_idx[surface.point_nodes[surface.element_points[i]]]);
+    std::sort(element_glb_nodes.begin(), element_glb_nodes.end());
+    known_elements.insert(element_glb_nodes);
+  }
+
+  // Pack the owned wall elements: number of nodes followed by the global node indices, and the node coordinates followed by the normal
+  std::vector<Uint> send_nodes;
+  std::vector<Real> send_coords;
+  Uint local_elem_idx = 0;
+  BOOST_FOREACH(const Handle<Entities>& wall_entity, surface_entities)
+  {
+    const Uint nb_elems = wall_entity->size();
+    for(Uint elem_idx = 0; elem_idx != nb_elems; ++elem_idx, ++local_elem_idx)
+    {
+      if(wall_entity->is_ghost(elem_idx))
+        continue;
+
+      const Uint first = surface.element_first_point[local_elem_idx];
+      const Uint last = surface.element_first_point[local_elem_idx+1];
+      send_nodes.push_back(last - first);
+      for(Uint i = first; i != last; ++i)
+      {
+        const Uint point_idx = surface.element_points[i];
+        send_nodes.push_back(glb_idx[surface.point_nodes[point_idx]]);
+        send_coords.insert(send_coords.end(), surface.point_coords.begin() + point_idx*dim, surface.point_coords.begin() + (point_idx+1)*dim);
+      }
+      const RealVector& normal = surface.element_normals[local_elem_idx];
+      send_coords.insert(send_coords.end(), normal.data(), normal.data() + dim);
+    }
+  }
+
+  std::vector< std::vector<Uint> > recv_nodes;
+  std::vector< std::vector<Real> > recv_coords;
+  comm.all_gather(send_nodes, recv_nodes);
+  comm.all_gather(send_coords, recv_coords);
+
+  const Uint nb_procs = comm.size();
+  std::vector<Uint> element_points;
+  RealVector normal(dim);
+  for(Uint rank = 0; rank != nb_procs; ++rank)
+  {
+    if(rank == comm.rank())
+      continue;
+
+    const std::vector<Uint>& nodes = recv_nodes[rank];
+    const Real* coords = recv_coords[rank].empty() ? nullptr : &recv_coords[rank][0];
+    for(Uint pos = 0; pos != nodes.size();)
+    {
+      const Uint element_nb_nodes = nodes[pos++];
+      element_glb_nodes.assign(nodes.begin() + pos, nodes.begin() + pos + element_nb_nodes);
+      std::sort(element_glb_nodes.begin(), element_glb_nodes.end());
+      const bool is_new = known_elements.insert(element_glb_nodes).second;
+
+      element_points.clear();
+      for(Uint i = 0; i != element_nb_nodes; ++i, coords += dim)
+      {
+        const Uint node_glb_idx = nodes[pos + i];
+        std::map<Uint, Uint>::iterator point_it = glb_to_point.find(node_glb_idx);
+        if(point_it == glb_to_point.end())
+        {
+          point_it = glb_to_point.insert(std::make_pair(node_glb_idx, surface.add_point(coords, invalid_index))).first;
+          surface.search_points.push_back(point_it->second);
+        }
+        element_points.push_back(point_it->second);
+      }
+      pos += element_nb_nodes;
+      for(Uint i = 0; i != dim; ++i)
+        normal[i] = coords[i];
+      coords += dim;
+
+      if(is_new)
+        surface.add_element(element_points, normal);
+    }
+  }
+
+  CFdebug << "WallDistance: gathered " << surface.nb_elements() - surface.nb_local_elements << " wall elements from other ranks" << CFendl;
+}
+
+/// Computes the distances for a range of nodes on each thread
+struct DistanceTask
+{
+  DistanceTask(const WallSurface& s, const Field& c, const std::vector<bool>& wall_nodes, const bool kd, Field& dist, common::Table<Uint>& n2w) :
+    surface(s),
+    coords(c),
+    is_wall_node(wall_nodes),
+    use_kd_tree(kd),
+    d(dist),
+    node_to_wall_element(n2w)
+  {
+    BOOST_FOREACH(const Uint point_idx, surface.search_points)
+    {
+      if(surface.point_nodes[point_idx] != invalid_index)
+        local_search_points.push_back(point_idx);
+    }
+
+    if(use_kd_tree)
+    {
+      build_tree(surface.search_points, tree);
+      if(!local_search_points.empty() && local_search_points.size() != surface.search_points.size())
+        build_tree(local_search_points, local_tree);
+    }
+  }
+
+  void build_tree(const std::vector<Uint>& points, KdTree& point_tree) const
+  {
+    std::vector<Real> search_coords;
+    search_coords.reserve(points.size()*surface.dim);
+    BOOST_FOREACH(const Uint point_idx, points)
+    {
+      search_coords.insert(search_coords.end(), surface.point_coords.begin() + point_idx*surface.dim, surface.point_coords.begin() + (point_idx+1)*surface.dim);
+    }
+    point_tree.build(search_coords, surface.dim);
+  }
+
+  /// Closest point among the given wall points, with ties resolved in favour of the first one
+  Uint closest_point(const RealVector& inner_coord, const std::vector<Uint>& points, const KdTree& point_tree) const
+  {
+    if(use_kd_tree)
+    {
+      Real d2;
+      return points[point_tree.nearest(inner_coord.data(), d2)];
+    }
+
+    Real shortest_distance = 1e20;
+    Uint closest_surface_point = 0;
+    BOOST_FOREACH(const Uint point_idx, points)
+    {
+      const Real d2 = (inner_coord - surface.point(point_idx)).squaredNorm();
+      if(d2 < shortest_distance)
+      {
+        shortest_distance = d2;
+        closest_surface_point = point_idx;
+      }
+    }
+    return closest_surface_point;
+  }
+
+  void operator()(const Uint thread_idx, const Uint nb_threads, boost::barrier&)
+  {
+    Uint nodes_begin, nodes_end;
+    common::ThreadPool::static_chunk(coords.size(), thread_idx, nb_threads, nodes_begin, nodes_end);
+    WallProjection normal_distance(surface);
+    for(Uint inner_node_idx = nodes_begin; inner_node_idx != nodes_end; ++inner_node_idx)
+    {
+      if(is_wall_node[inner_node_idx])
+      {
+        d[inner_node_idx][0] = 0.;
+        continue;
+      }
+
+      const RealVector inner_coord = to_vector(coords[inner_node_idx]);
+      const Uint closest_surface_point = closest_point(inner_coord, surface.search_points, tree);
+      d[inner_node_idx][0] = normal_distance(inner_coord, closest_surface_point);
+      if(normal_distance.m_has_nearest_element && normal_distance.m_last_nearest_element < surface.nb_local_elements)
+      {
+        node_to_wall_element[inner_node_idx][0] = 1;
+        node_to_wall_element[inner_node_idx][1] = local_element_refs[normal_distance.m_last_nearest_element].first;
+        node_to_wall_element[inner_node_idx][2] = local_element_refs[normal_distance.m_last_nearest_element].second;
+      }
+      else
+      {
+        // If the closest wall is on another rank, the closest local wall node is the nearest reference available here
+        Uint closest_node = surface.point_nodes[closest_surface_point];
+        if(closest_node == invalid_index && !local_search_points.empty())
+          closest_node = surface.point_nodes[closest_point(inner_coord, local_search_points, local_tree)];
+        node_to_wall_element[inner_node_idx][0] = closest_node == invalid_index ? 2 : 0;
+        node_to_wall_element[inner_node_idx][1] = closest_node == invalid_index ? 0 : closest_node;
+      }
+    }
+  }
+
+  const WallSurface& surface;
+  const Field& coords;
+  const std::vector<bool>& is_wall_node;
+  const bool use_kd_tree;
+  Field& d;
+  common::Table<Uint>& node_to_wall_element;
+  KdTree tree;
+  /// Wall points that are local nodes, in search_points order, with their tree if it differs from the full tree
+  std::vector<Uint> local_search_points;
+  KdTree local_tree;
+  /// Entities index and element index of the local wall elements
+  std::vector< std::pair<Uint, Uint> > local_element_refs;
 };
+
 }
 
 WallDistance::WallDistance(const std::string& name) : MeshTransformer(name)
@@ -210,6 +496,23 @@ WallDistance::WallDistance(const std::string& name) : MeshTransformer(name)
       .description("Regions that are to be considered as part of the wall")
       .link_to(&m_regions)
       .mark_basic();
+
+  std::vector<boost::any> searches;
+  searches.push_back(std::string("kd_tree"));
+  searches.push_back(std::string("brute_force"));
+  options().add("nearest_search", std::string("kd_tree"))
+      .description("Algorithm to find the closest wall node: kd_tree (query a k-d tree of the wall nodes) "
+                   "or brute_force (compare with all wall nodes)")
+      .pretty_name("Nearest Search")
+      .restricted_list() = searches;
+
+  options().add("global_wall", true)
+      .description("Gather the wall elements of all ranks, so the distance is correct near partition boundaries")
+      .pretty_name("Global Wall");
+
+  options().add("nb_threads", 1u)
+      .description("Number of threads used to compute the distances")
+      .pretty_name("Number of Threads");
 }
 
 void WallDistance::execute()
@@ -220,7 +523,9 @@ void WallDistance::execute()
   const Uint nb_nodes = coords.size();
   const Uint dim = coords.row_size();
 
-  Handle<NodeConnectivity> node_connectivity = mesh.create_component<NodeConnectivity>("wall_node_connectivity");
+  Handle<NodeConnectivity> node_connectivity(mesh.get_child("wall_node_connectivity"));
+  if(is_null(node_connectivity))
+    node_connectivity = mesh.create_component<NodeConnectivity>("wall_node_connectivity");
   std::vector< Handle<Entities> > surface_entities;
   std::vector< Handle<Entities const> > const_surface_entities;
   for(const Handle<Region>& region : m_regions)
@@ -235,39 +540,81 @@ void WallDistance::execute()
   node_connectivity->initialize(nb_nodes, const_surface_entities);
 
   // Wall distance field
-  Field& d = mesh.geometry_fields().create_field("wall_distance");
-  d.add_tag("wall_distance");
+  Handle<Field> d_handle(mesh.geometry_fields().get_child("wall_distance"));
+  if(is_null(d_handle))
+  {
+    d_handle = mesh.geometry_fields().create_field("wall_distance").handle<Field>();
+    d_handle->add_tag("wall_distance");
+  }
+  Field& d = *d_handle;
 
-  std::vector<std::vector<RealVector>> normals;
+  boost::shared_ptr< common::List< Uint > > surface_nodes_ptr = build_used_nodes_list(const_surface_entities, mesh.geometry_fields(), true);
+  const common::List<Uint>& surface_nodes = *surface_nodes_ptr;
+  const Uint nb_surface_nodes = surface_nodes.size();
 
-  for(const auto& wall_entity : surface_entities)
+  // The closest wall point is searched among the local surface nodes, in the order of the used nodes list
+  detail::WallSurface surface(dim);
+  std::vector<Uint> node_points(nb_nodes, detail::invalid_index);
+  std::vector<bool> is_wall_node(nb_nodes, false);
+  for(Uint i = 0; i != nb_surface_nodes; ++i)
   {
-    const Uint nb_elems = wall_entity->size();
-    const auto& geom_conn = wall_entity->geometry_space().connectivity();
-    const ElementType& etype = wall_entity->element_type();
+    const Uint node_idx = surface_nodes[i];
+    node_points[node_idx] = surface.add_point(to_vector(coords[node_idx]).data(), node_idx);
+    surface.search_points.push_back(node_points[node_idx]);
+    is_wall_node[node_idx] = true;
+  }
+
+  std::vector< std::pair<Uint, Uint> > local_element_refs;
+  std::vector<Uint> element_points;
+  for(Uint entities_idx = 0; entities_idx != surface_entities.size(); ++entities_idx)
+  {
+    const Entities& wall_entity = *surface_entities[entities_idx];
+    const Uint nb_elems = wall_entity.size();
+    const auto& geom_conn = wall_entity.geometry_space().connectivity();
+    const ElementType& etype = wall_entity.element_type();
     const Uint element_nb_nodes = etype.nb_nodes();
 
-    normals.push_back(std::vector<RealVector>(nb_elems, RealVector(dim)));
+    // We consider lines, triangles and quads as viable surface elements
+    if(element_nb_nodes < 2 || element_nb_nodes > 4 || etype.order() != 1)
+    {
+      throw common::SetupError(FromHere(), "Unsupported surface element of type " + etype.name() + " in surface region " + wall_entity.uri().path());
+    }
 
     RealMatrix elem_coords(element_nb_nodes, dim);
+    RealVector normal(dim);
     for(Uint elem_idx = 0; elem_idx != nb_elems; ++elem_idx)
     {
       const Connectivity::ConstRow conn_row = geom_conn[elem_idx];
       fill(elem_coords, coords, conn_row);
-      RealVector normal(dim);
-      etype.compute_normal(elem_coords, normals.back()[elem_idx]);
-      normals.back()[elem_idx] /= normals.back()[elem_idx].norm();
+      etype.compute_normal(elem_coords, normal);
+      normal /= normal.norm();
+
+      element_points.clear();
+      BOOST_FOREACH(const Uint node_idx, conn_row)
+      {
+        // Nodes that were replaced by their periodic link in the used nodes list are not searched, but still needed for the projection
+        if(node_points[node_idx] == detail::invalid_index)
+          node_points[node_idx] = surface.add_point(to_vector(coords[node_idx]).data(), node_idx);
+        element_points.push_back(node_points[node_idx]);
+      }
+      surface.add_element(element_points, normal);
+      local_element_refs.push_back(std::make_pair(entities_idx, elem_idx));
     }
   }
+  surface.nb_local_elements = surface.nb_elements();
 
-  boost::shared_ptr< common::List< Uint > > surface_nodes_ptr = build_used_nodes_list(const_surface_entities, mesh.geometry_fields(), true);
-  const common::List<Uint>& surface_nodes = *surface_nodes_ptr;
-  const Uint nb_surface_nodes = surface_nodes.size();
+  common::PE::Comm& comm = common::PE::Comm::instance();
+  if(options().value<bool>("global_wall") && comm.is_active() && comm.size() > 1)
+    detail::gather_remote_wall(surface, surface_entities, mesh.geometry_fields());
 
-  detail::WallProjection normal_distance(coords, *node_connectivity, normals);
+  surface.link_points();
 
-  // Link each node to a wall element. First column: 1 if a wall element exists. Second column: index to the entities in the node connectivity. Last column: element index
-  auto& node_to_wall_element = *mesh.create_component<common::Table<Uint>>("node_to_wall_element");
+  // Link each node to a wall element. First column: 1 if a wall element exists, 0 for a wall node and 2 if there is no local wall.
+  // Second column: index to the entities in the node connectivity or the wall node. Last column: element index
+  Handle< common::Table<Uint> > node_to_wall_element_handle(mesh.get_child("node_to_wall_element"));
+  if(is_null(node_to_wall_element_handle))
+    node_to_wall_element_handle = mesh.create_component< common::Table<Uint> >("node_to_wall_element");
+  auto& node_to_wall_element = *node_to_wall_element_handle;
   node_to_wall_element.set_row_size(3);
   node_to_wall_element.resize(nb_nodes);
   for(auto&& row : node_to_wall_element.array())
@@ -275,49 +622,17 @@ void WallDistance::execute()
     std::fill(row.begin(), row.end(), 0);
   }
 
-  for(Uint inner_node_idx = 0; inner_node_idx != nb_nodes; ++inner_node_idx)
+  if(surface.search_points.empty())
   {
-    bool is_surface_node = false;
-    Real shortest_distance = 1e20;
-    Uint closest_surface_node = 0;
-    for(Uint j = 0; j != nb_surface_nodes; ++j)
-    {
-      const Uint surface_node_idx = surface_nodes[j];
-      if(surface_node_idx == inner_node_idx)
-      {
-        is_surface_node = true;
-        break;
-      }
-      const Real d2 = (to_vector(coords[inner_node_idx]) - to_vector(coords[surface_node_idx])).squaredNorm();
-      if(d2 < shortest_distance)
-      {
-        shortest_distance = d2;
-        closest_surface_node = surface_node_idx;
-      }
-    }
-
-    if(is_surface_node)
-    {
-      d[inner_node_idx][0] = 0.;
-      // Eigen::Map<RealVector> node_normal(&nodal_normals[inner_node_idx][0], dim);
-      // node_normal /= node_normal.norm();
-    }
-    else
-    {
-      d[inner_node_idx][0] = normal_distance(inner_node_idx, closest_surface_node);
-      if(normal_distance.m_has_nearest_element)
-      {
-        node_to_wall_element[inner_node_idx][0] = 1;
-        node_to_wall_element[inner_node_idx][1] = normal_distance.m_last_nearest_element.first;
-        node_to_wall_element[inner_node_idx][2] = normal_distance.m_last_nearest_element.second;
-      }
-      else
-      {
-        node_to_wall_element[inner_node_idx][0] = 0;
-        node_to_wall_element[inner_node_idx][1] = closest_surface_node;
-      }
-    }
+    CFwarn << "WallDistance: no wall nodes found in " << mesh.uri().path() << ", setting the distance to zero" << CFendl;
+    for(Uint i = 0; i != nb_nodes; ++i)
+      d[i][0] = 0.;
+    return;
   }
+
+  detail::DistanceTask task(surface, coords, is_wall_node, options().value<std::string>("nearest_search") == "kd_tree", d, node_to_wall_element);
+  task.local_element_refs.swap(local_element_refs);
+  common::ThreadPool::instance().run(std::max(options().value<Uint>("nb_threads"), 1u), boost::ref(task));
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -22,6 +22,14 @@ namespace actions {
 
 //////////////////////////////////////////////////////////////////////////////
 
+/// Computes the distance to the closest wall for every node of the mesh, in the field "wall_distance".
+/// The closest wall node is found using a k-d tree, after which the distance is computed by projection onto the
+/// adjacent wall elements. When global_wall is enabled, the wall elements owned by the other ranks are gathered first,
+/// so the distance is correct near partition boundaries.
+/// The table "node_to_wall_element" links each node to the local wall element it was projected on (column 0 is 1,
+/// followed by the index in the "wall_node_connectivity" entities and the element index), or to the closest local
+/// wall node (column 0 is 0). Nodes that are closest to a wall on another rank refer to the closest local wall node
+/// instead, or have 2 in column 0 if this rank has no wall nodes at all.
 class WallDistance : public MeshTransformer
 {
 public:
@@ -12,6 +12,7 @@
 #include "common/BoostFilesystem.hpp"
 #include "common/Foreach.hpp"
 #include "common/OptionList.hpp"
+#include "common/OptionT.hpp"
 #include "common/Log.hpp"
 #include "common/PE/Comm.hpp"
 #include "common/Builder.hpp"
@@ -162,7 +163,9 @@ namespace detail
 Writer::Writer( const std::string& name )
 : MeshWriter(name)
 {
-
+  options().add("asynchronous", false)
+    .pretty_name("Asynchronous")
+    .description("Compress and write the mesh data on the output thread. The data index is completed when the output thread is flushed.");
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -186,6 +189,7 @@ void Writer::write()
   boost::shared_ptr<common::BinaryDataWriter> data_writer = common::allocate_component<common::BinaryDataWriter>("DataWriter");
   const common::URI binfile = m_file_path.base_path() / (m_file_path.base_name() + ".cfbinxml");
   data_writer->options().set("file", binfile);
+  data_writer->options().set("asynchronous", options().value<bool>("asynchronous"));
   
   common::XML::XmlDoc xml_doc("1.0", "ISO-8859-1");
   common::XML::XmlNode mesh_node = xml_doc.add_node("mesh");
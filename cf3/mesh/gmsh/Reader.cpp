@@ -4,6 +4,12 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/foreach.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/regex.hpp>
@@ -19,7 +25,9 @@
 #include "common/Table.hpp"
 #include "common/List.hpp"
 #include "common/DynTable.hpp"
+#include "common/ThreadPool.hpp"
 
+#include "common/PE/Comm.hpp"
 #include "common/PE/debug.hpp"
 
 #include "math/Consts.hpp"
@@ -49,13 +57,300 @@ namespace gmsh {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+
+/// Powers of ten that are exactly representable as a double
+const Real exact_powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+/// Reads from a range of the memory-mapped file. Section names, headers and the data of ASCII files are parsed as text,
+/// the data of binary files is read in the native byte order.
+struct Cursor
+{
+  Cursor(const char* begin, const char* end, const bool binary = false) : p(begin), end(end), binary(binary) {}
+
+  static bool is_space(const char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+  static bool is_digit(const char c) { return c >= '0' && c <= '9'; }
+
+  void skip_spaces()
+  {
+    while(p != end && is_space(*p))
+      ++p;
+  }
+
+  bool at_end()
+  {
+    skip_spaces();
+    return p == end;
+  }
+
+  void skip_line()
+  {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    p = eol ? eol + 1 : end;
+  }
+
+  void skip_lines(const Uint nb_lines)
+  {
+    for(Uint i = 0; i != nb_lines && p != end; ++i)
+      skip_line();
+  }
+
+  /// Rest of the current line, without trailing white space
+  std::string read_line()
+  {
+    const char* begin = p;
+    skip_line();
+    const char* last = p;
+    while(last != begin && is_space(*(last-1)))
+      --last;
+    return std::string(begin, last);
+  }
+
+  std::string read_word()
+  {
+    skip_spaces();
+    const char* begin = p;
+    while(p != end && !is_space(*p))
+      ++p;
+    if(begin == p)
+      throw ParsingFailed(FromHere(), "Unexpected end of Gmsh file");
+    return std::string(begin, p);
+  }
+
+  void skip_word()
+  {
+    skip_spaces();
+    while(p != end && !is_space(*p))
+      ++p;
+  }
+
+  Uint read_uint()
+  {
+    skip_spaces();
+    if(p == end || !is_digit(*p))
+      throw ParsingFailed(FromHere(), "Expected an unsigned integer in Gmsh file, found \"" + std::string(p, std::min(p + 16, end)) + "\"");
+    Uint result = 0;
+    for(; p != end && is_digit(*p); ++p)
+      result = 10*result + static_cast<Uint>(*p - '0');
+    return result;
+  }
+
+  /// Parse a floating point number. Numbers with a mantissa that fits in a double and a small exponent, like the ones
+  /// written by Gmsh, are converted exactly without the C library. Other numbers are passed to strtod.
+  Real read_real()
+  {
+    skip_spaces();
+    const char* start = p;
+    const bool negative = p != end && *p == '-';
+    if(p != end && (*p == '-' || *p == '+'))
+      ++p;
+
+    boost::uint64_t mantissa = 0;
+    Uint nb_mantissa_digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    bool truncated = false;
+    bool in_fraction = false;
+    for(; p != end; ++p)
+    {
+      if(is_digit(*p))
+      {
+        has_digits = true;
+        if(nb_mantissa_digits < 19)
+        {
+          mantissa = 10*mantissa + static_cast<boost::uint64_t>(*p - '0');
+          if(mantissa != 0)
+            ++nb_mantissa_digits;
+          if(in_fraction)
+            --exponent;
+        }
+        else
+        {
+          truncated = truncated || *p != '0';
+          if(!in_fraction)
+            ++exponent;
+        }
+      }
+      else if(*p == '.' && !in_fraction)
+      {
+        in_fraction = true;
+      }
+      else
+      {
+        break;
+      }
+    }
+
+    if(has_digits && p != end && (*p == 'e' || *p == 'E'))
+    {
+      ++p;
+      const bool negative_exponent = p != end && *p == '-';
+      if(p != end && (*p == '-' || *p == '+'))
+        ++p;
+      has_digits = p != end && is_digit(*p);
+      int exponent_value = 0;
+      for(; p != end && is_digit(*p); ++p)
+      {
+        if(exponent_value < 10000)
+          exponent_value = 10*exponent_value + (*p - '0');
+      }
+      exponent += negative_exponent ? -exponent_value : exponent_value;
+    }
+
+    const boost::uint64_t max_exact_mantissa = boost::uint64_t(1) << 53;
+    if(has_digits && !truncated && mantissa <= max_exact_mantissa && exponent >= -22 && exponent <= 22)
+    {
+      const Real value = exponent < 0 ? static_cast<Real>(mantissa) / exact_powers_of_ten[-exponent]
+                                      : static_cast<Real>(mantissa) * exact_powers_of_ten[exponent];
+      return negative ? -value : value;
+    }
+
+    // Fall back to the C library for everything else, including inf and nan
+    char buffer[64];
+    p = start;
+    while(p != end && !is_space(*p) && p - start < 63)
+      ++p;
+    std::copy(start, p, buffer);
+    buffer[p - start] = '\0';
+    char* conversion_end;
+    const Real value = std::strtod(buffer, &conversion_end);
+    if(conversion_end == buffer)
+      throw ParsingFailed(FromHere(), "Expected a real number in Gmsh file, found \"" + std::string(buffer) + "\"");
+    p = start + (conversion_end - buffer);
+    return value;
+  }
+
+  template<typename T>
+  T read_binary()
+  {
+    if(end - p < static_cast<std::ptrdiff_t>(sizeof(T)))
+      throw ParsingFailed(FromHere(), "Unexpected end of binary data in Gmsh file");
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+  }
+
+  void skip_binary(const std::size_t nb_bytes)
+  {
+    if(static_cast<std::size_t>(end - p) < nb_bytes)
+      throw ParsingFailed(FromHere(), "Unexpected end of binary data in Gmsh file");
+    p += nb_bytes;
+  }
+
+  /// Read an integer from a data block
+  Uint read_data_uint()
+  {
+    return binary ? static_cast<Uint>(read_binary<int>()) : read_uint();
+  }
+
+  /// Read a real from a data block
+  Real read_data_real()
+  {
+    return binary ? read_binary<double>() : read_real();
+  }
+
+  /// Skip reals in a data block. Text data is skipped by finish_line.
+  void skip_data_reals(const Uint nb_reals)
+  {
+    if(binary)
+      skip_binary(nb_reals*sizeof(double));
+  }
+
+  /// Go to the next line of text data. Binary data has no line ends.
+  void finish_line()
+  {
+    if(!binary)
+      skip_line();
+  }
+
+  /// Move past the first line starting with keyword. Returns false if no such line exists.
+  bool find_line(const std::string& keyword)
+  {
+    const char* start = p;
+    while(p != end)
+    {
+      const char* found = static_cast<const char*>(std::memchr(p, keyword[0], end - p));
+      if(!found)
+        break;
+      p = found + 1;
+      if(found != start && found[-1] != '\n')
+        continue;
+      if(static_cast<std::size_t>(end - found) < keyword.size() || !std::equal(keyword.begin(), keyword.end(), found))
+        continue;
+      const char* after = found + keyword.size();
+      if(after != end && !is_space(*after))
+        continue;
+      p = after;
+      skip_line();
+      return true;
+    }
+    p = end;
+    return false;
+  }
+
+  const char* p;
+  const char* end;
+  bool binary;
+};
+
+/// Range [begin, end) of the objects owned by this rank. The objects owned by a rank are contiguous.
+void owned_range(const ParallelDistribution& distribution, const Uint nb_obj, Uint& begin, Uint& end)
+{
+  const Uint rank = PE::Comm::instance().rank();
+  Uint low = 0;
+  Uint high = nb_obj;
+  while(low < high)
+  {
+    const Uint mid = low + (high - low) / 2;
+    if(distribution.proc_of_obj(mid) < rank)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  begin = low;
+  high = nb_obj;
+  while(low < high)
+  {
+    const Uint mid = low + (high - low) / 2;
+    if(distribution.proc_of_obj(mid) <= rank)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  end = low;
+}
+
+/// Split the text in [begin, end) in nb_chunks parts of about equal size, each starting at the beginning of a line
+void split_lines(const char* begin, const char* end, const Uint nb_chunks, std::vector<const char*>& boundaries)
+{
+  boundaries.resize(nb_chunks + 1);
+  boundaries.front() = begin;
+  boundaries.back() = end;
+  for(Uint i = 1; i < nb_chunks; ++i)
+  {
+    const char* guess = begin + (end - begin) * static_cast<std::ptrdiff_t>(i) / static_cast<std::ptrdiff_t>(nb_chunks);
+    Cursor cursor(std::max(guess - 1, boundaries[i-1]), end);
+    if(cursor.p != begin)
+      cursor.skip_line();
+    boundaries[i] = cursor.p;
+  }
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
 cf3::common::ComponentBuilder < gmsh::Reader, MeshReader, LibGmsh> aGmshReader_Builder;
 
 //////////////////////////////////////////////////////////////////////////////
 
 Reader::Reader( const std::string& name )
 : MeshReader(name),
-  Shared()
+  Shared(),
+  m_binary(false)
 {
 
   // options
@@ -73,6 +368,10 @@ Reader::Reader( const std::string& name )
       .pretty_name("Read Fields")
       .mark_basic();
 
+  options().add("nb_threads", 1u)
+      .description("Number of threads used to parse the nodes and elements")
+      .pretty_name("Number of Threads");
+
   // properties
 
   properties()["brief"] = std::string("Gmsh file reader component");
@@ -80,6 +379,7 @@ Reader::Reader( const std::string& name )
   std::string desc;
   desc += "This component can read in parallel.\n";
   desc += "It can also read multiple files in serial, combining them in one large mesh.\n";
+  desc += "Both the ASCII and binary variants of the Gmsh 2 format are supported.\n";
   desc += "Available coolfluid-element types are:\n";
   boost_foreach(const std::string& supported_type, m_supported_types)
   desc += "  - " + supported_type + "\n";
@@ -107,7 +407,7 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
   if( boost::filesystem::exists(fp) )
   {
     CFinfo <<  "Opening file " <<  fp.string() << CFendl;
-    m_file.open(fp,std::ios_base::in); // exists so open it
+    m_file.open(fp.string()); // exists so map it into memory
   }
   else // doesnt exist so throw exception
   {
@@ -141,13 +441,12 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
     read_node_data();
   }
 
+  // clean-up
   m_node_idx_gmsh_to_cf.clear();
   m_elem_idx_gmsh_to_cf.clear();
-
-  // clean-up
-  m_ghost_nodes.clear();
+  m_element_tables.clear();
   m_used_nodes.clear();
-  m_node_idx_gmsh_to_cf.clear();
+  m_binary_element_blocks.clear();
   if (is_not_null(m_hash))
     remove_component(*m_hash);
 
@@ -161,43 +460,55 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
 
 void Reader::get_file_positions()
 {
-  std::string region_names("$PhysicalNames");
-  std::string nodes("$Nodes");
-  std::string elements("$Elements");
-  std::string element_data("$ElementData");
-  std::string node_data("$NodeData");
-  std::string element_node_data("$ElementNodeData");
-
   m_element_data_positions.clear();
   m_node_data_positions.clear();
   m_element_node_data_positions.clear();
+  m_binary_element_blocks.clear();
   m_elements_position=0;
-  std::streampos p;
-  std::string line;
-  while (!m_file.eof())
+  m_binary = false;
+  m_nb_regions = 0;
+  m_region_list.clear();
+  m_mesh_dimension = options().value<Uint>("dimension");
+
+  const char* file_begin = m_file.data();
+  Cursor cursor(file_begin, file_begin + m_file.size());
+  while (!cursor.at_end())
   {
-    p = m_file.tellg();
-    getline(m_file,line);
-    if (line.find(region_names)!=std::string::npos) {
-      m_region_names_position=p;
-      m_file >> m_nb_regions;
-      m_region_list.resize(m_nb_regions);
+    const std::size_t position = cursor.p - file_begin;
+    const std::string line = cursor.read_line();
+    if (line.empty() || line[0] != '$')
+      continue;
+    const std::string section = line.substr(1);
 
-      m_nb_gmsh_elem_in_region.resize(m_nb_regions);
-      for(Uint ir = 0; ir < m_nb_regions; ++ir)
-      {
-        m_nb_gmsh_elem_in_region[ir].resize(Shared::nb_gmsh_types);
-        for(Uint type = 0; type < Shared::nb_gmsh_types; ++ type)
-           (m_nb_gmsh_elem_in_region[ir])[type] = 0;
-      }
+    if (section == "MeshFormat")
+    {
+      const std::string version = cursor.read_word();
+      const Uint file_type = cursor.read_uint();
+      const Uint data_size = cursor.read_uint();
+      if (version[0] != '2')
+        throw NotSupported(FromHere(), "Gmsh file format version " + version + " is not supported, only version 2 can be read");
+      if (data_size != sizeof(double))
+        throw ParsingFailed(FromHere(), "Gmsh files with data size " + to_str(data_size) + " are not supported");
+      cursor.skip_line();
+      m_binary = (file_type == 1);
+      // Binary files contain the integer 1, to detect the byte order
+      if (m_binary && cursor.read_binary<int>() != 1)
+        throw NotSupported(FromHere(), "Binary Gmsh file was written with a different byte order");
+    }
+    else if (section == "PhysicalNames")
+    {
+      m_region_names_position=position;
+      m_nb_regions = cursor.read_uint();
+      m_region_list.resize(m_nb_regions);
 
-      m_mesh_dimension = options().value<Uint>("dimension");
       for(Uint ir = 0; ir < m_nb_regions; ++ir)
       {
-        Uint phys_group_dimensionality;
-        Uint phys_group_index;
-        std::string phys_group_name;
-        m_file >> phys_group_dimensionality >> phys_group_index >> phys_group_name;
+        const Uint phys_group_dimensionality = cursor.read_uint();
+        const Uint phys_group_index = cursor.read_uint();
+        if (phys_group_index == 0 || phys_group_index > m_nb_regions)
+          throw ParsingFailed(FromHere(), "Physical group index " + to_str(phys_group_index) + " is out of range");
+        cursor.skip_spaces();
+        const std::string phys_group_name = cursor.read_line();
         m_region_list[phys_group_index-1].dim=phys_group_dimensionality;
         m_region_list[phys_group_index-1].index=phys_group_index;
         //The original name of the region in the mesh file has quotes, we want to strip them off
@@ -206,17 +517,19 @@ void Reader::get_file_positions()
         m_mesh_dimension = std::max(m_region_list[phys_group_index-1].dim,m_mesh_dimension);
       }
     }
-    else if (line.find(nodes)!=std::string::npos) {
-      m_coordinates_position=p;
-      m_file >> m_total_nb_nodes;
-//      CFinfo << "The total number of nodes is " << m_total_nb_nodes << CFendl;
+    else if (section == "Nodes")
+    {
+      m_coordinates_position=position;
+      m_total_nb_nodes = cursor.read_uint();
       if (m_total_nb_nodes == 0) throw ParsingFailed(FromHere(),"File contains no nodes");
+      cursor.skip_line();
+      if (m_binary)
+        cursor.skip_binary(static_cast<std::size_t>(m_total_nb_nodes) * (sizeof(int) + 3*sizeof(double)));
     }
-    else if (line.find(elements)!=std::string::npos)
+    else if (section == "Elements")
     {
-      m_elements_position = p;
-      m_file >> m_total_nb_elements;
-//      CFinfo << "The total number of elements is " << m_total_nb_elements << CFendl;
+      m_elements_position = position;
+      m_total_nb_elements = cursor.read_uint();
       if (m_total_nb_elements == 0) throw ParsingFailed(FromHere(),"File contains no elements");
       //Create a hash
       m_hash = create_component<MergedParallelDistribution>("hash");
@@ -225,43 +538,74 @@ void Reader::get_file_positions()
       num_obj[1] = m_total_nb_elements;
       m_hash->options().set("nb_parts",options().value<Uint>("nb_parts"));
       m_hash->options().set("nb_obj",num_obj);
+      cursor.skip_line();
 
-
-      Uint elem_idx, elem_type, nb_tags, phys_tag;
-
-      //Let's count how many elements of each type are present
-      for(Uint ie = 0; ie < m_total_nb_elements; ++ie)
+      if (m_binary)
       {
-          m_file >> elem_idx;
-          m_file >> elem_type;
-          m_file >> nb_tags;
-          m_file >> phys_tag;
-          cf3_assert(phys_tag > 0);
-          getline(m_file,line);
-          if (m_hash->subhash(ELEMS).owns(ie))
-            (m_nb_gmsh_elem_in_region[phys_tag-1])[elem_type]++;
-          m_region_list[phys_tag-1].element_types.insert(elem_type);
+        // Index the blocks of elements, so each rank and thread can go straight to its own elements
+        Uint nb_elements = 0;
+        while (nb_elements < m_total_nb_elements)
+        {
+          BinaryElementBlock block;
+          block.first_element = nb_elements;
+          block.type = cursor.read_binary<int>();
+          block.nb_elements = cursor.read_binary<int>();
+          block.nb_tags = cursor.read_binary<int>();
+          if (block.type == 0 || block.type >= Shared::nb_gmsh_types)
+            throw ParsingFailed(FromHere(), "Unknown Gmsh element type " + to_str(block.type));
+          block.offset = cursor.p - file_begin;
+          cursor.skip_binary(static_cast<std::size_t>(block.nb_elements) * sizeof(int) * (1 + block.nb_tags + Shared::m_nodes_in_gmsh_elem[block.type]));
+          m_binary_element_blocks.push_back(block);
+          nb_elements += block.nb_elements;
+        }
       }
     }
-    else if (line.find(element_data)!=std::string::npos)
-    {
-      m_element_data_positions.push_back(p);
-    }
-    else if (line.find(node_data)!=std::string::npos)
-    {
-      m_node_data_positions.push_back(p);
-    }
-    else if (line.find(element_node_data)!=std::string::npos)
+    else if (section == "ElementData" || section == "NodeData" || section == "ElementNodeData")
     {
-      m_element_node_data_positions.push_back(p);
+      std::vector<std::size_t>& positions = section == "ElementData" ? m_element_data_positions :
+                                            section == "NodeData"    ? m_node_data_positions :
+                                                                       m_element_node_data_positions;
+      positions.push_back(position);
+      if (m_binary)
+        cursor.p = file_begin + skip_binary_data(section, position);
     }
 
+    // Go to the end of the section. Unknown sections, such as $Comments, are skipped as well.
+    if (!cursor.find_line("$End" + section))
+      throw ParsingFailed(FromHere(), "Section $" + section + " is not terminated by $End" + section);
   }
   if (m_elements_position==0)
   {
     throw ParsingFailed(FromHere(),"File does not contain any elements");
   }
-  m_file.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t Reader::skip_binary_data(const std::string& section, const std::size_t position)
+{
+  std::map<std::string,Field> fields;
+  read_variable_header(position, fields);
+  const Field& field = fields.begin()->second;
+  const Uint nb_components = field.var_types.back();
+
+  const char* file_begin = m_file.data();
+  Cursor cursor(file_begin + field.file_data_positions.back(), file_begin + m_file.size(), true);
+  if (section == "ElementNodeData")
+  {
+    // Each entry has its own number of nodes
+    for (Uint e=0; e<field.nb_entries; ++e)
+    {
+      cursor.skip_binary(sizeof(int));
+      const Uint nb_nodes = cursor.read_binary<int>();
+      cursor.skip_data_reals(nb_nodes*nb_components);
+    }
+  }
+  else
+  {
+    cursor.skip_binary(static_cast<std::size_t>(field.nb_entries) * (sizeof(int) + nb_components*sizeof(double)));
+  }
+  return cursor.p - file_begin;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -287,215 +631,279 @@ Handle< Region > Reader::create_region(std::string const& relative_path)
 
 void Reader::find_used_nodes()
 {
-  m_used_nodes.clear();
-  std::string line;
-
-  m_file.seekg(m_elements_position,std::ios::beg);
-  // skip next line
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "header = " << line << std::endl;
-  //Skip the line containing the actual number of elements
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "nb_elems = " << line << std::endl;
-
-  // read every line and store the connectivity in the correct region through the buffer
-  Uint elementNumber, elementType, nbElementNodes;
-  Uint gmsh_node_number, nb_tags, phys_tag, other_tag;
-
-  std::set<Uint>::iterator it=m_used_nodes.begin();
-
-//  if (PE::Comm::instance().rank()==IO_rank)
-//  {
-//    std::cout << "nb_obj = "   << m_hash->subhash(ELEMS).options()["nb_obj"].value<Uint>() << std::endl;
-//    std::cout << "nb_parts = " <<m_hash->subhash(ELEMS).options()["nb_parts"].value<Uint>() << std::endl;
-//  }
-  for (Uint i=0; i<m_total_nb_elements; ++i)
+  Uint owned_begin, owned_end;
+  owned_range(m_hash->subhash(ELEMS), m_total_nb_elements, owned_begin, owned_end);
+
+  const Uint nb_threads = std::max(options().value<Uint>("nb_threads"), 1u);
+  m_element_chunks.assign(nb_threads, ElementChunk());
+
+  // In an ASCII file, skip to the first element of this rank and split the lines of this rank over the threads
+  std::vector<const char*> line_boundaries;
+  if (!m_binary)
   {
-//    if (m_total_nb_elements > 100000)
-//    {
-//      if(i%(m_total_nb_elements/20)==0)
-//        CFinfo << 100*i/m_total_nb_elements << "% " << CFflush;
-//    }
-
-    cf3_assert(m_hash);
-    if (m_hash->subhash(ELEMS).owns(i))
-    {
-      // element description
-      m_file >> elementNumber >> elementType;
-      nbElementNodes = Shared::m_nodes_in_gmsh_elem[elementType];
-
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << i << ":  elem["<<m_hash->subhash(ELEMS).part_of_obj(i)<<"] " << elementNumber << " :    ";
-      m_file >> nb_tags;
-      m_file >> phys_tag;
-      for(Uint itag = 0; itag < (nb_tags-1); ++itag)
-          m_file >> other_tag;
-
-      for (Uint j=0; j<nbElementNodes; ++j)
-      {
-        m_file >> gmsh_node_number;
-        it = m_used_nodes.insert(it,gmsh_node_number);
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << "  " << gmsh_node_number;
-      }
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << "\n";
-    }
-    getline(m_file,line); // finnish the line
+    const char* file_begin = m_file.data();
+    Cursor cursor(file_begin + m_elements_position, file_begin + m_file.size());
+    // Skip the line with keyword '$Elements' and the line with the number of elements
+    cursor.skip_lines(2 + owned_begin);
+    const char* begin = cursor.p;
+    cursor.skip_lines(owned_end - owned_begin);
+    split_lines(begin, cursor.p, nb_threads, line_boundaries);
   }
 
-  // Now we have all nodes, used by the elements
+  ThreadPool::instance().run(nb_threads, boost::bind(&Reader::parse_elements_task, this, _1, _2, _3, boost::cref(line_boundaries), owned_begin, owned_end));
 
-  // Now add owned nodes
-  m_file.seekg(m_coordinates_position,std::ios::beg);
-  //Skip the line with keyword '$Nodes':
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "header = " << line << std::endl;
-  // skip one line, which says how many (total) nodes are  present in the mesh
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "nb_nodes = " << line << std::endl;
-
-  for (Uint node_idx=0; node_idx<m_total_nb_nodes; ++node_idx)
+  // Count the elements of each type in each region. All ranks must create the same element types in each region,
+  // so the types found on each rank are combined.
+  m_nb_gmsh_elem_in_region.assign(m_nb_regions, std::vector<Uint>(Shared::nb_gmsh_types, 0));
+  std::vector<int> type_in_region(m_nb_regions*Shared::nb_gmsh_types, 0);
+  boost_foreach(const ElementChunk& chunk, m_element_chunks)
   {
-//    if (m_total_nb_nodes > 100000)
-//    {
-//      if(node_idx%(m_total_nb_nodes/20)==0)
-//        CFinfo << 100*node_idx/m_total_nb_nodes << "% " << CFflush;
-//      if (node_idx == m_total_nb_nodes-1)
-//        CFinfo << CFendl;
-//    }
-    getline(m_file,line);
-
-    std::stringstream ss(line);
-    ss >> gmsh_node_number;
-    getline(ss,line);
-    if (m_hash->subhash(NODES).owns(node_idx))
+    for (Uint e=0; e<chunk.numbers.size(); ++e)
     {
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << "node " << gmsh_node_number << "\n";
-
-      it = m_used_nodes.insert(it,gmsh_node_number);
+      if (chunk.regions[e] >= m_nb_regions)
+        throw ParsingFailed(FromHere(), "Element " + to_str(chunk.numbers[e]) + " is not in a physical group listed in $PhysicalNames");
+      ++m_nb_gmsh_elem_in_region[chunk.regions[e]][chunk.types[e]];
+      type_in_region[chunk.regions[e]*Shared::nb_gmsh_types + chunk.types[e]] = 1;
     }
-    else
+  }
+
+  if (PE::Comm::instance().is_active() && !type_in_region.empty())
+    PE::Comm::instance().all_reduce(PE::max(), &type_in_region[0], type_in_region.size(), &type_in_region[0]);
+
+  for(Uint ir = 0; ir < m_nb_regions; ++ir)
+  {
+    for(Uint etype = 0; etype < Shared::nb_gmsh_types; ++etype)
     {
-      it = m_used_nodes.find(gmsh_node_number);
-      if (it != m_used_nodes.end())
-      {
-        m_ghost_nodes.insert(node_idx);
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << "ghostnode " << gmsh_node_number << "\n";
-      }
+      if (type_in_region[ir*Shared::nb_gmsh_types + etype])
+        m_region_list[ir].element_types.insert(etype);
     }
   }
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << std::flush;
+
+  // Now we have all nodes, used by the elements
+  m_used_nodes.clear();
+  boost_foreach(const ElementChunk& chunk, m_element_chunks)
+    m_used_nodes.insert(m_used_nodes.end(), chunk.nodes.begin(), chunk.nodes.end());
+  std::sort(m_used_nodes.begin(), m_used_nodes.end());
+  m_used_nodes.erase(std::unique(m_used_nodes.begin(), m_used_nodes.end()), m_used_nodes.end());
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
-void Reader::read_coordinates()
+void Reader::parse_elements_task(const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier,
+                                 const std::vector<const char*>& line_boundaries, const Uint owned_begin, const Uint owned_end)
 {
+  ElementChunk& chunk = m_element_chunks[thread_idx];
+  if (m_binary)
+  {
+    Uint begin, end;
+    ThreadPool::static_chunk(owned_end - owned_begin, thread_idx, nb_threads, begin, end);
+    parse_binary_elements(owned_begin + begin, owned_begin + end, chunk);
+  }
+  else
+  {
+    parse_text_elements(line_boundaries[thread_idx], line_boundaries[thread_idx+1], chunk);
+  }
+}
 
-  m_file.seekg(m_coordinates_position,std::ios::beg);
+//////////////////////////////////////////////////////////////////////////////
 
+void Reader::parse_text_elements(const char* begin, const char* end, ElementChunk& chunk) const
+{
+  // Each line is: number type nb_tags physical_tag other_tags... nodes...
+  Cursor cursor(begin, end);
+  while (!cursor.at_end())
+  {
+    chunk.numbers.push_back(cursor.read_uint());
+    const Uint type = cursor.read_uint();
+    if (type == 0 || type >= Shared::nb_gmsh_types)
+      throw ParsingFailed(FromHere(), "Unknown Gmsh element type " + to_str(type));
+    chunk.types.push_back(type);
+    const Uint nb_tags = cursor.read_uint();
+    if (nb_tags == 0)
+      throw ParsingFailed(FromHere(), "Element " + to_str(chunk.numbers.back()) + " has no physical tag");
+    chunk.regions.push_back(cursor.read_uint() - 1);
+    for (Uint itag = 1; itag < nb_tags; ++itag)
+      cursor.skip_word();
+    for (Uint j=0; j<Shared::m_nodes_in_gmsh_elem[type]; ++j)
+      chunk.nodes.push_back(cursor.read_uint());
+    cursor.skip_line();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Reader::parse_binary_elements(const Uint begin, const Uint end, ElementChunk& chunk) const
+{
+  if (begin == end)
+    return;
+
+  const char* file_begin = m_file.data();
+  const char* file_end = file_begin + m_file.size();
+  std::vector<BinaryElementBlock>::const_iterator block = m_binary_element_blocks.begin();
+  for (Uint e=begin; e<end; ++e)
+  {
+    while (e >= block->first_element + block->nb_elements)
+      ++block;
+
+    // Each element is: number tags... nodes...
+    const Uint nb_element_nodes = Shared::m_nodes_in_gmsh_elem[block->type];
+    const std::size_t element_size = sizeof(int) * (1 + block->nb_tags + nb_element_nodes);
+    Cursor cursor(file_begin + block->offset + (e - block->first_element)*element_size, file_end, true);
+    chunk.numbers.push_back(cursor.read_binary<int>());
+    chunk.types.push_back(block->type);
+    if (block->nb_tags == 0)
+      throw ParsingFailed(FromHere(), "Element " + to_str(chunk.numbers.back()) + " has no physical tag");
+    chunk.regions.push_back(cursor.read_binary<int>() - 1);
+    cursor.skip_binary((block->nb_tags - 1) * sizeof(int));
+    for (Uint j=0; j<nb_element_nodes; ++j)
+      chunk.nodes.push_back(cursor.read_binary<int>());
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Reader::read_coordinates()
+{
   Dictionary& nodes = m_mesh->geometry_fields();
-  nodes.resize(m_used_nodes.size());
-  m_used_nodes.clear();
+  const ParallelDistribution& node_distribution = m_hash->subhash(NODES);
 
   Uint part = options().value<Uint>("part");
+  const Uint nb_threads = std::max(options().value<Uint>("nb_threads"), 1u);
 
-  std::string line;
-  //Skip the line with keyword '$Nodes':
-  getline(m_file,line);
-//  CFinfo << line << CFendl;
-  // skip one line, which says how many (total) nodes are  present in the mesh
-  getline(m_file,line);
-//  CFinfo << line << CFendl;
+  Uint owned_begin, owned_end;
+  owned_range(node_distribution, m_total_nb_nodes, owned_begin, owned_end);
 
+  const char* file_begin = m_file.data();
+  const char* file_end = file_begin + m_file.size();
+  Cursor cursor(file_begin + m_coordinates_position, file_end);
+  // Skip the line with keyword '$Nodes' and the line with the number of nodes
+  cursor.skip_lines(2);
 
-  // declare and allocate one coordinate row
-//  std::vector<Real> rowVector(m_mesh_dimension);
+  std::vector<const char*> line_boundaries;
+  std::vector<Uint> binary_indices;
+  if (m_binary)
+  {
+    line_boundaries.assign(1, cursor.p);
+
+    // Gmsh normally numbers the nodes 1, 2, 3, ... In that case, only the nodes of this rank are read,
+    // without going through all nodes in the file
+    const std::size_t node_size = sizeof(int) + 3*sizeof(double);
+    binary_indices.reserve(owned_end - owned_begin + m_used_nodes.size());
+    for (Uint node_idx=owned_begin; node_idx<owned_end; ++node_idx)
+      binary_indices.push_back(node_idx);
+    boost_foreach(const Uint gmsh_node_number, m_used_nodes)
+    {
+      const Uint node_idx = gmsh_node_number - 1;
+      int stored_number = 0;
+      if (gmsh_node_number != 0 && node_idx < m_total_nb_nodes)
+        std::memcpy(&stored_number, cursor.p + node_idx*node_size, sizeof(int));
+      if (static_cast<Uint>(stored_number) != gmsh_node_number)
+      {
+        // Check all nodes in the file
+        binary_indices.clear();
+        break;
+      }
+      if (node_idx < owned_begin || node_idx >= owned_end)
+        binary_indices.push_back(node_idx);
+    }
+    std::inplace_merge(binary_indices.begin(), binary_indices.begin() + std::min<std::size_t>(owned_end - owned_begin, binary_indices.size()), binary_indices.end());
+  }
+  else
+  {
+    const char* begin = cursor.p;
+    cursor.skip_lines(m_total_nb_nodes);
+    split_lines(begin, cursor.p, nb_threads, line_boundaries);
+  }
 
-  std::set<Uint>::const_iterator it;
+  std::vector<NodeChunk> chunks(nb_threads);
+  ThreadPool::instance().run(nb_threads, boost::bind(&Reader::parse_nodes_task, this, _1, _2, _3, boost::cref(line_boundaries), boost::cref(binary_indices),
+                                                     boost::ref(chunks), owned_begin, owned_end));
 
-  Uint coord_idx=0;
-  Uint gmsh_node_number;
+  Uint nb_nodes = 0;
+  boost_foreach(const NodeChunk& chunk, chunks)
+    nb_nodes += chunk.numbers.size();
+  nodes.resize(nb_nodes);
 
-  for (Uint node_idx=0; node_idx<m_total_nb_nodes; ++node_idx)
+  // Number the nodes in the order of the file
+  m_node_idx_gmsh_to_cf.clear();
+  m_node_idx_gmsh_to_cf.reserve(nb_nodes);
+  Uint coord_idx=0;
+  boost_foreach(const NodeChunk& chunk, chunks)
   {
-//    if (m_total_nb_nodes > 100000)
-//    {
-//      if(node_idx%(m_total_nb_nodes/20)==0)
-//        CFinfo << 100*node_idx/m_total_nb_nodes << "% " << CFflush;
-//      if(node_idx==m_total_nb_nodes-1)
-//        CFinfo << CFendl;
-//    }
-    getline(m_file,line);
-//    CFinfo << line << CFendl;
-    if (m_hash->subhash(NODES).owns(node_idx))
+    for (Uint i=0; i<chunk.numbers.size(); ++i, ++coord_idx)
     {
-      std::stringstream ss(line);
-      ss >> gmsh_node_number;
-      m_node_idx_gmsh_to_cf[gmsh_node_number]=coord_idx;
-
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << gmsh_node_number << " --> " << coord_idx << std::endl;
+      const Uint node_idx = chunk.indices[i];
+      const Uint gmsh_node_number = chunk.numbers[i];
+      m_node_idx_gmsh_to_cf.push_back(std::make_pair(gmsh_node_number, coord_idx));
 
+      //Gmsh always stores 3 coordinates, even for 2D meshes
       for (Uint dim=0; dim<m_mesh_dimension; ++dim)
-        ss >> nodes.coordinates()[coord_idx][dim];
-      if(m_mesh_dimension < DIM_3D) getline(ss,line); //Gmsh always stores 3 coordinates, even for 2D meshes
+        nodes.coordinates()[coord_idx][dim] = chunk.coordinates[3*i+dim];
 
-      nodes.rank()[coord_idx] = part;
+      const bool owned = node_idx >= owned_begin && node_idx < owned_end;
+      nodes.rank()[coord_idx] = owned ? part : node_distribution.part_of_obj(node_idx);
       nodes.glb_idx()[coord_idx] = gmsh_node_number-1;
-
-      coord_idx++;
     }
-    else
-    {
-      it = m_ghost_nodes.find(node_idx);
-      if (it != m_ghost_nodes.end())
-      {
-        std::stringstream ss(line);
-        ss >> gmsh_node_number;
-        m_node_idx_gmsh_to_cf[gmsh_node_number]=coord_idx;
+  }
+  std::sort(m_node_idx_gmsh_to_cf.begin(), m_node_idx_gmsh_to_cf.end());
 
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << gmsh_node_number << " --> " << coord_idx << std::endl;
+  std::vector<Uint>().swap(m_used_nodes);
+}
 
-        for (Uint dim=0; dim<m_mesh_dimension; ++dim)
-        ss >> nodes.coordinates()[coord_idx][dim];
-        if(m_mesh_dimension < DIM_3D) getline(ss, line);
+//////////////////////////////////////////////////////////////////////////////
 
-        nodes.rank()[coord_idx] = m_hash->subhash(NODES).part_of_obj(node_idx);
-        nodes.glb_idx()[coord_idx] = gmsh_node_number-1;
+void Reader::parse_nodes_task(const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier,
+                              const std::vector<const char*>& line_boundaries, const std::vector<Uint>& binary_indices,
+                              std::vector<NodeChunk>& chunks, const Uint owned_begin, const Uint owned_end) const
+{
+  NodeChunk& chunk = chunks[thread_idx];
+  const char* file_end = m_file.data() + m_file.size();
 
-        coord_idx++;
-      }
+  if (m_binary)
+  {
+    // Each node is: number x y z
+    const std::size_t node_size = sizeof(int) + 3*sizeof(double);
+    const bool check_all = binary_indices.empty();
+    Uint begin, end;
+    ThreadPool::static_chunk(check_all ? m_total_nb_nodes : binary_indices.size(), thread_idx, nb_threads, begin, end);
+    for (Uint i=begin; i<end; ++i)
+    {
+      const Uint node_idx = check_all ? i : binary_indices[i];
+      Cursor cursor(line_boundaries[0] + node_idx*node_size, file_end, true);
+      const Uint gmsh_node_number = cursor.read_binary<int>();
+      if (check_all && (node_idx < owned_begin || node_idx >= owned_end) && !std::binary_search(m_used_nodes.begin(), m_used_nodes.end(), gmsh_node_number))
+        continue;
+      chunk.indices.push_back(node_idx);
+      chunk.numbers.push_back(gmsh_node_number);
+      for (Uint dim=0; dim<3; ++dim)
+        chunk.coordinates.push_back(cursor.read_binary<double>());
     }
-
-
-  } //loop over nodes
-
-
-
-  /*
-  CFinfo << "Printing all nodal coordinates:" << CFendl;
-  for(Uint i = 0; i < m_total_nb_nodes; ++i)
+  }
+  else
   {
-      CFinfo << "\t";
-      for(Uint dim = 0; dim < m_mesh_dimension; ++dim)
-        {
-            CFinfo << nodes.coordinates()[i][dim] << " ";
-        }
-      CFinfo << CFendl;
+    // The index of the first node of each chunk follows from the number of lines in the chunks before it
+    const char* begin = line_boundaries[thread_idx];
+    const char* end = line_boundaries[thread_idx+1];
+    chunk.nb_lines = std::count(begin, end, '\n');
+    barrier.wait();
+    Uint node_idx = 0;
+    for (Uint i=0; i<thread_idx; ++i)
+      node_idx += chunks[i].nb_lines;
+
+    Cursor cursor(begin, end);
+    for (; !cursor.at_end(); ++node_idx)
+    {
+      const Uint gmsh_node_number = cursor.read_uint();
+      if ((node_idx >= owned_begin && node_idx < owned_end) || std::binary_search(m_used_nodes.begin(), m_used_nodes.end(), gmsh_node_number))
+      {
+        chunk.indices.push_back(node_idx);
+        chunk.numbers.push_back(gmsh_node_number);
+        for (Uint dim=0; dim<3; ++dim)
+          chunk.coordinates.push_back(cursor.read_real());
+      }
+      cursor.skip_line();
+    }
   }
-  */
-
-  getline(m_file,line);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -508,34 +916,17 @@ void Reader::read_connectivity()
 
   Uint part = options().value<Uint>("part");
 
-  //Each entry of this vector holds a map (gmsh_type_idx, pointer to connectivity table of this gmsh type).
- //Each row corresponds to one region of the mesh
- std::vector<std::map<Uint, Entities* > > conn_table_idx;
- conn_table_idx.resize(m_nb_regions);
- for(Uint ir = 0; ir < m_nb_regions; ++ir)
- {
-    conn_table_idx[ir].clear();
- }
-
- std::map<Uint, Entities*>::iterator elem_table_iter;
-
-// std::vector<std::map<std::string,Handle< Elements > > > elements(m_nb_regions);
-// std::vector<std::map<std::string,Handle< Connectivity::Buffer > > > buffer(m_nb_regions);
-
+ //For each region and gmsh type, the index of the element table in m_element_tables
+ std::vector<Uint> table_of_type(m_nb_regions*Shared::nb_gmsh_types, 0);
+ m_element_tables.clear();
 
- m_elem_idx_gmsh_to_cf.clear();
  //Loop over all regions and allocate a connectivity table of proper size for each element type that
- //is present in each region. Counting of elements was done during the first pass in the function
- //get_file_positions
+ //is present in each region. Counting of elements was done in find_used_nodes
  for(Uint ir = 0; ir < m_nb_regions; ++ir)
  {
    // create new region
    Handle< Region > region = m_region_list[ir].region;
 
-//   elements[ir] = create_cells_in_region(*region,m_mesh->geometry_fields(),m_supported_types);
-//   buffer[ir] = create_connectivity_buffermap(elements[ir]);
-
-
    // Take the gmsh element types present in this region and generate new names of elements which correspond
    // to coolfuid naming:
    for(Uint etype = 0; etype < Shared::nb_gmsh_types; ++etype)
@@ -560,97 +951,96 @@ void Reader::read_connectivity()
        elem_table.resize((m_nb_gmsh_elem_in_region[ir])[etype]);
        elements->rank().resize(m_nb_gmsh_elem_in_region[ir][etype]);
        elements->glb_idx().resize(m_nb_gmsh_elem_in_region[ir][etype]);
-       conn_table_idx[ir].insert(std::pair<Uint,Entities*>(etype,elements.get()));
+       table_of_type[ir*Shared::nb_gmsh_types + etype] = m_element_tables.size();
+       m_element_tables.push_back(Handle<Elements>(elements));
      }
    }
  }
 
-   std::string etype_CF;
-   std::set<Uint>::const_iterator it;
-   std::vector<Uint> cf_element;
-   Uint element_number, gmsh_element_type, nb_element_nodes;
-   Uint gmsh_node_number, nb_tags, phys_tag, other_tag;
-   Uint cf_node_number;
-   Uint cf_idx;
-
-   m_file.seekg(m_elements_position,std::ios::beg);
-   // skip next line
-   std::string line;
-   //Re-read the line that contains the keyword '$Elements':
-   getline(m_file,line);
-   //Parse the following line (containing the actual number of elements)
-   getline(m_file,line);
-
-   for(Uint ir = 0; ir < m_nb_regions; ++ir)
-     for(Uint etype = 0; etype < Shared::nb_gmsh_types; ++etype)
-      (m_nb_gmsh_elem_in_region[ir])[etype] = 0;
-
-  for (Uint i=0; i<m_total_nb_elements; ++i)
+  // The first row of each chunk in each table, so the threads fill the rows in the same order as a serial read
+  const Uint nb_chunks = m_element_chunks.size();
+  std::vector< std::vector<Uint> > chunk_rows(nb_chunks);
+  std::vector<Uint> chunk_begin(nb_chunks+1, 0);
+  std::vector<Uint> nb_rows(m_element_tables.size(), 0);
+  for (Uint c=0; c<nb_chunks; ++c)
   {
-//    if (m_total_nb_elements > 100000)
-//    {
-//      if(i%(m_total_nb_elements/20)==0)
-//        CFinfo << 100*i/m_total_nb_elements << "% " << CFflush;
-//      if(i==m_total_nb_elements-1)
-//        CFinfo << CFendl;
-//    }
-
-    // element description
-    m_file >> element_number >> gmsh_element_type;
-
-    nb_element_nodes = Shared::m_nodes_in_gmsh_elem[gmsh_element_type];
-
-    // get element nodes
-    if (m_hash->subhash(ELEMS).owns(i))
-    {
-      m_file >> nb_tags;
-      m_file >> phys_tag;
-      for(Uint itag = 0; itag < (nb_tags-1); ++itag)
-          m_file >> other_tag;
-
-//      CFinfo << "Reading element " << element_number << " of type " << gmsh_element_type;
-//      CFinfo << " in region " << phys_tag << " with " << nb_element_nodes << " nodes " << CFendl;
+    const ElementChunk& chunk = m_element_chunks[c];
+    chunk_rows[c] = nb_rows;
+    chunk_begin[c+1] = chunk_begin[c] + chunk.numbers.size();
+    for (Uint e=0; e<chunk.numbers.size(); ++e)
+      ++nb_rows[table_of_type[chunk.regions[e]*Shared::nb_gmsh_types + chunk.types[e]]];
+  }
 
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << element_number << "   -->   ";
+  m_elem_idx_gmsh_to_cf.resize(chunk_begin.back());
+  ThreadPool::instance().run(nb_chunks, boost::bind(&Reader::fill_connectivity_task, this, _1, _2, _3,
+                                                    boost::cref(table_of_type), boost::cref(chunk_rows), boost::cref(chunk_begin), part));
+  std::sort(m_elem_idx_gmsh_to_cf.begin(), m_elem_idx_gmsh_to_cf.end());
 
-      cf_element.resize(nb_element_nodes);
-      for (Uint j=0; j<nb_element_nodes; ++j)
-      {
-        cf_idx = Shared::m_nodes_gmsh_to_cf[gmsh_element_type][j];
-        m_file >> gmsh_node_number;
-        cf_node_number = m_node_idx_gmsh_to_cf[gmsh_node_number];
-        cf_element[cf_idx] = cf_node_number;
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << "  " << gmsh_node_number << "("<<m_node_idx_gmsh_to_cf[gmsh_node_number]<<")";
-      }
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << std::endl;
+  std::vector<ElementChunk>().swap(m_element_chunks);
+}
 
-      elem_table_iter = conn_table_idx[phys_tag-1].find(gmsh_element_type);
-      const Uint row_idx = (m_nb_gmsh_elem_in_region[phys_tag-1])[gmsh_element_type];
+//////////////////////////////////////////////////////////////////////////////
 
-      Handle< Elements > elements_region = Handle<Elements>(elem_table_iter->second->handle<Component>());
-      Connectivity::Row element_nodes = elements_region->geometry_space().connectivity()[row_idx];
+void Reader::fill_connectivity_task(const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier,
+                                    const std::vector<Uint>& table_of_type, const std::vector< std::vector<Uint> >& chunk_rows,
+                                    const std::vector<Uint>& chunk_begin, const Uint part)
+{
+  const ElementChunk& chunk = m_element_chunks[thread_idx];
+  std::vector<Uint> next_row = chunk_rows[thread_idx];
+  Uint node_begin = 0;
+  for (Uint e=0; e<chunk.numbers.size(); ++e)
+  {
+    const Uint gmsh_element_type = chunk.types[e];
+    const Uint nb_element_nodes = Shared::m_nodes_in_gmsh_elem[gmsh_element_type];
+    const Uint table = table_of_type[chunk.regions[e]*Shared::nb_gmsh_types + gmsh_element_type];
+    const Uint row_idx = next_row[table]++;
+
+    Elements& elements_region = *m_element_tables[table];
+    Connectivity::Row element_nodes = elements_region.geometry_space().connectivity()[row_idx];
+    for (Uint j=0; j<nb_element_nodes; ++j)
+    {
+      const Uint gmsh_node_number = chunk.nodes[node_begin + j];
+      Uint cf_node_number;
+      if (!find_node(gmsh_node_number, cf_node_number))
+        throw ParsingFailed(FromHere(), "Node " + to_str(gmsh_node_number) + " of element " + to_str(chunk.numbers[e]) + " is not in the file");
+      element_nodes[Shared::m_nodes_gmsh_to_cf[gmsh_element_type][j]] = cf_node_number;
+    }
+    node_begin += nb_element_nodes;
 
-      m_elem_idx_gmsh_to_cf[element_number] = std::make_pair( elements_region , row_idx);
+    elements_region.rank()[row_idx] = part;
+    elements_region.glb_idx()[row_idx] = chunk.numbers[e]-1;
 
-      for(Uint node = 0; node < nb_element_nodes; ++node)
-      {
-         element_nodes[node] = cf_element[node];
-      }
+    ElementLocation& location = m_elem_idx_gmsh_to_cf[chunk_begin[thread_idx] + e];
+    location.gmsh_idx = chunk.numbers[e];
+    location.table = table;
+    location.idx = row_idx;
+  }
+}
 
-      elements_region->rank()[row_idx] = part;
-      elements_region->glb_idx()[row_idx] = element_number-1;
+//////////////////////////////////////////////////////////////////////////////
 
-      (m_nb_gmsh_elem_in_region[phys_tag-1])[gmsh_element_type]++;
+bool Reader::find_node(const Uint gmsh_node, Uint& cf_idx) const
+{
+  std::vector< std::pair<Uint,Uint> >::const_iterator it =
+      std::lower_bound(m_node_idx_gmsh_to_cf.begin(), m_node_idx_gmsh_to_cf.end(), std::make_pair(gmsh_node, Uint(0)));
+  if (it == m_node_idx_gmsh_to_cf.end() || it->first != gmsh_node)
+    return false;
+  cf_idx = it->second;
+  return true;
+}
 
-    }
+//////////////////////////////////////////////////////////////////////////////
 
-    // finish the line
-    getline(m_file,line);
-  }
-  getline(m_file,line);  // ENDOFSECTION
+bool Reader::find_element(const Uint gmsh_elem, Handle<Elements>& elements, Uint& cf_idx) const
+{
+  ElementLocation key;
+  key.gmsh_idx = gmsh_elem;
+  std::vector<ElementLocation>::const_iterator it = std::lower_bound(m_elem_idx_gmsh_to_cf.begin(), m_elem_idx_gmsh_to_cf.end(), key);
+  if (it == m_elem_idx_gmsh_to_cf.end() || it->gmsh_idx != gmsh_elem)
+    return false;
+  elements = m_element_tables[it->table];
+  cf_idx = it->idx;
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -676,10 +1066,9 @@ void Reader::read_element_node_data()
 
   std::map<std::string,Reader::Field> gmsh_fields;
 
-  boost_foreach(std::streampos element_node_data_position, m_element_node_data_positions)
+  boost_foreach(const std::size_t element_node_data_position, m_element_node_data_positions)
   {
-    m_file.seekg(element_node_data_position,std::ios::beg);
-    read_variable_header(gmsh_fields);
+    read_variable_header(element_node_data_position, gmsh_fields);
   }
 
 
@@ -716,25 +1105,21 @@ void Reader::read_element_node_data()
         CFdebug << "Reading " << field.name() << "/" << field.var_name(var) <<"["<<static_cast<Uint>(field.var_length(var))<<"]" << CFendl;
         Uint var_begin = field.var_offset(var);
         Uint var_end = var_begin + static_cast<Uint>(field.var_length(var));
-        m_file.seekg(gmsh_field.file_data_positions[var]);
+        Cursor cursor(m_file.data() + gmsh_field.file_data_positions[var], m_file.data() + m_file.size(), m_binary);
 
-        std::string line;
         Uint gmsh_elem_idx;
         Uint gmsh_nb_elem_nodes;
         Uint cf_idx;
         Handle< Elements > elements;
-        Handle< Space > space;
         Uint d,n;
         std::vector<Real> data(gmsh_field.var_types[var]);
-        std::map<Uint, std::pair<Handle< Elements >,Uint> >::iterator it;
         for (Uint e=0; e<gmsh_field.nb_entries; ++e)
         {
-          m_file >> gmsh_elem_idx >> gmsh_nb_elem_nodes;
+          gmsh_elem_idx = cursor.read_data_uint();
+          gmsh_nb_elem_nodes = cursor.read_data_uint();
 
-          it = m_elem_idx_gmsh_to_cf.find(gmsh_elem_idx);
-          if (it != m_elem_idx_gmsh_to_cf.end())
+          if (find_element(gmsh_elem_idx, elements, cf_idx))
           {
-            boost::tie(elements,cf_idx) = it->second;
             const Space& space = elements->space(*dict);
 
             cf3_assert(elements->element_type().nb_nodes() == gmsh_nb_elem_nodes);
@@ -743,7 +1128,7 @@ void Reader::read_element_node_data()
             {
 
               for (d=0; d<data.size(); ++d)
-                m_file >> data[d];
+                data[d] = cursor.read_data_real();
 
               mesh::Field::Row field_data = field[space.connectivity()[cf_idx][n]] ;
 
@@ -757,7 +1142,11 @@ void Reader::read_element_node_data()
                 field_data[v] = data[d++];
             }
           }
-          getline(m_file,line); // finish line
+          else
+          {
+            cursor.skip_data_reals(gmsh_nb_elem_nodes*data.size());
+          }
+          cursor.finish_line();
         }
       }
     }
@@ -788,10 +1177,9 @@ void Reader::read_element_data()
 
   std::map<std::string,Reader::Field> fields;
 
-  boost_foreach(std::streampos element_data_position, m_element_data_positions)
+  boost_foreach(const std::size_t element_data_position, m_element_data_positions)
   {
-    m_file.seekg(element_data_position,std::ios::beg);
-    read_variable_header(fields);
+    read_variable_header(element_data_position, fields);
   }
 
   if (fields.size())
@@ -810,7 +1198,7 @@ void Reader::read_element_data()
         CFdebug << "Reading " << field.name() << "/" << field.var_name(i) <<"["<<static_cast<Uint>(field.var_length(i))<<"]" << CFendl;
         Uint var_begin = field.var_offset(i);
         Uint var_end = var_begin + static_cast<Uint>(field.var_length(i));
-        m_file.seekg(gmsh_field.file_data_positions[i]);
+        Cursor cursor(m_file.data() + gmsh_field.file_data_positions[i], m_file.data() + m_file.size(), m_binary);
 
 
         Uint gmsh_elem_idx;
@@ -821,15 +1209,12 @@ void Reader::read_element_data()
 
         for (Uint e=0; e<gmsh_field.nb_entries; ++e)
         {
-          m_file >> gmsh_elem_idx;
+          gmsh_elem_idx = cursor.read_data_uint();
           for (d=0; d<data.size(); ++d)
-            m_file >> data[d];
+            data[d] = cursor.read_data_real();
 
-          std::map<Uint, std::pair<Handle< Elements >,Uint> >::iterator it = m_elem_idx_gmsh_to_cf.find(gmsh_elem_idx);
-          if (it != m_elem_idx_gmsh_to_cf.end())
+          if (find_element(gmsh_elem_idx, elements, cf_idx))
           {
-            boost::tie(elements,cf_idx) = it->second;
-
             mesh::Field::Row field_data = field[field.space(*elements).connectivity()[cf_idx][0]] ;
 
             d=0;
@@ -866,10 +1251,9 @@ void Reader::read_node_data()
 
   std::map<std::string,Field> fields;
 
-  boost_foreach(std::streampos node_data_position, m_node_data_positions)
+  boost_foreach(const std::size_t node_data_position, m_node_data_positions)
   {
-    m_file.seekg(node_data_position,std::ios::beg);
-    read_variable_header(fields);
+    read_variable_header(node_data_position, fields);
   }
 
   foreach_container((const std::string& name) (Field& gmsh_field) , fields)
@@ -883,7 +1267,7 @@ void Reader::read_node_data()
       CFdebug << "Reading " << field.name() << "/" << field.var_name(i) <<"["<<static_cast<Uint>(field.var_length(i))<<"]" << CFendl;
       Uint var_begin = field.var_offset(i);
       Uint var_end = var_begin + static_cast<Uint>(field.var_length(i));
-      m_file.seekg(gmsh_field.file_data_positions[i]);
+      Cursor cursor(m_file.data() + gmsh_field.file_data_positions[i], m_file.data() + m_file.size(), m_binary);
 
       Uint gmsh_node_idx;
       Uint cf_idx;
@@ -892,14 +1276,12 @@ void Reader::read_node_data()
 
       for (Uint e=0; e<gmsh_field.nb_entries; ++e)
       {
-        m_file >> gmsh_node_idx;
+        gmsh_node_idx = cursor.read_data_uint();
         for (d=0; d<data.size(); ++d)
-          m_file >> data[d];
+          data[d] = cursor.read_data_real();
 
-        std::map<Uint, Uint>::iterator it = m_node_idx_gmsh_to_cf.find(gmsh_node_idx);
-        if (it != m_node_idx_gmsh_to_cf.end())
+        if (find_node(gmsh_node_idx, cf_idx))
         {
-          cf_idx = it->second;
           mesh::Field::Row field_data = field[cf_idx];
 
           if (var_end-var_begin == TENSOR_2D)
@@ -918,11 +1300,8 @@ void Reader::read_node_data()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Reader::read_variable_header(std::map<std::string,Field>& fields)
+void Reader::read_variable_header(const std::size_t position, std::map<std::string,Field>& fields)
 {
-  std::string line;
-  std::string dummy;
-
   Uint nb_string_tags(0);
   std::string var_name("field");
   std::string field_name("field");
@@ -934,64 +1313,65 @@ void Reader::read_variable_header(std::map<std::string,Field>& fields)
   Uint var_type(0);
   Uint nb_entries(0);
 
-  //Re-read the line that contains the keyword '$Elements':
-  getline(m_file,line);
+  const char* file_begin = m_file.data();
+  Cursor cursor(file_begin + position, file_begin + m_file.size());
+
+  //Skip the line that contains the section keyword
+  cursor.skip_line();
 
   // string tags
-  m_file >> nb_string_tags;
+  nb_string_tags = cursor.read_uint();
   if (nb_string_tags > 0)
   {
-    m_file >> var_name;
+    var_name = cursor.read_word();
     var_name = var_name.substr(1,var_name.length()-2);
     field_name = var_name;
     if (nb_string_tags > 1)
     {
-      m_file >> interpolation_scheme;
-      std::string tmp = interpolation_scheme;
+      interpolation_scheme = cursor.read_word();
       while(interpolation_scheme[0] == '"' && interpolation_scheme[interpolation_scheme.size()-1] != '"')
       {
-        m_file >> tmp;
-        interpolation_scheme += " "+tmp;
+        interpolation_scheme += " "+cursor.read_word();
       }
     }
     if (nb_string_tags > 2)
     {
-      m_file >> field_name;
+      field_name = cursor.read_word();
       field_name = field_name.substr(1,field_name.length()-2);
 
     }
-    if (nb_string_tags > 3)
+    for (Uint i=3; i<nb_string_tags; ++i)
     {
-      for (Uint i=2; i<nb_string_tags; ++i)
-      {
-        m_file >> dummy;
-      }
-
+      cursor.skip_word();
     }
   }
 
   // real tags
-  m_file >> nb_real_tags;
+  nb_real_tags = cursor.read_uint();
   if (nb_real_tags > 0)
   {
     if (nb_real_tags != 1)
       throw ParsingFailed(FromHere(),"Data cannot have more than 1 real tag (time)");
 
-    m_file >> field_time;
+    field_time = cursor.read_real();
   }
 
   // integer tags
-  m_file >> nb_integer_tags;
+  nb_integer_tags = cursor.read_uint();
   if (nb_integer_tags > 0)
   {
     if (nb_integer_tags >= 3)
     {
-      m_file >> field_time_step >> var_type >> nb_entries;
+      field_time_step = cursor.read_uint();
+      var_type = cursor.read_uint();
+      nb_entries = cursor.read_uint();
     }
     if (nb_integer_tags < 3)
       throw ParsingFailed(FromHere(),"Data must have 3 integer tags (time_step, variable_type, nb_entries)");
+    for (Uint i=3; i<nb_integer_tags; ++i)
+      cursor.skip_word();
   }
-  getline(m_file,line); // finish line
+  cursor.skip_line(); // finish line
 
   Field& field = fields[field_name];
   field.name=field_name;
@@ -1001,7 +1381,7 @@ void Reader::read_variable_header(std::map<std::string,Field>& fields)
   field.time=field_time;
   field.time_step=field_time_step;
   field.nb_entries=nb_entries;
-  field.file_data_positions.push_back(m_file.tellg());
+  field.file_data_positions.push_back(cursor.p - file_begin);
 
   CFdebug << "    - found variable " << var_name << " from discontinuous field " << field_name << " at time " << field_time << CFendl;
 }
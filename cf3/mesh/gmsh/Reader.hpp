@@ -10,6 +10,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <set>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/thread/barrier.hpp>
 #include <boost/tuple/tuple.hpp>
 
 #include "mesh/MeshReader.hpp"
@@ -34,6 +36,10 @@ namespace gmsh {
 //////////////////////////////////////////////////////////////////////////////
 
 /// This class defines gmsh mesh format reader
+///
+/// The file is memory-mapped. Both the ASCII and the binary variant of the version 2 format are supported.
+/// Every rank only parses the contiguous block of elements it owns, and the nodes these elements use.
+/// The node and element blocks are split in chunks that are parsed by multiple threads (option nb_threads).
 /// @author Willem Deconinck
 /// @author Martin Vymazal
 class gmsh_API Reader : public MeshReader, public Shared
@@ -67,6 +73,51 @@ private: // functions
 
   void read_node_data();
 
+  /// Elements read from one chunk of the file, with the gmsh node numbers of all elements concatenated
+  struct ElementChunk
+  {
+    std::vector<Uint> numbers;
+    std::vector<Uint> types;
+    std::vector<Uint> regions;
+    std::vector<Uint> nodes;
+  };
+
+  /// Nodes read from one chunk of the file
+  struct NodeChunk
+  {
+    /// Number of lines in the chunk, for ASCII files
+    Uint nb_lines;
+    std::vector<Uint> indices;
+    std::vector<Uint> numbers;
+    std::vector<Real> coordinates;
+  };
+
+  /// Parse the text lines in [begin, end), containing one element each
+  void parse_text_elements(const char* begin, const char* end, ElementChunk& chunk) const;
+
+  /// Parse the elements with index in [begin, end) from the binary element blocks
+  void parse_binary_elements(const Uint begin, const Uint end, ElementChunk& chunk) const;
+
+  /// Thread task parsing the element chunk of each thread
+  void parse_elements_task(const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier,
+                           const std::vector<const char*>& line_boundaries, const Uint owned_begin, const Uint owned_end);
+
+  /// Thread task parsing the nodes with the given indices in a binary file, or the nodes of one chunk of the text file
+  void parse_nodes_task(const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier,
+                        const std::vector<const char*>& line_boundaries, const std::vector<Uint>& binary_indices,
+                        std::vector<NodeChunk>& chunks, const Uint owned_begin, const Uint owned_end) const;
+
+  /// Thread task filling the connectivity tables from the element chunk of each thread
+  void fill_connectivity_task(const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier,
+                              const std::vector<Uint>& table_of_type, const std::vector< std::vector<Uint> >& chunk_rows,
+                              const std::vector<Uint>& chunk_begin, const Uint part);
+
+  /// Look up the index in the coordinates of a gmsh node number. Returns false if the node is not on this rank
+  bool find_node(const Uint gmsh_node, Uint& cf_idx) const;
+
+  /// Look up an element by its gmsh number. Returns false if the element is not on this rank
+  bool find_element(const Uint gmsh_elem, Handle<Elements>& elements, Uint& cf_idx) const;
+
 private: // data
 
   virtual void do_read_mesh_into(const common::URI& fp, Mesh& mesh);
@@ -74,11 +125,24 @@ private: // data
   enum HashType { NODES=0, ELEMS=1 };
   Handle<MergedParallelDistribution> m_hash;
 
-  // map< gmsh index , pair< elements, index in elements > >
-  std::map<Uint, std::pair<Handle<Elements>,Uint> > m_elem_idx_gmsh_to_cf;
-  std::map<Uint, Uint> m_node_idx_gmsh_to_cf;
+  /// Location of an element read on this rank: gmsh number, index in m_element_tables and row in the table
+  struct ElementLocation
+  {
+    Uint gmsh_idx;
+    Uint table;
+    Uint idx;
+    bool operator<(const ElementLocation& other) const { return gmsh_idx < other.gmsh_idx; }
+  };
+
+  /// Elements read on this rank, sorted by gmsh number
+  std::vector<ElementLocation> m_elem_idx_gmsh_to_cf;
+  std::vector< Handle<Elements> > m_element_tables;
+  /// Pairs of gmsh node number and index in the coordinates, sorted by gmsh number
+  std::vector< std::pair<Uint,Uint> > m_node_idx_gmsh_to_cf;
 
-  boost::filesystem::fstream m_file;
+  boost::iostreams::mapped_file_source m_file;
+  /// True if the file uses the binary variant of the format
+  bool m_binary;
   Handle<Mesh> m_mesh;
   Handle<Region> m_region;
 
@@ -100,19 +164,31 @@ private: // data
 
   std::vector<RegionData> m_region_list;
 
-  std::set<Uint> m_ghost_nodes;
-  //std::set<Uint> m_ghost_elems;
-  std::set<Uint> m_used_nodes;
-  
-  std::vector<std::set<Uint> > m_node_to_glb_elements;
+  /// Sorted gmsh numbers of the nodes used by the elements on this rank
+  std::vector<Uint> m_used_nodes;
 
-  //Markers for important places in the file to be read
-  std::streampos m_region_names_position;
-  std::streampos m_coordinates_position;
-  std::streampos m_elements_position;
-  std::vector<std::streampos> m_element_data_positions;
-  std::vector<std::streampos> m_node_data_positions;
-  std::vector<std::streampos> m_element_node_data_positions;
+  /// Elements of this rank, as parsed by each thread
+  std::vector<ElementChunk> m_element_chunks;
+
+  /// Consecutive elements of the same type in a binary file
+  struct BinaryElementBlock
+  {
+    Uint first_element;
+    Uint nb_elements;
+    Uint type;
+    Uint nb_tags;
+    /// Offset of the first element in the file
+    std::size_t offset;
+  };
+  std::vector<BinaryElementBlock> m_binary_element_blocks;
+
+  //Markers for important places in the file to be read, as offsets from the start of the file
+  std::size_t m_region_names_position;
+  std::size_t m_coordinates_position;
+  std::size_t m_elements_position;
+  std::vector<std::size_t> m_element_data_positions;
+  std::vector<std::size_t> m_node_data_positions;
+  std::vector<std::size_t> m_element_node_data_positions;
 
 
   std::vector<std::vector<Uint> > m_nb_gmsh_elem_in_region;
@@ -128,7 +204,7 @@ private: // data
     Uint time_step;
     std::vector<Uint> var_types;
     Uint nb_entries;
-    std::vector<std::streampos> file_data_positions;
+    std::vector<std::size_t> file_data_positions;
     std::string description() const
     {
       std::stringstream ss;
@@ -161,7 +237,11 @@ private: // data
 
   void fix_negative_volumes(Mesh& mesh);
 
-  void read_variable_header(std::map<std::string,Field>& fields);
+  /// Read the header of a data section starting at the given offset
+  void read_variable_header(const std::size_t position, std::map<std::string,Field>& fields);
+
+  /// Offset of the end of the binary data of the section with the given name, starting at position
+  std::size_t skip_binary_data(const std::string& section, const std::size_t position);
 
   Uint IO_rank;
 }; // end Reader
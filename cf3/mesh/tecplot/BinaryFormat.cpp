@@ -0,0 +1,197 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <limits>
+#include <ostream>
+
+#include "common/BasicExceptions.hpp"
+#include "common/StringConversion.hpp"
+
+#include "mesh/tecplot/BinaryFormat.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+namespace tecplot {
+namespace binary {
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+  const float zone_marker = 299.f;
+  const float end_of_header_marker = 357.f;
+
+  /// Data format code of double precision variables
+  const boost::int32_t double_format = 2;
+
+  void write_int(std::ostream& out, const boost::int32_t value)
+  {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void write_float(std::ostream& out, const float value)
+  {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void write_double(std::ostream& out, const double value)
+  {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  /// Strings are written as one 32 bit integer per character, terminated by a zero
+  void write_string(std::ostream& out, const std::string& str)
+  {
+    for(std::string::const_iterator c = str.begin(); c != str.end(); ++c)
+      write_int(out, static_cast<unsigned char>(*c));
+    write_int(out, 0);
+  }
+
+  boost::int32_t checked_int(const Uint value)
+  {
+    if(value > static_cast<Uint>(std::numeric_limits<boost::int32_t>::max()))
+      throw common::BadValue(FromHere(), "Value too large for a binary tecplot file");
+    return static_cast<boost::int32_t>(value);
+  }
+}
+
+Uint nb_element_nodes(const ZoneType zone_type)
+{
+  switch(zone_type)
+  {
+    case FELINESEG:       return 2;
+    case FETRIANGLE:      return 3;
+    case FEQUADRILATERAL: return 4;
+    case FETETRAHEDRON:   return 4;
+    case FEBRICK:         return 8;
+  }
+  throw common::BadValue(FromHere(), "Unknown tecplot zone type " + common::to_str(static_cast<Uint>(zone_type)));
+}
+
+ZoneHeader::ZoneHeader() :
+  strand_id(-1),
+  solution_time(0.),
+  zone_type(FELINESEG),
+  nb_nodes(0),
+  nb_elems(0)
+{
+}
+
+void write_file_header(std::ostream& out, const std::string& title, const std::vector<std::string>& variables)
+{
+  out.write("#!TDV112", 8);
+  detail::write_int(out, 1); // Byte order, read back as 1 if it matches that of the reader
+  detail::write_int(out, 0); // Full file, with grid and solution
+  detail::write_string(out, title);
+  detail::write_int(out, detail::checked_int(variables.size()));
+  for(Uint i = 0; i != variables.size(); ++i)
+    detail::write_string(out, variables[i]);
+}
+
+void write_zone_header(std::ostream& out, const ZoneHeader& zone)
+{
+  detail::write_float(out, detail::zone_marker);
+  detail::write_string(out, zone.title);
+  detail::write_int(out, -1); // No parent zone
+  detail::write_int(out, zone.strand_id);
+  detail::write_double(out, zone.solution_time);
+  detail::write_int(out, -1); // Not used
+  detail::write_int(out, zone.zone_type);
+
+  const bool has_cell_centred = std::find(zone.cell_centred.begin(), zone.cell_centred.end(), true) != zone.cell_centred.end();
+  detail::write_int(out, has_cell_centred ? 1 : 0);
+  if(has_cell_centred)
+  {
+    for(Uint i = 0; i != zone.cell_centred.size(); ++i)
+      detail::write_int(out, zone.cell_centred[i] ? 1 : 0);
+  }
+
+  detail::write_int(out, 0); // No raw face neighbors
+  detail::write_int(out, 0); // No user defined face neighbor connections
+  detail::write_int(out, detail::checked_int(zone.nb_nodes));
+  detail::write_int(out, detail::checked_int(zone.nb_elems));
+  detail::write_int(out, 0); // ICellDim, JCellDim and KCellDim, reserved
+  detail::write_int(out, 0);
+  detail::write_int(out, 0);
+  detail::write_int(out, 0); // No auxiliary data
+}
+
+void write_end_of_header(std::ostream& out)
+{
+  detail::write_float(out, detail::end_of_header_marker);
+}
+
+ZoneData::ZoneData(std::ostream& out, const Uint nb_vars) :
+  m_out(out),
+  m_nb_vars(nb_vars),
+  m_var_idx(0)
+{
+  detail::write_float(m_out, detail::zone_marker);
+  for(Uint i = 0; i != m_nb_vars; ++i)
+    detail::write_int(m_out, detail::double_format);
+  detail::write_int(m_out, 0); // No passive variables
+  detail::write_int(m_out, 0); // No variable sharing
+  detail::write_int(m_out, -1); // No connectivity sharing
+
+  m_ranges_pos = m_out.tellp();
+  for(Uint i = 0; i != 2*m_nb_vars; ++i)
+    detail::write_double(m_out, 0.);
+}
+
+void ZoneData::write_variable(const std::vector<Real>& values)
+{
+  if(m_var_idx == m_nb_vars)
+    throw common::BadValue(FromHere(), "All " + common::to_str(m_nb_vars) + " variables of the zone were already written");
+
+  Real min_value = 0.;
+  Real max_value = 0.;
+  if(!values.empty())
+  {
+    min_value = *std::min_element(values.begin(), values.end());
+    max_value = *std::max_element(values.begin(), values.end());
+  }
+
+  if(!values.empty())
+  {
+    // Values are stored as doubles, as announced in the data format of the variables
+    if(sizeof(Real) == sizeof(double))
+    {
+      m_out.write(reinterpret_cast<const char*>(&values[0]), values.size()*sizeof(double));
+    }
+    else
+    {
+      for(Uint i = 0; i != values.size(); ++i)
+        detail::write_double(m_out, static_cast<double>(values[i]));
+    }
+  }
+
+  // Fill in the range
+  const std::streampos end_pos = m_out.tellp();
+  m_out.seekp(m_ranges_pos + static_cast<std::streamoff>(2*m_var_idx*sizeof(double)));
+  detail::write_double(m_out, min_value);
+  detail::write_double(m_out, max_value);
+  m_out.seekp(end_pos);
+
+  ++m_var_idx;
+}
+
+void ZoneData::write_connectivity(const std::vector<boost::int32_t>& nodes)
+{
+  if(m_var_idx != m_nb_vars)
+    throw common::SetupError(FromHere(), "Connectivity written before all variables of the zone");
+  if(!nodes.empty())
+    m_out.write(reinterpret_cast<const char*>(&nodes[0]), nodes.size()*sizeof(boost::int32_t));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // binary
+} // tecplot
+} // mesh
+} // cf3
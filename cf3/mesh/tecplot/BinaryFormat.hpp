@@ -0,0 +1,98 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_tecplot_BinaryFormat_hpp
+#define cf3_mesh_tecplot_BinaryFormat_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "mesh/tecplot/LibTecplot.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+namespace tecplot {
+namespace binary {
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// @file BinaryFormat.hpp
+/// Records of the binary Tecplot file format, version 112 (#!TDV112), written without the TecIO library.
+/// A file consists of a header, with the variable names and the header of every zone, followed by the data
+/// of the zones in the same order. All values are written in the native byte order, which is announced
+/// in the file header. Only finite element zones with block data in double precision are supported.
+
+/// Zone types of the binary format
+enum ZoneType { FELINESEG = 1, FETRIANGLE = 2, FEQUADRILATERAL = 3, FETETRAHEDRON = 4, FEBRICK = 5 };
+
+/// Number of nodes of each element of a zone type
+tecplot_API Uint nb_element_nodes(const ZoneType zone_type);
+
+/// Description of a finite element zone in the file header
+struct tecplot_API ZoneHeader
+{
+  ZoneHeader();
+
+  std::string title;
+  boost::int32_t strand_id;
+  Real solution_time;
+  ZoneType zone_type;
+  Uint nb_nodes;
+  Uint nb_elems;
+  /// For each variable, true if it is cell centred instead of nodal
+  std::vector<bool> cell_centred;
+};
+
+/// Write the start of the file header, with the title and variable names
+tecplot_API void write_file_header(std::ostream& out, const std::string& title, const std::vector<std::string>& variables);
+
+/// Write the header of a zone. The headers of all zones follow the file header.
+tecplot_API void write_zone_header(std::ostream& out, const ZoneHeader& zone);
+
+/// Write the marker that ends the header, after all zone headers
+tecplot_API void write_end_of_header(std::ostream& out);
+
+/// Writes the data of one zone, streaming one variable at a time, followed by the connectivity.
+/// Room for the range of every variable is left at the start, and filled in when the variable is written.
+/// The stream must therefore be seekable.
+class tecplot_API ZoneData
+{
+public:
+  /// Write the start of the data of a zone with nb_vars variables
+  ZoneData(std::ostream& out, const Uint nb_vars);
+
+  /// Append the values of the next variable
+  void write_variable(const std::vector<Real>& values);
+
+  /// Append the zero-based node indices of a number of elements, after all variables were written.
+  /// May be called several times, to write the connectivity in chunks.
+  void write_connectivity(const std::vector<boost::int32_t>& nodes);
+
+private:
+  std::ostream& m_out;
+  const Uint m_nb_vars;
+  Uint m_var_idx;
+  /// Position of the range of the first variable
+  std::streampos m_ranges_pos;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // binary
+} // tecplot
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_tecplot_BinaryFormat_hpp
@@ -4,8 +4,9 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
 #include <iostream>
-#include <set>
+#include <sstream>
 #include "common/BoostFilesystem.hpp"
 #include "common/Foreach.hpp"
 #include "common/Log.hpp"
@@ -13,11 +14,13 @@
 #include "common/PropertyList.hpp"
 #include "common/OptionT.hpp"
 #include "common/PE/Comm.hpp"
+#include "common/PE/ParallelFile.hpp"
 #include "common/Builder.hpp"
 #include "common/FindComponents.hpp"
 #include "common/StringConversion.hpp"
 #include "common/List.hpp"
 
+#include "mesh/tecplot/BinaryFormat.hpp"
 #include "mesh/tecplot/Writer.hpp"
 #include "mesh/GeoShape.hpp"
 #include "mesh/Mesh.hpp"
@@ -45,12 +48,49 @@ common::ComponentBuilder < tecplot::Writer, MeshWriter, LibTecplot> atecplotWrit
 
 //////////////////////////////////////////////////////////////////////////////
 
+/// Zone of the output, with the elements of one Entities on this rank
+struct Writer::Zone
+{
+  Handle<Entities const> elements;
+  std::string name;
+  Uint strand_id;
+  /// Number of written elements, excluding ghosts unless overlap is enabled
+  Uint nb_elems;
+  boost::shared_ptr< common::List<Uint> > used_nodes;
+};
+
+/// Scalar variable of the output
+struct Writer::Variable
+{
+  std::string name;
+  /// Field of the variable, or null for the coordinates
+  Handle<Field const> field;
+  /// Column of the variable in the field, or the coordinate direction
+  Uint column;
+  /// True if the variable is written in the cells instead of the nodes
+  bool cell_centred;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+
 Writer::Writer( const std::string& name )
 : MeshWriter(name)
 {
 
   options().add("cell_centred",true)
     .description("True if discontinuous fields are to be plotted as cell-centred fields");
+
+  std::vector<boost::any> file_formats;
+  file_formats.push_back(std::string("ascii"));
+  file_formats.push_back(std::string("binary"));
+  options().add("file_format", std::string("ascii"))
+    .description("Format of the file: ascii, or binary (version 112, written without the TecIO library)")
+    .pretty_name("File Format")
+    .restricted_list() = file_formats;
+
+  options().add("single_file", false)
+    .description("For the binary format in parallel, write the zones of all ranks in one file instead of one file per rank")
+    .pretty_name("Single File");
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -66,76 +106,89 @@ std::vector<std::string> Writer::get_extensions()
 
 void Writer::write()
 {
-  // if the file is present open it
-  boost::filesystem::fstream file;
+  std::vector<Variable> variables;
+  build_variables(variables);
+  std::vector<Zone> zones;
+  build_zones(zones);
+  m_zone_node_idx.assign(m_mesh->geometry_fields().size(), 0u);
+
+  const bool binary = options().value<std::string>("file_format") == "binary";
   boost::filesystem::path path(m_file_path.path());
   if (PE::Comm::instance().size() > 1)
   {
+    if (binary && options().value<bool>("single_file"))
+    {
+      write_binary_single_file(path, variables, zones);
+      return;
+    }
     path = boost::filesystem::basename(path) + "_P" + to_str(PE::Comm::instance().rank()) + boost::filesystem::extension(path);
   }
+
+  // if the file is present open it
+  boost::filesystem::fstream file;
 //  CFLog(VERBOSE, "Opening file " <<  path.string() << "\n");
-  file.open(path,std::ios_base::out);
+  file.open(path, binary ? std::ios_base::out | std::ios_base::binary : std::ios_base::out);
   if (!file) // didn't open so throw exception
   {
      throw boost::filesystem::filesystem_error( path.string() + " failed to open",
                                                 boost::system::error_code() );
   }
 
-
-  write_file(file);
+  if (binary)
+    write_binary(file, variables, zones);
+  else
+    write_ascii(file, variables, zones);
 
   file.close();
 
 }
+
 /////////////////////////////////////////////////////////////////////////////
 
-void Writer::write_file(std::fstream& file)
+void Writer::build_variables(std::vector<Variable>& variables) const
 {
-  file << "TITLE      = COOLFluiD Mesh Data" << "\n";
-  file << "VARIABLES  = ";
+  variables.clear();
 
   Uint dimension = m_mesh->geometry_fields().coordinates().row_size();
-  // write the coordinate variable names
   for (Uint i = 0; i < dimension ; ++i)
   {
-    file << " \"x" << i << "\" ";
+    Variable coordinate;
+    coordinate.name = "x" + to_str(i);
+    coordinate.column = i;
+    coordinate.cell_centred = false;
+    variables.push_back(coordinate);
   }
 
-  std::vector<Uint> cell_centered_var_ids;
-  Uint zone_var_id(dimension);
+  const bool cell_centred = options().value<bool>("cell_centred");
   boost_foreach(Handle<Field const> field_ptr, m_fields)
   {
     const Field& field = *field_ptr;
+    Uint column(0);
     for (Uint iVar=0; iVar<field.nb_vars(); ++iVar)
     {
       VarType var_type = field.var_length(iVar);
       std::string var_name = field.var_name(iVar);
-
-      if ( static_cast<Uint>(var_type) > 1)
-      {
-        for (Uint i=0; i<static_cast<Uint>(var_type); ++i)
-        {
-          file << " \"" << var_name << "["<<i<<"]\"";
-          ++zone_var_id;
-          if (field.discontinuous())
-            cell_centered_var_ids.push_back(zone_var_id);
-        }
-      }
-      else
+      for (Uint i=0; i<static_cast<Uint>(var_type); ++i)
       {
-        file << " \"" << var_name <<"\"";
-        ++zone_var_id;
-        if (field.discontinuous())
-          cell_centered_var_ids.push_back(zone_var_id);
+        Variable variable;
+        variable.name = static_cast<Uint>(var_type) > 1 ? var_name + "[" + to_str(i) + "]" : var_name;
+        variable.field = field_ptr;
+        variable.column = column++;
+        variable.cell_centred = cell_centred && field.discontinuous();
+        variables.push_back(variable);
       }
     }
   }
-  file << "\n";
+}
 
+/////////////////////////////////////////////////////////////////////////////
+
+void Writer::build_zones(std::vector<Zone>& zones) const
+{
+  zones.clear();
 
   // loop over the element types
   // and create a zone in the tecplot file for each element type
-//  std::map<Handle<Component const>,Uint> zone_id;
   Uint zone_idx=0;
   boost_foreach (const Handle<Entities const>& elements_h, m_filtered_entities )
   {
@@ -157,13 +210,7 @@ void Writer::write_file(std::fstream& file)
 
     std::string zone_name = elements.parent()->uri().path();
     boost::algorithm::replace_first(zone_name,m_mesh->topology().uri().path()+"/","");
-    std::set<std::string> zone_names;
-    if (zone_names.count(zone_name) == 0)
-    {
-      zone_idx++;
-      zone_names.insert(zone_name);
-    }
-//    zone_id[elements.handle<Component>()] = zone_idx++;
+    zone_idx++;
 
     // tecplot doesn't handle zones with 0 elements
     // which can happen in parallel, so skip them
@@ -175,27 +222,238 @@ void Writer::write_file(std::fstream& file)
       throw NotImplemented(FromHere(), "Tecplot can only output P1 elements. A new P1 space should be created, and used as geometry space");
     }
 
-    boost::shared_ptr< common::List<Uint> > used_nodes_ptr = mesh::build_used_nodes_list(elements,m_mesh->geometry_fields(),m_enable_overlap);
-    common::List<Uint>& used_nodes = *used_nodes_ptr;
-    std::map<Uint,Uint> zone_node_idx;
+    Zone zone;
+    zone.elements = elements_h;
+    zone.name = zone_name;
+    zone.strand_id = zone_idx;
+    zone.nb_elems = nb_elems;
+    zone.used_nodes = mesh::build_used_nodes_list(elements,m_mesh->geometry_fields(),m_enable_overlap);
+    zones.push_back(zone);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Writer::set_zone_nodes(const Zone& zone)
+{
+  const common::List<Uint>& used_nodes = *zone.used_nodes;
+  for (Uint n=0; n<used_nodes.size(); ++n)
+    m_zone_node_idx[ used_nodes[n] ] = n+1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Writer::clear_zone_nodes(const Zone& zone)
+{
+  boost_foreach(const Uint n, zone.used_nodes->array())
+    m_zone_node_idx[n] = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Writer::compute_variable(const Zone& zone, const Variable& variable, std::vector<Real>& values) const
+{
+  const Entities& elements = *zone.elements;
+  const common::List<Uint>& used_nodes = *zone.used_nodes;
+  const Uint var_idx = variable.column;
+
+  // Coordinates and continuous fields in the geometry space are copied from the table
+  if (is_null(variable.field) || (variable.field->continuous() && &variable.field->dict() == &m_mesh->geometry_fields()))
+  {
+    const common::Table<Real>& table = is_null(variable.field) ? m_mesh->geometry_fields().coordinates() : *variable.field;
+    values.resize(used_nodes.size());
     for (Uint n=0; n<used_nodes.size(); ++n)
-      zone_node_idx[ used_nodes[n] ] = n+1;
+    {
+      cf3_assert(used_nodes[n]<table.size());
+      values[n] = table[used_nodes[n]][var_idx];
+    }
+    return;
+  }
+
+  const Field& field = *variable.field;
+
+  // field not defined for this zone, so write zeros
+  if (!field.dict().defined_for_entities(elements.handle<Entities>()))
+  {
+    values.assign(variable.cell_centred ? zone.nb_elems : used_nodes.size(), 0.);
+    return;
+  }
+
+  const Space& field_space = field.space(elements);
+  const ShapeFunction& sf = field_space.shape_function();
+  RealVector field_data (sf.nb_nodes());
+
+  if (variable.cell_centred)
+  {
+    boost::shared_ptr< ShapeFunction > P0_cell_centred = boost::dynamic_pointer_cast<ShapeFunction>(build_component("cf3.mesh.LagrangeP0."+to_str(elements.element_type().shape_name()),"tmp_shape_func"));
+
+    /// get cell-centred local coordinates
+    const RealRowVector cell_centre_values = sf.value(P0_cell_centred->local_coordinates().row(0));
+
+    values.clear();
+    values.reserve(zone.nb_elems);
+    for (Uint e=0; e<elements.size(); ++e)
+    {
+      if (m_enable_overlap || !elements.is_ghost(e))
+      {
+        Connectivity::ConstRow field_index = field_space.connectivity()[e];
+        /// set field data
+        for (Uint iState=0; iState<sf.nb_nodes(); ++iState)
+        {
+          field_data[iState] = field[field_index[iState]][var_idx];
+        }
+
+        /// evaluate field shape function in P0 space
+        const Real cell_centred_data = cell_centre_values*field_data;
+        values.push_back(cell_centred_data);
+      }
+    }
+    return;
+  }
+
+  values.assign(used_nodes.size(),0.);
+
+  RealMatrix interpolation(elements.geometry_space().shape_function().nb_nodes(),sf.nb_nodes());
+  const RealMatrix& geometry_local_coords = elements.geometry_space().shape_function().local_coordinates();
+  for (Uint g=0; g<interpolation.rows(); ++g)
+  {
+    interpolation.row(g) = sf.value(geometry_local_coords.row(g));
+  }
+
+  // Continuous field with different space than geometry
+  if (field.continuous())
+  {
+    // Compute interpolated data in the vector values
+    for (Uint e=0; e<elements.size(); ++e)
+    {
+      // Skip this element if it is a ghost cell and overlap is disabled
+      if (m_enable_overlap || !elements.is_ghost(e))
+      {
+        // get the node indices of this element
+        Connectivity::ConstRow field_index = field_space.connectivity()[e];
+
+        /// set field data
+        for (Uint iState=0; iState<sf.nb_nodes(); ++iState)
+        {
+          field_data[iState] = field[field_index[iState]][var_idx];
+        }
+
+        /// evaluate field shape function in P0 space
+        RealVector geometry_field_data = interpolation*field_data;
+
+        Connectivity::ConstRow geom_nodes = elements.geometry_space().connectivity()[e];
+        cf3_assert(geometry_field_data.size()==geom_nodes.size());
+        for (Uint g=0; g<geom_nodes.size(); ++g)
+        {
+          const Uint node_idx = m_zone_node_idx[geom_nodes[g]]-1;
+          cf3_assert(node_idx < values.size());
+          values[node_idx] = geometry_field_data[g];
+        }
+      }
+    }
+    return;
+  }
+
+  // Discontinuous field, averaged in the nodes
+  std::vector<Uint> nodal_data_count(used_nodes.size(),0u);
+  for (Uint e=0; e<elements.size(); ++e)
+  {
+    Connectivity::ConstRow field_index = field_space.connectivity()[e];
+
+    /// set field data
+    for (Uint iState=0; iState<sf.nb_nodes(); ++iState)
+    {
+      field_data[iState] = field[field_index[iState]][var_idx];
+    }
+
+    /// evaluate field shape function in P0 space
+    RealVector geometry_field_data = interpolation*field_data;
+
+    Connectivity::ConstRow geom_nodes = elements.geometry_space().connectivity()[e];
+    cf3_assert(geometry_field_data.size()==geom_nodes.size());
+    /// Average nodal values
+    for (Uint g=0; g<geom_nodes.size(); ++g)
+    {
+      if (m_zone_node_idx[geom_nodes[g]] != 0)
+      {
+        const Uint node_idx = m_zone_node_idx[geom_nodes[g]]-1;
+        cf3_assert(node_idx < values.size());
+        const Real accumulated_weight = nodal_data_count[node_idx]/(nodal_data_count[node_idx]+1.0);
+        const Real add_weight = 1.0/(nodal_data_count[node_idx]+1.0);
+        values[node_idx] = accumulated_weight*values[node_idx] + add_weight*geometry_field_data[g];
+        ++nodal_data_count[node_idx];
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Writer::element_nodes(const Zone& zone, const Uint elem, std::vector<Uint>& nodes) const
+{
+  Connectivity::ConstRow row = zone.elements->geometry_space().connectivity()[elem];
+  switch (zone.elements->element_type().shape())
+  {
+    case GeoShape::POINT: // FELINESEG
+      nodes.push_back(m_zone_node_idx[row[0]]);
+      nodes.push_back(m_zone_node_idx[row[0]]);
+      break;
+    case GeoShape::PYRAM: // FEBRICK
+      for (Uint i=0; i<4; ++i)
+        nodes.push_back(m_zone_node_idx[row[i]]);
+      for (Uint i=0; i<4; ++i)
+        nodes.push_back(m_zone_node_idx[row[4]]);
+      break;
+    case GeoShape::PRISM: // FEBRICK
+      nodes.push_back(m_zone_node_idx[row[0]]);
+      nodes.push_back(m_zone_node_idx[row[1]]);
+      nodes.push_back(m_zone_node_idx[row[2]]);
+      nodes.push_back(m_zone_node_idx[row[2]]);
+      nodes.push_back(m_zone_node_idx[row[3]]);
+      nodes.push_back(m_zone_node_idx[row[4]]);
+      nodes.push_back(m_zone_node_idx[row[5]]);
+      nodes.push_back(m_zone_node_idx[row[5]]);
+      break;
+    default:
+      boost_foreach ( Uint n, row)
+        nodes.push_back(m_zone_node_idx[n]);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
 
-    const Uint nbCellsInType  = elements.size();
+void Writer::write_ascii(std::ostream& file, const std::vector<Variable>& variables, const std::vector<Zone>& zones)
+{
+  file << "TITLE      = COOLFluiD Mesh Data" << "\n";
+  file << "VARIABLES  = ";
+
+  std::vector<Uint> cell_centered_var_ids;
+  for (Uint i=0; i<variables.size(); ++i)
+  {
+    file << " \"" << variables[i].name << "\"";
+    if (variables[i].cell_centred)
+      cell_centered_var_ids.push_back(i+1);
+  }
+  file << "\n";
 
+  std::vector<Real> values;
+  std::vector<Uint> nodes;
+  boost_foreach (const Zone& zone, zones)
+  {
+    const Entities& elements = *zone.elements;
 
     // print zone header,
     // one zone per element type per cpu
     // therefore the title is dependent on those parameters
     file << "ZONE "
-         << "  T=\"STEP"<<m_mesh->metadata().properties().value<Uint>("iter") << ":" << zone_name << "\""
-         << ", STRANDID="<<zone_idx
+         << "  T=\"STEP"<<m_mesh->metadata().properties().value<Uint>("iter") << ":" << zone.name << "\""
+         << ", STRANDID="<<zone.strand_id
          << ", SOLUTIONTIME="<<m_mesh->metadata().properties().value<Real>("time")
-         << ", N=" << used_nodes.size()
-         << ", E=" << nb_elems
+         << ", N=" << zone.used_nodes->size()
+         << ", E=" << zone.nb_elems
          << ", DATAPACKING=BLOCK"
-         << ", ZONETYPE=" << zone_type(etype);
-    if (cell_centered_var_ids.size() && options().value<bool>("cell_centred"))
+         << ", ZONETYPE=" << zone_type(elements.element_type());
+    if (cell_centered_var_ids.size())
     {
       file << ",VARLOCATION=(["<<cell_centered_var_ids[0];
       for (Uint i=1; i<cell_centered_var_ids.size(); ++i)
@@ -204,245 +462,178 @@ void Writer::write_file(std::fstream& file)
     }
     file << "\n\n";
 
-
-         //    fout << ", VARLOCATION=( [" << init_id << "]=CELLCENTERED )" ;
-         //   else
-         //    fout << ", VARLOCATION=( [" << init_id << "-" << end_id << "]=CELLCENTERED )" ;
-         // }
-
     file.setf(std::ios::scientific,std::ios::floatfield);
     file.precision(12);
 
-    // loop over coordinates
-    const common::Table<Real>& coordinates = m_mesh->geometry_fields().coordinates();
-    for (Uint d = 0; d < dimension; ++d)
+    set_zone_nodes(zone);
+
+    boost_foreach (const Variable& variable, variables)
     {
-      file << "\n### variable x" << d << "\n\n"; // var name in comment
-      boost_foreach(Uint n, used_nodes.array())
+      file << "\n### variable " << variable.name << "\n\n"; // var name in comment
+      compute_variable(zone, variable, values);
+      for (Uint n=0; n<values.size(); ++n)
       {
-        cf3_assert(n<coordinates.size());
-        file << coordinates[n][d] << " ";
+        file << values[n] << " ";
         CF3_BREAK_LINE(file,n);
       }
       file << "\n";
     }
     file << "\n";
 
-
-    boost_foreach(Handle<Field const> field_ptr, m_fields)
-    {
-      const Field& field = *field_ptr;
-      Uint var_idx(0);
-      for (Uint iVar=0; iVar<field.nb_vars(); ++iVar)
-      {
-        VarType var_type = field.var_length(iVar);
-        std::string var_name = field.var_name(iVar);
-        file << "\n### variable " << var_name << "\n\n"; // var name in comment
-
-        for (Uint i=0; i<static_cast<Uint>(var_type); ++i)
-        {
-          if (field.continuous())
-          {
-            // Continuous field with different space than geometry
-            if ( &field.dict() == &m_mesh->geometry_fields() )
-            {
-              boost_foreach(Uint n, used_nodes.array())
-              {
-                file << field[n][var_idx] << " ";
-                CF3_BREAK_LINE(file,n);
-              }
-              file << "\n";
-            }
-            // Continuous field with different space than geometry
-            else
-            {
-              if (field.dict().defined_for_entities(elements.handle<Entities>()) )
-              {
-                const Space& field_space = field.space(elements);
-                RealVector field_data (field_space.shape_function().nb_nodes());
-
-                std::vector<Real> nodal_data(used_nodes.size(),0.);
-
-                RealMatrix interpolation(elements.geometry_space().shape_function().nb_nodes(),field_space.shape_function().nb_nodes());
-                const RealMatrix& geometry_local_coords = elements.geometry_space().shape_function().local_coordinates();
-                const ShapeFunction& sf = field_space.shape_function();
-                for (Uint g=0; g<interpolation.rows(); ++g)
-                {
-                  interpolation.row(g) = sf.value(geometry_local_coords.row(g));
-                }
-
-                // Compute interpolated data in the vector nodal_data
-                for (Uint e=0; e<elements.size(); ++e)
-                {
-                  // Skip this element if it is a ghost cell and overlap is disabled
-                  if (m_enable_overlap || !elements.is_ghost(e))
-                  {
-                    // get the node indices of this element
-                    Connectivity::ConstRow field_index = field_space.connectivity()[e];
-
-                    /// set field data
-                    for (Uint iState=0; iState<field_space.shape_function().nb_nodes(); ++iState)
-                    {
-                      field_data[iState] = field[field_index[iState]][var_idx];
-                    }
-
-                    /// evaluate field shape function in P0 space
-                    RealVector geometry_field_data = interpolation*field_data;
-
-                    Connectivity::ConstRow geom_nodes = elements.geometry_space().connectivity()[e];
-                    cf3_assert(geometry_field_data.size()==geom_nodes.size());
-                    /// Average nodal values
-                    for (Uint g=0; g<geom_nodes.size(); ++g)
-                    {
-                      const Uint geom_node = geom_nodes[g];
-                      const Uint node_idx = zone_node_idx[geom_node]-1;
-                      cf3_assert(node_idx < nodal_data.size());
-                      nodal_data[node_idx] = geometry_field_data[g];
-                    }
-                  }
-                }
-                for (Uint n=0; n<nodal_data.size(); ++n)
-                {
-                  file << nodal_data[n] << " ";
-                  CF3_BREAK_LINE(file,n)
-                }
-                file << "\n";
-              }
-            }
-          }
-          // Discontinuous fields
-          else
-          {
-            if (field.dict().defined_for_entities(elements.handle<Entities>()))
-            {
-              const Space& field_space = field.space(elements);
-              RealVector field_data (field_space.shape_function().nb_nodes());
-
-              if (options().value<bool>("cell_centred"))
-              {
-                boost::shared_ptr< ShapeFunction > P0_cell_centred = boost::dynamic_pointer_cast<ShapeFunction>(build_component("cf3.mesh.LagrangeP0."+to_str(elements.element_type().shape_name()),"tmp_shape_func"));
-
-                for (Uint e=0; e<elements.size(); ++e)
-                {
-                  if (m_enable_overlap || !elements.is_ghost(e))
-                  {
-                    Connectivity::ConstRow field_index = field_space.connectivity()[e];
-                    /// set field data
-                    for (Uint iState=0; iState<field_space.shape_function().nb_nodes(); ++iState)
-                    {
-                      field_data[iState] = field[field_index[iState]][var_idx];
-                    }
-
-                    /// get cell-centred local coordinates
-                    RealVector local_coords = P0_cell_centred->local_coordinates().row(0);
-
-                    /// evaluate field shape function in P0 space
-                    Real cell_centred_data = field_space.shape_function().value(local_coords)*field_data;
-
-                    /// Write cell centred value
-                    file << cell_centred_data << " ";
-                    CF3_BREAK_LINE(file,e);
-                  }
-                }
-                file << "\n";
-              }
-              else
-              {
-                std::vector<Real> nodal_data(used_nodes.size(),0.);
-                std::vector<Uint> nodal_data_count(used_nodes.size(),0u);
-
-                RealMatrix interpolation(elements.geometry_space().shape_function().nb_nodes(),field_space.shape_function().nb_nodes());
-                const RealMatrix& geometry_local_coords = elements.geometry_space().shape_function().local_coordinates();
-                const ShapeFunction& sf = field_space.shape_function();
-                for (Uint g=0; g<interpolation.rows(); ++g)
-                {
-                  interpolation.row(g) = sf.value(geometry_local_coords.row(g));
-                }
-
-                for (Uint e=0; e<elements.size(); ++e)
-                {
-                  Connectivity::ConstRow field_index = field_space.connectivity()[e];
-
-                  /// set field data
-                  for (Uint iState=0; iState<field_space.shape_function().nb_nodes(); ++iState)
-                  {
-                    field_data[iState] = field[field_index[iState]][var_idx];
-                  }
-
-                  /// evaluate field shape function in P0 space
-                  RealVector geometry_field_data = interpolation*field_data;
-
-                  Connectivity::ConstRow geom_nodes = elements.geometry_space().connectivity()[e];
-                  cf3_assert(geometry_field_data.size()==geom_nodes.size());
-                  /// Average nodal values
-                  for (Uint g=0; g<geom_nodes.size(); ++g)
-                  {
-                    const Uint geom_node = geom_nodes[g];
-                    if (zone_node_idx.find(geom_node) != zone_node_idx.end())
-                    {
-                      const Uint node_idx = zone_node_idx[geom_node]-1;
-                      cf3_assert(node_idx < nodal_data.size());
-                      const Real accumulated_weight = nodal_data_count[node_idx]/(nodal_data_count[node_idx]+1.0);
-                      const Real add_weight = 1.0/(nodal_data_count[node_idx]+1.0);
-                      nodal_data[node_idx] = accumulated_weight*nodal_data[node_idx] + add_weight*geometry_field_data[g];
-                      ++nodal_data_count[node_idx];
-                    }
-                  }
-                }
-
-                for (Uint n=0; n<nodal_data.size(); ++n)
-                {
-                  file << nodal_data[n] << " ";
-                    CF3_BREAK_LINE(file,n)
-                }
-                file << "\n";
-
-              }
-            }
-            else
-            {
-              // field not defined for this zone, so write zeros
-              if (options().value<bool>("cell_centred"))
-                file << nb_elems << "*" << 0.;
-              else
-                file << used_nodes.size() << "*" << 0.;
-              file << "\n";
-            }
-          }
-          var_idx++;
-        }
-      }
-    }
-
     file << "\n### connectivity\n\n";
     // write connectivity
-    const Connectivity& connectivity = elements.geometry_space().connectivity();
     for (Uint e=0; e<elements.size(); ++e)
     {
       if (m_enable_overlap || !elements.is_ghost(e))
       {
-        if (etype.shape() == GeoShape::POINT)
+        nodes.clear();
+        element_nodes(zone, e, nodes);
+        boost_foreach (const Uint n, nodes)
         {
-          // these are represented by a FELINESEG, with coalesced nodes
-          Uint const& n = connectivity[e][0];
-          file << zone_node_idx[n] << " "
-               << zone_node_idx[n] << " ";
-        }
-        else
-        {
-          boost_foreach ( Uint n, connectivity[e])
-          {
-            file << zone_node_idx[n] << " ";
-          }
+          file << n << " ";
         }
         file << "\n";
       }
     }
     file << "\n\n";
 
+    clear_zone_nodes(zone);
   }
 }
 
+/////////////////////////////////////////////////////////////////////////////
+
+void Writer::write_binary(std::ostream& file, const std::vector<Variable>& variables, const std::vector<Zone>& zones)
+{
+  std::vector<std::string> variable_names;
+  boost_foreach (const Variable& variable, variables)
+    variable_names.push_back(variable.name);
+
+  binary::write_file_header(file, "COOLFluiD Mesh Data", variable_names);
+  boost_foreach (const Zone& zone, zones)
+    write_binary_zone_header(file, variables, zone);
+  binary::write_end_of_header(file);
+
+  boost_foreach (const Zone& zone, zones)
+    write_binary_zone_data(file, variables, zone);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Writer::write_binary_single_file(const boost::filesystem::path& path, const std::vector<Variable>& variables, const std::vector<Zone>& zones)
+{
+  PE::Comm& comm = PE::Comm::instance();
+
+  // The headers of the zones of all ranks precede the data in the file
+  std::ostringstream zone_headers;
+  boost_foreach (const Zone& zone, zones)
+    write_binary_zone_header(zone_headers, variables, zone);
+  const std::string local_headers = zone_headers.str();
+  std::vector< std::vector<char> > rank_headers;
+  comm.all_gather(std::vector<char>(local_headers.begin(), local_headers.end()), rank_headers);
+
+  std::vector<std::string> variable_names;
+  boost_foreach (const Variable& variable, variables)
+    variable_names.push_back(variable.name);
+  std::ostringstream header;
+  binary::write_file_header(header, "COOLFluiD Mesh Data", variable_names);
+  boost_foreach (const std::vector<char>& headers, rank_headers)
+    header.write(headers.empty() ? 0 : &headers[0], headers.size());
+  binary::write_end_of_header(header);
+
+  // The data of each rank is written at its own offset, using a single collective write through MPI-IO
+  // Sizes and offsets are 64 bit, so files over 4 GiB are possible
+  std::ostringstream data;
+  boost_foreach (const Zone& zone, zones)
+    write_binary_zone_data(data, variables, zone);
+  const std::string local_data = data.str();
+  std::vector<boost::uint64_t> data_sizes;
+  comm.all_gather(static_cast<boost::uint64_t>(local_data.size()), data_sizes);
+  const std::string header_str = header.str();
+  boost::uint64_t offset = header_str.size();
+  for (Uint rank=0; rank<comm.rank(); ++rank)
+    offset += data_sizes[rank];
+
+  // Each block is added as a single row, and empty blocks as no rows at all
+  const std::vector<Uint> single_row(1, 0);
+  PE::ParallelFile file(path.string(), PE::ParallelFile::WRITE);
+  if (comm.rank() == 0)
+    file.add_rows(0, header_str.data(), single_row, header_str.size());
+  if (!local_data.empty())
+    file.add_rows(offset, local_data.data(), single_row, local_data.size());
+  file.begin_write();
+  file.end_write();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Writer::write_binary_zone_header(std::ostream& file, const std::vector<Variable>& variables, const Zone& zone) const
+{
+  binary::ZoneHeader header;
+  header.title = "STEP" + to_str(m_mesh->metadata().properties().value<Uint>("iter")) + ":" + zone.name;
+  header.strand_id = zone.strand_id;
+  header.solution_time = m_mesh->metadata().properties().value<Real>("time");
+  header.zone_type = binary_zone_type(zone.elements->element_type());
+  header.nb_nodes = zone.used_nodes->size();
+  header.nb_elems = zone.nb_elems;
+  boost_foreach (const Variable& variable, variables)
+    header.cell_centred.push_back(variable.cell_centred);
+  binary::write_zone_header(file, header);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Writer::write_binary_zone_data(std::ostream& file, const std::vector<Variable>& variables, const Zone& zone)
+{
+  const Entities& elements = *zone.elements;
+  set_zone_nodes(zone);
+
+  binary::ZoneData data(file, variables.size());
+  std::vector<Real> values;
+  boost_foreach (const Variable& variable, variables)
+  {
+    compute_variable(zone, variable, values);
+    data.write_variable(values);
+  }
+
+  // The connectivity is zero-based, and written in chunks of elements
+  const Uint chunk_size = 4096;
+  std::vector<Uint> nodes;
+  std::vector<boost::int32_t> chunk;
+  for (Uint begin=0; begin<elements.size(); begin+=chunk_size)
+  {
+    nodes.clear();
+    const Uint end = std::min(begin+chunk_size, elements.size());
+    for (Uint e=begin; e<end; ++e)
+    {
+      if (m_enable_overlap || !elements.is_ghost(e))
+        element_nodes(zone, e, nodes);
+    }
+    chunk.resize(nodes.size());
+    for (Uint i=0; i<nodes.size(); ++i)
+      chunk[i] = static_cast<boost::int32_t>(nodes[i]) - 1;
+    data.write_connectivity(chunk);
+  }
+
+  clear_zone_nodes(zone);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+binary::ZoneType Writer::binary_zone_type(const ElementType& etype) const
+{
+  if ( etype.shape() == GeoShape::LINE)     return binary::FELINESEG;
+  if ( etype.shape() == GeoShape::TRIAG)    return binary::FETRIANGLE;
+  if ( etype.shape() == GeoShape::QUAD)     return binary::FEQUADRILATERAL;
+  if ( etype.shape() == GeoShape::TETRA)    return binary::FETETRAHEDRON;
+  if ( etype.shape() == GeoShape::PYRAM)    return binary::FEBRICK;  // with coalesced nodes
+  if ( etype.shape() == GeoShape::PRISM)    return binary::FEBRICK;  // with coalesced nodes
+  if ( etype.shape() == GeoShape::HEXA)     return binary::FEBRICK;
+  if ( etype.shape() == GeoShape::POINT)    return binary::FELINESEG; // with coalesced nodes
+  throw NotSupported(FromHere(), "Element type " + etype.derived_type_name() + " is not supported in tecplot");
+}
+
+/////////////////////////////////////////////////////////////////////////////
 
 std::string Writer::zone_type(const ElementType& etype) const
 {
@@ -9,9 +9,12 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <boost/filesystem/path.hpp>
+
 #include "mesh/MeshWriter.hpp"
 #include "mesh/GeoShape.hpp"
 
+#include "mesh/tecplot/BinaryFormat.hpp"
 #include "mesh/tecplot/LibTecplot.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -24,6 +27,8 @@ namespace tecplot {
 //////////////////////////////////////////////////////////////////////////////
 
 /// This class defines tecplot mesh format writer
+/// The file_format option selects the ASCII format, or the binary format which is written without the
+/// TecIO library. In parallel, every rank writes its own file, unless single_file is set for binary output.
 /// @author Willem Deconinck
 class tecplot_API Writer : public MeshWriter
 {
@@ -48,12 +53,51 @@ public: // functions
 
 private: // functions
 
-  void write_file(std::fstream& file);
+  struct Zone;
+  struct Variable;
+
+  /// List the output variables: the coordinates, followed by the components of every field
+  void build_variables(std::vector<Variable>& variables) const;
+
+  /// List the zones to write, one per non-empty filtered Entities
+  void build_zones(std::vector<Zone>& zones) const;
+
+  /// Number the nodes used by a zone in m_zone_node_idx
+  void set_zone_nodes(const Zone& zone);
+
+  /// Reset the zone numbering of the nodes used by a zone
+  void clear_zone_nodes(const Zone& zone);
+
+  /// Compute the values of a variable in the nodes or cells of a zone, as written to the file.
+  /// The zone nodes must be numbered with set_zone_nodes.
+  void compute_variable(const Zone& zone, const Variable& variable, std::vector<Real>& values) const;
+
+  /// Append the zone node indices (one-based) of an element to nodes, coalescing nodes for
+  /// shapes that are written as a zone type with more nodes
+  void element_nodes(const Zone& zone, const Uint elem, std::vector<Uint>& nodes) const;
+
+  void write_ascii(std::ostream& file, const std::vector<Variable>& variables, const std::vector<Zone>& zones);
+
+  void write_binary(std::ostream& file, const std::vector<Variable>& variables, const std::vector<Zone>& zones);
+
+  /// Write the zones of all ranks in one binary file
+  void write_binary_single_file(const boost::filesystem::path& path, const std::vector<Variable>& variables, const std::vector<Zone>& zones);
+
+  /// Write the header of a zone in the binary format
+  void write_binary_zone_header(std::ostream& file, const std::vector<Variable>& variables, const Zone& zone) const;
+
+  /// Write the data of a zone in the binary format
+  void write_binary_zone_data(std::ostream& file, const std::vector<Variable>& variables, const Zone& zone);
 
   std::string zone_type(const ElementType& etype) const;
 
+  binary::ZoneType binary_zone_type(const ElementType& etype) const;
+
 private: // data
 
+  /// Zone-local index of each node of the geometry dictionary, plus one. Zero for nodes not used by the current zone.
+  std::vector<Uint> m_zone_node_idx;
+
 
 }; // end Writer
 
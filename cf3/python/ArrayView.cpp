@@ -0,0 +1,161 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include "python/BoostPython.hpp"
+
+#include "python/ArrayView.hpp"
+
+namespace cf3 {
+namespace python {
+
+using namespace boost::python;
+
+namespace detail
+{
+
+/// Layout of the ArrayView Python objects
+struct ArrayViewObject
+{
+  PyObject_HEAD
+  ArrayViewSource* source;
+  /// Shape and strides handed out to the consumers of the buffer. They stay valid
+  /// while buffers are exported, since the storage can't be reallocated then.
+  Py_ssize_t shape[2];
+  Py_ssize_t strides[2];
+  Py_ssize_t nb_exports;
+};
+
+PyTypeObject array_view_type = { PyVarObject_HEAD_INIT(NULL, 0) };
+PyBufferProcs array_view_buffer_procs;
+
+bool is_contiguous(const ArrayViewObject& self, const int ndim, const bool c_order)
+{
+  Py_ssize_t stride = self.source->itemsize();
+  for(int j = 0; j != ndim; ++j)
+  {
+    const int i = c_order ? ndim - 1 - j : j;
+    if(self.shape[i] > 1 && self.strides[i] != stride)
+      return false;
+    stride *= self.shape[i];
+  }
+  return true;
+}
+
+int array_view_getbuffer(PyObject* obj, Py_buffer* view, int flags)
+{
+  ArrayViewObject& self = *reinterpret_cast<ArrayViewObject*>(obj);
+  ArrayViewSource& source = *self.source;
+  view->obj = NULL;
+
+  if((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE && source.readonly())
+  {
+    PyErr_SetString(PyExc_BufferError, ("The data of " + source.path() + " is read-only").c_str());
+    return -1;
+  }
+
+  const int ndim = source.ndim();
+  source.shape(self.shape, self.strides);
+
+  const bool c_contiguous = is_contiguous(self, ndim, true);
+  const bool f_contiguous = is_contiguous(self, ndim, false);
+  if(((flags & PyBUF_STRIDES) != PyBUF_STRIDES && !c_contiguous)
+     || ((flags & PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS && !c_contiguous)
+     || ((flags & PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS && !f_contiguous)
+     || ((flags & PyBUF_ANY_CONTIGUOUS) == PyBUF_ANY_CONTIGUOUS && !c_contiguous && !f_contiguous))
+  {
+    PyErr_SetString(PyExc_BufferError, ("The data of " + source.path() + " does not have the requested memory layout").c_str());
+    return -1;
+  }
+
+  Py_ssize_t nb_values = 1;
+  for(int i = 0; i != ndim; ++i)
+    nb_values *= self.shape[i];
+
+  view->buf = source.data();
+  view->obj = obj;
+  Py_INCREF(obj);
+  view->len = nb_values * source.itemsize();
+  view->readonly = source.readonly();
+  view->itemsize = source.itemsize();
+  view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(source.format()) : NULL;
+  view->ndim = ndim;
+  view->shape = (flags & PyBUF_ND) ? self.shape : NULL;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self.strides : NULL;
+  view->suboffsets = NULL;
+  view->internal = NULL;
+
+  source.add_storage_user();
+  ++self.nb_exports;
+  return 0;
+}
+
+void array_view_releasebuffer(PyObject* obj, Py_buffer*)
+{
+  ArrayViewObject& self = *reinterpret_cast<ArrayViewObject*>(obj);
+  --self.nb_exports;
+  self.source->remove_storage_user();
+}
+
+void array_view_dealloc(PyObject* obj)
+{
+  ArrayViewObject* self = reinterpret_cast<ArrayViewObject*>(obj);
+  delete self->source;
+  PyObject_Del(obj);
+}
+
+PyObject* array_view_repr(PyObject* obj)
+{
+  const ArrayViewSource& source = *reinterpret_cast<ArrayViewObject*>(obj)->source;
+  return incref(str("<ArrayView of " + source.path() + ">").ptr());
+}
+
+} // detail
+
+object make_array_view(ArrayViewSource* source)
+{
+  detail::ArrayViewObject* self = PyObject_New(detail::ArrayViewObject, &detail::array_view_type);
+  if(self == NULL)
+  {
+    delete source;
+    throw_error_already_set();
+  }
+  self->source = source;
+  self->nb_exports = 0;
+  return object(handle<>(reinterpret_cast<PyObject*>(self)));
+}
+
+object make_numpy_array(ArrayViewSource* source)
+{
+  object view = make_array_view(source);
+  return import("numpy").attr("asarray")(view);
+}
+
+void def_array_view()
+{
+  detail::array_view_buffer_procs.bf_getbuffer = detail::array_view_getbuffer;
+  detail::array_view_buffer_procs.bf_releasebuffer = detail::array_view_releasebuffer;
+
+  PyTypeObject& type = detail::array_view_type;
+  type.tp_name = "libcoolfluid_python.ArrayView";
+  type.tp_basicsize = sizeof(detail::ArrayViewObject);
+  type.tp_dealloc = detail::array_view_dealloc;
+  type.tp_repr = detail::array_view_repr;
+  type.tp_as_buffer = &detail::array_view_buffer_procs;
+  type.tp_flags = Py_TPFLAGS_DEFAULT;
+#if PY_MAJOR_VERSION < 3
+  type.tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+  type.tp_doc = "Exports the data of a Table or List through the buffer protocol, without copying. "
+                "Use numpy.asarray or memoryview to access it. The component can't be resized while such views exist.";
+
+  if(PyType_Ready(&type) < 0)
+    throw_error_already_set();
+
+  scope().attr("ArrayView") = object(handle<>(borrowed(reinterpret_cast<PyObject*>(&type))));
+}
+
+} // python
+} // cf3
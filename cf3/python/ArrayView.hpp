@@ -0,0 +1,114 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef CF3_Python_ArrayView_hpp
+#define CF3_Python_ArrayView_hpp
+
+#include "python/BoostPython.hpp"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/is_const.hpp>
+
+#include "common/Component.hpp"
+
+namespace cf3 {
+namespace python {
+
+/// Struct-module format character of the values exported through the buffer protocol
+template<typename ValueT>
+struct BufferFormat;
+
+template<> struct BufferFormat<float> { static const char* value() { return "f"; } };
+template<> struct BufferFormat<double> { static const char* value() { return "d"; } };
+template<> struct BufferFormat<long double> { static const char* value() { return "g"; } };
+template<> struct BufferFormat<int> { static const char* value() { return "i"; } };
+template<> struct BufferFormat<unsigned int> { static const char* value() { return "I"; } };
+template<> struct BufferFormat<bool> { static const char* value() { return "?"; } };
+
+/// Access to the storage of a component that is exported to Python through an ArrayView
+class ArrayViewSource
+{
+public:
+  virtual ~ArrayViewSource() {}
+
+  /// Path of the component, for error messages
+  virtual std::string path() const = 0;
+
+  /// Pointer to the first value
+  virtual void* data() const = 0;
+
+  /// Number of dimensions, at most 2
+  virtual int ndim() const = 0;
+
+  /// Fill in the shape and the strides in bytes, each with ndim() entries
+  virtual void shape(Py_ssize_t* shape, Py_ssize_t* strides) const = 0;
+
+  /// Size of a value in bytes
+  virtual Py_ssize_t itemsize() const = 0;
+
+  /// Format character of a value
+  virtual const char* format() const = 0;
+
+  /// True if the values may not be modified
+  virtual bool readonly() const = 0;
+
+  /// Keep the component from reallocating its storage while a view exists
+  virtual void add_storage_user() const = 0;
+  virtual void remove_storage_user() const = 0;
+};
+
+/// ArrayViewSource for a Table or a List, possibly const.
+/// It shares ownership of the component, so the exported storage stays valid if the component is removed from the tree.
+template<typename ComponentT>
+class ArrayViewSourceT : public ArrayViewSource
+{
+public:
+  typedef typename ComponentT::value_type ValueT;
+
+  ArrayViewSourceT(ComponentT& component) : m_component(boost::static_pointer_cast<ComponentT>(component.shared_from_this()))
+  {
+  }
+
+  virtual std::string path() const { return m_component->uri().path(); }
+  virtual void* data() const { return const_cast<ValueT*>(m_component->array().data()); }
+  virtual int ndim() const { return m_component->array().num_dimensions(); }
+
+  virtual void shape(Py_ssize_t* shape, Py_ssize_t* strides) const
+  {
+    for(int i = 0; i != ndim(); ++i)
+    {
+      shape[i] = m_component->array().shape()[i];
+      strides[i] = m_component->array().strides()[i] * static_cast<Py_ssize_t>(sizeof(ValueT));
+    }
+  }
+
+  virtual Py_ssize_t itemsize() const { return sizeof(ValueT); }
+  virtual const char* format() const { return BufferFormat<ValueT>::value(); }
+  virtual bool readonly() const { return boost::is_const<ComponentT>::value; }
+  virtual void add_storage_user() const { m_component->add_storage_user(); }
+  virtual void remove_storage_user() const { m_component->remove_storage_user(); }
+
+private:
+  boost::shared_ptr<ComponentT> m_component;
+};
+
+/// Python object exporting the storage of the source through the buffer protocol, without copying.
+/// numpy.asarray or memoryview turn it into an array that aliases the component data.
+/// The component can't be resized as long as such an array exists, and it is kept alive by the view,
+/// even when it is removed from the component tree. Takes ownership of the source.
+boost::python::object make_array_view(ArrayViewSource* source);
+
+/// NumPy array aliasing the storage of the source. NumPy is only needed when this is called.
+boost::python::object make_numpy_array(ArrayViewSource* source);
+
+void def_array_view();
+
+} // python
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // CF3_Python_ArrayView_hpp
@@ -15,6 +15,7 @@
 
 #include "common/List.hpp"
 
+#include "python/ArrayView.hpp"
 #include "python/ComponentWrapper.hpp"
 #include "python/ListWrapper.hpp"
 #include "python/Utility.hpp"
@@ -64,6 +65,26 @@ struct ListMethods
     return out_stream.str();
   }
 
+  static object buffer(ComponentWrapper& wrapped)
+  {
+    return make_array_view(new ArrayViewSourceT<ListT>(wrapped.component<ListT>()));
+  }
+
+  static object buffer_const(ComponentWrapperConst& wrapped)
+  {
+    return make_array_view(new ArrayViewSourceT<ListT const>(wrapped.component<ListT const>()));
+  }
+
+  static object numpy(ComponentWrapper& wrapped)
+  {
+    return make_numpy_array(new ArrayViewSourceT<ListT>(wrapped.component<ListT>()));
+  }
+
+  static object numpy_const(ComponentWrapperConst& wrapped)
+  {
+    return make_numpy_array(new ArrayViewSourceT<ListT const>(wrapped.component<ListT const>()));
+  }
+
 };
 
 template<typename ValueT>
@@ -77,12 +98,16 @@ void def_clist_types()
     .def("__setitem__", ListMethods<ValueT>::set_item)
     .def("__getitem__", ListMethods<ValueT>::get_item)
     .def("__len__", ListMethods<ValueT>::len)
-    .def("__str__", ListMethods<ValueT>::to_str);
+    .def("__str__", ListMethods<ValueT>::to_str)
+    .def("buffer", ListMethods<ValueT>::buffer, "Return an ArrayView exporting the list data through the buffer protocol, without copying")
+    .def("numpy", ListMethods<ValueT>::numpy, "Return a NumPy array that shares its data with the list. The list can't be resized while the array exists");
 
   boost::python::class_<ListWrapperConst, boost::python::bases<ComponentWrapperConst> >(("ListConst_"+common::class_name<ValueT>()).c_str(), boost::python::no_init)
     .def("__getitem__", ListMethods<ValueT>::get_item)
     .def("__len__", ListMethods<ValueT>::len)
-    .def("__str__", ListMethods<ValueT>::to_str);
+    .def("__str__", ListMethods<ValueT>::to_str)
+    .def("buffer", ListMethods<ValueT>::buffer_const, "Return a read-only ArrayView exporting the list data through the buffer protocol, without copying")
+    .def("numpy", ListMethods<ValueT>::numpy_const, "Return a read-only NumPy array that shares its data with the list. The list can't be resized while the array exists");
 
   ComponentWrapperRegistry::instance().register_factory< DefaultComponentWrapperFactory< common::List<ValueT> > >();
 }
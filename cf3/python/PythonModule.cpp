@@ -6,6 +6,7 @@
 
 #include "python/BoostPython.hpp"
 
+#include "python/ArrayView.hpp"
 #include "python/ComponentFilterPython.hpp"
 #include "python/ComponentWrapper.hpp"
 #include "python/CoreWrapper.hpp"
@@ -23,6 +24,7 @@ using namespace boost::python;
 
 BOOST_PYTHON_MODULE(libcoolfluid_python)
 {
+  def_array_view();
   def_component();
   def_component_filter_methods();
   def_core();
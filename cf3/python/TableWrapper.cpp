@@ -15,6 +15,7 @@
 
 #include "common/Table.hpp"
 
+#include "python/ArrayView.hpp"
 #include "python/ComponentWrapper.hpp"
 #include "python/TableWrapper.hpp"
 #include "python/Utility.hpp"
@@ -138,6 +139,26 @@ struct TableMethods
     out_stream << wrapped.component<TableT>();
     return out_stream.str();
   }
+
+  static object buffer(ComponentWrapper& wrapped)
+  {
+    return make_array_view(new ArrayViewSourceT<TableT>(wrapped.component<TableT>()));
+  }
+
+  static object buffer_const(ComponentWrapperConst& wrapped)
+  {
+    return make_array_view(new ArrayViewSourceT<TableT const>(wrapped.component<TableT const>()));
+  }
+
+  static object numpy(ComponentWrapper& wrapped)
+  {
+    return make_numpy_array(new ArrayViewSourceT<TableT>(wrapped.component<TableT>()));
+  }
+
+  static object numpy_const(ComponentWrapperConst& wrapped)
+  {
+    return make_numpy_array(new ArrayViewSourceT<TableT const>(wrapped.component<TableT const>()));
+  }
 };
 
 template<typename ValueT>
@@ -172,13 +193,17 @@ void def_ctable_types()
     .def("__setitem__", TableMethods<ValueT>::set_item)
     .def("__getitem__", TableMethods<ValueT>::get_item)
     .def("__len__", TableMethods<ValueT>::len)
-    .def("__str__", TableMethods<ValueT>::to_str);
+    .def("__str__", TableMethods<ValueT>::to_str)
+    .def("buffer", TableMethods<ValueT>::buffer, "Return an ArrayView exporting the table data through the buffer protocol, without copying")
+    .def("numpy", TableMethods<ValueT>::numpy, "Return a NumPy array that shares its data with the table. The table can't be resized while the array exists");
 
   boost::python::class_<TableWrapperConst, boost::python::bases<ComponentWrapperConst> >(("TableConst_"+common::class_name<ValueT>()).c_str(), boost::python::no_init)
     .def("row_size", TableMethods<ValueT>::row_size, "Return the number of columns the table can hold")
     .def("__getitem__", TableMethods<ValueT>::get_item_const)
     .def("__len__", TableMethods<ValueT>::len)
-    .def("__str__", TableMethods<ValueT>::to_str);
+    .def("__str__", TableMethods<ValueT>::to_str)
+    .def("buffer", TableMethods<ValueT>::buffer_const, "Return a read-only ArrayView exporting the table data through the buffer protocol, without copying")
+    .def("numpy", TableMethods<ValueT>::numpy_const, "Return a read-only NumPy array that shares its data with the table. The table can't be resized while the array exists");
 
   ComponentWrapperRegistry::instance().register_factory< DefaultComponentWrapperFactory< common::Table<ValueT> > >();
 }
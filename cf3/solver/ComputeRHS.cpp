@@ -33,7 +33,9 @@ common::ComponentBuilder < ComputeRHS, common::Action, solver::LibSolver > Compu
 
 ////////////////////////////////////////////////////////////////////////////////
 
-ComputeRHS::ComputeRHS ( const std::string& name ) : common::Action(name)
+ComputeRHS::ComputeRHS ( const std::string& name ) :
+  common::Action(name),
+  m_block_size(TermComputer::default_block_size)
 {
   options().add("rhs",m_rhs).link_to(&m_rhs)
       .description("Right-Hand-Side of equations")
@@ -41,6 +43,8 @@ ComputeRHS::ComputeRHS ( const std::string& name ) : common::Action(name)
   options().add("wave_speed",m_ws).link_to(&m_ws)
       .description("Wave speed")
       .mark_basic();
+  options().add("block_size",m_block_size).link_to(&m_block_size)
+      .description("Number of elements of which the rhs is computed at once");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -76,28 +80,39 @@ bool ComputeRHS::loop_cells(const Handle<mesh::Entities const>& cells)
 
 void ComputeRHS::compute_rhs(const Uint elem_idx, std::vector<RealVector>& rhs, std::vector<Real>& wave_speed)
 {
-  boost_foreach( RealVector& rhs_in_pt, rhs)
-  {
-    rhs_in_pt.setZero();
-  }
-  boost_foreach( Real& wave_speed_in_pt, wave_speed)
+  const Uint nb_sol_pts = rhs.size();
+  if (nb_sol_pts == 0) return;
+  const Uint nb_eqs = rhs[0].size();
+  m_block_rhs.resize(nb_sol_pts*nb_eqs);
+  m_block_ws.resize(nb_sol_pts);
+
+  compute_rhs(elem_idx,elem_idx+1,nb_sol_pts,nb_eqs,&m_block_rhs[0],&m_block_ws[0]);
+
+  const Real* elem_rhs = &m_block_rhs[0];
+  for (Uint p=0; p<nb_sol_pts; ++p)
   {
-    wave_speed_in_pt = 0.;
+    for (Uint eq=0; eq<nb_eqs; ++eq)
+    {
+      rhs[p][eq] = *elem_rhs++;
+    }
+    wave_speed[p] = m_block_ws[p];
   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ComputeRHS::compute_rhs(const Uint begin, const Uint end, const Uint nb_sol_pts, const Uint nb_eqs,
+                             Real* rhs, Real* wave_speed)
+{
+  const Uint nb_elems = end-begin;
+  std::fill(rhs, rhs+nb_elems*nb_sol_pts*nb_eqs, 0.);
+  std::fill(wave_speed, wave_speed+nb_elems*nb_sol_pts, 0.);
 
   for (Uint t=0; t<m_term_computers.size(); ++t)
   {
     if (m_loop_cells[t])
     {
-      m_term_computers[t]->compute_term(elem_idx,m_tmp_term,m_tmp_ws);
-      for (Uint p=0; p<rhs.size(); ++p)
-      {
-        for (Uint eq=0; eq<rhs[p].size(); ++eq)
-        {
-          rhs[p][eq] += m_tmp_term[p][eq];
-        }
-        wave_speed[p] = std::max(wave_speed[p],m_tmp_ws[p]);
-      }
+      m_term_computers[t]->add_term_block(begin,end,nb_sol_pts,nb_eqs,rhs,wave_speed);
     }
   }
 }
@@ -106,6 +121,8 @@ void ComputeRHS::compute_rhs(const Uint elem_idx, std::vector<RealVector>& rhs,
 
 void ComputeRHS::compute_rhs(mesh::Field& rhs, mesh::Field& wave_speed)
 {
+  if (m_block_size == 0) throw BadValue(FromHere(), "block_size must be at least 1");
+
   const Uint nb_eqs = rhs.row_size();
   mesh::Dictionary& dict = rhs.dict();
   boost_foreach(const Handle<mesh::Entities>& cells, dict.entities_range() )
@@ -113,30 +130,46 @@ void ComputeRHS::compute_rhs(mesh::Field& rhs, mesh::Field& wave_speed)
     if ( loop_cells(cells) )
     {
       const Space& space = dict.space(*cells);
+      const mesh::Connectivity& connectivity = space.connectivity();
 
-      // Element-loop
       const Uint nb_elems = cells->size();
       const Uint nb_sol_pts = space.shape_function().nb_nodes();
 
-      std::vector<RealVector> elem_rhs(nb_sol_pts,RealVector(nb_eqs));
-      std::vector<Real> elem_wave_speed(nb_sol_pts);
+      // The buffers keep their size between calls, so they are only allocated once
+      m_block_rhs.resize(m_block_size*nb_sol_pts*nb_eqs);
+      m_block_ws.resize(m_block_size*nb_sol_pts);
 
-      for (Uint elem_idx=0; elem_idx<nb_elems; ++elem_idx)
+      // Loop over blocks of consecutive elements that are not ghosts
+      Uint begin=0;
+      while (begin<nb_elems)
       {
-        if (cells->is_ghost(elem_idx)==false)
+        if (cells->is_ghost(begin))
         {
-          compute_rhs(elem_idx,elem_rhs,elem_wave_speed);
+          ++begin;
+          continue;
+        }
+        Uint end=begin+1;
+        while (end<nb_elems && end-begin<m_block_size && cells->is_ghost(end)==false)
+          ++end;
 
-          mesh::Connectivity::ConstRow nodes = space.connectivity()[elem_idx];
+        compute_rhs(begin,end,nb_sol_pts,nb_eqs,&m_block_rhs[0],&m_block_ws[0]);
+
+        const Real* elem_rhs = &m_block_rhs[0];
+        const Real* elem_ws = &m_block_ws[0];
+        for (Uint elem_idx=begin; elem_idx<end; ++elem_idx)
+        {
+          mesh::Connectivity::ConstRow nodes = connectivity[elem_idx];
           for (Uint sol_pt=0; sol_pt<nb_sol_pts; ++sol_pt)
           {
+            mesh::Field::Row rhs_row = rhs[nodes[sol_pt]];
             for (Uint eq=0; eq<nb_eqs; ++eq)
             {
-              rhs[nodes[sol_pt]][eq] = elem_rhs[sol_pt][eq];
+              rhs_row[eq] = *elem_rhs++;
             }
-            wave_speed[nodes[sol_pt]][0] = elem_wave_speed[sol_pt];
+            wave_speed[nodes[sol_pt]][0] = *elem_ws++;
           }
         }
+        begin=end;
       }
     }
   }
@@ -56,7 +56,15 @@ public:
   virtual bool loop_cells(const Handle<mesh::Entities const>& cells);
 
   /// @brief Compute the complete rhs for a given element, as well as the wave-speeds
-  virtual void compute_rhs(const Uint elem_idx, std::vector<RealVector>& rhs, std::vector<Real>& wave_speed);
+  /// This computes a block of one element, so customizations go in the block version below.
+  void compute_rhs(const Uint elem_idx, std::vector<RealVector>& rhs, std::vector<Real>& wave_speed);
+
+  /// @brief Compute the complete rhs for the elements [begin,end) in contiguous buffers, as well as the wave-speeds
+  /// @param rhs  nb_sol_pts*nb_eqs values per element, solution point by solution point
+  /// @param wave_speed  nb_sol_pts values per element
+  /// All terms are added to the same buffer, so the rhs of a solution point is only written once afterwards.
+  virtual void compute_rhs(const Uint begin, const Uint end, const Uint nb_sol_pts, const Uint nb_eqs,
+                           Real* rhs, Real* wave_speed);
 
   /// @brief Compute the complete rhs in a field, as well as wave speeds
   virtual void compute_rhs(mesh::Field& rhs, mesh::Field& wave_speed);
@@ -69,8 +77,9 @@ private:
   std::vector< Handle<TermComputer> > m_term_computers;
   std::vector< bool > m_loop_cells;
 
-  std::vector< RealVector > m_tmp_term;
-  std::vector< Real > m_tmp_ws;
+  Uint m_block_size;               ///! Number of elements of which the rhs is computed at once
+  std::vector< Real > m_block_rhs; ///! Rhs of a block of elements
+  std::vector< Real > m_block_ws;  ///! Wave speeds of a block of elements
 };
 
 ////////////////////////////////////////////////////////////////////////////////
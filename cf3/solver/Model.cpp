@@ -20,6 +20,7 @@
 #include "common/FindComponents.hpp"
 #include "common/Group.hpp"
 #include "common/OptionList.hpp"
+#include "common/OutputThread.hpp"
 #include "common/PropertyList.hpp"
 
 #include "common/XML/Protocol.hpp"
@@ -140,6 +141,8 @@ void Model::simulate()
     {
       solver.execute();
     }
+    // Complete the output that is still being written in the background
+    OutputThread::instance().flush();
     CFinfo << name() << ": end simulation\n" << CFendl;
   }
 //  catch (common::FailedToConverge& e)
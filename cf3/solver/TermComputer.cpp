@@ -10,6 +10,7 @@
 #include "mesh/Field.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/Connectivity.hpp"
+#include "mesh/ShapeFunction.hpp"
 #include "solver/TermComputer.hpp"
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -44,7 +45,10 @@ void TermComputer::execute()
 
 void TermComputer::compute_term(mesh::Field& term, mesh::Field& wave_speed)
 {
+  const Uint block_size = default_block_size;
+
   term = 0.;
+  const Uint nb_eqs = term.row_size();
   boost_foreach( const Handle<mesh::Entities const>& cells, term.entities_range() )
   {
     if (loop_cells(cells))
@@ -52,23 +56,54 @@ void TermComputer::compute_term(mesh::Field& term, mesh::Field& wave_speed)
       const mesh::Space& space = term.space(*cells);
       const Uint nb_elems = space.size();
       const Uint nb_nodes_per_elem = space.shape_function().nb_nodes();
-      for (Uint e=0; e<nb_elems; ++e)
+      m_block_term.resize(block_size*nb_nodes_per_elem*nb_eqs);
+      m_block_ws.resize(block_size*nb_nodes_per_elem);
+      for (Uint begin=0; begin<nb_elems; begin+=block_size)
       {
-        compute_term(e,m_tmp_term,m_tmp_ws);
-        for (Uint s=0; s<nb_nodes_per_elem; ++s)
+        const Uint end = std::min(begin+block_size, nb_elems);
+        std::fill(m_block_term.begin(), m_block_term.end(), 0.);
+        std::fill(m_block_ws.begin(), m_block_ws.end(), 0.);
+        add_term_block(begin,end,nb_nodes_per_elem,nb_eqs,&m_block_term[0],&m_block_ws[0]);
+
+        const Real* elem_term = &m_block_term[0];
+        const Real* elem_ws = &m_block_ws[0];
+        for (Uint e=begin; e<end; ++e)
         {
-          const Uint p=space.connectivity()[e][s];
-          for (Uint eq=0; eq<m_tmp_term[s].size(); ++eq)
+          for (Uint s=0; s<nb_nodes_per_elem; ++s)
           {
-            term[p][eq] += m_tmp_term[s][eq];
+            const Uint p=space.connectivity()[e][s];
+            for (Uint eq=0; eq<nb_eqs; ++eq)
+            {
+              term[p][eq] += *elem_term++;
+            }
+            wave_speed[p][0] = *elem_ws++;
           }
-          wave_speed[p][0] = m_tmp_ws[s]; 
         }
       }
     }
   }
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+
+void TermComputer::add_term_block(const Uint begin, const Uint end, const Uint nb_sol_pts, const Uint nb_eqs,
+                                  Real* term, Real* wave_speed)
+{
+  for (Uint e=begin; e<end; ++e)
+  {
+    compute_term(e,m_tmp_term,m_tmp_ws);
+    for (Uint s=0; s<nb_sol_pts; ++s)
+    {
+      for (Uint eq=0; eq<nb_eqs; ++eq)
+      {
+        *term++ += m_tmp_term[s][eq];
+      }
+      *wave_speed = std::max(*wave_speed, m_tmp_ws[s]);
+      ++wave_speed;
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 } // solver
@@ -43,6 +43,9 @@ public:
   /// @Get the class name
   static std::string type_name () { return "TermComputer"; }
 
+  /// Number of elements of which compute_term on fields computes the term at once, and default block size of ComputeRHS
+  static const Uint default_block_size = 64;
+
   // Compute the term in configured fields
   virtual void execute();
 
@@ -55,6 +58,14 @@ public:
   /// @brief Compute the term for given element in given vectors
   virtual void compute_term(const Uint elem_idx, std::vector<RealVector>& term, std::vector<Real>& wave_speed) = 0;
 
+  /// @brief Add the term of the elements [begin,end) to contiguous buffers
+  /// @param term  nb_sol_pts*nb_eqs values per element, solution point by solution point. The term is added to it.
+  /// @param wave_speed  nb_sol_pts values per element, replaced by the term wave speed where that is larger
+  /// The default implementation calls compute_term for each element. Term computers that know the number of
+  /// solution points and equations at compile time can override this and use TermBlock to avoid dynamic vectors.
+  virtual void add_term_block(const Uint begin, const Uint end, const Uint nb_sol_pts, const Uint nb_eqs,
+                              Real* term, Real* wave_speed);
+
  private:
 
   Handle<mesh::Field> m_term_field;
@@ -62,6 +73,34 @@ public:
   
   std::vector<RealVector> m_tmp_term;
   std::vector<Real>       m_tmp_ws;
+
+  std::vector<Real> m_block_term;
+  std::vector<Real> m_block_ws;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Fixed size view on the buffers of TermComputer::add_term_block
+template <Uint NB_SOL_PTS, Uint NB_EQS>
+class TermBlock
+{
+public:
+  /// Term of one element, a row per solution point
+  typedef Eigen::Matrix<Real, NB_SOL_PTS, NB_EQS, NB_EQS == 1 ? Eigen::ColMajor : Eigen::RowMajor> ElementTermT;
+  /// Wave speeds of one element
+  typedef Eigen::Matrix<Real, NB_SOL_PTS, 1> ElementWaveSpeedT;
+
+  TermBlock(Real* term, Real* wave_speed) : m_term(term), m_wave_speed(wave_speed) {}
+
+  /// Term of the i-th element of the block
+  Eigen::Map<ElementTermT> term(const Uint i) const { return Eigen::Map<ElementTermT>(m_term + i*NB_SOL_PTS*NB_EQS); }
+
+  /// Wave speeds of the i-th element of the block
+  Eigen::Map<ElementWaveSpeedT> wave_speed(const Uint i) const { return Eigen::Map<ElementWaveSpeedT>(m_wave_speed + i*NB_SOL_PTS); }
+
+private:
+  Real* m_term;
+  Real* m_wave_speed;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
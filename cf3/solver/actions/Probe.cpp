@@ -8,6 +8,7 @@
 #include <boost/function.hpp>
 
 #include "common/Core.hpp"
+#include "common/EventHandler.hpp"
 #include "common/Builder.hpp"
 #include "common/PropertyList.hpp"
 #include "common/OptionList.hpp"
@@ -29,6 +30,7 @@
 #include "mesh/Dictionary.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/PointInterpolator.hpp"
+#include "mesh/Tags.hpp"
 
 namespace cf3 {
 namespace solver {
@@ -42,7 +44,10 @@ common::ComponentBuilder < Probe, common::Action, solver::actions::LibActions >
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-Probe::Probe( const std::string& name  ) : common::Action(name)
+Probe::Probe( const std::string& name  ) :
+  common::Action(name),
+  m_located(false),
+  m_found_on_proc(-1)
 {
   mark_basic(); // by default probes are visible
 
@@ -54,7 +59,8 @@ Probe::Probe( const std::string& name  ) : common::Action(name)
   options().add("coordinate",std::vector<Real>())
     .pretty_name("Coordinate")
     .description("Coordinate to interpolate fields to")
-    .mark_basic();
+    .mark_basic()
+    .attach_trigger( boost::bind( &Probe::invalidate_location, this ) );
     
   options().add("dict",m_dict)
       .description("Dictionary that will be probed")
@@ -70,6 +76,8 @@ Probe::Probe( const std::string& name  ) : common::Action(name)
 
   m_point_interpolator = create_component<PointInterpolator>("point_interpolator");
   m_variables = create_component<math::VariablesDescriptor>("variables");
+
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &Probe::on_mesh_changed_event);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -77,46 +85,59 @@ Probe::Probe( const std::string& name  ) : common::Action(name)
 void Probe::configure_point_interpolator()
 {
   m_point_interpolator->options().set("dict",m_dict);
+  invalidate_location();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Probe::execute()
+void Probe::invalidate_location()
 {
-  if ( is_null(m_dict) )
-    throw SetupError(FromHere(), "Option \"dict\" was not configured in "+uri().string());
+  m_located = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Probe::on_mesh_changed_event(SignalArgs& args)
+{
+  invalidate_location();
+}
 
+////////////////////////////////////////////////////////////////////////////////
+
+void Probe::locate()
+{
   // Take the coordinate from the options
   std::vector<Real> opt_coord = options().value< std::vector<Real> >("coordinate");
   RealVector coord(opt_coord.size());
   math::copy(opt_coord,coord);
 
   // Find interpolation data for this coordinate
-  SpaceElem m_element;
-  std::vector<SpaceElem> m_stencil;
-  std::vector<Uint> m_points;
-  std::vector<Real> m_weights;
+  SpaceElem element;
+  std::vector<SpaceElem> stencil;
 
-  int found = m_point_interpolator->compute_storage(coord,m_element,m_stencil,m_points,m_weights);
+  const bool found = m_point_interpolator->compute_storage(coord,element,stencil,m_points,m_weights);
 
-//  std::cout << PE::Comm::instance().rank() << ":  found = " << found << std::endl;
-
-  int found_on_proc = found ? PE::Comm::instance().rank() : -1;
+  m_found_on_proc = found ? PE::Comm::instance().rank() : -1;
 
   if (PE::Comm::instance().is_active())
-    PE::Comm::instance().all_reduce(PE::max(), &found_on_proc, 1, &found_on_proc);
-
-//  std::cout << PE::Comm::instance().rank() << ":  found_on_proc = " << found_on_proc << std::endl;
+    PE::Comm::instance().all_reduce(PE::max(), &m_found_on_proc, 1, &m_found_on_proc);
 
-  if (found_on_proc<0)
+  if (m_found_on_proc<0)
     throw SetupError(FromHere(),"Cannot probe: coordinate ("+to_str(opt_coord)+") lies outside the domain");
 
+  // Only the owning rank interpolates
+  if (m_found_on_proc != PE::Comm::instance().rank())
+  {
+    m_points.clear();
+    m_weights.clear();
+  }
+
   PE::Buffer elem_comp_buffer;
-  if (found)
+  if (m_found_on_proc == PE::Comm::instance().rank())
   {
-    elem_comp_buffer << m_element.comp->uri().path() << m_element.glb_idx();
+    elem_comp_buffer << element.comp->uri().path() << element.glb_idx();
   }
-  elem_comp_buffer.broadcast(found_on_proc);
+  elem_comp_buffer.broadcast(m_found_on_proc);
   std::string elem_comp;
   Uint glb_idx;
   elem_comp_buffer >> elem_comp >> glb_idx;
@@ -124,33 +145,48 @@ void Probe::execute()
   properties()["space"]=elem_comp;
   properties()["glb_elem_idx"]=glb_idx;
 
-//  std::cout << PE::Comm::instance().rank() << ":  elem_comp = " << elem_comp << std::endl;
-//  std::cout << PE::Comm::instance().rank() << ":  glb_idx = " << glb_idx << std::endl;
+  m_located = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
-  boost_foreach (const Handle<Field>& field, m_dict->fields())
-  {
+void Probe::execute()
+{
+  if ( is_null(m_dict) )
+    throw SetupError(FromHere(), "Option \"dict\" was not configured in "+uri().string());
 
-    // Interpolate each field to the given point
-    std::vector<Real> interpolated(field->row_size());
+  if ( !m_located )
+    locate();
+
+  // Interpolate all fields into a single buffer, so the owning rank sends all values in one broadcast
+  Uint total_row_size = 0;
+  boost_foreach (const Handle<Field>& field, m_dict->fields())
+    total_row_size += field->row_size();
 
-    if (found)
+  std::vector<Real> interpolated(total_row_size, 0.);
+  Uint field_offset = 0;
+  boost_foreach (const Handle<Field>& field, m_dict->fields())
+  {
+    const Uint row_size = field->row_size();
+    for(Uint i=0; i<m_points.size(); ++i)
     {
-      for(Uint v=0; v<interpolated.size(); ++v)
-      {
-        interpolated[v]=0.;
-        for(Uint i=0; i<m_points.size(); ++i)
-        {
-          interpolated[v] += field->array()[m_points[i]][v] * m_weights[i];
-        }
-      }
+      const Field::ConstRow source_row = field->array()[m_points[i]];
+      for(Uint v=0; v<row_size; ++v)
+        interpolated[field_offset+v] += source_row[v] * m_weights[i];
     }
+    field_offset += row_size;
+  }
 
-    PE::Comm::instance().broadcast(interpolated,interpolated,found_on_proc);
+  if (PE::Comm::instance().is_active() && !interpolated.empty())
+    PE::Comm::instance().broadcast(&interpolated[0],interpolated.size(),&interpolated[0],m_found_on_proc);
 
-    // Set interpolated variables as properties
+  // Set interpolated variables as properties
+  field_offset = 0;
+  boost_foreach (const Handle<Field>& field, m_dict->fields())
+  {
     for (Uint var_idx=0; var_idx<field->nb_vars(); ++var_idx)
     {
-      Uint var_begin  = field->descriptor().offset(var_idx);
+      Uint var_begin  = field_offset + field->descriptor().offset(var_idx);
       Uint var_length = field->descriptor().var_length(var_idx);
       if (var_length==1)
       {
@@ -164,6 +200,7 @@ void Probe::execute()
         }
       }
     }
+    field_offset += field->row_size();
   }
 
   // Do all post-processing actions, which could add more properties to the probe,
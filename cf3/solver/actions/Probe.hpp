@@ -28,6 +28,9 @@ class ProbePostProcessor;
 /// Interpolated values are stored as properties within the probe component.
 /// Actions can be added as child to the probe, and will be executed, after
 /// the probe is executed.
+/// The coordinate is located on the first execution, and the interpolation data is kept
+/// until the coordinate, the dictionary or the mesh change. Each execution then
+/// sends the values of all fields from the owning rank in a single broadcast.
 /// @author Willem Deconinck
 class solver_actions_API Probe : public common::Action {
 friend class ProbePostProcessor;
@@ -74,12 +77,26 @@ private: // functions
   /// @brief Configure the point interpolator
   void configure_point_interpolator();
 
+  /// @brief Find the rank owning the coordinate and its interpolation data. Collective.
+  void locate();
+
+  /// @brief Discard the interpolation data, so the coordinate is located again on the next execution
+  void invalidate_location();
+
+  /// @brief Discard the interpolation data when the mesh changes
+  void on_mesh_changed_event(common::SignalArgs& args);
+
 private: // data
 
   Handle<mesh::Dictionary>            m_dict;                ///< Dictionary to interpolate
   Handle<mesh::PointInterpolator>     m_point_interpolator;  ///< Interpolator for one point
   Handle< math::VariablesDescriptor > m_variables;           ///< Variable description
 
+  bool m_located;                                            ///< True if the interpolation data is up to date
+  int m_found_on_proc;                                       ///< Rank that interpolates the coordinate
+  std::vector<Uint> m_points;                                ///< Dictionary entries used for the interpolation, on the owning rank
+  std::vector<Real> m_weights;                               ///< Interpolation weights of m_points
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -8,6 +8,7 @@
 #include <boost/function.hpp>
 
 #include "common/Core.hpp"
+#include "common/EventHandler.hpp"
 #include "common/Builder.hpp"
 #include "common/PropertyList.hpp"
 #include "common/OptionList.hpp"
@@ -29,6 +30,7 @@
 #include "mesh/Dictionary.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/PointInterpolator.hpp"
+#include "mesh/Tags.hpp"
 
 namespace cf3 {
 namespace solver {
@@ -46,25 +48,28 @@ ProbePoints::ProbePoints( const std::string& name  ) : common::Action(name)
 {
   mark_basic(); // by default probes are visible
 
-  properties()["brief"] = std::string("Probe to interpolate field values to a given coordinate");
+  properties()["brief"] = std::string("Probe to interpolate field values to a set of points");
   std::string description =
-      "Configure a coordinate and dictionary, and the probe will interpolate all found values";
+      "Configure the point coordinates and dictionary, and the probe will interpolate all found values";
   properties()["description"] = description;
   
   options().add("x_coordinate",std::vector<Real>())
     .pretty_name("xcoordinate")
     .description("x-coordinate to interpolate fields to")
-    .mark_basic();
+    .mark_basic()
+    .attach_trigger( boost::bind( &ProbePoints::invalidate_points, this ) );
 
   options().add("y_coordinate",std::vector<Real>())
     .pretty_name("ycoordinate")
     .description("y-coordinate to interpolate fields to")
-    .mark_basic();
+    .mark_basic()
+    .attach_trigger( boost::bind( &ProbePoints::invalidate_points, this ) );
 
   options().add("z_coordinate",std::vector<Real>())
     .pretty_name("zcoordinate")
     .description("z-coordinate to interpolate fields to")
-    .mark_basic();
+    .mark_basic()
+    .attach_trigger( boost::bind( &ProbePoints::invalidate_points, this ) );
     
   options().add("dict",m_dict)
       .description("Dictionary that will be probed")
@@ -80,6 +85,9 @@ ProbePoints::ProbePoints( const std::string& name  ) : common::Action(name)
 
   m_point_interpolator = create_component<PointInterpolator>("point_interpolator");
   m_variables = create_component<math::VariablesDescriptor>("variables");
+
+  m_points_located = false;
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &ProbePoints::on_mesh_changed_event);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -87,93 +95,155 @@ ProbePoints::ProbePoints( const std::string& name  ) : common::Action(name)
 void ProbePoints::configure_point_interpolator()
 {
   m_point_interpolator->options().set("dict",m_dict);
+  invalidate_points();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void ProbePoints::execute()
+void ProbePoints::invalidate_points()
 {
-  if ( is_null(m_dict) )
-    throw SetupError(FromHere(), "Option \"dict\" was not configured in "+uri().string());
-
-  // Take the coordinate from the options
-  std::vector<Real> opt_coord = options().value< std::vector<Real> >("coordinate");
-  RealVector coord(opt_coord.size()); //get the size
-  math::copy(opt_coord,coord);
+  m_points_located = false;
+}
 
-  // Find interpolation data for this coordinate
-  SpaceElem m_element;
-  std::vector<SpaceElem> m_stencil;
-  std::vector<Uint> m_points;
-  std::vector<Real> m_weights;
+////////////////////////////////////////////////////////////////////////////////
 
-  int found = m_point_interpolator->compute_storage(coord,m_element,m_stencil,m_points,m_weights);
+void ProbePoints::on_mesh_changed_event(SignalArgs& args)
+{
+  invalidate_points();
+}
 
-//  std::cout << PE::Comm::instance().rank() << ":  found = " << found << std::endl;
+////////////////////////////////////////////////////////////////////////////////
 
-  int found_on_proc = found ? PE::Comm::instance().rank() : -1;
+Uint ProbePoints::nb_points() const
+{
+  return options().value< std::vector<Real> >("x_coordinate").size();
+}
 
-  if (PE::Comm::instance().is_active())
-    PE::Comm::instance().all_reduce(PE::max(), &found_on_proc, 1, &found_on_proc);
+////////////////////////////////////////////////////////////////////////////////
 
-//  std::cout << PE::Comm::instance().rank() << ":  found_on_proc = " << found_on_proc << std::endl;
+void ProbePoints::locate_points()
+{
+  const std::vector<Real> x = options().value< std::vector<Real> >("x_coordinate");
+  const std::vector<Real> y = options().value< std::vector<Real> >("y_coordinate");
+  const std::vector<Real> z = options().value< std::vector<Real> >("z_coordinate");
+  const Uint nb_probe_points = x.size();
+  const Uint dim = z.empty() ? (y.empty() ? 1 : 2) : 3;
+  if ( (dim > 1 && y.size() != nb_probe_points) || (dim > 2 && z.size() != nb_probe_points) )
+    throw SetupError(FromHere(), "The coordinate options of "+uri().string()+" must all have the same size");
+
+  m_local_points.clear();
+  m_stencil_starts.assign(1, 0u);
+  m_source_points.clear();
+  m_source_weights.clear();
+
+  // Find all points on this rank first, so the owners are found in a single reduction
+  SpaceElem element;
+  std::vector<SpaceElem> stencil;
+  std::vector<Uint> points;
+  std::vector<Real> weights;
+  RealVector coord(dim);
+  std::vector<int> found_on_proc(nb_probe_points, -1);
+  std::vector< std::vector<Uint> > found_points(nb_probe_points);
+  std::vector< std::vector<Real> > found_weights(nb_probe_points);
+  for (Uint i=0; i<nb_probe_points; ++i)
+  {
+    coord[XX] = x[i];
+    if (dim > 1) coord[YY] = y[i];
+    if (dim > 2) coord[ZZ] = z[i];
+    if (m_point_interpolator->compute_storage(coord,element,stencil,points,weights))
+    {
+      found_on_proc[i] = PE::Comm::instance().rank();
+      found_points[i].swap(points);
+      found_weights[i].swap(weights);
+    }
+  }
 
-  if (found_on_proc<0)
-    throw SetupError(FromHere(),"Cannot probe: coordinate ("+to_str(opt_coord)+") lies outside the domain");
+  if (PE::Comm::instance().is_active() && nb_probe_points != 0)
+    PE::Comm::instance().all_reduce(PE::max(), &found_on_proc[0], nb_probe_points, &found_on_proc[0]);
 
-  PE::Buffer elem_comp_buffer;
-  if (found)
+  m_point_ranks.resize(nb_probe_points);
+  for (Uint i=0; i<nb_probe_points; ++i)
   {
-    elem_comp_buffer << m_element.comp->uri().path() << m_element.glb_idx();
+    if (found_on_proc[i] < 0)
+      throw SetupError(FromHere(),"Cannot probe: point "+to_str(i)+" of "+uri().string()+" lies outside the domain");
+
+    m_point_ranks[i] = found_on_proc[i];
+    if (m_point_ranks[i] != PE::Comm::instance().rank())
+      continue;
+
+    m_local_points.push_back(i);
+    m_source_points.insert(m_source_points.end(), found_points[i].begin(), found_points[i].end());
+    m_source_weights.insert(m_source_weights.end(), found_weights[i].begin(), found_weights[i].end());
+    m_stencil_starts.push_back(m_source_points.size());
   }
-  elem_comp_buffer.broadcast(found_on_proc);
-  std::string elem_comp;
-  Uint glb_idx;
-  elem_comp_buffer >> elem_comp >> glb_idx;
 
-  properties()["space"]=elem_comp;
-  properties()["glb_elem_idx"]=glb_idx;
+  m_points_located = true;
+}
 
-//  std::cout << PE::Comm::instance().rank() << ":  elem_comp = " << elem_comp << std::endl;
-//  std::cout << PE::Comm::instance().rank() << ":  glb_idx = " << glb_idx << std::endl;
+////////////////////////////////////////////////////////////////////////////////
 
-  boost_foreach (const Handle<Field>& field, m_dict->fields())
-  {
+void ProbePoints::execute()
+{
+  if ( is_null(m_dict) )
+    throw SetupError(FromHere(), "Option \"dict\" was not configured in "+uri().string());
+
+  if ( !m_points_located )
+    locate_points();
+
+  const Uint nb_probe_points = m_point_ranks.size();
+  const Uint nb_local_points = m_local_points.size();
 
-    // Interpolate each field to the given point
-    std::vector<Real> interpolated(field->row_size());
+  // Interpolate all fields into a single buffer, so the values from all ranks are combined in one reduction
+  Uint total_row_size = 0;
+  boost_foreach (const Handle<Field>& field, m_dict->fields())
+    total_row_size += field->row_size();
 
-    if (found)
+  std::vector<Real> values(nb_probe_points*total_row_size, 0.);
+  Uint field_offset = 0;
+  boost_foreach (const Handle<Field>& field, m_dict->fields())
+  {
+    const Uint row_size = field->row_size();
+    for (Uint l=0; l<nb_local_points; ++l)
     {
-      for(Uint v=0; v<interpolated.size(); ++v)
+      Real* point_values = &values[m_local_points[l]*total_row_size + field_offset];
+      for (Uint i=m_stencil_starts[l]; i<m_stencil_starts[l+1]; ++i)
       {
-        interpolated[v]=0.;
-        for(Uint i=0; i<m_points.size(); ++i)
-        {
-          interpolated[v] += field->array()[m_points[i]][v] * m_weights[i];
-        }
+        const Field::ConstRow source_row = field->array()[m_source_points[i]];
+        for (Uint v=0; v<row_size; ++v)
+          point_values[v] += source_row[v] * m_source_weights[i];
       }
     }
+    field_offset += row_size;
+  }
 
-    PE::Comm::instance().broadcast(interpolated,interpolated,found_on_proc);
+  if (PE::Comm::instance().is_active() && !values.empty())
+    PE::Comm::instance().all_reduce(PE::plus(), &values[0], values.size(), &values[0]);
 
-    // Set interpolated variables as properties
+  // Set interpolated variables as properties
+  field_offset = 0;
+  boost_foreach (const Handle<Field>& field, m_dict->fields())
+  {
     for (Uint var_idx=0; var_idx<field->nb_vars(); ++var_idx)
     {
-      Uint var_begin  = field->descriptor().offset(var_idx);
-      Uint var_length = field->descriptor().var_length(var_idx);
-      if (var_length==1)
-      {
-        set(field->descriptor().user_variable_name(var_idx) , interpolated[var_begin]);
-      }
-      else
+      const Uint var_begin  = field_offset + field->descriptor().offset(var_idx);
+      const Uint var_length = field->descriptor().var_length(var_idx);
+      for (Uint p=0; p<nb_probe_points; ++p)
       {
-        for (Uint i=0; i<var_length; ++i)
+        const std::string var_name = field->descriptor().user_variable_name(var_idx) + point_suffix(p);
+        if (var_length==1)
+        {
+          set(var_name, values[p*total_row_size + var_begin]);
+        }
+        else
         {
-          set(field->descriptor().user_variable_name(var_idx)+"["+to_str(i)+"]" , interpolated[var_begin+i]);
+          for (Uint i=0; i<var_length; ++i)
+          {
+            set(var_name+"["+to_str(i)+"]", values[p*total_row_size + var_begin + i]);
+          }
         }
       }
     }
+    field_offset += field->row_size();
   }
 
   // Do all post-processing actions, which could add more properties to the ProbePoints,
@@ -193,7 +263,7 @@ void ProbePoints::set(const std::string& var_name, const Real& var_value)
   {
     if (m_variables->nb_vars() == 0)
     {
-      m_variables->options().set("dimension",(Uint)options().value<std::vector<Real> >("coordinate").size());
+      m_variables->options().set("dimension",is_not_null(m_dict) ? m_dict->coordinates().row_size() : 1u);
     }
 
     m_variables->push_back(var_name,math::VariablesDescriptor::Dimensionalities::SCALAR);
@@ -203,6 +273,13 @@ void ProbePoints::set(const std::string& var_name, const Real& var_value)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+std::string ProbePoints::point_suffix(const Uint point_idx) const
+{
+  return m_point_ranks.size() == 1 ? std::string() : "_"+to_str(point_idx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ProbePoints::set(const std::string& var_name, const std::vector<Real>& var_values)
 {
   for (Uint i=0; i<var_values.size(); ++i)
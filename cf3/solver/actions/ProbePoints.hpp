@@ -23,9 +23,15 @@ class ProbePointsPostProcessor;
 
 ////////////////////////////////////////////////////////////////////////////////
 
-/// @brief Probe to interpolate field values to given coordinate along a line
+/// @brief Probe to interpolate field values to a set of points
 ///
-/// Interpolated values are stored as properties within the probe component.
+/// The points are given by the x_coordinate, y_coordinate and z_coordinate options.
+/// All points are located once, and the rank owning each point stores the interpolation
+/// stencil and weights. The stored data is reused until the points, the dictionary or the mesh change,
+/// so each execution only interpolates the local points and gathers all values in a single reduction.
+///
+/// Interpolated values are stored as scalar properties within the probe component.
+/// With more than one point, the name of each property ends with "_" and the index of the point.
 /// Actions can be added as child to the probe, and will be executed, after
 /// the probe is executed.
 class solver_actions_API ProbePoints : public common::Action {
@@ -56,6 +62,12 @@ public: // functions
   /// @brief Access to the description of the probed variables
   Handle<math::VariablesDescriptor> variables() { return m_variables; }
 
+  /// @brief Number of points in the probe
+  Uint nb_points() const;
+
+  /// @brief Rank of the process that interpolates each point. Only valid after execution.
+  const std::vector<Uint>& point_ranks() const { return m_point_ranks; }
+
 private: // functions
 
   /// @brief Add a variable to the internal storage
@@ -70,15 +82,33 @@ private: // functions
   /// This function can be called multiple times per entry.
   void set(const std::string& var_name, const std::vector<Real>& var_values);
 
+  /// @brief Suffix of the property names of a point, empty if there is only one point
+  std::string point_suffix(const Uint point_idx) const;
+
   /// @brief Configure the point interpolator
   void configure_point_interpolator();
 
+  /// @brief Find the owner of each point and the interpolation data for the local points. Collective.
+  void locate_points();
+
+  /// @brief Discard the interpolation data, so the points are located again on the next execution
+  void invalidate_points();
+
+  /// @brief Discard the interpolation data when the mesh changes
+  void on_mesh_changed_event(common::SignalArgs& args);
+
 private: // data
 
   Handle<mesh::Dictionary>            m_dict;                ///< Dictionary to interpolate
   Handle<mesh::PointInterpolator>     m_point_interpolator;  ///< Interpolator for one point
   Handle< math::VariablesDescriptor > m_variables;           ///< Variable description
 
+  bool m_points_located;                                     ///< True if the interpolation data is up to date
+  std::vector<Uint> m_point_ranks;                           ///< Rank interpolating each point
+  std::vector<Uint> m_local_points;                          ///< Points interpolated by this rank
+  std::vector<Uint> m_stencil_starts;                        ///< Start of the data for each local point in m_source_points and m_source_weights
+  std::vector<Uint> m_source_points;                         ///< Dictionary entries used to interpolate the local points
+  std::vector<Real> m_source_weights;                        ///< Interpolation weights for m_source_points
 };
 
 ////////////////////////////////////////////////////////////////////////////////
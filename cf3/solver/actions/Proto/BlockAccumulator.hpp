@@ -19,6 +19,7 @@
 #include "math/LSS/BlockAccumulator.hpp"
 #include "math/LSS/Matrix.hpp"
 
+#include "ElementScatterMap.hpp"
 #include "LSSWrapper.hpp"
 #include "Terminals.hpp"
 
@@ -109,6 +110,35 @@ inline void do_assign_op_matrix(boost::proto::tag::plus_assign, math::LSS::Matri
   }
 }
 
+/// Only additions can use the scatter map
+template<typename OpTagT, typename LSST, typename DataT>
+inline bool do_scatter_op_matrix(OpTagT, LSST& lss, const DataT& data)
+{
+  return false;
+}
+
+/// Add the element matrix at the locations stored in the scatter map of the matrix, skipping the index conversion.
+/// The scatter data is looked up once per matrix and connectivity, and the values are then added inline.
+/// Returns false if the block must be added through the block accumulator indices instead.
+template<typename LSST, typename DataT>
+inline bool do_scatter_op_matrix(boost::proto::tag::plus_assign, LSST& lss, const DataT& data)
+{
+  if(!data.use_scatter_map)
+    return false;
+
+  math::LSS::Matrix& lss_matrix = lss.matrix();
+  if(data.scatter_matrix != &lss_matrix)
+  {
+    data.scatter = element_scatter(lss_matrix, data.block_connectivity(), lss.used_node_map());
+    data.scatter_matrix = &lss_matrix;
+  }
+  if(data.scatter == nullptr)
+    return false;
+
+  data.scatter->add_element_values(data.element_idx(), data.block_accumulator.mat.data());
+  return true;
+}
+
 /// Translate tag to operator
 inline void do_assign_op_rhs(boost::proto::tag::assign, math::LSS::Vector& lss_rhs, const math::LSS::BlockAccumulator& block_accumulator)
 {
@@ -154,7 +184,6 @@ struct BlockAssignmentOp<SystemMatrixTag, OpTagT>
     static const Uint nb_nodes = detail::SafeNbNodes<DataT::nb_lss_nodes>::value;
     static const Uint nb_dofs = mat_size / nb_nodes;
     math::LSS::BlockAccumulator& block_accumulator = data.block_accumulator;
-    lss.convert_to_lss(data);
 
     for(Uint row = 0; row != mat_size; ++row)
     {
@@ -166,6 +195,11 @@ struct BlockAssignmentOp<SystemMatrixTag, OpTagT>
         block_accumulator.mat(block_row, block_col) = rhs(row, col);
       }
     }
+
+    if(do_scatter_op_matrix(OpTagT(), lss, data))
+      return;
+
+    lss.convert_to_lss(data);
     do_assign_op_matrix(OpTagT(), lss.matrix(), block_accumulator);
   }
 };
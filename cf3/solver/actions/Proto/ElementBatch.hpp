@@ -0,0 +1,239 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Proto_ElementBatch_hpp
+#define cf3_solver_actions_Proto_ElementBatch_hpp
+
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/Core>
+
+#include "common/Assertions.hpp"
+#include "common/Table.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/GeoShape.hpp"
+
+/// @file
+/// Evaluation of the geometric data of several elements at once
+
+/// Number of elements that are evaluated together in a batch. This should be a multiple of the SIMD width for doubles.
+#ifndef CF3_PROTO_ELEMENT_BATCH_SIZE
+  #define CF3_PROTO_ELEMENT_BATCH_SIZE 8
+#endif
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+/// True if the mapping from mapped to real coordinates is affine, i.e. the Jacobian is constant over the element
+template<typename ETYPE>
+struct HasAffineMapping
+{
+  static const bool value = ETYPE::order == 1 && ETYPE::dimension == ETYPE::dimensionality &&
+    (ETYPE::shape == mesh::GeoShape::LINE || ETYPE::shape == mesh::GeoShape::TRIAG || ETYPE::shape == mesh::GeoShape::TETRA);
+};
+
+namespace detail
+{
+  /// Inverse and determinant of a batch of small matrices, stored as a[row][col][lane]
+  template<Uint Dim>
+  struct BatchInverse;
+
+  template<>
+  struct BatchInverse<1>
+  {
+    template<Uint N>
+    static void apply(const Real (&a)[1][1][N], Real (&inv)[1][1][N], Real (&det)[N])
+    {
+      for(Uint l = 0; l != N; ++l)
+      {
+        det[l] = a[0][0][l];
+        inv[0][0][l] = 1. / det[l];
+      }
+    }
+  };
+
+  template<>
+  struct BatchInverse<2>
+  {
+    template<Uint N>
+    static void apply(const Real (&a)[2][2][N], Real (&inv)[2][2][N], Real (&det)[N])
+    {
+      for(Uint l = 0; l != N; ++l)
+      {
+        det[l] = a[0][0][l]*a[1][1][l] - a[0][1][l]*a[1][0][l];
+        const Real inv_det = 1. / det[l];
+        inv[0][0][l] =  a[1][1][l] * inv_det;
+        inv[0][1][l] = -a[0][1][l] * inv_det;
+        inv[1][0][l] = -a[1][0][l] * inv_det;
+        inv[1][1][l] =  a[0][0][l] * inv_det;
+      }
+    }
+  };
+
+  template<>
+  struct BatchInverse<3>
+  {
+    template<Uint N>
+    static void apply(const Real (&a)[3][3][N], Real (&inv)[3][3][N], Real (&det)[N])
+    {
+      for(Uint l = 0; l != N; ++l)
+      {
+        const Real c00 = a[1][1][l]*a[2][2][l] - a[1][2][l]*a[2][1][l];
+        const Real c01 = a[1][2][l]*a[2][0][l] - a[1][0][l]*a[2][2][l];
+        const Real c02 = a[1][0][l]*a[2][1][l] - a[1][1][l]*a[2][0][l];
+        det[l] = a[0][0][l]*c00 + a[0][1][l]*c01 + a[0][2][l]*c02;
+        const Real inv_det = 1. / det[l];
+        inv[0][0][l] = c00 * inv_det;
+        inv[1][0][l] = c01 * inv_det;
+        inv[2][0][l] = c02 * inv_det;
+        inv[0][1][l] = (a[0][2][l]*a[2][1][l] - a[0][1][l]*a[2][2][l]) * inv_det;
+        inv[1][1][l] = (a[0][0][l]*a[2][2][l] - a[0][2][l]*a[2][0][l]) * inv_det;
+        inv[2][1][l] = (a[0][1][l]*a[2][0][l] - a[0][0][l]*a[2][1][l]) * inv_det;
+        inv[0][2][l] = (a[0][1][l]*a[1][2][l] - a[0][2][l]*a[1][1][l]) * inv_det;
+        inv[1][2][l] = (a[0][2][l]*a[1][0][l] - a[0][0][l]*a[1][2][l]) * inv_det;
+        inv[2][2][l] = (a[0][0][l]*a[1][1][l] - a[0][1][l]*a[1][0][l]) * inv_det;
+      }
+    }
+  };
+}
+
+/// Nodes and Jacobian data for a batch of elements with an affine mapping, computed for all elements of the batch at once.
+/// Values are stored with the element in the batch (the "lane") as fastest running index, so the compiler can vectorize
+/// the loops across elements. Elements without an affine mapping use the specialization below, which does nothing.
+template<typename ETYPE, bool IsAffine = HasAffineMapping<ETYPE>::value>
+class ElementBatch
+{
+public:
+  static const Uint size = CF3_PROTO_ELEMENT_BATCH_SIZE;
+  static const Uint nb_nodes = ETYPE::nb_nodes;
+  static const Uint dim = ETYPE::dimension;
+
+  ElementBatch() : m_nb_elements(0), m_next(0)
+  {
+    // The gradient of the shape functions in mapped coordinates is constant for an affine mapping
+    ETYPE::SF::compute_gradient(ETYPE::MappedCoordsT::Zero(), m_mapped_gradient);
+  }
+
+  /// Gather the nodes of the given elements and compute their Jacobians
+  void compute(const common::Table<Real>& coordinates, const mesh::Connectivity::ArrayT& connectivity, const Uint* elements, const Uint nb_elements)
+  {
+    cf3_assert(nb_elements > 0 && nb_elements <= size);
+    m_nb_elements = nb_elements;
+    m_next = 0;
+    std::copy(elements, elements + nb_elements, m_elements);
+
+    // Gather, padding the unused lanes with the last element to avoid dividing by zero
+    const Real* coords = coordinates.array().data();
+    const std::ptrdiff_t row_stride = coordinates.array().strides()[0];
+    const std::ptrdiff_t col_stride = coordinates.array().strides()[1];
+    for(Uint l = 0; l != size; ++l)
+    {
+      const mesh::Connectivity::ConstRow row = connectivity[elements[std::min(l, nb_elements-1)]];
+      for(Uint n = 0; n != nb_nodes; ++n)
+      {
+        const Real* node = coords + row[n]*row_stride;
+        for(Uint d = 0; d != dim; ++d)
+          m_nodes[n][d][l] = node[d*col_stride];
+      }
+    }
+
+    for(Uint i = 0; i != dim; ++i)
+    {
+      for(Uint j = 0; j != dim; ++j)
+      {
+        for(Uint l = 0; l != size; ++l)
+          m_jacobian[i][j][l] = 0.;
+        for(Uint n = 0; n != nb_nodes; ++n)
+        {
+          const Real g = m_mapped_gradient(i, n);
+          for(Uint l = 0; l != size; ++l)
+            m_jacobian[i][j][l] += g * m_nodes[n][j][l];
+        }
+      }
+    }
+
+    detail::BatchInverse<dim>::apply(m_jacobian, m_jacobian_inverse, m_jacobian_determinant);
+  }
+
+  /// True if the Jacobian of the current element is invertible, using the same threshold as the element by element computation
+  bool is_invertible() const
+  {
+    return std::abs(m_jacobian_determinant[m_current]) > Eigen::NumTraits<Real>::dummy_precision();
+  }
+
+  /// If element_idx is the next element of the batch, copy its nodes and return true. The batch is then positioned on this element.
+  bool next(const Uint element_idx, typename ETYPE::NodesT& nodes)
+  {
+    if(m_next == m_nb_elements || m_elements[m_next] != element_idx)
+    {
+      m_next = m_nb_elements; // Leave the batch if elements are visited out of order
+      return false;
+    }
+
+    m_current = m_next++;
+    for(Uint n = 0; n != nb_nodes; ++n)
+      for(Uint d = 0; d != dim; ++d)
+        nodes(n, d) = m_nodes[n][d][m_current];
+    return true;
+  }
+
+  /// Copy the Jacobian data of the current element
+  void jacobian(typename ETYPE::JacobianT& jacobian, typename ETYPE::JacobianT& jacobian_inverse, Real& jacobian_determinant) const
+  {
+    for(Uint i = 0; i != dim; ++i)
+    {
+      for(Uint j = 0; j != dim; ++j)
+      {
+        jacobian(i, j) = m_jacobian[i][j][m_current];
+        jacobian_inverse(i, j) = m_jacobian_inverse[i][j][m_current];
+      }
+    }
+    jacobian_determinant = m_jacobian_determinant[m_current];
+    cf3_assert(is_invertible());
+  }
+
+private:
+  typename ETYPE::SF::GradientT m_mapped_gradient;
+  Uint m_elements[size];
+  Uint m_nb_elements;
+  Uint m_next;
+  Uint m_current;
+
+  Real m_nodes[nb_nodes][dim][size];
+  Real m_jacobian[dim][dim][size];
+  Real m_jacobian_inverse[dim][dim][size];
+  Real m_jacobian_determinant[size];
+};
+
+/// Elements with a non-affine mapping are always evaluated one by one
+template<typename ETYPE>
+class ElementBatch<ETYPE, false>
+{
+public:
+  void compute(const common::Table<Real>&, const mesh::Connectivity::ArrayT&, const Uint*, const Uint)
+  {
+  }
+
+  bool next(const Uint, typename ETYPE::NodesT&)
+  {
+    return false;
+  }
+
+  void jacobian(typename ETYPE::JacobianT&, typename ETYPE::JacobianT&, Real&) const
+  {
+  }
+};
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
+
+#endif // cf3_solver_actions_Proto_ElementBatch_hpp
@@ -0,0 +1,152 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+
+#include "common/Core.hpp"
+#include "common/EventHandler.hpp"
+#include "common/List.hpp"
+#include "common/Log.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
+
+#include "ElementColoring.hpp"
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+ElementColoring::ElementColoring(const std::string& name) :
+  Component(name),
+  m_nb_nodes(0)
+{
+  common::Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &ElementColoring::on_mesh_changed_event);
+}
+
+ElementColoring::~ElementColoring()
+{
+}
+
+void ElementColoring::compute(const mesh::Elements& elements)
+{
+  const mesh::Dictionary& geometry = elements.geometry_fields();
+  const mesh::Connectivity& connectivity = elements.geometry_space().connectivity();
+  const Uint nb_elems = connectivity.size();
+  const Uint nb_nodes = geometry.size();
+  const Uint row_size = connectivity.row_size();
+
+  // Nodes that are linked periodically are the same node as far as assembly is concerned
+  std::vector<Uint> node_map(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+    node_map[i] = i;
+  Handle< common::List<Uint> const > periodic_links_nodes_h(geometry.get_child("periodic_links_nodes"));
+  Handle< common::List<bool> const > periodic_links_active_h(geometry.get_child("periodic_links_active"));
+  if(is_not_null(periodic_links_nodes_h) && is_not_null(periodic_links_active_h))
+  {
+    const common::List<Uint>& periodic_links_nodes = *periodic_links_nodes_h;
+    const common::List<bool>& periodic_links_active = *periodic_links_active_h;
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      Uint target = i;
+      while(periodic_links_active[target])
+        target = periodic_links_nodes[target];
+      node_map[i] = target;
+    }
+  }
+
+  // Greedy coloring, processing the elements in order. Each pass handles 64 colors, using a bit mask per node to
+  // flag the colors already used by an element connected to that node. Elements that don't fit go to the next pass.
+  std::vector<Uint> colors(nb_elems, 0);
+  std::vector<bool> is_colored(nb_elems, false);
+  std::vector<boost::uint64_t> node_masks(nb_nodes);
+  Uint nb_uncolored = nb_elems;
+  Uint color_offset = 0;
+  while(nb_uncolored != 0)
+  {
+    std::fill(node_masks.begin(), node_masks.end(), 0);
+    for(Uint elem = 0; elem != nb_elems; ++elem)
+    {
+      if(is_colored[elem])
+        continue;
+
+      const mesh::Connectivity::ConstRow row = connectivity[elem];
+      boost::uint64_t used_colors = 0;
+      for(Uint i = 0; i != row_size; ++i)
+        used_colors |= node_masks[node_map[row[i]]];
+
+      if(used_colors == ~boost::uint64_t(0))
+        continue;
+
+      Uint color = 0;
+      while(used_colors & (boost::uint64_t(1) << color))
+        ++color;
+
+      const boost::uint64_t color_bit = boost::uint64_t(1) << color;
+      for(Uint i = 0; i != row_size; ++i)
+        node_masks[node_map[row[i]]] |= color_bit;
+
+      colors[elem] = color_offset + color;
+      is_colored[elem] = true;
+      --nb_uncolored;
+    }
+    color_offset += 64;
+  }
+
+  // Sort the elements by color, keeping the original order within a color
+  Uint nb_colors = 0;
+  for(Uint elem = 0; elem != nb_elems; ++elem)
+    nb_colors = std::max(nb_colors, colors[elem] + 1);
+
+  m_color_starts.assign(nb_colors + 1, 0);
+  for(Uint elem = 0; elem != nb_elems; ++elem)
+    ++m_color_starts[colors[elem] + 1];
+  for(Uint color = 0; color != nb_colors; ++color)
+    m_color_starts[color + 1] += m_color_starts[color];
+
+  m_elements.resize(nb_elems);
+  std::vector<Uint> insert_positions(m_color_starts.begin(), m_color_starts.end() - 1);
+  for(Uint elem = 0; elem != nb_elems; ++elem)
+    m_elements[insert_positions[colors[elem]]++] = elem;
+
+  m_nb_nodes = nb_nodes;
+
+  CFdebug << "Colored " << nb_elems << " elements of " << elements.uri().path() << " using " << nb_colors << " colors" << CFendl;
+}
+
+bool ElementColoring::is_valid(const mesh::Elements& elements) const
+{
+  return !m_color_starts.empty() && m_elements.size() == elements.size() && m_nb_nodes == elements.geometry_fields().size();
+}
+
+void ElementColoring::on_mesh_changed_event(common::SignalArgs& args)
+{
+  m_elements.clear();
+  m_color_starts.clear();
+  m_nb_nodes = 0;
+}
+
+const ElementColoring& element_coloring(mesh::Elements& elements)
+{
+  Handle<ElementColoring> coloring(elements.get_child("element_coloring"));
+  if(is_null(coloring))
+    coloring = elements.create_component<ElementColoring>("element_coloring");
+
+  if(!coloring->is_valid(elements))
+    coloring->compute(elements);
+
+  return *coloring;
+}
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
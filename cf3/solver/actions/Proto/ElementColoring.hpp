@@ -0,0 +1,83 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Proto_ElementColoring_hpp
+#define cf3_solver_actions_Proto_ElementColoring_hpp
+
+#include <vector>
+
+#include "common/Component.hpp"
+
+#include "LoopSettings.hpp"
+
+/// @file
+/// Coloring of elements, used to run element loops on multiple threads
+
+namespace cf3 {
+  namespace mesh { class Elements; }
+namespace solver {
+namespace actions {
+namespace Proto {
+
+/// Partition of the elements of a mesh::Elements in colors, so that no two elements of the same color share a node.
+/// Elements of the same color can then be processed concurrently, since they never write to the same matrix row
+/// or nodal value. Nodes linked through periodic boundaries count as the same node.
+/// The coloring is cached as a child of the Elements and discarded when the mesh_changed event is raised.
+class ElementColoring : public common::Component
+{
+public:
+  ElementColoring(const std::string& name);
+  virtual ~ElementColoring();
+
+  static std::string type_name() { return "ElementColoring"; }
+
+  /// Compute the coloring for the given elements
+  void compute(const mesh::Elements& elements);
+
+  /// True if the stored coloring can be used for the given elements
+  bool is_valid(const mesh::Elements& elements) const;
+
+  /// Number of colors
+  Uint nb_colors() const
+  {
+    return m_color_starts.empty() ? 0 : m_color_starts.size() - 1;
+  }
+
+  /// Index of the first element of the given color in the elements() array
+  Uint color_begin(const Uint color) const
+  {
+    return m_color_starts[color];
+  }
+
+  /// One past the index of the last element of the given color in the elements() array
+  Uint color_end(const Uint color) const
+  {
+    return m_color_starts[color+1];
+  }
+
+  /// Element indices, sorted by color and then by increasing index
+  const std::vector<Uint>& elements() const
+  {
+    return m_elements;
+  }
+
+private:
+  void on_mesh_changed_event(common::SignalArgs& args);
+
+  std::vector<Uint> m_elements;
+  std::vector<Uint> m_color_starts;
+  Uint m_nb_nodes;
+};
+
+/// Get the coloring for the given elements, computing it if it was not cached yet
+const ElementColoring& element_coloring(mesh::Elements& elements);
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
+
+#endif // cf3_solver_actions_Proto_ElementColoring_hpp
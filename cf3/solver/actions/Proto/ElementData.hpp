@@ -37,8 +37,10 @@
 #include "mesh/ElementData.hpp"
 #include "mesh/Connectivity.hpp"
 
+#include "ElementBatch.hpp"
 #include "ElementMatrix.hpp"
 #include "ElementOperations.hpp"
+#include "ElementScatterMap.hpp"
 #include "ElementTransforms.hpp"
 #include "FieldSync.hpp"
 #include "Terminals.hpp"
@@ -184,8 +186,17 @@ public:
   GeometricSupport(const mesh::Elements& elements) :
     m_coordinates(elements.geometry_fields().coordinates()),
     m_connectivity_array(elements.geometry_space().connectivity().array()),
-    m_elements(elements)
+    m_elements(elements),
+    m_batched(false)
+  {
+  }
+
+  /// Compute the geometric data for a batch of at most CF3_PROTO_ELEMENT_BATCH_SIZE elements at once.
+  /// Calling set_element for these elements, in the same order, then uses the precomputed data.
+  /// This does nothing for element types with a non-affine mapping.
+  void set_batch(const Uint* elements, const Uint nb_elements)
   {
+    m_batch.compute(m_coordinates, m_connectivity_array, elements, nb_elements);
   }
 
   /// Update nodes for the current element and set the connectivity for the passed block accumulator
@@ -194,7 +205,9 @@ public:
     m_element_idx = element_idx;
     const mesh::Connectivity::ConstRow row = m_connectivity_array[element_idx];
     std::copy(row.begin(), row.end(), m_connectivity.begin());
-    mesh::fill(m_nodes, m_coordinates, m_connectivity);
+    m_batched = m_batch.next(element_idx, m_nodes);
+    if(!m_batched)
+      mesh::fill(m_nodes, m_coordinates, m_connectivity);
   }
 
   /// Reference to the current nodes
@@ -336,6 +349,12 @@ private:
 
   void compute_jacobian_dispatch(boost::mpl::true_, const typename EtypeT::MappedCoordsT& mapped_coords) const
   {
+    if(m_batched)
+    {
+      // The Jacobian is constant for batched elements, and was computed in set_batch
+      m_batch.jacobian(m_jacobian_matrix, m_jacobian_inverse, m_jacobian_determinant);
+      return;
+    }
     EtypeT::compute_jacobian(mapped_coords, m_nodes, m_jacobian_matrix);
     bool is_invertible;
     m_jacobian_matrix.computeInverseAndDetWithCheck(m_jacobian_inverse, m_jacobian_determinant, is_invertible);
@@ -359,6 +378,12 @@ private:
 
   const mesh::Elements& m_elements;
 
+  /// Geometric data computed for a batch of elements
+  ElementBatch<EtypeT> m_batch;
+
+  /// True if the current element is taken from the batch
+  bool m_batched;
+
   /// Temp storage for non-scalar results
 private:
   mutable typename EtypeT::SF::ValueT m_sf;
@@ -505,6 +530,12 @@ public:
     block_accumulator.neighbour_indices(m_connectivity_array[m_element_idx]);
   }
 
+  /// Connectivity table used for the blocks of the system matrix
+  const mesh::Connectivity::ArrayT& connectivity() const
+  {
+    return m_connectivity_array;
+  }
+
   /// Reference to the geometric support
   const SupportT& support() const
   {
@@ -674,8 +705,8 @@ class EtypeTVariableData<ElementBased<Dim>, SupportEtypeT, Dim, IsEquationVar>
 public:
   typedef ElementBased<Dim> EtypeT;
 
-  /// Type of returned value
-  typedef Eigen::Map< Eigen::Matrix<Real, 1, Dim> > ValueResultT;
+  /// Type of returned value, strided to support column-major fields
+  typedef Eigen::Map< Eigen::Matrix<Real, 1, Dim>, Eigen::Unaligned, Eigen::InnerStride<Eigen::Dynamic> > ValueResultT;
 
   /// Data type for the geometric support
   typedef GeometricSupport<SupportEtypeT> SupportT;
@@ -703,7 +734,7 @@ public:
 
   ValueResultT value() const
   {
-    return ValueResultT(&m_field[m_field_idx][offset]);
+    return ValueResultT(&m_field[m_field_idx][offset], Eigen::InnerStride<Eigen::Dynamic>(m_field.array().strides()[1]));
   }
 
   typedef typename SupportEtypeT::MappedCoordsT MappedCoordsT;
@@ -974,6 +1005,9 @@ public:
   static const Uint nb_lss_nodes = detail::GetNbNodes<EquationDataT>::value;
 
   ElementData(VariablesT& variables, mesh::Elements& elements) :
+    use_scatter_map(false),
+    scatter(nullptr),
+    scatter_matrix(nullptr),
     m_variables(variables),
     m_elements(elements),
     m_support(elements),
@@ -1011,6 +1045,12 @@ public:
     boost::mpl::for_each< boost::mpl::range_c<int, 0, NbVarsT::value> >(DeleteVariablesData(m_variables_data));
   }
 
+  /// Precompute the geometric data for the given elements, which must then be visited in order using set_element
+  void set_batch(const Uint* elements, const Uint nb_elements)
+  {
+    m_support.set_batch(elements, nb_elements);
+  }
+
   /// Update element index
   void set_element(const Uint element_idx)
   {
@@ -1028,6 +1068,18 @@ public:
     indices_converted = false;
   }
 
+  /// Index of the current element
+  Uint element_idx() const
+  {
+    return m_element_idx;
+  }
+
+  /// Connectivity table that determines the nodes of the block accumulator
+  const mesh::Connectivity::ArrayT& block_connectivity() const
+  {
+    return boost::fusion::front(m_equation_data)->connectivity();
+  }
+
   void update_blocks(boost::mpl::true_)
   {
   }
@@ -1125,6 +1177,12 @@ public:
   mutable math::LSS::BlockAccumulator block_accumulator;
   mutable bool indices_converted; // Indicate if the indices in the block accumulator have been converted to LSS indices
 
+  /// Add system matrix blocks through the persistent scatter map of the matrix, if it offers one
+  bool use_scatter_map;
+  /// Scatter data for the matrix in scatter_matrix, resolved on first use
+  mutable const ElementScatterMap::Entry* scatter;
+  mutable const math::LSS::Matrix* scatter_matrix;
+
 private:
   /// Variables used in the expression
   VariablesT& m_variables;
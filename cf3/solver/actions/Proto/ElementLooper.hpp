@@ -16,6 +16,15 @@
 #include <boost/mpl/for_each.hpp>
 #include <boost/mpl/filter_view.hpp>
 
+#include <boost/exception_ptr.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "common/ThreadPool.hpp"
+#include "common/Trace.hpp"
+
+#include "ElementColoring.hpp"
 #include "ElementData.hpp"
 #include "ElementExpressionWrapper.hpp"
 #include "ElementGrammar.hpp"
@@ -61,7 +70,7 @@ struct CheckSameEtype
 template<typename ElementTypesT, typename ExprT, typename SupportETYPE, typename VariablesT, typename VariablesEtypesT, typename NbVarsT, typename VarIdxT>
 struct ExpressionRunner
 {
-  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems) : variables(vars), expression(expr), elements(elems), m_nb_tests(0), m_found(false) {}
+  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems, const LoopSettings& loop_settings) : variables(vars), expression(expr), elements(elems), settings(loop_settings), m_nb_tests(0), m_found(false) {}
 
   typedef typename boost::remove_reference<typename boost::fusion::result_of::at<VariablesT, VarIdxT>::type>::type VarT;
 
@@ -90,7 +99,7 @@ struct ExpressionRunner
       NewVariablesEtypesT,
       NbVarsT,
       NextIdxT
-    >(variables, expression, elements).run();
+    >(variables, expression, elements, settings).run();
   }
 
   // Chosen otherwise
@@ -142,12 +151,13 @@ struct ExpressionRunner
       NewVariablesEtypesT,
       NbVarsT,
       NextIdxT
-    >(variables, expression, elements).run();
+    >(variables, expression, elements, settings).run();
   }
 
   VariablesT& variables;
   const ExprT& expression;
   mesh::Elements& elements;
+  const LoopSettings& settings;
   // Number of times we tried a shape function
   mutable Uint m_nb_tests;
   mutable bool m_found;
@@ -160,32 +170,136 @@ template<typename DataT>
 struct ElementLooperImpl
 {
   template<typename ExprT>
-  void operator()(const ExprT& expr, DataT& data, const Uint nb_elems) const
+  void operator()(const ExprT& expr, DataT& data, const Uint nb_elems, const bool batched = false) const
   {
     const typename DataT::SupportShapeFunction::MappedCoordsT mapped_coords; // needed to deduce proper return type when wrapping
-    run(WrapExpression()(expr, mapped_coords, data), data, nb_elems);
+    run(WrapExpression()(expr, mapped_coords, data), data, nb_elems, batched);
+  }
+
+  /// Run the expression over all elements, using the supplied settings to choose between the serial and the colored loop
+  template<typename ExprT, typename VariablesT>
+  void operator()(const ExprT& expr, VariablesT& variables, mesh::Elements& elements, const LoopSettings& settings) const
+  {
+    common::TraceRegion trace("Proto element loop", "proto");
+    if(!settings.is_colored())
+    {
+      DataT data(variables, elements);
+      data.use_scatter_map = settings.element_scatter_map;
+      (*this)(expr, data, elements.size(), settings.element_batching);
+      return;
+    }
+
+    const ElementColoring& coloring = element_coloring(elements);
+    const Uint nb_threads = std::max(settings.nb_threads, 1u);
+
+    // Each thread gets its own data. These are constructed and destroyed here, since that may involve
+    // registering fields for synchronization and collective communication
+    boost::ptr_vector<DataT> thread_data;
+    for(Uint i = 0; i != nb_threads; ++i)
+    {
+      thread_data.push_back(new DataT(variables, elements));
+      thread_data.back().use_scatter_map = settings.element_scatter_map;
+    }
+
+    ColoredLoop<ExprT> loop(expr, thread_data, coloring, settings.element_batching);
+    common::ThreadPool::instance().run(nb_threads, boost::ref(loop));
+    if(loop.exception)
+      boost::rethrow_exception(loop.exception);
   }
 
 private:
   template<typename FilteredExprT>
-  void run(const FilteredExprT& expr, DataT& data, const Uint nb_elems) const
+  void run(const FilteredExprT& expr, DataT& data, const Uint nb_elems, const bool batched) const
   {
     ElementGrammar grammar;
+    Uint batch[CF3_PROTO_ELEMENT_BATCH_SIZE];
     for(Uint elem = 0; elem != nb_elems; ++elem)
     {
+      // Prepare the geometric data of the next elements in one go
+      if(batched && elem % CF3_PROTO_ELEMENT_BATCH_SIZE == 0)
+      {
+        const Uint batch_size = std::min(nb_elems - elem, static_cast<Uint>(CF3_PROTO_ELEMENT_BATCH_SIZE));
+        for(Uint i = 0; i != batch_size; ++i)
+          batch[i] = elem + i;
+        data.set_batch(batch, batch_size);
+      }
       // Update the data for the element
       data.set_element(elem);
       // Run the expression using a proto transform, passing as arguments in the standard proto sense: the expression, a state and the data
       grammar(expr, elem, data);
     }
   }
+
+  /// Executes the colors one by one, dividing the elements of each color over the threads. Since elements of the same color
+  /// share no nodes, every matrix row and nodal value receives its contributions in color order, whatever the number of threads.
+  template<typename ExprT>
+  struct ColoredLoop
+  {
+    ColoredLoop(const ExprT& e, boost::ptr_vector<DataT>& d, const ElementColoring& c, const bool b) : expr(e), data(d), coloring(c), batched(b), failed(false)
+    {
+    }
+
+    void operator()(const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier)
+    {
+      common::TraceRegion trace("Proto element loop thread", "proto");
+      DataT& my_data = data[thread_idx];
+      const typename DataT::SupportShapeFunction::MappedCoordsT mapped_coords;
+      // The wrapped expression stores intermediate results, so each thread needs its own copy
+      run(WrapExpression()(expr, mapped_coords, my_data), my_data, thread_idx, nb_threads, barrier);
+    }
+
+    template<typename FilteredExprT>
+    void run(const FilteredExprT& wrapped_expr, DataT& my_data, const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier)
+    {
+      ElementGrammar grammar;
+      const std::vector<Uint>& elements = coloring.elements();
+      const Uint nb_colors = coloring.nb_colors();
+      for(Uint color = 0; color != nb_colors; ++color)
+      {
+        if(!failed)
+        {
+          try
+          {
+            const Uint color_begin = coloring.color_begin(color);
+            Uint chunk_begin, chunk_end;
+            common::ThreadPool::static_chunk(coloring.color_end(color) - color_begin, thread_idx, nb_threads, chunk_begin, chunk_end);
+            for(Uint i = color_begin + chunk_begin; i != color_begin + chunk_end; ++i)
+            {
+              if(batched && (i - color_begin - chunk_begin) % CF3_PROTO_ELEMENT_BATCH_SIZE == 0)
+                my_data.set_batch(&elements[i], std::min(color_begin + chunk_end - i, static_cast<Uint>(CF3_PROTO_ELEMENT_BATCH_SIZE)));
+              const Uint elem = elements[i];
+              my_data.set_element(elem);
+              grammar(wrapped_expr, elem, my_data);
+            }
+          }
+          catch(...)
+          {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            if(!exception)
+              exception = boost::current_exception();
+            failed = true;
+          }
+        }
+        // All threads must pass the barrier for every color, even after an error
+        barrier.wait();
+      }
+    }
+
+    const ExprT& expr;
+    boost::ptr_vector<DataT>& data;
+    const ElementColoring& coloring;
+    const bool batched;
+    boost::mutex mutex;
+    boost::exception_ptr exception;
+    volatile bool failed;
+  };
 };
 
 /// When we recursed to the last variable, actually run the expression
 template<typename ElementTypesT, typename ExprT, typename SupportETYPE, typename VariablesT, typename VariablesEtypesT, typename NbVarsT>
 struct ExpressionRunner<ElementTypesT, ExprT, SupportETYPE, VariablesT, VariablesEtypesT, NbVarsT, NbVarsT>
 {
-  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems) : variables(vars), expression(expr), elements(elems) {}
+  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems, const LoopSettings& loop_settings) : variables(vars), expression(expr), elements(elems), settings(loop_settings) {}
 
   typedef ElementData<VariablesT, VariablesEtypesT, SupportETYPE, typename EquationVariables<ExprT, NbVarsT>::type> DataT;
 
@@ -197,15 +311,14 @@ struct ExpressionRunner<ElementTypesT, ExprT, SupportETYPE, VariablesT, Variable
       INVALID_ELEMENT_EXPRESSION,
       (ElementGrammar));
 
-    DataT data(variables, elements);
-
-    ElementLooperImpl<DataT>()(expression, data, elements.size());
+    ElementLooperImpl<DataT>()(expression, variables, elements, settings);
   }
 
 private:
   VariablesT& variables;
   const ExprT& expression;
   mesh::Elements& elements;
+  const LoopSettings& settings;
 };
 
 /// mpl::for_each compatible functor to loop over elements, using the correct shape function for the geometry
@@ -216,10 +329,11 @@ struct ElementLooper
   // Type of a fusion vector that can contain a copy of each variable that is used in the expression
   typedef typename ExpressionProperties<ExprT>::VariablesT VariablesT;
 
-  ElementLooper(mesh::Elements& elements, const ExprT& expr, VariablesT& variables) :
+  ElementLooper(mesh::Elements& elements, const ExprT& expr, VariablesT& variables, const LoopSettings& settings = LoopSettings()) :
     m_elements(elements),
     m_expr(expr),
-    m_variables(variables)
+    m_variables(variables),
+    m_settings(settings)
   {
   }
 
@@ -253,9 +367,7 @@ struct ElementLooper
     // Verify the types match, and throw an error if non-matching fields are found
     boost::fusion::for_each(m_variables, CheckSameEtype<ETYPE>(m_elements));
 
-    DataT data(m_variables, m_elements);
-
-    ElementLooperImpl<DataT>()(m_expr, data, m_elements.size());
+    ElementLooperImpl<DataT>()(m_expr, m_variables, m_elements, m_settings);
   }
 
   /// Static dispatch in case different ETYPE are possible
@@ -276,17 +388,19 @@ struct ElementLooper
       boost::mpl::vector0<>, // Start with an empty vector for the per-variable element types
       NbVarsT, // number of variables
       boost::mpl::int_<0> // Start index, as MPL integral constant
-    >(m_variables, m_expr, m_elements).run();
+    >(m_variables, m_expr, m_elements, m_settings).run();
   }
 
 private:
   mesh::Elements& m_elements;
   const ExprT& m_expr;
   VariablesT& m_variables;
+  const LoopSettings m_settings;
 };
 
+/// Run the expression over all elements below root_region. The settings control the use of threads.
 template<typename ElementTypesT, typename ExprT>
-void for_each_element(mesh::Region& root_region, const ExprT& expr)
+void for_each_element(mesh::Region& root_region, const ExprT& expr, const LoopSettings& settings = LoopSettings())
 {
   // Store the variables
   typedef typename ExpressionProperties<ExprT>::VariablesT VariablesT;
@@ -298,7 +412,7 @@ void for_each_element(mesh::Region& root_region, const ExprT& expr)
   BOOST_FOREACH(mesh::Elements& elements, common::find_components_recursively<mesh::Elements>(root_region))
   {
     // We skip order 0 functions in the top-call, because first the support shape function is determined, and order 0 is not allowed there
-    boost::mpl::for_each< boost::mpl::filter_view< ElementTypesT, mesh::IsMinimalOrder<1> > >( ElementLooper<ElementTypesT, ExprT>(elements, expr, vars) );
+    boost::mpl::for_each< boost::mpl::filter_view< ElementTypesT, mesh::IsMinimalOrder<1> > >( ElementLooper<ElementTypesT, ExprT>(elements, expr, vars, settings) );
   }
 };
 
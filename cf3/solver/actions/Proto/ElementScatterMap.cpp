@@ -0,0 +1,109 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <boost/thread/locks.hpp>
+
+#include "common/Log.hpp"
+
+#include "ElementScatterMap.hpp"
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+ElementScatterMap::ElementScatterMap(const std::string& name) :
+  Component(name)
+{
+}
+
+ElementScatterMap::~ElementScatterMap()
+{
+}
+
+ElementScatterMap::Entry::Entry() :
+  values(nullptr),
+  block_offsets(nullptr),
+  nb_block_entries(0)
+{
+}
+
+const ElementScatterMap::Entry* ElementScatterMap::entry(const mesh::Connectivity::ArrayT& connectivity, const common::List<int>* used_node_map)
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+
+  const Uint nb_elems = connectivity.size();
+  std::map<const mesh::Connectivity::ArrayT*, Entry>::iterator it = m_entries.find(&connectivity);
+  if(it != m_entries.end() && it->second.element_blocks.size() == nb_elems)
+    return is_null(it->second.batch) ? nullptr : &it->second;
+
+  Entry& result = m_entries[&connectivity];
+  result.batch.reset();
+  result.element_blocks.assign(nb_elems, -1);
+
+  const Uint nb_nodes = nb_elems == 0 ? 0 : connectivity.shape()[1];
+  std::vector<Uint> node_indices;
+  node_indices.reserve(nb_elems*nb_nodes);
+  int nb_blocks = 0;
+  for(Uint elem = 0; elem != nb_elems; ++elem)
+  {
+    bool in_lss = true;
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      const Uint node = connectivity[elem][i];
+      if(is_not_null(used_node_map) && (*used_node_map)[node] < 0)
+      {
+        in_lss = false;
+        break;
+      }
+    }
+    if(!in_lss)
+      continue;
+
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      const Uint node = connectivity[elem][i];
+      node_indices.push_back(is_null(used_node_map) ? node : static_cast<Uint>((*used_node_map)[node]));
+    }
+    result.element_blocks[elem] = nb_blocks++;
+  }
+
+  if(nb_blocks == 0)
+    return nullptr;
+
+  math::LSS::Matrix& matrix = dynamic_cast<math::LSS::Matrix&>(*parent());
+  boost::shared_ptr<math::LSS::BlockBatch> batch = matrix.create_batch(nb_nodes, node_indices);
+
+  // Without direct access to the values, using the batch would only add a copy
+  if(batch->values == nullptr)
+    return nullptr;
+
+  CFdebug << "Created element scatter map for " << nb_blocks << " elements in " << matrix.uri().path() << CFendl;
+  result.batch = batch;
+  result.values = batch->values;
+  result.block_offsets = &batch->offsets[0];
+  result.nb_block_entries = batch->offsets.size() / nb_blocks;
+  return &result;
+}
+
+const ElementScatterMap::Entry* element_scatter(math::LSS::Matrix& matrix, const mesh::Connectivity::ArrayT& connectivity, const common::List<int>* used_node_map)
+{
+  static boost::mutex creation_mutex;
+  Handle<ElementScatterMap> scatter_map;
+  {
+    boost::lock_guard<boost::mutex> lock(creation_mutex);
+    scatter_map = Handle<ElementScatterMap>(matrix.get_child("element_scatter_map"));
+    if(is_null(scatter_map))
+      scatter_map = matrix.create_component<ElementScatterMap>("element_scatter_map");
+  }
+
+  return scatter_map->entry(connectivity, used_node_map);
+}
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
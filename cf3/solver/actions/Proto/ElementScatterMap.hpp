@@ -0,0 +1,92 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Proto_ElementScatterMap_hpp
+#define cf3_solver_actions_Proto_ElementScatterMap_hpp
+
+#include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "common/Component.hpp"
+#include "common/List.hpp"
+
+#include "math/LSS/Matrix.hpp"
+
+#include "mesh/Connectivity.hpp"
+
+/// @file
+/// Persistent mapping from element matrices to the storage of the system matrix
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+/// Batches of element blocks created by the system matrix, one per connectivity table, so element matrices can be added
+/// at precomputed locations in the matrix storage without converting indices.
+/// The map is cached as a child of the matrix, so it is discarded when the LSS is created again.
+class ElementScatterMap : public common::Component
+{
+public:
+  ElementScatterMap(const std::string& name);
+  virtual ~ElementScatterMap();
+
+  static std::string type_name() { return "ElementScatterMap"; }
+
+  /// Scatter data for the elements of a connectivity table
+  struct Entry
+  {
+    Entry();
+
+    /// Add the element matrix of element elem_idx, in the layout of BlockAccumulator::mat, directly to the matrix values
+    void add_element_values(const Uint elem_idx, const Real* element_values) const
+    {
+      // Elements with nodes outside the LSS are skipped, as in do_assign_op_matrix
+      const int block = element_blocks[elem_idx];
+      if(block < 0)
+        return;
+
+      const int* offsets = block_offsets + block*nb_block_entries;
+      for(Uint i = 0; i != nb_block_entries; ++i)
+      {
+        if(offsets[i] >= 0)
+          values[offsets[i]] += element_values[i];
+      }
+    }
+
+    /// One block per element that has all of its nodes in the LSS
+    boost::shared_ptr<math::LSS::BlockBatch> batch;
+    /// Block in the batch for each element, or -1 if the element has nodes outside of the LSS
+    std::vector<int> element_blocks;
+    /// Value array of the matrix, copied from the batch
+    Real* values;
+    /// Offsets of the entries of the first block in the batch
+    const int* block_offsets;
+    /// Number of entries in the matrix of each block
+    Uint nb_block_entries;
+  };
+
+  /// Get the scatter data for the given connectivity, building it the first time. Returns null if the matrix does not
+  /// store its values in a single array, in which case element matrices are better added directly. Thread safe.
+  const Entry* entry(const mesh::Connectivity::ArrayT& connectivity, const common::List<int>* used_node_map);
+
+private:
+  std::map<const mesh::Connectivity::ArrayT*, Entry> m_entries;
+  boost::mutex m_mutex;
+};
+
+/// Get the scatter data for the given matrix and connectivity, see ElementScatterMap::entry. Thread safe.
+const ElementScatterMap::Entry* element_scatter(math::LSS::Matrix& matrix, const mesh::Connectivity::ArrayT& connectivity, const common::List<int>* used_node_map);
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
+
+#endif // cf3_solver_actions_Proto_ElementScatterMap_hpp
@@ -20,6 +20,7 @@
 #include "common/OptionT.hpp"
 #include "common/OptionArray.hpp"
 #include "common/OptionList.hpp"
+#include "common/Timer.hpp"
 
 #include "math/VariableManager.hpp"
 #include "math/VariablesDescriptor.hpp"
@@ -29,9 +30,12 @@
 #include "mesh/LagrangeP1/ElementTypes.hpp"
 #include "physics/PhysModel.hpp"
 
+#include "solver/actions/Rebalance.hpp"
+
 #include "ConfigurableConstant.hpp"
 #include "ElementLooper.hpp"
 #include "ElementMatrix.hpp"
+#include "LoopSettings.hpp"
 #include "NodeLooper.hpp"
 #include "NodeGrammar.hpp"
 #include "PhysicsConstant.hpp"
@@ -65,6 +69,9 @@ public:
   /// value: space library name, to indicate what kind of field is expected
   virtual void insert_field_info(std::map<std::string, std::string>& tags) const = 0;
 
+  /// Set the settings that control the execution of the loop, i.e. the number of threads
+  virtual void set_loop_settings(const LoopSettings& settings) = 0;
+
   virtual ~Expression() {}
 };
 
@@ -144,6 +151,11 @@ public:
     boost::fusion::for_each(m_variables, AppendTags(tags));
   }
 
+  void set_loop_settings(const LoopSettings& settings)
+  {
+    m_loop_settings = settings;
+  }
+
 private:
   /// Values for configurable constants
   ConstantStorage m_constant_values;
@@ -165,6 +177,9 @@ protected:
   // True for the variables that are stored
   typedef typename EquationVariables<ExprT, NbVarsT>::type EquationVariablesT;
 
+  /// Settings for the execution of the loop
+  LoopSettings m_loop_settings;
+
 private:
 
   /// Functor to register variables in a physical model
@@ -255,7 +270,10 @@ public:
     // Traverse all Elements under the region and evaluate the expression
     BOOST_FOREACH(mesh::Elements& elements, common::find_components_recursively<mesh::Elements>(region) )
     {
-      boost::mpl::for_each<boost::mpl::filter_view< ElementTypes, mesh::IsMinimalOrder<1> > >( ElementLooper<ElementTypes, typename BaseT::CopiedExprT>(elements, BaseT::m_expr, BaseT::m_variables) );
+      common::Timer timer;
+      boost::mpl::for_each<boost::mpl::filter_view< ElementTypes, mesh::IsMinimalOrder<1> > >( ElementLooper<ElementTypes, typename BaseT::CopiedExprT>(elements, BaseT::m_expr, BaseT::m_variables, BaseT::m_loop_settings) );
+      // Measured cost, used for load balancing
+      add_element_cost(elements, timer.elapsed());
     }
   }
 };
@@ -279,7 +297,7 @@ public:
       INVALID_NODE_EXPRESSION,
       (NodeGrammar));
 
-    boost::mpl::for_each< DimsT >( NodeLooper<typename BaseT::CopiedExprT>(BaseT::m_expr, region, BaseT::m_variables) );
+    boost::mpl::for_each< DimsT >( NodeLooper<typename BaseT::CopiedExprT>(BaseT::m_expr, region, BaseT::m_variables, BaseT::m_loop_settings) );
   }
 };
 
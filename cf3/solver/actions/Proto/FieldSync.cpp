@@ -32,6 +32,24 @@ void FieldSynchronizer::insert(mesh::Field& f, bool do_periodic_element_update)
 
 void FieldSynchronizer::synchronize()
 {
+  begin_synchronize();
+  end_synchronize();
+}
+
+void FieldSynchronizer::begin_synchronize()
+{
+  // A field that is still in flight must arrive before it can be modified and sent again
+  for(FieldsT::iterator field_it = m_fields.begin(); field_it != m_fields.end(); ++field_it)
+  {
+    FieldsT::iterator pending_it = m_pending_fields.find(field_it->first);
+    if(pending_it != m_pending_fields.end())
+    {
+      if(common::PE::Comm::instance().is_active())
+        pending_it->second.first->end_synchronize();
+      m_pending_fields.erase(pending_it);
+    }
+  }
+
   // Periodic update needed even in a sequential run
   for(FieldsT::iterator field_it = m_fields.begin(); field_it != m_fields.end(); ++field_it)
   {
@@ -88,13 +106,27 @@ void FieldSynchronizer::synchronize()
   {
     for(FieldsT::iterator field_it = m_fields.begin(); field_it != m_fields.end(); ++field_it)
     {
-      field_it->second.first->synchronize();
+      field_it->second.first->begin_synchronize();
     }
   }
 
+  m_pending_fields.insert(m_fields.begin(), m_fields.end());
   m_fields.clear();
 }
 
+void FieldSynchronizer::end_synchronize()
+{
+  if(common::PE::Comm::instance().is_active())
+  {
+    for(FieldsT::iterator field_it = m_pending_fields.begin(); field_it != m_pending_fields.end(); ++field_it)
+    {
+      field_it->second.first->end_synchronize();
+    }
+  }
+
+  m_pending_fields.clear();
+}
+
 } // namespace Proto
 } // namespace actions
 } // namespace solver
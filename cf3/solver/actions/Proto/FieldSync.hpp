@@ -32,6 +32,13 @@ public:
   /// Sync fields and clear the list
   void synchronize();
 
+  /// Apply the periodic updates and start the exchange of ghost values for all fields, without waiting for it to finish.
+  /// Computations that don't touch the inserted fields can run until end_synchronize is called.
+  void begin_synchronize();
+
+  /// Wait for the exchange started by begin_synchronize and clear the list
+  void end_synchronize();
+
 private:
   FieldSynchronizer();
 
@@ -39,6 +46,9 @@ private:
   // on each cpu.
   typedef std::map< std::string, std::pair<Handle<mesh::Field>, bool> > FieldsT;
   FieldsT m_fields;
+
+  // Fields for which the exchange was started
+  FieldsT m_pending_fields;
 };
 
 
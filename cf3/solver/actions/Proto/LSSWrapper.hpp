@@ -99,6 +99,12 @@ public:
     data.indices_converted = true;
   }
   
+  /// Map from mesh nodes to LSS nodes, or null if they are the same
+  const common::List<int>* used_node_map() const
+  {
+    return m_used_node_map;
+  }
+
   int node_to_lss(const Uint node)
   {
     if(is_null(m_used_node_map))
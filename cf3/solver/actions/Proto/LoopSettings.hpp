@@ -0,0 +1,52 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Proto_LoopSettings_hpp
+#define cf3_solver_actions_Proto_LoopSettings_hpp
+
+#include "common/CF.hpp"
+
+/// @file
+/// Settings for the execution of Proto loops
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+/// Settings that control how a loop over elements or nodes is executed
+struct LoopSettings
+{
+  LoopSettings(const Uint threads = 1, const bool coloring = false, const bool batching = false, const bool scatter_map = false) :
+    nb_threads(threads),
+    element_coloring(coloring),
+    element_batching(batching),
+    element_scatter_map(scatter_map)
+  {
+  }
+
+  /// True if element loops visit the elements color by color
+  bool is_colored() const
+  {
+    return element_coloring || nb_threads > 1;
+  }
+
+  /// Number of threads to use
+  Uint nb_threads;
+  /// Force element loops to run color by color, even if only one thread is used
+  bool element_coloring;
+  /// Compute the geometric data of elements with an affine mapping in batches of CF3_PROTO_ELEMENT_BATCH_SIZE elements
+  bool element_batching;
+  /// Add element matrices to the system matrix at offsets that are computed on the first assembly and kept with the matrix
+  bool element_scatter_map;
+};
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
+
+#endif // cf3_solver_actions_Proto_LoopSettings_hpp
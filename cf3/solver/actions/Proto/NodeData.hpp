@@ -7,6 +7,8 @@
 #ifndef cf3_solver_actions_Proto_NodeData_hpp
 #define cf3_solver_actions_Proto_NodeData_hpp
 
+#include <vector>
+
 #include <boost/fusion/algorithm/iteration/for_each.hpp>
 
 #include <boost/mpl/for_each.hpp>
@@ -127,8 +129,8 @@ struct NodeVarData< ScalarField >
 
   void set_node(const Uint idx)
   {
-    m_idx = idx;
-    m_value = m_field[idx][m_var_begin];
+    m_data = m_field.array().data() + idx*m_field.array().strides()[0] + m_var_begin*m_field.array().strides()[1];
+    m_value = *m_data;
   }
 
   typedef Real ValueT;
@@ -145,21 +147,21 @@ struct NodeVarData< ScalarField >
   {
     m_need_synchronization = true;
     m_value = v;
-    m_field[m_idx][m_var_begin] = m_value;
+    *m_data = m_value;
   }
 
   void set_value(boost::proto::tag::plus_assign, const Real v)
   {
     m_need_synchronization = true;
     m_value += v;
-    m_field[m_idx][m_var_begin] = m_value;
+    *m_data = m_value;
   }
 
   void set_value(boost::proto::tag::minus_assign, const Real v)
   {
     m_need_synchronization = true;
     m_value -= v;
-    m_field[m_idx][m_var_begin] = m_value;
+    *m_data = m_value;
   }
 
   /// Offset for the variable in the field
@@ -171,7 +173,8 @@ struct NodeVarData< ScalarField >
 private:
   mesh::Field& m_field;
   Uint m_var_begin;
-  Uint m_idx;
+  /// Location of the value for the current node in the field storage
+  Real* m_data;
   Real m_value;
   bool m_need_synchronization;
 };
@@ -214,9 +217,11 @@ struct NodeVarData<VectorField, Dim>
 
   void set_node(const Uint idx)
   {
-    m_idx = idx;
+    // Gather directly from the storage, so row-major and column-major fields are both supported
+    m_stride = m_field.array().strides()[1];
+    m_data = m_field.array().data() + idx*m_field.array().strides()[0] + m_var_begin*m_stride;
     for(Uint i = 0; i != Dim; ++i)
-      m_value[i] = m_field[idx][m_var_begin + i];
+      m_value[i] = m_data[i*m_stride];
   }
 
   /// Return a reference to the stored value
@@ -232,7 +237,7 @@ struct NodeVarData<VectorField, Dim>
     m_need_synchronization = true;
     m_value = v;
     for(Uint i = 0; i != Dim; ++i)
-      m_field[m_idx][m_var_begin + i] = v[i];
+      m_data[i*m_stride] = v[i];
   }
 
   template<typename VectorT>
@@ -241,7 +246,7 @@ struct NodeVarData<VectorField, Dim>
     m_need_synchronization = true;
     m_value += v;
     for(Uint i = 0; i != Dim; ++i)
-      m_field[m_idx][m_var_begin + i] += v[i];
+      m_data[i*m_stride] += v[i];
   }
 
   template<typename VectorT>
@@ -250,28 +255,28 @@ struct NodeVarData<VectorField, Dim>
     m_need_synchronization = true;
     m_value -= v;
     for(Uint i = 0; i != Dim; ++i)
-      m_field[m_idx][m_var_begin + i] -= v[i];
+      m_data[i*m_stride] -= v[i];
   }
 
   void set_value_component(boost::proto::tag::assign, const Real& v, const Uint i)
   {
     m_need_synchronization = true;
     m_value[i] = v;
-    m_field[m_idx][m_var_begin + i] = v;
+    m_data[i*m_stride] = v;
   }
 
   void set_value_component(boost::proto::tag::plus_assign, const Real& v, const Uint i)
   {
     m_need_synchronization = true;
     m_value[i] += v;
-    m_field[m_idx][m_var_begin + i] += v;
+    m_data[i*m_stride] += v;
   }
 
   void set_value_component(boost::proto::tag::minus_assign, const Real& v, const Uint i)
   {
     m_need_synchronization = true;
     m_value[i] -= v;
-    m_field[m_idx][m_var_begin + i] -= v;
+    m_data[i*m_stride] -= v;
   }
 
   /// Offset for the variable in the field
@@ -284,7 +289,10 @@ private:
   mesh::Field& m_field;
   Uint m_var_begin;
   ValueT m_value;
-  Uint m_idx;
+  /// Location of the first component for the current node in the field storage
+  Real* m_data;
+  /// Distance between the components in the field storage
+  std::ptrdiff_t m_stride;
   bool m_need_synchronization;
 };
 
@@ -384,7 +392,44 @@ public:
     return m_position;
   }
 
+  /// Combine value into the partial result of the reduction to result, using op
+  void reduce(Real* result, Real (*op)(const Real, const Real), const Real value)
+  {
+    const Uint nb_reductions = m_reductions.size();
+    for(Uint i = 0; i != nb_reductions; ++i)
+    {
+      if(m_reductions[i].result == result)
+      {
+        m_reductions[i].value = op(m_reductions[i].value, value);
+        return;
+      }
+    }
+    m_reductions.push_back(PartialReduction(result, op, value));
+  }
+
+  /// Combine the partial results of the reductions into their final results, which must be called after the loop
+  void finish_reductions()
+  {
+    BOOST_FOREACH(const PartialReduction& reduction, m_reductions)
+    {
+      *reduction.result = reduction.op(*reduction.result, reduction.value);
+    }
+    m_reductions.clear();
+  }
+
 private:
+  /// Reduction result for the nodes visited using this data
+  struct PartialReduction
+  {
+    PartialReduction(Real* r, Real (*o)(const Real, const Real), const Real v) : result(r), op(o), value(v)
+    {
+    }
+
+    Real* result;
+    Real (*op)(const Real, const Real);
+    Real value;
+  };
+
   /// Variables used in the expression
   VariablesT& m_variables;
 
@@ -400,6 +445,9 @@ private:
   /// Current coordinates
   mutable CoordsT m_position;
 
+  /// Partial results of the reductions in the expression
+  std::vector<PartialReduction> m_reductions;
+
   ///////////// helper functions and structs /////////////
 private:
   /// Initializes the pointers in a VariablesDataT fusion sequence
@@ -16,6 +16,7 @@
 #include "SetSolution.hpp"
 #include "NodalMatrixManipulation.hpp"
 #include "NodeData.hpp"
+#include "NodeReduction.hpp"
 #include "RHSVector.hpp"
 #include "SolutionVector.hpp"
 #include "Transforms.hpp"
@@ -229,6 +230,7 @@ struct SingleExprNodeGrammar :
     SetRHSGrammar<NodeMath>,
     ZeroLSSRowGrammar,
     SetSolutionGrammar<NodeMath>,
+    NodeReductionGrammar<NodeMath>,
     boost::proto::when
     <
       NodeMath,
@@ -7,9 +7,18 @@
 #ifndef cf3_solver_actions_Proto_NodeLooper_hpp
 #define cf3_solver_actions_Proto_NodeLooper_hpp
 
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/max.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/barrier.hpp>
+
+#include "common/ThreadPool.hpp"
+#include "common/Trace.hpp"
+
 #include "mesh/Functions.hpp"
 
 #include "FieldSync.hpp"
+#include "LoopSettings.hpp"
 #include "NodeData.hpp"
 #include "NodeGrammar.hpp"
 
@@ -31,6 +40,52 @@ struct WrappableNodeExpressions :
 {
 };
 
+/// Matches the linear system terminals that a node loop can write to. Writing to the linear system is not thread safe.
+struct LSSWriteTerminals :
+  boost::proto::or_
+  <
+    boost::proto::terminal< LSSWrapperImpl<SystemMatrixTag> >,
+    boost::proto::terminal< LSSWrapperImpl<SystemRHSTag> >,
+    boost::proto::terminal< LSSWrapperImpl<DirichletBCTag> >
+  >
+{
+};
+
+/// Evaluates to true if the expression contains one of the LSSWriteTerminals
+struct HasLSSWriteTerminal :
+  boost::proto::or_
+  <
+    boost::proto::when
+    <
+      LSSWriteTerminals,
+      boost::mpl::true_()
+    >,
+    boost::proto::when
+    <
+      boost::proto::terminal< boost::proto::_ >,
+      boost::mpl::false_()
+    >,
+    boost::proto::when
+    <
+      boost::proto::nary_expr<boost::proto::_, boost::proto::vararg<boost::proto::_> >,
+      boost::proto::fold< boost::proto::_, boost::mpl::false_(), boost::mpl::max< boost::proto::_state, boost::proto::call<HasLSSWriteTerminal> >() >
+    >
+  >
+{
+};
+
+/// True if a node loop over the expression modifies a linear system, in which case it always runs on a single thread
+template<typename ExprT>
+struct ModifiesLSS :
+  boost::mpl::bool_<boost::tr1_result_of<HasLSSWriteTerminal(ExprT)>::type::value>
+{
+};
+
+/// Number of consecutive nodes that make up a chunk in threaded node loops, i.e. a cache line of 64 bytes of Real values
+#ifndef CF3_PROTO_NODE_CHUNK_ALIGNMENT
+  #define CF3_PROTO_NODE_CHUNK_ALIGNMENT 8
+#endif
+
 /// Loop over nodes, when the dimension is known
 template<typename ExprT, typename NbDimsT>
 struct NodeLooperDim
@@ -40,10 +95,11 @@ struct NodeLooperDim
 
   typedef NodeData<VariablesT, NbDimsT> DataT;
 
-  NodeLooperDim(const ExprT& expr, mesh::Region& region, VariablesT& variables) :
+  NodeLooperDim(const ExprT& expr, mesh::Region& region, VariablesT& variables, const LoopSettings& settings = LoopSettings()) :
     m_expr(expr),
     m_region(region),
-    m_variables(variables)
+    m_variables(variables),
+    m_settings(settings)
   {
   }
 
@@ -129,6 +185,8 @@ struct NodeLooperDim
 
   void operator()() const
   {
+    common::TraceRegion trace("Proto node loop", "proto");
+
     // Create data used for the evaluation
     mesh::Mesh& mesh = common::find_parent_component<mesh::Mesh>(m_region);
     Handle<mesh::Dictionary const> dict;
@@ -136,36 +194,78 @@ struct NodeLooperDim
     if(is_null(dict))
       dict = mesh.geometry_fields().handle<mesh::Dictionary>(); // fall back to the geometry if the dict is not found by tag
 
+    // Build a list of used entities
+    std::vector< Handle<mesh::Entities const> > used_entities;
+    BOOST_FOREACH(const mesh::Entities& entities, common::find_components_recursively<mesh::Entities>(m_region))
+    {
+      used_entities.push_back(entities.handle<mesh::Entities>());
+    }
+
+    boost::shared_ptr< common::List<Uint> > used_nodes_ptr = mesh::build_used_nodes_list(used_entities, *dict, false);
+    const common::List<Uint>& nodes = *used_nodes_ptr;
+
     const mesh::Field& coordinates = dict->coordinates();
-    DataT node_data(m_variables, m_region, coordinates, m_expr);
+    // Node loops that write to a linear system are never threaded
+    const Uint nb_threads = ModifiesLSS<ExprT>::value ? 1u : std::max(m_settings.nb_threads, 1u);
+    if(nb_threads == 1)
+    {
+      DataT node_data(m_variables, m_region, coordinates, m_expr);
+
+      // Wrap things up so that we can store the intermediate product results
+      run(WrapExpression()(m_expr, 0, node_data), node_data, nodes, 0, nodes.size());
+      node_data.finish_reductions();
+      return;
+    }
 
-    // Wrap things up so that we can store the intermediate product results
-    do_run(WrapExpression()(m_expr, 0, node_data), node_data, *dict);
+    // Each thread gets its own data. These are constructed and destroyed here, since that may involve
+    // registering fields for synchronization and collective communication
+    boost::ptr_vector<DataT> thread_data;
+    for(Uint i = 0; i != nb_threads; ++i)
+      thread_data.push_back(new DataT(m_variables, m_region, coordinates, m_expr));
+
+    common::ThreadPool::instance().run(nb_threads, ThreadedLoop(m_expr, thread_data, nodes));
+
+    // Partial reductions are combined in thread order, so the result only depends on the number of threads
+    BOOST_FOREACH(DataT& node_data, thread_data)
+    {
+      node_data.finish_reductions();
+    }
   }
 
 private:
   template<typename FilteredExprT>
-  void do_run(const FilteredExprT& expr, DataT& data, const mesh::Dictionary& dict) const
+  static void run(const FilteredExprT& expr, DataT& data, const common::List<Uint>& nodes, const Uint begin, const Uint end)
   {
     NodeGrammar grammar;
-
-    // Build a list of used entities
-    std::vector< Handle<mesh::Entities const> > used_entities;
-    BOOST_FOREACH(const mesh::Entities& entities, common::find_components_recursively<mesh::Entities>(m_region))
+    for(Uint i = begin; i != end; ++i)
     {
-      used_entities.push_back(entities.handle<mesh::Entities>());
+      data.set_node(nodes[i]);
+      grammar(expr, 0, data); // The "0" is the proto state, which is unused at the top-level expression
     }
+  }
 
-    boost::shared_ptr< common::List<Uint> > used_nodes_ptr = mesh::build_used_nodes_list(used_entities, dict, false);
+  /// Divides the list of nodes in contiguous chunks, one for each thread. Each node is visited by exactly one thread, so
+  /// expressions that only modify the current node are safe, but accumulating into a shared value must use a reduction.
+  struct ThreadedLoop
+  {
+    ThreadedLoop(const ExprT& e, boost::ptr_vector<DataT>& d, const common::List<Uint>& n) : expr(e), data(d), nodes(n)
+    {
+    }
 
-    const common::List<Uint>& nodes = *used_nodes_ptr;
-    const Uint nb_nodes = nodes.size();
-    for(Uint i = 0; i != nb_nodes; ++i)
+    void operator()(const Uint thread_idx, const Uint nb_threads, boost::barrier&) const
     {
-      data.set_node(nodes[i]);
-      grammar(expr, 0, data); // The "0" is the proto state, which is unused at the top-level expression
+      common::TraceRegion trace("Proto node loop thread", "proto");
+      DataT& my_data = data[thread_idx];
+      Uint begin, end;
+      common::ThreadPool::static_chunk(nodes.size(), thread_idx, nb_threads, begin, end, CF3_PROTO_NODE_CHUNK_ALIGNMENT);
+      // The wrapped expression stores intermediate results, so each thread needs its own copy
+      run(WrapExpression()(expr, 0, my_data), my_data, nodes, begin, end);
     }
-  }
+
+    const ExprT& expr;
+    boost::ptr_vector<DataT>& data;
+    const common::List<Uint>& nodes;
+  };
 
   struct FindDict
   {
@@ -197,6 +297,7 @@ private:
   const ExprT& m_expr;
   mesh::Region& m_region;
   VariablesT& m_variables;
+  const LoopSettings m_settings;
 };
 
 /// Loop over nodes, using static-sized vectors to store coordinates
@@ -206,10 +307,11 @@ struct NodeLooper
   /// Type of a fusion vector that can contain a copy of each variable that is used in the expression
   typedef typename ExpressionProperties<ExprT>::VariablesT VariablesT;
 
-  NodeLooper(const ExprT& expr, mesh::Region& region, VariablesT& variables) :
+  NodeLooper(const ExprT& expr, mesh::Region& region, VariablesT& variables, const LoopSettings& settings = LoopSettings()) :
     m_expr(expr),
     m_region(region),
-    m_variables(variables)
+    m_variables(variables),
+    m_settings(settings)
   {
   }
 
@@ -223,7 +325,7 @@ struct NodeLooper
       return;
 
     // Execute with known dimension
-    NodeLooperDim<ExprT, NbDimsT>(m_expr, m_region, m_variables)();
+    NodeLooperDim<ExprT, NbDimsT>(m_expr, m_region, m_variables, m_settings)();
 
     FieldSynchronizer::instance().synchronize();
   }
@@ -233,10 +335,11 @@ private:
   const ExprT& m_expr;
   mesh::Region& m_region;
   VariablesT& m_variables;
+  const LoopSettings m_settings;
 };
 
 template<Uint dim, typename ExprT>
-void for_each_node(mesh::Region& root_region, const ExprT& expr)
+void for_each_node(mesh::Region& root_region, const ExprT& expr, const LoopSettings& settings = LoopSettings())
 {
   // IF COMPILATION FAILS HERE: the expression passed is invalid
   BOOST_MPL_ASSERT_MSG(
@@ -250,18 +353,19 @@ void for_each_node(mesh::Region& root_region, const ExprT& expr)
   CopyNumberedVars<VariablesT> ctx(vars);
   boost::proto::eval(expr, ctx);
 
-  NodeLooper<ExprT>(expr, root_region, vars)(boost::mpl::int_<dim>());
+  NodeLooper<ExprT>(expr, root_region, vars, settings)(boost::mpl::int_<dim>());
 }
 
 /// Visit all nodes used by root_region exactly once, executing expr
 /// @param variable_names Name of each of the variables, in case a linear system is solved
 /// @param variable_sizes Size (number of scalars) that makes up each variable in the linear system, if any
+/// @param settings Loop settings. With more than one thread, the nodes are divided over the threads in contiguous chunks
 template<typename ExprT>
-void for_each_node(mesh::Region& root_region, const ExprT& expr)
+void for_each_node(mesh::Region& root_region, const ExprT& expr, const LoopSettings& settings = LoopSettings())
 {
-  for_each_node<1>(root_region, expr);
-  for_each_node<2>(root_region, expr);
-  for_each_node<3>(root_region, expr);
+  for_each_node<1>(root_region, expr, settings);
+  for_each_node<2>(root_region, expr, settings);
+  for_each_node<3>(root_region, expr, settings);
 }
 
 
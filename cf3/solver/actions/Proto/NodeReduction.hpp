@@ -0,0 +1,112 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Proto_NodeReduction_hpp
+#define cf3_solver_actions_Proto_NodeReduction_hpp
+
+#include <algorithm>
+
+#include <boost/proto/core.hpp>
+
+#include "common/CF.hpp"
+
+/// @file
+/// Reductions of nodal values to a single value, usable in threaded node loops
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+/// Sum of the reduced values
+struct SumReduction
+{
+  static Real apply(const Real a, const Real b)
+  {
+    return a + b;
+  }
+};
+
+/// Maximum of the reduced values
+struct MaxReduction
+{
+  static Real apply(const Real a, const Real b)
+  {
+    return std::max(a, b);
+  }
+};
+
+/// Minimum of the reduced values
+struct MinReduction
+{
+  static Real apply(const Real a, const Real b)
+  {
+    return std::min(a, b);
+  }
+};
+
+/// Terminal value referring to the result of a reduction
+template<typename OpT>
+struct NodeReduction
+{
+  explicit NodeReduction(Real& r) : result(&r)
+  {
+  }
+
+  Real* result;
+};
+
+/// Sum the nodal values in result, i.e. nodal_sum(result) += value adds value for every node to the initial value of result.
+/// Unlike accumulating in a literal, this also works when the loop uses several threads. The result is local to the process.
+inline boost::proto::terminal< NodeReduction<SumReduction> >::type nodal_sum(Real& result)
+{
+  boost::proto::terminal< NodeReduction<SumReduction> >::type t = {NodeReduction<SumReduction>(result)};
+  return t;
+}
+
+/// Maximum of the nodal values and the initial value of result, i.e. nodal_max(result) += value
+inline boost::proto::terminal< NodeReduction<MaxReduction> >::type nodal_max(Real& result)
+{
+  boost::proto::terminal< NodeReduction<MaxReduction> >::type t = {NodeReduction<MaxReduction>(result)};
+  return t;
+}
+
+/// Minimum of the nodal values and the initial value of result, i.e. nodal_min(result) += value
+inline boost::proto::terminal< NodeReduction<MinReduction> >::type nodal_min(Real& result)
+{
+  boost::proto::terminal< NodeReduction<MinReduction> >::type t = {NodeReduction<MinReduction>(result)};
+  return t;
+}
+
+/// Combines a value into the partial result that the node data keeps for the reduction
+struct ReduceNodeValue : boost::proto::callable
+{
+  typedef void result_type;
+
+  template<typename OpT, typename DataT>
+  void operator()(const NodeReduction<OpT>& reduction, const Real value, DataT& data) const
+  {
+    data.reduce(reduction.result, &OpT::apply, value);
+  }
+};
+
+/// Grammar for reduction expressions, of the form nodal_sum(result) += value
+template<typename GrammarT>
+struct NodeReductionGrammar :
+  boost::proto::when
+  <
+    boost::proto::plus_assign< boost::proto::terminal< NodeReduction<boost::proto::_> >, GrammarT >,
+    ReduceNodeValue(boost::proto::_value(boost::proto::_left), GrammarT(boost::proto::_right), boost::proto::_data)
+  >
+{
+};
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
+
+#endif // cf3_solver_actions_Proto_NodeReduction_hpp
@@ -40,6 +40,45 @@ struct ProtoAction::Implementation
     m_physical_model(physical_model)
   {
     m_component.options().option(Tags::physical_model()).attach_trigger(boost::bind(&Implementation::trigger_physical_model, this));
+
+    m_component.options().add("nb_threads", m_loop_settings.nb_threads)
+      .pretty_name("Number of Threads")
+      .description("Number of threads used to run the loop. Element loops with more than one thread run color by color, "
+                   "so no two threads write to the same node. Node loops divide the nodes over the threads in contiguous chunks. "
+                   "Expressions that accumulate into shared values, such as literals, must use a single thread, but node loops "
+                   "can use nodal_sum, nodal_max and nodal_min instead. Node loops that modify a linear system always run on a single thread.")
+      .link_to(&m_loop_settings.nb_threads)
+      .attach_trigger(boost::bind(&Implementation::trigger_loop_settings, this));
+
+    m_component.options().add("element_coloring", m_loop_settings.element_coloring)
+      .pretty_name("Element Coloring")
+      .description("Run element loops color by color, even when a single thread is used. The assembled result is then identical for any number of threads.")
+      .link_to(&m_loop_settings.element_coloring)
+      .attach_trigger(boost::bind(&Implementation::trigger_loop_settings, this));
+
+    m_component.options().add("element_batching", m_loop_settings.element_batching)
+      .pretty_name("Element Batching")
+      .description("Compute the Jacobians of linear triangles and tetrahedra for a batch of elements at once, "
+                   "using vectorized loops across the elements of the batch.")
+      .link_to(&m_loop_settings.element_batching)
+      .attach_trigger(boost::bind(&Implementation::trigger_loop_settings, this));
+
+    m_component.options().add("element_scatter_map", m_loop_settings.element_scatter_map)
+      .pretty_name("Element Scatter Map")
+      .description("Add element matrices to the system matrix at locations computed during the first assembly, "
+                   "skipping the index conversion afterwards. The locations are kept until the LSS is created again "
+                   "and take one integer per element matrix entry.")
+      .link_to(&m_loop_settings.element_scatter_map)
+      .attach_trigger(boost::bind(&Implementation::trigger_loop_settings, this));
+  }
+
+  void trigger_loop_settings()
+  {
+    if(m_loop_settings.nb_threads == 0)
+      throw common::BadValue(FromHere(), "Number of threads for " + m_component.uri().path() + " must be at least 1");
+
+    if(m_expression)
+      m_expression->set_loop_settings(m_loop_settings);
   }
 
   void trigger_physical_model()
@@ -62,6 +101,8 @@ struct ProtoAction::Implementation
   boost::shared_ptr< Expression > m_expression;
   Component& m_component;
 
+  LoopSettings m_loop_settings;
+
   const Handle<PhysModel>& m_physical_model;
 
   struct PhysicsConstantLink
@@ -130,6 +171,7 @@ void ProtoAction::execute()
 void ProtoAction::set_expression(const boost::shared_ptr< Expression >& expression)
 {
   m_implementation->m_expression = expression;
+  expression->set_loop_settings(m_implementation->m_loop_settings);
   expression->add_options(options());
   m_implementation->trigger_physical_model();
 }
@@ -5,12 +5,14 @@
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
 #include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/function.hpp>
 
 #include "common/Builder.hpp"
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
 #include "common/BinaryDataReader.hpp"
+#include "common/PE/ParallelFile.hpp"
 
 #include "common/XML/FileOperations.hpp"
 
@@ -88,9 +90,17 @@ void ReadRestartFile::execute()
     time->options().set("iteration", common::from_str<Uint>(restart_node.attribute_value("iteration")));
   }
 
-  if(common::from_str<Uint>(restart_node.attribute_value("version")) != 1)
+  const Uint version = common::from_str<Uint>(restart_node.attribute_value("version"));
+  if(version == 1)
+    read_per_rank_data(*mesh, restart_node, filepath);
+  else if(version == 2)
+    read_global_data(*mesh, restart_node);
+  else
     throw common::FileFormatError(FromHere(), "File  " + filepath.path() + " has unsupported version");
+}
 
+void ReadRestartFile::read_per_rank_data(mesh::Mesh& mesh, common::XML::XmlNode& restart_node, const common::URI& filepath)
+{
   common::PE::Comm& comm = common::PE::Comm::instance();
   if(common::from_str<Uint>(restart_node.attribute_value("nb_procs")) != comm.size())
     throw common::SetupError(FromHere(), "File  " + filepath.path() + " was made for " + restart_node.attribute_value("nb_procs") + " CPUs, but we are loading on " + common::to_str(comm.size()) + " CPUs");
@@ -101,14 +111,58 @@ void ReadRestartFile::execute()
   common::XML::XmlNode field_node = restart_node.content->first_node("field");
   for(; field_node.is_valid(); field_node.content = field_node.content->next_sibling("field"))
   {
-    Handle<mesh::Field> field(mesh->access_component(common::URI(field_node.attribute_value("path"), common::URI::Scheme::CPATH)));
-    if(is_null(field))
-      throw common::SetupError(FromHere(), "Field " + field_node.attribute_value("path") + " was not found in mesh " + mesh->uri().path());
+    data_reader->read_table(find_field(mesh, field_node), common::from_str<Uint>(field_node.attribute_value("index")));
+  }
+}
+
+void ReadRestartFile::read_global_data(mesh::Mesh& mesh, common::XML::XmlNode& restart_node)
+{
+  common::PE::ParallelFile data_file(restart_node.attribute_value("binary_file"), common::PE::ParallelFile::READ);
 
-    data_reader->read_table(*field, common::from_str<Uint>(field_node.attribute_value("index")));
+  common::XML::XmlNode field_node = restart_node.content->first_node("field");
+  for(; field_node.is_valid(); field_node.content = field_node.content->next_sibling("field"))
+  {
+    mesh::Field& field = find_field(mesh, field_node);
+    const common::List<Uint>& glb_idx = field.dict().glb_idx();
+    const Uint nb_global_rows = common::from_str<Uint>(field_node.attribute_value("nb_rows"));
+    const Uint row_size = common::from_str<Uint>(field_node.attribute_value("nb_cols"));
+
+    if(row_size != field.row_size())
+      throw common::SetupError(FromHere(), "Field " + field.uri().path() + " has row size " + common::to_str(field.row_size()) + ", but the restart file has " + common::to_str(row_size));
+    if(glb_idx.size() != field.size())
+      throw common::SetupError(FromHere(), "Global indices of dictionary " + field.dict().uri().path() + " are not set for field " + field.uri().path());
+
+    // Every process reads the rows it holds, ghosts included, using the global index
+    const std::vector<Uint> row_indices(glb_idx.array().begin(), glb_idx.array().end());
+    BOOST_FOREACH(const Uint gid, row_indices)
+    {
+      if(gid >= nb_global_rows)
+        throw common::SetupError(FromHere(), "Global index " + common::to_str(gid) + " of field " + field.uri().path() + " is not in the restart file, which has " + common::to_str(nb_global_rows) + " rows");
+    }
+
+    const boost::uint64_t begin = common::from_str<boost::uint64_t>(field_node.attribute_value("begin"));
+    if(field.is_column_major())
+    {
+      // The file stores the rows contiguously, so go through a row-major copy
+      mesh::Field::ArrayT rows(boost::extents[field.size()][row_size]);
+      data_file.read_rows(begin, reinterpret_cast<char*>(rows.data()), row_indices, row_size*sizeof(Real));
+      field.array() = rows;
+    }
+    else
+    {
+      data_file.read_rows(begin, reinterpret_cast<char*>(field.array().data()), row_indices, row_size*sizeof(Real));
+    }
   }
 }
 
+mesh::Field& ReadRestartFile::find_field(mesh::Mesh& mesh, common::XML::XmlNode& field_node)
+{
+  Handle<mesh::Field> field(mesh.access_component(common::URI(field_node.attribute_value("path"), common::URI::Scheme::CPATH)));
+  if(is_null(field))
+    throw common::SetupError(FromHere(), "Field " + field_node.attribute_value("path") + " was not found in mesh " + mesh.uri().path());
+  return *field;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 } // actions
@@ -13,12 +13,16 @@
 /////////////////////////////////////////////////////////////////////////////////////
 
 namespace cf3 {
+namespace common { class URI; namespace XML { class XmlNode; } }
+namespace mesh { class Field; class Mesh; }
 namespace solver {
 namespace actions {
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
-/// Read out a restartfile, designed to be loaded into an already-created mesh
+/// Read out a restartfile, designed to be loaded into an already-created mesh.
+/// Version 2 files are indexed by the global node or element index, and can be read on any number of processes.
+/// Version 1 files store the data per rank and can only be read on the same number of processes as they were written.
 class solver_actions_API ReadRestartFile : public common::Action
 {
 public: // functions
@@ -34,6 +38,16 @@ public: // functions
 
   /// execute the action
   virtual void execute ();
+
+private:
+  /// Read the data from the version 1 format, with one binary file per rank
+  void read_per_rank_data(mesh::Mesh& mesh, common::XML::XmlNode& restart_node, const common::URI& filepath);
+
+  /// Read the data from the version 2 format, with a single binary file indexed by global index
+  void read_global_data(mesh::Mesh& mesh, common::XML::XmlNode& restart_node);
+
+  /// Get the field referred to by the given field node
+  mesh::Field& find_field(mesh::Mesh& mesh, common::XML::XmlNode& field_node);
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
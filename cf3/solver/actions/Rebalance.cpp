@@ -0,0 +1,229 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
+#include "common/Builder.hpp"
+#include "common/FindComponents.hpp"
+#include "common/List.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/TimedComponent.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshTransformer.hpp"
+#include "mesh/Tags.hpp"
+
+#include "Rebalance.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3::common;
+using namespace cf3::mesh;
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < Rebalance, common::Action, LibActions > Rebalance_Builder;
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+void add_element_cost(Entities& elements, const Real cost)
+{
+  PropertyList& properties = elements.properties();
+  if(properties.check(mesh::Tags::measured_cost()))
+    properties.set(mesh::Tags::measured_cost(), properties.value<Real>(mesh::Tags::measured_cost()) + cost);
+  else
+    properties.add(mesh::Tags::measured_cost(), cost);
+}
+
+Real element_cost(const Entities& elements)
+{
+  return elements.properties().check(mesh::Tags::measured_cost()) ? elements.properties().value<Real>(mesh::Tags::measured_cost()) : 0.;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+Rebalance::Rebalance ( const std::string& name ) :
+  solver::Action(name),
+  m_nb_executions(0)
+{
+  options().add("interval", 10u)
+    .pretty_name("Interval")
+    .description("Check the balance every interval executions");
+
+  options().add("imbalance_threshold", 1.2)
+    .pretty_name("Imbalance Threshold")
+    .description("Rebalance when the maximum cost of a process divided by the mean cost exceeds this value");
+
+  options().add("solve_actions", std::vector<URI>())
+    .pretty_name("Solve Actions")
+    .description("Timed actions (e.g. the linear system solves) that add to the cost of a process. "
+                 "Their time is divided evenly over the elements of the process. Requires component timing.");
+
+  options().add("lss_actions", std::vector<URI>())
+    .pretty_name("LSS Actions")
+    .description("Actions with a create_lss signal, called to rebuild their linear system after rebalancing");
+
+  properties().add("imbalance", 1.);
+  properties().add("nb_rebalances", 0u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Rebalance::execute()
+{
+  const Uint interval = options().value<Uint>("interval");
+  if(interval == 0 || ++m_nb_executions % interval != 0)
+    return;
+
+  Mesh& mesh = this->mesh();
+  PE::Comm& comm = PE::Comm::instance();
+
+  Real rank_cost = 0.;
+  BOOST_FOREACH(const Entities& elements, find_components_recursively<Entities>(mesh))
+  {
+    rank_cost += element_cost(elements);
+  }
+  const Real solve_time = solve_cost();
+  rank_cost += solve_time;
+
+  Real max_cost = rank_cost;
+  Real total_cost = rank_cost;
+  Uint nb_procs = 1;
+  if(comm.is_active())
+  {
+    comm.all_reduce(PE::max(), &rank_cost, 1, &max_cost);
+    comm.all_reduce(PE::plus(), &rank_cost, 1, &total_cost);
+    nb_procs = comm.size();
+  }
+
+  const Real mean_cost = total_cost / static_cast<Real>(nb_procs);
+  const Real imbalance = mean_cost > 0. ? max_cost / mean_cost : 1.;
+  properties().set("imbalance", imbalance);
+  CFdebug << "Load imbalance for mesh " << mesh.uri().path() << ": " << imbalance << CFendl;
+
+  if(nb_procs > 1 && imbalance > options().value<Real>("imbalance_threshold"))
+    rebalance(solve_time);
+
+  // Start measuring again
+  BOOST_FOREACH(Entities& elements, find_components_recursively<Entities>(mesh))
+  {
+    if(elements.properties().check(mesh::Tags::measured_cost()))
+      elements.properties().set(mesh::Tags::measured_cost(), 0.);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Real Rebalance::solve_cost()
+{
+  Real result = 0.;
+  BOOST_FOREACH(const URI& action_uri, options().value< std::vector<URI> >("solve_actions"))
+  {
+    Handle<Component> action = access_component(action_uri);
+    if(is_null(action))
+      throw ValueNotFound(FromHere(), "Could not find solve action " + action_uri.path() + " for " + uri().path());
+
+    TimedComponent* timed_action = dynamic_cast<TimedComponent*>(action.get());
+    if(timed_action == nullptr)
+      continue;
+
+    timed_action->store_timings();
+    const Real total_time = action->properties().value<Real>("timer_mean") * static_cast<Real>(action->properties().value<Uint>("timer_count"));
+    Real& previous_time = m_previous_solve_times[action_uri.path()];
+    result += total_time - previous_time;
+    previous_time = total_time;
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Rebalance::rebalance(const Real solve_cost)
+{
+  Mesh& mesh = this->mesh();
+  PE::Comm& comm = PE::Comm::instance();
+
+  CFinfo << "Rebalancing mesh " << mesh.uri().path() << " with load imbalance " << properties().value<Real>("imbalance") << CFendl;
+
+  // Cost per element for each element component, measured including the overlap
+  Uint nb_elements = 0;
+  BOOST_FOREACH(const Entities& elements, find_components_recursively<Entities>(mesh))
+  {
+    nb_elements += elements.size();
+  }
+  const Real solve_cost_per_element = nb_elements == 0 ? 0. : solve_cost / static_cast<Real>(nb_elements);
+
+  std::vector< std::pair<Handle<Entities>, Real> > costs_per_element;
+  Real local_costs[2] = {0., static_cast<Real>(nb_elements)};
+  BOOST_FOREACH(Entities& elements, find_components_recursively<Entities>(mesh))
+  {
+    const Real cost = elements.size() == 0 ? 0. : element_cost(elements) / static_cast<Real>(elements.size()) + solve_cost_per_element;
+    costs_per_element.push_back(std::make_pair(elements.handle<Entities>(), cost));
+    local_costs[0] += cost * static_cast<Real>(elements.size());
+  }
+
+  // Weights are relative to the mean cost of an element, so they have the same magnitude as the unit weight of the nodes
+  Real global_costs[2];
+  comm.all_reduce(PE::plus(), local_costs, 2, global_costs);
+  const Real mean_cost = global_costs[1] > 0. ? global_costs[0] / global_costs[1] : 0.;
+
+  // The partitioner needs a mesh without overlap
+  build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.RemoveGhostElements", "remove_ghosts")->transform(mesh);
+
+  typedef std::pair<Handle<Entities>, Real> CostT;
+  BOOST_FOREACH(const CostT& cost, costs_per_element)
+  {
+    List<Real>& weights = *cost.first->create_component< List<Real> >(mesh::Tags::partition_weights());
+    weights.resize(cost.first->size());
+    std::fill(weights.array().begin(), weights.array().end(), mean_cost > 0. ? cost.second / mean_cost : 1.);
+  }
+
+  build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.LoadBalance", "load_balance")->transform(mesh);
+
+  // Weights don't follow the migrated elements
+  BOOST_FOREACH(Entities& elements, find_components_recursively<Entities>(mesh))
+  {
+    if(is_not_null(elements.get_child(mesh::Tags::partition_weights())))
+      elements.remove_component(mesh::Tags::partition_weights());
+  }
+
+  // Communication patterns are rebuilt on demand for the new distribution
+  BOOST_FOREACH(Dictionary& dict, find_components_recursively<Dictionary>(mesh))
+  {
+    if(is_not_null(dict.get_child("CommPattern")))
+      dict.remove_component("CommPattern");
+  }
+
+  BOOST_FOREACH(const URI& action_uri, options().value< std::vector<URI> >("lss_actions"))
+  {
+    Handle<Component> action = access_component(action_uri);
+    if(is_null(action))
+      throw ValueNotFound(FromHere(), "Could not find LSS action " + action_uri.path() + " for " + uri().path());
+    std::vector<std::string> args;
+    action->call_signal("create_lss", args);
+  }
+
+  properties().set("nb_rebalances", properties().value<Uint>("nb_rebalances") + 1u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
@@ -0,0 +1,75 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Rebalance_hpp
+#define cf3_solver_actions_Rebalance_hpp
+
+#include <map>
+
+#include "solver/Action.hpp"
+
+#include "solver/actions/LibActions.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+
+namespace mesh { class Entities; }
+
+namespace solver {
+namespace actions {
+
+/// Add the measured time spent on the given elements, e.g. during assembly, to the mesh::Tags::measured_cost() property.
+/// Proto element loops call this for each Elements component they visit.
+solver_actions_API void add_element_cost(mesh::Entities& elements, const Real cost);
+
+/// Time spent on the given elements since the last rebalance check
+solver_actions_API Real element_cost(const mesh::Entities& elements);
+
+/// Repartitions the mesh when the measured cost is unevenly distributed over the processes.
+/// Every "interval" executions, the cost of each process is computed as the sum of the measured element costs
+/// and the time spent in the "solve_actions". If the maximum cost exceeds the mean cost by more than the
+/// imbalance threshold, the overlap is removed and the mesh is load balanced again, weighting each element with
+/// the cost per element of its element component. This migrates the elements and the field data through the
+/// MeshAdaptor. The communication patterns of the dictionaries are then rebuilt on demand, and the linear systems
+/// of the "lss_actions" are recreated.
+class solver_actions_API Rebalance : public cf3::solver::Action
+{
+public: // functions
+  /// Contructor
+  /// @param name of the component
+  Rebalance ( const std::string& name );
+
+  /// Virtual destructor
+  virtual ~Rebalance() {}
+
+  /// Get the class name
+  static std::string type_name () { return "Rebalance"; }
+
+  /// Check the balance, and rebalance if needed
+  virtual void execute ();
+
+private:
+  /// Time spent in the solve actions since the last check
+  Real solve_cost();
+
+  /// Partition the mesh again, using the measured costs as weights
+  void rebalance(const Real solve_cost);
+
+  /// Number of calls to execute
+  Uint m_nb_executions;
+
+  /// Total time of each of the solve actions at the previous check
+  std::map<std::string, Real> m_previous_solve_times;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
+
+#endif // cf3_solver_actions_Rebalance_hpp
@@ -64,11 +64,19 @@ void SynchronizeFields::config_fields()
 
 void SynchronizeFields::execute()
 {
+  // Start all exchanges before waiting for any of them, so the communication of the different fields overlaps
   boost_foreach(Handle<Field> ptr, m_fields)
   {
     if( is_null(ptr) ) continue; // skip if pointer invalid
 
-    ptr->synchronize();
+    ptr->begin_synchronize();
+  }
+
+  boost_foreach(Handle<Field> ptr, m_fields)
+  {
+    if( is_null(ptr) ) continue;
+
+    ptr->end_synchronize();
   }
 }
 
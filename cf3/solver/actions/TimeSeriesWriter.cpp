@@ -56,7 +56,8 @@ void TimeSeriesWriter::execute()
   const std::string current_time_str = boost::lexical_cast<std::string>(m_time->current_time());
   const std::string current_iter_str = common::to_str(current_iter);
 
-
+  // Asynchronous writers stage a copy of the data, so the previous output can still be in progress. The output thread
+  // only blocks when its queue is full, and the remaining output is completed at the end of the simulation.
   BOOST_FOREACH(common::Action& action, common::find_components<common::Action>(*this))
   {
     if(action.options().check("file"))
@@ -4,11 +4,15 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/make_shared.hpp>
 
 #include "common/Builder.hpp"
+#include "common/Core.hpp"
+#include "common/EventHandler.hpp"
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
 #include "common/PropertyList.hpp"
@@ -21,6 +25,7 @@
 #include "mesh/Mesh.hpp"
 #include "mesh/Region.hpp"
 #include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
 
 #include "solver/actions/TurbulenceStatistics.hpp"
 
@@ -51,6 +56,7 @@ TurbulenceStatistics::TurbulenceStatistics ( const std::string& name ) :
   common::Action(name),
   m_rolling_size(10),
   m_options_changed(true),
+  m_mesh_changed(false),
   m_dim(0),
   m_velocity_field_offset(0),
   m_pressure_field_offset(0),
@@ -102,12 +108,13 @@ TurbulenceStatistics::TurbulenceStatistics ( const std::string& name ) :
     .pretty_name("Setup");
   
   properties().add("restart_field_tags", std::vector<std::string>(1, "turbulence_statistics"));
+
+  common::Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &TurbulenceStatistics::on_mesh_changed_event);
 }
 
 void TurbulenceStatistics::execute()
 {
   setup();
-  common::PE::Comm& comm = common::PE::Comm::instance();
 
   const Uint nb_nodes = m_used_nodes->size();
   const common::List<Uint>::ListT& used_nodes_list = m_used_nodes->array();
@@ -239,6 +246,7 @@ void TurbulenceStatistics::reset_statistics()
 void TurbulenceStatistics::add_probe(const RealVector& probe_location)
 {
   m_probe_locations.push_back(probe_location);
+  m_options_changed = true;
 }
 
 void TurbulenceStatistics::trigger_option()
@@ -246,6 +254,18 @@ void TurbulenceStatistics::trigger_option()
   m_options_changed = true;
 }
 
+void TurbulenceStatistics::on_mesh_changed_event(common::SignalArgs& args)
+{
+  Handle<mesh::Region> region = options().value< Handle<mesh::Region> >("region");
+  if(is_null(region))
+    return;
+
+  // Only handle events coming from the mesh of our region
+  common::XML::SignalOptions options(args);
+  if(options.value<common::URI>("mesh_uri") == common::find_parent_component<mesh::Mesh>(*region).uri())
+    m_mesh_changed = true;
+}
+
 void TurbulenceStatistics::signal_add_probe(common::SignalArgs& args)
 {
   common::XML::SignalOptions options(args);
@@ -266,9 +286,13 @@ void TurbulenceStatistics::signal_setup(common::SignalArgs& args)
 
 void TurbulenceStatistics::setup()
 {
-  if(!m_options_changed)
+  if(!m_options_changed && !m_mesh_changed)
     return;
+
+  // If only the mesh changed, the probes are located again but keep their statistics
+  const bool reset = m_options_changed;
   m_options_changed = false;
+  m_mesh_changed = false;
 
   m_used_nodes.reset();
 
@@ -331,6 +355,7 @@ void TurbulenceStatistics::setup()
   m_used_nodes = mesh::build_used_nodes_list(*region, *dictionary, true, false);
   const int nb_probes = m_probe_locations.size();
   std::vector<int> my_probes_found(nb_probes, 0);
+  const std::vector<Uint> old_probe_indices = m_probe_indices;
   m_probe_nodes.clear();
   m_probe_indices.clear();
   const common::List<Uint>::ListT& used_nodes_list = m_used_nodes->array();
@@ -380,10 +405,12 @@ void TurbulenceStatistics::setup()
     const Uint probe_idx = m_probe_indices[my_idx];
     std::string probe_path = (original_uri.base_path() / (original_uri.base_name() + "-probe-" + common::to_str(probe_idx) + original_uri.extension())).path();
 
-    m_probe_files.push_back(boost::make_shared<boost::filesystem::fstream>(probe_path, std::ios_base::out));
+    m_probe_files.push_back(boost::make_shared<boost::filesystem::fstream>(probe_path, reset ? std::ios_base::out : (std::ios_base::out | std::ios_base::app)));
     boost::filesystem::fstream& file = *m_probe_files.back();
     if(!file)
       throw common::FileSystemError(FromHere(), "Failed to open file " + probe_path);
+    if(!reset)
+      continue;
 
     file << "# Probe data for probe " << probe_idx << " at point " << m_probe_locations[probe_idx].transpose() << "\n";
     if(m_dim == 2)
@@ -411,10 +438,29 @@ void TurbulenceStatistics::setup()
     m_statistics_field->add_tag("turbulence_statistics");
   }
 
-  // Reset statistics without changing m_count
-  const Uint nb_accs = (2.*m_dim + m_dim-1 + m_dim-2)*m_probe_nodes.size();
-  m_means.assign(nb_accs, MeanAccT());
-  m_rolling_means.assign(nb_accs, RollingAccT(boost::accumulators::tag::rolling_window::window_size = options().value<Uint>("rolling_window")));
+  const Uint stride = 2.*m_dim + m_dim-1 + m_dim-2;
+  const RollingAccT empty_rolling_mean(boost::accumulators::tag::rolling_window::window_size = options().value<Uint>("rolling_window"));
+  if(reset)
+  {
+    // Reset statistics without changing m_count
+    m_means.assign(stride*nb_my_probes, MeanAccT());
+    m_rolling_means.assign(stride*nb_my_probes, empty_rolling_mean);
+    return;
+  }
+
+  // Keep the statistics of the probes that stayed on this rank. Probes that moved here from another rank start over.
+  std::vector<MeanAccT> means(stride*nb_my_probes, MeanAccT());
+  std::vector<RollingAccT> rolling_means(stride*nb_my_probes, empty_rolling_mean);
+  for(Uint my_idx = 0; my_idx != nb_my_probes; ++my_idx)
+  {
+    const Uint old_idx = std::find(old_probe_indices.begin(), old_probe_indices.end(), m_probe_indices[my_idx]) - old_probe_indices.begin();
+    if(old_idx == old_probe_indices.size())
+      continue;
+    std::copy(m_means.begin() + old_idx*stride, m_means.begin() + (old_idx+1)*stride, means.begin() + my_idx*stride);
+    std::copy(m_rolling_means.begin() + old_idx*stride, m_rolling_means.begin() + (old_idx+1)*stride, rolling_means.begin() + my_idx*stride);
+  }
+  m_means.swap(means);
+  m_rolling_means.swap(rolling_means);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -47,8 +47,11 @@ public: // functions
   /// Reset the statistics
   void reset_statistics();
 
+  /// Add a probe at the given location. The probes are matched to the nodes once, on the next execution,
+  /// and kept until a probe is added, an option changes or the mesh changes. When only the mesh changes,
+  /// the statistics of the probes are kept and their files are appended to.
   void add_probe(const RealVector& probe_location);
-  
+
 private:
   /// Set up the accumulators as configured by the options
   void setup();
@@ -56,6 +59,9 @@ private:
   /// Triggered when an option is changed
   void trigger_option();
 
+  /// Locate the probes again when the mesh of the region changes
+  void on_mesh_changed_event(common::SignalArgs& args);
+
   void signal_add_probe(common::SignalArgs& args);
   void signature_add_probe(common::SignalArgs& args);
   void signal_setup(common::SignalArgs& args);
@@ -64,6 +70,8 @@ private:
   Uint m_rolling_size;
   /// True if one of the options changed since last execute
   bool m_options_changed;
+  /// True if the mesh of the region changed since last execute
+  bool m_mesh_changed;
   /// Nodes used by the region
   boost::shared_ptr< common::List<Uint> > m_used_nodes;
   /// Field having the velocity
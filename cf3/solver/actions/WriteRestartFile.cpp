@@ -5,13 +5,17 @@
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
 #include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "common/Builder.hpp"
 #include "common/FindComponents.hpp"
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
-#include "common/BinaryDataWriter.hpp"
+#include "common/Log.hpp"
+#include "common/OutputThread.hpp"
+#include "common/PE/ParallelFile.hpp"
 #include "common/XML/FileOperations.hpp"
 
 #include "mesh/Dictionary.hpp"
@@ -34,6 +38,19 @@ namespace actions {
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+  /// Wait for the field data to be written and write the XML description. Collective.
+  void finish_restart_file(const boost::shared_ptr<common::PE::ParallelFile>& data_file, const boost::shared_ptr<common::XML::XmlDoc>& xml_doc, const common::URI& out_file_path)
+  {
+    data_file->end_write();
+    if(common::PE::Comm::instance().rank() == 0)
+      common::XML::to_file(*xml_doc, out_file_path);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
 common::ComponentBuilder < WriteRestartFile, common::Action, LibActions > WriteRestartFile_Builder;
 
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -55,6 +72,23 @@ WriteRestartFile::WriteRestartFile ( const std::string& name ) :
     .pretty_name("Time")
     .description("Time component, used to extract timing and iteration information")
     .mark_basic();
+
+  options().add("asynchronous", false)
+    .pretty_name("Asynchronous")
+    .description("Return as soon as the write is started, and complete it at the next flush of the output thread. "
+                 "At most common::OutputThread::max_queue_size() writes are pending: the oldest ones are completed before starting a new one.");
+}
+
+WriteRestartFile::~WriteRestartFile()
+{
+  try
+  {
+    common::OutputThread::instance().flush();
+  }
+  catch(std::exception& e)
+  {
+    CFerror << "Error completing the restart output of " << uri().path() << ": " << e.what() << CFendl;
+  }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -83,13 +117,12 @@ void WriteRestartFile::execute()
   cf3_assert(is_not_null(mesh));
   
   const common::URI out_file_path = options().value<common::URI>("file");
-  const common::URI binfile = out_file_path.base_path() / (out_file_path.base_name() + ".cfbinxml");
-  boost::shared_ptr<common::BinaryDataWriter> data_writer = common::allocate_component<common::BinaryDataWriter>("DataWriter");
-  data_writer->options().set("file", binfile);
+  const common::URI binfile = out_file_path.base_path() / (out_file_path.base_name() + ".cfrestartdata");
+  boost::shared_ptr<common::PE::ParallelFile> data_file(new common::PE::ParallelFile(binfile.path(), common::PE::ParallelFile::WRITE));
   
-  common::XML::XmlDoc xml_doc("1.0", "ISO-8859-1");
-  common::XML::XmlNode restart_node = xml_doc.add_node("restart");
-  restart_node.set_attribute("version", "1");
+  boost::shared_ptr<common::XML::XmlDoc> xml_doc(new common::XML::XmlDoc("1.0", "ISO-8859-1"));
+  common::XML::XmlNode restart_node = xml_doc->add_node("restart");
+  restart_node.set_attribute("version", "2");
   restart_node.set_attribute("binary_file", binfile.path());
   restart_node.set_attribute("nb_procs", common::to_str(comm.size()));
   restart_node.set_attribute("current_time", common::to_str(time->current_time()));
@@ -97,19 +130,60 @@ void WriteRestartFile::execute()
   restart_node.set_attribute("iteration", common::to_str(time->iter()));
   
   const std::string base_path = mesh->uri().path() + "/";
-  
+
+  // Each field is stored as a block of rows, ordered by global index, so the file does not depend on the partitioning
+  boost::uint64_t block_begin = 0;
+  std::vector<Uint> owned_gids;
+  std::vector<Real> owned_data;
   BOOST_FOREACH(const Handle<mesh::Field>& field, fields)
   {
+    const mesh::Dictionary& dict = field->dict();
+    const common::List<Uint>& glb_idx = dict.glb_idx();
+    const Uint nb_rows = field->size();
+    const Uint row_size = field->row_size();
+    if(glb_idx.size() != nb_rows)
+      throw common::SetupError(FromHere(), "Global indices of dictionary " + dict.uri().path() + " are not set for field " + field->uri().path());
+
+    // Only the owner writes a row
+    owned_gids.clear();
+    owned_data.clear();
+    Uint nb_global_rows = 0;
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      nb_global_rows = std::max(nb_global_rows, glb_idx[i] + 1);
+      if(dict.is_ghost(i))
+        continue;
+      owned_gids.push_back(glb_idx[i]);
+      owned_data.insert(owned_data.end(), (*field)[i].begin(), (*field)[i].end());
+    }
+    if(comm.is_active())
+      comm.all_reduce(common::PE::max(), &nb_global_rows, 1, &nb_global_rows);
+
+    data_file->add_rows(block_begin, reinterpret_cast<const char*>(owned_data.empty() ? 0 : &owned_data[0]), owned_gids, row_size*sizeof(Real));
+
     common::XML::XmlNode field_node = restart_node.add_node("field");
     std::string relative_path = field->uri().path();
     boost::replace_first(relative_path, base_path, "");
     cf3_assert(relative_path.size() == field->uri().path().size() - base_path.size());
     field_node.set_attribute("path", relative_path);
-    field_node.set_attribute("index", common::to_str(data_writer->append_data(*field)));
+    field_node.set_attribute("begin", common::to_str(block_begin));
+    field_node.set_attribute("nb_rows", common::to_str(nb_global_rows));
+    field_node.set_attribute("nb_cols", common::to_str(row_size));
+
+    block_begin += static_cast<boost::uint64_t>(nb_global_rows)*row_size*sizeof(Real);
   }
 
-  if(comm.rank() == 0)
-    common::XML::to_file(xml_doc, out_file_path);
+  // All fields are written using a single nonblocking collective write
+  data_file->begin_write();
+  if(options().value<bool>("asynchronous"))
+  {
+    // Collective MPI calls are not allowed on the output thread, so only the completion is queued
+    common::OutputThread::instance().enqueue(common::OutputThread::TaskT(), boost::bind(&detail::finish_restart_file, data_file, xml_doc, out_file_path));
+  }
+  else
+  {
+    detail::finish_restart_file(data_file, xml_doc, out_file_path);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
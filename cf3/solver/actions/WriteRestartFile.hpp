@@ -18,7 +18,10 @@ namespace actions {
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
-/// Write out a restartfile, designed to be loaded into an already-created mesh
+/// Write out a restartfile, designed to be loaded into an already-created mesh.
+/// The field data is written into a single binary file shared by all processes, using collective MPI-IO.
+/// Rows are stored by global index, so the file can be read back on a different number of processes.
+/// When the option "asynchronous" is set, the write is started with nonblocking MPI-IO and completed when the common::OutputThread is flushed.
 class solver_actions_API WriteRestartFile : public common::Action
 {
 public: // functions
@@ -27,7 +30,8 @@ public: // functions
   WriteRestartFile ( const std::string& name );
 
   /// Virtual destructor
-  virtual ~WriteRestartFile() {}
+  /// Completes asynchronous writes that are still pending
+  virtual ~WriteRestartFile();
 
   /// Get the class name
   static std::string type_name () { return "WriteRestartFile"; }
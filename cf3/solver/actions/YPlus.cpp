@@ -211,16 +211,17 @@ void YPlus::execute()
   for(Uint node_idx = 0; node_idx != nb_nodes; ++node_idx)
   {
     yplus_field[node_idx][0] = 0;
-    if(node_to_wall_element[node_idx][0] != 0)
+    if(node_to_wall_element[node_idx][0] == 1)
     {
       const Entities& wall_entities = *wall_node_connectivity.entities()[node_to_wall_element[node_idx][1]];
       const Uint wall_field_idx = wall_entities.space(wall_P0).connectivity()[node_to_wall_element[node_idx][2]][0];
       yplus_field[node_idx][0] = wall_distance_field[node_idx][0] * sqrt(nu*wall_velocity_gradient_field[wall_field_idx][0]) / nu;
     }
-    else
+    else if(node_to_wall_element[node_idx][0] == 0)
     {
       yplus_field[node_idx][0] = wall_distance_field[node_idx][0] * sqrt(nu*wall_velocity_gradient_field_nodal[node_to_wall_element[node_idx][1]][0]) / nu;
     }
+    // Otherwise there is no wall on this rank to take the velocity gradient from, and y+ is left at zero
   }
 }
 
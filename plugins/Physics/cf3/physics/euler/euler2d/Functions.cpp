@@ -5,6 +5,7 @@
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
 #include "cf3/physics/euler/euler2d/Functions.hpp"
+#include "cf3/common/CF.hpp"
 #include "cf3/math/Defs.hpp"
 
 namespace cf3 {
@@ -200,6 +201,189 @@ void compute_hlle_flux( const Data& left, const Data& right, const ColVector_NDI
   compute_convective_wave_speed(roe,normal,wave_speed);
 }
 
+namespace detail
+{
+  /// Rows of a block of faces stored per variable. Indexing separate rows, instead of computing
+  /// i*nb_faces + f, lets the compiler see that the accesses are contiguous and vectorize the loops.
+  template <typename T, Uint NB_ROWS>
+  struct FaceRows
+  {
+    FaceRows( T* data, const Uint nb_faces )
+    {
+      for (Uint i=0; i<NB_ROWS; ++i)
+        rows[i] = data + i*nb_faces;
+    }
+
+    T* operator[]( const Uint i ) const { return rows[i]; }
+
+    T* rows[NB_ROWS];
+  };
+
+  typedef FaceRows<const Real, NEQS> StateRows;
+  typedef FaceRows<const Real, NDIM> NormalRows;
+  typedef FaceRows<Real, NEQS> FluxRows;
+
+  /// Quantities of a conservative state needed by the Riemann solvers, computed as in Data::compute_from_conservative
+  struct FaceState
+  {
+    FaceState( const Real gamma, const StateRows& cons, const Uint f ) :
+      rho(cons[0][f]),
+      u(cons[1][f]/rho),
+      v(cons[2][f]/rho)
+    {
+      const Real E = cons[3][f]/rho;
+      p = (gamma-1.)*rho*(E - 0.5*(u*u + v*v));
+      H = E + p/rho;
+      c = std::sqrt(gamma*p/rho);
+    }
+
+    /// Normal velocity
+    Real normal_velocity( const Real nx, const Real ny ) const { return u*nx + v*ny; }
+
+    /// Convective flux, given the normal velocity
+    void convective_flux( const Real un, const Real nx, const Real ny, Real* flux ) const
+    {
+      const Real rho_un = rho*un;
+      flux[0] = rho_un;
+      flux[1] = rho_un*u + p*nx;
+      flux[2] = rho_un*v + p*ny;
+      flux[3] = rho_un*H;
+    }
+
+    Real rho, u, v, p, H, c;
+  };
+
+  /// Roe average of two states, as in compute_roe_average
+  struct RoeState
+  {
+    RoeState( const Real gamma, const FaceState& left, const FaceState& right )
+    {
+      const Real sqrt_rhoL = std::sqrt(left.rho);
+      const Real sqrt_rhoR = std::sqrt(right.rho);
+      const Real sum = sqrt_rhoL + sqrt_rhoR;
+      rho = sqrt_rhoL*sqrt_rhoR;
+      u   = (sqrt_rhoL*left.u + sqrt_rhoR*right.u) / sum;
+      v   = (sqrt_rhoL*left.v + sqrt_rhoR*right.v) / sum;
+      H   = (sqrt_rhoL*left.H + sqrt_rhoR*right.H) / sum;
+      U2  = u*u + v*v;
+      c2  = (gamma-1.)*(H-0.5*U2);
+      c   = std::sqrt(c2);
+    }
+
+    Real rho, u, v, H, U2, c2, c;
+  };
+}
+
+void compute_rusanov_flux( const Uint nb_faces, const Real gamma,
+                           const Real* cf_restrict left, const Real* cf_restrict right, const Real* cf_restrict normals,
+                           Real* cf_restrict flux, Real* cf_restrict wave_speed )
+{
+  const detail::StateRows consL(left, nb_faces), consR(right, nb_faces);
+  const detail::NormalRows n(normals, nb_faces);
+  const detail::FluxRows F(flux, nb_faces);
+  for (Uint f=0; f<nb_faces; ++f)
+  {
+    const Real nx = n[XX][f];
+    const Real ny = n[YY][f];
+    const detail::FaceState L(gamma, consL, f);
+    const detail::FaceState R(gamma, consR, f);
+    const Real unL = L.normal_velocity(nx, ny);
+    const Real unR = R.normal_velocity(nx, ny);
+
+    Real fL[NEQS], fR[NEQS];
+    L.convective_flux(unL, nx, ny, fL);
+    R.convective_flux(unR, nx, ny, fR);
+
+    const Real ws = std::max(std::abs(unL)+L.c, std::abs(unR)+R.c);
+    for (Uint eq=0; eq<NEQS; ++eq)
+      F[eq][f] = 0.5*(fL[eq]+fR[eq]) - 0.5*ws*(consR[eq][f] - consL[eq][f]);
+    wave_speed[f] = ws;
+  }
+}
+
+void compute_roe_flux( const Uint nb_faces, const Real gamma,
+                       const Real* cf_restrict left, const Real* cf_restrict right, const Real* cf_restrict normals,
+                       Real* cf_restrict flux, Real* cf_restrict wave_speed )
+{
+  const detail::StateRows consL(left, nb_faces), consR(right, nb_faces);
+  const detail::NormalRows n(normals, nb_faces);
+  const detail::FluxRows F(flux, nb_faces);
+  for (Uint f=0; f<nb_faces; ++f)
+  {
+    const Real nx = n[XX][f];
+    const Real ny = n[YY][f];
+    const detail::FaceState L(gamma, consL, f);
+    const detail::FaceState R(gamma, consR, f);
+    const detail::RoeState roe(gamma, L, R);
+    const Real unL = L.normal_velocity(nx, ny);
+    const Real unR = R.normal_velocity(nx, ny);
+    const Real un  = roe.u*nx + roe.v*ny;
+    const Real us  = roe.u*ny - roe.v*nx;
+
+    // Wave strengths
+    const Real du   = R.u - L.u;
+    const Real dv   = R.v - L.v;
+    const Real drho = R.rho - L.rho;
+    const Real dp   = R.p - L.p;
+    const Real dun  = du*nx + dv*ny;
+    const Real dus  = du*ny - dv*nx;
+    const Real dW0 = drho - dp/roe.c2;
+    const Real dW1 = dus * roe.rho;
+    const Real dW2 = 0.5*(dp/roe.c2 + dun*roe.rho/roe.c);
+    const Real dW3 = 0.5*(dp/roe.c2 - dun*roe.rho/roe.c);
+
+    // Wave strengths scaled with half the absolute wave speeds
+    const Real a0 = 0.5*std::abs(un)*dW0;
+    const Real a1 = 0.5*std::abs(un)*dW1;
+    const Real a2 = 0.5*std::abs(un+roe.c)*dW2;
+    const Real a3 = 0.5*std::abs(un-roe.c)*dW3;
+
+    Real fL[NEQS], fR[NEQS];
+    L.convective_flux(unL, nx, ny, fL);
+    R.convective_flux(unR, nx, ny, fR);
+
+    // Subtract the right eigenvectors, see compute_convective_right_eigenvectors, multiplied with the scaled strengths
+    F[0][f] = 0.5*(fL[0]+fR[0]) - (a0 + a2 + a3);
+    F[1][f] = 0.5*(fL[1]+fR[1]) - (a0*roe.u + a1*ny + a2*(roe.u+roe.c*nx) + a3*(roe.u-roe.c*nx));
+    F[2][f] = 0.5*(fL[2]+fR[2]) - (a0*roe.v - a1*nx + a2*(roe.v+roe.c*ny) + a3*(roe.v-roe.c*ny));
+    F[3][f] = 0.5*(fL[3]+fR[3]) - (a0*0.5*roe.U2 + a1*us + a2*(roe.H+roe.c*un) + a3*(roe.H-roe.c*un));
+    wave_speed[f] = std::abs(un)+roe.c;
+  }
+}
+
+void compute_hlle_flux( const Uint nb_faces, const Real gamma,
+                        const Real* cf_restrict left, const Real* cf_restrict right, const Real* cf_restrict normals,
+                        Real* cf_restrict flux, Real* cf_restrict wave_speed )
+{
+  const detail::StateRows consL(left, nb_faces), consR(right, nb_faces);
+  const detail::NormalRows n(normals, nb_faces);
+  const detail::FluxRows F(flux, nb_faces);
+  for (Uint f=0; f<nb_faces; ++f)
+  {
+    const Real nx = n[XX][f];
+    const Real ny = n[YY][f];
+    const detail::FaceState L(gamma, consL, f);
+    const detail::FaceState R(gamma, consR, f);
+    const detail::RoeState roe(gamma, L, R);
+    const Real unL = L.normal_velocity(nx, ny);
+    const Real unR = R.normal_velocity(nx, ny);
+    const Real un  = roe.u*nx + roe.v*ny;
+
+    // Clipping the wave speeds to zero selects the left or right flux in the supersonic cases, without branching
+    const Real sL = std::min(std::min(unL-L.c, un-roe.c), 0.);
+    const Real sR = std::max(std::max(unR+R.c, un+roe.c), 0.);
+    const Real inv_ds = 1./(sR-sL);
+
+    Real fL[NEQS], fR[NEQS];
+    L.convective_flux(unL, nx, ny, fL);
+    R.convective_flux(unR, nx, ny, fR);
+
+    for (Uint eq=0; eq<NEQS; ++eq)
+      F[eq][f] = (sR*fL[eq] - sL*fR[eq] + sL*sR*(consR[eq][f] - consL[eq][f])) * inv_ds;
+    wave_speed[f] = std::abs(un)+roe.c;
+  }
+}
+
 void compute_specific_entropy( const Data& p, Real& specific_entropy)
 {
   // Compute specific entropy from primitive variables
@@ -65,6 +65,30 @@ void compute_roe_flux( const Data& left, const Data& right, const ColVector_NDIM
 void compute_hlle_flux( const Data& left, const Data& right, const ColVector_NDIM& normal,
                         RowVector_NEQS& flux, Real& wave_speed );
 
+/// @name Approximate Riemann solvers for a block of faces
+/// The states, normals and results of nb_faces faces are stored per variable (structure of arrays):
+/// variable i of face f is at index i*nb_faces + f. The states are conservative and share the same gamma.
+/// The loops over the faces contain no branches or function calls other than square roots, so the
+/// compiler can vectorize them. The results are those of the single face versions, up to roundoff.
+//@{
+
+/// @brief Rusanov Approximate Riemann solver for a block of faces
+void compute_rusanov_flux( const Uint nb_faces, const Real gamma,
+                           const Real* left, const Real* right, const Real* normals,
+                           Real* flux, Real* wave_speed );
+
+/// @brief Roe Approximate Riemann solver for a block of faces
+void compute_roe_flux( const Uint nb_faces, const Real gamma,
+                       const Real* left, const Real* right, const Real* normals,
+                       Real* flux, Real* wave_speed );
+
+/// @brief HLLE Approximate Riemann solver for a block of faces
+void compute_hlle_flux( const Uint nb_faces, const Real gamma,
+                        const Real* left, const Real* right, const Real* normals,
+                        Real* flux, Real* wave_speed );
+
+//@}
+
 /// @brief Compute the specific entropy from the primitive variables
 void compute_specific_entropy( const Data& p, Real& specific_entropy );
 
@@ -0,0 +1,337 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Benchmark of the element-wise and block-wise ComputeRHS for Scalar and LinEuler terms"
+
+#include <iostream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
+#include "common/OptionList.hpp"
+#include "common/StringConversion.hpp"
+#include "common/Timer.hpp"
+
+#include "math/Defs.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshGenerator.hpp"
+#include "mesh/ShapeFunction.hpp"
+#include "mesh/Space.hpp"
+
+#include "solver/ComputeRHS.hpp"
+#include "solver/TermComputer.hpp"
+
+#include "cf3/physics/lineuler/lineuler2d/Functions.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+using namespace cf3::physics::lineuler;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Linear advection of a scalar
+struct ScalarPhysics
+{
+  enum { NEQS = 1 };
+  typedef Eigen::Matrix<Real,1,NEQS> StateT;
+
+  static void compute_fluxes(const StateT& sol, StateT& flux_x, StateT& flux_y, Real& wave_speed)
+  {
+    const Real ax = 1.;
+    const Real ay = 0.5;
+    flux_x = ax*sol;
+    flux_y = ay*sol;
+    wave_speed = std::sqrt(ax*ax + ay*ay);
+  }
+};
+
+/// Linearized Euler equations around a uniform mean flow
+struct LinEulerPhysics
+{
+  enum { NEQS = 4 };
+  typedef lineuler2d::RowVector_NEQS StateT;
+
+  static void compute_fluxes(const StateT& sol, StateT& flux_x, StateT& flux_y, Real& wave_speed)
+  {
+    lineuler2d::Data p;
+    p.gamma = 1.4;
+    p.rho0 = 1.;
+    p.U0 << 0.5, 0.;
+    p.c0 = 1.;
+    p.p0 = p.rho0*p.c0*p.c0/p.gamma;
+    p.compute_from_conservative(sol);
+
+    lineuler2d::ColVector_NDIM normal;
+    Real wave_speed_x, wave_speed_y;
+    normal << 1., 0.;
+    lineuler2d::compute_convective_flux(p, normal, flux_x, wave_speed_x);
+    normal << 0., 1.;
+    lineuler2d::compute_convective_flux(p, normal, flux_y, wave_speed_y);
+    wave_speed = std::max(wave_speed_x, wave_speed_y);
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Term -convection*(Dx Fx + Dy Fy) - damping*u on linear quadrilaterals, with Dx and Dy the differences along the
+/// edges of the reference square. Computed element by element with dynamic vectors, or, if BLOCK is true,
+/// block by block with fixed sizes.
+template <typename PhysicsT, bool BLOCK>
+class BenchmarkTerm : public TermComputer
+{
+public:
+  enum { NEQS = PhysicsT::NEQS };
+  enum { NB_SOL_PTS = 4 };
+  typedef typename TermBlock<NB_SOL_PTS, NEQS>::ElementTermT ElementMatrixT;
+
+  BenchmarkTerm(const std::string& name) : TermComputer(name), convection(0.), damping(0.)
+  {
+    dx << -0.5,  0.5,  0. ,  0. ,
+          -0.5,  0.5,  0. ,  0. ,
+           0. ,  0. ,  0.5, -0.5,
+           0. ,  0. ,  0.5, -0.5;
+    dy << -0.5,  0. ,  0. ,  0.5,
+           0. , -0.5,  0.5,  0. ,
+           0. , -0.5,  0.5,  0. ,
+          -0.5,  0. ,  0. ,  0.5;
+  }
+
+  static std::string type_name() { return "BenchmarkTerm"; }
+
+  /// Only the quadrilaterals, not the boundary faces
+  virtual bool loop_cells(const Handle<Entities const>& cells)
+  {
+    const Space& space = solution->space(*cells);
+    connectivity = space.connectivity().handle<Connectivity>();
+    return space.shape_function().nb_nodes() == NB_SOL_PTS;
+  }
+
+  virtual void compute_term(const Uint elem_idx, std::vector<RealVector>& term, std::vector<Real>& wave_speed)
+  {
+    term.resize(NB_SOL_PTS, RealVector(NEQS));
+    wave_speed.resize(NB_SOL_PTS);
+    flux_x.resize(NB_SOL_PTS, RealVector(NEQS));
+    flux_y.resize(NB_SOL_PTS, RealVector(NEQS));
+    sol.resize(NB_SOL_PTS, RealVector(NEQS));
+
+    typename PhysicsT::StateT state, point_flux_x, point_flux_y;
+    for (Uint i=0; i<NB_SOL_PTS; ++i)
+    {
+      const Field::ConstRow row = (*solution)[(*connectivity)[elem_idx][i]];
+      for (Uint eq=0; eq<NEQS; ++eq)
+        state[eq] = sol[i][eq] = row[eq];
+      PhysicsT::compute_fluxes(state, point_flux_x, point_flux_y, wave_speed[i]);
+      for (Uint eq=0; eq<NEQS; ++eq)
+      {
+        flux_x[i][eq] = point_flux_x[eq];
+        flux_y[i][eq] = point_flux_y[eq];
+      }
+    }
+    for (Uint i=0; i<NB_SOL_PTS; ++i)
+    {
+      term[i] = -damping*sol[i];
+      for (Uint j=0; j<NB_SOL_PTS; ++j)
+        term[i] -= convection*(dx(i,j)*flux_x[j] + dy(i,j)*flux_y[j]);
+    }
+  }
+
+  virtual void add_term_block(const Uint begin, const Uint end, const Uint nb_sol_pts, const Uint nb_eqs,
+                              Real* term, Real* wave_speed)
+  {
+    if (!BLOCK)
+    {
+      TermComputer::add_term_block(begin, end, nb_sol_pts, nb_eqs, term, wave_speed);
+      return;
+    }
+
+    cf3_assert(nb_sol_pts == NB_SOL_PTS && nb_eqs == NEQS);
+    const TermBlock<NB_SOL_PTS, NEQS> block(term, wave_speed);
+    ElementMatrixT elem_sol, elem_flux_x, elem_flux_y;
+    typename PhysicsT::StateT state, point_flux_x, point_flux_y;
+    Real point_wave_speed;
+    for (Uint e=begin; e<end; ++e)
+    {
+      const Connectivity::ConstRow nodes = (*connectivity)[e];
+      Eigen::Map<typename TermBlock<NB_SOL_PTS, NEQS>::ElementWaveSpeedT> elem_wave_speed = block.wave_speed(e-begin);
+      for (Uint i=0; i<NB_SOL_PTS; ++i)
+      {
+        const Field::ConstRow row = (*solution)[nodes[i]];
+        for (Uint eq=0; eq<NEQS; ++eq)
+          state[eq] = row[eq];
+        PhysicsT::compute_fluxes(state, point_flux_x, point_flux_y, point_wave_speed);
+        elem_sol.row(i) = state;
+        elem_flux_x.row(i) = point_flux_x;
+        elem_flux_y.row(i) = point_flux_y;
+        elem_wave_speed[i] = std::max(elem_wave_speed[i], point_wave_speed);
+      }
+      block.term(e-begin).noalias() -= damping*elem_sol + convection*(dx*elem_flux_x + dy*elem_flux_y);
+    }
+  }
+
+  Handle<Field> solution;
+  Real convection;
+  Real damping;
+
+private:
+  Handle<Connectivity const> connectivity;
+  Eigen::Matrix<Real, NB_SOL_PTS, NB_SOL_PTS> dx, dy;
+  std::vector<RealVector> flux_x, flux_y, sol;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// The element-wise algorithm ComputeRHS used before it computed blocks of elements, summing the terms of each element
+void compute_rhs_per_element(ComputeRHS& rhs_computer, Field& rhs, Field& wave_speed)
+{
+  const Uint nb_eqs = rhs.row_size();
+  std::vector<RealVector> term;
+  std::vector<Real> term_wave_speed;
+  std::vector< Handle<TermComputer> > term_computers;
+  boost_foreach(TermComputer& term_computer, find_components<TermComputer>(rhs_computer))
+    term_computers.push_back(term_computer.handle<TermComputer>());
+
+  boost_foreach(const Handle<Entities>& cells, rhs.dict().entities_range())
+  {
+    if (rhs_computer.loop_cells(cells))
+    {
+      const Space& space = rhs.dict().space(*cells);
+      const Uint nb_sol_pts = space.shape_function().nb_nodes();
+      std::vector<RealVector> elem_rhs(nb_sol_pts, RealVector(nb_eqs));
+      std::vector<Real> elem_wave_speed(nb_sol_pts);
+      for (Uint elem_idx=0; elem_idx<cells->size(); ++elem_idx)
+      {
+        if (cells->is_ghost(elem_idx))
+          continue;
+        for (Uint sol_pt=0; sol_pt<nb_sol_pts; ++sol_pt)
+        {
+          elem_rhs[sol_pt].setZero();
+          elem_wave_speed[sol_pt] = 0.;
+        }
+        boost_foreach(const Handle<TermComputer>& term_computer, term_computers)
+        {
+          term_computer->compute_term(elem_idx, term, term_wave_speed);
+          for (Uint sol_pt=0; sol_pt<nb_sol_pts; ++sol_pt)
+          {
+            elem_rhs[sol_pt] += term[sol_pt];
+            elem_wave_speed[sol_pt] = std::max(elem_wave_speed[sol_pt], term_wave_speed[sol_pt]);
+          }
+        }
+        const Connectivity::ConstRow nodes = space.connectivity()[elem_idx];
+        for (Uint sol_pt=0; sol_pt<nb_sol_pts; ++sol_pt)
+        {
+          for (Uint eq=0; eq<nb_eqs; ++eq)
+            rhs[nodes[sol_pt]][eq] = elem_rhs[sol_pt][eq];
+          wave_speed[nodes[sol_pt]][0] = elem_wave_speed[sol_pt];
+        }
+      }
+    }
+  }
+}
+
+template <typename PhysicsT>
+void benchmark(const std::string& name)
+{
+  const Uint nb_repeats = 10;
+  const Uint nb_cells = 200;
+
+  Component& root = Core::instance().root();
+  Handle<Mesh> mesh = root.create_component<Mesh>("mesh_"+name);
+  Handle<MeshGenerator> generator = root.create_component<MeshGenerator>("generator_"+name, "cf3.mesh.SimpleMeshGenerator");
+  generator->options().set("mesh", mesh->uri());
+  generator->options().set("nb_cells", std::vector<Uint>(2, nb_cells));
+  generator->options().set("lengths", std::vector<Real>(2, 1.));
+  generator->execute();
+
+  Dictionary& dict = mesh->create_discontinuous_space("solution_space", "cf3.mesh.LagrangeP1");
+  const std::string vars = "q[" + common::to_str(static_cast<Uint>(PhysicsT::NEQS)) + "]";
+  Field& solution = dict.create_field("solution", vars);
+  Field& rhs_element = dict.create_field("rhs_element", vars);
+  Field& rhs_default = dict.create_field("rhs_default", vars);
+  Field& rhs_block = dict.create_field("rhs_block", vars);
+  Field& wave_speed = dict.create_field("wave_speed");
+  for (Uint i=0; i<solution.size(); ++i)
+    for (Uint eq=0; eq<solution.row_size(); ++eq)
+      solution[i][eq] = std::sin(0.1*i + eq);
+
+  // The default add_term_block, calling compute_term for each element, and the fixed size version
+  Handle<ComputeRHS> rhs_computer_default = root.create_component<ComputeRHS>("rhs_default_"+name);
+  Handle<ComputeRHS> rhs_computer_block = root.create_component<ComputeRHS>("rhs_block_"+name);
+  typedef BenchmarkTerm<PhysicsT, false> DefaultTermT;
+  typedef BenchmarkTerm<PhysicsT, true> BlockTermT;
+  Handle<DefaultTermT> convection_default = rhs_computer_default->create_component<DefaultTermT>("convection");
+  Handle<DefaultTermT> damping_default = rhs_computer_default->create_component<DefaultTermT>("damping");
+  Handle<BlockTermT> convection_block = rhs_computer_block->create_component<BlockTermT>("convection");
+  Handle<BlockTermT> damping_block = rhs_computer_block->create_component<BlockTermT>("damping");
+  convection_default->solution = convection_block->solution = solution.handle<Field>();
+  damping_default->solution = damping_block->solution = solution.handle<Field>();
+  convection_default->convection = convection_block->convection = 1.;
+  damping_default->damping = damping_block->damping = 0.1;
+
+  Timer timer;
+  for (Uint r=0; r<nb_repeats; ++r)
+    compute_rhs_per_element(*rhs_computer_default, rhs_element, wave_speed);
+  const Real element_time = timer.elapsed();
+
+  timer.restart();
+  for (Uint r=0; r<nb_repeats; ++r)
+    rhs_computer_default->compute_rhs(rhs_default, wave_speed);
+  const Real default_time = timer.elapsed();
+
+  timer.restart();
+  for (Uint r=0; r<nb_repeats; ++r)
+    rhs_computer_block->compute_rhs(rhs_block, wave_speed);
+  const Real block_time = timer.elapsed();
+
+  Real max_difference = 0.;
+  for (Uint i=0; i<rhs_block.size(); ++i)
+  {
+    for (Uint eq=0; eq<rhs_block.row_size(); ++eq)
+    {
+      max_difference = std::max(max_difference, std::abs(rhs_block[i][eq] - rhs_element[i][eq]));
+      max_difference = std::max(max_difference, std::abs(rhs_default[i][eq] - rhs_element[i][eq]));
+    }
+  }
+  BOOST_CHECK_SMALL(max_difference, 1e-12);
+
+  const Real nb_evaluations = static_cast<Real>(nb_repeats*nb_cells*nb_cells);
+  std::cout << name << ": per element " << nb_evaluations / element_time << " elements/s, "
+            << "default blocks " << nb_evaluations / default_time << " elements/s, "
+            << "fixed size blocks " << nb_evaluations / block_time << " elements/s" << std::endl;
+
+  mesh->parent()->remove_component(*mesh);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( ComputeRHSBenchmarkSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Scalar )
+{
+  benchmark<ScalarPhysics>("Scalar");
+}
+
+BOOST_AUTO_TEST_CASE( LinEuler )
+{
+  benchmark<LinEulerPhysics>("LinEuler");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
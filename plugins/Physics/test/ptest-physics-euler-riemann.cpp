@@ -0,0 +1,132 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Benchmark of the single face and batched Euler 2D Riemann solvers"
+
+#include <cstdlib>
+#include <iostream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "math/Defs.hpp"
+
+#include "cf3/common/Timer.hpp"
+#include "cf3/physics/euler/euler2d/Functions.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::physics::euler;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Random faces, stored both as Data for the single face solvers and per variable for the batched solvers
+struct RiemannFixture
+{
+  typedef void (*BatchT)(const Uint, const Real, const Real*, const Real*, const Real*, Real*, Real*);
+  typedef void (*SingleT)(const euler2d::Data&, const euler2d::Data&, const euler2d::ColVector_NDIM&, euler2d::RowVector_NEQS&, Real&);
+
+  RiemannFixture() :
+    nb_faces(100000),
+    nb_repeats(20),
+    gamma(1.4),
+    pL(nb_faces),
+    pR(nb_faces),
+    normal_vectors(nb_faces),
+    left(euler2d::NEQS*nb_faces),
+    right(euler2d::NEQS*nb_faces),
+    normals(euler2d::NDIM*nb_faces),
+    flux(euler2d::NEQS*nb_faces),
+    wave_speed(nb_faces)
+  {
+    std::srand(1);
+    for (Uint f=0; f<nb_faces; ++f)
+    {
+      euler2d::RowVector_NEQS prim_left, prim_right;
+      prim_left  << 1. + random(), 400.*random() - 200., 400.*random() - 200., 1e5 + 1e4*random();
+      prim_right << 1. + random(), 400.*random() - 200., 400.*random() - 200., 1e5 + 1e4*random();
+      pL[f].gamma=gamma; pL[f].R=287.05; pL[f].compute_from_primitive(prim_left);
+      pR[f].gamma=gamma; pR[f].R=287.05; pR[f].compute_from_primitive(prim_right);
+      normal_vectors[f] << random() - 0.5, random() - 0.5;
+      normal_vectors[f].normalize();
+      for (Uint eq=0; eq<euler2d::NEQS; ++eq)
+      {
+        left[eq*nb_faces+f]  = pL[f].cons[eq];
+        right[eq*nb_faces+f] = pR[f].cons[eq];
+      }
+      normals[f]          = normal_vectors[f][XX];
+      normals[nb_faces+f] = normal_vectors[f][YY];
+    }
+  }
+
+  static Real random() { return static_cast<Real>(std::rand()) / RAND_MAX; }
+
+  void benchmark(const std::string& name, const SingleT single_solver, const BatchT batch_solver)
+  {
+    euler2d::RowVector_NEQS face_flux;
+    Real face_wave_speed;
+    Real checksum = 0.;
+    Timer timer;
+    for (Uint r=0; r<nb_repeats; ++r)
+    {
+      for (Uint f=0; f<nb_faces; ++f)
+      {
+        single_solver(pL[f], pR[f], normal_vectors[f], face_flux, face_wave_speed);
+        checksum += face_wave_speed;
+      }
+    }
+    const Real single_time = timer.elapsed();
+
+    timer.restart();
+    for (Uint r=0; r<nb_repeats; ++r)
+    {
+      batch_solver(nb_faces, gamma, &left[0], &right[0], &normals[0], &flux[0], &wave_speed[0]);
+      checksum -= wave_speed[r];
+    }
+    const Real batch_time = timer.elapsed();
+
+    const Real nb_evaluations = static_cast<Real>(nb_faces*nb_repeats);
+    std::cout << name << ": single face " << nb_evaluations / single_time << " faces/s, batched "
+              << nb_evaluations / batch_time << " faces/s, speedup " << single_time / batch_time
+              << " (checksum " << checksum << ")" << std::endl;
+  }
+
+  const Uint nb_faces;
+  const Uint nb_repeats;
+  const Real gamma;
+
+  std::vector<euler2d::Data, Eigen::aligned_allocator<euler2d::Data> > pL, pR;
+  std::vector<euler2d::ColVector_NDIM, Eigen::aligned_allocator<euler2d::ColVector_NDIM> > normal_vectors;
+
+  std::vector<Real> left, right, normals, flux, wave_speed;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( EulerRiemannBenchmarkSuite, RiemannFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Rusanov )
+{
+  benchmark("Rusanov", static_cast<SingleT>(euler2d::compute_rusanov_flux), static_cast<BatchT>(euler2d::compute_rusanov_flux));
+}
+
+BOOST_AUTO_TEST_CASE( Roe )
+{
+  benchmark("Roe", static_cast<SingleT>(euler2d::compute_roe_flux), static_cast<BatchT>(euler2d::compute_roe_flux));
+}
+
+BOOST_AUTO_TEST_CASE( HLLE )
+{
+  benchmark("HLLE", static_cast<SingleT>(euler2d::compute_hlle_flux), static_cast<BatchT>(euler2d::compute_hlle_flux));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
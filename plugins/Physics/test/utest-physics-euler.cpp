@@ -7,10 +7,12 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Test module for cf3::Euler"
 
+#include <cstdlib>
 #include <iostream>
 #include <boost/test/unit_test.hpp>
 
 #include "math/Defs.hpp"
+#include "math/Consts.hpp"
 
 #include "cf3/common/Log.hpp"
 #include "cf3/common/Core.hpp"
@@ -243,6 +245,67 @@ BOOST_AUTO_TEST_CASE( Test_Euler2D_SymmetryBCs )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/// Compare a batched Riemann solver with the single face version, for faces in all flow regimes
+template<typename BatchT, typename SingleT>
+void check_euler2d_riemann_batch( const BatchT& batch_solver, const SingleT& single_solver )
+{
+  const Real gamma = 1.4;
+  const Real R = 287.05;
+  const Uint n = 64;
+
+  std::vector<Real> left(euler2d::NEQS*n), right(euler2d::NEQS*n), normals(euler2d::NDIM*n);
+  std::vector<euler2d::Data, Eigen::aligned_allocator<euler2d::Data> > pL(n), pR(n);
+  std::srand(2);
+  for (Uint f=0; f<n; ++f)
+  {
+    // Velocities range from supersonic to the left to supersonic to the right
+    const Real angle = 2.*math::Consts::pi()*f/n;
+    const Real u = 1200.*(static_cast<Real>(std::rand())/RAND_MAX - 0.5);
+    const Real v = 100.*(static_cast<Real>(std::rand())/RAND_MAX - 0.5);
+    euler2d::RowVector_NEQS prim_left, prim_right;
+    prim_left  << 1.2 + static_cast<Real>(std::rand())/RAND_MAX, u, v, 101300. + 1e5*static_cast<Real>(std::rand())/RAND_MAX;
+    prim_right << 1.2 + static_cast<Real>(std::rand())/RAND_MAX, u + 50.*(static_cast<Real>(std::rand())/RAND_MAX - 0.5), -v, 101300.;
+
+    pL[f].gamma=gamma; pL[f].R=R; pL[f].compute_from_primitive(prim_left);
+    pR[f].gamma=gamma; pR[f].R=R; pR[f].compute_from_primitive(prim_right);
+    for (Uint eq=0; eq<euler2d::NEQS; ++eq)
+    {
+      left[eq*n+f]  = pL[f].cons[eq];
+      right[eq*n+f] = pR[f].cons[eq];
+    }
+    normals[f]   = std::cos(angle);
+    normals[n+f] = std::sin(angle);
+  }
+
+  std::vector<Real> flux(euler2d::NEQS*n), wave_speed(n);
+  batch_solver(n, gamma, &left[0], &right[0], &normals[0], &flux[0], &wave_speed[0]);
+
+  for (Uint f=0; f<n; ++f)
+  {
+    euler2d::ColVector_NDIM normal; normal << normals[f], normals[n+f];
+    euler2d::RowVector_NEQS single_flux;
+    Real single_wave_speed;
+    single_solver(pL[f], pR[f], normal, single_flux, single_wave_speed);
+
+    const Real tolerance = 1e-12 * single_flux.cwiseAbs().maxCoeff();
+    for (Uint eq=0; eq<euler2d::NEQS; ++eq)
+      BOOST_CHECK_SMALL( flux[eq*n+f] - single_flux[eq], tolerance );
+    BOOST_CHECK_CLOSE( wave_speed[f], single_wave_speed, 1e-10 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Test_Euler2D_riemann_batch )
+{
+  typedef void (*BatchT)(const Uint, const Real, const Real*, const Real*, const Real*, Real*, Real*);
+  typedef void (*SingleT)(const euler2d::Data&, const euler2d::Data&, const euler2d::ColVector_NDIM&, euler2d::RowVector_NEQS&, Real&);
+
+  check_euler2d_riemann_batch( static_cast<BatchT>(euler2d::compute_rusanov_flux), static_cast<SingleT>(euler2d::compute_rusanov_flux) );
+  check_euler2d_riemann_batch( static_cast<BatchT>(euler2d::compute_roe_flux),     static_cast<SingleT>(euler2d::compute_roe_flux) );
+  check_euler2d_riemann_batch( static_cast<BatchT>(euler2d::compute_hlle_flux),    static_cast<SingleT>(euler2d::compute_hlle_flux) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_SUITE_END()
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -40,7 +40,7 @@ print ET.tostring(measurement)
 profiler = Profiler()
 
 # We loop over all available implementations, to test them all
-for lss_name in ['EmptyLSS', 'TrilinosCrs']:
+for lss_name in ['EmptyLSS', 'TrilinosCrs', 'Native']:
   for modelname in ['Proto']:
     # Setup a model
     model = cf.Core.root().create_component(modelname+'Model', 'cf3.solver.Model')
@@ -53,6 +53,8 @@ for lss_name in ['EmptyLSS', 'TrilinosCrs']:
     # Add a solver for the Poisson problem
     poisson_solver = solver.add_direct_solver('cf3.UFEM.demo.Poisson'+modelname)
     poisson_solver.matrix_builder = 'cf3.math.LSS.{name}Matrix'.format(name=lss_name)
+    if lss_name == 'Native':
+      poisson_solver.solution_strategy = 'cf3.math.LSS.NativeStrategy'
 
     # Generate a unit square
     mesh = domain.create_component('Mesh', 'cf3.mesh.Mesh')
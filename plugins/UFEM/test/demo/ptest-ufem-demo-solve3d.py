@@ -0,0 +1,74 @@
+import coolfluid as cf
+import xml.etree.ElementTree as ET
+
+# Global configuration
+cf.env.assertion_throws = False
+cf.env.assertion_backtrace = False
+cf.env.exception_backtrace = False
+cf.env.exception_outputs = False
+cf.env.regist_signal_handlers = False
+cf.env.log_level = 1
+
+n = 16
+
+measurement = ET.Element('DartMeasurement', name = 'Problem size', type = 'numeric/integer')
+measurement.text = str(n)
+print ET.tostring(measurement)
+
+# Compare the linear solver backends on the same Poisson problem: matrix name, strategy builder, strategy configuration
+def configure_trilinos(strategy):
+  strategy.Parameters.linear_solver_type = 'Belos'
+  strategy.Parameters.LinearSolverTypes.Belos.solver_type = 'Block CG'
+  strategy.Parameters.LinearSolverTypes.Belos.SolverTypes.BlockCG.convergence_tolerance = 1e-8
+  strategy.Parameters.preconditioner_type = 'Ifpack'
+
+def configure_native(strategy):
+  strategy.solver = 'CG'
+  strategy.preconditioner = 'BlockJacobi'
+  strategy.tolerance = 1e-8
+
+backends = [('TrilinosCrs', 'cf3.math.LSS.TrilinosStratimikosStrategy', configure_trilinos), ('Native', 'cf3.math.LSS.NativeStrategy', configure_native)]
+
+for (lss_name, strategy_builder, configure) in backends:
+  model = cf.Core.root().create_component('Model' + lss_name, 'cf3.solver.Model')
+  domain = model.create_domain()
+  physics = model.create_physics('cf3.physics.DynamicModel')
+  solver = model.create_solver('cf3.UFEM.Solver')
+  poisson_solver = solver.add_direct_solver('cf3.UFEM.demo.PoissonProto')
+  poisson_solver.matrix_builder = 'cf3.math.LSS.{name}Matrix'.format(name=lss_name)
+  poisson_solver.solution_strategy = strategy_builder
+
+  # Generate a unit cube
+  mesh = domain.create_component('Mesh', 'cf3.mesh.Mesh')
+  mesh_generator = domain.create_component("MeshGenerator","cf3.mesh.SimpleMeshGenerator")
+  mesh_generator.mesh = mesh.uri()
+  mesh_generator.nb_cells = [n,n,n]
+  mesh_generator.lengths = [1.,1.,1.]
+  mesh_generator.offsets = [0.,0.,0.]
+  mesh_generator.execute()
+
+  poisson_solver.regions = [mesh.topology.uri()]
+  configure(poisson_solver.LSS.SolutionStrategy)
+
+  bc = poisson_solver.BoundaryConditions.add_function_bc(region_name = 'left', variable_name = 'u')
+  bc.value = ['1 + x^2 + 2*y^2']
+  bc.regions = [mesh.topology.left.uri(), mesh.topology.right.uri(), mesh.topology.top.uri(), mesh.topology.bottom.uri()]
+
+  ic_f = solver.InitialConditions.create_initial_condition(builder_name = 'cf3.UFEM.InitialConditionConstant', field_tag = 'source_term')
+  ic_f.f = -6.
+  ic_f.regions = [mesh.topology.uri()]
+
+  # Assemble and solve once, then time the solution only
+  model.simulate()
+  for i in range(5):
+    poisson_solver.SolveLSS.execute()
+  model.store_timings()
+
+  try:
+    solve_time = poisson_solver.SolveLSS.properties()["timer_mean"]
+    measurement = ET.Element('DartMeasurement', name = lss_name + ' solve timing', type = 'numeric/double')
+    measurement.text = str(solve_time)
+    print ET.tostring(measurement)
+  except:
+    pass
+  model.delete_component()
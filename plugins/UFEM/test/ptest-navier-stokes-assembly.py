@@ -26,7 +26,7 @@ def make_square(x_segs, y_segs):
   return blocks
 
 class TestCase:
-  def __init__(self, modelname, segments, use_spec):
+  def __init__(self, modelname, segments, use_spec, matrix_builder = 'cf3.math.LSS.TrilinosFEVbrMatrix', scatter_map = False):
     if len(sys.argv) == 2:
       self.nb_procs = int(sys.argv[1])
     else:
@@ -51,6 +51,8 @@ class TestCase:
     self.ns_solver.options().set('use_specializations', use_spec)
     self.ns_solver.options().set('disabled_actions', ['SolveLSS'])
     self.use_spec = use_spec
+    self.matrix_builder = matrix_builder
+    self.scatter_map = scatter_map
 
   def grow_overlap(self):
     if self.nb_procs > 1:
@@ -105,12 +107,16 @@ class TestCase:
   def setup_lss(self):
     self.grow_overlap()
     self.ns_solver.options().set('regions', [self.mesh.access_component('topology').uri()])
-    self.ns_solver.create_lss('cf3.math.LSS.TrilinosFEVbrMatrix')
+    self.ns_solver.create_lss(self.matrix_builder)
+    if self.scatter_map:
+      # The assembly has one proto action per element type
+      for action_name in ['AssemblyTriags', 'AssemblyTetras', 'AssemblyQuads', 'AssemblyHexas', 'AssemblyPrisms']:
+        self.ns_solver.get_child('Assembly').get_child(action_name).options().set('element_scatter_map', True)
 
-  def run(self):
+  def run(self, nb_steps = 1):
     time = self.model.create_time()
     time.options().set('time_step', 1.)
-    time.options().set('end_time', 1.)
+    time.options().set('end_time', float(nb_steps))
     self.model.simulate()
     self.ns_solver.store_timings()
     try:
@@ -165,4 +171,27 @@ test_case.model.delete_component()
 test_case = TestCase('TetrasSpecialized', [20, 10, 10], True)
 test_case.cube_mesh_tetras()
 test_case.run()
-test_case.model.delete_component()
\ No newline at end of file
+test_case.model.delete_component()
+
+# Generic assembly over triangles into a CRS matrix, without and with the cached element scatter map.
+# Several steps are run, so the cost of building the map is amortized as in a real simulation.
+test_case = TestCase('TriagsCrs', [150,100], False, 'cf3.math.LSS.TrilinosCrsMatrix')
+test_case.square_mesh_triags()
+test_case.run(5)
+test_case.model.delete_component()
+
+test_case = TestCase('TriagsCrsScatterMap', [150,100], False, 'cf3.math.LSS.TrilinosCrsMatrix', True)
+test_case.square_mesh_triags()
+test_case.run(5)
+test_case.model.delete_component()
+
+# Same comparison over tetrahedrons
+test_case = TestCase('TetrasCrs', [20, 10, 10], False, 'cf3.math.LSS.TrilinosCrsMatrix')
+test_case.cube_mesh_tetras()
+test_case.run(5)
+test_case.model.delete_component()
+
+test_case = TestCase('TetrasCrsScatterMap', [20, 10, 10], False, 'cf3.math.LSS.TrilinosCrsMatrix', True)
+test_case.cube_mesh_tetras()
+test_case.run(5)
+test_case.model.delete_component()
@@ -0,0 +1,161 @@
+import resource
+import sys
+import coolfluid as cf
+
+# This test compares the implicit Navier-Stokes solve using an assembled matrix with the matrix-free operator, on the driven cavity.
+# Peak memory is only growing, so the matrix-free cases are run first. The solution after the first time step is compared
+# with that of the assembled matrix at the end.
+
+segments = 64
+u_lid = [2., 0.]
+gmres_tolerance = 1e-6
+
+# Solution after the first time step for each case
+first_step_solutions = {}
+
+def make_square(domain, segs):
+  blocks = domain.create_component('blocks', 'cf3.mesh.BlockMesh.BlockArrays')
+  points = blocks.create_points(dimensions = 2, nb_points = 4)
+  points[0]  = [-0.5, -0.5]
+  points[1]  = [0.5, -0.5]
+  points[2]  = [-0.5, 0.5]
+  points[3]  = [0.5, 0.5]
+
+  blocks.create_blocks(1)[0] = [0, 1, 3, 2]
+  blocks.create_block_subdivisions()[0] = [segs, segs]
+  blocks.create_block_gradings()[0] = [1., 1., 1., 1.]
+
+  blocks.create_patch_nb_faces(name = 'left', nb_faces = 1)[0] = [2, 0]
+  blocks.create_patch_nb_faces(name = 'right', nb_faces = 1)[0] = [1, 3]
+  blocks.create_patch_nb_faces(name = 'top', nb_faces = 1)[0] = [3, 2]
+  blocks.create_patch_nb_faces(name = 'bottom', nb_faces = 1)[0] = [0, 1]
+
+  blocks.partition_blocks(nb_partitions = cf.Core.nb_procs(), direction = 0)
+
+  mesh = domain.create_component('Mesh', 'cf3.mesh.Mesh')
+  blocks.create_mesh(mesh.uri())
+
+  create_point_region = domain.create_component('CreatePointRegion', 'cf3.mesh.actions.AddPointRegion')
+  create_point_region.coordinates = [0., 0.]
+  create_point_region.region_name = 'center'
+  create_point_region.mesh = mesh
+  create_point_region.execute()
+
+  return mesh
+
+class TestCase:
+  def __init__(self, modelname, matrix_builder, preconditioner_builder = '', preconditioner_sparsity = 'Diagonal'):
+    self.model = cf.Core.root().create_component(modelname, 'cf3.solver.ModelUnsteady')
+    self.domain = self.model.create_domain()
+    self.physics = self.model.create_physics('cf3.UFEM.NavierStokesPhysics')
+    self.solver = self.model.create_solver('cf3.UFEM.Solver')
+
+    self.physics.options().set('density', 1000.)
+    self.physics.options().set('dynamic_viscosity', 10.)
+
+    self.ns_solver = self.solver.add_unsteady_solver('cf3.UFEM.NavierStokes')
+    self.mesh = make_square(self.domain, segments)
+    self.ns_solver.regions = [self.mesh.topology.interior.uri()]
+    self.ns_solver.options.matrix_builder = matrix_builder
+
+    bc = self.ns_solver.BoundaryConditions
+    bc.regions = [self.mesh.topology.uri()]
+    bc.add_constant_bc(region_name = 'top', variable_name = 'Velocity').value = u_lid
+    bc.add_constant_bc(region_name = 'bottom', variable_name = 'Velocity').value = [0., 0.]
+    bc.add_constant_bc(region_name = 'left', variable_name = 'Velocity').value = [0., 0.]
+    bc.add_constant_bc(region_name = 'right', variable_name = 'Velocity').value = [0., 0.]
+    bc.add_constant_bc(region_name = 'center', variable_name = 'Pressure').value = 0.
+
+    lss = self.ns_solver.LSS
+    lss.SolutionStrategy.print_settings = False
+    lss.SolutionStrategy.Parameters.LinearSolverTypes.Belos.SolverTypes.BlockGMRES.convergence_tolerance = gmres_tolerance
+    lss.SolutionStrategy.Parameters.LinearSolverTypes.Belos.SolverTypes.BlockGMRES.maximum_iterations = 2000
+    if matrix_builder == 'cf3.math.LSS.TrilinosMatrixFreeOperator':
+      # The operator is applied by executing the assembly again
+      lss.Matrix.options.operator_action = self.ns_solver.Assembly
+      lss.Matrix.options.preconditioner_sparsity = preconditioner_sparsity
+      lss.Matrix.options.preconditioner_matrix_builder = preconditioner_builder
+      if preconditioner_builder == '':
+        lss.SolutionStrategy.Parameters.preconditioner_type = 'None'
+      else:
+        lss.SolutionStrategy.Parameters.preconditioner_type = 'Ifpack'
+    else:
+      lss.SolutionStrategy.Parameters.preconditioner_type = 'Ifpack'
+
+  def run(self):
+    time = self.model.create_time()
+    time.options().set('time_step', 0.01)
+
+    # First time step, stored for the comparison
+    time.options().set('end_time', 0.01)
+    self.model.simulate()
+    solution = self.mesh.geometry.navier_stokes_solution
+    first_step_solutions[self.model.name()] = [[value for value in row] for row in solution]
+
+    self.solver.options().set('disabled_actions', ['InitialConditions'])
+    time.options().set('end_time', 0.05)
+    self.model.simulate()
+    self.ns_solver.store_timings()
+
+    # With the matrix-free operator, the assembly is also executed for each operator application. That time is
+    # subtracted, so the assembly time covers only the assembly of the RHS and preconditioner once per time step.
+    name = self.model.name()
+    assembly = self.ns_solver.Assembly.properties()
+    nb_assemblies = assembly['timer_count']
+    assembly_total = assembly['timer_mean'] * nb_assemblies
+    matrix = self.ns_solver.LSS.Matrix
+    if matrix.derived_type_name() == 'cf3.math.LSS.TrilinosMatrixFreeOperator':
+      nb_applications = matrix.properties()['nb_applications']
+      application_time = matrix.properties()['application_time']
+      assembly_total -= application_time
+      nb_assemblies -= nb_applications
+      print '<DartMeasurement name=\"' + name + ' operator application time\" type=\"numeric/double\">' + str(application_time / nb_applications) + '</DartMeasurement>'
+      print '<DartMeasurement name=\"' + name + ' operator applications\" type=\"numeric/double\">' + str(nb_applications) + '</DartMeasurement>'
+    print '<DartMeasurement name=\"' + name + ' solve time\" type=\"numeric/double\">' + str(self.ns_solver.SolveLSS.properties()['timer_mean']) + '</DartMeasurement>'
+    print '<DartMeasurement name=\"' + name + ' assembly time\" type=\"numeric/double\">' + str(assembly_total / nb_assemblies) + '</DartMeasurement>'
+    print '<DartMeasurement name=\"' + name + ' peak memory (kB)\" type=\"numeric/double\">' + str(resource.getrusage(resource.RUSAGE_SELF).ru_maxrss) + '</DartMeasurement>'
+
+def check_first_step(name, reference_name):
+    """ Compare the first time step solution with the reference, for each variable relative to its largest value """
+    solution = first_step_solutions[name]
+    reference = first_step_solutions[reference_name]
+    if len(solution) != len(reference):
+      raise Exception(name + ' has ' + str(len(solution)) + ' nodes, but ' + reference_name + ' has ' + str(len(reference)))
+    # The linear solves converge to gmres_tolerance, so the solutions differ by about that relative amount
+    tolerance = 100. * gmres_tolerance
+    for var in range(len(reference[0])):
+      scale = max([abs(row[var]) for row in reference])
+      difference = max([abs(row[var] - ref_row[var]) for (row, ref_row) in zip(solution, reference)])
+      print name + ': maximum difference in column ' + str(var) + ' is ' + str(difference) + ', for a maximum value of ' + str(scale)
+      if difference > tolerance * scale:
+        raise Exception('Solution of ' + name + ' in column ' + str(var) + ' differs by ' + str(difference) + ' from ' + reference_name)
+
+# Some shortcuts
+root = cf.Core.root()
+env = cf.Core.environment()
+
+## Global configuration
+env.options().set('assertion_throws', False)
+env.options().set('assertion_backtrace', False)
+env.options().set('exception_backtrace', False)
+env.options().set('regist_signal_handlers', False)
+env.options().set('log_level', 0)
+
+test_case = TestCase('MatrixFree', 'cf3.math.LSS.TrilinosMatrixFreeOperator')
+test_case.run()
+test_case.model.delete_component()
+
+test_case = TestCase('MatrixFreeDiagonalPreconditioner', 'cf3.math.LSS.TrilinosMatrixFreeOperator', 'cf3.math.LSS.TrilinosCrsMatrix', 'Diagonal')
+test_case.run()
+test_case.model.delete_component()
+
+test_case = TestCase('MatrixFreeFullPreconditioner', 'cf3.math.LSS.TrilinosMatrixFreeOperator', 'cf3.math.LSS.TrilinosCrsMatrix', 'Full')
+test_case.run()
+test_case.model.delete_component()
+
+test_case = TestCase('Assembled', 'cf3.math.LSS.TrilinosCrsMatrix')
+test_case.run()
+test_case.model.delete_component()
+
+for name in ['MatrixFree', 'MatrixFreeDiagonalPreconditioner', 'MatrixFreeFullPreconditioner']:
+  check_first_step(name, 'Assembled')
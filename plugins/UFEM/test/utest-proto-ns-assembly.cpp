@@ -19,6 +19,7 @@
 #include "common/Environment.hpp"
 #include "common/Group.hpp"
 
+#include "mesh/Connectivity.hpp"
 #include "mesh/Domain.hpp"
 #include "mesh/LagrangeP1/Triag2D.hpp"
 #include "mesh/LagrangeP1/Tetra3D.hpp"
@@ -102,6 +103,165 @@ struct NavierStokesAssemblyFixture
     check_close(generic_result, spec_result, eps);
   }
 
+  /// Compare the system matrix assembled one element at a time with the matrix assembled using element batches
+  template<Uint Dim, typename ExprT>
+  void compare_batching(const boost::shared_ptr<Mesh>& mesh, const ExprT& initial_condition_expression, const bool use_specializations)
+  {
+    boost::shared_ptr<common::Group> root = allocate_component<Group>("Root");
+    Handle<ModelUnsteady> model = root->create_component<ModelUnsteady>("NavierStokes");
+    Domain& domain = model->create_domain("Domain");
+    physics::PhysModel& physical_model = model->create_physics("cf3.UFEM.NavierStokesPhysics");
+
+    Handle<UFEM::Solver> solver(model->create_solver("cf3.UFEM.Solver").handle());
+    Handle<InitialConditions> ic = solver->create_initial_conditions();
+    Handle<UFEM::LSSActionUnsteady> lss_action(solver->add_unsteady_solver("cf3.UFEM.NavierStokes"));
+
+    physical_model.options().set("density", 1.);
+    physical_model.options().set("dynamic_viscosity", 1.);
+
+    Time& time = model->create_time();
+    time.options().set("time_step", 1.);
+
+    ic->remove_component(lss_action->solution_tag());
+
+    domain.add_component(mesh);
+    mesh->raise_mesh_loaded();
+
+    solver->configure_option_recursively("regions", std::vector<URI>(1, mesh->topology().uri()));
+    cf3::math::LSS::System& lss = lss_action->create_lss();
+
+    const std::vector<std::string> disabled_actions = boost::assign::list_of("BoundaryConditions")("SolveLSS")("Update");
+    lss_action->options().set("disabled_actions", disabled_actions);
+
+    lss_action->options().set("use_specializations", use_specializations);
+    time.options().set("end_time", 1.);
+    solver->create_fields();
+    for_each_node<Dim>(mesh->topology(), initial_condition_expression);
+    model->simulate();
+    const RealMatrix scalar_result = system_matrix(lss);
+
+    solver->configure_option_recursively("element_batching", true);
+    time.options().set("end_time", 2.);
+    model->simulate();
+    const RealMatrix batched_result = system_matrix(lss);
+
+    // The batched Jacobians are computed with different rounding, so entries that vanish are compared with the largest entry
+    const Real tolerance = 1e-12 * scalar_result.array().abs().maxCoeff();
+    BOOST_CHECK_SMALL((batched_result - scalar_result).array().abs().maxCoeff(), tolerance);
+  }
+
+  RealMatrix system_matrix(cf3::math::LSS::System& lss)
+  {
+    const Uint matsize = lss.matrix()->blockcol_size()*lss.matrix()->neq();
+    RealMatrix result(matsize, matsize);
+    for(Uint i = 0; i != matsize; ++i)
+      for(Uint j = 0; j != matsize; ++j)
+        lss.matrix()->get_value(i, j, result(i,j));
+    return result;
+  }
+
+  /// Square of n by n cells, each split into two triangles. The interior nodes are moved, so the triangles differ from each other.
+  boost::shared_ptr<Mesh> create_triangles(const Uint n)
+  {
+    boost::shared_ptr<Mesh> mesh_ptr = allocate_component<Mesh>("mesh");
+    Mesh& mesh = *mesh_ptr;
+    const Uint nb_nodes_1d = n+1;
+    mesh.initialize_nodes(nb_nodes_1d*nb_nodes_1d, 2);
+    Dictionary& geometry_dict = mesh.geometry_fields();
+    Field& coords = geometry_dict.coordinates();
+    for(Uint j = 0; j != nb_nodes_1d; ++j)
+    {
+      for(Uint i = 0; i != nb_nodes_1d; ++i)
+      {
+        const Uint node = j*nb_nodes_1d + i;
+        const bool interior = i != 0 && j != 0 && i != n && j != n;
+        coords[node][XX] = (static_cast<Real>(i) + (interior ? 0.05*static_cast<Real>((3*i + j) % 4) : 0.)) / static_cast<Real>(n);
+        coords[node][YY] = (static_cast<Real>(j) + (interior ? 0.05*static_cast<Real>((i + 2*j) % 3) : 0.)) / static_cast<Real>(n);
+        geometry_dict.glb_idx()[node] = node;
+        geometry_dict.rank()[node] = 0;
+      }
+    }
+
+    Elements& cells = mesh.topology().create_region("cells").create_elements("cf3.mesh.LagrangeP1.Triag2D", geometry_dict);
+    cells.resize(2*n*n);
+    Connectivity& connectivity = cells.geometry_space().connectivity();
+    for(Uint j = 0; j != n; ++j)
+    {
+      for(Uint i = 0; i != n; ++i)
+      {
+        const Uint corner = j*nb_nodes_1d + i;
+        const Uint element = 2*(j*n + i);
+        connectivity[element][0] = corner;
+        connectivity[element][1] = corner + 1;
+        connectivity[element][2] = corner + nb_nodes_1d + 1;
+        connectivity[element+1][0] = corner;
+        connectivity[element+1][1] = corner + nb_nodes_1d + 1;
+        connectivity[element+1][2] = corner + nb_nodes_1d;
+        cells.glb_idx()[element] = element;
+        cells.glb_idx()[element+1] = element+1;
+        cells.rank()[element] = 0;
+        cells.rank()[element+1] = 0;
+      }
+    }
+
+    return mesh_ptr;
+  }
+
+  /// Cube of n by n by n cells, each split into 6 tetrahedra along the same diagonal
+  boost::shared_ptr<Mesh> create_tetras(const Uint n)
+  {
+    boost::shared_ptr<Mesh> mesh_ptr = allocate_component<Mesh>("mesh");
+    Mesh& mesh = *mesh_ptr;
+    const Uint nb_nodes_1d = n+1;
+    mesh.initialize_nodes(nb_nodes_1d*nb_nodes_1d*nb_nodes_1d, 3);
+    Dictionary& geometry_dict = mesh.geometry_fields();
+    Field& coords = geometry_dict.coordinates();
+    for(Uint k = 0; k != nb_nodes_1d; ++k)
+    {
+      for(Uint j = 0; j != nb_nodes_1d; ++j)
+      {
+        for(Uint i = 0; i != nb_nodes_1d; ++i)
+        {
+          const Uint node = (k*nb_nodes_1d + j)*nb_nodes_1d + i;
+          coords[node][XX] = static_cast<Real>(i) / static_cast<Real>(n);
+          coords[node][YY] = static_cast<Real>(j) / static_cast<Real>(n);
+          coords[node][ZZ] = (static_cast<Real>(k) + 0.1*static_cast<Real>(i)) / static_cast<Real>(n);
+          geometry_dict.glb_idx()[node] = node;
+          geometry_dict.rank()[node] = 0;
+        }
+      }
+    }
+
+    // Corners of a cube are numbered with the bits x=1, y=2, z=4
+    const Uint tetras[6][4] = {{0,1,3,7}, {0,5,1,7}, {0,3,2,7}, {0,2,6,7}, {0,4,5,7}, {0,6,4,7}};
+    Elements& cells = mesh.topology().create_region("cells").create_elements("cf3.mesh.LagrangeP1.Tetra3D", geometry_dict);
+    cells.resize(6*n*n*n);
+    Connectivity& connectivity = cells.geometry_space().connectivity();
+    Uint element = 0;
+    for(Uint k = 0; k != n; ++k)
+    {
+      for(Uint j = 0; j != n; ++j)
+      {
+        for(Uint i = 0; i != n; ++i)
+        {
+          for(Uint t = 0; t != 6; ++t)
+          {
+            for(Uint c = 0; c != 4; ++c)
+            {
+              const Uint corner = tetras[t][c];
+              connectivity[element][c] = ((k + (corner>>2 & 1))*nb_nodes_1d + j + (corner>>1 & 1))*nb_nodes_1d + i + (corner & 1);
+            }
+            cells.glb_idx()[element] = element;
+            cells.rank()[element] = 0;
+            ++element;
+          }
+        }
+      }
+    }
+
+    return mesh_ptr;
+  }
+
   boost::shared_ptr<Mesh> create_triangle(const RealVector2& a, const RealVector2& b, const RealVector2& c)
   {
     // coordinates
@@ -202,4 +362,21 @@ BOOST_AUTO_TEST_CASE( GenericTetraVortex )
   //run_model<3>(create_tetra(RealVector3(100.2, 100.1, 99.9), RealVector3(100.75, 99.9, 100.05), RealVector3(100.33, 100.83, 100.23), RealVector3(100.1, 99.9, 100.67)), u = n_op*coordinates / (coordinates[0]*coordinates[0] + coordinates[1]*coordinates[1]), 5.);
 }
 
+// The ns_implementation assemblies over triangles and tetrahedra, with and without element batches
+BOOST_AUTO_TEST_CASE( BatchedTriangles )
+{
+  RealMatrix2 n_op; n_op << 0., 1., -1., 0.;
+  FieldVariable<0, VectorField> u("Velocity", "navier_stokes_solution");
+  compare_batching<2>(create_triangles(4), u = n_op*coordinates, false);
+  compare_batching<2>(create_triangles(4), u = n_op*coordinates, true);
+}
+
+BOOST_AUTO_TEST_CASE( BatchedTetras )
+{
+  RealMatrix3 n_op; n_op << 0., 1., 0., -1., 0., 0., 0., 0., 0.;
+  FieldVariable<0, VectorField> u("Velocity", "navier_stokes_solution");
+  compare_batching<3>(create_tetras(2), u = n_op*coordinates, false);
+  compare_batching<3>(create_tetras(2), u = n_op*coordinates, true);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
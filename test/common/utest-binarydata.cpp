@@ -20,6 +20,7 @@
 #include "common/Core.hpp"
 #include "common/List.hpp"
 #include "common/OptionList.hpp"
+#include "common/OutputThread.hpp"
 #include "common/Table.hpp"
 
 #include "common/PE/Comm.hpp"
@@ -173,6 +174,78 @@ BOOST_AUTO_TEST_CASE( ReadBinaryData )
   BOOST_CHECK_EQUAL(empty_real_table.row_size(), 8);
 }
 
+BOOST_AUTO_TEST_CASE( AsynchronousWrite )
+{
+  common::Component& group = *common::Core::instance().root().create_component("AsyncGroup", "cf3.common.Group");
+
+  common::Table<Real>& real_table = *group.create_component< common::Table<Real> >("RealTable");
+  real_table.set_row_size(real_table_cols);
+  real_table.resize(real_table_size);
+  fill_table(real_table);
+  const common::Table<Real>::ArrayT reference = real_table.array();
+
+  common::BinaryDataWriter& writer = *group.create_component<common::BinaryDataWriter>("Writer");
+  writer.options().set("asynchronous", true);
+  writer.options().set("file", common::URI("binary_data_async.cfbinxml"));
+  writer.append_data(real_table);
+  writer.close();
+
+  // The writer works on a copy, so the data can be changed right away
+  fill_table(real_table);
+
+  common::OutputThread::instance().flush();
+
+  common::BinaryDataReader& reader = *group.create_component<common::BinaryDataReader>("Reader");
+  reader.options().set("file", common::URI("binary_data_async.cfbinxml"));
+  common::Table<Real>& read_real_table = *group.create_component< common::Table<Real> >("ReadRealTable");
+  reader.read_table(read_real_table, 0);
+  BOOST_CHECK(read_real_table.array() == reference);
+}
+
+BOOST_AUTO_TEST_CASE( ColumnMajorTable )
+{
+  common::Component& group = *common::Core::instance().root().create_component("ColumnMajorGroup", "cf3.common.Group");
+
+  common::Table<Real>& real_table = *group.create_component< common::Table<Real> >("RealTable");
+  real_table.set_row_size(real_table_cols);
+  real_table.resize(real_table_size);
+  fill_table(real_table);
+  const common::Table<Real>::ArrayT reference = real_table.array();
+
+  // Changing the layout keeps the values, and the columns become contiguous
+  real_table.set_column_major(true);
+  BOOST_CHECK(real_table.is_column_major());
+  BOOST_CHECK(real_table.array() == reference);
+  BOOST_CHECK_EQUAL(real_table.array().strides()[0], 1);
+  BOOST_CHECK_EQUAL(real_table.array().data()[1], reference[1][0]);
+  BOOST_CHECK_EQUAL(real_table.array().data()[real_table_size], reference[0][1]);
+
+  // Resizing keeps the layout
+  real_table.resize(real_table_size+1);
+  BOOST_CHECK(real_table.is_column_major());
+  BOOST_CHECK_EQUAL(real_table[real_table_size-1][real_table_cols-1], reference[real_table_size-1][real_table_cols-1]);
+  real_table.resize(real_table_size);
+
+  common::BinaryDataWriter& writer = *group.create_component<common::BinaryDataWriter>("Writer");
+  writer.options().set("file", common::URI("binary_data_column_major.cfbinxml"));
+  writer.append_data(real_table);
+  writer.close();
+
+  // Read back into a row-major and a column-major table
+  common::BinaryDataReader& reader = *group.create_component<common::BinaryDataReader>("Reader");
+  reader.options().set("file", common::URI("binary_data_column_major.cfbinxml"));
+  common::Table<Real>& row_major_table = *group.create_component< common::Table<Real> >("RowMajorTable");
+  reader.read_table(row_major_table, 0);
+  BOOST_CHECK(!row_major_table.is_column_major());
+  BOOST_CHECK(row_major_table.array() == reference);
+
+  common::Table<Real>& column_major_table = *group.create_component< common::Table<Real> >("ColumnMajorTable");
+  column_major_table.set_column_major(true);
+  reader.read_table(column_major_table, 0);
+  BOOST_CHECK(column_major_table.is_column_major());
+  BOOST_CHECK(column_major_table.array() == reference);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_SUITE_END()
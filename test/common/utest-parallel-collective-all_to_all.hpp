@@ -452,6 +452,26 @@ BOOST_AUTO_TEST_CASE( all_to_all_vector_variable )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( sparse_all_to_all_vector_vector )
+{
+  int i;
+
+  // each process only sends to the next one, irank+1 values
+  const int next=(irank+1)%nproc;
+  const int prev=(irank+nproc-1)%nproc;
+  std::vector< std::vector<double> > snd(nproc);
+  for (i=0; i<irank+1; i++) snd[next].push_back(100.*irank+i);
+
+  std::vector< std::vector<double> > rcv;
+  PE::Comm::instance().sparse_all_to_all(snd, rcv);
+  BOOST_CHECK_EQUAL( (int)rcv.size() , nproc );
+  for (i=0; i<nproc; i++) if (i!=prev) BOOST_CHECK_EQUAL( (int)rcv[i].size() , 0 );
+  BOOST_CHECK_EQUAL( (int)rcv[prev].size() , prev+1 );
+  for (i=0; i<(int)rcv[prev].size(); i++) BOOST_CHECK_EQUAL( rcv[prev][i] , 100.*prev+i );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_SUITE_END()
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,159 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the tracing of code regions"
+
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/OptionList.hpp"
+#include "common/ThreadPool.hpp"
+#include "common/Trace.hpp"
+
+#include "common/PE/Comm.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Records a region for each thread
+void trace_task(const Uint, const Uint, boost::barrier&)
+{
+  TraceRegion trace("thread", "test");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( TraceSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init_mpi )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+}
+
+BOOST_AUTO_TEST_CASE( Disabled )
+{
+  Tracer& tracer = Tracer::instance();
+  BOOST_CHECK(!tracer.enabled());
+  {
+    TraceRegion trace("disabled");
+  }
+  BOOST_CHECK(tracer.events().empty());
+}
+
+BOOST_AUTO_TEST_CASE( Nested )
+{
+  Tracer& tracer = Tracer::instance();
+  Core::instance().environment().options().set("trace", true);
+  BOOST_CHECK(tracer.enabled());
+
+  {
+    TraceRegion outer("outer", "test");
+    TraceRegion inner(std::string("inner"), "test");
+  }
+
+  // Events are recorded when they finish, so the inner region comes first
+  const std::vector< std::pair<Tracer::Event, Uint> > events = tracer.events();
+  BOOST_REQUIRE_EQUAL(events.size(), 2u);
+  BOOST_CHECK_EQUAL(std::string(events[0].first.name), "inner");
+  BOOST_CHECK_EQUAL(std::string(events[1].first.name), "outer");
+  BOOST_CHECK(events[1].first.begin <= events[0].first.begin);
+  BOOST_CHECK(events[0].first.end <= events[1].first.end);
+  BOOST_CHECK_EQUAL(events[0].second, events[1].second);
+
+  tracer.clear();
+  BOOST_CHECK(tracer.events().empty());
+}
+
+BOOST_AUTO_TEST_CASE( RingBuffer )
+{
+  Tracer& tracer = Tracer::instance();
+  Core::instance().environment().options().set("trace_buffer_size", 4u);
+
+  const char* names[] = {"a", "b", "c", "d", "e", "f"};
+  for(Uint i = 0; i != 6; ++i)
+    TraceRegion trace(names[i], "test");
+
+  // Only the last 4 events are kept
+  const std::vector< std::pair<Tracer::Event, Uint> > events = tracer.events();
+  BOOST_REQUIRE_EQUAL(events.size(), 4u);
+  for(Uint i = 0; i != 4; ++i)
+    BOOST_CHECK_EQUAL(std::string(events[i].first.name), names[i+2]);
+
+  // The summary still includes the overwritten events
+  BOOST_CHECK(tracer.summary().find("\na ") != std::string::npos);
+
+  Core::instance().environment().options().set("trace_buffer_size", 100000u);
+  BOOST_CHECK(tracer.events().empty());
+}
+
+BOOST_AUTO_TEST_CASE( Threads )
+{
+  Tracer& tracer = Tracer::instance();
+  ThreadPool::instance().run(4, &trace_task);
+
+  // One event for each thread, each with a different thread index
+  const std::vector< std::pair<Tracer::Event, Uint> > events = tracer.events();
+  BOOST_REQUIRE_EQUAL(events.size(), 4u);
+  std::set<Uint> threads;
+  for(Uint i = 0; i != events.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(std::string(events[i].first.name), "thread");
+    threads.insert(events[i].second);
+  }
+  BOOST_CHECK_EQUAL(threads.size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE( Output )
+{
+  Tracer& tracer = Tracer::instance();
+  const Uint rank = PE::Comm::instance().rank();
+
+  // Rank 1 gets a slower region, so the maximum differs from the average
+  {
+    TraceRegion trace("output \"quoted\"", "test");
+    if(rank == 1)
+      boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+  }
+
+  std::vector<std::string> args;
+  args.push_back("file:string=utest-trace");
+  Core::instance().environment().call_signal("write_trace", args);
+
+  std::ifstream json(("utest-trace-P" + to_str(rank) + ".json").c_str());
+  std::stringstream json_contents;
+  json_contents << json.rdbuf();
+  BOOST_CHECK(json_contents.str().find("\"traceEvents\"") != std::string::npos);
+  BOOST_CHECK(json_contents.str().find("\"name\":\"output \\\"quoted\\\"\",\"cat\":\"test\",\"ph\":\"X\"") != std::string::npos);
+
+  const std::string summary = tracer.summary();
+  BOOST_CHECK(summary.find("output \"quoted\"") != std::string::npos);
+  BOOST_CHECK(summary.find("thread") != std::string::npos);
+
+  Core::instance().environment().options().set("trace", false);
+  tracer.clear();
+}
+
+BOOST_AUTO_TEST_CASE( finalize_mpi )
+{
+  PE::Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
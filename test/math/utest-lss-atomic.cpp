@@ -321,6 +321,39 @@ BOOST_AUTO_TEST_CASE( test_matrix_only )
         }
   }
 
+  // batched access gives the same result as performant access, also for blocks with non-owned rows
+  mat->reset();
+  if (irank==1)
+  {
+    LSS::BlockAccumulator ba1, ba2;
+    ba1.resize(3,neq);
+    ba2.resize(3,neq);
+    ba1.indices[0]=5; ba1.indices[1]=2; ba1.indices[2]=8;
+    ba2.indices[0]=3; ba2.indices[1]=2; ba2.indices[2]=7;
+    std::vector<Uint> batch_indices;
+    batch_indices += 5,2,8,3,2,7;
+    std::vector<Real> batch_values(2*ba1.mat.size());
+    for (int i=0; i<(const int)batch_values.size(); i++) batch_values[i]=i+1.;
+    std::copy(batch_values.begin(), batch_values.begin()+ba1.mat.size(), ba1.mat.data());
+    std::copy(batch_values.begin()+ba1.mat.size(), batch_values.end(), ba2.mat.data());
+
+    mat->reset();
+    mat->add_values(ba1);
+    mat->add_values(ba2);
+    mat->add_values(ba2);
+    std::vector<Real> ref_vals;
+    mat->debug_data(rows,cols,ref_vals);
+
+    mat->reset();
+    boost::shared_ptr<LSS::BlockBatch> batch = mat->create_batch(3, batch_indices);
+    BOOST_CHECK_EQUAL(batch->nb_blocks(),2);
+    mat->add_values_batch(*batch, 0, 2, &batch_values[0]);
+    mat->add_values_batch(*batch, 1, 2, &batch_values[ba1.mat.size()]);
+    mat->debug_data(rows,cols,vals);
+    BOOST_CHECK_EQUAL(vals.size(),ref_vals.size());
+    for (int i=0; i<(const int)vals.size(); i++) BOOST_CHECK_EQUAL(vals[i],ref_vals[i]);
+  }
+
   // bc-related: dirichlet-condition
   mat->reset(-1.);
   if (irank==0)
@@ -0,0 +1,258 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the native linear solver"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "common/PE/CommWrapper.hpp"
+
+#include "math/LSS/System.hpp"
+#include "math/LSS/Native/NativeMatrix.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::common::PE;
+using namespace cf3::math;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct NativeLSSFixture
+{
+  NativeLSSFixture() :
+    nb_owned(20),
+    neq(2)
+  {
+    irank = Comm::instance().is_active() ? Comm::instance().rank() : 0;
+    nproc = Comm::instance().is_active() ? Comm::instance().size() : 1;
+    nb_global = nb_owned*nproc;
+  }
+
+  /// 1D chain of nodes, split in consecutive parts over the processes. Ghost nodes are added at the end of the local numbering.
+  void build_chain(CommPattern& cp, std::vector<Uint>& node_connectivity, std::vector<Uint>& starting_indices)
+  {
+    gid.clear();
+    ranks.clear();
+    for(Uint i = 0; i != nb_owned; ++i)
+    {
+      gid.push_back(irank*nb_owned + i);
+      ranks.push_back(irank);
+    }
+    if(irank != 0)
+    {
+      gid.push_back(irank*nb_owned - 1);
+      ranks.push_back(irank-1);
+    }
+    if(irank != nproc-1)
+    {
+      gid.push_back((irank+1)*nb_owned);
+      ranks.push_back(irank+1);
+    }
+
+    cp.insert("gid", gid, 1, false);
+    cp.setup(Handle<CommWrapper>(cp.get_child("gid")), ranks);
+
+    node_connectivity.clear();
+    starting_indices.assign(1, 0);
+    for(Uint i = 0; i != gid.size(); ++i)
+    {
+      for(Uint j = 0; j != gid.size(); ++j)
+      {
+        if(gid[i] == gid[j] || gid[i] == gid[j]+1 || gid[i]+1 == gid[j])
+          node_connectivity.push_back(j);
+      }
+      starting_indices.push_back(node_connectivity.size());
+    }
+  }
+
+  /// Assemble two decoupled Laplace equations with different diffusion coefficients, with dirichlet conditions on both ends
+  void assemble(LSS::System& lss)
+  {
+    lss.reset();
+    LSS::BlockAccumulator acc;
+    acc.resize(2, neq);
+    for(Uint i = 0; i != gid.size(); ++i)
+    {
+      for(Uint j = 0; j != gid.size(); ++j)
+      {
+        if(gid[j] != gid[i]+1)
+          continue;
+        acc.reset();
+        acc.indices[0] = i;
+        acc.indices[1] = j;
+        for(Uint eq = 0; eq != neq; ++eq)
+        {
+          const Real coefficient = eq == 0 ? 1. : 3.;
+          acc.mat(eq, eq) = coefficient;
+          acc.mat(neq+eq, neq+eq) = coefficient;
+          acc.mat(eq, neq+eq) = -coefficient;
+          acc.mat(neq+eq, eq) = -coefficient;
+        }
+        lss.add_values(acc);
+      }
+    }
+
+    for(Uint i = 0; i != gid.size(); ++i)
+    {
+      if(ranks[i] != irank)
+        continue;
+      if(gid[i] == 0)
+      {
+        lss.dirichlet(i, 0, 1., true);
+        lss.dirichlet(i, 1, -1., true);
+      }
+      if(gid[i] == nb_global-1)
+      {
+        lss.dirichlet(i, 0, 2., true);
+        lss.dirichlet(i, 1, 5., true);
+      }
+    }
+  }
+
+  /// The solution is linear along the chain
+  void check_solution(LSS::System& lss)
+  {
+    for(Uint i = 0; i != gid.size(); ++i)
+    {
+      const Real x = static_cast<Real>(gid[i]) / static_cast<Real>(nb_global-1);
+      Real value;
+      lss.solution()->get_value(i, 0, value);
+      BOOST_CHECK_SMALL(value - (1. + x), 1e-6);
+      lss.solution()->get_value(i, 1, value);
+      BOOST_CHECK_SMALL(value - (-1. + 6.*x), 1e-6);
+    }
+  }
+
+  Uint irank;
+  Uint nproc;
+  const Uint nb_owned;
+  Uint nb_global;
+  const Uint neq;
+  std::vector<Uint> gid;
+  std::vector<Uint> ranks;
+};
+
+BOOST_FIXTURE_TEST_SUITE( NativeLSSSuite, NativeLSSFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( InitMPI )
+{
+  Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  Core::instance().environment().options().set("log_level", 3u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Structure )
+{
+  Component& root = Core::instance().root();
+  CommPattern& cp = *root.create_component<CommPattern>("structure_commpattern");
+  std::vector<Uint> node_connectivity, starting_indices;
+  build_chain(cp, node_connectivity, starting_indices);
+
+  Handle<LSS::System> lss = root.create_component<LSS::System>("structure_lss");
+  lss->options().set("matrix_builder", std::string("cf3.math.LSS.NativeMatrix"));
+  lss->options().set("solution_strategy", std::string("cf3.math.LSS.NativeStrategy"));
+  lss->create(cp, neq, node_connectivity, starting_indices);
+
+  BOOST_CHECK_EQUAL(lss->solvertype(), "Native");
+  BOOST_CHECK_EQUAL(lss->matrix()->blockrow_size(), nb_owned);
+  BOOST_CHECK_EQUAL(lss->matrix()->blockcol_size(), gid.size());
+  BOOST_CHECK_EQUAL(lss->rhs()->blockrow_size(), gid.size());
+
+  // Only owned rows are stored
+  Handle<LSS::NativeMatrix> matrix(lss->matrix());
+  BOOST_CHECK(is_not_null(matrix));
+  for(Uint i = 0; i != gid.size(); ++i)
+    BOOST_CHECK_EQUAL(matrix->row_starts()[i+1] != matrix->row_starts()[i], ranks[i] == irank);
+
+  // y = A*x with a constant x is zero inside the domain
+  assemble(*lss);
+  lss->solution()->reset(1.);
+  lss->matrix()->apply(lss->rhs(), lss->solution());
+  for(Uint i = 0; i != nb_owned; ++i)
+  {
+    if(gid[i] == 0 || gid[i] == nb_global-1)
+      continue;
+    Real value;
+    lss->rhs()->get_value(i, 0, value);
+    BOOST_CHECK_SMALL(value, 1e-12);
+    lss->rhs()->get_value(i, 1, value);
+    BOOST_CHECK_SMALL(value, 1e-12);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Solve )
+{
+  Component& root = Core::instance().root();
+  CommPattern& cp = *root.create_component<CommPattern>("solve_commpattern");
+  std::vector<Uint> node_connectivity, starting_indices;
+  build_chain(cp, node_connectivity, starting_indices);
+
+  Handle<LSS::System> lss = root.create_component<LSS::System>("solve_lss");
+  lss->options().set("matrix_builder", std::string("cf3.math.LSS.NativeMatrix"));
+  lss->options().set("solution_strategy", std::string("cf3.math.LSS.NativeStrategy"));
+  lss->create(cp, neq, node_connectivity, starting_indices);
+  lss->matrix()->options().set("nb_threads", 2u);
+
+  std::vector<std::string> solvers;
+  solvers.push_back("CG");
+  solvers.push_back("BiCGStab");
+  solvers.push_back("GMRES");
+  std::vector<std::string> preconditioners;
+  preconditioners.push_back("Default");
+  preconditioners.push_back("None");
+  preconditioners.push_back("Jacobi");
+  preconditioners.push_back("BlockJacobi");
+  preconditioners.push_back("ILU0");
+
+  Handle<LSS::SolutionStrategy> strategy = lss->solution_strategy();
+  strategy->options().set("tolerance", 1e-12);
+  strategy->options().set("gmres_restart", 10u);
+  for(Uint i = 0; i != solvers.size(); ++i)
+  {
+    for(Uint j = 0; j != preconditioners.size(); ++j)
+    {
+      BOOST_TEST_MESSAGE("Solving with " << solvers[i] << " and preconditioner " << preconditioners[j]);
+      strategy->options().set("solver", solvers[i]);
+      strategy->options().set("preconditioner", preconditioners[j]);
+      assemble(*lss);
+      // ILU0 is not symmetric, so CG rejects it
+      if(solvers[i] == "CG" && preconditioners[j] == "ILU0")
+      {
+        BOOST_CHECK_THROW(lss->solve(), SetupError);
+        continue;
+      }
+      lss->solve();
+      check_solution(*lss);
+      BOOST_CHECK(strategy->properties().value<Uint>("iterations") > 0);
+      BOOST_CHECK_SMALL(lss->solution_strategy()->compute_residual(), 1e-8);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( FinalizeMPI )
+{
+  Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
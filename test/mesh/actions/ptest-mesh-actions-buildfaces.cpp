@@ -0,0 +1,280 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Benchmark of the face matching algorithms of BuildFaces"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "common/Core.hpp"
+#include "common/FindComponents.hpp"
+#include "common/List.hpp"
+#include "common/OptionList.hpp"
+#include "common/Table.hpp"
+
+#include "mesh/Cells.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/FaceCellConnectivity.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
+
+#include "mesh/actions/BuildFaces.hpp"
+
+#include "Tools/Testing/ProfiledTestFixture.hpp"
+#include "Tools/Testing/TimedTestFixture.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::mesh::actions;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct BuildFacesFixture :
+  public Tools::Testing::ProfiledTestFixture,
+  public Tools::Testing::TimedTestFixture
+{
+  BuildFacesFixture() :
+    root(Core::instance().root()),
+    nb_segments(40)
+  {
+    int argc = boost::unit_test::framework::master_test_suite().argc;
+    char** argv = boost::unit_test::framework::master_test_suite().argv;
+    if(argc > 1)
+      nb_segments = boost::lexical_cast<Uint>(argv[1]);
+  }
+
+  /// Create a unit cube of nb_segments^3 hexahedra, each optionally split into 6 tetrahedra or 2 prisms
+  void create_box(Mesh& mesh, const std::string& shape)
+  {
+    const Uint n = nb_segments;
+    const Uint nb_nodes_1d = n+1;
+    mesh.initialize_nodes(nb_nodes_1d*nb_nodes_1d*nb_nodes_1d, DIM_3D);
+    Dictionary& nodes = mesh.geometry_fields();
+    for(Uint k = 0; k != nb_nodes_1d; ++k)
+    {
+      for(Uint j = 0; j != nb_nodes_1d; ++j)
+      {
+        for(Uint i = 0; i != nb_nodes_1d; ++i)
+        {
+          const Uint node = (k*nb_nodes_1d + j)*nb_nodes_1d + i;
+          nodes.coordinates()[node][XX] = static_cast<Real>(i) / static_cast<Real>(n);
+          nodes.coordinates()[node][YY] = static_cast<Real>(j) / static_cast<Real>(n);
+          nodes.coordinates()[node][ZZ] = static_cast<Real>(k) / static_cast<Real>(n);
+          nodes.glb_idx()[node] = node;
+          nodes.rank()[node] = 0;
+        }
+      }
+    }
+
+    // Nodes of each sub-element, as corners of the hexahedron numbered with bits x=1, y=2, z=4
+    std::vector< std::vector<Uint> > sub_elements;
+    std::string etype;
+    if(shape == "Hexa")
+    {
+      etype = "cf3.mesh.LagrangeP1.Hexa3D";
+      const Uint hexa[] = {0, 1, 3, 2, 4, 5, 7, 6};
+      sub_elements.push_back(std::vector<Uint>(hexa, hexa+8));
+    }
+    else if(shape == "Tetra")
+    {
+      // Kuhn subdivision, which is conforming because all cubes are split along the same diagonal
+      etype = "cf3.mesh.LagrangeP1.Tetra3D";
+      const Uint tetras[6][4] = {{0,1,3,7}, {0,1,5,7}, {0,2,3,7}, {0,2,6,7}, {0,4,5,7}, {0,4,6,7}};
+      for(Uint t = 0; t != 6; ++t)
+        sub_elements.push_back(std::vector<Uint>(tetras[t], tetras[t]+4));
+    }
+    else
+    {
+      etype = "cf3.mesh.LagrangeP1.Prism3D";
+      const Uint prisms[2][6] = {{0,1,3,4,5,7}, {0,3,2,4,7,6}};
+      for(Uint p = 0; p != 2; ++p)
+        sub_elements.push_back(std::vector<Uint>(prisms[p], prisms[p]+6));
+    }
+
+    Handle<Cells> cells = mesh.topology().create_region("box").create_component<Cells>(shape);
+    cells->initialize(etype, nodes);
+    cells->resize(n*n*n*sub_elements.size());
+    Connectivity& connectivity = cells->geometry_space().connectivity();
+    Uint element = 0;
+    for(Uint k = 0; k != n; ++k)
+    {
+      for(Uint j = 0; j != n; ++j)
+      {
+        for(Uint i = 0; i != n; ++i)
+        {
+          BOOST_FOREACH(const std::vector<Uint>& sub_element, sub_elements)
+          {
+            for(Uint c = 0; c != sub_element.size(); ++c)
+            {
+              const Uint corner = sub_element[c];
+              connectivity[element][c] = ((k + (corner>>2 & 1))*nb_nodes_1d + j + (corner>>1 & 1))*nb_nodes_1d + i + (corner & 1);
+            }
+            cells->glb_idx()[element] = element;
+            cells->rank()[element] = 0;
+            ++element;
+          }
+        }
+      }
+    }
+
+    mesh.raise_mesh_loaded();
+  }
+
+  static std::string mesh_name(const std::string& shape, const std::string& face_matching, const Uint nb_threads)
+  {
+    return shape + "_" + face_matching + "_" + boost::lexical_cast<std::string>(nb_threads);
+  }
+
+  /// Build the faces of a new mesh with the given settings. Only building the faces is timed.
+  void run(const std::string& shape, const std::string& face_matching, const Uint nb_threads)
+  {
+    const std::string name = mesh_name(shape, face_matching, nb_threads);
+    Handle<Mesh> mesh = root.create_component<Mesh>(name);
+    create_box(*mesh, shape);
+
+    Handle<BuildFaces> build_faces = root.create_component<BuildFaces>("build_faces_" + name);
+    build_faces->options().set("face_matching", face_matching);
+    build_faces->options().set("nb_threads", nb_threads);
+
+    restart_timer();
+    build_faces->transform(*mesh);
+  }
+
+  /// Path of a component relative to the mesh
+  std::string relative_path(const Component& component, const Mesh& mesh)
+  {
+    return component.uri().path().substr(mesh.uri().path().size());
+  }
+
+  /// Check that the faces and their connectivity are identical in both meshes
+  void check_identical(const Mesh& reference, const Mesh& mesh)
+  {
+    std::vector< Handle<Entities> > reference_faces = range_to_vector(find_components_recursively_with_tag<Entities>(reference.topology(), mesh::Tags::face_entity()));
+    std::vector< Handle<Entities> > faces = range_to_vector(find_components_recursively_with_tag<Entities>(mesh.topology(), mesh::Tags::face_entity()));
+    BOOST_REQUIRE_EQUAL(faces.size(), reference_faces.size());
+    for(Uint i = 0; i != faces.size(); ++i)
+    {
+      BOOST_CHECK_EQUAL(relative_path(*faces[i], mesh), relative_path(*reference_faces[i], reference));
+      BOOST_REQUIRE_EQUAL(faces[i]->size(), reference_faces[i]->size());
+      const Connectivity& reference_nodes = reference_faces[i]->geometry_space().connectivity();
+      const Connectivity& nodes = faces[i]->geometry_space().connectivity();
+      const FaceCellConnectivity& reference_f2c = *Handle<FaceCellConnectivity>(reference_faces[i]->get_child("cell_connectivity"));
+      const FaceCellConnectivity& f2c = *Handle<FaceCellConnectivity>(faces[i]->get_child("cell_connectivity"));
+
+      Uint nb_differences = 0;
+      for(Uint face = 0; face != nodes.size(); ++face)
+      {
+        for(Uint n = 0; n != nodes.row_size(); ++n)
+          nb_differences += nodes[face][n] != reference_nodes[face][n];
+        nb_differences += f2c.is_bdry_face()[face] != reference_f2c.is_bdry_face()[face];
+        for(Uint c = 0; c != f2c.connectivity().row_size(); ++c)
+        {
+          const Entity& cell = f2c.connectivity()[face][c];
+          const Entity& reference_cell = reference_f2c.connectivity()[face][c];
+          nb_differences += is_null(cell.comp) != is_null(reference_cell.comp);
+          if(is_not_null(cell.comp) && is_not_null(reference_cell.comp))
+            nb_differences += cell.idx != reference_cell.idx || relative_path(*cell.comp, mesh) != relative_path(*reference_cell.comp, reference);
+          nb_differences += f2c.face_number()[face][c] != reference_f2c.face_number()[face][c];
+          nb_differences += f2c.cell_rotation()[face][c] != reference_f2c.cell_rotation()[face][c];
+          nb_differences += f2c.cell_orientation()[face][c] != reference_f2c.cell_orientation()[face][c];
+        }
+      }
+      BOOST_CHECK_EQUAL(nb_differences, 0u);
+    }
+  }
+
+  /// Compare the faces built by the hash with those of the node search, and remove the meshes
+  void compare(const std::string& shape)
+  {
+    Handle<Mesh> reference(root.get_child(mesh_name(shape, "node_search", 1)));
+    Handle<Mesh> hashed(root.get_child(mesh_name(shape, "hash", 1)));
+    Handle<Mesh> threaded(root.get_child(mesh_name(shape, "hash", 4)));
+    check_identical(*reference, *hashed);
+    check_identical(*reference, *threaded);
+    root.remove_component(*reference);
+    root.remove_component(*hashed);
+    root.remove_component(*threaded);
+  }
+
+  Component& root;
+  Uint nb_segments;
+};
+
+BOOST_FIXTURE_TEST_SUITE( BuildFacesSuite, BuildFacesFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( HexaNodeSearch )
+{
+  run("Hexa", "node_search", 1);
+}
+
+BOOST_AUTO_TEST_CASE( HexaHash )
+{
+  run("Hexa", "hash", 1);
+}
+
+BOOST_AUTO_TEST_CASE( HexaHashThreaded )
+{
+  run("Hexa", "hash", 4);
+}
+
+BOOST_AUTO_TEST_CASE( CheckHexa )
+{
+  compare("Hexa");
+}
+
+BOOST_AUTO_TEST_CASE( TetraNodeSearch )
+{
+  run("Tetra", "node_search", 1);
+}
+
+BOOST_AUTO_TEST_CASE( TetraHash )
+{
+  run("Tetra", "hash", 1);
+}
+
+BOOST_AUTO_TEST_CASE( TetraHashThreaded )
+{
+  run("Tetra", "hash", 4);
+}
+
+BOOST_AUTO_TEST_CASE( CheckTetra )
+{
+  compare("Tetra");
+}
+
+BOOST_AUTO_TEST_CASE( PrismNodeSearch )
+{
+  run("Prism", "node_search", 1);
+}
+
+BOOST_AUTO_TEST_CASE( PrismHash )
+{
+  run("Prism", "hash", 1);
+}
+
+BOOST_AUTO_TEST_CASE( PrismHashThreaded )
+{
+  run("Prism", "hash", 4);
+}
+
+BOOST_AUTO_TEST_CASE( CheckPrism )
+{
+  compare("Prism");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
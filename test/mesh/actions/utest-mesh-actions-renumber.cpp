@@ -0,0 +1,163 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Tests mesh::actions::Renumber"
+
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/foreach.hpp>
+
+#include "common/Core.hpp"
+#include "common/FindComponents.hpp"
+#include "common/List.hpp"
+#include "common/OptionList.hpp"
+
+#include "mesh/actions/Renumber.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshReader.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::mesh::actions;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Largest difference between the node indices of an element
+Uint bandwidth(const Mesh& mesh)
+{
+  Uint result = 0;
+  BOOST_FOREACH(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    BOOST_FOREACH(const Connectivity::ConstRow row, elements.geometry_space().connectivity().array())
+    {
+      result = std::max(result, *std::max_element(row.begin(), row.end()) - *std::min_element(row.begin(), row.end()));
+    }
+  }
+  return result;
+}
+
+/// Global indices of the nodes of each element, indexed by the global element index
+void element_nodes(const Mesh& mesh, std::map< Uint, std::vector<Uint> >& nodes)
+{
+  const List<Uint>& node_glb_idx = mesh.geometry_fields().glb_idx();
+  BOOST_FOREACH(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    const Connectivity& connectivity = elements.geometry_space().connectivity();
+    for(Uint e = 0; e != elements.size(); ++e)
+    {
+      std::vector<Uint>& element_nodes = nodes[elements.glb_idx()[e]];
+      BOOST_FOREACH(const Uint node, connectivity[e])
+      {
+        element_nodes.push_back(node_glb_idx[node]);
+      }
+    }
+  }
+}
+
+/// Renumber the mesh in the given file, checking that fields and connectivity are still consistent. Returns the bandwidth before and after.
+std::pair<Uint, Uint> check_renumber(const std::string& filename, const std::string& ordering)
+{
+  Handle<Mesh> mesh = Core::instance().root().create_component<Mesh>(ordering + "_mesh");
+  boost::shared_ptr<MeshReader> meshreader = build_component_abstract_type<MeshReader>("cf3.mesh.neu.Reader", "meshreader");
+  meshreader->read_mesh_into(filename, *mesh);
+
+  // Nodal field that depends on the coordinates
+  Dictionary& geometry = mesh->geometry_fields();
+  const Uint dim = geometry.coordinates().row_size();
+  Field& nodal = geometry.create_field("nodal");
+  for(Uint i = 0; i != geometry.size(); ++i)
+  {
+    nodal[i][0] = 0.;
+    for(Uint d = 0; d != dim; ++d)
+      nodal[i][0] += static_cast<Real>(d+1) * geometry.coordinates()[i][d];
+  }
+
+  // Element field holding the global element index
+  Dictionary& elems_P0 = mesh->create_discontinuous_space("elems_P0", "cf3.mesh.LagrangeP0");
+  Field& element_idx = elems_P0.create_field("element_idx");
+  BOOST_FOREACH(const Elements& elements, find_components_recursively<Elements>(mesh->topology()))
+  {
+    const Connectivity& connectivity = elems_P0.space(elements).connectivity();
+    for(Uint e = 0; e != elements.size(); ++e)
+      element_idx[connectivity[e][0]][0] = elements.glb_idx()[e];
+  }
+
+  std::map< Uint, std::vector<Uint> > nodes_before;
+  element_nodes(*mesh, nodes_before);
+  const Uint bandwidth_before = bandwidth(*mesh);
+
+  boost::shared_ptr<MeshTransformer> renumber = allocate_component<Renumber>("renumber");
+  renumber->options().set("ordering", ordering);
+  renumber->transform(*mesh);
+
+  BOOST_CHECK(mesh->check_sanity());
+
+  for(Uint i = 0; i != geometry.size(); ++i)
+  {
+    Real expected = 0.;
+    for(Uint d = 0; d != dim; ++d)
+      expected += static_cast<Real>(d+1) * geometry.coordinates()[i][d];
+    BOOST_CHECK_EQUAL(nodal[i][0], expected);
+  }
+
+  BOOST_FOREACH(const Elements& elements, find_components_recursively<Elements>(mesh->topology()))
+  {
+    const Connectivity& connectivity = elems_P0.space(elements).connectivity();
+    for(Uint e = 0; e != elements.size(); ++e)
+      BOOST_CHECK_EQUAL(element_idx[connectivity[e][0]][0], elements.glb_idx()[e]);
+  }
+
+  // The rows of the element field are in element order
+  Uint previous_row = 0;
+  BOOST_FOREACH(const Handle<Entities>& elements, mesh->elements())
+  {
+    BOOST_FOREACH(const Connectivity::ConstRow row, elems_P0.space(*elements).connectivity().array())
+    {
+      BOOST_CHECK_EQUAL(row[0], previous_row++);
+    }
+  }
+
+  std::map< Uint, std::vector<Uint> > nodes_after;
+  element_nodes(*mesh, nodes_after);
+  BOOST_CHECK(nodes_before == nodes_after);
+
+  return std::make_pair(bandwidth_before, bandwidth(*mesh));
+}
+
+BOOST_AUTO_TEST_SUITE( RenumberSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  Core::instance().initiate(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+}
+
+BOOST_AUTO_TEST_CASE( RCM )
+{
+  const std::pair<Uint, Uint> bandwidths = check_renumber("../../../resources/rotation-tg-p1.neu", "RCM");
+  BOOST_CHECK_LT(bandwidths.second, bandwidths.first);
+}
+
+BOOST_AUTO_TEST_CASE( Hilbert )
+{
+  check_renumber("../../../resources/hextet.neu", "Hilbert");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
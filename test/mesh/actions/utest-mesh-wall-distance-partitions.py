@@ -0,0 +1,72 @@
+import sys
+import coolfluid as cf
+
+# The wall distance must not depend on the partitioning, also for nodes whose closest wall is on another rank.
+# Run with "write" on one process to store the serial distances, and with "read" on several processes to compare.
+# The generated mesh has the same global indices on any number of processes.
+
+mode = sys.argv[1]
+
+env = cf.Core.environment()
+env.log_level = 4
+env.only_cpu0_writes = True
+
+root = cf.Core.root()
+domain = root.create_component('Domain', 'cf3.mesh.Domain')
+mesh = domain.create_component('Mesh','cf3.mesh.Mesh')
+
+mesh_generator = root.create_component('MeshGenerator', 'cf3.mesh.SimpleMeshGenerator')
+mesh_generator.options().set('mesh', mesh.uri())
+mesh_generator.options().set('nb_cells', [20, 24])
+mesh_generator.options().set('lengths', [1., 1.2])
+mesh_generator.execute()
+
+time = domain.create_component('Time', 'cf3.solver.Time')
+wall_distance = root.create_component('WallDistance', 'cf3.mesh.actions.WallDistance')
+wall_distance.mesh = mesh
+
+# Only the bottom wall leaves ranks without any wall, adding the left wall gives ranks with a wall that is not the closest one
+cases = [('bottom', [mesh.topology.bottom]), ('bottom-left', [mesh.topology.bottom, mesh.topology.left])]
+
+for (case_name, regions) in cases:
+  wall_distance.regions = regions
+  wall_distance.execute()
+
+  d = mesh.geometry.wall_distance
+  restart_file = cf.URI('wall-distance-partitions-' + case_name + '.cf3restart')
+
+  if mode == 'write':
+    writer = domain.create_component('Writer', 'cf3.solver.actions.WriteRestartFile')
+    writer.fields = [d]
+    writer.file = restart_file
+    writer.time = time
+    writer.execute()
+    writer.delete_component()
+
+  elif mode == 'read':
+    parallel_distance = [d[i][0] for i in range(len(d))]
+
+    reader = domain.create_component('Reader', 'cf3.solver.actions.ReadRestartFile')
+    reader.mesh = mesh
+    reader.file = restart_file
+    reader.time = time
+    reader.execute()
+    reader.delete_component()
+
+    for i in range(len(d)):
+      if abs(parallel_distance[i] - d[i][0]) > 1e-12:
+        raise Exception('Wall distance ' + str(parallel_distance[i]) + ' for node ' + str(i) + ' with wall ' + case_name + ' differs from the serial value ' + str(d[i][0]))
+
+    # Nodes that are not linked to a local wall element refer to a local wall node, unless this rank has no wall
+    n2w = mesh.node_to_wall_element
+    has_wall_node = 0. in parallel_distance
+    for i in range(len(n2w)):
+      if parallel_distance[i] == 0. or n2w[i][0] == 1:
+        continue
+      if n2w[i][0] == 0 and parallel_distance[n2w[i][1]] != 0.:
+        raise Exception('Node ' + str(i) + ' with wall ' + case_name + ' refers to node ' + str(n2w[i][1]) + ', which is not on the wall')
+      if n2w[i][0] == 2 and has_wall_node:
+        raise Exception('Node ' + str(i) + ' with wall ' + case_name + ' is not linked to any of the local wall nodes')
+
+  else:
+    raise Exception('Unknown mode ' + mode)
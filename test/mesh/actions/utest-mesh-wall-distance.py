@@ -1,11 +1,29 @@
 import sys
 import coolfluid as cf
+from coolfluid import cf_check_equal
 
 env = cf.Core.environment()
 env.log_level = 4
 env.only_cpu0_writes = True
 
 root = cf.Core.root()
+
+# The k-d tree search must give exactly the same result as comparing with all wall nodes
+def check_against_brute_force(wall_distance, mesh):
+  d = mesh.geometry.wall_distance
+  n2w = mesh.node_to_wall_element
+  kd_tree_distance = [d[i][0] for i in range(len(d))]
+  kd_tree_wall = [[n2w[i][j] for j in range(3)] for i in range(len(n2w))]
+  wall_distance.nearest_search = 'brute_force'
+  wall_distance.nb_threads = 1
+  wall_distance.execute()
+  for i in range(len(d)):
+    cf_check_equal(d[i][0], kd_tree_distance[i], 'Wall distance differs from brute force for node ' + str(i))
+    for j in range(3):
+      cf_check_equal(n2w[i][j], kd_tree_wall[i][j], 'Wall element differs from brute force for node ' + str(i))
+  wall_distance.nearest_search = 'kd_tree'
+  wall_distance.nb_threads = 2
+
 domain = root.create_component('Domain', 'cf3.mesh.Domain')
 
 # 2D case
@@ -54,9 +72,11 @@ make_boundary_global.mesh = mesh
 make_boundary_global.execute()
 
 wall_distance = root.create_component('WallDistance', 'cf3.mesh.actions.WallDistance')
+wall_distance.nb_threads = 2
 wall_distance.mesh = mesh
 wall_distance.regions = [mesh.topology.step]
 wall_distance.execute()
+check_against_brute_force(wall_distance, mesh)
 
 writer.mesh =  mesh
 writer.file = cf.URI('wall-distance-2dstep.vtm')
@@ -72,6 +92,7 @@ make_boundary_global.execute()
 wall_distance.mesh = mesh
 wall_distance.regions = [mesh.topology.inner]
 wall_distance.execute()
+check_against_brute_force(wall_distance, mesh)
 
 writer.mesh =  mesh
 writer.file = cf.URI('wall-distance-sphere.vtm')
@@ -126,6 +147,7 @@ make_boundary_global.execute()
 wall_distance.mesh = mesh
 wall_distance.regions = [mesh.topology.step, mesh.topology.back]
 wall_distance.execute()
+check_against_brute_force(wall_distance, mesh)
 
 writer.mesh =  mesh
 writer.file = cf.URI('wall-distance-3dstep.vtm')
@@ -0,0 +1,195 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Benchmark of the Hilbert curve partitioner against the graph partitioners"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "coolfluid-packages.hpp"
+
+#include "common/Core.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshGenerator.hpp"
+#include "mesh/MeshTransformer.hpp"
+#include "mesh/Region.hpp"
+
+#include "Tools/Testing/ProfiledTestFixture.hpp"
+#include "Tools/Testing/TimedTestFixture.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct PartitionerFixture :
+  public Tools::Testing::ProfiledTestFixture,
+  public Tools::Testing::TimedTestFixture
+{
+  PartitionerFixture() :
+    root(Core::instance().root())
+  {
+  }
+
+  /// Generate a new mesh with global numbering and connectivity, as needed by the partitioners
+  void setup()
+  {
+    std::vector<Uint> nb_cells(2, 400);
+    int argc = boost::unit_test::framework::master_test_suite().argc;
+    char** argv = boost::unit_test::framework::master_test_suite().argv;
+    if(argc > 2)
+    {
+      nb_cells[0] = boost::lexical_cast<Uint>(argv[1]);
+      nb_cells[1] = boost::lexical_cast<Uint>(argv[2]);
+    }
+    nb_cells_total = nb_cells[0]*nb_cells[1];
+
+    Handle<MeshGenerator> generator = root.create_component<MeshGenerator>("generator", "cf3.mesh.SimpleMeshGenerator");
+    generator->options().set("mesh", root.uri()/"mesh");
+    generator->options().set("nb_cells", nb_cells);
+    generator->options().set("lengths", std::vector<Real>(2, 1.));
+    generator->options().set("bdry", false);
+    mesh = generator->generate().handle<Mesh>();
+    root.remove_component("generator");
+
+    build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.GlobalNumbering", "glb_numbering")->transform(*mesh);
+    build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.GlobalConnectivity", "glb_connectivity")->transform(*mesh);
+    PE::Comm::instance().barrier();
+  }
+
+  /// Partition the mesh with the given partitioner. Only this is timed.
+  void partition(const std::string& partitioner_name)
+  {
+    boost::shared_ptr<MeshTransformer> partitioner = build_component_abstract_type<MeshTransformer>(partitioner_name, "partitioner");
+    restart_timer();
+    partitioner->transform(*mesh);
+    PE::Comm::instance().barrier();
+  }
+
+  /// Check the partitioned mesh and remove it, returning the maximum number of elements of a rank divided by the mean
+  Real check(const std::string& partitioner_name)
+  {
+    PE::Comm& comm = PE::Comm::instance();
+
+    // Element balance
+    Real nb_elements = 0;
+    BOOST_FOREACH(const Elements& elements, find_components_recursively<Elements>(mesh->topology()))
+    {
+      nb_elements += elements.size();
+    }
+    Real max_elements, total_elements;
+    comm.all_reduce(PE::max(), &nb_elements, 1, &max_elements);
+    comm.all_reduce(PE::plus(), &nb_elements, 1, &total_elements);
+    const Real imbalance = max_elements / (total_elements / static_cast<Real>(comm.size()));
+
+    // The number of node copies on the partition interfaces measures the communication volume, like the edge cut
+    Real nb_ghosts = 0;
+    const Dictionary& nodes = mesh->geometry_fields();
+    for(Uint i = 0; i != nodes.size(); ++i)
+    {
+      if(nodes.is_ghost(i))
+        nb_ghosts += 1.;
+    }
+    Real total_ghosts;
+    comm.all_reduce(PE::plus(), &nb_ghosts, 1, &total_ghosts);
+
+    CFinfo << partitioner_name << ": imbalance " << imbalance << ", interface nodes " << total_ghosts << CFendl;
+    std::cout << "<DartMeasurement name=\"" << partitioner_name << " interface nodes\" type=\"numeric/double\">" << total_ghosts << "</DartMeasurement>" << std::endl;
+
+    BOOST_CHECK_EQUAL(total_elements, static_cast<Real>(nb_cells_total));
+
+    root.remove_component("mesh");
+
+    return imbalance;
+  }
+
+  Component& root;
+  static Handle<Mesh> mesh;
+  static Uint nb_cells_total;
+};
+
+Handle<Mesh> PartitionerFixture::mesh;
+Uint PartitionerFixture::nb_cells_total = 0;
+
+BOOST_FIXTURE_TEST_SUITE( PartitionerSuite, PartitionerFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+}
+
+BOOST_AUTO_TEST_CASE( SetupHilbert )
+{
+  setup();
+}
+
+BOOST_AUTO_TEST_CASE( Hilbert )
+{
+  partition("cf3.mesh.HilbertPartitioner");
+}
+
+BOOST_AUTO_TEST_CASE( CheckHilbert )
+{
+  BOOST_CHECK_LT(check("cf3.mesh.HilbertPartitioner"), 1.01);
+}
+
+#ifdef CF3_HAVE_ZOLTAN
+BOOST_AUTO_TEST_CASE( SetupZoltanPHG )
+{
+  setup();
+}
+
+BOOST_AUTO_TEST_CASE( ZoltanPHG )
+{
+  partition("cf3.mesh.zoltan.Partitioner");
+}
+
+BOOST_AUTO_TEST_CASE( CheckZoltanPHG )
+{
+  check("cf3.mesh.zoltan.Partitioner");
+}
+#endif
+
+#ifdef CF3_HAVE_PTSCOTCH
+BOOST_AUTO_TEST_CASE( SetupPTScotch )
+{
+  setup();
+}
+
+BOOST_AUTO_TEST_CASE( PTScotch )
+{
+  partition("cf3.mesh.ptscotch.Partitioner");
+}
+
+BOOST_AUTO_TEST_CASE( CheckPTScotch )
+{
+  check("cf3.mesh.ptscotch.Partitioner");
+}
+#endif
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  PE::Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
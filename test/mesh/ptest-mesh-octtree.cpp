@@ -0,0 +1,297 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Benchmark of the octtree against a uniform grid for element search"
+
+#include <cmath>
+
+#include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+
+#include "mesh/BoundingBox.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Octtree.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+#include "Tools/Testing/ProfiledTestFixture.hpp"
+#include "Tools/Testing/TimedTestFixture.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Reference implementation of the uniform grid that was used by the octtree before, in 2D
+struct UniformGrid
+{
+  void build(Mesh& mesh)
+  {
+    bounding_box.define(*mesh.local_bounding_box());
+    const Uint nb_elems = mesh.topology().recursive_filtered_elements_count(IsElementsVolume(),true);
+    Real volume = 1.;
+    for(Uint d = 0; d != 2; ++d)
+      volume *= bounding_box.max()[d] - bounding_box.min()[d];
+    const Real cell_size = std::sqrt(volume / nb_elems);
+    for(Uint d = 0; d != 2; ++d)
+    {
+      N[d] = static_cast<Uint>(std::ceil((bounding_box.max()[d] - bounding_box.min()[d]) / cell_size));
+      D[d] = (bounding_box.max()[d] - bounding_box.min()[d]) / N[d];
+    }
+    cells.resize(N[0]*N[1]);
+
+    RealVector centroid(2);
+    BOOST_FOREACH(Elements& elements, find_components_recursively_with_filter<Elements>(mesh, IsElementsVolume()))
+    {
+      RealMatrix coordinates;
+      elements.geometry_space().allocate_coordinates(coordinates);
+      for(Uint elem_idx = 0; elem_idx != elements.size(); ++elem_idx)
+      {
+        elements.geometry_space().put_coordinates(coordinates, elem_idx);
+        elements.element_type().compute_centroid(coordinates, centroid);
+        cells[cell_index(centroid, 0) + N[0]*cell_index(centroid, 1)].push_back(Entity(elements, elem_idx));
+      }
+    }
+  }
+
+  Uint cell_index(const RealVector& coord, const Uint d) const
+  {
+    return std::min(static_cast<Uint>(std::max(std::floor((coord[d] - bounding_box.min()[d]) / D[d]), 0.)), N[d]-1);
+  }
+
+  /// Check the elements in the ring at distance ring around cell (i,j)
+  bool search_ring(const RealVector& coord, const int i, const int j, const int ring, Uint& nb_checked, Entity& result)
+  {
+    for(int ii = std::max(i-ring, 0); ii <= std::min(i+ring, int(N[0])-1); ++ii)
+    {
+      for(int jj = std::max(j-ring, 0); jj <= std::min(j+ring, int(N[1])-1); ++jj)
+      {
+        if(std::abs(ii-i) != ring && std::abs(jj-j) != ring)
+          continue;
+        BOOST_FOREACH(const Entity& element, cells[ii + N[0]*jj])
+        {
+          ++nb_checked;
+          element.allocate_coordinates(coordinates);
+          element.put_coordinates(coordinates);
+          if(element.element_type().is_coord_in_element(coord, coordinates))
+          {
+            result = element;
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  /// Same search as the old octtree: expand rings until elements are found, and try one more ring
+  bool find_element(const RealVector& coord, Entity& result)
+  {
+    if(!bounding_box.contains(coord))
+      return false;
+    const int i = cell_index(coord, 0);
+    const int j = cell_index(coord, 1);
+    Uint nb_checked = 0;
+    int ring = 0;
+    for(; nb_checked == 0 && ring <= int(std::max(N[0], N[1])); ++ring)
+    {
+      if(search_ring(coord, i, j, ring, nb_checked, result))
+        return true;
+    }
+    return search_ring(coord, i, j, ring, nb_checked, result);
+  }
+
+  Uint memory_size() const
+  {
+    Uint result = cells.capacity() * sizeof(std::vector<Entity>);
+    BOOST_FOREACH(const std::vector<Entity>& cell, cells)
+      result += cell.capacity() * sizeof(Entity);
+    return result;
+  }
+
+  math::BoundingBox bounding_box;
+  Uint N[2];
+  Real D[2];
+  std::vector< std::vector<Entity> > cells;
+  RealMatrix coordinates;
+};
+
+struct OcttreeBenchmarkFixture :
+  public Tools::Testing::ProfiledTestFixture,
+  public Tools::Testing::TimedTestFixture
+{
+  /// Create a unit square mesh with the given grading exponent for the y coordinate, and the points to search
+  void setup(const std::string& name, const Real grading)
+  {
+    mesh = Core::instance().root().create_component<Mesh>(name);
+    Tools::MeshGeneration::create_rectangle(*mesh, 1., 1., nb_segments, nb_segments);
+
+    // Cluster the nodes towards y = 0, as in a boundary layer
+    Field& coords = mesh->geometry_fields().coordinates();
+    for(Uint i = 0; i != coords.size(); ++i)
+      coords[i][YY] = std::pow(coords[i][YY], grading);
+
+    // Half of the points are uniformly distributed, the other half is clustered like the mesh
+    boost::random::mt19937 gen(42);
+    boost::random::uniform_real_distribution<Real> dist(0.05, 0.95);
+    points.resize(nb_points, 2);
+    for(Uint i = 0; i != nb_points; ++i)
+    {
+      points(i, XX) = dist(gen);
+      points(i, YY) = i % 2 ? dist(gen) : std::pow(dist(gen), grading);
+    }
+
+    grid.reset(new UniformGrid());
+    octtree = mesh->create_component<Octtree>("octtree");
+    octtree->options().set("mesh", mesh);
+  }
+
+  void build_grid()
+  {
+    grid->build(*mesh);
+    CFinfo << mesh->name() << " uniform grid: " << grid->memory_size() << " bytes" << CFendl;
+  }
+
+  void query_grid()
+  {
+    Uint grid_found = 0;
+    Entity element;
+    RealVector point(2);
+    for(Uint i = 0; i != nb_points; ++i)
+    {
+      point = points.row(i).transpose();
+      if(grid->find_element(point, element))
+        ++grid_found;
+    }
+    CFinfo << mesh->name() << " uniform grid: found " << grid_found << " of " << nb_points << CFendl;
+  }
+
+  void build_octtree()
+  {
+    octtree->create_octtree();
+    CFinfo << mesh->name() << " octtree: " << octtree->memory_size() << " bytes" << CFendl;
+  }
+
+  void query_octtree()
+  {
+    Uint tree_found = 0;
+    Entity element;
+    RealVector point(2);
+    for(Uint i = 0; i != nb_points; ++i)
+    {
+      point = points.row(i).transpose();
+      if(octtree->find_element(point, element))
+        ++tree_found;
+    }
+    BOOST_CHECK_EQUAL(tree_found, nb_points);
+  }
+
+  void batch_query_octtree()
+  {
+    std::vector<Entity> elements;
+    BOOST_CHECK_EQUAL(octtree->find_elements(points, elements), nb_points);
+  }
+
+  static const Uint nb_segments = 300;
+  static const Uint nb_points = 100000;
+
+  static Handle<Mesh> mesh;
+  static RealMatrix points;
+  static boost::shared_ptr<UniformGrid> grid;
+  static Handle<Octtree> octtree;
+};
+
+const Uint OcttreeBenchmarkFixture::nb_segments;
+const Uint OcttreeBenchmarkFixture::nb_points;
+Handle<Mesh> OcttreeBenchmarkFixture::mesh;
+RealMatrix OcttreeBenchmarkFixture::points;
+boost::shared_ptr<UniformGrid> OcttreeBenchmarkFixture::grid;
+Handle<Octtree> OcttreeBenchmarkFixture::octtree;
+
+BOOST_FIXTURE_TEST_SUITE( OcttreeBenchmarkSuite, OcttreeBenchmarkFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( SetupUniform )
+{
+  setup("uniform", 1.);
+}
+
+BOOST_AUTO_TEST_CASE( UniformGridBuild )
+{
+  build_grid();
+}
+
+BOOST_AUTO_TEST_CASE( UniformGridQuery )
+{
+  query_grid();
+}
+
+BOOST_AUTO_TEST_CASE( UniformOcttreeBuild )
+{
+  build_octtree();
+}
+
+BOOST_AUTO_TEST_CASE( UniformOcttreeQuery )
+{
+  query_octtree();
+}
+
+BOOST_AUTO_TEST_CASE( UniformOcttreeBatchQuery )
+{
+  batch_query_octtree();
+}
+
+BOOST_AUTO_TEST_CASE( SetupGraded )
+{
+  setup("graded", 4.);
+}
+
+BOOST_AUTO_TEST_CASE( GradedGridBuild )
+{
+  build_grid();
+}
+
+BOOST_AUTO_TEST_CASE( GradedGridQuery )
+{
+  query_grid();
+}
+
+BOOST_AUTO_TEST_CASE( GradedOcttreeBuild )
+{
+  build_octtree();
+}
+
+BOOST_AUTO_TEST_CASE( GradedOcttreeQuery )
+{
+  query_octtree();
+}
+
+BOOST_AUTO_TEST_CASE( GradedOcttreeBatchQuery )
+{
+  batch_query_octtree();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
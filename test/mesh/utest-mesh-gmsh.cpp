@@ -7,6 +7,8 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Test module for cf3::mesh::gmsh::Reader"
 
+#include <fstream>
+
 #include <boost/test/unit_test.hpp>
 
 #include "common/Log.hpp"
@@ -15,6 +17,8 @@
 
 #include "common/Core.hpp"
 #include "common/Environment.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
 
 #include "math/VariablesDescriptor.hpp"
 
@@ -25,6 +29,7 @@
 #include "mesh/MeshTransformer.hpp"
 #include "mesh/Field.hpp"
 #include "mesh/Entities.hpp"
+#include "mesh/Connectivity.hpp"
 #include "mesh/Space.hpp"
 #include "common/DynTable.hpp"
 #include "common/List.hpp"
@@ -311,6 +316,108 @@ BOOST_AUTO_TEST_CASE( read_2d_mesh_mix_p1_out )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( read_2d_mesh_threaded )
+{
+  boost::shared_ptr< MeshReader > meshreader = build_component_abstract_type<MeshReader>("cf3.mesh.gmsh.Reader","meshreader");
+
+  Mesh& serial_mesh = *Core::instance().root().create_component<Mesh>("mesh_2d_mix_p1_serial");
+  meshreader->read_mesh_into("../../resources/rectangle-mix-p1.msh",serial_mesh);
+
+  // Reading with several threads must give exactly the same mesh
+  meshreader->options().set("nb_threads",3u);
+  Mesh& threaded_mesh = *Core::instance().root().create_component<Mesh>("mesh_2d_mix_p1_threaded");
+  meshreader->read_mesh_into("../../resources/rectangle-mix-p1.msh",threaded_mesh);
+
+  const Field& serial_coords = serial_mesh.geometry_fields().coordinates();
+  const Field& threaded_coords = threaded_mesh.geometry_fields().coordinates();
+  BOOST_REQUIRE_EQUAL(serial_coords.size(), threaded_coords.size());
+  for(Uint i = 0; i != serial_coords.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(serial_coords[i][XX], threaded_coords[i][XX]);
+    BOOST_CHECK_EQUAL(serial_coords[i][YY], threaded_coords[i][YY]);
+  }
+
+  std::vector< Handle<Entities> > serial_entities, threaded_entities;
+  boost_foreach(Entities& entities, find_components_recursively<Entities>(serial_mesh.topology()))
+    serial_entities.push_back(entities.handle<Entities>());
+  boost_foreach(Entities& entities, find_components_recursively<Entities>(threaded_mesh.topology()))
+    threaded_entities.push_back(entities.handle<Entities>());
+  BOOST_REQUIRE_EQUAL(serial_entities.size(), threaded_entities.size());
+  for(Uint i = 0; i != serial_entities.size(); ++i)
+  {
+    const Connectivity& serial_conn = serial_entities[i]->geometry_space().connectivity();
+    const Connectivity& threaded_conn = threaded_entities[i]->geometry_space().connectivity();
+    BOOST_REQUIRE_EQUAL(serial_conn.size(), threaded_conn.size());
+    for(Uint e = 0; e != serial_conn.size(); ++e)
+      BOOST_CHECK(std::equal(serial_conn[e].begin(), serial_conn[e].end(), threaded_conn[e].begin()));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( read_2d_mesh_binary )
+{
+  // Unit square made of two triangles, with a line on the bottom boundary and a nodal field
+  {
+    std::ofstream file("square-binary.msh", std::ios::binary);
+    file << "$MeshFormat\n2.2 1 8\n";
+    const int one = 1;
+    file.write(reinterpret_cast<const char*>(&one), sizeof(int));
+    file << "\n$EndMeshFormat\n";
+    file << "$PhysicalNames\n2\n1 1 \"bottom\"\n2 2 \"domain\"\n$EndPhysicalNames\n";
+
+    file << "$Nodes\n4\n";
+    const Real coords[4][3] = { {0.,0.,0.}, {1.,0.,0.}, {1.,1.,0.}, {0.,1.,0.} };
+    for(int n = 0; n != 4; ++n)
+    {
+      const int number = n+1;
+      file.write(reinterpret_cast<const char*>(&number), sizeof(int));
+      file.write(reinterpret_cast<const char*>(coords[n]), 3*sizeof(Real));
+    }
+    file << "\n$EndNodes\n";
+
+    // Blocks of: type, number of elements, number of tags, followed by number, tags, nodes for each element
+    file << "$Elements\n3\n";
+    const int line_block[] = { 1, 1, 2,   1, 1, 1,   1, 2 };
+    const int triag_block[] = { 2, 2, 2,   2, 2, 1, 1, 2, 3,   3, 2, 1, 1, 3, 4 };
+    file.write(reinterpret_cast<const char*>(line_block), sizeof(line_block));
+    file.write(reinterpret_cast<const char*>(triag_block), sizeof(triag_block));
+    file << "\n$EndElements\n";
+
+    file << "$NodeData\n1\n\"u\"\n1\n0\n3\n0\n1\n4\n";
+    for(int n = 0; n != 4; ++n)
+    {
+      const int number = n+1;
+      const Real value = 10.*number;
+      file.write(reinterpret_cast<const char*>(&number), sizeof(int));
+      file.write(reinterpret_cast<const char*>(&value), sizeof(Real));
+    }
+    file << "\n$EndNodeData\n";
+  }
+
+  boost::shared_ptr< MeshReader > meshreader = build_component_abstract_type<MeshReader>("cf3.mesh.gmsh.Reader","meshreader");
+  Mesh& mesh = *Core::instance().root().create_component<Mesh>("mesh_2d_binary");
+  meshreader->read_mesh_into("square-binary.msh",mesh);
+
+  BOOST_CHECK_EQUAL(mesh.dimension(), 2u);
+  const Field& coords = mesh.geometry_fields().coordinates();
+  BOOST_REQUIRE_EQUAL(coords.size(), 4u);
+  BOOST_CHECK_EQUAL(coords[2][XX], 1.);
+  BOOST_CHECK_EQUAL(coords[2][YY], 1.);
+
+  const Entities& triags = find_component_recursively_with_filter<Entities>(mesh.topology(), IsElementsVolume());
+  BOOST_REQUIRE_EQUAL(triags.size(), 2u);
+  BOOST_CHECK_EQUAL(triags.geometry_space().connectivity()[1][1], 2u);
+  BOOST_CHECK_EQUAL(triags.geometry_space().connectivity()[1][2], 3u);
+  BOOST_CHECK_EQUAL(find_component<Region>(mesh.topology()).recursive_elements_count(true), 3u);
+
+  const Field& u = *Handle<Field const>(mesh.geometry_fields().get_child("u"));
+  for(Uint n = 0; n != 4; ++n)
+    BOOST_CHECK_EQUAL(u[n][0], 10.*(n+1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( finalize_mpi )
 {
   Core::instance().terminate();
@@ -0,0 +1,64 @@
+import sys
+import coolfluid as cf
+
+# The Hilbert partitioner places elements with a periodic node at the target of the link,
+# so the nodes on both sides of a periodic boundary end up on the same process, except near the splitters.
+
+env = cf.Core.environment()
+env.log_level = 4
+env.only_cpu0_writes = True
+
+root = cf.Core.root()
+domain = root.create_component('Domain', 'cf3.mesh.Domain')
+mesh = domain.create_component('mesh','cf3.mesh.Mesh')
+
+mesh_generator = domain.create_component("MeshGenerator","cf3.mesh.SimpleMeshGenerator")
+mesh_generator.mesh = mesh.uri()
+mesh_generator.nb_cells = [40,40]
+mesh_generator.lengths = [1.,1.]
+mesh_generator.offsets = [0.,0.]
+mesh_generator.execute()
+
+make_par_data = root.create_component('MakeParData', 'cf3.solver.actions.ParallelDataToFields')
+make_par_data.mesh = mesh
+make_par_data.execute()
+
+make_boundary_global = domain.create_component('MakeBoundaryGlobal', 'cf3.mesh.actions.MakeBoundaryGlobal')
+make_boundary_global.mesh = mesh
+make_boundary_global.execute()
+
+link_horizontal = domain.create_component('LinkHorizontal', 'cf3.mesh.actions.LinkPeriodicNodes')
+link_horizontal.mesh = mesh
+link_horizontal.source_region = mesh.topology.right
+link_horizontal.destination_region = mesh.topology.left
+link_horizontal.translation_vector = [-1., 0.]
+link_horizontal.execute()
+
+partitioner = domain.create_component('Partitioner', 'cf3.mesh.HilbertPartitioner')
+partitioner.mesh = mesh
+partitioner.execute()
+
+make_par_data.execute()
+
+my_rank = cf.Core.rank()
+ranks = mesh.geometry.children.rank
+periodic_links_nodes = mesh.geometry.children.periodic_links_nodes
+periodic_links_active = mesh.geometry.children.periodic_links_active
+
+nb_periodic = 0
+nb_split = 0
+for i in range(len(ranks)):
+  if ranks[i] != my_rank or not periodic_links_active[i]:
+    continue
+  target = periodic_links_nodes[i]
+  while periodic_links_active[target]:
+    target = periodic_links_nodes[target]
+  nb_periodic += 1
+  if ranks[target] != my_rank:
+    nb_split += 1
+
+print('periodic nodes on rank ' + str(my_rank) + ': ' + str(nb_periodic) + ', with the target on another rank: ' + str(nb_split))
+
+# Without periodic placement, nearly all targets on the left side would be on another rank than the nodes on the right side
+if nb_split > nb_periodic / 4 + 2:
+  raise Exception('Too many periodic nodes separated from their target on rank ' + str(my_rank))
@@ -0,0 +1,131 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Tests mesh k-d tree"
+
+#include <cstdlib>
+#include <limits>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/BasicExceptions.hpp"
+
+#include "mesh/KdTree.hpp"
+
+using namespace cf3;
+using namespace cf3::mesh;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Linear search with a strict comparison, the reference for the tree
+Uint brute_force_nearest(const std::vector<Real>& coords, const Uint dim, const Real* point, Real& squared_distance)
+{
+  Uint result = 0;
+  squared_distance = std::numeric_limits<Real>::max();
+  const Uint nb_points = coords.size() / dim;
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    Real d2 = 0.;
+    for(Uint d = 0; d != dim; ++d)
+    {
+      const Real diff = point[d] - coords[i*dim + d];
+      d2 += diff*diff;
+    }
+    if(d2 < squared_distance)
+    {
+      squared_distance = d2;
+      result = i;
+    }
+  }
+  return result;
+}
+
+void check_tree(const std::vector<Real>& coords, const std::vector<Real>& queries, const Uint dim)
+{
+  KdTree tree;
+  tree.build(coords, dim);
+  BOOST_CHECK_EQUAL(tree.size(), coords.size() / dim);
+
+  const Uint nb_queries = queries.size() / dim;
+  for(Uint i = 0; i != nb_queries; ++i)
+  {
+    Real tree_d2, reference_d2;
+    const Uint tree_idx = tree.nearest(&queries[i*dim], tree_d2);
+    const Uint reference_idx = brute_force_nearest(coords, dim, &queries[i*dim], reference_d2);
+    BOOST_CHECK_EQUAL(tree_idx, reference_idx);
+    BOOST_CHECK_EQUAL(tree_d2, reference_d2);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( KdTreeSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( RandomPoints )
+{
+  std::srand(42);
+  for(Uint dim = 2; dim != 4; ++dim)
+  {
+    std::vector<Real> coords(1000*dim);
+    for(Uint i = 0; i != coords.size(); ++i)
+      coords[i] = static_cast<Real>(std::rand()) / RAND_MAX;
+    std::vector<Real> queries(500*dim);
+    for(Uint i = 0; i != queries.size(); ++i)
+      queries[i] = 2.*static_cast<Real>(std::rand()) / RAND_MAX - 0.5;
+    check_tree(coords, queries, dim);
+  }
+}
+
+// Points on a grid, including duplicates, queried at the cell centers and the points themselves, so there are many ties
+BOOST_AUTO_TEST_CASE( GridTies )
+{
+  const Uint n = 20;
+  std::vector<Real> coords;
+  for(Uint copy = 0; copy != 2; ++copy)
+  {
+    for(Uint i = 0; i != n; ++i)
+    {
+      for(Uint j = 0; j != n; ++j)
+      {
+        coords.push_back(static_cast<Real>(i));
+        coords.push_back(static_cast<Real>(j));
+      }
+    }
+  }
+
+  std::vector<Real> queries;
+  for(Uint i = 0; i != n; ++i)
+  {
+    for(Uint j = 0; j != n; ++j)
+    {
+      queries.push_back(i + 0.5);
+      queries.push_back(j + 0.5);
+      queries.push_back(i);
+      queries.push_back(j);
+    }
+  }
+  check_tree(coords, queries, 2);
+}
+
+BOOST_AUTO_TEST_CASE( Errors )
+{
+  KdTree tree;
+  BOOST_CHECK_THROW(tree.build(std::vector<Real>(5, 0.), 2), common::BadValue);
+
+  tree.build(std::vector<Real>(), 3);
+  Real d2;
+  const Real point[] = {0., 0., 0.};
+  BOOST_CHECK_THROW(tree.nearest(point, d2), common::SetupError);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,8 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Tests mesh octtree"
 
+#include <set>
+
 #include <boost/test/unit_test.hpp>
 #include "common/BoostAssign.hpp"
 #include <boost/assign/std/vector.hpp>
@@ -98,12 +100,6 @@ BOOST_AUTO_TEST_CASE( Octtree_creation )
   octtree.options().set("nb_elems_per_cell", 1u );
   octtree.options().set("mesh", mesh.handle<Mesh>());
 
-  // Following configuration option has priority over the the previous one.
-  std::vector<Uint> nb_cells = boost::assign::list_of(5)(5);
-  octtree.options().set("nb_cells", nb_cells );
-
-  BOOST_CHECK(true);
-
   Entity element;
   RealVector2 coord;
 
@@ -119,6 +115,27 @@ BOOST_AUTO_TEST_CASE( Octtree_creation )
   element = octtree.find_element(coord);
   BOOST_CHECK_EQUAL(element.idx,5u);
 
+  // Points outside the mesh are not found
+  coord << 11. , 1. ;
+  element = octtree.find_element(coord);
+  BOOST_CHECK(is_null(element.comp));
+
+  // Batched search, results are in the order of the points
+  RealMatrix points(4,2);
+  points << 3., 1.,
+            1., 1.,
+            11., 1.,
+            9., 9.;
+  std::vector<Entity> found_elements;
+  BOOST_CHECK_EQUAL(octtree.find_elements(points, found_elements), 3u);
+  BOOST_CHECK_EQUAL(found_elements[0].idx,1u);
+  BOOST_CHECK_EQUAL(found_elements[1].idx,0u);
+  BOOST_CHECK(is_null(found_elements[2].comp));
+  BOOST_CHECK_EQUAL(found_elements[3].idx,24u);
+
+  // The tree is balanced
+  BOOST_CHECK_EQUAL(octtree.nb_nodes(), 49u);
+
 
   Handle<StencilComputerOcttree> stencil_computer = Core::instance().root().create_component<StencilComputerOcttree>("stencilcomputer");  
   stencil_computer->options().set("dict", dict );
@@ -128,16 +145,23 @@ BOOST_AUTO_TEST_CASE( Octtree_creation )
   stencil_computer->options().set("stencil_size", 1u );
   stencil_computer->compute_stencil(space_elem, stencil);
   BOOST_CHECK_EQUAL(stencil.size(), 1u);
+  BOOST_CHECK_EQUAL(stencil[0].idx, 7u);
 
-  stencil_computer->options().set("stencil_size", 2u );
+  // The closest elements are the 4 face neighbours, then the 4 corner neighbours
+  stencil_computer->options().set("stencil_size", 5u );
   stencil_computer->compute_stencil(space_elem, stencil);
-  BOOST_CHECK_EQUAL(stencil.size(), 9u);
-
-  stencil_computer->options().set("stencil_size", 10u );
+  BOOST_CHECK_EQUAL(stencil.size(), 5u);
+  std::set<Uint> face_neighbours;
+  for(Uint i = 1; i != 5; ++i)
+    face_neighbours.insert(stencil[i].idx);
+  const std::set<Uint> expected_neighbours = boost::assign::list_of(2u)(6u)(8u)(12u);
+  BOOST_CHECK(face_neighbours == expected_neighbours);
+
+  stencil_computer->options().set("stencil_size", 9u );
   stencil_computer->compute_stencil(space_elem, stencil);
-  BOOST_CHECK_EQUAL(stencil.size(), 20u);
+  BOOST_CHECK_EQUAL(stencil.size(), 9u);
 
-  stencil_computer->options().set("stencil_size", 21u );
+  stencil_computer->options().set("stencil_size", 30u );
   stencil_computer->compute_stencil(space_elem, stencil);
   BOOST_CHECK_EQUAL(stencil.size(), 25u); // mesh size
 
@@ -164,10 +188,6 @@ BOOST_AUTO_TEST_CASE( Octtree_parallel )
   octtree.options().set("mesh", mesh.handle<Mesh>() );
   octtree.create_octtree();
 
-  // Following configuration option has priority over the the previous one.
-  std::vector<Uint> nb_cells = boost::assign::list_of(5)(5);
-  octtree.options().set("nb_cells", nb_cells );
-
   boost::multi_array<Real,2> coordinates;
   coordinates.resize(boost::extents[2][2]);
   coordinates[0][XX] = 5.;  coordinates[0][YY] = 2.5;
@@ -0,0 +1,126 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_test_mesh_tecplot_binary_reader_hpp
+#define cf3_test_mesh_tecplot_binary_reader_hpp
+
+/// @file utest-mesh-tecplot-binary-reader.hpp
+/// Minimal reader for the binary Tecplot files written by cf3::mesh::tecplot::Writer, to check them in the tests.
+/// Only the records written by mesh/tecplot/BinaryFormat.hpp are understood.
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "common/CF.hpp"
+
+#include "mesh/tecplot/BinaryFormat.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace tecplot_binary_reader {
+
+using cf3::Uint;
+using cf3::Real;
+
+template<typename T>
+T read_value(std::istream& in)
+{
+  T value;
+  in.read(reinterpret_cast<char*>(&value), sizeof(value));
+  return value;
+}
+
+inline std::string read_string(std::istream& in)
+{
+  std::string result;
+  for(boost::int32_t c = read_value<boost::int32_t>(in); c != 0; c = read_value<boost::int32_t>(in))
+    result.push_back(static_cast<char>(c));
+  return result;
+}
+
+/// A zone as read from the file
+struct Zone
+{
+  boost::int32_t zone_type;
+  Uint nb_nodes;
+  Uint nb_elems;
+  /// For each variable, true if it is cell centred
+  std::vector<bool> cell_centred;
+  /// Values of each variable, filled by read_zone_data
+  std::vector< std::vector<Real> > values;
+  /// Zero-based connectivity, filled by read_zone_data
+  std::vector<boost::int32_t> connectivity;
+};
+
+/// Read the header, up to and including the end of header marker
+inline void read_header(std::istream& in, std::vector<std::string>& variables, std::vector<Zone>& zones)
+{
+  char magic[8];
+  in.read(magic, 8);
+  read_value<boost::int32_t>(in); // byte order
+  read_value<boost::int32_t>(in); // file type
+  read_string(in); // title
+  variables.resize(read_value<boost::int32_t>(in));
+  for(Uint i = 0; i != variables.size(); ++i)
+    variables[i] = read_string(in);
+
+  for(float marker = read_value<float>(in); in && marker == 299.f; marker = read_value<float>(in))
+  {
+    Zone zone;
+    read_string(in); // title
+    read_value<boost::int32_t>(in); // parent zone
+    read_value<boost::int32_t>(in); // strand id
+    read_value<double>(in); // solution time
+    read_value<boost::int32_t>(in); // not used
+    zone.zone_type = read_value<boost::int32_t>(in);
+    zone.cell_centred.assign(variables.size(), false);
+    if(read_value<boost::int32_t>(in) == 1)
+    {
+      for(Uint i = 0; i != variables.size(); ++i)
+        zone.cell_centred[i] = read_value<boost::int32_t>(in) == 1;
+    }
+    read_value<boost::int32_t>(in); // raw face neighbors
+    read_value<boost::int32_t>(in); // user defined face neighbor connections
+    zone.nb_nodes = read_value<boost::int32_t>(in);
+    zone.nb_elems = read_value<boost::int32_t>(in);
+    for(Uint i = 0; i != 4; ++i)
+      read_value<boost::int32_t>(in); // cell dimensions and auxiliary data
+    zones.push_back(zone);
+  }
+}
+
+/// Read the data of the next zone
+inline void read_zone_data(std::istream& in, Zone& zone)
+{
+  const Uint nb_vars = zone.cell_centred.size();
+  read_value<float>(in); // zone marker
+  for(Uint i = 0; i != nb_vars + 3; ++i)
+    read_value<boost::int32_t>(in); // data formats, passive, sharing and connectivity sharing flags
+  for(Uint i = 0; i != 2*nb_vars; ++i)
+    read_value<double>(in); // ranges
+
+  zone.values.resize(nb_vars);
+  for(Uint var = 0; var != nb_vars; ++var)
+  {
+    zone.values[var].resize(zone.cell_centred[var] ? zone.nb_elems : zone.nb_nodes);
+    for(Uint i = 0; i != zone.values[var].size(); ++i)
+      zone.values[var][i] = read_value<double>(in);
+  }
+
+  const Uint nb_element_nodes = cf3::mesh::tecplot::binary::nb_element_nodes(static_cast<cf3::mesh::tecplot::binary::ZoneType>(zone.zone_type));
+  zone.connectivity.resize(zone.nb_elems*nb_element_nodes);
+  for(Uint i = 0; i != zone.connectivity.size(); ++i)
+    zone.connectivity[i] = read_value<boost::int32_t>(in);
+}
+
+} // namespace tecplot_binary_reader
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_test_mesh_tecplot_binary_reader_hpp
@@ -0,0 +1,172 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::mesh::tecplot::Writer in parallel"
+
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/List.hpp"
+#include "common/OptionList.hpp"
+#include "common/StringConversion.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshGenerator.hpp"
+#include "mesh/MeshWriter.hpp"
+
+#include "utest-mesh-tecplot-binary-reader.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::string file_contents(const std::string& path)
+{
+  std::ifstream file(path.c_str(), std::ios_base::in | std::ios_base::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/// Parts of a binary file: the file header, the zone headers, the end of header marker and the zone data
+struct BinaryFileParts
+{
+  BinaryFileParts(const std::string& contents)
+  {
+    std::istringstream in(contents);
+    std::vector<std::string> variables;
+    std::vector<tecplot_binary_reader::Zone> zones;
+    tecplot_binary_reader::read_header(in, variables, zones);
+    BOOST_REQUIRE(in.good());
+    nb_zones = zones.size();
+    const std::string::size_type end_of_header = in.tellg();
+    for(Uint i = 0; i != nb_zones; ++i)
+      tecplot_binary_reader::read_zone_data(in, zones[i]);
+    BOOST_CHECK(in.good());
+    BOOST_CHECK_EQUAL(static_cast<std::string::size_type>(in.tellg()), contents.size());
+
+    // The file header ends after the last variable name
+    in.seekg(0);
+    char magic[8];
+    in.read(magic, 8);
+    tecplot_binary_reader::read_value<boost::int32_t>(in);
+    tecplot_binary_reader::read_value<boost::int32_t>(in);
+    tecplot_binary_reader::read_string(in);
+    const Uint nb_vars = tecplot_binary_reader::read_value<boost::int32_t>(in);
+    for(Uint i = 0; i != nb_vars; ++i)
+      tecplot_binary_reader::read_string(in);
+    const std::string::size_type end_of_file_header = in.tellg();
+
+    file_header = contents.substr(0, end_of_file_header);
+    zone_headers = contents.substr(end_of_file_header, end_of_header - sizeof(float) - end_of_file_header);
+    end_marker = contents.substr(end_of_header - sizeof(float), sizeof(float));
+    data = contents.substr(end_of_header);
+  }
+
+  Uint nb_zones;
+  std::string file_header;
+  std::string zone_headers;
+  std::string end_marker;
+  std::string data;
+};
+
+std::vector<std::string> gather_strings(const std::string& local)
+{
+  std::vector< std::vector<char> > gathered;
+  PE::Comm::instance().all_gather(std::vector<char>(local.begin(), local.end()), gathered);
+  std::vector<std::string> result;
+  for(Uint i = 0; i != gathered.size(); ++i)
+    result.push_back(std::string(gathered[i].begin(), gathered[i].end()));
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( TecplotParallelSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  BOOST_CHECK(PE::Comm::instance().size() > 1);
+
+  Component& root = Core::instance().root();
+  Handle<MeshGenerator> generator = root.create_component<MeshGenerator>("generator", "cf3.mesh.SimpleMeshGenerator");
+  generator->options().set("mesh", root.uri()/"mesh");
+  generator->options().set("nb_cells", std::vector<Uint>(2, 20));
+  generator->options().set("lengths", std::vector<Real>(2, 1.));
+  Mesh& mesh = generator->generate();
+
+  Field& nodal = mesh.geometry_fields().create_field("nodal", "nodal[vector]");
+  const List<Uint>& glb_idx = mesh.geometry_fields().glb_idx();
+  for(Uint i = 0; i != nodal.size(); ++i)
+  {
+    for(Uint j = 0; j != nodal.row_size(); ++j)
+      nodal[i][j] = static_cast<Real>(glb_idx[i]) + 0.5*j;
+  }
+}
+
+/// The single file holds the header, zone headers and data of all ranks, in rank order, exactly as in the per-rank files
+BOOST_AUTO_TEST_CASE( SingleFile )
+{
+  PE::Comm& comm = PE::Comm::instance();
+  Mesh& mesh = *Handle<Mesh>(Core::instance().root().get_child("mesh"));
+
+  boost::shared_ptr<MeshWriter> writer = build_component_abstract_type<MeshWriter>("cf3.mesh.tecplot.Writer", "writer");
+  writer->options().set("mesh", mesh.handle<Mesh const>());
+  writer->options().set("fields", std::vector<URI>(1, mesh.geometry_fields().uri()/"nodal"));
+  writer->options().set("file_format", std::string("binary"));
+  writer->options().set("file", URI("tecplot-parallel.plt"));
+  writer->execute();
+  writer->options().set("single_file", true);
+  writer->options().set("file", URI("tecplot-parallel-single.plt"));
+  writer->execute();
+
+  const BinaryFileParts rank_parts(file_contents("tecplot-parallel_P" + to_str(comm.rank()) + ".plt"));
+  BOOST_CHECK(rank_parts.nb_zones > 0);
+  const std::vector<std::string> all_zone_headers = gather_strings(rank_parts.zone_headers);
+  const std::vector<std::string> all_data = gather_strings(rank_parts.data);
+  std::vector<Uint> nb_zones;
+  comm.all_gather(rank_parts.nb_zones, nb_zones);
+
+  if(comm.rank() == 0)
+  {
+    const std::string single_contents = file_contents("tecplot-parallel-single.plt");
+    const BinaryFileParts single_parts(single_contents);
+    BOOST_CHECK_EQUAL(single_parts.nb_zones, std::accumulate(nb_zones.begin(), nb_zones.end(), 0u));
+
+    std::string expected = rank_parts.file_header;
+    for(Uint rank = 0; rank != comm.size(); ++rank)
+      expected += all_zone_headers[rank];
+    expected += rank_parts.end_marker;
+    for(Uint rank = 0; rank != comm.size(); ++rank)
+      expected += all_data[rank];
+    BOOST_CHECK_EQUAL(single_contents.size(), expected.size());
+    BOOST_CHECK(single_contents == expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  PE::Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -7,11 +7,17 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Test module for cf3::mesh::tecplot::Writer"
 
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include <boost/cstdint.hpp>
 #include <boost/test/unit_test.hpp>
 
 #include "common/Log.hpp"
 #include "common/OptionList.hpp"
 #include "common/Core.hpp"
+#include "common/StringConversion.hpp"
 
 #include "math/VariablesDescriptor.hpp"
 
@@ -26,6 +32,8 @@
 #include "common/Table.hpp"
 #include "mesh/Dictionary.hpp"
 
+#include "utest-mesh-tecplot-binary-reader.hpp"
+
 using namespace std;
 using namespace boost;
 using namespace cf3;
@@ -131,6 +139,131 @@ BOOST_AUTO_TEST_CASE( read_2d_mesh )
   BOOST_CHECK(true);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( write_binary )
+{
+  Mesh& mesh = *Handle<Mesh>(Core::instance().root().get_child("mesh"));
+
+  std::vector<URI> fields;
+  fields.push_back(mesh.geometry_fields().uri()/"nodal");
+  fields.push_back(mesh.uri()/"elems_P0/cell_centred");
+  fields.push_back(mesh.uri()/"nodes_P2/nodesP2");
+  boost::shared_ptr< MeshWriter > tec_writer = build_component_abstract_type<MeshWriter>("cf3.mesh.tecplot.Writer","meshwriter");
+  tec_writer->options().set("file_format",std::string("binary"));
+  tec_writer->options().set("mesh",mesh.handle<Mesh const>());
+  tec_writer->options().set("fields",fields);
+  tec_writer->options().set("file",URI("quadtriag_binary.plt"));
+  tec_writer->execute();
+
+  std::ifstream file("quadtriag_binary.plt", std::ios_base::in | std::ios_base::binary);
+  BOOST_REQUIRE(file);
+
+  char magic[8];
+  file.read(magic, 8);
+  BOOST_CHECK_EQUAL(std::string(magic, 8), "#!TDV112");
+
+  boost::int32_t value;
+  file.read(reinterpret_cast<char*>(&value), sizeof(value));
+  BOOST_CHECK_EQUAL(value, 1); // byte order
+  file.read(reinterpret_cast<char*>(&value), sizeof(value));
+  BOOST_CHECK_EQUAL(value, 0); // full file
+
+  std::string title;
+  for(file.read(reinterpret_cast<char*>(&value), sizeof(value)); value != 0; file.read(reinterpret_cast<char*>(&value), sizeof(value)))
+    title.push_back(static_cast<char>(value));
+  BOOST_CHECK_EQUAL(title, "COOLFluiD Mesh Data");
+
+  // Two coordinates and two components of each of the three fields
+  file.read(reinterpret_cast<char*>(&value), sizeof(value));
+  BOOST_CHECK_EQUAL(value, 8);
+
+  std::vector<std::string> names(value);
+  for(Uint i = 0; i != names.size(); ++i)
+  {
+    for(file.read(reinterpret_cast<char*>(&value), sizeof(value)); value != 0; file.read(reinterpret_cast<char*>(&value), sizeof(value)))
+      names[i].push_back(static_cast<char>(value));
+  }
+  BOOST_CHECK_EQUAL(names[0], "x0");
+  BOOST_CHECK_EQUAL(names[3], "nodal[1]");
+  BOOST_CHECK_EQUAL(names[4], "cell_centred[0]");
+
+  float marker;
+  file.read(reinterpret_cast<char*>(&marker), sizeof(marker));
+  BOOST_CHECK_EQUAL(marker, 299.f); // first zone
+  BOOST_CHECK(file.good());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( binary_matches_ascii )
+{
+  Mesh& mesh = *Handle<Mesh>(Core::instance().root().get_child("mesh"));
+
+  std::vector<URI> fields;
+  fields.push_back(mesh.geometry_fields().uri()/"nodal");
+  fields.push_back(mesh.uri()/"elems_P0/cell_centred");
+  fields.push_back(mesh.uri()/"nodes_P2/nodesP2");
+  boost::shared_ptr< MeshWriter > tec_writer = build_component_abstract_type<MeshWriter>("cf3.mesh.tecplot.Writer","meshwriter");
+  tec_writer->options().set("cell_centred",true);
+  tec_writer->options().set("mesh",mesh.handle<Mesh const>());
+  tec_writer->options().set("fields",fields);
+  tec_writer->options().set("file",URI("quadtriag_compare_ascii.plt"));
+  tec_writer->execute();
+  tec_writer->options().set("file_format",std::string("binary"));
+  tec_writer->options().set("file",URI("quadtriag_compare_binary.plt"));
+  tec_writer->execute();
+
+  // First zone of the binary file
+  std::ifstream binary_file("quadtriag_compare_binary.plt", std::ios_base::in | std::ios_base::binary);
+  BOOST_REQUIRE(binary_file);
+  std::vector<std::string> variables;
+  std::vector<tecplot_binary_reader::Zone> zones;
+  tecplot_binary_reader::read_header(binary_file, variables, zones);
+  BOOST_REQUIRE(!zones.empty());
+  tecplot_binary_reader::Zone& zone = zones.front();
+  tecplot_binary_reader::read_zone_data(binary_file, zone);
+  BOOST_REQUIRE(binary_file.good());
+  BOOST_CHECK(zone.cell_centred[4]);
+
+  // Numbers of the first zone of the ASCII file, skipping the comments
+  std::ifstream ascii_file("quadtriag_compare_ascii.plt");
+  BOOST_REQUIRE(ascii_file);
+  std::string line;
+  while(std::getline(ascii_file, line) && line.compare(0, 4, "ZONE") != 0);
+  BOOST_REQUIRE(ascii_file);
+  std::vector<std::string> tokens;
+  while(std::getline(ascii_file, line) && line.compare(0, 4, "ZONE") != 0)
+  {
+    if(!line.empty() && line[0] == '#')
+      continue;
+    std::istringstream line_stream(line);
+    std::string token;
+    while(line_stream >> token)
+      tokens.push_back(token);
+  }
+
+  Uint nb_values = 0;
+  for(Uint var = 0; var != zone.values.size(); ++var)
+    nb_values += zone.values[var].size();
+  BOOST_REQUIRE_EQUAL(tokens.size(), nb_values + zone.connectivity.size());
+
+  // The ASCII values have 13 significant digits
+  Uint token_idx = 0;
+  for(Uint var = 0; var != zone.values.size(); ++var)
+  {
+    for(Uint i = 0; i != zone.values[var].size(); ++i, ++token_idx)
+    {
+      const Real ascii_value = from_str<Real>(tokens[token_idx]);
+      BOOST_CHECK_SMALL(std::abs(ascii_value - zone.values[var][i]) / (1. + std::abs(ascii_value)), 1e-11);
+    }
+  }
+
+  // The ASCII connectivity is one-based
+  for(Uint i = 0; i != zone.connectivity.size(); ++i, ++token_idx)
+    BOOST_CHECK_EQUAL(from_str<int>(tokens[token_idx]) - 1, zone.connectivity[i]);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /*
 BOOST_AUTO_TEST_CASE( threeD_test )
@@ -1,4 +1,5 @@
 from coolfluid import *
+import struct
 
 root = Core.root()
 env = Core.environment()
@@ -37,3 +38,51 @@ cf_check_equal(table[0][0],2,'Table increment failed')
 
 print 'Full table:'
 print table
+
+# Views share the data with the table, without copying
+view = memoryview(table.buffer())
+cf_check_equal(view.shape, (10, 2), 'Incorrect view shape')
+cf_check_equal(view.format, 'I', 'Incorrect view format')
+cf_check_equal(view.strides[0], 2*view.itemsize, 'Incorrect view strides')
+
+# The table can't be resized while a view exists
+resized = True
+try:
+  table.resize(20)
+except RuntimeError:
+  resized = False
+cf_check(not resized, 'Table was resized while a view exists')
+
+del view
+table.resize(20)
+cf_check_equal(len(table),20,'Table resize after releasing the view failed')
+
+try:
+  import numpy
+except ImportError:
+  numpy = None
+
+if numpy is not None:
+  array = table.numpy()
+  cf_check_equal(array.shape, (20, 2), 'Incorrect NumPy array shape')
+  array[1,1] = 7
+  cf_check_equal(table[1][1], 7, 'NumPy array does not share the table data')
+  del array
+
+# A view keeps the table data alive when the table is deleted
+deleted_table = root.create_component("deleted_table", "cf3.common.Table<unsigned>")
+deleted_table.set_row_size(2)
+deleted_table.resize(3)
+deleted_table[2] = [5, 6]
+view = memoryview(deleted_table.buffer())
+if numpy is not None:
+  array = deleted_table.numpy()
+deleted_table.delete_component()
+del deleted_table
+cf_check_equal(struct.unpack('6I', view.tobytes())[5], 6, 'View data changed after deleting the table')
+if numpy is not None:
+  cf_check_equal(array[2,1], 6, 'NumPy array data changed after deleting the table')
+  array[2,1] = 8
+  cf_check_equal(array[2,1], 8, 'NumPy array of a deleted table can not be modified')
+  del array
+del view
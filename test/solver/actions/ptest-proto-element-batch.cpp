@@ -0,0 +1,156 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Benchmark of batched element evaluation in proto element loops"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/FindComponents.hpp"
+#include "common/OptionList.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementTypes.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+
+#include "solver/Tags.hpp"
+
+#include "solver/actions/Proto/ElementLooper.hpp"
+#include "solver/actions/Proto/Expression.hpp"
+#include "solver/actions/Proto/NodeLooper.hpp"
+#include "solver/actions/Proto/ProtoAction.hpp"
+#include "solver/actions/Proto/Terminals.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+#include "Tools/Testing/ProfiledTestFixture.hpp"
+#include "Tools/Testing/TimedTestFixture.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+using namespace cf3::solver::actions;
+using namespace cf3::solver::actions::Proto;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct ElementBatchFixture :
+  public Tools::Testing::ProfiledTestFixture,
+  public Tools::Testing::TimedTestFixture
+{
+  ElementBatchFixture() :
+    root(Core::instance().root())
+  {
+  }
+
+  /// Run the assembly action nb_iterations times, timing only the assembly
+  void run()
+  {
+    zero_action->execute();
+    restart_timer();
+    for(Uint i = 0; i != nb_iterations; ++i)
+      assembly_action->execute();
+  }
+
+  /// Compare the result of the last run with the result of the scalar assembly
+  void check_result()
+  {
+    const Field& field = find_component_recursively_with_tag<Field>(*mesh, "nodal_value");
+    const Uint nb_nodes = field.size();
+    BOOST_REQUIRE_EQUAL(reference.size(), nb_nodes);
+    for(Uint i = 0; i != nb_nodes; ++i)
+      BOOST_CHECK_CLOSE(field[i][0], reference[i], 1e-8);
+  }
+
+  Component& root;
+  static Handle<Mesh> mesh;
+  static Handle<ProtoAction> zero_action;
+  static Handle<ProtoAction> assembly_action;
+  static std::vector<Real> reference;
+  static const Uint nb_iterations = 5;
+};
+
+Handle<Mesh> ElementBatchFixture::mesh;
+Handle<ProtoAction> ElementBatchFixture::zero_action;
+Handle<ProtoAction> ElementBatchFixture::assembly_action;
+std::vector<Real> ElementBatchFixture::reference;
+
+BOOST_FIXTURE_TEST_SUITE( ElementBatchSuite, ElementBatchFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Setup )
+{
+  mesh = root.create_component<Mesh>("mesh");
+  Tools::MeshGeneration::create_rectangle_tris(*mesh, 1., 1., 400, 400);
+  mesh->geometry_fields().create_field("temperature", "T").add_tag("temperature");
+  mesh->geometry_fields().create_field("nodal_value", "V").add_tag("nodal_value");
+
+  const std::vector<URI> loop_regions(1, mesh->topology().uri());
+
+  FieldVariable<0, ScalarField> T("T", "temperature");
+  FieldVariable<1, ScalarField> V("V", "nodal_value");
+
+  zero_action = root.create_component<ProtoAction>("ZeroAction");
+  zero_action->set_expression(nodes_expression(group(V = 0., T = coordinates[0])));
+  zero_action->options().set(solver::Tags::regions(), loop_regions);
+
+  // Element matrix of a diffusion-reaction problem, as assembled in the finite element solvers, lumped into the nodes
+  assembly_action = root.create_component<ProtoAction>("AssemblyAction");
+  assembly_action->set_expression(elements_expression(mesh::LagrangeP1::CellTypes(),
+    group
+    (
+      _A = _0,
+      element_quadrature(_A(T,T) += transpose(nabla(T)) * nabla(T) + transpose(N(T))*N(T)),
+      V += diagonal(_A) + _A*nodal_values(T)
+    )
+  ));
+  assembly_action->options().set(solver::Tags::regions(), loop_regions);
+}
+
+BOOST_AUTO_TEST_CASE( Scalar )
+{
+  run();
+}
+
+BOOST_AUTO_TEST_CASE( StoreScalarResult )
+{
+  const Field& field = find_component_recursively_with_tag<Field>(*mesh, "nodal_value");
+  reference.resize(field.size());
+  for(Uint i = 0; i != field.size(); ++i)
+    reference[i] = field[i][0];
+  assembly_action->options().set("element_batching", true);
+}
+
+BOOST_AUTO_TEST_CASE( Batched )
+{
+  run();
+}
+
+BOOST_AUTO_TEST_CASE( CheckBatched )
+{
+  check_result();
+  assembly_action->options().set("nb_threads", 2u);
+}
+
+BOOST_AUTO_TEST_CASE( BatchedTwoThreads )
+{
+  run();
+}
+
+BOOST_AUTO_TEST_CASE( CheckBatchedTwoThreads )
+{
+  check_result();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,173 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Benchmark of node loops on row-major and column-major fields"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/FindComponents.hpp"
+#include "common/OptionList.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+
+#include "solver/actions/Proto/Expression.hpp"
+#include "solver/actions/Proto/NodeLooper.hpp"
+#include "solver/actions/Proto/Terminals.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+#include "Tools/Testing/ProfiledTestFixture.hpp"
+#include "Tools/Testing/TimedTestFixture.hpp"
+
+using namespace cf3;
+using namespace cf3::solver;
+using namespace cf3::solver::actions;
+using namespace cf3::solver::actions::Proto;
+using namespace cf3::mesh;
+using namespace cf3::common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct FieldLayoutFixture :
+  public Tools::Testing::ProfiledTestFixture,
+  public Tools::Testing::TimedTestFixture
+{
+  FieldLayoutFixture() :
+    p("p", "solution"),
+    k("k", "solution"),
+    u("u", "solution")
+  {
+  }
+
+  /// Create a mesh with a field that has many variables, like a turbulent flow solution
+  void setup(const std::string& name, const bool column_major)
+  {
+    Mesh& mesh = *Core::instance().root().create_component<Mesh>(name);
+    Tools::MeshGeneration::create_rectangle(mesh, 1., 1., nb_segments, nb_segments);
+    Field& new_field = mesh.geometry_fields().create_field("solution", "u[vector],p[scalar],k[scalar],epsilon[scalar],nu_t[scalar],T[scalar]");
+    new_field.add_tag("solution");
+    new_field.options().set("column_major", column_major);
+    for(Uint i = 0; i != new_field.size(); ++i)
+      for(Uint j = 0; j != new_field.row_size(); ++j)
+        new_field[i][j] = static_cast<Real>(i+j);
+    field = new_field.handle<Field>();
+    norm = 0.;
+  }
+
+  Region& topology()
+  {
+    return find_parent_component<Mesh>(*field).topology();
+  }
+
+  /// Raw column access, as in a norm computation on a single variable
+  void column_norm()
+  {
+    const Uint p_idx = field->var_offset("p");
+    for(Uint i = 0; i != nb_iterations; ++i)
+      norm += field->col(p_idx).matrix().squaredNorm();
+  }
+
+  /// Checksum of the results of all loops
+  Real checksum()
+  {
+    Real result = norm;
+    const Uint p_idx = field->var_offset("p");
+    for(Uint i = 0; i != field->size(); ++i)
+      result += (*field)[i][p_idx] + (*field)[i][0] + (*field)[i][1];
+    return result;
+  }
+
+  FieldVariable<0, ScalarField> p;
+  FieldVariable<1, ScalarField> k;
+  FieldVariable<2, VectorField> u;
+
+  static Handle<Field> field;
+  static Real norm;
+  static Real row_major_checksum;
+  static const Uint nb_segments = 500;
+  static const Uint nb_iterations = 10;
+};
+
+Handle<Field> FieldLayoutFixture::field;
+Real FieldLayoutFixture::norm = 0.;
+Real FieldLayoutFixture::row_major_checksum = 0.;
+
+BOOST_FIXTURE_TEST_SUITE( FieldLayoutSuite, FieldLayoutFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( SetupRowMajor )
+{
+  setup("RowMajor", false);
+}
+
+BOOST_AUTO_TEST_CASE( RowMajorScalarUpdate )
+{
+  for(Uint i = 0; i != nb_iterations; ++i)
+    for_each_node(topology(), p = 0.5*p + 1.);
+}
+
+BOOST_AUTO_TEST_CASE( RowMajorScalarPair )
+{
+  for(Uint i = 0; i != nb_iterations; ++i)
+    for_each_node(topology(), p += 0.1*k);
+}
+
+BOOST_AUTO_TEST_CASE( RowMajorVectorUpdate )
+{
+  for(Uint i = 0; i != nb_iterations; ++i)
+    for_each_node<2>(topology(), u = 0.5*u);
+}
+
+BOOST_AUTO_TEST_CASE( RowMajorColumnNorm )
+{
+  column_norm();
+}
+
+BOOST_AUTO_TEST_CASE( SetupColumnMajor )
+{
+  row_major_checksum = checksum();
+  setup("ColumnMajor", true);
+}
+
+BOOST_AUTO_TEST_CASE( ColumnMajorScalarUpdate )
+{
+  for(Uint i = 0; i != nb_iterations; ++i)
+    for_each_node(topology(), p = 0.5*p + 1.);
+}
+
+BOOST_AUTO_TEST_CASE( ColumnMajorScalarPair )
+{
+  for(Uint i = 0; i != nb_iterations; ++i)
+    for_each_node(topology(), p += 0.1*k);
+}
+
+BOOST_AUTO_TEST_CASE( ColumnMajorVectorUpdate )
+{
+  for(Uint i = 0; i != nb_iterations; ++i)
+    for_each_node<2>(topology(), u = 0.5*u);
+}
+
+BOOST_AUTO_TEST_CASE( ColumnMajorColumnNorm )
+{
+  column_norm();
+}
+
+BOOST_AUTO_TEST_CASE( CompareLayouts )
+{
+  BOOST_CHECK(field->is_column_major());
+  BOOST_CHECK_CLOSE(checksum(), row_major_checksum, 1e-10);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
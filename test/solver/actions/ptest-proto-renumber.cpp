@@ -0,0 +1,258 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Benchmark of proto element loops on a shuffled and a renumbered mesh"
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/foreach.hpp>
+
+#include "common/Core.hpp"
+#include "common/FindComponents.hpp"
+#include "common/List.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/ElementTypes.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshTransformer.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
+
+#include "solver/Tags.hpp"
+
+#include "solver/actions/Proto/ElementLooper.hpp"
+#include "solver/actions/Proto/Expression.hpp"
+#include "solver/actions/Proto/NodeLooper.hpp"
+#include "solver/actions/Proto/ProtoAction.hpp"
+#include "solver/actions/Proto/Terminals.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+#include "Tools/Testing/ProfiledTestFixture.hpp"
+#include "Tools/Testing/TimedTestFixture.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+using namespace cf3::solver::actions;
+using namespace cf3::solver::actions::Proto;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Randomly reorder the nodes and elements, as a mesh reader could leave them
+void shuffle(Mesh& mesh)
+{
+  Dictionary& geometry = mesh.geometry_fields();
+  const Uint nb_nodes = geometry.size();
+  std::vector<Uint> old_to_new(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+    old_to_new[i] = i;
+  std::random_shuffle(old_to_new.begin(), old_to_new.end());
+
+  const Field::ArrayT old_coordinates = geometry.coordinates().array();
+  const List<Uint>::ListT old_glb_idx = geometry.glb_idx().array();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    geometry.coordinates()[old_to_new[i]] = old_coordinates[i];
+    geometry.glb_idx()[old_to_new[i]] = old_glb_idx[i];
+  }
+
+  BOOST_FOREACH(Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    Connectivity& connectivity = elements.geometry_space().connectivity();
+    BOOST_FOREACH(Connectivity::Row row, connectivity.array())
+    {
+      BOOST_FOREACH(Uint& node, row)
+      {
+        node = old_to_new[node];
+      }
+    }
+
+    const Uint nb_elems = elements.size();
+    std::vector<Uint> new_to_old(nb_elems);
+    for(Uint e = 0; e != nb_elems; ++e)
+      new_to_old[e] = e;
+    std::random_shuffle(new_to_old.begin(), new_to_old.end());
+    const Connectivity::ArrayT old_connectivity = connectivity.array();
+    const List<Uint>::ListT old_elements_glb_idx = elements.glb_idx().array();
+    for(Uint e = 0; e != nb_elems; ++e)
+    {
+      connectivity[e] = old_connectivity[new_to_old[e]];
+      elements.glb_idx()[e] = old_elements_glb_idx[new_to_old[e]];
+    }
+  }
+
+  mesh.raise_mesh_changed();
+}
+
+/// Mean over the elements of the largest difference between their node indices, a measure for the number of cache lines touched
+Real mean_node_spread(const Mesh& mesh)
+{
+  Real total = 0.;
+  Uint nb_elements = 0;
+  BOOST_FOREACH(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    BOOST_FOREACH(const Connectivity::ConstRow row, elements.geometry_space().connectivity().array())
+    {
+      total += static_cast<Real>(*std::max_element(row.begin(), row.end()) - *std::min_element(row.begin(), row.end()));
+      ++nb_elements;
+    }
+  }
+  return total / static_cast<Real>(nb_elements);
+}
+
+struct RenumberFixture :
+  public Tools::Testing::ProfiledTestFixture,
+  public Tools::Testing::TimedTestFixture
+{
+  RenumberFixture() :
+    root(Core::instance().root())
+  {
+  }
+
+  static std::string mesh_name(const std::string& ordering)
+  {
+    return ordering.empty() ? std::string("shuffled") : ordering;
+  }
+
+  /// Create a shuffled mesh, renumbered with the given ordering if it is not empty, and the actions that assemble on it
+  void setup(const std::string& ordering)
+  {
+    const std::string name = mesh_name(ordering);
+    Mesh& mesh = *root.create_component<Mesh>(name + "_mesh");
+    Tools::MeshGeneration::create_rectangle_tris(mesh, 1., 1., nb_segments, nb_segments);
+    std::srand(1);
+    shuffle(mesh);
+    if(!ordering.empty())
+    {
+      boost::shared_ptr<MeshTransformer> renumber = build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.Renumber", "renumber");
+      renumber->options().set("ordering", ordering);
+      renumber->transform(mesh);
+    }
+
+    mesh.geometry_fields().create_field("temperature", "T").add_tag("temperature");
+    mesh.geometry_fields().create_field("nodal_value", "V").add_tag("nodal_value");
+
+    const std::vector<URI> loop_regions(1, mesh.topology().uri());
+    FieldVariable<0, ScalarField> T("T", "temperature");
+    FieldVariable<1, ScalarField> V("V", "nodal_value");
+
+    Handle<ProtoAction> zero_action = root.create_component<ProtoAction>(name + "_zero");
+    zero_action->set_expression(nodes_expression(group(V = 0., T = coordinates[0])));
+    zero_action->options().set(solver::Tags::regions(), loop_regions);
+
+    Handle<ProtoAction> action = root.create_component<ProtoAction>(name + "_assembly");
+    action->set_expression(elements_expression(mesh::LagrangeP1::CellTypes(),
+      group
+      (
+        _A = _0,
+        element_quadrature(_A(T,T) += transpose(nabla(T)) * nabla(T) + transpose(N(T))*N(T)),
+        V += diagonal(_A) + _A*nodal_values(T)
+      )
+    ));
+    action->options().set(solver::Tags::regions(), loop_regions);
+  }
+
+  /// Assemble nb_iterations times on the mesh for the given ordering. Only the assembly is timed.
+  void assemble(const std::string& ordering)
+  {
+    const std::string name = mesh_name(ordering);
+    Handle<ProtoAction>(root.get_child(name + "_zero"))->execute();
+    ProtoAction& action = *Handle<ProtoAction>(root.get_child(name + "_assembly"));
+    restart_timer();
+    for(Uint i = 0; i != nb_iterations; ++i)
+      action.execute();
+  }
+
+  /// Report the node spread and check that the result doesn't depend on the order
+  void check(const std::string& ordering)
+  {
+    const std::string name = mesh_name(ordering);
+    const Mesh& mesh = *Handle<Mesh>(root.get_child(name + "_mesh"));
+
+    const Real spread = mean_node_spread(mesh);
+    CFinfo << name << ": mean node index spread " << spread << CFendl;
+    std::cout << "<DartMeasurement name=\"" << name << " node spread\" type=\"numeric/double\">" << spread << "</DartMeasurement>" << std::endl;
+
+    Real checksum = 0.;
+    const Field& V_field = find_component_recursively_with_tag<Field>(mesh, "nodal_value");
+    for(Uint i = 0; i != V_field.size(); ++i)
+      checksum += V_field[i][0];
+    if(ordering.empty())
+      reference_checksum = checksum;
+    else
+      BOOST_CHECK_CLOSE(checksum, reference_checksum, 1e-8);
+  }
+
+  Component& root;
+  static Real reference_checksum;
+  static const Uint nb_segments = 400;
+  static const Uint nb_iterations = 5;
+};
+
+Real RenumberFixture::reference_checksum = 0.;
+
+BOOST_FIXTURE_TEST_SUITE( RenumberSuite, RenumberFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( SetupShuffled )
+{
+  setup("");
+}
+
+BOOST_AUTO_TEST_CASE( Shuffled )
+{
+  assemble("");
+}
+
+BOOST_AUTO_TEST_CASE( CheckShuffled )
+{
+  check("");
+}
+
+BOOST_AUTO_TEST_CASE( SetupRCM )
+{
+  setup("RCM");
+}
+
+BOOST_AUTO_TEST_CASE( RCM )
+{
+  assemble("RCM");
+}
+
+BOOST_AUTO_TEST_CASE( CheckRCM )
+{
+  check("RCM");
+}
+
+BOOST_AUTO_TEST_CASE( SetupHilbert )
+{
+  setup("Hilbert");
+}
+
+BOOST_AUTO_TEST_CASE( Hilbert )
+{
+  assemble("Hilbert");
+}
+
+BOOST_AUTO_TEST_CASE( CheckHilbert )
+{
+  check("Hilbert");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,398 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for threaded proto element and node loops"
+
+#include <set>
+
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Log.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/ThreadPool.hpp"
+
+#include "math/LSS/System.hpp"
+#include "math/LSS/Matrix.hpp"
+#include "math/LSS/Vector.hpp"
+
+#include "mesh/Domain.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/FieldManager.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementTypes.hpp"
+
+#include "physics/PhysModel.hpp"
+
+#include "solver/Model.hpp"
+#include "solver/Tags.hpp"
+
+#include "solver/actions/Proto/ElementColoring.hpp"
+#include "solver/actions/Proto/Expression.hpp"
+#include "solver/actions/Proto/ProtoAction.hpp"
+#include "solver/actions/Proto/Terminals.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+using namespace cf3::solver::actions;
+using namespace cf3::solver::actions::Proto;
+
+/// Adds a value that depends on the element volume and position to each element node
+struct AddElementContribution
+{
+  typedef void result_type;
+
+  template<typename VarT>
+  void operator()(VarT& v) const
+  {
+    const Real contribution = v.support().volume() / (1. + v.support().nodes()(0,0));
+    v.add_nodal_values(VarT::ElementVectorT::Constant(contribution));
+  }
+};
+
+static MakeSFOp<AddElementContribution>::type const add_element_contribution = {};
+
+struct ProtoThreadsFixture
+{
+  ProtoThreadsFixture() :
+    root(Core::instance().root())
+  {
+    if(is_null(model))
+    {
+      common::PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+
+      model = root.create_component<Model>("Model");
+      physical_model = Handle<physics::PhysModel>(model->create_physics("cf3.physics.DynamicModel").handle());
+      Domain& dom = model->create_domain("Domain");
+      mesh = dom.create_component<Mesh>("mesh");
+      Tools::MeshGeneration::create_rectangle_tris(*mesh, 1., 1., 40, 30);
+
+      field_manager = model->create_component<FieldManager>("FieldManager");
+      field_manager->options().set("variable_manager", model->physics().variable_manager().handle<math::VariableManager>());
+
+      loop_regions.push_back(mesh->topology().uri());
+    }
+  }
+
+  /// Build the node connectivity for the LSS
+  void build_sparsity(std::vector<Uint>& node_connectivity, std::vector<Uint>& starting_indices)
+  {
+    std::vector< std::set<Uint> > connectivity_sets(mesh->geometry_fields().size());
+    BOOST_FOREACH(const Elements& elements, common::find_components_recursively_with_filter<Elements>(*mesh, IsElementsVolume()))
+    {
+      const Connectivity& connectivity = elements.geometry_space().connectivity();
+      const Uint nb_elems = connectivity.size();
+      for(Uint elem = 0; elem != nb_elems; ++elem)
+      {
+        BOOST_FOREACH(const Uint node_a, connectivity[elem])
+        {
+          BOOST_FOREACH(const Uint node_b, connectivity[elem])
+          {
+            connectivity_sets[node_a].insert(node_b);
+          }
+        }
+      }
+    }
+
+    starting_indices.push_back(0);
+    BOOST_FOREACH(const std::set<Uint>& nodes, connectivity_sets)
+    {
+      starting_indices.push_back(starting_indices.back() + nodes.size());
+      node_connectivity.insert(node_connectivity.end(), nodes.begin(), nodes.end());
+    }
+  }
+
+  Component& root;
+  static Handle<Model> model;
+  static Handle<physics::PhysModel> physical_model;
+  static Handle<Mesh> mesh;
+  static Handle<FieldManager> field_manager;
+  static std::vector<URI> loop_regions;
+};
+
+Handle<Model> ProtoThreadsFixture::model;
+Handle<physics::PhysModel> ProtoThreadsFixture::physical_model;
+Handle<Mesh> ProtoThreadsFixture::mesh;
+Handle<FieldManager> ProtoThreadsFixture::field_manager;
+std::vector<URI> ProtoThreadsFixture::loop_regions;
+
+BOOST_FIXTURE_TEST_SUITE( ProtoThreadsSuite, ProtoThreadsFixture )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( StaticChunk )
+{
+  // Chunks must cover the range exactly and respect the alignment
+  const Uint size = 1003;
+  for(Uint nb_threads = 1; nb_threads != 9; ++nb_threads)
+  {
+    Uint expected_begin = 0;
+    for(Uint i = 0; i != nb_threads; ++i)
+    {
+      Uint begin, end;
+      ThreadPool::static_chunk(size, i, nb_threads, begin, end, 8);
+      BOOST_CHECK_EQUAL(begin, expected_begin);
+      BOOST_CHECK(begin % 8 == 0 || begin == size);
+      expected_begin = end;
+    }
+    BOOST_CHECK_EQUAL(expected_begin, size);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Coloring )
+{
+  BOOST_FOREACH(Elements& elements, common::find_components_recursively_with_filter<Elements>(*mesh, IsElementsVolume()))
+  {
+    const ElementColoring& coloring = element_coloring(elements);
+    const Connectivity& connectivity = elements.geometry_space().connectivity();
+    BOOST_CHECK(coloring.nb_colors() > 1);
+    BOOST_CHECK_EQUAL(coloring.elements().size(), elements.size());
+
+    std::vector<bool> visited(elements.size(), false);
+    for(Uint color = 0; color != coloring.nb_colors(); ++color)
+    {
+      std::set<Uint> color_nodes;
+      for(Uint i = coloring.color_begin(color); i != coloring.color_end(color); ++i)
+      {
+        const Uint elem = coloring.elements()[i];
+        BOOST_CHECK(!visited[elem]);
+        visited[elem] = true;
+        BOOST_FOREACH(const Uint node, connectivity[elem])
+        {
+          BOOST_CHECK(color_nodes.insert(node).second);
+        }
+      }
+    }
+    BOOST_CHECK(std::find(visited.begin(), visited.end(), false) == visited.end());
+
+    // The cached coloring is reused
+    BOOST_CHECK_EQUAL(&element_coloring(elements), &coloring);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( NodalContributions )
+{
+  FieldVariable<0, ScalarField> V("NodalValue", "nodal_value");
+
+  Handle<ProtoAction> zero_action = root.create_component<ProtoAction>("ZeroAction");
+  zero_action->set_expression(nodes_expression(V = 0.));
+  zero_action->options().set(solver::Tags::regions(), loop_regions);
+  zero_action->options().set(solver::Tags::physical_model(), physical_model);
+
+  Handle<ProtoAction> action = root.create_component<ProtoAction>("ContributionAction");
+  action->set_expression(elements_expression(mesh::LagrangeP1::CellTypes(), add_element_contribution(V)));
+  action->options().set(solver::Tags::regions(), loop_regions);
+  action->options().set(solver::Tags::physical_model(), physical_model);
+
+  field_manager->create_field("nodal_value", mesh->geometry_fields());
+  const Field& field = find_component_recursively_with_tag<Field>(*mesh, "nodal_value");
+
+  // Plain serial loop
+  zero_action->execute();
+  action->execute();
+  const Field::ArrayT reference = field.array();
+
+  // Serial loop, color by color
+  action->options().set("element_coloring", true);
+  zero_action->execute();
+  action->execute();
+  const Field::ArrayT colored_reference = field.array();
+
+  for(Uint nb_threads = 2; nb_threads != 5; ++nb_threads)
+  {
+    action->options().set("nb_threads", nb_threads);
+    zero_action->execute();
+    action->execute();
+    const Uint nb_nodes = field.size();
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      // Same summation order as the serial colored loop, so the result must be identical
+      BOOST_CHECK_EQUAL(field[i][0], colored_reference[i][0]);
+      BOOST_CHECK_CLOSE(field[i][0], reference[i][0], 1e-10);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( AssemblyIsThreadIndependent )
+{
+  std::vector<Uint> node_connectivity, starting_indices;
+  build_sparsity(node_connectivity, starting_indices);
+
+  Handle<math::LSS::System> lss = root.create_component<math::LSS::System>("lss");
+  lss->options().set("matrix_builder", std::string("cf3.math.LSS.TrilinosCrsMatrix"));
+  lss->create(mesh->geometry_fields().comm_pattern(), 1, node_connectivity, starting_indices);
+
+  FieldVariable<0, ScalarField> T("Temperature", "temperature");
+  SystemMatrix matrix(*lss);
+
+  Handle<ProtoAction> action = root.create_component<ProtoAction>("AssemblyAction");
+  action->set_expression(elements_expression(mesh::LagrangeP1::CellTypes(),
+    group
+    (
+      _A = _0,
+      element_quadrature(_A(T,T) += transpose(nabla(T)) * nabla(T) + transpose(N(T))*N(T)),
+      matrix += _A
+    )
+  ));
+  action->options().set(solver::Tags::regions(), loop_regions);
+  action->options().set(solver::Tags::physical_model(), physical_model);
+  action->options().set("element_coloring", true);
+
+  field_manager->create_field("temperature", mesh->geometry_fields());
+
+  std::vector<Uint> rows, cols;
+  std::vector<Real> serial_values;
+  lss->reset();
+  action->execute();
+  lss->matrix()->debug_data(rows, cols, serial_values);
+
+  action->options().set("nb_threads", 4u);
+  lss->reset();
+  action->execute();
+  std::vector<Real> threaded_values;
+  rows.clear(); cols.clear();
+  lss->matrix()->debug_data(rows, cols, threaded_values);
+
+  BOOST_CHECK_EQUAL(serial_values.size(), threaded_values.size());
+  BOOST_CHECK(serial_values == threaded_values);
+
+  // The scatter map is built by the first assembly and reused by the second
+  action->options().set("element_scatter_map", true);
+  for(Uint i = 0; i != 2; ++i)
+  {
+    lss->reset();
+    action->execute();
+    std::vector<Real> scattered_values;
+    rows.clear(); cols.clear();
+    lss->matrix()->debug_data(rows, cols, scattered_values);
+    BOOST_CHECK(serial_values == scattered_values);
+  }
+  BOOST_CHECK(is_not_null(lss->matrix()->get_child("element_scatter_map")));
+
+  // Creating the LSS again discards the scatter map
+  lss->create(mesh->geometry_fields().comm_pattern(), 1, node_connectivity, starting_indices);
+  BOOST_CHECK(is_null(lss->matrix()->get_child("element_scatter_map")));
+}
+
+/// True if a node loop over the expression always runs on a single thread
+template<typename ExprT>
+bool modifies_lss(const ExprT&)
+{
+  return ModifiesLSS<ExprT>::value;
+}
+
+BOOST_AUTO_TEST_CASE( NodeLoopsModifyingLSS )
+{
+  Handle<math::LSS::System> lss(root.get_child("lss"));
+  FieldVariable<0, ScalarField> T("Temperature", "temperature");
+  SystemMatrix matrix(*lss);
+  SystemRHS rhs(*lss);
+  DirichletBC dirichlet(*lss);
+
+  BOOST_CHECK(!modifies_lss(T = coordinates[0]));
+  BOOST_CHECK(modifies_lss(rhs(T) = coordinates[0]));
+  BOOST_CHECK(modifies_lss(group(T = coordinates[0], dirichlet(T) = T)));
+  BOOST_CHECK(modifies_lss(zero_row(matrix, T)));
+
+  Handle<ProtoAction> action = root.create_component<ProtoAction>("LSSNodeAction");
+  action->set_expression(nodes_expression(group
+  (
+    rhs(T) = coordinates[0] + 2.*coordinates[1],
+    dirichlet(T) = coordinates[0]*coordinates[1]
+  )));
+  action->options().set(solver::Tags::regions(), loop_regions);
+  action->options().set(solver::Tags::physical_model(), physical_model);
+
+  std::vector<Uint> rows, cols;
+  std::vector<Real> serial_matrix, serial_rhs;
+  lss->reset();
+  action->execute();
+  lss->matrix()->debug_data(rows, cols, serial_matrix);
+  lss->rhs()->debug_data(serial_rhs);
+
+  // Setting more threads is allowed, but the loop still runs serially
+  action->options().set("nb_threads", 4u);
+  lss->reset();
+  action->execute();
+  std::vector<Real> threaded_matrix, threaded_rhs;
+  rows.clear(); cols.clear();
+  lss->matrix()->debug_data(rows, cols, threaded_matrix);
+  lss->rhs()->debug_data(threaded_rhs);
+
+  BOOST_CHECK(serial_matrix == threaded_matrix);
+  BOOST_CHECK(serial_rhs == threaded_rhs);
+}
+
+BOOST_AUTO_TEST_CASE( NodeLoops )
+{
+  FieldVariable<0, ScalarField> T("Temperature", "temperature");
+  FieldVariable<1, ScalarField> V("NodalValue", "nodal_value");
+
+  Real total, maximum, minimum;
+
+  Handle<ProtoAction> action = root.create_component<ProtoAction>("NodeAction");
+  action->set_expression(nodes_expression(group
+  (
+    T = coordinates[0]*coordinates[0] + 2.*coordinates[1],
+    V = 2.*T + node_index,
+    nodal_sum(total) += T,
+    nodal_max(maximum) += V,
+    nodal_min(minimum) += V - T
+  )));
+  action->options().set(solver::Tags::regions(), loop_regions);
+  action->options().set(solver::Tags::physical_model(), physical_model);
+
+  const Field& field = find_component_recursively_with_tag<Field>(*mesh, "nodal_value");
+  const Uint nb_nodes = field.size();
+
+  total = 1.; maximum = 0.; minimum = 0.;
+  action->execute();
+  const Field::ArrayT reference = field.array();
+
+  // Reference results for the reductions, including the initial values
+  Real ref_total = 1., ref_maximum = 0., ref_minimum = 0.;
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Real t = (reference[i][0] - static_cast<Real>(i)) / 2.;
+    ref_total += t;
+    ref_maximum = std::max(ref_maximum, reference[i][0]);
+    ref_minimum = std::min(ref_minimum, reference[i][0] - t);
+  }
+  BOOST_CHECK_CLOSE(total, ref_total, 1e-10);
+  BOOST_CHECK_EQUAL(maximum, ref_maximum);
+  BOOST_CHECK_EQUAL(minimum, ref_minimum);
+
+  for(Uint nb_threads = 2; nb_threads != 5; ++nb_threads)
+  {
+    action->options().set("nb_threads", nb_threads);
+    total = 1.; maximum = 0.; minimum = 0.;
+    action->execute();
+    for(Uint i = 0; i != nb_nodes; ++i)
+      BOOST_CHECK_EQUAL(field[i][0], reference[i][0]);
+    BOOST_CHECK_CLOSE(total, ref_total, 1e-10);
+    BOOST_CHECK_EQUAL(maximum, ref_maximum);
+    BOOST_CHECK_EQUAL(minimum, ref_minimum);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  common::PE::Comm::instance().finalize();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
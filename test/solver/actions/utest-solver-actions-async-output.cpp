@@ -0,0 +1,184 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for asynchronous restart and VTKXML output"
+
+#include <fstream>
+#include <iterator>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/BoostFilesystem.hpp"
+#include "common/Core.hpp"
+#include "common/OptionList.hpp"
+#include "common/OutputThread.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshGenerator.hpp"
+#include "mesh/MeshWriter.hpp"
+
+#include "solver/Time.hpp"
+#include "solver/actions/ReadRestartFile.hpp"
+#include "solver/actions/WriteRestartFile.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+using namespace cf3::solver::actions;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Value of the test field in a node at a step
+Real step_value(const Uint step, const Uint node)
+{
+  return static_cast<Real>(step) + 0.001*static_cast<Real>(node);
+}
+
+void set_step(Field& field, const Uint step)
+{
+  for(Uint i = 0; i != field.size(); ++i)
+    field[i][0] = step_value(step, i);
+}
+
+std::string file_contents(const std::string& path)
+{
+  std::ifstream file(path.c_str(), std::ios_base::in | std::ios_base::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+std::string restart_path(const Uint step)
+{
+  return "async-output-" + to_str(step) + ".cf3restart";
+}
+
+struct AsyncOutputFixture
+{
+  AsyncOutputFixture() :
+    root(Core::instance().root()),
+    nb_steps(5)
+  {
+  }
+
+  Component& root;
+  const Uint nb_steps;
+};
+
+BOOST_FIXTURE_TEST_SUITE( AsyncOutputSuite, AsyncOutputFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+
+  Handle<MeshGenerator> generator = root.create_component<MeshGenerator>("generator", "cf3.mesh.SimpleMeshGenerator");
+  generator->options().set("mesh", root.uri()/"mesh");
+  generator->options().set("nb_cells", std::vector<Uint>(2, 20));
+  generator->options().set("lengths", std::vector<Real>(2, 1.));
+  generator->options().set("bdry", false);
+  Mesh& mesh = generator->generate();
+  mesh.geometry_fields().create_field("u");
+
+  root.create_component<Time>("time");
+}
+
+BOOST_AUTO_TEST_CASE( AsynchronousRestart )
+{
+  Mesh& mesh = *Handle<Mesh>(root.get_child("mesh"));
+  Field& u = *Handle<Field>(mesh.geometry_fields().get_child("u"));
+  Handle<Time> time(root.get_child("time"));
+
+  OutputThread& output_thread = OutputThread::instance();
+  BOOST_CHECK_EQUAL(output_thread.max_queue_size(), 2u);
+
+  Handle<WriteRestartFile> writer = root.create_component<WriteRestartFile>("restart_writer");
+  writer->options().set("fields", std::vector< Handle<Field> >(1, u.handle<Field>()));
+  writer->options().set("time", time);
+  writer->options().set("asynchronous", true);
+
+  for(Uint step = 0; step != nb_steps; ++step)
+  {
+    set_step(u, step);
+    time->options().set("iteration", step);
+    writer->options().set("file", URI(restart_path(step)));
+    writer->execute();
+  }
+
+  // The number of pending writes is bounded, so the first steps are complete without an explicit flush
+  PE::Comm::instance().barrier();
+  BOOST_CHECK(boost::filesystem::exists(restart_path(0)));
+  BOOST_CHECK(boost::filesystem::exists(restart_path(nb_steps - output_thread.max_queue_size() - 1)));
+
+  output_thread.flush();
+
+  Handle<ReadRestartFile> reader = root.create_component<ReadRestartFile>("restart_reader");
+  reader->options().set("mesh", mesh.handle<Mesh>());
+  reader->options().set("time", time);
+  for(Uint step = 0; step != nb_steps; ++step)
+  {
+    set_step(u, 1000);
+    reader->options().set("file", URI(restart_path(step)));
+    reader->execute();
+    BOOST_CHECK_EQUAL(time->iter(), step);
+    for(Uint i = 0; i != u.size(); ++i)
+      BOOST_CHECK_EQUAL(u[i][0], step_value(step, i));
+  }
+
+  root.remove_component("restart_writer");
+  root.remove_component("restart_reader");
+}
+
+BOOST_AUTO_TEST_CASE( AsynchronousVTKXML )
+{
+  Mesh& mesh = *Handle<Mesh>(root.get_child("mesh"));
+  Field& u = *Handle<Field>(mesh.geometry_fields().get_child("u"));
+  const std::string rank_suffix = "_P" + to_str(PE::Comm::instance().rank()) + ".vtu";
+
+  boost::shared_ptr<MeshWriter> sync_writer = build_component_abstract_type<MeshWriter>("cf3.mesh.VTKXML.Writer", "sync_writer");
+  boost::shared_ptr<MeshWriter> async_writer = build_component_abstract_type<MeshWriter>("cf3.mesh.VTKXML.Writer", "async_writer");
+  async_writer->options().set("asynchronous", true);
+  const std::vector<URI> fields(1, u.uri());
+  sync_writer->options().set("mesh", mesh.handle<Mesh const>());
+  sync_writer->options().set("fields", fields);
+  async_writer->options().set("mesh", mesh.handle<Mesh const>());
+  async_writer->options().set("fields", fields);
+
+  for(Uint step = 0; step != nb_steps; ++step)
+  {
+    set_step(u, step);
+    sync_writer->options().set("file", URI("sync-output-" + to_str(step) + ".pvtu"));
+    sync_writer->execute();
+    async_writer->options().set("file", URI("async-output-" + to_str(step) + ".pvtu"));
+    async_writer->execute();
+  }
+
+  OutputThread::instance().flush();
+
+  // The staged data must give the same file as the data compressed while it is appended
+  for(Uint step = 0; step != nb_steps; ++step)
+  {
+    const std::string sync_contents = file_contents("sync-output-" + to_str(step) + rank_suffix);
+    BOOST_CHECK(!sync_contents.empty());
+    BOOST_CHECK(sync_contents == file_contents("async-output-" + to_str(step) + rank_suffix));
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  PE::Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,210 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for probes executed over several steps"
+
+#include <boost/test/unit_test.hpp>
+
+#include <mpi.h>
+
+#include "common/Core.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshGenerator.hpp"
+#include "mesh/Region.hpp"
+
+#include "solver/actions/Probe.hpp"
+#include "solver/actions/ProbePoints.hpp"
+#include "solver/actions/TurbulenceStatistics.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver::actions;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Number of collective calls made through MPI, counted using the MPI profiling interface
+Uint nb_collectives = 0;
+
+#if MPI_VERSION >= 3
+#define CF3_MPI_CONST const
+#else
+#define CF3_MPI_CONST
+#endif
+
+extern "C"
+{
+  int MPI_Allreduce(CF3_MPI_CONST void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+  {
+    ++nb_collectives;
+    return PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+  }
+
+  int MPI_Bcast(void* buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm)
+  {
+    ++nb_collectives;
+    return PMPI_Bcast(buffer, count, datatype, root, comm);
+  }
+}
+
+/// Linear function, interpolated exactly by the probes
+Real step_value(const Uint step, const Real x, const Real y)
+{
+  return static_cast<Real>(step) + x + 2.*y;
+}
+
+void set_step(const Dictionary& dict, Field& field, const Uint step)
+{
+  const Field& coords = dict.coordinates();
+  for(Uint i = 0; i != field.size(); ++i)
+  {
+    const Real u = step_value(step, coords[i][XX], coords[i][YY]);
+    field[i][0] = u;
+    field[i][1] = 2.*u;
+    field[i][2] = 3.*u;
+  }
+}
+
+struct ProbeFixture
+{
+  ProbeFixture() :
+    root(Core::instance().root()),
+    nb_steps(4)
+  {
+  }
+
+  Component& root;
+  const Uint nb_steps;
+};
+
+BOOST_FIXTURE_TEST_SUITE( ProbeSuite, ProbeFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+
+  Handle<MeshGenerator> generator = root.create_component<MeshGenerator>("generator", "cf3.mesh.SimpleMeshGenerator");
+  generator->options().set("mesh", root.uri()/"mesh");
+  generator->options().set("nb_cells", std::vector<Uint>(2, 20));
+  generator->options().set("lengths", std::vector<Real>(2, 1.));
+  generator->options().set("bdry", false);
+  Mesh& mesh = generator->generate();
+  mesh.geometry_fields().create_field("solution", "Velocity[vector],Pressure");
+}
+
+BOOST_AUTO_TEST_CASE( ProbeSteps )
+{
+  Mesh& mesh = *Handle<Mesh>(root.get_child("mesh"));
+  Dictionary& dict = mesh.geometry_fields();
+  Field& solution = *Handle<Field>(dict.get_child("solution"));
+
+  std::vector<Real> coordinate(2);
+  coordinate[XX] = 0.33; coordinate[YY] = 0.27;
+  Handle<Probe> probe = root.create_component<Probe>("probe");
+  probe->options().set("dict", dict.handle<Dictionary>());
+  probe->options().set("coordinate", coordinate);
+
+  std::vector<Real> x(2), y(2);
+  x[0] = 0.21; y[0] = 0.18;
+  x[1] = 0.77; y[1] = 0.69;
+  Handle<ProbePoints> probe_points = root.create_component<ProbePoints>("probe_points");
+  probe_points->options().set("dict", dict.handle<Dictionary>());
+  probe_points->options().set("x_coordinate", x);
+  probe_points->options().set("y_coordinate", y);
+
+  for(Uint step = 0; step != nb_steps; ++step)
+  {
+    set_step(dict, solution, step);
+
+    // After the first step the locations are known, and each probe needs a single collective
+    const Uint nb_collectives_before = nb_collectives;
+    probe->execute();
+    if(step != 0)
+      BOOST_CHECK_EQUAL(nb_collectives - nb_collectives_before, 1u);
+
+    const Real expected = step_value(step, coordinate[XX], coordinate[YY]);
+    BOOST_CHECK_CLOSE(probe->properties().value<Real>("Velocity[0]"), expected, 1e-8);
+    BOOST_CHECK_CLOSE(probe->properties().value<Real>("Velocity[1]"), 2.*expected, 1e-8);
+    BOOST_CHECK_CLOSE(probe->properties().value<Real>("Pressure"), 3.*expected, 1e-8);
+
+    const Uint nb_points_collectives_before = nb_collectives;
+    probe_points->execute();
+    if(step != 0)
+      BOOST_CHECK_EQUAL(nb_collectives - nb_points_collectives_before, 1u);
+
+    for(Uint p = 0; p != x.size(); ++p)
+    {
+      const Real point_expected = step_value(step, x[p], y[p]);
+      BOOST_CHECK_CLOSE(probe_points->properties().value<Real>("Velocity_" + to_str(p) + "[0]"), point_expected, 1e-8);
+      BOOST_CHECK_CLOSE(probe_points->properties().value<Real>("Velocity_" + to_str(p) + "[1]"), 2.*point_expected, 1e-8);
+      BOOST_CHECK_CLOSE(probe_points->properties().value<Real>("Pressure_" + to_str(p)), 3.*point_expected, 1e-8);
+    }
+  }
+
+  // Moving the probe locates it again
+  coordinate[XX] = 0.62;
+  probe->options().set("coordinate", coordinate);
+  probe->execute();
+  BOOST_CHECK_CLOSE(probe->properties().value<Real>("Pressure"), 3.*step_value(nb_steps-1, coordinate[XX], coordinate[YY]), 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE( TurbulenceStatisticsSteps )
+{
+  Mesh& mesh = *Handle<Mesh>(root.get_child("mesh"));
+  Dictionary& dict = mesh.geometry_fields();
+  Field& solution = *Handle<Field>(dict.get_child("solution"));
+
+  Handle<TurbulenceStatistics> statistics = root.create_component<TurbulenceStatistics>("statistics");
+  statistics->options().set("region", mesh.topology().handle<Region>());
+  statistics->options().set("file", URI("probe-turbulence-statistics.txt"));
+
+  // Probes at nodes, away from the partition boundaries
+  RealVector2 probe_location(0.25, 0.25);
+  statistics->add_probe(probe_location);
+  probe_location << 0.75, 0.75;
+  statistics->add_probe(probe_location);
+
+  for(Uint step = 0; step != nb_steps; ++step)
+  {
+    set_step(dict, solution, step);
+    const Uint nb_collectives_before = nb_collectives;
+    statistics->execute();
+    if(step != 0)
+      BOOST_CHECK_EQUAL(nb_collectives, nb_collectives_before);
+  }
+
+  // The statistics contain the mean velocity over all steps
+  const Field& coords = dict.coordinates();
+  const Field& means = *Handle<Field>(dict.get_child("turbulence_statistics"));
+  for(Uint i = 0; i != means.size(); ++i)
+  {
+    if(dict.is_ghost(i))
+      continue;
+    const Real expected = 0.5*static_cast<Real>(nb_steps-1) + coords[i][XX] + 2.*coords[i][YY];
+    BOOST_CHECK_CLOSE(means[i][0], expected, 1e-8);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  PE::Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,151 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::solver::actions::Rebalance"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/foreach.hpp>
+
+#include "common/Core.hpp"
+#include "common/FindComponents.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshGenerator.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
+
+#include "solver/actions/Rebalance.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver::actions;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Elements with their centroid below the given height are expensive
+Real expensive_cost(const Mesh& mesh, const Real y_max)
+{
+  Real result = 0.;
+  const Field& coords = mesh.geometry_fields().coordinates();
+  BOOST_FOREACH(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    const Connectivity& connectivity = elements.geometry_space().connectivity();
+    const Uint nb_elems = elements.size();
+    for(Uint i = 0; i != nb_elems; ++i)
+    {
+      if(elements.is_ghost(i))
+        continue;
+      Real y = 0.;
+      BOOST_FOREACH(const Uint node, connectivity[i])
+      {
+        y += coords[node][YY];
+      }
+      y /= static_cast<Real>(connectivity.row_size());
+      result += y < y_max ? 5. : 1.;
+    }
+  }
+  return result;
+}
+
+/// Maximum cost divided by the mean cost over all ranks
+Real imbalance(const Real rank_cost)
+{
+  PE::Comm& comm = PE::Comm::instance();
+  Real max_cost, total_cost;
+  comm.all_reduce(PE::max(), &rank_cost, 1, &max_cost);
+  comm.all_reduce(PE::plus(), &rank_cost, 1, &total_cost);
+  return max_cost / (total_cost / static_cast<Real>(comm.size()));
+}
+
+BOOST_AUTO_TEST_SUITE( RebalanceSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  BOOST_CHECK_EQUAL(PE::Comm::instance().size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE( RebalanceMeasuredCost )
+{
+  PE::Comm& comm = PE::Comm::instance();
+  Component& root = Core::instance().root();
+
+  // The generator distributes the rows of the mesh over the ranks, so the elements of rank 0 are at the bottom
+  Handle<MeshGenerator> generator = root.create_component<MeshGenerator>("generator", "cf3.mesh.SimpleMeshGenerator");
+  std::vector<Uint> nb_cells(2, 40);
+  std::vector<Real> lengths(2, 1.);
+  generator->options().set("mesh", root.uri()/"mesh");
+  generator->options().set("nb_cells", nb_cells);
+  generator->options().set("lengths", lengths);
+  generator->options().set("bdry", false);
+  Mesh& mesh = generator->generate();
+
+  Handle<Rebalance> rebalance = root.create_component<Rebalance>("Rebalance");
+  rebalance->options().set("mesh", mesh.handle<Mesh>());
+  rebalance->options().set("interval", 1u);
+  rebalance->options().set("imbalance_threshold", 1.5);
+
+  // Equal costs don't trigger a rebalance
+  BOOST_FOREACH(Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    add_element_cost(elements, 1e-3 * static_cast<Real>(elements.size()));
+  }
+  rebalance->execute();
+  BOOST_CHECK_CLOSE(rebalance->properties().value<Real>("imbalance"), 1., 1e-8);
+  BOOST_CHECK_EQUAL(rebalance->properties().value<Uint>("nb_rebalances"), 0u);
+
+  // The elements of rank 0 are 5 times as expensive
+  Real y_max = 0.;
+  Real local_y_max = 0.;
+  const Field& coords = mesh.geometry_fields().coordinates();
+  for(Uint i = 0; i != coords.size(); ++i)
+  {
+    if(!coords.is_ghost(i))
+      local_y_max = std::max(local_y_max, comm.rank() == 0 ? coords[i][YY] : 0.);
+  }
+  comm.all_reduce(PE::max(), &local_y_max, 1, &y_max);
+
+  BOOST_FOREACH(Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    add_element_cost(elements, (comm.rank() == 0 ? 5e-3 : 1e-3) * static_cast<Real>(elements.size()));
+  }
+  const Real imbalance_before = imbalance(expensive_cost(mesh, y_max));
+  rebalance->execute();
+  BOOST_CHECK_GT(rebalance->properties().value<Real>("imbalance"), 1.5);
+  BOOST_CHECK_EQUAL(rebalance->properties().value<Uint>("nb_rebalances"), 1u);
+
+  // Costs are reset after each check
+  BOOST_FOREACH(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    BOOST_CHECK_EQUAL(element_cost(elements), 0.);
+  }
+
+  const Real imbalance_after = imbalance(expensive_cost(mesh, y_max));
+  BOOST_CHECK_LT(imbalance_after, imbalance_before);
+  BOOST_CHECK(mesh.check_sanity());
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  PE::Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,80 @@
+import sys
+import coolfluid as cf
+
+# Restart files are indexed by global index, so a file written on one number of processes must read back on any other.
+# Run with "write" to write the file, and with "read" on a different number of processes to check it.
+# The generated mesh has the same global indices on any number of processes.
+
+def copy_and_reset(source, domain):
+  nb_items = len(source)
+  row_size = source.row_size()
+  destination = domain.create_component(source.name() + '_ref', 'cf3.mesh.Field')
+  destination.set_row_size(row_size)
+  destination.resize(nb_items)
+
+  for i in range(nb_items):
+    for j in range(row_size):
+      destination[i][j] = source[i][j]
+      source[i][j] = 0.
+
+  return destination
+
+mode = sys.argv[1]
+
+env = cf.Core.environment()
+env.log_level = 4
+env.only_cpu0_writes = True
+
+root = cf.Core.root()
+domain = root.create_component('Domain', 'cf3.mesh.Domain')
+mesh = domain.create_component('Mesh','cf3.mesh.Mesh')
+
+mesh_generator = root.create_component('MeshGenerator', 'cf3.mesh.SimpleMeshGenerator')
+mesh_generator.options().set('mesh', mesh.uri())
+mesh_generator.options().set('nb_cells', [16, 12])
+mesh_generator.options().set('lengths', [2., 1.])
+mesh_generator.options().set('bdry', False)
+mesh_generator.execute()
+
+make_par_data = root.create_component('MakeParData', 'cf3.solver.actions.ParallelDataToFields')
+make_par_data.mesh = mesh
+make_par_data.execute()
+
+time = domain.create_component('Time', 'cf3.solver.Time')
+
+fields = [mesh.geometry.coordinates, mesh.geometry.node_gids, mesh.elems_P0.element_gids]
+restart_file = cf.URI('restart-partitions-test.cf3restart')
+
+if mode == 'write':
+  time.current_time = 1.
+  time.time_step = 0.1
+  time.iteration = 10
+
+  writer = domain.create_component('Writer', 'cf3.solver.actions.WriteRestartFile')
+  writer.fields = fields
+  writer.file = restart_file
+  writer.time = time
+  writer.execute()
+
+elif mode == 'read':
+  references = [copy_and_reset(field, domain) for field in fields]
+
+  reader = domain.create_component('Reader', 'cf3.solver.actions.ReadRestartFile')
+  reader.mesh = mesh
+  reader.file = restart_file
+  reader.time = time
+  reader.execute()
+
+  differ = domain.create_component('Differ', 'cf3.common.ArrayDiff')
+  for (reference, field) in zip(references, fields):
+    differ.left = reference
+    differ.right = field
+    differ.execute()
+    if not differ.properties()['arrays_equal']:
+      raise Exception('Field ' + field.name() + ' does not match after reading on ' + str(cf.Core.nb_procs()) + ' processes')
+
+  if time.current_time != 1. or time.time_step != 0.1 or time.iteration != 10:
+    raise Exception('Error in time data')
+
+else:
+  raise Exception('Unknown mode ' + mode)